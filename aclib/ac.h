@@ -38,6 +38,9 @@
 #define AC_SSE42        0x1000  /* x86: SSE4.2 instructions (Intel) */
 #define AC_SSE4A        0x2000  /* x86: SSE4a instructions (AMD) */
 #define AC_SSE5         0x4000  /* x86: SSE5 instructions (AMD) */
+#define AC_AVX          0x8000  /* x86: AVX instructions */
+#define AC_AVX2        0x10000  /* x86: AVX2 instructions */
+#define AC_AVX512BW    0x20000  /* x86: AVX-512 F+BW instructions */
 
 #define AC_NONE         0       /* No acceleration (vanilla C functions) */
 #define AC_ALL          (~0)    /* All available acceleration */
@@ -90,6 +93,88 @@ extern void ac_rescale(const uint8_t *src1, const uint8_t *src2,
                        uint8_t *dest, int bytes,
                        uint32_t weight1, uint32_t weight2);
 
+/* Filtered resampling of a row of data: each byte of pixel `i' of `dest'
+ * is the weighted sum of the same byte of `taps' consecutive pixels of
+ * `src', starting at pixel start[i]; the weights for pixel `i' are at
+ * weights[i*taps], in fixed point with AC_RESAMPLE_BITS fraction bits.
+ * Results are rounded and clamped to 0..255.  `src' must be readable up
+ * to the last of those pixels. */
+extern void ac_resample_h(const uint8_t *src, uint8_t *dest,
+                          int width, int Bpp,
+                          const int32_t *start, const int16_t *weights,
+                          int taps);
+
+/* Filtered resampling in the other direction: each byte of `dest' is the
+ * weighted sum of the same byte of the `taps' rows in `rows'. */
+extern void ac_resample_v(const uint8_t * const *rows,
+                          const int16_t *weights, int taps,
+                          uint8_t *dest, int bytes);
+
+#define AC_RESAMPLE_BITS        14
+
+/* Block matching, for motion estimation.  Blocks are `width' bytes by
+ * `height' lines; `stride' values give the distance between lines. */
+
+/* Sum of absolute differences between two blocks */
+extern uint32_t ac_sad(const uint8_t *src1, int stride1,
+                       const uint8_t *src2, int stride2,
+                       int width, int height);
+
+/* Sum of absolute differences between `src1' and the average (rounded
+ * up) of `src2a' and `src2b', for half-pixel positions */
+extern uint32_t ac_sad_avg(const uint8_t *src1, int stride1,
+                           const uint8_t *src2a, const uint8_t *src2b,
+                           int stride2, int width, int height);
+
+/* Sum of squared differences between two blocks */
+extern uint64_t ac_ssd(const uint8_t *src1, int stride1,
+                       const uint8_t *src2, int stride2,
+                       int width, int height);
+
+/* A motion vector: the offset of the best match in the reference, and
+ * its SAD. */
+typedef struct acmotionvector_ {
+    int x, y;
+    uint32_t cost;
+} ACMotionVector;
+
+/* Search the reference for the block at `cur'.  `ref' points at the
+ * block's own position in the reference; offsets within `radius' of the
+ * incoming mv->x,mv->y are tried every `step' pixels, then every pixel
+ * within step-1 of the best one.  The lowest SAD wins, the first one
+ * found on ties (offsets are scanned by column).  The reference must be
+ * readable radius+step-1 pixels around the block. */
+extern void ac_motion_search(const uint8_t *cur, int cur_stride,
+                             const uint8_t *ref, int ref_stride,
+                             int width, int height, int radius, int step,
+                             ACMotionVector *mv);
+
+/* Coarse-to-fine search over `levels' pyramid levels (level 0 full size,
+ * each next one halved with ac_downsample2()).  The block at x,y of
+ * `width' x `height' pixels (level 0 sizes) is searched within
+ * radius>>(levels-1) on the smallest level, then within 1 pixel of twice
+ * the previous vector on each larger one.  The reference must be
+ * readable radius+(1<<(levels-1)) pixels around the block on level 0,
+ * and proportionally on the others.  mv->x,mv->y are set, not read. */
+extern void ac_motion_search_hier(const uint8_t * const *cur,
+                                  const uint8_t * const *ref,
+                                  const int *stride, int levels,
+                                  int x, int y, int width, int height,
+                                  int radius, ACMotionVector *mv);
+
+/* Refine a full-pixel vector to half a pixel: on return mv->x,mv->y are
+ * in half pixels.  The reference must be readable one pixel further
+ * around the vector's block. */
+extern void ac_motion_halfpel(const uint8_t *cur, int cur_stride,
+                              const uint8_t *ref, int ref_stride,
+                              int width, int height, ACMotionVector *mv);
+
+/* Halve a plane in both directions by averaging 2x2 blocks; `width' and
+ * `height' are the size of `dest'. */
+extern void ac_downsample2(const uint8_t *src, int src_stride,
+                           uint8_t *dest, int dest_stride,
+                           int width, int height);
+
 /* Image format manipulation is available in aclib/imgconvert.h */
 
 /*************************************************************************/
@@ -26,7 +26,9 @@
 extern int ac_average_init(int accel);
 extern int ac_imgconvert_init(int accel);
 extern int ac_memcpy_init(int accel);
+extern int ac_motion_init(int accel);
 extern int ac_rescale_init(int accel);
+extern int ac_resample_init(int accel);
 
 
 #endif  /* ACLIB_AC_INTERNAL_H */
@@ -32,7 +32,9 @@ int ac_init(int accel)
     if (!ac_average_init(accel)
      || !ac_imgconvert_init(accel)
      || !ac_memcpy_init(accel)
+     || !ac_motion_init(accel)
      || !ac_rescale_init(accel)
+     || !ac_resample_init(accel)
     ) {
         return 0;
     }
@@ -78,7 +80,10 @@ const char *ac_flagstotext(int accel)
     static char retbuf[1000];
     if (!accel)
         return "none";
-    snprintf(retbuf, sizeof(retbuf), "%s%s%s%s%s%s%s%s%s%s%s%s%s%s",
+    snprintf(retbuf, sizeof(retbuf), "%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s",
+             accel & AC_AVX512BW              ? " avx512bw" : "",
+             accel & AC_AVX2                  ? " avx2"     : "",
+             accel & AC_AVX                   ? " avx"      : "",
              accel & AC_SSE5                  ? " sse5"     : "",
              accel & AC_SSE4A                 ? " sse4a"    : "",
              accel & AC_SSE42                 ? " sse42"    : "",
@@ -158,6 +163,12 @@ int ac_parseflags(const char *text, int *accel)
             *accel |= AC_SSE4A;
         else if (strcasecmp(buf, "sse5"    ) == 0)
             *accel |= AC_SSE5;
+        else if (strcasecmp(buf, "avx"     ) == 0)
+            *accel |= AC_AVX;
+        else if (strcasecmp(buf, "avx2"    ) == 0)
+            *accel |= AC_AVX2;
+        else if (strcasecmp(buf, "avx512bw") == 0)
+            *accel |= AC_AVX512BW;
         else
             parsed = 0;
         text = comma + 1;
@@ -201,9 +212,28 @@ int ac_parseflags(const char *text, int *accel)
         : "=a" (ret_a), "=S" (ret_b), "=c" (ret_c), "=d" (ret_d)        \
         : "a" (func))
 
+/* The same, for functions with subleaves (ECX = sub). */
+#define CPUID2(func,sub,ret_a,ret_b,ret_c,ret_d)                        \
+    asm("mov "EBX", "ESI"; cpuid; xchg "EBX", "ESI                      \
+        : "=a" (ret_a), "=S" (ret_b), "=c" (ret_c), "=d" (ret_d)        \
+        : "a" (func), "c" (sub))
+
+/* Read the extended control register XCR0, which tells which register
+ * states the OS saves on context switches.  Only valid if CPUID reports
+ * OSXSAVE.  (The opcode is spelled out for old assemblers.) */
+#define XGETBV0(ret_a,ret_d)                                            \
+    asm(".byte 0x0F, 0x01, 0xD0"                                        \
+        : "=a" (ret_a), "=d" (ret_d)                                    \
+        : "c" (0))
+
 /* Various CPUID flags.  The second word of the macro name indicates the
- * function (1: function 1, X1: function 0x80000001) and register (D: EDX)
- * to which the value belongs. */
+ * function (1: function 1, 7: function 7 subleaf 0, X1: function 0x80000001)
+ * and register (D: EDX) to which the value belongs. */
+
+/* XCR0 bits: the OS saves SSE, AVX (upper YMM) and AVX-512 (opmask, upper
+ * ZMM and ZMM16-31) state. */
+#define XCR0_SSE_AVX            0x06
+#define XCR0_AVX512             0xE0
 #define CPUID_1D_CMOVE          (1UL<<15)
 #define CPUID_1D_MMX            (1UL<<23)
 #define CPUID_1D_SSE            (1UL<<25)
@@ -212,6 +242,11 @@ int ac_parseflags(const char *text, int *accel)
 #define CPUID_1C_SSSE3          (1UL<< 9)
 #define CPUID_1C_SSE41          (1UL<<19)
 #define CPUID_1C_SSE42          (1UL<<20)
+#define CPUID_1C_OSXSAVE        (1UL<<27)
+#define CPUID_1C_AVX            (1UL<<28)
+#define CPUID_7B_AVX2           (1UL<< 5)
+#define CPUID_7B_AVX512F        (1UL<<16)
+#define CPUID_7B_AVX512BW       (1UL<<30)
 #define CPUID_X1D_AMD_MMXEXT    (1UL<<22)  /* AMD only */
 #define CPUID_X1D_AMD_3DNOW     (1UL<<31)  /* AMD only */
 #define CPUID_X1D_AMD_3DNOWEXT  (1UL<<30)  /* AMD only */
@@ -227,7 +262,8 @@ static int cpuinfo_x86(void)
         char string[13];
         struct { uint32_t ebx, edx, ecx; } regs;
     } cpu_vendor;  /* 12-byte CPU vendor string + trailing null */
-    uint32_t cpuid_1D, cpuid_1C, cpuid_X1C, cpuid_X1D;
+    uint32_t cpuid_1D, cpuid_1C, cpuid_7B, cpuid_X1C, cpuid_X1D;
+    uint32_t xcr0;
     int accel;
 
     /* First see if the CPUID instruction is even available.  We try to
@@ -257,9 +293,11 @@ static int cpuinfo_x86(void)
     CPUID(0x80000000, cpuid_ext_max, ebx, ecx, edx);
 
     /* Read available features */
-    cpuid_1D = cpuid_1C = cpuid_X1C = cpuid_X1D = 0;
+    cpuid_1D = cpuid_1C = cpuid_7B = cpuid_X1C = cpuid_X1D = 0;
     if (cpuid_max >= 1)
         CPUID(1, eax, ebx, cpuid_1C, cpuid_1D);
+    if (cpuid_max >= 7)
+        CPUID2(7, 0, eax, cpuid_7B, ecx, edx);
     if (cpuid_ext_max >= 0x80000001)
         CPUID(0x80000001, eax, ebx, cpuid_X1C, cpuid_X1D);
 
@@ -285,6 +323,20 @@ static int cpuinfo_x86(void)
         accel |= AC_SSE41;
     if (cpuid_1C & CPUID_1C_SSE42)
         accel |= AC_SSE42;
+    /* The AVX registers are only usable if the OS saves them, too */
+    xcr0 = 0;
+    if (cpuid_1C & CPUID_1C_OSXSAVE)
+        XGETBV0(xcr0, edx);
+    if ((cpuid_1C & CPUID_1C_AVX)
+     && (xcr0 & XCR0_SSE_AVX) == XCR0_SSE_AVX) {
+        accel |= AC_AVX;
+        if (cpuid_7B & CPUID_7B_AVX2)
+            accel |= AC_AVX2;
+        if ((cpuid_7B & CPUID_7B_AVX512F)
+         && (cpuid_7B & CPUID_7B_AVX512BW)
+         && (xcr0 & XCR0_AVX512) == XCR0_AVX512)
+            accel |= AC_AVX512BW;
+    }
     if (strcmp(cpu_vendor.string, "AuthenticAMD") == 0) {
         if (cpuid_X1D & CPUID_X1D_AMD_MMXEXT)
             accel |= AC_MMXEXT;
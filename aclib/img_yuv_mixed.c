@@ -19,72 +19,6 @@
 
 /*************************************************************************/
 
-/* Wrappers for UYVY and YVYU */
-/* Note: we rely on YUY2<->{UYVY,YVYU} working for src==dest */
-/* FIXME: when converting from UYVY/YVYU, src is destroyed! */
-
-static int uyvy_yvyu_wrapper(uint8_t **src, ImageFormat srcfmt,
-                             uint8_t **dest, ImageFormat destfmt,
-                             int width, int height)
-{
-    if (srcfmt == IMG_UYVY || srcfmt == IMG_YVYU)
-        return ac_imgconvert(src, srcfmt, src, IMG_YUY2, width, height)
-            && ac_imgconvert(src, IMG_YUY2, dest, destfmt, width, height);
-    else
-        return ac_imgconvert(src, srcfmt, dest, IMG_YUY2, width, height)
-            && ac_imgconvert(dest, IMG_YUY2, dest, destfmt, width, height);
-}
-
-static int yuv420p_uyvy(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YUV420P, dest, IMG_UYVY, width, height); }
-
-static int yuv420p_yvyu(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YUV420P, dest, IMG_YVYU, width, height); }
-
-static int yuv411p_uyvy(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YUV411P, dest, IMG_UYVY, width, height); }
-
-static int yuv411p_yvyu(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YUV411P, dest, IMG_YVYU, width, height); }
-
-static int yuv422p_uyvy(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YUV422P, dest, IMG_UYVY, width, height); }
-
-static int yuv422p_yvyu(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YUV422P, dest, IMG_YVYU, width, height); }
-
-static int yuv444p_uyvy(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YUV444P, dest, IMG_UYVY, width, height); }
-
-static int yuv444p_yvyu(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YUV444P, dest, IMG_YVYU, width, height); }
-
-static int uyvy_yuv420p(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_UYVY, dest, IMG_YUV420P, width, height); }
-
-static int yvyu_yuv420p(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YVYU, dest, IMG_YUV420P, width, height); }
-
-static int uyvy_yuv411p(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_UYVY, dest, IMG_YUV411P, width, height); }
-
-static int yvyu_yuv411p(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YVYU, dest, IMG_YUV411P, width, height); }
-
-static int uyvy_yuv422p(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_UYVY, dest, IMG_YUV422P, width, height); }
-
-static int yvyu_yuv422p(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YVYU, dest, IMG_YUV422P, width, height); }
-
-static int uyvy_yuv444p(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_UYVY, dest, IMG_YUV444P, width, height); }
-
-static int yvyu_yuv444p(uint8_t **src, uint8_t **dest, int width, int height)
-{ return uyvy_yvyu_wrapper(src, IMG_YVYU, dest, IMG_YUV444P, width, height); }
-
-/*************************************************************************/
-
 static int yuv420p_yuy2(uint8_t **src, uint8_t **dest, int width, int height)
 {
     int x, y;
@@ -903,24 +837,222 @@ static int uyvy_y8_sse2(uint8_t **src, uint8_t **dest, int width, int height)
 /*************************************************************************/
 /*************************************************************************/
 
+#if defined(HAVE_ASM_AVX2)
+
+/* AVX2 routines.  As with SSE2, we don't bother unrolling the loops; see
+ * img_yuv_planar.c for notes on VPERMQ and VZEROUPPER.  Unlike the SSE2
+ * set, these also convert directly to and from UYVY, instead of going
+ * through YUY2 twice. */
+
+/* Common macros/data for x86 code */
+#include "img_x86_common.h"
+
+/* Interleave the Y bytes in YMM0 with the U/V pairs in YMM2, for YUY2 or
+ * UYVY, leaving the results in YMM1 (low) and YMM0 (high) */
+#define AVX2_PACK_YUY2 \
+        "vpunpcklbw %%ymm2, %%ymm0, %%ymm1                              \n\
+        vpunpckhbw %%ymm2, %%ymm0, %%ymm0                               \n"
+#define AVX2_PACK_UYVY \
+        "vpunpcklbw %%ymm0, %%ymm2, %%ymm1                              \n\
+        vpunpckhbw %%ymm0, %%ymm2, %%ymm0                               \n"
+
+/* Small (1 unit) loops for the above */
+#define X86_YUV42XP_YUY2 \
+        "movb -1("EDX","ECX"), %%bh                                     \n\
+        movb -1("ESI","ECX",2), %%bl                                    \n\
+        shll $16, %%ebx                                                 \n\
+        movb -1("EAX","ECX"), %%bh                                      \n\
+        movb -2("ESI","ECX",2), %%bl                                    \n\
+        movl %%ebx, -4("EDI","ECX",4)"
+#define X86_YUV42XP_UYVY \
+        "movb -1("ESI","ECX",2), %%bh                                   \n\
+        movb -1("EDX","ECX"), %%bl                                      \n\
+        shll $16, %%ebx                                                 \n\
+        movb -2("ESI","ECX",2), %%bh                                    \n\
+        movb -1("EAX","ECX"), %%bl                                      \n\
+        movl %%ebx, -4("EDI","ECX",4)"
+
+/* YUV420P (1 row) or YUV422P -> YUY2 or UYVY (unit: 2 pixels) */
+#define YUV42XP_PACKED_AVX2(fmt) \
+    SIMD_LOOP_WRAPPER(                                                  \
+        /* blocksize */ 16,                                             \
+        /* push_regs */ PUSH(EBX),                                      \
+        /* pop_regs  */ POP(EBX),                                       \
+        /* small_loop */ X86_YUV42XP_##fmt,                             \
+        /* main_loop */                                                 \
+        "vmovdqu -32("ESI","ECX",2), %%ymm0 # YMM0: Y31..Y0             \n\
+        vmovdqu -16("EAX","ECX"), %%xmm2 # XMM2: U15..U0                \n\
+        vmovdqu -16("EDX","ECX"), %%xmm3 # XMM3: V15..V0                \n\
+        vpunpckhbw %%xmm3, %%xmm2, %%xmm1 # XMM1: V15 U15 ..... V8 U8   \n\
+        vpunpcklbw %%xmm3, %%xmm2, %%xmm2 # XMM2: V7 U7 ....... V0 U0   \n\
+        vinserti128 $1, %%xmm1, %%ymm2, %%ymm2 # YMM2: V15 U15 .. V0 U0 \n\
+        "AVX2_PACK_##fmt"       # YMM1: pixels 16-23 | 0-7              \n\
+                                # YMM0: pixels 24-31 | 8-15             \n\
+        vmovdqu %%xmm1, -64("EDI","ECX",4)                              \n\
+        vmovdqu %%xmm0, -48("EDI","ECX",4)                              \n\
+        vextracti128 $1, %%ymm1, -32("EDI","ECX",4)                     \n\
+        vextracti128 $1, %%ymm0, -16("EDI","ECX",4)",                   \
+        /* emms */ "vzeroupper")
+
+/* Split the row of YUY2 or UYVY pixels in YMM0 into Y (YMM1) and U/V
+ * (YMM0) words, doing the same to the U/V of the other row in YMM2 */
+#define AVX2_SPLIT_YUY2 \
+        "vpand %%ymm7, %%ymm0, %%ymm1                                   \n\
+        vpsrlw $8, %%ymm0, %%ymm0                                       \n\
+        vpsrlw $8, %%ymm2, %%ymm2                                       \n"
+#define AVX2_SPLIT_UYVY \
+        "vpsrlw $8, %%ymm0, %%ymm1                                      \n\
+        vpand %%ymm7, %%ymm0, %%ymm0                                    \n\
+        vpand %%ymm7, %%ymm2, %%ymm2                                    \n"
+
+/* Keep the U (even) or V (odd) words of the U/V pairs in YMM0 */
+#define AVX2_CHROMA_U   "vpand %%ymm6, %%ymm0, %%ymm0"
+#define AVX2_CHROMA_V   "vpsrld $16, %%ymm0, %%ymm0"
+
+/* Small (1 unit) loops: the byte offsets of the Y and U/V values */
+#define X86_PACKED_YUV420P(y0,y1,c) \
+        "movb "#y0"("ESI","ECX",4), %%bl                                \n\
+        movb %%bl, -2("EDI","ECX",2)                                    \n\
+        movb "#y1"("ESI","ECX",4), %%bl                                 \n\
+        movb %%bl, -1("EDI","ECX",2)                                    \n\
+        movzbl "#c"("ESI","ECX",4), %%ebx                               \n\
+        movzbl "#c"("EAX","ECX",4), %%ebp                               \n\
+        addl %%ebp, %%ebx                                               \n\
+        shrl $1, %%ebx                                                  \n\
+        movb %%bl, -1("EDX","ECX")"
+
+/* YUY2 or UYVY -> YUV420P (U or V row) (unit: 2 pixels) */
+#define PACKED_YUV420P_AVX2(fmt,chroma,small_loop) \
+    /* Load 0x00FF*16 into YMM7 and 0x0000FFFF*8 into YMM6 for masking */ \
+    "vpcmpeqd %%ymm7, %%ymm7, %%ymm7; vpsrld $16, %%ymm7, %%ymm6;"      \
+    "vpsrlw $8, %%ymm7, %%ymm7;"                                        \
+    SIMD_LOOP_WRAPPER(                                                  \
+        /* blocksize */ 8,                                              \
+        /* push_regs */ PUSH2(EBX,EBP),                                 \
+        /* pop_regs  */ POP2(EBP,EBX),                                  \
+        /* small_loop */ small_loop,                                    \
+        /* main_loop */                                                 \
+        "vmovdqu -32("ESI","ECX",4), %%ymm0 # YMM0: this row            \n\
+        vmovdqu -32("EAX","ECX",4), %%ymm2 # YMM2: other row            \n\
+        "AVX2_SPLIT_##fmt"                                              \n\
+        vpackuswb %%ymm1, %%ymm1, %%ymm1 # YMM1: Y15..Y8 | Y7..Y0       \n\
+        vpermq $0x08, %%ymm1, %%ymm1    # XMM1: Y15..Y0                 \n\
+        vpavgw %%ymm2, %%ymm0, %%ymm0   # YMM0: v7 u7 ........ v0 u0    \n\
+        "AVX2_CHROMA_##chroma"          # YMM0: -- c7 -- c6 ...... c0   \n\
+        vpackusdw %%ymm0, %%ymm0, %%ymm0                                \n\
+        vpackuswb %%ymm0, %%ymm0, %%ymm0 # YMM0: c7..c4 | c3..c0 (low)  \n\
+        vextracti128 $1, %%ymm0, %%xmm2                                 \n\
+        vpunpckldq %%xmm2, %%xmm0, %%xmm0 # XMM0: c7..c0                \n\
+        vmovdqu %%xmm1, -16("EDI","ECX",2)                              \n\
+        vmovq %%xmm0, -8("EDX","ECX")",                                 \
+        /* emms */ "vzeroupper")
+
+/*************************************************************************/
+
+#define DEFINE_YUV42XP_PACKED_AVX2(fmt,lcfmt) \
+static int yuv420p_##lcfmt##_avx2(uint8_t **src, uint8_t **dest,        \
+                                  int width, int height)                \
+{                                                                       \
+    int y;                                                              \
+    for (y = 0; y < (height & ~1); y++) {                               \
+        int dummy;                                                      \
+        asm volatile(YUV42XP_PACKED_AVX2(fmt)                           \
+            : "=c" (dummy)  /* Ensure GCC reloads ECX each time through */ \
+            : "S" (src[0]+y*width), "a" (src[1]+(y/2)*(width/2)),       \
+              "d" (src[2]+(y/2)*(width/2)), "D" (dest[0]+y*width*2),    \
+              "0" (width/2)                                             \
+              FAKE_PUSH_CLOBBER                                         \
+        );                                                              \
+    }                                                                   \
+    return 1;                                                           \
+}                                                                       \
+                                                                        \
+static int yuv422p_##lcfmt##_avx2(uint8_t **src, uint8_t **dest,        \
+                                  int width, int height)                \
+{                                                                       \
+    if (!(width & 1)) {                                                 \
+        asm(YUV42XP_PACKED_AVX2(fmt)                                    \
+            : /* no outputs */                                          \
+            : "S" (src[0]), "a" (src[1]), "d" (src[2]), "D" (dest[0]),  \
+              "c" ((width/2)*height)                                    \
+              FAKE_PUSH_CLOBBER                                         \
+        );                                                              \
+    } else {                                                            \
+        int y;                                                          \
+        for (y = 0; y < height; y++) {                                  \
+            int dummy;                                                  \
+            asm volatile(YUV42XP_PACKED_AVX2(fmt)                       \
+                : "=c" (dummy)                                          \
+                : "S" (src[0]+y*width), "a" (src[1]+y*(width/2)),       \
+                  "d" (src[2]+y*(width/2)), "D" (dest[0]+y*width*2),    \
+                  "0" (width/2)                                         \
+                  FAKE_PUSH_CLOBBER                                     \
+            );                                                          \
+        }                                                               \
+    }                                                                   \
+    return 1;                                                           \
+}
+
+#define DEFINE_PACKED_YUV420P_AVX2(fmt,lcfmt,y0,y1,u,v) \
+static int lcfmt##_yuv420p_avx2(uint8_t **src, uint8_t **dest,          \
+                                int width, int height)                  \
+{                                                                       \
+    int y;                                                              \
+                                                                        \
+    for (y = 0; y < (height & ~1); y += 2) {                            \
+        int dummy;                                                      \
+        asm volatile(PACKED_YUV420P_AVX2(fmt, U,                        \
+                                         X86_PACKED_YUV420P(y0,y1,u))   \
+            : "=c" (dummy)                                              \
+            : "S" (src[0]+y*width*2), "a" (src[0]+(y+1)*width*2),       \
+              "D" (dest[0]+y*width), "d" (dest[1]+(y/2)*(width/2)),     \
+              "0" (width/2)                                             \
+              FAKE_PUSH_CLOBBER_2                                       \
+        );                                                              \
+        asm volatile(PACKED_YUV420P_AVX2(fmt, V,                        \
+                                         X86_PACKED_YUV420P(y0,y1,v))   \
+            : "=c" (dummy)                                              \
+            : "S" (src[0]+(y+1)*width*2), "a" (src[0]+y*width*2),       \
+              "D" (dest[0]+(y+1)*width), "d" (dest[2]+(y/2)*(width/2)), \
+              "0" (width/2)                                             \
+              FAKE_PUSH_CLOBBER_2                                       \
+        );                                                              \
+    }                                                                   \
+    return 1;                                                           \
+}
+
+#ifdef ARCH_X86_64
+# define FAKE_PUSH_CLOBBER      : FAKE_PUSH_REG
+# define FAKE_PUSH_CLOBBER_2    : FAKE_PUSH_REG, FAKE_PUSH_REG_2
+#else
+# define FAKE_PUSH_CLOBBER      /*nothing*/
+# define FAKE_PUSH_CLOBBER_2    /*nothing*/
+#endif
+
+DEFINE_YUV42XP_PACKED_AVX2(YUY2, yuy2)
+DEFINE_YUV42XP_PACKED_AVX2(UYVY, uyvy)
+DEFINE_PACKED_YUV420P_AVX2(YUY2, yuy2, -4, -2, -3, -1)
+DEFINE_PACKED_YUV420P_AVX2(UYVY, uyvy, -3, -1, -4, -2)
+
+/*************************************************************************/
+
+#endif  /* HAVE_ASM_AVX2 */
+
+/*************************************************************************/
+/*************************************************************************/
+
 /* Initialization */
 
 int ac_imgconvert_init_yuv_mixed(int accel)
 {
+    /* Planar <-> UYVY/YVYU conversions without a routine of their own go
+     * through YUY2 (see the conversion planner in imgconvert.c) */
     if (!register_conversion(IMG_YUV420P, IMG_YUY2,    yuv420p_yuy2)
      || !register_conversion(IMG_YUV411P, IMG_YUY2,    yuv411p_yuy2)
      || !register_conversion(IMG_YUV422P, IMG_YUY2,    yuv422p_yuy2)
      || !register_conversion(IMG_YUV444P, IMG_YUY2,    yuv444p_yuy2)
      || !register_conversion(IMG_Y8,      IMG_YUY2,    y8_yuy2)
-     || !register_conversion(IMG_YUV420P, IMG_UYVY,    yuv420p_uyvy)
-     || !register_conversion(IMG_YUV411P, IMG_UYVY,    yuv411p_uyvy)
-     || !register_conversion(IMG_YUV422P, IMG_UYVY,    yuv422p_uyvy)
-     || !register_conversion(IMG_YUV444P, IMG_UYVY,    yuv444p_uyvy)
      || !register_conversion(IMG_Y8,      IMG_UYVY,    y8_uyvy)
-     || !register_conversion(IMG_YUV420P, IMG_YVYU,    yuv420p_yvyu)
-     || !register_conversion(IMG_YUV411P, IMG_YVYU,    yuv411p_yvyu)
-     || !register_conversion(IMG_YUV422P, IMG_YVYU,    yuv422p_yvyu)
-     || !register_conversion(IMG_YUV444P, IMG_YVYU,    yuv444p_yvyu)
      || !register_conversion(IMG_Y8,      IMG_YVYU,    y8_yuy2)
 
      || !register_conversion(IMG_YUY2,    IMG_YUV420P, yuy2_yuv420p)
@@ -928,15 +1060,7 @@ int ac_imgconvert_init_yuv_mixed(int accel)
      || !register_conversion(IMG_YUY2,    IMG_YUV422P, yuy2_yuv422p)
      || !register_conversion(IMG_YUY2,    IMG_YUV444P, yuy2_yuv444p)
      || !register_conversion(IMG_YUY2,    IMG_Y8,      yuy2_y8)
-     || !register_conversion(IMG_UYVY,    IMG_YUV420P, uyvy_yuv420p)
-     || !register_conversion(IMG_UYVY,    IMG_YUV411P, uyvy_yuv411p)
-     || !register_conversion(IMG_UYVY,    IMG_YUV422P, uyvy_yuv422p)
-     || !register_conversion(IMG_UYVY,    IMG_YUV444P, uyvy_yuv444p)
      || !register_conversion(IMG_UYVY,    IMG_Y8,      uyvy_y8)
-     || !register_conversion(IMG_YVYU,    IMG_YUV420P, yvyu_yuv420p)
-     || !register_conversion(IMG_YVYU,    IMG_YUV411P, yvyu_yuv411p)
-     || !register_conversion(IMG_YVYU,    IMG_YUV422P, yvyu_yuv422p)
-     || !register_conversion(IMG_YVYU,    IMG_YUV444P, yvyu_yuv444p)
      || !register_conversion(IMG_YVYU,    IMG_Y8,      yuy2_y8)
     ) {
         return 0;
@@ -965,6 +1089,21 @@ int ac_imgconvert_init_yuv_mixed(int accel)
     }
 #endif  /* HAVE_ASM_SSE2 */
 
+#if defined(HAVE_ASM_AVX2)
+    if (accel & AC_AVX2) {
+        if (!register_conversion(IMG_YUV420P, IMG_YUY2,    yuv420p_yuy2_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_YUY2,    yuv422p_yuy2_avx2)
+         || !register_conversion(IMG_YUV420P, IMG_UYVY,    yuv420p_uyvy_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_UYVY,    yuv422p_uyvy_avx2)
+
+         || !register_conversion(IMG_YUY2,    IMG_YUV420P, yuy2_yuv420p_avx2)
+         || !register_conversion(IMG_UYVY,    IMG_YUV420P, uyvy_yuv420p_avx2)
+        ) {
+            return 0;
+        }
+    }
+#endif  /* HAVE_ASM_AVX2 */
+
     return 1;
 }
 
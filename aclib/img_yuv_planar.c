@@ -522,7 +522,8 @@ static int y8_yuv444p(uint8_t **src, uint8_t **dest, int width, int height)
         movq %%xmm0, -8("EDI","ECX")",                                  \
         /* emms */ "emms")                                              \
         : "=c" (dummy)                                                  \
-        : "S" (src1), "d" (src2), "D" (dest), "c" (count));             \
+        : "S" (src1), "d" (src2), "D" (dest), "0" (count)               \
+        : "eax");                                                       \
 } while (0)
 
 /*************************************************************************/
@@ -713,6 +714,213 @@ static int yuv444p_yuv422p_sse2(uint8_t **src, uint8_t **dest, int width, int he
 /*************************************************************************/
 /*************************************************************************/
 
+#if defined(HAVE_ASM_AVX2)
+
+/* AVX2 routines.  These work on 32 bytes at a time, but the per-128-bit
+ * lane behavior of the pack/unpack instructions means the results of
+ * packing have to be put back in order with VPERMQ.  VZEROUPPER replaces
+ * EMMS, to avoid AVX->SSE transition penalties in the code following. */
+
+/* Common macros/data for x86 code */
+#include "img_x86_common.h"
+
+/* Average 2 bytes horizontally (e.g. 444P->422P) (unit: 2 source bytes) */
+#define AVG_2H_AVX2(src,dest,count)  do { \
+    int dummy;                                                          \
+    asm volatile(                                                       \
+        "vpcmpeqd %%ymm7, %%ymm7, %%ymm7; vpsrlw $8, %%ymm7, %%ymm7;"   \
+        SIMD_LOOP_WRAPPER(                                              \
+        /* blocksize */ 16,                                             \
+        /* push_regs */ "",                                             \
+        /* pop_regs  */ "",                                             \
+        /* small_loop */                                                \
+        "movzbl -2("ESI","ECX",2), %%eax                                \n\
+        movzbl -1("ESI","ECX",2), %%edx                                 \n\
+        addl %%edx, %%eax                                               \n\
+        shrl $1, %%eax                                                  \n\
+        movb %%al, -1("EDI","ECX")",                                    \
+        /* main_loop */                                                 \
+        "vmovdqu -32("ESI","ECX",2), %%ymm0                             \n\
+        vpand %%ymm7, %%ymm0, %%ymm1    # YMM1: even bytes              \n\
+        vpsrlw $8, %%ymm0, %%ymm0       # YMM0: odd bytes               \n\
+        vpavgw %%ymm1, %%ymm0, %%ymm0   # YMM0: averages (16-bit)       \n\
+        vpackuswb %%ymm0, %%ymm0, %%ymm0 # YMM0: 8 bytes in each lane   \n\
+        vpermq $0x08, %%ymm0, %%ymm0    # XMM0: all 16 averages         \n\
+        vmovdqu %%xmm0, -16("EDI","ECX")",                              \
+        /* emms */ "vzeroupper")                                        \
+        : "=c" (dummy)                                                  \
+        : "S" (src), "D" (dest), "0" (count)                            \
+        : "eax", "edx");                                                \
+} while (0)
+
+/* Repeat 2 bytes horizontally (e.g. 422P->444P) (unit: 1 source byte) */
+#define REP_2H_AVX2(src,dest,count)  do { \
+    int dummy;                                                          \
+    asm volatile(SIMD_LOOP_WRAPPER(                                     \
+        /* blocksize */ 16,                                             \
+        /* push_regs */ "",                                             \
+        /* pop_regs  */ "",                                             \
+        /* small_loop */                                                \
+        "movb -1("ESI","ECX"), %%al                                     \n\
+        movb %%al, %%ah                                                 \n\
+        movw %%ax, -2("EDI","ECX",2)",                                  \
+        /* main_loop */                                                 \
+        "vmovdqu -16("ESI","ECX"), %%xmm0 # XMM0: FEDCBA9876543210      \n\
+        vpermq $0x50, %%ymm0, %%ymm0    # YMM0: lanes 76543210/FEDCBA98 \n\
+        vpunpcklbw %%ymm0, %%ymm0, %%ymm0 # YMM0: FFEE...1100           \n\
+        vmovdqu %%ymm0, -32("EDI","ECX",2)",                            \
+        /* emms */ "vzeroupper")                                        \
+        : "=c" (dummy)                                                  \
+        : "S" (src), "D" (dest), "0" (count)                            \
+        : "eax");                                                       \
+} while (0)
+
+/* Average 2 bytes vertically (422P->420P) (unit: 1 source byte) */
+#define AVG_422_420_AVX2(src1,src2,dest,count)  do { \
+    int dummy;                                                          \
+    asm volatile(SIMD_LOOP_WRAPPER(                                     \
+        /* blocksize */ 32,                                             \
+        /* push_regs */ "push "EBX,                                     \
+        /* pop_regs  */ "pop "EBX,                                      \
+        /* small_loop */                                                \
+        "movzbl -1("ESI","ECX"), %%eax                                  \n\
+        movzbl -1("EDX","ECX"), %%ebx                                   \n\
+        addl %%ebx, %%eax                                               \n\
+        shrl $1, %%eax                                                  \n\
+        movb %%al, -1("EDI","ECX")",                                    \
+        /* main_loop */                                                 \
+        "vmovdqu -32("ESI","ECX"), %%ymm0                               \n\
+        vpavgb -32("EDX","ECX"), %%ymm0, %%ymm0                         \n\
+        vmovdqu %%ymm0, -32("EDI","ECX")",                              \
+        /* emms */ "vzeroupper")                                        \
+        : "=c" (dummy)                                                  \
+        : "S" (src1), "d" (src2), "D" (dest), "0" (count)               \
+        : "eax");                                                       \
+} while (0)
+
+/* Average 4 bytes, 2 horizontally and 2 vertically (444P->420P)
+ * (unit: 2 source bytes) */
+#define AVG_444_420_AVX2(src1,src2,dest,count)  do { \
+    int dummy;                                                          \
+    asm volatile(                                                       \
+        "vpcmpeqd %%ymm7, %%ymm7, %%ymm7; vpsrlw $8, %%ymm7, %%ymm7;"   \
+        SIMD_LOOP_WRAPPER(                                              \
+        /* blocksize */ 16,                                             \
+        /* push_regs */ "push "EBX,                                     \
+        /* pop_regs  */ "pop "EBX,                                      \
+        /* small_loop */                                                \
+        "movzbl -2("ESI","ECX",2), %%eax                                \n\
+        movzbl -1("ESI","ECX",2), %%ebx                                 \n\
+        addl %%ebx, %%eax                                               \n\
+        movzbl -2("EDX","ECX",2), %%ebx                                 \n\
+        addl %%ebx, %%eax                                               \n\
+        movzbl -1("EDX","ECX",2), %%ebx                                 \n\
+        addl %%ebx, %%eax                                               \n\
+        shrl $2, %%eax                                                  \n\
+        movb %%al, -1("EDI","ECX")",                                    \
+        /* main_loop */                                                 \
+        "vmovdqu -32("ESI","ECX",2), %%ymm0                             \n\
+        vmovdqu -32("EDX","ECX",2), %%ymm2                              \n\
+        vpsrlw $8, %%ymm0, %%ymm1                                       \n\
+        vpand %%ymm7, %%ymm0, %%ymm0                                    \n\
+        vpavgw %%ymm1, %%ymm0, %%ymm0                                   \n\
+        vpsrlw $8, %%ymm2, %%ymm3                                       \n\
+        vpand %%ymm7, %%ymm2, %%ymm2                                    \n\
+        vpavgw %%ymm3, %%ymm2, %%ymm2                                   \n\
+        vpavgw %%ymm2, %%ymm0, %%ymm0                                   \n\
+        vpackuswb %%ymm0, %%ymm0, %%ymm0                                \n\
+        vpermq $0x08, %%ymm0, %%ymm0                                    \n\
+        vmovdqu %%xmm0, -16("EDI","ECX")",                              \
+        /* emms */ "vzeroupper")                                        \
+        : "=c" (dummy)                                                  \
+        : "S" (src1), "d" (src2), "D" (dest), "0" (count)               \
+        : "eax");                                                       \
+} while (0)
+
+/*************************************************************************/
+
+static int yuv420p_yuv444p_avx2(uint8_t **src, uint8_t **dest, int width, int height)
+{
+    int y;
+    ac_memcpy(dest[0], src[0], width*height);
+    for (y = 0; y < height; y += 2) {
+        REP_2H_AVX2(src[1]+(y/2)*(width/2), dest[1]+y*width, width/2);
+        ac_memcpy(dest[1]+(y+1)*width, dest[1]+y*width, width);
+        REP_2H_AVX2(src[2]+(y/2)*(width/2), dest[2]+y*width, width/2);
+        ac_memcpy(dest[2]+(y+1)*width, dest[2]+y*width, width);
+    }
+    return 1;
+}
+
+static int yuv422p_yuv420p_avx2(uint8_t **src, uint8_t **dest, int width, int height)
+{
+    int y;
+    ac_memcpy(dest[0], src[0], width*height);
+    for (y = 0; y < (height & ~1); y += 2) {
+        AVG_422_420_AVX2(src[1]+y*(width/2), src[1]+(y+1)*(width/2),
+                         dest[1]+(y/2)*(width/2), width/2);
+        AVG_422_420_AVX2(src[2]+y*(width/2), src[2]+(y+1)*(width/2),
+                         dest[2]+(y/2)*(width/2), width/2);
+    }
+    return 1;
+}
+
+static int yuv422p_yuv444p_avx2(uint8_t **src, uint8_t **dest, int width, int height)
+{
+    ac_memcpy(dest[0], src[0], width*height);
+    if (!(width & 1)) {
+        /* Fast version, no bytes at end of row to skip */
+        REP_2H_AVX2(src[1], dest[1], (width/2)*height);
+        REP_2H_AVX2(src[2], dest[2], (width/2)*height);
+    } else {
+        /* Slow version, loop through each row */
+        int y;
+        for (y = 0; y < height; y++) {
+            REP_2H_AVX2(src[1]+y*(width/2), dest[1]+y*width, width/2);
+            REP_2H_AVX2(src[2]+y*(width/2), dest[2]+y*width, width/2);
+        }
+    }
+    return 1;
+}
+
+static int yuv444p_yuv420p_avx2(uint8_t **src, uint8_t **dest, int width, int height)
+{
+    int y;
+    ac_memcpy(dest[0], src[0], width*height);
+    for (y = 0; y < (height & ~1); y += 2) {
+        AVG_444_420_AVX2(src[1]+y*width, src[1]+(y+1)*width,
+                         dest[1]+(y/2)*(width/2), width/2);
+        AVG_444_420_AVX2(src[2]+y*width, src[2]+(y+1)*width,
+                         dest[2]+(y/2)*(width/2), width/2);
+    }
+    return 1;
+}
+
+static int yuv444p_yuv422p_avx2(uint8_t **src, uint8_t **dest, int width, int height)
+{
+    ac_memcpy(dest[0], src[0], width*height);
+    if (!(width & 1)) {
+        /* Fast version, no bytes at end of row to skip */
+        AVG_2H_AVX2(src[1], dest[1], (width/2)*height);
+        AVG_2H_AVX2(src[2], dest[2], (width/2)*height);
+    } else {
+        /* Slow version, loop through each row */
+        int y;
+        for (y = 0; y < height; y++) {
+            AVG_2H_AVX2(src[1]+y*width, dest[1]+y*(width/2), width/2);
+            AVG_2H_AVX2(src[2]+y*width, dest[2]+y*(width/2), width/2);
+        }
+    }
+    return 1;
+}
+
+/*************************************************************************/
+
+#endif  /* HAVE_ASM_AVX2 */
+
+/*************************************************************************/
+/*************************************************************************/
+
 /* Initialization */
 
 int ac_imgconvert_init_yuv_planar(int accel)
@@ -772,6 +980,19 @@ int ac_imgconvert_init_yuv_planar(int accel)
     }
 #endif  /* ARCH_X86 || ARCH_X86_64 */
 
+#if defined(HAVE_ASM_AVX2)
+    if (accel & AC_AVX2) {
+        if (!register_conversion(IMG_YUV420P, IMG_YUV444P, yuv420p_yuv444p_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_YUV420P, yuv422p_yuv420p_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_YUV444P, yuv422p_yuv444p_avx2)
+         || !register_conversion(IMG_YUV444P, IMG_YUV420P, yuv444p_yuv420p_avx2)
+         || !register_conversion(IMG_YUV444P, IMG_YUV422P, yuv444p_yuv422p_avx2)
+        ) {
+            return 0;
+        }
+    }
+#endif  /* HAVE_ASM_AVX2 */
+
     return 1;
 }
 
@@ -389,7 +389,7 @@ static int y8_argb32(uint8_t **src, uint8_t **dest, int width, int height)
 
 #include "img_x86_common.h"
 
-static const struct { uint16_t n[72]; } __attribute__((aligned(16))) yuv_data = {{
+static const struct { uint16_t n[80]; } __attribute__((aligned(16))) yuv_data = {{
     0x00FF,0x00FF,0x00FF,0x00FF,0x00FF,0x00FF,0x00FF,0x00FF, /* for odd/even */
     0x0010,0x0010,0x0010,0x0010,0x0010,0x0010,0x0010,0x0010, /* for Y -16    */
     0x0080,0x0080,0x0080,0x0080,0x0080,0x0080,0x0080,0x0080, /* for U/V -128 */
@@ -399,6 +399,7 @@ static const struct { uint16_t n[72]; } __attribute__((aligned(16))) yuv_data =
     0xE5FC,0xE5FC,0xE5FC,0xE5FC,0xE5FC,0xE5FC,0xE5FC,0xE5FC, /* gV constant  */
     0x408D,0x408D,0x408D,0x408D,0x408D,0x408D,0x408D,0x408D, /* bU constant  */
     0x0008,0x0008,0x0008,0x0008,0x0008,0x0008,0x0008,0x0008, /* for rounding */
+    0x0100,0x0402,0x0605,0x0908,0x0C0A,0x0E0D,0x8080,0x8080, /* RGBA->RGB    */
 }};
 /* Note that G->Y exceeds 0x7FFF, so be careful to treat it as unsigned
  * (the rest of the values are signed) */
@@ -2084,6 +2085,542 @@ static int y8_argb32_sse2(uint8_t **src, uint8_t **dest, int width, int height)
 /*************************************************************************/
 /*************************************************************************/
 
+#if defined(HAVE_ASM_AVX2)
+
+/* AVX2 routines.  These follow the SSE2 ones, on 32 pixels at a time for
+ * YUV->RGB and 16 for RGB->YUV, but the per-128-bit lane behavior of the
+ * pack/unpack instructions means each lane holds its own half of the
+ * pixels; the stores put the halves back in place.  Only the YUV420P and
+ * YUV422P formats, the ones actually used for encoding, have AVX2
+ * versions; the others keep using the SSE2 routines. */
+
+/*************************************************************************/
+
+static inline void avx2_load_yuv420p(uint8_t *srcY, uint8_t *srcU,
+                                     uint8_t *srcV, int x, int y, int width);
+static inline void avx2_load_yuv422p(uint8_t *srcY, uint8_t *srcU,
+                                     uint8_t *srcV, int x, int y, int width);
+static inline void avx2_yuv_to_rgb(void);
+static inline void avx2_store_rgb24(uint8_t *dest);
+static inline void avx2_store_bgr24(uint8_t *dest);
+static inline void avx2_store_rgba32(uint8_t *dest);
+static inline void avx2_store_abgr32(uint8_t *dest);
+static inline void avx2_store_argb32(uint8_t *dest);
+static inline void avx2_store_bgra32(uint8_t *dest);
+
+#define DEFINE_YUV2RGB_AVX2(yuv,rgb,rgbsz,slowop) \
+static int yuv##_##rgb##_avx2(uint8_t **src, uint8_t **dest,            \
+                              int width, int height)                    \
+{                                                                       \
+    int x, y;                                                           \
+                                                                        \
+    yuv_create_tables();                                                \
+    for (y = 0; y < height; y++) {                                      \
+        for (x = 0; x < (width & ~31); x += 32) {                       \
+            avx2_load_##yuv(src[0], src[1], src[2], x, y, width);       \
+            avx2_yuv_to_rgb();                                          \
+            avx2_store_##rgb(dest[0] + (y*width+x)*rgbsz);              \
+        }                                                               \
+        while (x < width) {                                             \
+            slowop;                                                     \
+            x++;                                                        \
+        }                                                               \
+    }                                                                   \
+    asm("vzeroupper");                                                  \
+    return 1;                                                           \
+}
+
+#define DEFINE_YUV2RGB_AVX2_SET(rgb,sz,r,g,b) \
+    DEFINE_YUV2RGB_AVX2(yuv420p, rgb,sz, YUV2RGB_420P(sz,r,g,b))        \
+    DEFINE_YUV2RGB_AVX2(yuv422p, rgb,sz, YUV2RGB_422P(sz,r,g,b))
+
+DEFINE_YUV2RGB_AVX2_SET(rgb24,  3,0,1,2)
+DEFINE_YUV2RGB_AVX2_SET(bgr24,  3,2,1,0)
+DEFINE_YUV2RGB_AVX2_SET(rgba32, 4,0,1,2)
+DEFINE_YUV2RGB_AVX2_SET(abgr32, 4,3,2,1)
+DEFINE_YUV2RGB_AVX2_SET(argb32, 4,1,2,3)
+DEFINE_YUV2RGB_AVX2_SET(bgra32, 4,2,1,0)
+
+/************************************/
+
+/* Y in YMM6 (even) and YMM7 (odd), U/V in YMM2/YMM3, all in 16 bits.
+ * Lane 0 holds pixels 0-15, lane 1 pixels 16-31. */
+#define AVX2_LOAD_YUVP "\
+        vmovdqu ("EAX"), %%ymm6         # YMM6: Y31..................Y0 \n\
+        vpmovzxbw ("ECX"), %%ymm2       # YMM2: U15..U0 in 16 bits      \n\
+        vpmovzxbw ("EDX"), %%ymm3       # YMM3: V15..V0 in 16 bits      \n\
+        vpsrlw $8, %%ymm6, %%ymm7       # YMM7: Y31 Y29 ........ Y3 Y1  \n\
+        vpsllw $8, %%ymm6, %%ymm6                                       \n\
+        vpsrlw $8, %%ymm6, %%ymm6       # YMM6: Y30 Y28 ........ Y2 Y0  \n"
+
+static inline void avx2_load_yuv420p(uint8_t *srcY, uint8_t *srcU,
+                                     uint8_t *srcV, int x, int y, int width)
+{
+    srcY += y*width+x;
+    srcU += (y/2)*(width/2)+(x/2);
+    srcV += (y/2)*(width/2)+(x/2);
+    asm(AVX2_LOAD_YUVP
+        : /* no outputs */
+        : "a" (srcY), "c" (srcU), "d" (srcV)
+    );
+}
+
+static inline void avx2_load_yuv422p(uint8_t *srcY, uint8_t *srcU,
+                                     uint8_t *srcV, int x, int y, int width)
+{
+    srcY += y*width+x;
+    srcU += y*(width/2)+(x/2);
+    srcV += y*(width/2)+(x/2);
+    asm(AVX2_LOAD_YUVP
+        : /* no outputs */
+        : "a" (srcY), "c" (srcU), "d" (srcV)
+    );
+}
+
+/************************************/
+
+/* Standard YUV->RGB (Yodd=YMM7 Yeven=YMM6 U=YMM2 V=YMM3), same arithmetic
+ * as sse2_yuv_to_rgb(); R/G/B end up in YMM0/YMM1/YMM2. */
+static inline void avx2_yuv_to_rgb(void)
+{
+    asm("\
+        vbroadcasti128 16("ESI"), %%ymm4 # YMM4: 16                     \n\
+        vpsubw %%ymm4, %%ymm6, %%ymm6   # YMM6: subtract 16             \n\
+        vpsllw $7, %%ymm6, %%ymm6       # YMM6: fixed point 8.7         \n\
+        vpsubw %%ymm4, %%ymm7, %%ymm7   # YMM7: subtract 16             \n\
+        vpsllw $7, %%ymm7, %%ymm7       # YMM7: fixed point 8.7         \n\
+        vbroadcasti128 32("ESI"), %%ymm4 # YMM4: 128                    \n\
+        vpsubw %%ymm4, %%ymm2, %%ymm2   # YMM2: subtract 128            \n\
+        vpsllw $7, %%ymm2, %%ymm2       # YMM2: fixed point 8.7         \n\
+        vpsubw %%ymm4, %%ymm3, %%ymm3   # YMM3: subtract 128            \n\
+        vpsllw $7, %%ymm3, %%ymm3       # YMM3: fixed point 8.7         \n\
+        # Multiply by constants                                         \n\
+        vbroadcasti128 48("ESI"), %%ymm4 # YMM4: Y constant             \n\
+        vpmulhw %%ymm4, %%ymm6, %%ymm6  # YMM6: cY30...............cY0  \n\
+        vpmulhw %%ymm4, %%ymm7, %%ymm7  # YMM7: cY31...............cY1  \n\
+        vbroadcasti128 80("ESI"), %%ymm4 # YMM4: gU constant            \n\
+        vpmulhw %%ymm2, %%ymm4, %%ymm4  # YMM4: gU15..............gU0   \n\
+        vbroadcasti128 96("ESI"), %%ymm5 # YMM5: gV constant            \n\
+        vpmulhw %%ymm3, %%ymm5, %%ymm5  # YMM5: gV15..............gV0   \n\
+        vpaddw %%ymm5, %%ymm4, %%ymm4   # YMM4: g15................g0   \n\
+        vbroadcasti128 64("ESI"), %%ymm0 # YMM0: rV constant            \n\
+        vpmulhw %%ymm0, %%ymm3, %%ymm3  # YMM3: r15................r0   \n\
+        vbroadcasti128 112("ESI"), %%ymm0 # YMM0: bU constant           \n\
+        vpmulhw %%ymm0, %%ymm2, %%ymm2  # YMM2: b15................b0   \n\
+        # Add intermediate results and round/shift to get R/G/B values  \n\
+        vbroadcasti128 128("ESI"), %%ymm0 # Rounding (0.5 @ 8.4 fixed)  \n\
+        vpaddw %%ymm0, %%ymm6, %%ymm6                                   \n\
+        vpaddw %%ymm0, %%ymm7, %%ymm7                                   \n\
+        vpaddw %%ymm6, %%ymm3, %%ymm0   # YMM0: R30 R28 ......... R2 R0 \n\
+        vpsraw $4, %%ymm0, %%ymm0       # Shift back to 8.0 fixed       \n\
+        vpaddw %%ymm6, %%ymm4, %%ymm1   # YMM1: G30 G28 ......... G2 G0 \n\
+        vpsraw $4, %%ymm1, %%ymm1                                       \n\
+        vpaddw %%ymm6, %%ymm2, %%ymm6   # YMM6: B30 B28 ......... B2 B0 \n\
+        vpsraw $4, %%ymm6, %%ymm6                                       \n\
+        vpaddw %%ymm7, %%ymm3, %%ymm3   # YMM3: R31 R29 ......... R3 R1 \n\
+        vpsraw $4, %%ymm3, %%ymm3                                       \n\
+        vpaddw %%ymm7, %%ymm4, %%ymm4   # YMM4: G31 G29 ......... G3 G1 \n\
+        vpsraw $4, %%ymm4, %%ymm4                                       \n\
+        vpaddw %%ymm7, %%ymm2, %%ymm5   # YMM5: B31 B29 ......... B3 B1 \n\
+        vpsraw $4, %%ymm5, %%ymm5                                       \n\
+        # Saturate to 0-255 and pack into bytes (within each lane)      \n\
+        vpackuswb %%ymm0, %%ymm0, %%ymm0                                \n\
+        vpackuswb %%ymm1, %%ymm1, %%ymm1                                \n\
+        vpackuswb %%ymm6, %%ymm6, %%ymm6                                \n\
+        vpackuswb %%ymm3, %%ymm3, %%ymm3                                \n\
+        vpackuswb %%ymm4, %%ymm4, %%ymm4                                \n\
+        vpackuswb %%ymm5, %%ymm5, %%ymm5                                \n\
+        vpunpcklbw %%ymm3, %%ymm0, %%ymm0 # YMM0: R31..R16 | R15..R0    \n\
+        vpunpcklbw %%ymm4, %%ymm1, %%ymm1 # YMM1: G31..G16 | G15..G0    \n\
+        vpunpcklbw %%ymm5, %%ymm6, %%ymm2 # YMM2: B31..B16 | B15..B0    \n"
+        : /* no outputs */
+        : "S" (&yuv_data), "m" (yuv_data)
+    );
+}
+
+/************************************/
+
+/* Convert YUV->RGB output to RGBA pixels in YMM0..YMM3; YMMn holds pixels
+ * 4n..4n+3 in lane 0 and 4n+16..4n+19 in lane 1. */
+#define AVX2_RGB_TO_RGBA "\
+        vpxor %%ymm7, %%ymm7, %%ymm7                                    \n\
+        vpunpcklbw %%ymm1, %%ymm0, %%ymm3 # G/R 16-23 | 0-7              \n\
+        vpunpckhbw %%ymm1, %%ymm0, %%ymm4 # G/R 24-31 | 8-15             \n\
+        vpunpcklbw %%ymm7, %%ymm2, %%ymm5 # 0/B 16-23 | 0-7              \n\
+        vpunpckhbw %%ymm7, %%ymm2, %%ymm6 # 0/B 24-31 | 8-15             \n\
+        vpunpcklwd %%ymm5, %%ymm3, %%ymm0                               \n\
+        vpunpckhwd %%ymm5, %%ymm3, %%ymm1                               \n\
+        vpunpcklwd %%ymm6, %%ymm4, %%ymm2                               \n\
+        vpunpckhwd %%ymm6, %%ymm4, %%ymm3                               \n"
+
+/* Convert YUV->RGB output to BGRA pixels in YMM0..YMM3 (as above) */
+#define AVX2_RGB_TO_BGRA "\
+        vpxor %%ymm7, %%ymm7, %%ymm7                                    \n\
+        vpunpcklbw %%ymm1, %%ymm2, %%ymm3 # G/B 16-23 | 0-7              \n\
+        vpunpckhbw %%ymm1, %%ymm2, %%ymm4 # G/B 24-31 | 8-15             \n\
+        vpunpcklbw %%ymm7, %%ymm0, %%ymm5 # 0/R 16-23 | 0-7              \n\
+        vpunpckhbw %%ymm7, %%ymm0, %%ymm6 # 0/R 24-31 | 8-15             \n\
+        vpunpcklwd %%ymm5, %%ymm3, %%ymm0                               \n\
+        vpunpckhwd %%ymm5, %%ymm3, %%ymm1                               \n\
+        vpunpcklwd %%ymm6, %%ymm4, %%ymm2                               \n\
+        vpunpckhwd %%ymm6, %%ymm4, %%ymm3                               \n"
+
+/* Shift RGBA (BGRA) pixels in YMM0..YMM3 to ARGB (ABGR) */
+#define AVX2_RGBA_TO_ARGB "\
+        vpslld $8, %%ymm0, %%ymm0                                       \n\
+        vpslld $8, %%ymm1, %%ymm1                                       \n\
+        vpslld $8, %%ymm2, %%ymm2                                       \n\
+        vpslld $8, %%ymm3, %%ymm3                                       \n"
+
+/* Store 32 RGBA32 pixels from YMM0..YMM3 at EDI */
+#define AVX2_STORE_RGB32 "\
+        vmovdqu %%xmm0,   ("EDI")                                       \n\
+        vmovdqu %%xmm1, 16("EDI")                                       \n\
+        vmovdqu %%xmm2, 32("EDI")                                       \n\
+        vmovdqu %%xmm3, 48("EDI")                                       \n\
+        vextracti128 $1, %%ymm0,  64("EDI")                             \n\
+        vextracti128 $1, %%ymm1,  80("EDI")                             \n\
+        vextracti128 $1, %%ymm2,  96("EDI")                             \n\
+        vextracti128 $1, %%ymm3, 112("EDI")                             \n"
+
+/* Pack 32 RGBA32 pixels in YMM0..YMM3 to RGB24 and store at EDI.  Each
+ * 16-byte store leaves 4 garbage bytes past its 12 pixel bytes, which the
+ * next store overwrites; the last one is split so as not to write past
+ * the 96 bytes of the block. */
+#define AVX2_STORE_RGB24 "\
+        vbroadcasti128 144("ESI"), %%ymm7 # YMM7: RGBA->RGB shuffle     \n\
+        vpshufb %%ymm7, %%ymm0, %%ymm0                                  \n\
+        vpshufb %%ymm7, %%ymm1, %%ymm1                                  \n\
+        vpshufb %%ymm7, %%ymm2, %%ymm2                                  \n\
+        vpshufb %%ymm7, %%ymm3, %%ymm3                                  \n\
+        vmovdqu %%xmm0,   ("EDI")                                       \n\
+        vmovdqu %%xmm1, 12("EDI")                                       \n\
+        vmovdqu %%xmm2, 24("EDI")                                       \n\
+        vmovdqu %%xmm3, 36("EDI")                                       \n\
+        vextracti128 $1, %%ymm0, 48("EDI")                              \n\
+        vextracti128 $1, %%ymm1, 60("EDI")                              \n\
+        vextracti128 $1, %%ymm2, 72("EDI")                              \n\
+        vextracti128 $1, %%ymm3, %%xmm3                                 \n\
+        vmovq %%xmm3, 84("EDI")                                         \n\
+        vpextrd $2, %%xmm3, 92("EDI")                                   \n"
+
+static inline void avx2_store_rgb24(uint8_t *dest)
+{
+    asm(AVX2_RGB_TO_RGBA AVX2_STORE_RGB24
+        : /* no outputs */
+        : "D" (dest), "S" (&yuv_data), "m" (yuv_data)
+    );
+}
+
+static inline void avx2_store_bgr24(uint8_t *dest)
+{
+    asm(AVX2_RGB_TO_BGRA AVX2_STORE_RGB24
+        : /* no outputs */
+        : "D" (dest), "S" (&yuv_data), "m" (yuv_data)
+    );
+}
+
+static inline void avx2_store_rgba32(uint8_t *dest)
+{
+    asm(AVX2_RGB_TO_RGBA AVX2_STORE_RGB32
+        : /* no outputs */
+        : "D" (dest)
+    );
+}
+
+static inline void avx2_store_abgr32(uint8_t *dest)
+{
+    asm(AVX2_RGB_TO_BGRA AVX2_RGBA_TO_ARGB AVX2_STORE_RGB32
+        : /* no outputs */
+        : "D" (dest)
+    );
+}
+
+static inline void avx2_store_argb32(uint8_t *dest)
+{
+    asm(AVX2_RGB_TO_RGBA AVX2_RGBA_TO_ARGB AVX2_STORE_RGB32
+        : /* no outputs */
+        : "D" (dest)
+    );
+}
+
+static inline void avx2_store_bgra32(uint8_t *dest)
+{
+    asm(AVX2_RGB_TO_BGRA AVX2_STORE_RGB32
+        : /* no outputs */
+        : "D" (dest)
+    );
+}
+
+/*************************************************************************/
+
+/* Shuffle masks picking one component of 8 packed pixels into 16-bit
+ * words: the A mask takes pixels 0-3 from the 16 bytes at the start of
+ * the pixels, the B mask pixels 4-7 from the 16 bytes ending with them. */
+#define AVX2_SHUF_A(bpp,c) \
+    0*bpp+c,0x80, 1*bpp+c,0x80, 2*bpp+c,0x80, 3*bpp+c,0x80,             \
+    0x80,0x80, 0x80,0x80, 0x80,0x80, 0x80,0x80
+#define AVX2_SHUF_B(bpp,c) \
+    0x80,0x80, 0x80,0x80, 0x80,0x80, 0x80,0x80,                         \
+    4*bpp+c-(8*bpp-16),0x80, 5*bpp+c-(8*bpp-16),0x80,                   \
+    6*bpp+c-(8*bpp-16),0x80, 7*bpp+c-(8*bpp-16),0x80
+
+/* 24-bit masks at 32*c, 32-bit masks at 96+32*c */
+static const struct { uint8_t n[7*32]; } __attribute__((aligned(16)))
+avx2_rgb_shuf = {{
+    AVX2_SHUF_A(3,0), AVX2_SHUF_B(3,0),
+    AVX2_SHUF_A(3,1), AVX2_SHUF_B(3,1),
+    AVX2_SHUF_A(3,2), AVX2_SHUF_B(3,2),
+    AVX2_SHUF_A(4,0), AVX2_SHUF_B(4,0),
+    AVX2_SHUF_A(4,1), AVX2_SHUF_B(4,1),
+    AVX2_SHUF_A(4,2), AVX2_SHUF_B(4,2),
+    AVX2_SHUF_A(4,3), AVX2_SHUF_B(4,3),
+}};
+
+static inline void avx2_load_rgb24(uint8_t *src);
+static inline void avx2_load_bgr24(uint8_t *src);
+static inline void avx2_load_rgba32(uint8_t *src);
+static inline void avx2_load_abgr32(uint8_t *src);
+static inline void avx2_load_argb32(uint8_t *src);
+static inline void avx2_load_bgra32(uint8_t *src);
+static inline void avx2_rgb_to_yuv420p(
+    uint8_t *destY, uint8_t *destU, uint8_t *destV, int x, int y, int width);
+static inline void avx2_rgb_to_yuv422p(
+    uint8_t *destY, uint8_t *destU, uint8_t *destV, int x, int y, int width);
+
+#define DEFINE_RGB2YUV_AVX2(rgb,yuv,rgbsz,rofs,gofs,bofs,slowop) \
+static int rgb##_##yuv##_avx2(uint8_t **src, uint8_t **dest,            \
+                              int width, int height)                    \
+{                                                                       \
+    int x, y;                                                           \
+                                                                        \
+    for (y = 0; y < height; y++) {                                      \
+        for (x = 0; x < (width & ~15); x += 16) {                       \
+            avx2_load_##rgb(src[0]+(y*width+x)*rgbsz);                  \
+            avx2_rgb_to_##yuv(dest[0], dest[1], dest[2], x, y, width);  \
+        }                                                               \
+        while (x < width) {                                             \
+            int r = src[0][(y*width+x)*rgbsz+rofs];                     \
+            int g = src[0][(y*width+x)*rgbsz+gofs];                     \
+            int b = src[0][(y*width+x)*rgbsz+bofs];                     \
+            slowop;                                                     \
+            x++;                                                        \
+        }                                                               \
+    }                                                                   \
+    asm("vzeroupper");                                                  \
+    return 1;                                                           \
+}
+
+#define DEFINE_RGB2YUV_AVX2_SET(rgb,sz,r,g,b) \
+    DEFINE_RGB2YUV_AVX2(rgb,yuv420p, sz,r,g,b, RGB2YUV_420P)            \
+    DEFINE_RGB2YUV_AVX2(rgb,yuv422p, sz,r,g,b, RGB2YUV_422P)
+
+DEFINE_RGB2YUV_AVX2_SET(rgb24,  3,0,1,2)
+DEFINE_RGB2YUV_AVX2_SET(bgr24,  3,2,1,0)
+DEFINE_RGB2YUV_AVX2_SET(rgba32, 4,0,1,2)
+DEFINE_RGB2YUV_AVX2_SET(abgr32, 4,3,2,1)
+DEFINE_RGB2YUV_AVX2_SET(argb32, 4,1,2,3)
+DEFINE_RGB2YUV_AVX2_SET(bgra32, 4,2,1,0)
+
+/************************************/
+
+/* Load 16 pixels of `bpp' bytes into R/G/B in YMM0/YMM1/YMM2 (16 bits),
+ * pixels 0-7 in lane 0 and 8-15 in lane 1.  The offsets are those of the
+ * A and B loads for pixels 8-15, and of the R/G/B shuffle masks. */
+#define AVX2_LOAD_RGB(lo,hi8,hi,r,g,b) "\
+        vmovdqu ("ESI"), %%xmm3                                         \n\
+        vinserti128 $1, "hi8"("ESI"), %%ymm3, %%ymm3                    \n\
+        vmovdqu "lo"("ESI"), %%xmm4                                     \n\
+        vinserti128 $1, "hi"("ESI"), %%ymm4, %%ymm4                     \n\
+        vbroadcasti128 "r"("EDI"), %%ymm5                               \n\
+        vpshufb %%ymm5, %%ymm3, %%ymm0                                  \n\
+        vbroadcasti128 "r"+16("EDI"), %%ymm5                            \n\
+        vpshufb %%ymm5, %%ymm4, %%ymm5                                  \n\
+        vpor %%ymm5, %%ymm0, %%ymm0     # YMM0: R15..............R0     \n\
+        vbroadcasti128 "g"("EDI"), %%ymm5                               \n\
+        vpshufb %%ymm5, %%ymm3, %%ymm1                                  \n\
+        vbroadcasti128 "g"+16("EDI"), %%ymm5                            \n\
+        vpshufb %%ymm5, %%ymm4, %%ymm5                                  \n\
+        vpor %%ymm5, %%ymm1, %%ymm1     # YMM1: G15..............G0     \n\
+        vbroadcasti128 "b"("EDI"), %%ymm5                               \n\
+        vpshufb %%ymm5, %%ymm3, %%ymm2                                  \n\
+        vbroadcasti128 "b"+16("EDI"), %%ymm5                            \n\
+        vpshufb %%ymm5, %%ymm4, %%ymm5                                  \n\
+        vpor %%ymm5, %%ymm2, %%ymm2     # YMM2: B15..............B0     \n"
+
+static inline void avx2_load_rgb24(uint8_t *src)
+{
+    asm(AVX2_LOAD_RGB("8","24","32","0","32","64")
+        : /* no outputs */
+        : "S" (src), "D" (&avx2_rgb_shuf), "m" (avx2_rgb_shuf)
+    );
+}
+
+static inline void avx2_load_bgr24(uint8_t *src)
+{
+    asm(AVX2_LOAD_RGB("8","24","32","64","32","0")
+        : /* no outputs */
+        : "S" (src), "D" (&avx2_rgb_shuf), "m" (avx2_rgb_shuf)
+    );
+}
+
+static inline void avx2_load_rgba32(uint8_t *src)
+{
+    asm(AVX2_LOAD_RGB("16","32","48","96","128","160")
+        : /* no outputs */
+        : "S" (src), "D" (&avx2_rgb_shuf), "m" (avx2_rgb_shuf)
+    );
+}
+
+static inline void avx2_load_abgr32(uint8_t *src)
+{
+    asm(AVX2_LOAD_RGB("16","32","48","192","160","128")
+        : /* no outputs */
+        : "S" (src), "D" (&avx2_rgb_shuf), "m" (avx2_rgb_shuf)
+    );
+}
+
+static inline void avx2_load_argb32(uint8_t *src)
+{
+    asm(AVX2_LOAD_RGB("16","32","48","128","160","192")
+        : /* no outputs */
+        : "S" (src), "D" (&avx2_rgb_shuf), "m" (avx2_rgb_shuf)
+    );
+}
+
+static inline void avx2_load_bgra32(uint8_t *src)
+{
+    asm(AVX2_LOAD_RGB("16","32","48","160","128","96")
+        : /* no outputs */
+        : "S" (src), "D" (&avx2_rgb_shuf), "m" (avx2_rgb_shuf)
+    );
+}
+
+/************************************/
+
+/* Same arithmetic as the SSE2_RGB2* macros, with the constants broadcast
+ * from the 128-bit rows of rgb_data */
+#define AVX2_RGB2Y "\
+        # Make RGB data into 8.6 fixed-point, then create 8.6           \n\
+        # fixed-point Y data in YMM3                                    \n\
+        vpsllw $6, %%ymm0, %%ymm0                                       \n\
+        vbroadcasti128 ("EDI"), %%ymm3                                  \n\
+        vpmulhuw %%ymm0, %%ymm3, %%ymm3                                 \n\
+        vpsllw $6, %%ymm1, %%ymm1                                       \n\
+        vbroadcasti128 16("EDI"), %%ymm6                                \n\
+        vpmulhuw %%ymm1, %%ymm6, %%ymm6                                 \n\
+        vpsllw $6, %%ymm2, %%ymm2                                       \n\
+        vbroadcasti128 32("EDI"), %%ymm7                                \n\
+        vpmulhuw %%ymm2, %%ymm7, %%ymm7                                 \n\
+        vpaddw %%ymm6, %%ymm3, %%ymm3   # No possibility of overflow    \n\
+        vpaddw %%ymm7, %%ymm3, %%ymm3                                   \n\
+        vbroadcasti128 144("EDI"), %%ymm6                               \n\
+        vpaddw %%ymm6, %%ymm3, %%ymm3                                   \n"
+#define AVX2_RGB2U "\
+        # Create 8.6 fixed-point U data in YMM4                         \n\
+        vbroadcasti128 48("EDI"), %%ymm4                                \n\
+        vpmulhw %%ymm0, %%ymm4, %%ymm4                                  \n\
+        vbroadcasti128 64("EDI"), %%ymm6                                \n\
+        vpmulhw %%ymm1, %%ymm6, %%ymm6                                  \n\
+        vbroadcasti128 80("EDI"), %%ymm7                                \n\
+        vpmulhw %%ymm2, %%ymm7, %%ymm7                                  \n\
+        vpaddw %%ymm6, %%ymm4, %%ymm4                                   \n\
+        vpaddw %%ymm7, %%ymm4, %%ymm4                                   \n\
+        vbroadcasti128 160("EDI"), %%ymm6                               \n\
+        vpaddw %%ymm6, %%ymm4, %%ymm4                                   \n"
+#define AVX2_RGB2V "\
+        # Create 8.6 fixed-point V data in YMM0                         \n\
+        vbroadcasti128 96("EDI"), %%ymm6                                \n\
+        vpmulhw %%ymm6, %%ymm0, %%ymm0                                  \n\
+        vbroadcasti128 112("EDI"), %%ymm6                               \n\
+        vpmulhw %%ymm6, %%ymm1, %%ymm1                                  \n\
+        vbroadcasti128 128("EDI"), %%ymm6                               \n\
+        vpmulhw %%ymm6, %%ymm2, %%ymm2                                  \n\
+        vpaddw %%ymm1, %%ymm0, %%ymm0                                   \n\
+        vpaddw %%ymm2, %%ymm0, %%ymm0                                   \n\
+        vbroadcasti128 160("EDI"), %%ymm6                               \n\
+        vpaddw %%ymm6, %%ymm0, %%ymm0                                   \n"
+/* Y values to bytes, in order in XMM3 */
+#define AVX2_PACKY "\
+        vpsraw $6, %%ymm3, %%ymm3                                       \n\
+        vpackuswb %%ymm3, %%ymm3, %%ymm3                                \n\
+        vpermq $0x08, %%ymm3, %%ymm3    # XMM3: Y15..............Y0     \n"
+/* Even (U) or odd (V) chroma values of YMMn to 8 bytes, in order in XMMn */
+#define AVX2_STRIPU(N) "\
+        vpsraw $6, %%ymm"#N", %%ymm"#N"                                 \n\
+        vpackuswb %%ymm"#N", %%ymm"#N", %%ymm"#N"                       \n\
+        vpsllw $8, %%ymm"#N", %%ymm"#N"                                 \n\
+        vpsrlw $8, %%ymm"#N", %%ymm"#N"                                 \n\
+        vpackuswb %%ymm"#N", %%ymm"#N", %%ymm"#N"                       \n\
+        vextracti128 $1, %%ymm"#N", %%xmm5                              \n\
+        vpunpckldq %%xmm5, %%xmm"#N", %%xmm"#N"                         \n"
+#define AVX2_STRIPV "\
+        vpsraw $6, %%ymm0, %%ymm0                                       \n\
+        vpackuswb %%ymm0, %%ymm0, %%ymm0                                \n\
+        vpsrlw $8, %%ymm0, %%ymm0                                       \n\
+        vpackuswb %%ymm0, %%ymm0, %%ymm0                                \n\
+        vextracti128 $1, %%ymm0, %%xmm5                                 \n\
+        vpunpckldq %%xmm5, %%xmm0, %%xmm0                               \n"
+
+static inline void avx2_rgb_to_yuv420p(
+    uint8_t *destY, uint8_t *destU, uint8_t *destV, int x, int y, int width)
+{
+    if (y%2 == 0) {
+        asm("\
+            "AVX2_RGB2Y"                                                \n\
+            "AVX2_RGB2U"                                                \n\
+            "AVX2_PACKY"                                                \n\
+            "AVX2_STRIPU(4)"                                            \n\
+            # Store into destination pointers                           \n\
+            vmovdqu %%xmm3, ("EAX")                                     \n\
+            vmovq %%xmm4, ("ECX")                                       \n"
+            : /* no outputs */
+            : "a" (destY+y*width+x), "c" (destU+(y/2)*(width/2)+(x/2)),
+              "D" (&rgb_data), "m" (rgb_data)
+        );
+    } else {
+        asm("\
+            "AVX2_RGB2Y"                                                \n\
+            "AVX2_RGB2V"                                                \n\
+            "AVX2_PACKY"                                                \n\
+            "AVX2_STRIPV"                                               \n\
+            # Store into destination pointers                           \n\
+            vmovdqu %%xmm3, ("EAX")                                     \n\
+            vmovq %%xmm0, ("EDX")                                       \n"
+            : /* no outputs */
+            : "a" (destY+y*width+x), "d" (destV+(y/2)*(width/2)+(x/2)),
+              "D" (&rgb_data), "m" (rgb_data)
+        );
+    }
+}
+
+static inline void avx2_rgb_to_yuv422p(
+    uint8_t *destY, uint8_t *destU, uint8_t *destV, int x, int y, int width)
+{
+    asm("\
+        "AVX2_RGB2Y"                                                    \n\
+        "AVX2_RGB2U"                                                    \n\
+        "AVX2_RGB2V"                                                    \n\
+        "AVX2_PACKY"                                                    \n\
+        "AVX2_STRIPU(4)"                                                \n\
+        "AVX2_STRIPV"                                                   \n\
+        # Store into destination pointers                               \n\
+        vmovdqu %%xmm3, ("EAX")                                         \n\
+        vmovq %%xmm4, ("ECX")                                           \n\
+        vmovq %%xmm0, ("EDX")                                           \n"
+        : /* no outputs */
+        : "a" (destY+y*width+x), "c" (destU+y*(width/2)+(x/2)),
+          "d" (destV+y*(width/2)+(x/2)), "D" (&rgb_data), "m" (rgb_data)
+    );
+}
+
+/*************************************************************************/
+
+#endif  /* HAVE_ASM_AVX2 */
+
+/*************************************************************************/
+/*************************************************************************/
+
 /* Initialization */
 
 int ac_imgconvert_init_yuv_rgb(int accel)
@@ -2394,6 +2931,46 @@ int ac_imgconvert_init_yuv_rgb(int accel)
     }
 #endif
 
+    /******** AVX2 implementations ********/
+
+#if defined(HAVE_ASM_AVX2)
+    if (HAS_ACCEL(accel, AC_AVX2)) {
+
+        //---- YUV->RGB ----//
+
+        if (!register_conversion(IMG_YUV420P, IMG_RGB24,  yuv420p_rgb24_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_RGB24,  yuv422p_rgb24_avx2)
+         || !register_conversion(IMG_YUV420P, IMG_BGR24,  yuv420p_bgr24_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_BGR24,  yuv422p_bgr24_avx2)
+         || !register_conversion(IMG_YUV420P, IMG_RGBA32, yuv420p_rgba32_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_RGBA32, yuv422p_rgba32_avx2)
+         || !register_conversion(IMG_YUV420P, IMG_ABGR32, yuv420p_abgr32_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_ABGR32, yuv422p_abgr32_avx2)
+         || !register_conversion(IMG_YUV420P, IMG_ARGB32, yuv420p_argb32_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_ARGB32, yuv422p_argb32_avx2)
+         || !register_conversion(IMG_YUV420P, IMG_BGRA32, yuv420p_bgra32_avx2)
+         || !register_conversion(IMG_YUV422P, IMG_BGRA32, yuv422p_bgra32_avx2)
+
+        //---- RGB->YUV ----//
+
+         || !register_conversion(IMG_RGB24,   IMG_YUV420P, rgb24_yuv420p_avx2)
+         || !register_conversion(IMG_RGB24,   IMG_YUV422P, rgb24_yuv422p_avx2)
+         || !register_conversion(IMG_BGR24,   IMG_YUV420P, bgr24_yuv420p_avx2)
+         || !register_conversion(IMG_BGR24,   IMG_YUV422P, bgr24_yuv422p_avx2)
+         || !register_conversion(IMG_RGBA32,  IMG_YUV420P, rgba32_yuv420p_avx2)
+         || !register_conversion(IMG_RGBA32,  IMG_YUV422P, rgba32_yuv422p_avx2)
+         || !register_conversion(IMG_ABGR32,  IMG_YUV420P, abgr32_yuv420p_avx2)
+         || !register_conversion(IMG_ABGR32,  IMG_YUV422P, abgr32_yuv422p_avx2)
+         || !register_conversion(IMG_ARGB32,  IMG_YUV420P, argb32_yuv420p_avx2)
+         || !register_conversion(IMG_ARGB32,  IMG_YUV422P, argb32_yuv422p_avx2)
+         || !register_conversion(IMG_BGRA32,  IMG_YUV420P, bgra32_yuv420p_avx2)
+         || !register_conversion(IMG_BGRA32,  IMG_YUV422P, bgra32_yuv422p_avx2)
+        ) {
+            return 0;
+        }
+    }
+#endif
+
     return 1;
 }
 
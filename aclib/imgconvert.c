@@ -14,14 +14,51 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*************************************************************************/
 
+/* Conversions are looked up in a table indexed by format: YUV formats
+ * first, then RGB formats.  For pairs with no registered conversion, the
+ * planner (see plan_routes()) stores the sequence of conversions to go
+ * through instead, if there is one. */
+
+#define N_YUV_FORMATS   (IMG_YUV_LAST - IMG_YUV_BASE - 1)
+#define N_RGB_FORMATS   (IMG_RGB_LAST - IMG_RGB_BASE - 1)
+#define N_FORMATS       (N_YUV_FORMATS + N_RGB_FORMATS)
+
+/* Maximum number of conversions in a route */
+#define MAX_HOPS        3
+
+/* Approximate amount of intermediate data per strip for routed
+ * conversions; small enough to stay in the L2 cache */
+#define STRIP_BYTES     65536
+
+static ConversionFunc conversions[N_FORMATS][N_FORMATS];
+
 static struct {
-    ImageFormat srcfmt, destfmt;
-    ConversionFunc func;
-} *conversions;
-static int n_conversions = 0;
+    int hops;                   /* Number of conversions, 0 if none */
+    int8_t via[MAX_HOPS-1];     /* Intermediate formats (indices) */
+} routes[N_FORMATS][N_FORMATS];
+
+static int format_index(ImageFormat fmt)
+{
+    if (IS_YUV_FORMAT(fmt))
+        return fmt - IMG_YUV_BASE - 1;
+    if (IS_RGB_FORMAT(fmt))
+        return N_YUV_FORMATS + (fmt - IMG_RGB_BASE - 1);
+    return -1;
+}
+
+static ImageFormat index_format(int i)
+{
+    if (i < N_YUV_FORMATS)
+        return IMG_YUV_BASE + 1 + i;
+    return IMG_RGB_BASE + 1 + (i - N_YUV_FORMATS);
+}
+
+static int convert_routed(uint8_t **src, int s, uint8_t **dest, int d,
+                          int width, int height);
 
 /*************************************************************************/
 /*************************************************************************/
@@ -35,7 +72,7 @@ int ac_imgconvert(uint8_t **src, ImageFormat srcfmt,
                   uint8_t **dest, ImageFormat destfmt,
                   int width, int height)
 {
-    int i;
+    int s, d;
 
     /* Hack to handle YV12 easily, because conversion routines don't get
      * format tags */
@@ -55,12 +92,494 @@ int ac_imgconvert(uint8_t **src, ImageFormat srcfmt,
         dest = newdest;
     }
 
-    for (i = 0; i < n_conversions; i++) {
-        if (conversions[i].srcfmt==srcfmt && conversions[i].destfmt==destfmt)
-            return (*conversions[i].func)(src, dest, width, height);
+    s = format_index(srcfmt);
+    d = format_index(destfmt);
+    if (s < 0 || d < 0)
+        return 0;
+    if (conversions[s][d])
+        return (*conversions[s][d])(src, dest, width, height);
+    if (routes[s][d].hops > 0)
+        return convert_routed(src, s, dest, d, width, height);
+    return 0;
+}
+
+/* Return the number of conversions ac_imgconvert() goes through for the
+ * given formats (0 if it can't convert), and store the intermediate
+ * formats in `via' if not NULL. */
+
+int ac_imgconvert_route(ImageFormat srcfmt, ImageFormat destfmt,
+                        ImageFormat *via)
+{
+    int s, d, i;
+
+    s = format_index(srcfmt == IMG_YV12 ? IMG_YUV420P : srcfmt);
+    d = format_index(destfmt == IMG_YV12 ? IMG_YUV420P : destfmt);
+    if (s < 0 || d < 0)
+        return 0;
+    if (conversions[s][d])
+        return 1;
+    for (i = 0; via && i < routes[s][d].hops - 1; i++)
+        via[i] = index_format(routes[s][d].via[i]);
+    return routes[s][d].hops;
+}
+
+/*************************************************************************/
+
+/* Layout of each image format: number of planes, bytes per pixel in the
+ * first plane, and horizontal/vertical subsampling of the U/V planes (for
+ * packed YUV formats, xsub is the number of pixels sharing a U/V pair). */
+
+static const struct {
+    ImageFormat fmt;
+    int planes, bpp, xsub, ysub;
+} layouts[] = {
+    { IMG_YUV420P, 3, 1, 2, 2 },
+    { IMG_YV12,    3, 1, 2, 2 },
+    { IMG_YUV411P, 3, 1, 4, 1 },
+    { IMG_YUV422P, 3, 1, 2, 1 },
+    { IMG_YUV444P, 3, 1, 1, 1 },
+    { IMG_YUY2,    1, 2, 2, 1 },
+    { IMG_UYVY,    1, 2, 2, 1 },
+    { IMG_YVYU,    1, 2, 2, 1 },
+    { IMG_Y8,      1, 1, 1, 1 },
+    { IMG_RGB24,   1, 3, 1, 1 },
+    { IMG_BGR24,   1, 3, 1, 1 },
+    { IMG_RGBA32,  1, 4, 1, 1 },
+    { IMG_ABGR32,  1, 4, 1, 1 },
+    { IMG_ARGB32,  1, 4, 1, 1 },
+    { IMG_BGRA32,  1, 4, 1, 1 },
+    { IMG_GRAY8,   1, 1, 1, 1 },
+};
+
+static int find_layout(ImageFormat fmt)
+{
+    int i;
+    for (i = 0; i < sizeof(layouts) / sizeof(*layouts); i++) {
+        if (layouts[i].fmt == fmt)
+            return i;
     }
+    return -1;
+}
 
-    return 0;
+/* Bytes of data in one row of plane `p', and number of rows in it */
+#define PLANE_WIDTH(l,p,w) \
+    ((p)==0 ? (w)*layouts[(l)].bpp : (w)/layouts[(l)].xsub)
+#define PLANE_ROWS(l,p,h) \
+    ((p)==0 ? (h) : (h)/layouts[(l)].ysub)
+
+/* Round `n' up to a multiple of `align' (a power of 2) */
+#define ALIGN_UP(n,align)   (((n) + (align)-1) & ~((align)-1))
+
+/*************************************************************************/
+
+/* Image descriptor routines; see imgconvert.h for details. */
+
+int ac_image_size(ImageFormat fmt, int width, int height, int align)
+{
+    int l = find_layout(fmt);
+    int p, size = 0;
+
+    if (align <= 0)
+        align = 1;
+    if (l < 0 || width <= 0 || height <= 0 || (align & (align-1)))
+        return 0;
+    for (p = 0; p < layouts[l].planes; p++) {
+        size += ALIGN_UP(PLANE_WIDTH(l, p, width), align)
+              * PLANE_ROWS(l, p, height);
+    }
+    return size;
+}
+
+int ac_image_init(ACImage *img, ImageFormat fmt, uint8_t *buffer,
+                  int width, int height, int align)
+{
+    int l = find_layout(fmt);
+    int p;
+
+    if (!img || !buffer || !ac_image_size(fmt, width, height, align))
+        return 0;
+    if (align <= 0)
+        align = 1;
+    img->format = fmt;
+    img->width  = width;
+    img->height = height;
+    for (p = 0; p < 4; p++) {
+        if (p < layouts[l].planes) {
+            img->planes[p] = buffer;
+            img->stride[p] = ALIGN_UP(PLANE_WIDTH(l, p, width), align);
+            buffer += img->stride[p] * PLANE_ROWS(l, p, height);
+        } else {
+            img->planes[p] = NULL;
+            img->stride[p] = 0;
+        }
+    }
+    return 1;
+}
+
+int ac_image_crop(ACImage *sub, const ACImage *img,
+                  int x, int y, int width, int height)
+{
+    int l, p;
+
+    if (!sub || !img || (l = find_layout(img->format)) < 0)
+        return 0;
+    if (x < 0 || y < 0 || width <= 0 || height <= 0
+     || x + width > img->width || y + height > img->height
+     || x % layouts[l].xsub != 0 || y % layouts[l].ysub != 0)
+        return 0;
+    *sub = *img;
+    sub->width  = width;
+    sub->height = height;
+    sub->planes[0] += y*img->stride[0] + x*layouts[l].bpp;
+    for (p = 1; p < layouts[l].planes; p++) {
+        sub->planes[p] += (y / layouts[l].ysub) * img->stride[p]
+                        + x / layouts[l].xsub;
+    }
+    return 1;
+}
+
+/*************************************************************************/
+
+/* Are all the rows of an image contiguous? */
+static int image_is_packed(const ACImage *img, int l)
+{
+    int p;
+    for (p = 0; p < layouts[l].planes; p++) {
+        if (img->stride[p] != PLANE_WIDTH(l, p, img->width))
+            return 0;
+    }
+    return 1;
+}
+
+/* Copy `rows' rows of `width' bytes between buffers with the given
+ * strides */
+static void copy_rows(uint8_t *dest, int dest_stride,
+                      const uint8_t *src, int src_stride,
+                      int width, int rows)
+{
+    int i;
+    for (i = 0; i < rows; i++)
+        ac_memcpy(dest + i*dest_stride, src + i*src_stride, width);
+}
+
+/* Conversion of padded/cropped images.  The conversion routines only know
+ * about contiguous planes, so the image is converted a band of rows at a
+ * time: one row, except when a YUV420P image is involved, since its U/V
+ * rows are shared by two rows of pixels.  A single row is always
+ * contiguous, so the routines work directly on the image data; for two
+ * rows, the planes with padding are gathered into (or scattered from) a
+ * small contiguous buffer, which stays in the cache. */
+
+int ac_imgconvert_image(const ACImage *src, ACImage *dest)
+{
+    const ACImage *img[2];
+    uint8_t *planes[2][3], *stage[2][3], *buffer = NULL;
+    int lay[2], band, size, side, p, y;
+
+    if (!src || !dest)
+        return 0;
+    lay[0] = find_layout(src->format);
+    lay[1] = find_layout(dest->format);
+    if (lay[0] < 0 || lay[1] < 0 || src->width <= 0 || src->height <= 0
+     || src->width != dest->width || src->height != dest->height)
+        return 0;
+
+    if (image_is_packed(src, lay[0]) && image_is_packed(dest, lay[1])) {
+        for (p = 0; p < 3; p++) {
+            planes[0][p] = src->planes[p];
+            planes[1][p] = dest->planes[p];
+        }
+        return ac_imgconvert(planes[0], src->format, planes[1], dest->format,
+                             src->width, src->height);
+    }
+
+    img[0] = src;
+    img[1] = dest;
+    for (p = 0; p < 3; p++) {
+        planes[0][p] = planes[1][p] = NULL;
+        stage[0][p] = stage[1][p] = NULL;
+    }
+    band = (layouts[lay[0]].ysub > 1 || layouts[lay[1]].ysub > 1) ? 2 : 1;
+
+    /* Set up the staging buffers for planes which need them */
+    size = 0;
+    for (side = 0; side < 2; side++) {
+        int l = lay[side];
+        for (p = 0; p < layouts[l].planes; p++) {
+            int width = PLANE_WIDTH(l, p, img[side]->width);
+            if (band > 1 && img[side]->stride[p] != width)
+                size += width * PLANE_ROWS(l, p, band);
+        }
+    }
+    if (size > 0) {
+        buffer = malloc(size);
+        if (!buffer) {
+            fprintf(stderr, "ac_imgconvert_image(): out of memory\n");
+            return 0;
+        }
+        size = 0;
+        for (side = 0; side < 2; side++) {
+            int l = lay[side];
+            for (p = 0; p < layouts[l].planes; p++) {
+                int width = PLANE_WIDTH(l, p, img[side]->width);
+                if (band > 1 && img[side]->stride[p] != width) {
+                    stage[side][p] = buffer + size;
+                    size += width * PLANE_ROWS(l, p, band);
+                }
+            }
+        }
+    }
+
+    for (y = 0; y < src->height; y += band) {
+        int rows = src->height - y < band ? src->height - y : band;
+        uint8_t *data[2][3];
+        int nrows[2][3];
+
+        for (side = 0; side < 2; side++) {
+            int l = lay[side];
+            for (p = 0; p < layouts[l].planes; p++) {
+                int prows = PLANE_ROWS(l, p, img[side]->height);
+                int row = PLANE_ROWS(l, p, y);
+                nrows[side][p] = PLANE_ROWS(l, p, rows);
+                if (side == 0 && nrows[0][p] == 0)
+                    nrows[0][p] = 1;  /* last row of an odd height */
+                if (row >= prows)
+                    row = prows - 1;  /* ...whose U/V row is the last */
+                if (nrows[side][p] > prows - row)
+                    nrows[side][p] = prows - row;
+                data[side][p] = img[side]->planes[p]
+                              + row * img[side]->stride[p];
+                planes[side][p] = stage[side][p] ? stage[side][p]
+                                                 : data[side][p];
+            }
+        }
+
+        /* Destination rows are gathered as well, so that bytes the
+         * conversion doesn't write (like alpha) are left untouched */
+        for (side = 0; side < 2; side++) {
+            int l = lay[side];
+            for (p = 0; p < layouts[l].planes; p++) {
+                if (stage[side][p]) {
+                    int width = PLANE_WIDTH(l, p, img[side]->width);
+                    copy_rows(stage[side][p], width,
+                              data[side][p], img[side]->stride[p],
+                              width, nrows[side][p]);
+                }
+            }
+        }
+        if (!ac_imgconvert(planes[0], src->format, planes[1], dest->format,
+                           src->width, rows)) {
+            free(buffer);
+            return 0;
+        }
+        for (p = 0; p < layouts[lay[1]].planes; p++) {
+            if (stage[1][p]) {
+                copy_rows(data[1][p], dest->stride[p],
+                          stage[1][p], PLANE_WIDTH(lay[1], p, dest->width),
+                          PLANE_WIDTH(lay[1], p, dest->width), nrows[1][p]);
+            }
+        }
+    }
+
+    free(buffer);
+    return 1;
+}
+
+/*************************************************************************/
+
+/* Conversion through intermediate formats.  The image is converted a strip
+ * of rows at a time, each strip going through all the conversions of the
+ * route before the next one, so the intermediate data stays in the cache
+ * instead of making full-size passes over memory.  Full rows of a
+ * contiguous image are contiguous as well, so the conversion routines can
+ * work directly on each strip of the source and destination images. */
+
+static int convert_routed(uint8_t **src, int s, uint8_t **dest, int d,
+                          int width, int height)
+{
+    int hops = routes[s][d].hops;
+    int fmt[MAX_HOPS+1], lay[MAX_HOPS+1];
+    uint8_t *buffer, *tmp[MAX_HOPS-1];
+    int rowsize, strip, size, h, p, y;
+
+    if (width <= 0 || height <= 0)
+        return 0;
+    fmt[0] = index_format(s);
+    for (h = 1; h < hops; h++)
+        fmt[h] = index_format(routes[s][d].via[h-1]);
+    fmt[hops] = index_format(d);
+    for (h = 0; h <= hops; h++)
+        lay[h] = find_layout(fmt[h]);
+
+    /* Strips have an even number of rows, for formats with vertically
+     * subsampled U/V planes */
+    rowsize = 0;
+    for (h = 1; h < hops; h++)
+        rowsize += ac_image_size(fmt[h], width, 2, 0) / 2;
+    strip = (STRIP_BYTES / rowsize) & ~1;
+    if (strip < 2)
+        strip = 2;
+    if (strip > height)
+        strip = height;
+
+    size = 0;
+    for (h = 1; h < hops; h++)
+        size += ac_image_size(fmt[h], width, strip, 0);
+    buffer = malloc(size);
+    if (!buffer) {
+        fprintf(stderr, "ac_imgconvert(): out of memory\n");
+        return 0;
+    }
+    size = 0;
+    for (h = 1; h < hops; h++) {
+        tmp[h-1] = buffer + size;
+        size += ac_image_size(fmt[h], width, strip, 0);
+    }
+
+    for (y = 0; y < height; y += strip) {
+        int rows = height - y < strip ? height - y : strip;
+        uint8_t *in[3], *out[3];
+
+        for (p = 0; p < layouts[lay[0]].planes; p++) {
+            in[p] = src[p] + PLANE_WIDTH(lay[0], p, width)
+                           * PLANE_ROWS(lay[0], p, y);
+        }
+        for (h = 0; h < hops; h++) {
+            int l = lay[h+1];
+            if (h == hops-1) {
+                for (p = 0; p < layouts[l].planes; p++) {
+                    out[p] = dest[p] + PLANE_WIDTH(l, p, width)
+                                     * PLANE_ROWS(l, p, y);
+                }
+            } else {
+                ACImage img;
+                ac_image_init(&img, fmt[h+1], tmp[h], width, rows, 0);
+                for (p = 0; p < 3; p++)
+                    out[p] = img.planes[p];
+            }
+            if (!(*conversions[format_index(fmt[h])]
+                              [format_index(fmt[h+1])])(in, out,
+                                                        width, rows)) {
+                free(buffer);
+                return 0;
+            }
+            for (p = 0; p < 3; p++)
+                in[p] = out[p];
+        }
+    }
+
+    free(buffer);
+    return 1;
+}
+
+/*************************************************************************/
+
+/* Conversion planner: for each pair of formats without a registered
+ * conversion, find the cheapest sequence of registered conversions
+ * between them.  The cost of a conversion is the amount of data it reads
+ * and writes per pixel, plus a fixed cost per conversion.  Only formats
+ * which keep all the information the destination can hold from the
+ * source are used as intermediates: no Y-only formats, no coarser U/V
+ * subsampling than both ends, and alpha formats between alpha formats. */
+
+#define HOP_COST        4
+
+/* Half-bytes of data per pixel */
+static int pixel_cost(int l)
+{
+    if (layouts[l].planes == 1)
+        return layouts[l].bpp * 2;
+    return 2 + 4 / (layouts[l].xsub * layouts[l].ysub);
+}
+
+static int is_gray(ImageFormat fmt)
+{
+    return fmt == IMG_Y8 || fmt == IMG_GRAY8;
+}
+
+static int can_go_through(int k, int s, int d)
+{
+    ImageFormat fk = index_format(k), fs = index_format(s),
+                fd = index_format(d);
+    int lk = find_layout(fk), ls = find_layout(fs), ld = find_layout(fd);
+
+    if (lk < 0 || fk == IMG_YV12 || is_gray(fk))
+        return 0;
+    if (!is_gray(fs) && !is_gray(fd)) {
+        int xsub = layouts[ls].xsub > layouts[ld].xsub
+                 ? layouts[ls].xsub : layouts[ld].xsub;
+        int ysub = layouts[ls].ysub > layouts[ld].ysub
+                 ? layouts[ls].ysub : layouts[ld].ysub;
+        if (layouts[lk].xsub > xsub || layouts[lk].ysub > ysub)
+            return 0;
+    }
+    if (layouts[ls].bpp == 4 && layouts[ld].bpp == 4
+     && layouts[lk].bpp != 4)
+        return 0;
+    return 1;
+}
+
+/* Dijkstra's algorithm over the (small) conversion graph, limited to
+ * MAX_HOPS conversions */
+static void plan_route(int s, int d)
+{
+    int cost[N_FORMATS], hops[N_FORMATS], prev[N_FORMATS], done[N_FORMATS];
+    int i, u, v;
+
+    for (i = 0; i < N_FORMATS; i++) {
+        cost[i] = -1;
+        done[i] = 0;
+    }
+    cost[s] = 0;
+    hops[s] = 0;
+    for (;;) {
+        u = -1;
+        for (i = 0; i < N_FORMATS; i++) {
+            if (!done[i] && cost[i] >= 0 && (u < 0 || cost[i] < cost[u]))
+                u = i;
+        }
+        if (u < 0 || u == d)
+            break;
+        done[u] = 1;
+        if (hops[u] == MAX_HOPS || (u != s && !can_go_through(u, s, d)))
+            continue;
+        for (v = 0; v < N_FORMATS; v++) {
+            int c;
+            if (done[v] || !conversions[u][v])
+                continue;
+            c = cost[u] + pixel_cost(find_layout(index_format(u)))
+              + pixel_cost(find_layout(index_format(v))) + HOP_COST;
+            if (cost[v] < 0 || c < cost[v]) {
+                cost[v] = c;
+                hops[v] = hops[u] + 1;
+                prev[v] = u;
+            }
+        }
+    }
+
+    routes[s][d].hops = 0;
+    if (cost[d] < 0)
+        return;
+    routes[s][d].hops = hops[d];
+    for (v = d, i = hops[d] - 2; i >= 0; i--) {
+        v = prev[v];
+        routes[s][d].via[i] = v;
+    }
+}
+
+static void plan_routes(void)
+{
+    int s, d;
+
+    for (s = 0; s < N_FORMATS; s++) {
+        for (d = 0; d < N_FORMATS; d++) {
+            routes[s][d].hops = 0;
+            if (s != d && !conversions[s][d]
+             && find_layout(index_format(s)) >= 0
+             && find_layout(index_format(d)) >= 0)
+                plan_route(s, d);
+        }
+    }
 }
 
 /*************************************************************************/
@@ -70,6 +589,9 @@ int ac_imgconvert(uint8_t **src, ImageFormat srcfmt,
 
 int ac_imgconvert_init(int accel)
 {
+    /* Start from scratch, so that routines for another `accel' value
+     * don't stay around */
+    memset(conversions, 0, sizeof(conversions));
     if (!ac_imgconvert_init_yuv_planar(accel)
      || !ac_imgconvert_init_yuv_packed(accel)
      || !ac_imgconvert_init_yuv_mixed(accel)
@@ -79,30 +601,21 @@ int ac_imgconvert_init(int accel)
         fprintf(stderr, "ac_imgconvert_init() failed");
         return 0;
     }
+    plan_routes();
     return 1;
 }
 
 int register_conversion(ImageFormat srcfmt, ImageFormat destfmt,
                         ConversionFunc function)
 {
-    int i;
-
-    for (i = 0; i < n_conversions; i++) {
-        if (conversions[i].srcfmt==srcfmt && conversions[i].destfmt==destfmt) {
-            conversions[i].func = function;
-            return 1;
-        }
-    }
+    int s = format_index(srcfmt), d = format_index(destfmt);
 
-    if (!(conversions = realloc(conversions,
-                                (n_conversions+1) * sizeof(*conversions)))) {
-        fprintf(stderr, "register_conversion(): out of memory\n");
+    if (s < 0 || d < 0) {
+        fprintf(stderr, "register_conversion(): bad format 0x%X->0x%X\n",
+                srcfmt, destfmt);
         return 0;
     }
-    conversions[n_conversions].srcfmt  = srcfmt;
-    conversions[n_conversions].destfmt = destfmt;
-    conversions[n_conversions].func    = function;
-    n_conversions++;
+    conversions[s][d] = function;
     return 1;
 }
 
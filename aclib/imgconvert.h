@@ -65,23 +65,25 @@ typedef enum {
      (planes)[1] = (planes)[0] + (w)*(h),      \
      (planes)[2] = (planes)[1] + UV_PLANE_SIZE((fmt),(w),(h)))
 
-#if 0
-/* Structure describing an image.  FIXME: not currently used--this should
- * eventually replace the (planes,format) pairs passed to ac_imgconvert. */
+/* Structure describing an image whose rows may be padded (stride larger
+ * than the row data) or which may be a sub-rectangle of a larger image.
+ * The planes are in the same order as for ac_imgconvert() (so for IMG_YV12,
+ * planes[1] is the V plane). */
 typedef struct {
     ImageFormat format;  /* Format of image data */
     int width, height;   /* Size of image */
     uint8_t *planes[4];  /* Data planes (use planes[0] for packed data) */
     int stride[4];       /* Length of one row in each plane, incl. padding */
-} Image;
-#endif
+} ACImage;
 
 /*************************************************************************/
 
 /* Initialization routine.  Returns 1 on success, 0 on failure. */
 extern int ac_imgconvert_init(int accel);
 
-/* Conversion routine.  Returns 1 on success, 0 on failure. */
+/* Conversion routine.  Pairs of formats without a direct conversion are
+ * converted through intermediate formats, a strip of rows at a time.
+ * Returns 1 on success, 0 on failure. */
 extern int ac_imgconvert(uint8_t **src,         /* Array of source planes */
                          ImageFormat srcfmt,    /* Source image format */
                          uint8_t **dest,        /* Array of dest planes */
@@ -90,6 +92,49 @@ extern int ac_imgconvert(uint8_t **src,         /* Array of source planes */
                          int height             /* Image height in pixels */
                         );
 
+/* Number of conversions ac_imgconvert() goes through to convert between
+ * the given formats: 1 for a direct conversion, 0 if the formats can't be
+ * converted.  If `via' is not NULL, the intermediate formats (at most 2)
+ * are stored there. */
+extern int ac_imgconvert_route(ImageFormat srcfmt,   /* Source format */
+                               ImageFormat destfmt,  /* Dest format */
+                               ImageFormat *via      /* Intermediates */
+                              );
+
+/* Size in bytes of a buffer for an image laid out by ac_image_init(), or
+ * 0 if the parameters are invalid. */
+extern int ac_image_size(ImageFormat fmt,       /* Image format */
+                         int width,             /* Image width in pixels */
+                         int height,            /* Image height in pixels */
+                         int align              /* Row alignment (bytes) */
+                        );
+
+/* Initialize an image descriptor for a buffer of ac_image_size() bytes.
+ * Each row of each plane starts at a multiple of `align' bytes (a power
+ * of 2; 0 or 1 for tightly packed rows) from the start of the buffer.
+ * Returns 1 on success, 0 on failure. */
+extern int ac_image_init(ACImage *img,          /* Descriptor to set */
+                         ImageFormat fmt,       /* Image format */
+                         uint8_t *buffer,       /* Image data */
+                         int width,             /* Image width in pixels */
+                         int height,            /* Image height in pixels */
+                         int align              /* Row alignment (bytes) */
+                        );
+
+/* Set `sub' to describe the given rectangle of `img', sharing its data.
+ * The rectangle must be inside the image, and x/y must fall on a chroma
+ * sample (e.g. even for YUV420P).  Returns 1 on success, 0 on failure. */
+extern int ac_image_crop(ACImage *sub,          /* Descriptor to set */
+                         const ACImage *img,    /* Containing image */
+                         int x, int y,          /* Top left corner */
+                         int width, int height  /* Size of rectangle */
+                        );
+
+/* Conversion routine for image descriptors: like ac_imgconvert(), but the
+ * rows of either image may be padded or belong to a larger image.  Both
+ * images must have the same size.  Returns 1 on success, 0 on failure. */
+extern int ac_imgconvert_image(const ACImage *src, ACImage *dest);
+
 /*************************************************************************/
 
 #endif  /* ACLIB_IMGCONVERT_H */
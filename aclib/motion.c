@@ -0,0 +1,602 @@
+/*
+ * motion.c -- block matching for motion estimation
+ *
+ * This file is part of transcode, a video stream processing tool.
+ * transcode is free software, distributable under the terms of the GNU
+ * General Public License (version 2 or later).  See the file COPYING
+ * for details.
+ */
+
+#include "ac.h"
+#include "ac_internal.h"
+
+#include <stdlib.h>
+
+static uint32_t sad(const uint8_t *, int, const uint8_t *, int, int, int);
+static uint32_t sad_avg(const uint8_t *, int, const uint8_t *,
+                        const uint8_t *, int, int, int);
+static uint64_t ssd(const uint8_t *, int, const uint8_t *, int, int, int);
+static uint32_t (*sad_ptr)(const uint8_t *, int, const uint8_t *, int,
+                           int, int)
+    = sad;
+static uint32_t (*sad_avg_ptr)(const uint8_t *, int, const uint8_t *,
+                               const uint8_t *, int, int, int)
+    = sad_avg;
+static uint64_t (*ssd_ptr)(const uint8_t *, int, const uint8_t *, int,
+                           int, int)
+    = ssd;
+
+/*************************************************************************/
+
+/* External interface */
+
+uint32_t ac_sad(const uint8_t *src1, int stride1,
+                const uint8_t *src2, int stride2, int width, int height)
+{
+    return (*sad_ptr)(src1, stride1, src2, stride2, width, height);
+}
+
+uint32_t ac_sad_avg(const uint8_t *src1, int stride1,
+                    const uint8_t *src2a, const uint8_t *src2b,
+                    int stride2, int width, int height)
+{
+    return (*sad_avg_ptr)(src1, stride1, src2a, src2b, stride2,
+                          width, height);
+}
+
+uint64_t ac_ssd(const uint8_t *src1, int stride1,
+                const uint8_t *src2, int stride2, int width, int height)
+{
+    return (*ssd_ptr)(src1, stride1, src2, stride2, width, height);
+}
+
+/*************************************************************************/
+
+/* Searches, built on the block functions above.  They are cheap next to
+ * the SADs they call, so there is only the one version of each. */
+
+void ac_motion_search(const uint8_t *cur, int cur_stride,
+                      const uint8_t *ref, int ref_stride,
+                      int width, int height, int radius, int step,
+                      ACMotionVector *mv)
+{
+    int cx = mv->x, cy = mv->y, bx = cx, by = cy, dx, dy;
+    uint32_t best = UINT32_MAX;
+
+    if (step < 1)
+        step = 1;
+    for (dx = cx - radius; dx <= cx + radius; dx += step) {
+        for (dy = cy - radius; dy <= cy + radius; dy += step) {
+            uint32_t cost = (*sad_ptr)(cur, cur_stride,
+                                       ref + dy*ref_stride + dx, ref_stride,
+                                       width, height);
+            if (cost < best) {
+                best = cost;
+                bx = dx;
+                by = dy;
+            }
+        }
+    }
+    if (step > 1) {
+        cx = bx;
+        cy = by;
+        for (dx = cx - (step-1); dx <= cx + (step-1); dx++) {
+            for (dy = cy - (step-1); dy <= cy + (step-1); dy++) {
+                uint32_t cost;
+                if (dx == cx && dy == cy)
+                    continue;
+                cost = (*sad_ptr)(cur, cur_stride,
+                                  ref + dy*ref_stride + dx, ref_stride,
+                                  width, height);
+                if (cost < best) {
+                    best = cost;
+                    bx = dx;
+                    by = dy;
+                }
+            }
+        }
+    }
+    mv->x = bx;
+    mv->y = by;
+    mv->cost = best;
+}
+
+void ac_motion_search_hier(const uint8_t * const *cur,
+                           const uint8_t * const *ref,
+                           const int *stride, int levels,
+                           int x, int y, int width, int height,
+                           int radius, ACMotionVector *mv)
+{
+    int top = levels > 1 ? levels-1 : 0, l;
+
+    mv->x = 0;
+    mv->y = 0;
+    for (l = top; l >= 0; l--) {
+        int lx = x >> l, ly = y >> l;
+        int lw = width >> l, lh = height >> l;
+        int offset = ly*stride[l] + lx;
+        if (lw < 1)
+            lw = 1;
+        if (lh < 1)
+            lh = 1;
+        if (l == top) {
+            ac_motion_search(cur[l] + offset, stride[l],
+                             ref[l] + offset, stride[l],
+                             lw, lh, radius >> l, 1, mv);
+        } else {
+            mv->x *= 2;
+            mv->y *= 2;
+            ac_motion_search(cur[l] + offset, stride[l],
+                             ref[l] + offset, stride[l],
+                             lw, lh, 1, 1, mv);
+        }
+    }
+}
+
+void ac_motion_halfpel(const uint8_t *cur, int cur_stride,
+                       const uint8_t *ref, int ref_stride,
+                       int width, int height, ACMotionVector *mv)
+{
+    const uint8_t *p = ref + mv->y*ref_stride + mv->x;
+    int bx = 0, by = 0, hx, hy;
+    uint32_t best = (*sad_ptr)(cur, cur_stride, p, ref_stride,
+                               width, height);
+
+    /* Diagonal positions average the two pixels on the diagonal rather
+     * than all four, as yuvdenoise always has. */
+    for (hy = -1; hy <= 1; hy++) {
+        for (hx = -1; hx <= 1; hx++) {
+            const uint8_t *a, *b;
+            uint32_t cost;
+            if (!hx && !hy)
+                continue;
+            a = p + (hy < 0 ? -ref_stride : 0) + (hx < 0 ? -1 : 0);
+            b = p + (hy > 0 ? ref_stride : 0) + (hx > 0 ? 1 : 0);
+            cost = (*sad_avg_ptr)(cur, cur_stride, a, b, ref_stride,
+                                  width, height);
+            if (cost < best) {
+                best = cost;
+                bx = hx;
+                by = hy;
+            }
+        }
+    }
+    mv->x = mv->x*2 + bx;
+    mv->y = mv->y*2 + by;
+    mv->cost = best;
+}
+
+void ac_downsample2(const uint8_t *src, int src_stride,
+                    uint8_t *dest, int dest_stride, int width, int height)
+{
+    int x, y;
+
+    for (y = 0; y < height; y++) {
+        const uint8_t *s0 = src + (2*y)*src_stride;
+        const uint8_t *s1 = s0 + src_stride;
+        uint8_t *d = dest + y*dest_stride;
+        for (x = 0; x < width; x++)
+            d[x] = (s0[2*x] + s0[2*x+1] + s1[2*x] + s1[2*x+1] + 2) >> 2;
+    }
+}
+
+/*************************************************************************/
+/*************************************************************************/
+
+/* Vanilla C versions */
+
+static uint32_t sad(const uint8_t *src1, int stride1,
+                    const uint8_t *src2, int stride2, int width, int height)
+{
+    uint32_t sum = 0;
+    int x, y;
+
+    for (y = 0; y < height; y++, src1 += stride1, src2 += stride2) {
+        for (x = 0; x < width; x++)
+            sum += abs(src1[x] - src2[x]);
+    }
+    return sum;
+}
+
+static uint32_t sad_avg(const uint8_t *src1, int stride1,
+                        const uint8_t *src2a, const uint8_t *src2b,
+                        int stride2, int width, int height)
+{
+    uint32_t sum = 0;
+    int x, y;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++)
+            sum += abs(src1[x] - ((src2a[x] + src2b[x] + 1) >> 1));
+        src1 += stride1;
+        src2a += stride2;
+        src2b += stride2;
+    }
+    return sum;
+}
+
+static uint64_t ssd(const uint8_t *src1, int stride1,
+                    const uint8_t *src2, int stride2, int width, int height)
+{
+    uint64_t sum = 0;
+    int x, y;
+
+    for (y = 0; y < height; y++, src1 += stride1, src2 += stride2) {
+        uint32_t rowsum = 0;
+        for (x = 0; x < width; x++) {
+            int d = src1[x] - src2[x];
+            rowsum += d*d;
+        }
+        sum += rowsum;
+    }
+    return sum;
+}
+
+/*************************************************************************/
+
+/* Common declarations for the x86 versions */
+
+#if defined(HAVE_ASM_SSE2)
+
+#define XMM_CLOBBERS \
+    "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm7"
+
+#endif  /* HAVE_ASM_SSE2 */
+
+/*************************************************************************/
+
+/* SSE2 versions.  Each row is done 16 bytes at a time, then 8; anything
+ * left over (less than 8 bytes per row) is added in C. */
+
+#if defined(HAVE_ASM_SSE2)
+
+static uint32_t sad_sse2(const uint8_t *src1, int stride1,
+                         const uint8_t *src2, int stride2,
+                         int width, int height)
+{
+    long w16 = width & ~15, w8 = width & ~7, x;
+    long s1 = stride1, s2 = stride2;
+    int rows = height;
+    uint32_t sum = 0;
+
+    if (UNLIKELY(height <= 0))
+        return 0;
+    if (w8 > 0) {
+        const uint8_t *p1 = src1, *p2 = src2;
+        asm("pxor %%xmm0, %%xmm0                                        \n\
+            0:                                                          \n\
+            xor %[x], %[x]                                              \n\
+            cmp %[w16], %[x]                                            \n\
+            jae 2f                                                      \n\
+            1:                                                          \n\
+            movdqu (%[p1],%[x]), %%xmm1                                 \n\
+            movdqu (%[p2],%[x]), %%xmm2                                 \n\
+            psadbw %%xmm2, %%xmm1                                       \n\
+            paddq %%xmm1, %%xmm0                                        \n\
+            add $16, %[x]                                               \n\
+            cmp %[w16], %[x]                                            \n\
+            jb 1b                                                       \n\
+            2:                                                          \n\
+            cmp %[w8], %[x]                                             \n\
+            jae 3f                                                      \n\
+            movq (%[p1],%[x]), %%xmm1                                   \n\
+            movq (%[p2],%[x]), %%xmm2                                   \n\
+            psadbw %%xmm2, %%xmm1                                       \n\
+            paddq %%xmm1, %%xmm0                                        \n\
+            3:                                                          \n\
+            add %[s1], %[p1]                                            \n\
+            add %[s2], %[p2]                                            \n\
+            subl $1, %[rows]                                            \n\
+            jnz 0b                                                      \n\
+            movdqa %%xmm0, %%xmm1                                       \n\
+            psrldq $8, %%xmm1                                           \n\
+            paddq %%xmm1, %%xmm0                                        \n\
+            movd %%xmm0, %[sum]"
+            : [p1] "+r" (p1), [p2] "+r" (p2), [x] "=&r" (x),
+              [rows] "+rm" (rows), [sum] "=r" (sum)
+            : [w16] "rm" (w16), [w8] "rm" (w8), [s1] "rm" (s1),
+              [s2] "rm" (s2)
+            : "memory", XMM_CLOBBERS);
+    }
+    if (UNLIKELY(w8 < width)) {
+        int y;
+        for (y = 0; y < height; y++, src1 += stride1, src2 += stride2) {
+            for (x = w8; x < width; x++)
+                sum += abs(src1[x] - src2[x]);
+        }
+    }
+    return sum;
+}
+
+static uint32_t sad_avg_sse2(const uint8_t *src1, int stride1,
+                             const uint8_t *src2a, const uint8_t *src2b,
+                             int stride2, int width, int height)
+{
+    long w16 = width & ~15, w8 = width & ~7, x;
+    long s1 = stride1, s2 = stride2;
+    int rows = height;
+    uint32_t sum = 0;
+
+    if (UNLIKELY(height <= 0))
+        return 0;
+    if (w8 > 0) {
+        const uint8_t *p1 = src1, *pa = src2a, *pb = src2b;
+        asm("pxor %%xmm0, %%xmm0                                        \n\
+            0:                                                          \n\
+            xor %[x], %[x]                                              \n\
+            cmp %[w16], %[x]                                            \n\
+            jae 2f                                                      \n\
+            1:                                                          \n\
+            movdqu (%[pa],%[x]), %%xmm2                                 \n\
+            movdqu (%[pb],%[x]), %%xmm3                                 \n\
+            movdqu (%[p1],%[x]), %%xmm1                                 \n\
+            pavgb %%xmm3, %%xmm2                                        \n\
+            psadbw %%xmm2, %%xmm1                                       \n\
+            paddq %%xmm1, %%xmm0                                        \n\
+            add $16, %[x]                                               \n\
+            cmp %[w16], %[x]                                            \n\
+            jb 1b                                                       \n\
+            2:                                                          \n\
+            cmp %[w8], %[x]                                             \n\
+            jae 3f                                                      \n\
+            movq (%[pa],%[x]), %%xmm2                                   \n\
+            movq (%[pb],%[x]), %%xmm3                                   \n\
+            movq (%[p1],%[x]), %%xmm1                                   \n\
+            pavgb %%xmm3, %%xmm2                                        \n\
+            psadbw %%xmm2, %%xmm1                                       \n\
+            paddq %%xmm1, %%xmm0                                        \n\
+            3:                                                          \n\
+            add %[s1], %[p1]                                            \n\
+            add %[s2], %[pa]                                            \n\
+            add %[s2], %[pb]                                            \n\
+            subl $1, %[rows]                                            \n\
+            jnz 0b                                                      \n\
+            movdqa %%xmm0, %%xmm1                                       \n\
+            psrldq $8, %%xmm1                                           \n\
+            paddq %%xmm1, %%xmm0                                        \n\
+            movd %%xmm0, %[sum]"
+            : [p1] "+r" (p1), [pa] "+r" (pa), [pb] "+r" (pb),
+              [x] "=&r" (x), [rows] "+rm" (rows), [sum] "=rm" (sum)
+            : [w16] "rm" (w16), [w8] "rm" (w8), [s1] "rm" (s1),
+              [s2] "rm" (s2)
+            : "memory", XMM_CLOBBERS);
+    }
+    if (UNLIKELY(w8 < width)) {
+        int y;
+        for (y = 0; y < height; y++) {
+            for (x = w8; x < width; x++)
+                sum += abs(src1[x] - ((src2a[x] + src2b[x] + 1) >> 1));
+            src1 += stride1;
+            src2a += stride2;
+            src2b += stride2;
+        }
+    }
+    return sum;
+}
+
+/* Squared differences of 16-bit values are summed two at a time with
+ * PMADDWD into 32-bit lanes (XMM3), which are widened into the 64-bit
+ * total (XMM0) at the end of each row. */
+
+static uint64_t ssd_sse2(const uint8_t *src1, int stride1,
+                         const uint8_t *src2, int stride2,
+                         int width, int height)
+{
+    long w16 = width & ~15, w8 = width & ~7, x;
+    long s1 = stride1, s2 = stride2;
+    int rows = height;
+    uint64_t sum = 0;
+
+    if (UNLIKELY(height <= 0))
+        return 0;
+    if (w8 > 0) {
+        const uint8_t *p1 = src1, *p2 = src2;
+        asm("pxor %%xmm0, %%xmm0                                        \n\
+            pxor %%xmm7, %%xmm7                                         \n\
+            0:                                                          \n\
+            pxor %%xmm3, %%xmm3                                         \n\
+            xor %[x], %[x]                                              \n\
+            cmp %[w16], %[x]                                            \n\
+            jae 2f                                                      \n\
+            1:                                                          \n\
+            movdqu (%[p1],%[x]), %%xmm1                                 \n\
+            movdqu (%[p2],%[x]), %%xmm2                                 \n\
+            movdqa %%xmm1, %%xmm4                                       \n\
+            movdqa %%xmm2, %%xmm5                                       \n\
+            punpcklbw %%xmm7, %%xmm1                                    \n\
+            punpcklbw %%xmm7, %%xmm2                                    \n\
+            punpckhbw %%xmm7, %%xmm4                                    \n\
+            punpckhbw %%xmm7, %%xmm5                                    \n\
+            psubw %%xmm2, %%xmm1                                        \n\
+            psubw %%xmm5, %%xmm4                                        \n\
+            pmaddwd %%xmm1, %%xmm1                                      \n\
+            pmaddwd %%xmm4, %%xmm4                                      \n\
+            paddd %%xmm1, %%xmm3                                        \n\
+            paddd %%xmm4, %%xmm3                                        \n\
+            add $16, %[x]                                               \n\
+            cmp %[w16], %[x]                                            \n\
+            jb 1b                                                       \n\
+            2:                                                          \n\
+            cmp %[w8], %[x]                                             \n\
+            jae 3f                                                      \n\
+            movq (%[p1],%[x]), %%xmm1                                   \n\
+            movq (%[p2],%[x]), %%xmm2                                   \n\
+            punpcklbw %%xmm7, %%xmm1                                    \n\
+            punpcklbw %%xmm7, %%xmm2                                    \n\
+            psubw %%xmm2, %%xmm1                                        \n\
+            pmaddwd %%xmm1, %%xmm1                                      \n\
+            paddd %%xmm1, %%xmm3                                        \n\
+            3:                                                          \n\
+            movdqa %%xmm3, %%xmm4                                       \n\
+            punpckldq %%xmm7, %%xmm3                                    \n\
+            punpckhdq %%xmm7, %%xmm4                                    \n\
+            paddq %%xmm3, %%xmm0                                        \n\
+            paddq %%xmm4, %%xmm0                                        \n\
+            add %[s1], %[p1]                                            \n\
+            add %[s2], %[p2]                                            \n\
+            subl $1, %[rows]                                            \n\
+            jnz 0b                                                      \n\
+            movdqa %%xmm0, %%xmm1                                       \n\
+            psrldq $8, %%xmm1                                           \n\
+            paddq %%xmm1, %%xmm0                                        \n\
+            movq %%xmm0, %[sum]"
+            : [p1] "+r" (p1), [p2] "+r" (p2), [x] "=&r" (x),
+              [rows] "+rm" (rows), [sum] "=m" (sum)
+            : [w16] "rm" (w16), [w8] "rm" (w8), [s1] "rm" (s1),
+              [s2] "rm" (s2)
+            : "memory", XMM_CLOBBERS);
+    }
+    if (UNLIKELY(w8 < width)) {
+        int y;
+        for (y = 0; y < height; y++, src1 += stride1, src2 += stride2) {
+            for (x = w8; x < width; x++) {
+                int d = src1[x] - src2[x];
+                sum += d*d;
+            }
+        }
+    }
+    return sum;
+}
+
+#endif  /* HAVE_ASM_SSE2 */
+
+/*************************************************************************/
+
+/* AVX2 versions: 32 bytes at a time, with the rest of each row left to
+ * the SSE2 versions. */
+
+#if defined(HAVE_ASM_AVX2)
+
+static uint32_t sad_avx2(const uint8_t *src1, int stride1,
+                         const uint8_t *src2, int stride2,
+                         int width, int height)
+{
+    long w32 = width & ~31, x;
+    long s1 = stride1, s2 = stride2;
+    int rows = height;
+    uint32_t sum = 0;
+
+    if (UNLIKELY(height <= 0))
+        return 0;
+    if (w32 > 0) {
+        const uint8_t *p1 = src1, *p2 = src2;
+        asm("vpxor %%ymm0, %%ymm0, %%ymm0                               \n\
+            0:                                                          \n\
+            xor %[x], %[x]                                              \n\
+            1:                                                          \n\
+            vmovdqu (%[p1],%[x]), %%ymm1                                \n\
+            vpsadbw (%[p2],%[x]), %%ymm1, %%ymm1                        \n\
+            vpaddq %%ymm1, %%ymm0, %%ymm0                               \n\
+            add $32, %[x]                                               \n\
+            cmp %[w32], %[x]                                            \n\
+            jb 1b                                                       \n\
+            add %[s1], %[p1]                                            \n\
+            add %[s2], %[p2]                                            \n\
+            subl $1, %[rows]                                            \n\
+            jnz 0b                                                      \n\
+            vextracti128 $1, %%ymm0, %%xmm1                             \n\
+            vpaddq %%xmm1, %%xmm0, %%xmm0                               \n\
+            vpsrldq $8, %%xmm0, %%xmm1                                  \n\
+            vpaddq %%xmm1, %%xmm0, %%xmm0                               \n\
+            vmovd %%xmm0, %[sum]                                        \n\
+            vzeroupper"
+            : [p1] "+r" (p1), [p2] "+r" (p2), [x] "=&r" (x),
+              [rows] "+rm" (rows), [sum] "=r" (sum)
+            : [w32] "rm" (w32), [s1] "rm" (s1), [s2] "rm" (s2)
+            : "memory", XMM_CLOBBERS);
+    }
+    if (w32 < width) {
+        sum += sad_sse2(src1 + w32, stride1, src2 + w32, stride2,
+                        width - w32, height);
+    }
+    return sum;
+}
+
+static uint32_t sad_avg_avx2(const uint8_t *src1, int stride1,
+                             const uint8_t *src2a, const uint8_t *src2b,
+                             int stride2, int width, int height)
+{
+    long w32 = width & ~31, x;
+    long s1 = stride1, s2 = stride2;
+    int rows = height;
+    uint32_t sum = 0;
+
+    if (UNLIKELY(height <= 0))
+        return 0;
+    if (w32 > 0) {
+        const uint8_t *p1 = src1, *pa = src2a, *pb = src2b;
+        asm("vpxor %%ymm0, %%ymm0, %%ymm0                               \n\
+            0:                                                          \n\
+            xor %[x], %[x]                                              \n\
+            1:                                                          \n\
+            vmovdqu (%[pa],%[x]), %%ymm2                                \n\
+            vpavgb (%[pb],%[x]), %%ymm2, %%ymm2                         \n\
+            vpsadbw (%[p1],%[x]), %%ymm2, %%ymm1                        \n\
+            vpaddq %%ymm1, %%ymm0, %%ymm0                               \n\
+            add $32, %[x]                                               \n\
+            cmp %[w32], %[x]                                            \n\
+            jb 1b                                                       \n\
+            add %[s1], %[p1]                                            \n\
+            add %[s2], %[pa]                                            \n\
+            add %[s2], %[pb]                                            \n\
+            subl $1, %[rows]                                            \n\
+            jnz 0b                                                      \n\
+            vextracti128 $1, %%ymm0, %%xmm1                             \n\
+            vpaddq %%xmm1, %%xmm0, %%xmm0                               \n\
+            vpsrldq $8, %%xmm0, %%xmm1                                  \n\
+            vpaddq %%xmm1, %%xmm0, %%xmm0                               \n\
+            vmovd %%xmm0, %[sum]                                        \n\
+            vzeroupper"
+            : [p1] "+r" (p1), [pa] "+r" (pa), [pb] "+r" (pb),
+              [x] "=&r" (x), [rows] "+rm" (rows), [sum] "=rm" (sum)
+            : [w32] "rm" (w32), [s1] "rm" (s1), [s2] "rm" (s2)
+            : "memory", XMM_CLOBBERS);
+    }
+    if (w32 < width) {
+        sum += sad_avg_sse2(src1 + w32, stride1, src2a + w32, src2b + w32,
+                            stride2, width - w32, height);
+    }
+    return sum;
+}
+
+#endif  /* HAVE_ASM_AVX2 */
+
+/*************************************************************************/
+/*************************************************************************/
+
+/* Initialization routine. */
+
+int ac_motion_init(int accel)
+{
+    sad_ptr     = sad;
+    sad_avg_ptr = sad_avg;
+    ssd_ptr     = ssd;
+
+#if defined(HAVE_ASM_SSE2)
+    if (HAS_ACCEL(accel, AC_SSE2)) {
+        sad_ptr     = sad_sse2;
+        sad_avg_ptr = sad_avg_sse2;
+        ssd_ptr     = ssd_sse2;
+    }
+#endif
+#if defined(HAVE_ASM_AVX2)
+    if (HAS_ACCEL(accel, AC_AVX2)) {
+        sad_ptr     = sad_avx2;
+        sad_avg_ptr = sad_avg_avx2;
+    }
+#endif
+
+    return 1;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,542 @@
+/*
+ * resample.c -- filtered resampling of rows of byte data
+ *
+ * This file is part of transcode, a video stream processing tool.
+ * transcode is free software, distributable under the terms of the GNU
+ * General Public License (version 2 or later).  See the file COPYING
+ * for details.
+ */
+
+#include "ac.h"
+#include "ac_internal.h"
+
+#include <stddef.h>
+
+static void resample_h(const uint8_t *, uint8_t *, int, int,
+                       const int32_t *, const int16_t *, int);
+static void resample_v(const uint8_t * const *, const int16_t *, int,
+                       uint8_t *, int);
+static void (*resample_h_ptr)(const uint8_t *, uint8_t *, int, int,
+                              const int32_t *, const int16_t *, int)
+    = resample_h;
+static void (*resample_v_ptr)(const uint8_t * const *, const int16_t *, int,
+                              uint8_t *, int)
+    = resample_v;
+
+/* Rounding constant for the fixed-point sums */
+#define ROUND   (1 << (AC_RESAMPLE_BITS-1))
+
+/*************************************************************************/
+
+/* External interface */
+
+void ac_resample_h(const uint8_t *src, uint8_t *dest, int width, int Bpp,
+                   const int32_t *start, const int16_t *weights, int taps)
+{
+    (*resample_h_ptr)(src, dest, width, Bpp, start, weights, taps);
+}
+
+void ac_resample_v(const uint8_t * const *rows, const int16_t *weights,
+                   int taps, uint8_t *dest, int bytes)
+{
+    (*resample_v_ptr)(rows, weights, taps, dest, bytes);
+}
+
+/*************************************************************************/
+/*************************************************************************/
+
+/* Vanilla C versions */
+
+static inline uint8_t clamp_sum(int32_t sum)
+{
+    sum >>= AC_RESAMPLE_BITS;
+    return sum < 0 ? 0 : sum > 255 ? 255 : sum;
+}
+
+static void resample_h(const uint8_t *src, uint8_t *dest, int width, int Bpp,
+                       const int32_t *start, const int16_t *weights, int taps)
+{
+    int i, c, k;
+
+    for (i = 0; i < width; i++, weights += taps) {
+        const uint8_t *s = src + start[i]*Bpp;
+        for (c = 0; c < Bpp; c++, s++) {
+            int32_t sum = ROUND;
+            for (k = 0; k < taps; k++)
+                sum += s[k*Bpp] * weights[k];
+            *dest++ = clamp_sum(sum);
+        }
+    }
+}
+
+static void resample_v(const uint8_t * const *rows, const int16_t *weights,
+                       int taps, uint8_t *dest, int bytes)
+{
+    int i, k;
+
+    for (i = 0; i < bytes; i++) {
+        int32_t sum = ROUND;
+        for (k = 0; k < taps; k++)
+            sum += rows[k][i] * weights[k];
+        dest[i] = clamp_sum(sum);
+    }
+}
+
+/*************************************************************************/
+
+/* Common declarations for the x86 versions */
+
+#if defined(HAVE_ASM_SSE2)
+
+#ifdef ARCH_X86_64
+# define MOVSX "movslq"
+#else
+# define MOVSX "movl"
+#endif
+
+#define XMM_CLOBBERS \
+    "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7"
+
+/* For the vertical pass, rows are taken two at a time, with their weights
+ * interleaved so that PMADDWD on interleaved pixels gives the sum for each
+ * pixel.  An odd last row is paired with itself and a zero weight. */
+struct vpair {
+    int32_t weights[8];         /* w0|w1<<16, 8 times (for AVX2) */
+    const uint8_t *row0, *row1;
+} __attribute__((aligned(16)));
+
+static int make_pairs(struct vpair *pairs, const uint8_t * const *rows,
+                      const int16_t *weights, int taps)
+{
+    int n, k;
+
+    for (n = 0, k = 0; k < taps; n++, k += 2) {
+        uint16_t w0 = weights[k], w1 = k+1 < taps ? weights[k+1] : 0;
+        int32_t w = w0 | (uint32_t)w1 << 16;
+        int i;
+        for (i = 0; i < 8; i++)
+            pairs[n].weights[i] = w;
+        pairs[n].row0 = rows[k];
+        pairs[n].row1 = k+1 < taps ? rows[k+1] : rows[k];
+    }
+    return n;
+}
+
+#endif  /* HAVE_ASM_SSE2 */
+
+/*************************************************************************/
+
+/* SSE2 versions */
+
+#if defined(HAVE_ASM_SSE2)
+
+/* Vertical pass, 16 bytes at a time */
+
+static void resample_v_sse2(const uint8_t * const *rows,
+                            const int16_t *weights, int taps,
+                            uint8_t *dest, int bytes)
+{
+    struct vpair pairs[(taps+1)/2];
+    int npairs = make_pairs(pairs, rows, weights, taps);
+    long x;
+
+    for (x = 0; x+16 <= bytes; x += 16) {
+        const struct vpair *p = pairs;
+        long n = npairs;
+        const uint8_t *row;
+        asm volatile("\
+            pcmpeqd %%xmm0, %%xmm0      # XMM0..3: rounding constant    \n\
+            psrld $31, %%xmm0                                           \n\
+            pslld %[bits], %%xmm0                                       \n\
+            movdqa %%xmm0, %%xmm1                                       \n\
+            movdqa %%xmm0, %%xmm2                                       \n\
+            movdqa %%xmm0, %%xmm3                                       \n\
+            pxor %%xmm7, %%xmm7                                         \n\
+            0:                                                          \n\
+            mov %c[row0](%[p]), %[row]                                  \n\
+            movdqu (%[row],%[x]), %%xmm5    # XMM5: A0..A15             \n\
+            mov %c[row1](%[p]), %[row]                                  \n\
+            movdqu (%[row],%[x]), %%xmm6    # XMM6: B0..B15             \n\
+            movdqa %%xmm5, %%xmm4                                       \n\
+            punpcklbw %%xmm6, %%xmm4        # XMM4: A0 B0..A7 B7        \n\
+            punpckhbw %%xmm6, %%xmm5        # XMM5: A8 B8..A15 B15      \n\
+            movdqa %%xmm4, %%xmm6                                       \n\
+            punpcklbw %%xmm7, %%xmm4        # (as words)                \n\
+            punpckhbw %%xmm7, %%xmm6                                    \n\
+            pmaddwd (%[p]), %%xmm4          # XMM4: sums for 0..3       \n\
+            pmaddwd (%[p]), %%xmm6          # XMM6: sums for 4..7       \n\
+            paddd %%xmm4, %%xmm0                                        \n\
+            paddd %%xmm6, %%xmm1                                        \n\
+            movdqa %%xmm5, %%xmm4                                       \n\
+            punpcklbw %%xmm7, %%xmm4                                    \n\
+            punpckhbw %%xmm7, %%xmm5                                    \n\
+            pmaddwd (%[p]), %%xmm4          # XMM4: sums for 8..11      \n\
+            pmaddwd (%[p]), %%xmm5          # XMM5: sums for 12..15     \n\
+            paddd %%xmm4, %%xmm2                                        \n\
+            paddd %%xmm5, %%xmm3                                        \n\
+            add %[size], %[p]                                           \n\
+            sub $1, %[n]                                                \n\
+            jnz 0b                                                      \n\
+            psrad %[shift], %%xmm0                                      \n\
+            psrad %[shift], %%xmm1                                      \n\
+            psrad %[shift], %%xmm2                                      \n\
+            psrad %[shift], %%xmm3                                      \n\
+            packssdw %%xmm1, %%xmm0                                     \n\
+            packssdw %%xmm3, %%xmm2                                     \n\
+            packuswb %%xmm2, %%xmm0                                     \n\
+            movdqu %%xmm0, (%[dest])"
+            : [p] "+r" (p), [n] "+r" (n), [row] "=&r" (row)
+            : [x] "r" (x), [dest] "r" (dest + x),
+              [row0] "i" (offsetof(struct vpair, row0)),
+              [row1] "i" (offsetof(struct vpair, row1)),
+              [size] "i" (sizeof(struct vpair)),
+              [bits] "i" (AC_RESAMPLE_BITS-1),
+              [shift] "i" (AC_RESAMPLE_BITS)
+            : "memory", XMM_CLOBBERS);
+    }
+    if (UNLIKELY(x < bytes)) {
+        const uint8_t *tailrows[taps];
+        int k;
+        for (k = 0; k < taps; k++)
+            tailrows[k] = rows[k] + x;
+        resample_v(tailrows, weights, taps, dest + x, bytes - x);
+    }
+}
+
+/* Horizontal pass, 4 pixels at a time, for one byte per pixel and a
+ * multiple of 8 taps (with straight-line code for 8 and 16 taps).  The
+ * sums of products for each pixel are transposed so that the final
+ * additions give the 4 results in one register. */
+
+#define SSE2_H_LOAD8(i) "\
+            "MOVSX" "#i"*4(%[start]), %[s]                              \n\
+            movq (%[src],%[s]), %%xmm"#i"                               \n\
+            punpcklbw %%xmm7, %%xmm"#i"                                 \n\
+            movdqu "#i"*16(%[w]), %%xmm4                                \n\
+            pmaddwd %%xmm4, %%xmm"#i"                                   \n"
+
+#define SSE2_H_LOAD16(i) "\
+            "MOVSX" "#i"*4(%[start]), %[s]                              \n\
+            movdqu (%[src],%[s]), %%xmm4                                \n\
+            movdqa %%xmm4, %%xmm"#i"                                    \n\
+            punpcklbw %%xmm7, %%xmm"#i"                                 \n\
+            punpckhbw %%xmm7, %%xmm4                                    \n\
+            movdqu "#i"*32(%[w]), %%xmm5                                \n\
+            pmaddwd %%xmm5, %%xmm"#i"                                   \n\
+            movdqu "#i"*32+16(%[w]), %%xmm5                             \n\
+            pmaddwd %%xmm5, %%xmm4                                      \n\
+            paddd %%xmm4, %%xmm"#i"                                     \n"
+
+/* One group of 8 taps at offset %[k] for pixel i; %[w] is advanced to
+ * the weights for the next pixel */
+#define SSE2_H_LOADN(i) "\
+            "MOVSX" "#i"*4(%[start]), %[s]                              \n\
+            add %[k], %[s]                                              \n\
+            movq (%[src],%[s]), %%xmm4                                  \n\
+            punpcklbw %%xmm7, %%xmm4                                    \n\
+            movdqu (%[w],%[k],2), %%xmm5                                \n\
+            pmaddwd %%xmm5, %%xmm4                                      \n\
+            paddd %%xmm4, %%xmm"#i"                                     \n\
+            add %[wstep], %[w]                                          \n"
+
+#define SSE2_H_STORE "\
+            movdqa %%xmm0, %%xmm4       # Transpose and add             \n\
+            punpckldq %%xmm1, %%xmm0                                    \n\
+            punpckhdq %%xmm1, %%xmm4                                    \n\
+            paddd %%xmm4, %%xmm0                                        \n\
+            movdqa %%xmm2, %%xmm5                                       \n\
+            punpckldq %%xmm3, %%xmm2                                    \n\
+            punpckhdq %%xmm3, %%xmm5                                    \n\
+            paddd %%xmm5, %%xmm2                                        \n\
+            movdqa %%xmm0, %%xmm4                                       \n\
+            punpcklqdq %%xmm2, %%xmm0                                   \n\
+            punpckhqdq %%xmm2, %%xmm4                                   \n\
+            paddd %%xmm4, %%xmm0        # XMM0: sums for pixels 0..3    \n\
+            pcmpeqd %%xmm5, %%xmm5                                      \n\
+            psrld $31, %%xmm5                                           \n\
+            pslld %[bits], %%xmm5                                       \n\
+            paddd %%xmm5, %%xmm0                                        \n\
+            psrad %[shift], %%xmm0                                      \n\
+            packssdw %%xmm0, %%xmm0                                     \n\
+            packuswb %%xmm0, %%xmm0                                     \n\
+            movd %%xmm0, (%[dest])"
+
+static void resample_h_sse2(const uint8_t *src, uint8_t *dest, int width,
+                            int Bpp, const int32_t *start,
+                            const int16_t *weights, int taps)
+{
+    int i;
+
+    if (Bpp != 1 || taps % 8 != 0) {
+        resample_h(src, dest, width, Bpp, start, weights, taps);
+        return;
+    }
+    for (i = 0; i+4 <= width; i += 4) {
+        long s;
+        if (taps == 8) {
+            asm volatile("pxor %%xmm7, %%xmm7\n"
+                SSE2_H_LOAD8(0) SSE2_H_LOAD8(1)
+                SSE2_H_LOAD8(2) SSE2_H_LOAD8(3)
+                SSE2_H_STORE
+                : [s] "=&r" (s)
+                : [src] "r" (src), [start] "r" (start + i),
+                  [w] "r" (weights + i*taps), [dest] "r" (dest + i),
+                  [bits] "i" (AC_RESAMPLE_BITS-1),
+                  [shift] "i" (AC_RESAMPLE_BITS)
+                : "memory", XMM_CLOBBERS);
+        } else if (taps == 16) {
+            asm volatile("pxor %%xmm7, %%xmm7\n"
+                SSE2_H_LOAD16(0) SSE2_H_LOAD16(1)
+                SSE2_H_LOAD16(2) SSE2_H_LOAD16(3)
+                SSE2_H_STORE
+                : [s] "=&r" (s)
+                : [src] "r" (src), [start] "r" (start + i),
+                  [w] "r" (weights + i*taps), [dest] "r" (dest + i),
+                  [bits] "i" (AC_RESAMPLE_BITS-1),
+                  [shift] "i" (AC_RESAMPLE_BITS)
+                : "memory", XMM_CLOBBERS);
+        } else {
+            const int16_t *w = weights + i*taps;
+            long k = 0, ntaps = taps, wstep = taps*2, wstep4 = taps*8;
+            asm volatile("\
+                pxor %%xmm0, %%xmm0                                     \n\
+                pxor %%xmm1, %%xmm1                                     \n\
+                pxor %%xmm2, %%xmm2                                     \n\
+                pxor %%xmm3, %%xmm3                                     \n\
+                pxor %%xmm7, %%xmm7                                     \n\
+                0:                                                      \n"
+                SSE2_H_LOADN(0) SSE2_H_LOADN(1)
+                SSE2_H_LOADN(2) SSE2_H_LOADN(3) "\
+                sub %[wstep4], %[w]                                     \n\
+                add $8, %[k]                                            \n\
+                cmp %[taps], %[k]                                       \n\
+                jb 0b                                                   \n"
+                SSE2_H_STORE
+                : [s] "=&r" (s), [w] "+r" (w), [k] "+r" (k)
+                : [src] "r" (src), [start] "r" (start + i),
+                  [dest] "r" (dest + i),
+                  [taps] "m" (ntaps), [wstep] "m" (wstep),
+                  [wstep4] "m" (wstep4),
+                  [bits] "i" (AC_RESAMPLE_BITS-1),
+                  [shift] "i" (AC_RESAMPLE_BITS)
+                : "memory", XMM_CLOBBERS);
+        }
+    }
+    if (UNLIKELY(i < width)) {
+        resample_h(src, dest + i, width - i, 1, start + i,
+                   weights + i*taps, taps);
+    }
+}
+
+#endif  /* HAVE_ASM_SSE2 */
+
+/*************************************************************************/
+
+/* AVX2 versions: as SSE2, but twice as wide.  The unpack and pack
+ * instructions work on each 128-bit half separately; for the vertical
+ * pass, packing puts the bytes back in order, and for the horizontal pass,
+ * each half holds the sums for a different set of pixels (or taps). */
+
+#if defined(HAVE_ASM_AVX2)
+
+static void resample_v_avx2(const uint8_t * const *rows,
+                            const int16_t *weights, int taps,
+                            uint8_t *dest, int bytes)
+{
+    struct vpair pairs[(taps+1)/2];
+    int npairs = make_pairs(pairs, rows, weights, taps);
+    long x;
+
+    for (x = 0; x+32 <= bytes; x += 32) {
+        const struct vpair *p = pairs;
+        long n = npairs;
+        const uint8_t *row;
+        asm volatile("\
+            vpcmpeqd %%ymm0, %%ymm0, %%ymm0                             \n\
+            vpsrld $31, %%ymm0, %%ymm0                                  \n\
+            vpslld %[bits], %%ymm0, %%ymm0                              \n\
+            vmovdqa %%ymm0, %%ymm1                                      \n\
+            vmovdqa %%ymm0, %%ymm2                                      \n\
+            vmovdqa %%ymm0, %%ymm3                                      \n\
+            vpxor %%ymm7, %%ymm7, %%ymm7                                \n\
+            0:                                                          \n\
+            mov %c[row0](%[p]), %[row]                                  \n\
+            vmovdqu (%[row],%[x]), %%ymm5   # YMM5: A0..A31             \n\
+            mov %c[row1](%[p]), %[row]                                  \n\
+            vmovdqu (%[row],%[x]), %%ymm6   # YMM6: B0..B31             \n\
+            vpunpcklbw %%ymm6, %%ymm5, %%ymm4   # A0 B0..A7 B7 | A16..  \n\
+            vpunpckhbw %%ymm6, %%ymm5, %%ymm5   # A8 B8..A15 B15 | A24..\n\
+            vpunpcklbw %%ymm7, %%ymm4, %%ymm6                           \n\
+            vpunpckhbw %%ymm7, %%ymm4, %%ymm4                           \n\
+            vpmaddwd (%[p]), %%ymm6, %%ymm6     # 0..3 | 16..19         \n\
+            vpmaddwd (%[p]), %%ymm4, %%ymm4     # 4..7 | 20..23         \n\
+            vpaddd %%ymm6, %%ymm0, %%ymm0                               \n\
+            vpaddd %%ymm4, %%ymm1, %%ymm1                               \n\
+            vpunpcklbw %%ymm7, %%ymm5, %%ymm6                           \n\
+            vpunpckhbw %%ymm7, %%ymm5, %%ymm5                           \n\
+            vpmaddwd (%[p]), %%ymm6, %%ymm6     # 8..11 | 24..27        \n\
+            vpmaddwd (%[p]), %%ymm5, %%ymm5     # 12..15 | 28..31       \n\
+            vpaddd %%ymm6, %%ymm2, %%ymm2                               \n\
+            vpaddd %%ymm5, %%ymm3, %%ymm3                               \n\
+            add %[size], %[p]                                           \n\
+            sub $1, %[n]                                                \n\
+            jnz 0b                                                      \n\
+            vpsrad %[shift], %%ymm0, %%ymm0                             \n\
+            vpsrad %[shift], %%ymm1, %%ymm1                             \n\
+            vpsrad %[shift], %%ymm2, %%ymm2                             \n\
+            vpsrad %[shift], %%ymm3, %%ymm3                             \n\
+            vpackssdw %%ymm1, %%ymm0, %%ymm0    # 0..7 | 16..23         \n\
+            vpackssdw %%ymm3, %%ymm2, %%ymm2    # 8..15 | 24..31        \n\
+            vpackuswb %%ymm2, %%ymm0, %%ymm0                            \n\
+            vmovdqu %%ymm0, (%[dest])                                   \n\
+            vzeroupper"
+            : [p] "+r" (p), [n] "+r" (n), [row] "=&r" (row)
+            : [x] "r" (x), [dest] "r" (dest + x),
+              [row0] "i" (offsetof(struct vpair, row0)),
+              [row1] "i" (offsetof(struct vpair, row1)),
+              [size] "i" (sizeof(struct vpair)),
+              [bits] "i" (AC_RESAMPLE_BITS-1),
+              [shift] "i" (AC_RESAMPLE_BITS)
+            : "memory", XMM_CLOBBERS);
+    }
+    if (UNLIKELY(x < bytes)) {
+        const uint8_t *tailrows[taps];
+        int k;
+        for (k = 0; k < taps; k++)
+            tailrows[k] = rows[k] + x;
+        resample_v_sse2(tailrows, weights, taps, dest + x, bytes - x);
+    }
+}
+
+/* Horizontal pass: with 8 taps, pixel i goes in the low half of register
+ * i and pixel i+4 in the high half, giving 8 pixels at a time; with 16
+ * taps, each half gets 8 of the taps of a pixel, and the halves are added
+ * together at the end. */
+
+#define AVX2_H_LOAD8(i) "\
+            "MOVSX" "#i"*4(%[start]), %[s]                              \n\
+            vmovq (%[src],%[s]), %%xmm"#i"                              \n\
+            "MOVSX" "#i"*4+16(%[start]), %[s]                           \n\
+            vmovhps (%[src],%[s]), %%xmm"#i", %%xmm"#i"                 \n\
+            vpmovzxbw %%xmm"#i", %%ymm"#i"                              \n\
+            vmovdqu "#i"*16(%[w]), %%xmm4                               \n\
+            vinserti128 $1, "#i"*16+64(%[w]), %%ymm4, %%ymm4            \n\
+            vpmaddwd %%ymm4, %%ymm"#i", %%ymm"#i"                       \n"
+
+#define AVX2_H_LOAD16(i) "\
+            "MOVSX" "#i"*4(%[start]), %[s]                              \n\
+            vpmovzxbw (%[src],%[s]), %%ymm"#i"                          \n\
+            vpmaddwd "#i"*32(%[w]), %%ymm"#i", %%ymm"#i"                \n"
+
+#define AVX2_H_SUM "\
+            vpunpckldq %%ymm1, %%ymm0, %%ymm4   # Transpose and add     \n\
+            vpunpckhdq %%ymm1, %%ymm0, %%ymm0                           \n\
+            vpaddd %%ymm4, %%ymm0, %%ymm0                               \n\
+            vpunpckldq %%ymm3, %%ymm2, %%ymm5                           \n\
+            vpunpckhdq %%ymm3, %%ymm2, %%ymm2                           \n\
+            vpaddd %%ymm5, %%ymm2, %%ymm2                               \n\
+            vpunpcklqdq %%ymm2, %%ymm0, %%ymm4                          \n\
+            vpunpckhqdq %%ymm2, %%ymm0, %%ymm0                          \n\
+            vpaddd %%ymm4, %%ymm0, %%ymm0                               \n\
+            vextracti128 $1, %%ymm0, %%xmm1                             \n\
+            vpcmpeqd %%xmm5, %%xmm5, %%xmm5                             \n\
+            vpsrld $31, %%xmm5, %%xmm5                                  \n\
+            vpslld %[bits], %%xmm5, %%xmm5                              \n"
+
+static void resample_h_avx2(const uint8_t *src, uint8_t *dest, int width,
+                            int Bpp, const int32_t *start,
+                            const int16_t *weights, int taps)
+{
+    int i = 0;
+
+    if (Bpp != 1 || (taps != 8 && taps != 16)) {
+        resample_h_sse2(src, dest, width, Bpp, start, weights, taps);
+        return;
+    }
+    if (taps == 8) {
+        for (; i+8 <= width; i += 8) {
+            long s;
+            asm volatile(AVX2_H_LOAD8(0) AVX2_H_LOAD8(1)
+                AVX2_H_LOAD8(2) AVX2_H_LOAD8(3)
+                AVX2_H_SUM "\
+                vpaddd %%xmm5, %%xmm0, %%xmm0                           \n\
+                vpaddd %%xmm5, %%xmm1, %%xmm1                           \n\
+                vpsrad %[shift], %%xmm0, %%xmm0                         \n\
+                vpsrad %[shift], %%xmm1, %%xmm1                         \n\
+                vpackssdw %%xmm1, %%xmm0, %%xmm0                        \n\
+                vpackuswb %%xmm0, %%xmm0, %%xmm0                        \n\
+                vmovq %%xmm0, (%[dest])                                 \n\
+                vzeroupper"
+                : [s] "=&r" (s)
+                : [src] "r" (src), [start] "r" (start + i),
+                  [w] "r" (weights + i*taps), [dest] "r" (dest + i),
+                  [bits] "i" (AC_RESAMPLE_BITS-1),
+                  [shift] "i" (AC_RESAMPLE_BITS)
+                : "memory", XMM_CLOBBERS);
+        }
+    } else {
+        for (; i+4 <= width; i += 4) {
+            long s;
+            asm volatile(AVX2_H_LOAD16(0) AVX2_H_LOAD16(1)
+                AVX2_H_LOAD16(2) AVX2_H_LOAD16(3)
+                AVX2_H_SUM "\
+                vpaddd %%xmm1, %%xmm0, %%xmm0                           \n\
+                vpaddd %%xmm5, %%xmm0, %%xmm0                           \n\
+                vpsrad %[shift], %%xmm0, %%xmm0                         \n\
+                vpackssdw %%xmm0, %%xmm0, %%xmm0                        \n\
+                vpackuswb %%xmm0, %%xmm0, %%xmm0                        \n\
+                vmovd %%xmm0, (%[dest])                                 \n\
+                vzeroupper"
+                : [s] "=&r" (s)
+                : [src] "r" (src), [start] "r" (start + i),
+                  [w] "r" (weights + i*taps), [dest] "r" (dest + i),
+                  [bits] "i" (AC_RESAMPLE_BITS-1),
+                  [shift] "i" (AC_RESAMPLE_BITS)
+                : "memory", XMM_CLOBBERS);
+        }
+    }
+    if (UNLIKELY(i < width)) {
+        resample_h_sse2(src, dest + i, width - i, 1, start + i,
+                        weights + i*taps, taps);
+    }
+}
+
+#endif  /* HAVE_ASM_AVX2 */
+
+/*************************************************************************/
+/*************************************************************************/
+
+/* Initialization routine. */
+
+int ac_resample_init(int accel)
+{
+    resample_h_ptr = resample_h;
+    resample_v_ptr = resample_v;
+
+#if defined(HAVE_ASM_SSE2)
+    if (HAS_ACCEL(accel, AC_SSE2)) {
+        resample_h_ptr = resample_h_sse2;
+        resample_v_ptr = resample_v_sse2;
+    }
+#endif
+#if defined(HAVE_ASM_AVX2)
+    if (HAS_ACCEL(accel, AC_AVX2)) {
+        resample_h_ptr = resample_h_avx2;
+        resample_v_ptr = resample_v_avx2;
+    }
+#endif
+
+    return 1;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
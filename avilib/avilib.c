@@ -46,6 +46,7 @@ enum {
     MAX_INFO_STRLEN  = 64,               /* XXX: ???                   */
     FRAME_RATE_SCALE = 1000000,          /* XXX: ???                   */
     HEADERBYTES      = 2048,             /* bytes for the header       */
+    DIRECT_ALIGN     = 4096,             /* O_DIRECT block size        */
 };
 
 /* AVI_MAX_LEN: The maximum length of an AVI file, we stay a bit below
@@ -137,6 +138,174 @@ static int avi_sampsize(avi_t *AVI, int j)
    return s;
 }
 
+/*************************************************************************/
+/* buffered output                                                       */
+
+/* Chunks are collected in AVI->wbuf and reach the file once wbuf_size
+   bytes are pending: the buffer and the chunk overflowing it go out with
+   a single writev().
+
+   In direct mode the buffer covers whole DIRECT_ALIGN blocks from an
+   aligned file position and is written with O_DIRECT each time it
+   fills up.  When the file must be complete (header updates, closing)
+   the last, partial block is written through the page cache but stays
+   in the buffer, so that the next direct write starts aligned again.
+
+   Either way, between calls fdes is positioned at wbuf_pos, while
+   AVI->pos is where the next chunk goes. */
+
+/* a failed write loses whatever was pending */
+static int avi_wbuf_fail(avi_t *AVI)
+{
+    plat_seek(AVI->fdes, AVI->wbuf_pos, SEEK_SET);
+    AVI->pos      = AVI->wbuf_pos;
+    AVI->wbuf_len = 0;
+    AVI_errno     = AVI_ERR_WRITE;
+    return -1;
+}
+
+static int avi_wbuf_write(avi_t *AVI, const struct iovec *iov, int n)
+{
+    struct iovec v[n + 1];
+    long len = 0, c = 0, left = 0;
+    const uint8_t *p = NULL;
+    int i, k = 0;
+
+    if (AVI->wbuf_direct) {
+        for (i = 0; i < n; i++) {
+            p    = iov[i].iov_base;
+            left = iov[i].iov_len;
+            while (left > 0) {
+                c = AVI->wbuf_size - AVI->wbuf_len;
+                if (c > left)
+                    c = left;
+                memcpy(AVI->wbuf + AVI->wbuf_len, p, c);
+                AVI->wbuf_len += c;
+                p    += c;
+                left -= c;
+
+                if (AVI->wbuf_len == AVI->wbuf_size) {
+                    AVI->wbuf_calls++;
+                    if (plat_write(AVI->fdes, AVI->wbuf, AVI->wbuf_size)
+                          != AVI->wbuf_size)
+                        return avi_wbuf_fail(AVI);
+                    AVI->wbuf_pos += AVI->wbuf_size;
+                    AVI->wbuf_len  = 0;
+                }
+            }
+        }
+        return 0;
+    }
+
+    for (i = 0; i < n; i++)
+        len += iov[i].iov_len;
+
+    if (AVI->wbuf_len + len <= AVI->wbuf_size) {
+        for (i = 0; i < n; i++) {
+            memcpy(AVI->wbuf + AVI->wbuf_len,
+                   iov[i].iov_base, iov[i].iov_len);
+            AVI->wbuf_len += iov[i].iov_len;
+        }
+        return 0;
+    }
+
+    /* pending data and the new chunk in one go */
+    if (AVI->wbuf_len > 0) {
+        v[k].iov_base = AVI->wbuf;
+        v[k].iov_len  = AVI->wbuf_len;
+        k++;
+    }
+    for (i = 0; i < n; i++) {
+        if (iov[i].iov_len > 0)
+            v[k++] = iov[i];
+    }
+    AVI->wbuf_calls++;
+    if (plat_writev(AVI->fdes, v, k) != AVI->wbuf_len + len)
+        return avi_wbuf_fail(AVI);
+
+    AVI->wbuf_pos += AVI->wbuf_len + len;
+    AVI->wbuf_len  = 0;
+    return 0;
+}
+
+/* bring the file up to date */
+static int avi_wbuf_sync(avi_t *AVI)
+{
+    ssize_t n = 0;
+
+    if (AVI->wbuf_len == 0)
+        return 0;
+
+    AVI->wbuf_calls++;
+    if (AVI->wbuf_direct) {
+        plat_set_direct(AVI->fdes, 0);
+        n = plat_write(AVI->fdes, AVI->wbuf, AVI->wbuf_len);
+        plat_set_direct(AVI->fdes, 1);
+        plat_seek(AVI->fdes, AVI->wbuf_pos, SEEK_SET);
+        return (n == AVI->wbuf_len) ?0 :avi_wbuf_fail(AVI);
+    }
+
+    if (plat_write(AVI->fdes, AVI->wbuf, AVI->wbuf_len) != AVI->wbuf_len)
+        return avi_wbuf_fail(AVI);
+    AVI->wbuf_pos += AVI->wbuf_len;
+    AVI->wbuf_len  = 0;
+    return 0;
+}
+
+/* write `len' bytes at `pos' without moving the output */
+static int avi_write_at(avi_t *AVI, off_t pos,
+                        const uint8_t *data, long len)
+{
+    off_t lo = pos, hi = pos + len;
+    int ret = 0;
+
+    if (avi_wbuf_sync(AVI) < 0)
+        return -1;
+
+    if (AVI->wbuf_direct) {
+        /* the buffer must not undo this later */
+        if (lo < AVI->wbuf_pos)
+            lo = AVI->wbuf_pos;
+        if (hi > AVI->wbuf_pos + AVI->wbuf_len)
+            hi = AVI->wbuf_pos + AVI->wbuf_len;
+        if (lo < hi)
+            memcpy(AVI->wbuf + (lo - AVI->wbuf_pos), data + (lo - pos),
+                   hi - lo);
+        plat_set_direct(AVI->fdes, 0);
+    }
+
+    AVI->wbuf_calls++;
+    if (plat_seek(AVI->fdes, pos, SEEK_SET) < 0
+     || plat_write(AVI->fdes, data, len) != len)
+        ret = -1;
+
+    if (AVI->wbuf_direct)
+        plat_set_direct(AVI->fdes, 1);
+    if (plat_seek(AVI->fdes, AVI->wbuf_pos, SEEK_SET) < 0)
+        ret = -1;
+    return ret;
+}
+
+/* sync and drop the buffer; fdes is left at AVI->pos */
+static int avi_wbuf_release(avi_t *AVI)
+{
+    int ret = avi_wbuf_sync(AVI);
+
+    if (AVI->wbuf_direct) {
+        plat_set_direct(AVI->fdes, 0);
+        plat_seek(AVI->fdes, AVI->pos, SEEK_SET);
+        AVI->wbuf_direct = 0;
+    }
+    free(AVI->wbuf); /* from posix_memalign() */
+    AVI->wbuf      = NULL;
+    AVI->wbuf_size = 0;
+    AVI->wbuf_len  = 0;
+    AVI->wbuf_pos  = AVI->pos;
+    return ret;
+}
+
+/*************************************************************************/
+
 /* Add a chunk (=tag and data) to the AVI file,
    returns -1 on write error, 0 on success */
 
@@ -145,25 +314,23 @@ static int avi_add_chunk(avi_t *AVI, const char *tag,
 {
    uint8_t c[8] = { '\0' };
    char p = 0;
-
-   /* Copy tag and length int c, so that we need only 1 write system call
-      for these two values */
+   struct iovec iov[3];
 
    memcpy(c, tag, 4);
    long2str(c + 4, length);
 
-   /* Output tag, length and data, restore previous position
-      if the write fails */
+   /* Output tag, length, data and, if len is uneven, a pad byte,
+      all in one go */
 
-   if (plat_write(AVI->fdes, c,    8)          != 8
-    || plat_write(AVI->fdes, data, length)     != length
-    || plat_write(AVI->fdes, &p,   length & 1) != (length & 1))
-    // if len is uneven, write a pad byte
-   {
-      plat_seek(AVI->fdes, AVI->pos, SEEK_SET);
-      AVI_errno = AVI_ERR_WRITE;
+   iov[0].iov_base = c;
+   iov[0].iov_len  = 8;
+   iov[1].iov_base = (void *)data;
+   iov[1].iov_len  = length;
+   iov[2].iov_base = &p;
+   iov[2].iov_len  = length & 1;
+
+   if (avi_wbuf_write(AVI, iov, 3) < 0)
       return -1;
-   }
 
    AVI->pos += 8 + PAD_EVEN(length);
 
@@ -305,8 +472,15 @@ static int avi_add_odml_index_entry_core(avi_t *AVI, long flags, off_t pos,
 
     // need to fetch more memory
     if (cur_chunk_idx >= si->dwSize) {
-        si->dwSize += 4096;
-        si->aIndex = plat_realloc( si->aIndex, si->dwSize * sizeof(uint32_t) * si->wLongsPerEntry);
+        void *ptr = plat_realloc(si->aIndex, 2 * si->dwSize
+                                 * sizeof(uint32_t) * si->wLongsPerEntry);
+        if (!ptr) {
+            si->nEntriesInUse--;
+            AVI_errno = AVI_ERR_NO_MEM;
+            return -1;
+        }
+        si->dwSize *= 2;
+        si->aIndex = ptr;
     }
 
     if (len>AVI->max_len)
@@ -485,16 +659,18 @@ static int avi_add_odml_index_entry(avi_t *AVI, const char *tag,
 
 
     if (video) {
-	avi_add_odml_index_entry_core(AVI, flags, AVI->pos, len,
-		AVI->video_superindex->stdindex[ AVI->video_superindex->nEntriesInUse-1 ]);
+	if (avi_add_odml_index_entry_core(AVI, flags, AVI->pos, len,
+		AVI->video_superindex->stdindex[ AVI->video_superindex->nEntriesInUse-1 ]) < 0)
+	    return -1;
 
 	AVI->total_frames++;
     } // video
 
     if (audio) {
-	avi_add_odml_index_entry_core(AVI, flags, AVI->pos, len,
+	if (avi_add_odml_index_entry_core(AVI, flags, AVI->pos, len,
 		AVI->track[AVI->aptr].audio_superindex->stdindex[
-		        AVI->track[AVI->aptr].audio_superindex->nEntriesInUse-1 ]);
+		        AVI->track[AVI->aptr].audio_superindex->nEntriesInUse-1 ]) < 0)
+	    return -1;
     }
 
 
@@ -507,15 +683,18 @@ static int avi_add_index_entry(avi_t *AVI, const char *tag, long flags,
             			       unsigned long pos, unsigned long len)
 {
     void *ptr;
+    long max;
 
     if (AVI->n_idx >= AVI->max_idx) {
-        ptr = plat_realloc((void *)AVI->idx, (AVI->max_idx+4096)*16);
+        /* grow geometrically: long files index many small chunks */
+        max = (AVI->max_idx > 0) ?AVI->max_idx*2 :4096;
+        ptr = plat_realloc((void *)AVI->idx, max*16);
 
         if (!ptr) {
             AVI_errno = AVI_ERR_NO_MEM;
             return -1;
         }
-        AVI->max_idx += 4096;
+        AVI->max_idx = max;
         AVI->idx = (unsigned char((*)[16])) ptr;
     }
 
@@ -533,6 +712,471 @@ static int avi_add_index_entry(avi_t *AVI, const char *tag, long flags,
     return 0;
 }
 
+/*************************************************************************/
+/* mapped input and the lazy index                                       */
+
+/* Input files are mapped as a whole when the platform allows it, and
+   chunks are copied out of the map instead of read(); the *_ref()
+   readers hand out pointers into it.  Anything the map doesn't cover
+   (no mapping, or a file still growing) goes through seek and read.
+
+   Files with neither idx1 nor OpenDML index have to be scanned chunk
+   by chunk.  That is done only as far as a read needs: scan_pos is the
+   next chunk to look at, and video_index and the audio indexes grow as
+   the scan goes.  Asking for totals (frames, chunks, bytes) completes
+   the scan. */
+
+/* copies `len' bytes at `pos' to `buf'; -1 if they aren't all there */
+static int avi_read_at(avi_t *AVI, off_t pos, void *buf, long len)
+{
+    if (AVI->map != NULL && pos >= 0 && pos + len <= AVI->map_size) {
+        memcpy(buf, AVI->map + pos, len);
+        return 0;
+    }
+    if (plat_seek(AVI->fdes, pos, SEEK_SET) == (off_t)-1
+     || plat_read(AVI->fdes, buf, len) != len) {
+        return -1;
+    }
+    return 0;
+}
+
+/* points to `len' bytes at `pos': into the map, or else into *buf, read
+   there and grown as needed */
+static const uint8_t *avi_ref_at(avi_t *AVI, off_t pos, long len,
+                                 uint8_t **buf, long *size)
+{
+    uint8_t *ptr = NULL;
+
+    if (AVI->map != NULL && pos >= 0 && pos + len <= AVI->map_size) {
+        return AVI->map + pos;
+    }
+    if (*buf == NULL || len > *size) {
+        ptr = plat_realloc(*buf, (len > 4096) ?len :4096);
+        if (!ptr) {
+            AVI_errno = AVI_ERR_NO_MEM;
+            return NULL;
+        }
+        *buf  = ptr;
+        *size = (len > 4096) ?len :4096;
+    }
+    if (avi_read_at(AVI, pos, *buf, len) < 0) {
+        AVI_errno = AVI_ERR_READ;
+        return NULL;
+    }
+    return *buf;
+}
+
+static void avi_map_file(avi_t *AVI)
+{
+    off_t size = plat_seek(AVI->fdes, 0, SEEK_END);
+
+    if (size > 0) {
+        AVI->map = plat_mmap(AVI->fdes, size);
+        AVI->map_size = (AVI->map != NULL) ?size :0;
+    }
+    plat_seek(AVI->fdes, 0, SEEK_SET);
+}
+
+/* makes room for entry `n' and a zeroed one after it, as the readers
+   expect past the last chunk */
+static int avi_grow_index(void **index, long *max, long n, size_t size)
+{
+    void *ptr = NULL;
+    long m = 0;
+
+    if (n + 1 < *max) {
+        return 0;
+    }
+    m = (*max > 0) ?*max :4096;
+    while (n + 1 >= m)
+        m *= 2;
+    ptr = plat_realloc(*index, m * size);
+    if (!ptr) {
+        AVI_errno = AVI_ERR_NO_MEM;
+        return -1;
+    }
+    memset((uint8_t *)ptr + *max * size, 0, (m - *max) * size);
+    *index = ptr;
+    *max   = m;
+    return 0;
+}
+
+static int avi_scan_video_entry(avi_t *AVI, off_t pos, uint32_t len)
+{
+    video_index_entry *e = NULL;
+
+    if (avi_grow_index((void **)&AVI->video_index, &AVI->max_vidx,
+                       AVI->video_frames, sizeof(video_index_entry)) < 0) {
+        return -1;
+    }
+    e = &AVI->video_index[AVI->video_frames++];
+    e->key = 0;
+    e->pos = pos;
+    e->len = len;
+
+    if (len > AVI->max_len)
+        AVI->max_len = len;
+    return 0;
+}
+
+static int avi_scan_audio_entry(avi_t *AVI, int j, off_t pos, uint32_t len)
+{
+    track_t *t = &AVI->track[j];
+    audio_index_entry *e = NULL;
+
+    if (avi_grow_index((void **)&t->audio_index, &t->audio_max_idx,
+                       t->audio_chunks, sizeof(audio_index_entry)) < 0) {
+        return -1;
+    }
+    e = &t->audio_index[t->audio_chunks++];
+    e->pos = pos;
+    e->len = len;
+    e->tot = t->audio_bytes;
+    t->audio_bytes += len;
+    return 0;
+}
+
+/* The index found by a complete scan is kept in a sidecar file, the AVI
+   file name plus AVI_INDEX_CACHE_SUFFIX, and read back instead of
+   scanning again as long as the AVI file keeps its size and mtime:
+
+     "TCAI", version                       2 x 4 bytes
+     file size, mtime, movi_start          3 x 8 bytes
+     video frames, audio tracks            2 x 4 bytes
+     audio chunks per track                tracks x 4 bytes
+     video entries: pos, len, key          8 + 4 + 4 bytes each
+     audio entries: pos, len               8 + 4 bytes each
+     Adler-32 of all the above             4 bytes
+
+   all numbers little endian.  Failing to write it is not an error. */
+
+enum {
+    CACHE_VERSION = 1,
+    CACHE_HEAD    = 40,     /* up to the audio chunk counts */
+    CACHE_VENTRY  = 16,
+    CACHE_AENTRY  = 12,
+};
+
+static void ullong2str(uint8_t *dst, uint64_t n)
+{
+    long2str(dst,     n & 0xffffffff);
+    long2str(dst + 4, n >> 32);
+}
+
+static uint32_t avi_adler32(const uint8_t *data, long len)
+{
+    uint32_t a = 1, b = 0;
+    long i = 0;
+
+    while (len > 0) {
+        long n = (len < 5552) ?len :5552; /* no overflow before modulo */
+
+        for (i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += n;
+        len  -= n;
+    }
+    return (b << 16) | a;
+}
+
+static long avi_cache_size(long frames, int anum, const long *chunks)
+{
+    long size = CACHE_HEAD + 4 * anum + CACHE_VENTRY * frames + 4;
+    int j;
+
+    for (j = 0; j < anum; j++)
+        size += CACHE_AENTRY * chunks[j];
+    return size;
+}
+
+static void avi_save_index_cache(avi_t *AVI)
+{
+    struct stat st;
+    char tmpname[PATH_MAX];
+    long chunks[AVI_MAX_TRACKS];
+    uint8_t *buf = NULL, *p = NULL;
+    long size = 0, i;
+    int fd = -1, j, ok = 0;
+
+    if (plat_fstat(AVI->fdes, &st) != 0)
+        return;
+    for (j = 0; j < AVI->anum; j++)
+        chunks[j] = AVI->track[j].audio_chunks;
+    size = avi_cache_size(AVI->video_frames, AVI->anum, chunks);
+    buf = plat_malloc(size);
+    if (!buf)
+        return;
+
+    p = buf;
+    memcpy(p, "TCAI", 4);
+    long2str(p + 4, CACHE_VERSION);
+    ullong2str(p + 8, st.st_size);
+    ullong2str(p + 16, st.st_mtime);
+    ullong2str(p + 24, AVI->movi_start);
+    long2str(p + 32, AVI->video_frames);
+    long2str(p + 36, AVI->anum);
+    p += CACHE_HEAD;
+    for (j = 0; j < AVI->anum; j++, p += 4)
+        long2str(p, chunks[j]);
+    for (i = 0; i < AVI->video_frames; i++, p += CACHE_VENTRY) {
+        ullong2str(p, AVI->video_index[i].pos);
+        long2str(p + 8, AVI->video_index[i].len);
+        long2str(p + 12, AVI->video_index[i].key);
+    }
+    for (j = 0; j < AVI->anum; j++) {
+        for (i = 0; i < chunks[j]; i++, p += CACHE_AENTRY) {
+            ullong2str(p, AVI->track[j].audio_index[i].pos);
+            long2str(p + 8, AVI->track[j].audio_index[i].len);
+        }
+    }
+    long2str(p, avi_adler32(buf, size - 4));
+
+    /* readers see either the old file or the complete new one */
+    snprintf(tmpname, sizeof(tmpname), "%s.XXXXXX", AVI->index_cache);
+    fd = plat_mkstemp(tmpname, 0644);
+    if (fd >= 0) {
+        ok = (plat_write(fd, buf, size) == size);
+        plat_close(fd);
+        if (!ok || plat_rename(tmpname, AVI->index_cache) != 0)
+            unlink(tmpname);
+    }
+    plat_free(buf);
+}
+
+/* 0 if the index was read from the cache */
+static int avi_load_index_cache(avi_t *AVI)
+{
+    struct stat st;
+    long chunks[AVI_MAX_TRACKS];
+    uint8_t head[CACHE_HEAD], *buf = NULL, *p = NULL;
+    long frames = 0, size = 0, i;
+    int fd = -1, anum = 0, j, ok = 0;
+
+    if (plat_fstat(AVI->fdes, &st) != 0)
+        return -1;
+    fd = plat_open(AVI->index_cache, O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+
+    if (plat_read(fd, head, CACHE_HEAD) != CACHE_HEAD
+     || memcmp(head, "TCAI", 4) != 0
+     || str2ulong(head + 4) != CACHE_VERSION
+     || str2ullong(head + 8) != (uint64_t)st.st_size
+     || str2ullong(head + 16) != (uint64_t)st.st_mtime
+     || str2ullong(head + 24) != (uint64_t)AVI->movi_start
+     || str2ulong(head + 36) != AVI->anum) {
+        plat_close(fd);
+        return -1;
+    }
+    frames = str2ulong(head + 32);
+    anum   = AVI->anum;
+
+    /* the whole file, as big as the counts say */
+    size = plat_seek(fd, 0, SEEK_END);
+    buf = (size > CACHE_HEAD + 4 * anum) ?plat_malloc(size) :NULL;
+    if (buf && plat_seek(fd, 0, SEEK_SET) == 0
+     && plat_read(fd, buf, size) == size) {
+        ok = (frames <= st.st_size / 8);
+        for (j = 0; j < anum; j++) {
+            chunks[j] = str2ulong(buf + CACHE_HEAD + 4 * j);
+            ok = ok && (chunks[j] <= st.st_size / 8);
+        }
+        ok = (ok
+              && avi_cache_size(frames, anum, chunks) == size
+              && avi_adler32(buf, size - 4) == str2ulong(buf + size - 4));
+    }
+    plat_close(fd);
+    if (!ok) {
+        plat_free(buf);
+        return -1;
+    }
+
+    /* avi_scan_reset() left them empty */
+    p = buf + CACHE_HEAD + 4 * anum;
+    if (avi_grow_index((void **)&AVI->video_index, &AVI->max_vidx,
+                       frames, sizeof(video_index_entry)) < 0) {
+        plat_free(buf);
+        return -1;
+    }
+    for (i = 0; i < frames; i++, p += CACHE_VENTRY) {
+        avi_scan_video_entry(AVI, str2ullong(p), str2ulong(p + 8));
+        AVI->video_index[i].key = str2ulong(p + 12);
+    }
+    for (j = 0; j < anum; j++) {
+        if (avi_grow_index((void **)&AVI->track[j].audio_index,
+                           &AVI->track[j].audio_max_idx, chunks[j],
+                           sizeof(audio_index_entry)) < 0) {
+            plat_free(buf);
+            return -1;
+        }
+        for (i = 0; i < chunks[j]; i++, p += CACHE_AENTRY)
+            avi_scan_audio_entry(AVI, j, str2ullong(p), str2ulong(p + 8));
+    }
+    plat_free(buf);
+    return 0;
+}
+
+static void avi_scan_done(avi_t *AVI)
+{
+    AVI->scan_pos = 0;
+
+    if (AVI->index_cache)
+        avi_save_index_cache(AVI);
+
+    if (AVI->scan_resync) {
+        if (AVI->video_frames < AVI->total_frames) {
+            plat_log_send(PLAT_LOG_WARNING, __FILE__,
+                          "Uh? Some frames seems missing (%ld/%d)",
+                          AVI->video_frames, AVI->total_frames);
+        }
+        plat_log_send(PLAT_LOG_INFO, __FILE__,
+                      "index reconstructed: nvi=%ld nai=%ld tot=%ld",
+                      AVI->video_frames, AVI->track[0].audio_chunks,
+                      (long)AVI->track[0].audio_bytes);
+    }
+}
+
+/* indexes the chunk at scan_pos and moves past it */
+static int avi_scan_chunk(avi_t *AVI)
+{
+    uint8_t data[8];
+    off_t pos = AVI->scan_pos;
+    uint32_t n = 0;
+    int j = 0, ret = 0;
+
+    if (avi_read_at(AVI, pos, data, 8) < 0) {
+        avi_scan_done(AVI); /* we assume it's EOF */
+        return 0;
+    }
+    n = str2ulong(data + 4);
+
+    if (AVI->scan_resync) {
+        /* only one audio track, and anything unknown means we are out
+           of step: try again 4 bytes further */
+        if ((data[0] == '0' || data[1] == '0')
+         && (data[2] == 'd' || data[2] == 'D')
+         && (data[3] == 'b' || data[3] == 'B'
+          || data[3] == 'c' || data[3] == 'C')) {
+            ret = avi_scan_video_entry(AVI, pos + 8, n);
+        } else if ((data[0] == '0' || data[1] == '1')
+                && (data[2] == 'w' || data[2] == 'W')
+                && (data[3] == 'b' || data[3] == 'B')) {
+            if (AVI->anum > 0)
+                ret = avi_scan_audio_entry(AVI, 0, pos + 8, n);
+        } else {
+            AVI->scan_pos = pos + 4;
+            return 0;
+        }
+        if (ret == 0) {
+            AVI->scan_pos = pos + 8 + PAD_EVEN(n);
+            if (AVI->video_frames >= AVI->total_frames)
+                avi_scan_done(AVI);
+        }
+        return ret;
+    }
+
+    /* the movi list may contain sub-lists, look into them */
+    if (strncasecmp((char *)data, "LIST", 4) == 0) {
+        AVI->scan_pos = pos + 12;
+        return 0;
+    }
+
+    /* check if we got a tag ##db, ##dc or ##wb */
+    if (((data[2] == 'd' || data[2] == 'D')
+      && (data[3] == 'b' || data[3] == 'B'
+       || data[3] == 'c' || data[3] == 'C'))
+     || ((data[2] == 'w' || data[2] == 'W')
+      && (data[3] == 'b' || data[3] == 'B'))) {
+        if (strncasecmp((char *)data, AVI->video_tag, 3) == 0) {
+            ret = avi_scan_video_entry(AVI, pos + 8, n);
+        }
+        for (j = 0; j < AVI->anum && ret == 0; j++) {
+            if (strncasecmp((char *)data, AVI->track[j].audio_tag, 4) == 0)
+                ret = avi_scan_audio_entry(AVI, j, pos + 8, n);
+        }
+    }
+    if (ret == 0)
+        AVI->scan_pos = pos + 8 + PAD_EVEN(n);
+    return ret;
+}
+
+/* scans until video frame `frame' and audio chunk `chunk' and byte
+   `byte' of the current track are indexed, or the file ends */
+static void avi_scan_to(avi_t *AVI, long frame, long chunk, off_t byte)
+{
+    const track_t *t = &AVI->track[AVI->aptr];
+
+    while (AVI->scan_pos > 0
+           && (AVI->video_frames <= frame || t->audio_chunks <= chunk
+               || t->audio_bytes <= byte)) {
+        if (avi_scan_chunk(AVI) < 0)
+            break;
+    }
+}
+
+#define avi_scan_all(AVI)   avi_scan_to((AVI), LONG_MAX, -1, -1)
+
+/* drops the index found so far */
+static int avi_scan_reset(avi_t *AVI)
+{
+    int j;
+
+    if (AVI->video_index)
+        plat_free(AVI->video_index);
+    AVI->video_index  = NULL;
+    AVI->video_frames = 0;
+    AVI->max_vidx     = 0;
+    AVI->max_len      = 0;
+    if (avi_grow_index((void **)&AVI->video_index, &AVI->max_vidx, 0,
+                       sizeof(video_index_entry)) < 0) {
+        return -1;
+    }
+    for (j = 0; j < AVI->anum; j++) {
+        track_t *t = &AVI->track[j];
+
+        if (t->audio_index)
+            plat_free(t->audio_index);
+        t->audio_index   = NULL;
+        t->audio_chunks  = 0;
+        t->audio_bytes   = 0;
+        t->audio_max_idx = 0;
+        if (avi_grow_index((void **)&t->audio_index, &t->audio_max_idx, 0,
+                           sizeof(audio_index_entry)) < 0) {
+            return -1;
+        }
+    }
+    AVI->n_idx = 0;
+    return 0;
+}
+
+/* takes the index from the cache, or starts scanning for one */
+static int avi_scan_start(avi_t *AVI, int resync)
+{
+    if (!resync)
+        AVI->total_frames = AVI->video_frames; /* the header's count */
+    if (avi_scan_reset(AVI) < 0)
+        return -1;
+    if (AVI->index_cache) {
+        if (avi_load_index_cache(AVI) == 0)
+            return 0;
+        if (avi_scan_reset(AVI) < 0)
+            return -1;
+    }
+
+    if (resync)
+        plat_log_send(PLAT_LOG_INFO, __FILE__, "Reconstructing index...");
+    AVI->scan_pos    = AVI->movi_start;
+    AVI->scan_resync = resync;
+
+    /* the first frame tells whether there is any video at all */
+    avi_scan_to(AVI, 0, -1, -1);
+    return 0;
+}
+
 /* Returns 1 if more audio is in that video junk */
 int AVI_can_read_audio(avi_t *AVI)
 {
@@ -540,6 +1184,8 @@ int AVI_can_read_audio(avi_t *AVI)
    if(!AVI->video_index)         { return -1; }
    if(!AVI->track[AVI->aptr].audio_index)         { return -1; }
 
+   avi_scan_to(AVI, AVI->video_pos, AVI->track[AVI->aptr].audio_posc, -1);
+
    // is it -1? the last ones got left out --tibit
    //if (AVI->track[AVI->aptr].audio_posc>=AVI->track[AVI->aptr].audio_chunks-1) {
    if (AVI->track[AVI->aptr].audio_posc>=AVI->track[AVI->aptr].audio_chunks) {
@@ -596,6 +1242,9 @@ avi_t *AVI_open_output_file(const char *filename)
     AVI->pos  = HEADERBYTES;
     AVI->mode = AVI_MODE_WRITE; /* open for writing */
 
+    /* unbuffered if this fails */
+    AVI_set_write_buffer(AVI, AVI_WRITE_BUFFER, 0);
+
     //init
     AVI->anum = 0;
     AVI->aptr = 0;
@@ -914,9 +1563,7 @@ int avi_update_header(avi_t *AVI)
    /* Output the header, truncate the file to the number of bytes
       actually written, report an error if someting goes wrong */
 
-   if ( plat_seek(AVI->fdes,0,SEEK_SET)<0 ||
-        plat_write(AVI->fdes,(char *)AVI_header,HEADERBYTES)!=HEADERBYTES ||
-	plat_seek(AVI->fdes,AVI->pos,SEEK_SET)<0)
+   if (avi_write_at(AVI, 0, AVI_header, HEADERBYTES) < 0)
      {
        AVI_errno = AVI_ERR_CLOSE;
        return -1;
@@ -1593,10 +2240,11 @@ static int avi_close_output_file(avi_t *AVI)
    OUTLONG(movi_len); /* Length of list in bytes */
    OUT4CC ("movi");
 
-   /* Output the header, truncate the file to the number of bytes
-      actually written, report an error if someting goes wrong */
+   /* Flush the output, write the header, truncate the file to the number
+      of bytes actually written, report an error if someting goes wrong */
 
-   if ( plat_seek(AVI->fdes,0,SEEK_SET)<0 ||
+   if ( avi_wbuf_release(AVI)<0 ||
+        plat_seek(AVI->fdes,0,SEEK_SET)<0 ||
         plat_write(AVI->fdes,(char *)AVI_header,HEADERBYTES)!=HEADERBYTES ||
         plat_ftruncate(AVI->fdes,AVI->pos)<0 )
    {
@@ -1730,6 +2378,59 @@ int AVI_write_audio(avi_t *AVI, const uint8_t *data, long bytes)
     return 0;
 }
 
+/*
+   AVI_set_write_buffer:
+   Collect up to `size' bytes of output before writing them out, 0 writes
+   every chunk as it comes.  With `direct' set the output goes to disk in
+   aligned blocks with O_DIRECT, bypassing the page cache, if platform and
+   filesystem allow it; else this falls back to plain buffering.
+
+   Return values:
+    0    No error;
+   -1    Error, AVI_errno is set appropriatly;
+
+*/
+int AVI_set_write_buffer(avi_t *AVI, long size, int direct)
+{
+    off_t start = AVI->pos;
+    long head = 0;
+
+    RETURN_ERROR_IF_READ_MODE(AVI);
+
+    if (avi_wbuf_release(AVI) < 0)
+        return -1;
+    if (size <= 0)
+        return 0;
+
+    if (direct) {
+        size  = (size + DIRECT_ALIGN-1) & ~(DIRECT_ALIGN-1);
+        start = AVI->pos & ~(off_t)(DIRECT_ALIGN-1);
+        head  = AVI->pos - start;
+    }
+    if (posix_memalign((void **)&AVI->wbuf, DIRECT_ALIGN, size) != 0) {
+        AVI->wbuf = NULL;
+        AVI_errno = AVI_ERR_NO_MEM;
+        return -1;
+    }
+    AVI->wbuf_size = size;
+
+    /* direct writes restart from the block holding the current end */
+    if (direct) {
+        if (plat_seek(AVI->fdes, start, SEEK_SET) == start
+         && plat_read(AVI->fdes, AVI->wbuf, head) == head
+         && plat_set_direct(AVI->fdes, 1) == 0) {
+            AVI->wbuf_pos    = start;
+            AVI->wbuf_len    = head;
+            AVI->wbuf_direct = 1;
+        } else {
+            plat_log_send(PLAT_LOG_WARNING, __FILE__,
+                          "no direct I/O here, using plain buffering");
+        }
+        plat_seek(AVI->fdes, AVI->wbuf_pos, SEEK_SET);
+    }
+    return 0;
+}
+
 
 long AVI_bytes_remain(avi_t *AVI)
 {
@@ -1803,8 +2504,16 @@ int AVI_close(avi_t *AVI)
         plat_close(AVI->comment_fd);
     AVI->comment_fd = -1;
 
+    if (AVI->map)
+        plat_munmap(AVI->map, AVI->map_size);
     plat_close(AVI->fdes);
 
+    if (AVI->index_cache)
+        plat_free(AVI->index_cache);
+    if (AVI->vref)
+        plat_free(AVI->vref);
+    if (AVI->aref)
+        plat_free(AVI->aref);
     if (AVI->idx)
         plat_free(AVI->idx);
     if (AVI->video_index)
@@ -1867,7 +2576,9 @@ int AVI_close(avi_t *AVI)
    return 0; \
 } while (0)
 
-avi_t *AVI_open_indexfd(int fd, int getIndex, const char *indexfile)
+/* `filename' names the index cache, if given */
+static avi_t *avi_open_input(int fd, int getIndex, const char *indexfile,
+                             const char *filename)
 {
    avi_t *AVI = plat_zalloc(sizeof(avi_t));
    if (AVI == NULL) {
@@ -1883,7 +2594,16 @@ avi_t *AVI_open_indexfd(int fd, int getIndex, const char *indexfile)
    if (indexfile) {
        AVI->index_file = strdup(indexfile);
    }
+   if (filename) {
+       size_t len = strlen(filename) + strlen(AVI_INDEX_CACHE_SUFFIX) + 1;
+
+       AVI->index_cache = plat_malloc(len);
+       if (AVI->index_cache)
+           snprintf(AVI->index_cache, len, "%s%s",
+                    filename, AVI_INDEX_CACHE_SUFFIX);
+   }
    AVI_errno = 0;
+   avi_map_file(AVI);
    avi_parse_input_file(AVI, getIndex);
 
    if (AVI != NULL && !AVI_errno) {
@@ -1893,6 +2613,11 @@ avi_t *AVI_open_indexfd(int fd, int getIndex, const char *indexfile)
    return (AVI_errno) ?NULL :AVI;
 }
 
+avi_t *AVI_open_indexfd(int fd, int getIndex, const char *indexfile)
+{
+   return avi_open_input(fd, getIndex, indexfile, NULL);
+}
+
 avi_t *AVI_open_input_indexfile(const char *filename, int getIndex,
 				                const char *indexfile)
 {
@@ -1901,7 +2626,7 @@ avi_t *AVI_open_input_indexfile(const char *filename, int getIndex,
       AVI_errno = AVI_ERR_OPEN;
       return NULL;
    }
-   return AVI_open_indexfd(fd, getIndex, indexfile);
+   return avi_open_input(fd, getIndex, indexfile, filename);
 }
 
 avi_t *AVI_open_input_file(const char *filename, int getIndex)
@@ -2099,6 +2824,7 @@ static int avi_parse_input_file(avi_t *AVI, int getIndex)
   //  int auds_strf_seen = 0;
   char data[256];
   off_t oldpos=-1, newpos=-1, n;
+  int lazy = 0;
 
   /* Read first 12 bytes and check that this is an AVI file */
 
@@ -2483,38 +3209,12 @@ static int avi_parse_input_file(avi_t *AVI, int getIndex)
 
    if(idx_type == 0 && !AVI->is_opendml && !AVI->total_frames)
    {
-      /* we must search through the file to get the index */
-
-      plat_seek(AVI->fdes, AVI->movi_start, SEEK_SET);
+      /* we must search through the file to get the index;
+         this goes only as far as the reads need */
 
-      AVI->n_idx = 0;
-
-      while(1)
-      {
-         if( plat_read(AVI->fdes,data,8) != 8 ) break;
-         n = str2ulong((unsigned char *)data+4);
-
-         /* The movi list may contain sub-lists, ignore them */
-
-         if(strncasecmp(data,"LIST",4)==0)
-         {
-            plat_seek(AVI->fdes,4,SEEK_CUR);
-            continue;
-         }
-
-         /* Check if we got a tag ##db, ##dc or ##wb */
-	
-         if( ( (data[2]=='d' || data[2]=='D') &&
-               (data[3]=='b' || data[3]=='B' || data[3]=='c' || data[3]=='C') )
-	     || ( (data[2]=='w' || data[2]=='W') &&
-		  (data[3]=='b' || data[3]=='B') ) )
-	   {
-	   avi_add_index_entry(AVI,(unsigned char *)data,0,plat_seek(AVI->fdes,0,SEEK_CUR)-8,n);
-         }
-	
-         plat_seek(AVI->fdes,PAD_EVEN(n),SEEK_CUR);
-      }
-      idx_type = 1;
+      if (avi_scan_start(AVI, 0) < 0) ERR_EXIT(AVI_ERR_NO_MEM);
+      if (AVI->video_frames == 0) ERR_EXIT(AVI_ERR_NO_VIDS);
+      lazy = 1;
    }
 
    // ************************
@@ -2522,7 +3222,10 @@ static int avi_parse_input_file(avi_t *AVI, int getIndex)
    // ************************
 
    // read extended index chunks
-   if (AVI->is_opendml) {
+   if (lazy) {
+      /* nothing else to do now */
+   }
+   else if (AVI->is_opendml) {
       uint64_t offset = 0;
       int hdrl_len = 4+4+2+1+1+4+4+8+4;
       char *en, *chunk_start;
@@ -2687,110 +3390,10 @@ static int avi_parse_input_file(avi_t *AVI, int getIndex)
    // MULTIPLE RIFF CHUNKS (and no index)
    // *********************
 
-      long aud_chunks = 0;
 multiple_riff:
 
-      plat_seek(AVI->fdes, AVI->movi_start, SEEK_SET);
-
-      AVI->n_idx = 0;
-
-      plat_log_send(PLAT_LOG_INFO, __FILE__, "Reconstructing index...");
-
-      // Number of frames; only one audio track supported
-      nvi = AVI->video_frames = AVI->total_frames;
-      nai[0] = AVI->track[0].audio_chunks = AVI->total_frames;
-      for(j=1; j<AVI->anum; ++j) AVI->track[j].audio_chunks = 0;
-
-      AVI->video_index = plat_malloc(nvi*sizeof(video_index_entry));
-
-      if(AVI->video_index==0) ERR_EXIT(AVI_ERR_NO_MEM);
-
-      for(j=0; j<AVI->anum; ++j) {
-	  if(AVI->track[j].audio_chunks) {
-	      AVI->track[j].audio_index = plat_zalloc((nai[j]+1)*sizeof(audio_index_entry));
-	      if(AVI->track[j].audio_index==0) ERR_EXIT(AVI_ERR_NO_MEM);
-	  }
-      }
-
-      nvi = 0;
-      for(j=0; j<AVI->anum; ++j) nai[j] = tot[j] = 0;
-
-      aud_chunks = AVI->total_frames;
-
-      while(1)
-      {
-	 if (nvi >= AVI->total_frames) break;
-
-         if( plat_read(AVI->fdes,data,8) != 8 ) break;
-         n = str2ulong((unsigned char *)data+4);
-
-
-	 j=0;
-
-	 if (aud_chunks - nai[j] -1 <= 0) {
-	     aud_chunks += AVI->total_frames;
-	     AVI->track[j].audio_index = plat_realloc( AVI->track[j].audio_index, (aud_chunks+1)*sizeof(audio_index_entry));
-	     if (!AVI->track[j].audio_index) {
-         plat_log_send(PLAT_LOG_ERROR, __FILE__, "Internal error -- no mem");
-		 AVI_errno = AVI_ERR_NO_MEM;
-		 return -1;
-	     }
-	 }
-
-         /* Check if we got a tag ##db, ##dc or ##wb */
-	
-	 // VIDEO
-         if(
-	     (data[0]=='0' || data[1]=='0') &&
-	     (data[2]=='d' || data[2]=='D') &&
-             (data[3]=='b' || data[3]=='B' || data[3]=='c' || data[3]=='C') ) {
-
-	     AVI->video_index[nvi].key = 0x0;
-	     AVI->video_index[nvi].pos = plat_seek(AVI->fdes,0,SEEK_CUR);
-	     AVI->video_index[nvi].len = n;
-
-	     /*
-	     fprintf(stderr, "Frame %ld pos %lld len %lld key %ld\n",
-		     nvi, AVI->video_index[nvi].pos,  AVI->video_index[nvi].len, (long)AVI->video_index[nvi].key);
-		     */
-	     nvi++;
-	     plat_seek(AVI->fdes,PAD_EVEN(n),SEEK_CUR);
-	 }
-
-	 //AUDIO
-	 else if(
-		 (data[0]=='0' || data[1]=='1') &&
-		 (data[2]=='w' || data[2]=='W') &&
-	     (data[3]=='b' || data[3]=='B') ) {
-
-
-		AVI->track[j].audio_index[nai[j]].pos = plat_seek(AVI->fdes,0,SEEK_CUR);
-		AVI->track[j].audio_index[nai[j]].len = n;
-		AVI->track[j].audio_index[nai[j]].tot = tot[j];
-		tot[j] += AVI->track[j].audio_index[nai[j]].len;
-		nai[j]++;
-
-		plat_seek(AVI->fdes,PAD_EVEN(n),SEEK_CUR);
-	 }
-	 else {
-            plat_seek(AVI->fdes,-4,SEEK_CUR);
-	 }
-
-      }
-      if (nvi < AVI->total_frames) {
-          plat_log_send(PLAT_LOG_WARNING, __FILE__,
-                        "Uh? Some frames seems missing (%ld/%d)",
-                        nvi,  AVI->total_frames);
-      }
-
-
-      AVI->video_frames = nvi;
-      AVI->track[0].audio_chunks = nai[0];
-
-      for(j=0; j<AVI->anum; ++j) AVI->track[j].audio_bytes = tot[j];
-      idx_type = 1;
-      plat_log_send(PLAT_LOG_INFO, __FILE__,
-                    "done. nvi=%ld nai=%ld tot=%ld", nvi, nai[0], tot[0]);
+      // as above; only one audio track supported
+      if (avi_scan_start(AVI, 1) < 0) ERR_EXIT(AVI_ERR_NO_MEM);
 
    } // total_frames but no indx chunk (xawtv does this)
 
@@ -2871,8 +3474,18 @@ multiple_riff:
 
 long AVI_video_frames(avi_t *AVI)
 {
+   avi_scan_all(AVI);
    return AVI->video_frames;
 }
+
+/* the frame count without finishing the index: until then, the header's
+   if it has one */
+long AVI_video_frames_hint(avi_t *AVI)
+{
+   if (AVI->scan_pos > 0 && AVI->total_frames > 0)
+      return AVI->total_frames;
+   return AVI_video_frames(AVI);
+}
 int  AVI_video_width(avi_t *AVI)
 {
    return AVI->width;
@@ -2932,11 +3545,13 @@ long AVI_audio_rate(avi_t *AVI)
 
 long AVI_audio_bytes(avi_t *AVI)
 {
+   avi_scan_all(AVI);
    return AVI->track[AVI->aptr].audio_bytes;
 }
 
 long AVI_audio_chunks(avi_t *AVI)
 {
+   avi_scan_all(AVI);
    return AVI->track[AVI->aptr].audio_chunks;
 }
 
@@ -2965,6 +3580,7 @@ long AVI_frame_size(avi_t *AVI, long frame)
    if(AVI->mode==AVI_MODE_WRITE) { AVI_errno = AVI_ERR_NOT_PERM; return -1; }
    if(!AVI->video_index)         { AVI_errno = AVI_ERR_NO_IDX;   return -1; }
 
+   avi_scan_to(AVI, frame, -1, -1);
    if(frame < 0 || frame >= AVI->video_frames) return 0;
    return(AVI->video_index[frame].len);
 }
@@ -2974,6 +3590,7 @@ long AVI_audio_size(avi_t *AVI, long frame)
   if(AVI->mode==AVI_MODE_WRITE) { AVI_errno = AVI_ERR_NOT_PERM; return -1; }
   if(!AVI->track[AVI->aptr].audio_index)         { AVI_errno = AVI_ERR_NO_IDX;   return -1; }
 
+  avi_scan_to(AVI, -1, frame, -1);
   if(frame < 0 || frame >= AVI->track[AVI->aptr].audio_chunks) return -1;
   return(AVI->track[AVI->aptr].audio_index[frame].len);
 }
@@ -2983,6 +3600,7 @@ long AVI_get_video_position(avi_t *AVI, long frame)
    if(AVI->mode==AVI_MODE_WRITE) { AVI_errno = AVI_ERR_NOT_PERM; return -1; }
    if(!AVI->video_index)         { AVI_errno = AVI_ERR_NO_IDX;   return -1; }
 
+   avi_scan_to(AVI, frame, -1, -1);
    if(frame < 0 || frame >= AVI->video_frames) return 0;
    return(AVI->video_index[frame].pos);
 }
@@ -3016,13 +3634,14 @@ int AVI_set_audio_bitrate(avi_t *AVI, long bitrate)
 }
 
 
-long AVI_read_video(avi_t *AVI, char *vidbuf, long bytes, int *keyframe)
+long AVI_read_video(avi_t *AVI, uint8_t *vidbuf, long bytes, int *keyframe)
 {
    long n;
 
    if(AVI->mode==AVI_MODE_WRITE) { AVI_errno = AVI_ERR_NOT_PERM; return -1; }
    if(!AVI->video_index)         { AVI_errno = AVI_ERR_NO_IDX;   return -1; }
 
+   avi_scan_to(AVI, AVI->video_pos, -1, -1);
    if(AVI->video_pos < 0 || AVI->video_pos >= AVI->video_frames) return -1;
    n = AVI->video_index[AVI->video_pos].len;
 
@@ -3038,9 +3657,7 @@ long AVI_read_video(avi_t *AVI, char *vidbuf, long bytes, int *keyframe)
      return n;
    }
 
-   plat_seek(AVI->fdes, AVI->video_index[AVI->video_pos].pos, SEEK_SET);
-
-   if (plat_read(AVI->fdes,vidbuf,n) != n)
+   if (avi_read_at(AVI, AVI->video_index[AVI->video_pos].pos, vidbuf, n) < 0)
    {
       AVI_errno = AVI_ERR_READ;
       return -1;
@@ -3053,7 +3670,24 @@ long AVI_read_video(avi_t *AVI, char *vidbuf, long bytes, int *keyframe)
 
 long AVI_read_frame(avi_t *AVI, char *vidbuf, int *keyframe)
 {
-   return AVI_read_video(AVI, vidbuf, -1, keyframe);
+   return AVI_read_video(AVI, (uint8_t *)vidbuf, -1, keyframe);
+}
+
+/* as AVI_read_frame, but points *vidbuf to the data: into the file
+   mapping, or a buffer of the avi_t reused by the next call */
+long AVI_read_frame_ref(avi_t *AVI, const uint8_t **vidbuf, int *keyframe)
+{
+   long n = AVI_read_video(AVI, NULL, -1, keyframe);
+
+   if (n < 0) return -1;
+
+   *vidbuf = avi_ref_at(AVI, AVI->video_index[AVI->video_pos-1].pos, n,
+                        &AVI->vref, &AVI->vref_size);
+   if (*vidbuf == NULL) {
+      AVI->video_pos--;
+      return -1;
+   }
+   return n;
 }
 
 
@@ -3069,6 +3703,7 @@ int AVI_set_audio_position_index(avi_t *AVI, long indexpos)
 {
    if(AVI->mode==AVI_MODE_WRITE) { AVI_errno = AVI_ERR_NOT_PERM; return -1; }
    if(!AVI->track[AVI->aptr].audio_index)         { AVI_errno = AVI_ERR_NO_IDX;   return -1; }
+   avi_scan_to(AVI, -1, indexpos, -1);
    if(indexpos > AVI->track[AVI->aptr].audio_chunks)     { AVI_errno = AVI_ERR_NO_IDX;   return -1; }
 
    AVI->track[AVI->aptr].audio_posc = indexpos;
@@ -3086,6 +3721,7 @@ int AVI_set_audio_position(avi_t *AVI, long byte)
    if(!AVI->track[AVI->aptr].audio_index)         { AVI_errno = AVI_ERR_NO_IDX;   return -1; }
 
    if(byte < 0) byte = 0;
+   avi_scan_to(AVI, -1, -1, byte);
 
    /* Binary search in the audio chunks */
 
@@ -3124,7 +3760,7 @@ long AVI_read_audio(avi_t *AVI, char *audbuf, long bytes)
    }
    while(bytes>0)
    {
-       off_t ret;
+      avi_scan_to(AVI, -1, AVI->track[AVI->aptr].audio_posc+1, -1);
       left = AVI->track[AVI->aptr].audio_index[AVI->track[AVI->aptr].audio_posc].len - AVI->track[AVI->aptr].audio_posb;
       if(left==0)
       {
@@ -3138,11 +3774,10 @@ long AVI_read_audio(avi_t *AVI, char *audbuf, long bytes)
       else
          todo = left;
       pos = AVI->track[AVI->aptr].audio_index[AVI->track[AVI->aptr].audio_posc].pos + AVI->track[AVI->aptr].audio_posb;
-      plat_seek(AVI->fdes, pos, SEEK_SET);
-      if ( (ret = plat_read(AVI->fdes,audbuf+nr,todo)) != todo)
+      if (avi_read_at(AVI, pos, audbuf+nr, todo) < 0)
       {
-	    plat_log_send(PLAT_LOG_DEBUG, __FILE__, "XXX pos = %lld, ret = %lld, todo = %ld",
-                     (long long)pos, (long long)ret, todo);
+	    plat_log_send(PLAT_LOG_DEBUG, __FILE__, "XXX pos = %lld, todo = %ld",
+                     (long long)pos, todo);
          AVI_errno = AVI_ERR_READ;
          return -1;
       }
@@ -3162,6 +3797,7 @@ long AVI_read_audio_chunk(avi_t *AVI, char *audbuf)
    if(AVI->mode==AVI_MODE_WRITE) { AVI_errno = AVI_ERR_NOT_PERM; return -1; }
    if(!AVI->track[AVI->aptr].audio_index)         { AVI_errno = AVI_ERR_NO_IDX;   return -1; }
 
+   avi_scan_to(AVI, -1, AVI->track[AVI->aptr].audio_posc, -1);
    if (AVI->track[AVI->aptr].audio_posc+1>AVI->track[AVI->aptr].audio_chunks) return -1;
 
    left = AVI->track[AVI->aptr].audio_index[AVI->track[AVI->aptr].audio_posc].len - AVI->track[AVI->aptr].audio_posb;
@@ -3175,8 +3811,7 @@ long AVI_read_audio_chunk(avi_t *AVI, char *audbuf)
    }
 
    pos = AVI->track[AVI->aptr].audio_index[AVI->track[AVI->aptr].audio_posc].pos + AVI->track[AVI->aptr].audio_posb;
-   plat_seek(AVI->fdes, pos, SEEK_SET);
-   if (plat_read(AVI->fdes,audbuf,left) != left)
+   if (avi_read_at(AVI, pos, audbuf, left) < 0)
    {
       AVI_errno = AVI_ERR_READ;
       return -1;
@@ -3187,6 +3822,25 @@ long AVI_read_audio_chunk(avi_t *AVI, char *audbuf)
    return left;
 }
 
+/* as AVI_read_audio_chunk, but points *audbuf to the data like
+   AVI_read_frame_ref does */
+long AVI_read_audio_chunk_ref(avi_t *AVI, const uint8_t **audbuf)
+{
+   track_t *t = &AVI->track[AVI->aptr];
+   long left = AVI_read_audio_chunk(AVI, NULL);
+
+   if (left < 0) return -1;
+
+   *audbuf = avi_ref_at(AVI, t->audio_index[t->audio_posc].pos + t->audio_posb,
+                        left, &AVI->aref, &AVI->aref_size);
+   if (*audbuf == NULL) return -1;
+
+   t->audio_posc++;
+   t->audio_posb = 0;
+
+   return left;
+}
+
 /* AVI_print_error: Print most recent error (similar to perror) */
 
 static const char *avi_errors[] =
@@ -145,6 +145,7 @@ typedef struct track_s
     off_t  a_codecf_off;       /* absolut offset of audio codec information */
 
     audio_index_entry *audio_index;
+    long   audio_max_idx;     /* entries allocated, while scanning */
     avisuperindex_chunk *audio_superindex;
 
 } track_t;
@@ -238,23 +239,48 @@ typedef struct
   uint32_t last_len;   /* Length of last frame written */
   int must_use_index;       /* Flag if frames are duplicated */
   off_t  movi_start;
-  int total_frames;         /* total number of frames if dmlh is present */
+  int total_frames;         /* total number of frames if dmlh is present
+                               (or strh says, while scanning the index) */
 
   int anum;            // total number of audio tracks
   int aptr;            // current audio working track
   int comment_fd;      // Read avi header comments from this fd
   char *index_file;    // read the avi index from this file
+  char *index_cache;   // sidecar index cache, see avi_save_index_cache()
 
   alBITMAPINFOHEADER *bitmap_info_header;
   alWAVEFORMATEX *wave_format_ex[AVI_MAX_TRACKS];
 
   void*     extradata;
   unsigned long extradata_size;
+
+  /* output buffer, see AVI_set_write_buffer() */
+  uint8_t *wbuf;            /* pending output */
+  long   wbuf_size;         /* flush threshold, 0 for unbuffered */
+  long   wbuf_len;          /* bytes pending */
+  off_t  wbuf_pos;          /* file position of wbuf[0] */
+  int    wbuf_direct;       /* fdes is in O_DIRECT mode */
+  long   wbuf_calls;        /* write syscalls so far */
+
+  /* input side, see avi_read_at() and avi_scan_chunk() */
+  const uint8_t *map;       /* the whole file, or NULL */
+  off_t  map_size;          /* bytes mapped */
+  uint8_t *vref;            /* AVI_read_frame_ref() data if not mapped */
+  long   vref_size;
+  uint8_t *aref;            /* the same for AVI_read_audio_chunk_ref() */
+  long   aref_size;
+  off_t  scan_pos;          /* next chunk to index, 0 once complete */
+  int    scan_resync;       /* xawtv style file: resync on unknown tags */
+  long   max_vidx;          /* video_index entries allocated */
 } avi_t;
 
 #define AVI_MODE_WRITE  0
 #define AVI_MODE_READ   1
 
+#define AVI_WRITE_BUFFER (512*1024) /* default output buffer size */
+
+#define AVI_INDEX_CACHE_SUFFIX ".aviidx" /* appended to the file name */
+
 /* The error codes delivered by avi_open_input_file */
 
 #define AVI_ERR_SIZELIM      1     /* The write of the data would exceed
@@ -331,6 +357,7 @@ int  AVI_write_audio(avi_t *AVI, const uint8_t *data, long bytes);
 long AVI_bytes_remain(avi_t *AVI);
 int  AVI_close(avi_t *AVI);
 long AVI_bytes_written(avi_t *AVI);
+int  AVI_set_write_buffer(avi_t *AVI, long size, int direct);
 
 avi_t *AVI_open_input_file(const char *filename, int getIndex);
 avi_t *AVI_open_input_indexfile(const char *filename, int getIndex,
@@ -341,6 +368,7 @@ avi_t *AVI_open_indexfd(int fd, int getIndex, const char *indexfile);
 long AVI_audio_mp3rate(avi_t *AVI);
 long AVI_audio_padrate(avi_t *AVI);
 long AVI_video_frames(avi_t *AVI);
+long AVI_video_frames_hint(avi_t *AVI);
 int  AVI_video_width(avi_t *AVI);
 int  AVI_video_height(avi_t *AVI);
 double AVI_frame_rate(avi_t *AVI);
@@ -362,7 +390,8 @@ int  AVI_seek_start(avi_t *AVI);
 int  AVI_set_video_position(avi_t *AVI, long frame);
 long AVI_get_video_position(avi_t *AVI, long frame);
 long AVI_read_frame(avi_t *AVI, char *vidbuf, int *keyframe);
-long AVI_read_video(avi_t *AVI, char *vidbuf, long bytes, int *keyframe);
+long AVI_read_video(avi_t *AVI, uint8_t *vidbuf, long bytes, int *keyframe);
+long AVI_read_frame_ref(avi_t *AVI, const uint8_t **vidbuf, int *keyframe);
 
 int  AVI_set_audio_position(avi_t *AVI, long byte);
 int  AVI_set_audio_bitrate(avi_t *AVI, long bitrate);
@@ -372,6 +401,7 @@ int  AVI_set_audio_position_index(avi_t *AVI, long indexpos);
 
 long AVI_read_audio(avi_t *AVI, char *audbuf, long bytes);
 long AVI_read_audio_chunk(avi_t *AVI, char *audbuf);
+long AVI_read_audio_chunk_ref(avi_t *AVI, const uint8_t **audbuf);
 
 long AVI_audio_codech_offset(avi_t *AVI);
 long AVI_audio_codecf_offset(avi_t *AVI);
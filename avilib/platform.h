@@ -25,11 +25,8 @@
 
 #include "config.h"
 
-#ifdef OS_DARWIN
-#include <sys/uio.h>
-#endif
-
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -46,8 +43,20 @@ int plat_open(const char *pathname, int flags, int mode);
 int plat_close(int fd);
 ssize_t plat_read(int fd, void *buf, size_t count);
 ssize_t plat_write(int fd, const void *buf, size_t count);
+ssize_t plat_writev(int fd, const struct iovec *iov, int iovcnt);
 int64_t plat_seek(int fd, int64_t offset, int whence);
 int plat_ftruncate(int fd, int64_t length);
+int plat_fstat(int fd, struct stat *buf);
+int plat_rename(const char *oldpath, const char *newpath);
+/* create and open for writing a new file named after `template', which
+   ends with "XXXXXX" (see mkstemp); -1 on error */
+int plat_mkstemp(char *template, int mode);
+/* switch O_DIRECT on or off for `fd'; -1 if the platform can't */
+int plat_set_direct(int fd, int enable);
+/* map the first `size' bytes of `fd' read-only; NULL if the platform
+   can't */
+const void *plat_mmap(int fd, int64_t size);
+int plat_munmap(const void *addr, int64_t size);
 
 /*************************************************************************/
 /* libc-like memory handling                                             */
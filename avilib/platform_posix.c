@@ -19,11 +19,16 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE /* O_DIRECT */
+#endif
+
 #include "platform.h"
 
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <sys/mman.h>
 
 
 /*************************************************************************/
@@ -80,6 +85,38 @@ ssize_t plat_write(int fd, const void *buf, size_t count)
     return r;
 }
 
+/*
+ * as above, for a whole vector: a short write goes on from where it
+ * stopped
+ */
+ssize_t plat_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    struct iovec v[iovcnt];
+    ssize_t n = 0, r = 0;
+    int i = 0;
+
+    memcpy(v, iov, iovcnt * sizeof(*v));
+    while (i < iovcnt) {
+        n = writev(fd, v + i, iovcnt - i);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return n;
+        }
+
+        r += n;
+        while (i < iovcnt && n >= v[i].iov_len) {
+            n -= v[i].iov_len;
+            i++;
+        }
+        if (i < iovcnt) {
+            v[i].iov_base = (uint8_t *)v[i].iov_base + n;
+            v[i].iov_len -= n;
+        }
+    }
+    return r;
+}
+
 
 int64_t plat_seek(int fd, int64_t offset, int whence)
 {
@@ -91,6 +128,57 @@ int plat_ftruncate(int fd, int64_t length)
     return ftruncate(fd, length);
 }
 
+int plat_fstat(int fd, struct stat *buf)
+{
+    return fstat(fd, buf);
+}
+
+int plat_rename(const char *oldpath, const char *newpath)
+{
+    return rename(oldpath, newpath);
+}
+
+int plat_mkstemp(char *template, int mode)
+{
+    int fd = mkstemp(template);
+
+    if (fd >= 0 && fchmod(fd, mode) != 0) {
+        close(fd);
+        unlink(template);
+        fd = -1;
+    }
+    return fd;
+}
+
+int plat_set_direct(int fd, int enable)
+{
+#ifdef O_DIRECT
+    int flags = fcntl(fd, F_GETFL);
+
+    if (flags < 0)
+        return -1;
+    flags = (enable) ?(flags | O_DIRECT) :(flags & ~O_DIRECT);
+    return fcntl(fd, F_SETFL, flags);
+#else
+    return -1;
+#endif
+}
+
+const void *plat_mmap(int fd, int64_t size)
+{
+    void *addr = NULL;
+
+    if (size <= 0 || (uint64_t)size > SIZE_MAX)
+        return NULL;
+    addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    return (addr == MAP_FAILED) ?NULL :addr;
+}
+
+int plat_munmap(const void *addr, int64_t size)
+{
+    return munmap((void *)addr, size);
+}
+
 
 
 /*************************************************************************/
@@ -51,6 +51,23 @@ ssize_t plat_write(int fd, const void *buf, size_t count)
     return tc_pwrite(fd, buf, count);
 }
 
+ssize_t plat_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    ssize_t n = 0, r = 0;
+    int i = 0;
+
+    /* xio has no vectored I/O */
+    for (i = 0; i < iovcnt; i++) {
+        n = tc_pwrite(fd, iov[i].iov_base, iov[i].iov_len);
+        if (n < 0)
+            return n;
+        r += n;
+        if (n < iov[i].iov_len)
+            break;
+    }
+    return r;
+}
+
 int64_t plat_seek(int fd, int64_t offset, int whence)
 {
     return xio_lseek(fd, offset, whence);
@@ -61,6 +78,50 @@ int plat_ftruncate(int fd, int64_t length)
     return xio_ftruncate(fd, length);
 }
 
+int plat_fstat(int fd, struct stat *buf)
+{
+    return xio_fstat(fd, buf);
+}
+
+int plat_rename(const char *oldpath, const char *newpath)
+{
+    return xio_rename(oldpath, newpath);
+}
+
+int plat_mkstemp(char *template, int mode)
+{
+    /* the name is ours once created: open it again through xio */
+    int fd = mkstemp(template);
+
+    if (fd < 0)
+        return -1;
+    if (fchmod(fd, mode) != 0) {
+        close(fd);
+        unlink(template);
+        return -1;
+    }
+    close(fd);
+    fd = xio_open(template, O_WRONLY|O_TRUNC, 0);
+    if (fd < 0)
+        unlink(template);
+    return fd;
+}
+
+int plat_set_direct(int fd, int enable)
+{
+    return -1; /* xio handles may not be plain descriptors */
+}
+
+const void *plat_mmap(int fd, int64_t size)
+{
+    return NULL; /* as above */
+}
+
+int plat_munmap(const void *addr, int64_t size)
+{
+    return -1;
+}
+
 
 
 void *_plat_malloc(const char *file, int line, size_t size)
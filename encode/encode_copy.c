@@ -102,7 +102,8 @@ static int copy_encode_video(TCModuleInstance *self,
 {
     TC_MODULE_SELF_CHECK(self, "encode_video");
 
-    vframe_copy(outframe, inframe, 1);
+    /* just hand over the payload: it stays valid until we return */
+    vframe_copy(outframe, inframe, 0);
     outframe->video_len = outframe->video_size;
 
     return TC_OK;
@@ -113,7 +114,7 @@ static int copy_encode_audio(TCModuleInstance *self,
 {
     TC_MODULE_SELF_CHECK(self, "encode_audio");
 
-    aframe_copy(outframe, inframe, 1);
+    aframe_copy(outframe, inframe, 0);
     outframe->audio_len = outframe->audio_size;
 
     return TC_OK;
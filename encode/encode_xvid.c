@@ -138,8 +138,11 @@ typedef struct {
     int64_t sse_u;
     int64_t sse_v;
 
-    /* Image format conversion handle */
+    /* Image format conversion handle, and the converted picture: the
+     * input frame may share its payload with a clone, so it is never
+     * converted in place */
     TCVHandle tcvhandle;
+    uint8_t *convbuf;
 
     int flush_flag;
     int need_flush;
@@ -223,7 +226,7 @@ static int tc_xvid_init(TCModuleInstance *self, uint32_t features)
         return TC_ERROR;
     }
 
-    pd = tc_malloc(sizeof(XviDPrivateData));
+    pd = tc_zalloc(sizeof(XviDPrivateData));
     if (!pd) {
         tc_log_error(MOD_NAME, "init: can't allocate XviD private data");
         return TC_ERROR;
@@ -241,6 +244,12 @@ static int tc_xvid_init(TCModuleInstance *self, uint32_t features)
             tc_log_warn(MOD_NAME, "init: tcv_init failed");
             goto init_failed;
         }
+        pd->convbuf = tc_malloc(vob->ex_v_width * vob->ex_v_height * 3);
+        if (!pd->convbuf) {
+            tc_log_warn(MOD_NAME, "init: can't allocate conversion buffer");
+            tcv_free(pd->tcvhandle);
+            goto init_failed;
+        }
     }
 
     reset_module(pd);
@@ -335,11 +344,11 @@ static int tc_xvid_encode_video(TCModuleInstance *self,
 
     if(vob->im_v_codec == TC_CODEC_YUV422P) {
         /* Convert to UYVY */
-        tcv_convert(pd->tcvhandle, inframe->video_buf, inframe->video_buf,
+        tcv_convert(pd->tcvhandle, inframe->video_buf, pd->convbuf,
                     vob->ex_v_width, vob->ex_v_height, IMG_YUV422P, IMG_UYVY);
     } else if (vob->im_v_codec == TC_CODEC_RGB24) {
         /* Convert to BGR (why isn't RGB supported??) */
-        tcv_convert(pd->tcvhandle, inframe->video_buf, inframe->video_buf,
+        tcv_convert(pd->tcvhandle, inframe->video_buf, pd->convbuf,
                     vob->ex_v_width, vob->ex_v_height, IMG_RGB24, IMG_BGR24);
     }
     /* Combine both the config settings with the transcode direct options
@@ -532,6 +541,8 @@ static void cleanup_module(XviDPrivateData *mod)
         tcv_free(mod->tcvhandle);
         mod->tcvhandle = NULL;
     }
+    tc_free(mod->convbuf);
+    mod->convbuf = NULL;
 
     /* Release stream buffer memory */
     if(mod->stream != NULL) {
@@ -999,8 +1010,8 @@ static void set_frame_struct(XviDPrivateData *mod, vob_t *vob,
     } else {
         x->length    = outframe->video_size;
 
-        /* Bind source frame */
-        x->input.plane[0] = inframe->video_buf;
+        /* Bind source frame, or its converted copy */
+        x->input.plane[0] = (mod->convbuf) ?mod->convbuf :inframe->video_buf;
         if (vob->im_v_codec == TC_CODEC_RGB24) {
             x->input.csp       = XVID_CSP_BGR;
             x->input.stride[0] = vob->ex_v_width*3;
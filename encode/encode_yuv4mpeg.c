@@ -81,6 +81,7 @@ typedef struct Y4MPrivateData {
     int size;
     TCVHandle tcvhandle;
     ImageFormat srcfmt;
+    uint8_t *frame;     /* converted picture; the input frame may be shared */
     y4m_stream_info_t y4mstream;
 } Y4MPrivateData;
 
@@ -132,6 +133,7 @@ static int tc_yuv4mpeg_init(TCModuleInstance *self, uint32_t features)
         return TC_ERROR;
     }
     pd->wrote_header = 0;
+    pd->frame = NULL;
 
     if (vob->im_v_codec == TC_CODEC_YUV420P) {
         pd->srcfmt = IMG_YUV_DEFAULT;
@@ -208,6 +210,16 @@ static int tc_yuv4mpeg_configure(TCModuleInstance *self, const char *options,
 
     pd->size = vob->ex_v_width * vob->ex_v_height * 3/2;
 
+    tc_free(pd->frame);
+    pd->frame = NULL;
+    if (pd->srcfmt != IMG_YUV420P) {
+        pd->frame = tc_malloc(pd->size);
+        if (!pd->frame) {
+            tc_log_error(MOD_NAME, "configure: can't allocate frame buffer");
+            return TC_ERROR;
+        }
+    }
+
     return TC_OK;
 }
 
@@ -235,6 +247,7 @@ static int tc_yuv4mpeg_encode_video(TCModuleInstance *self,
     vob_t *vob = tc_get_vob();
     y4m_frame_info_t info;
     y4m_cb_writer_t writer;
+    uint8_t *picture = NULL;
 
     TC_MODULE_SELF_CHECK(self, "encode_video");
 
@@ -257,11 +270,17 @@ static int tc_yuv4mpeg_encode_video(TCModuleInstance *self,
         return TC_OK;
     }
 
-    if (!tcv_convert(pd->tcvhandle, inframe->video_buf, inframe->video_buf,
-                     vob->ex_v_width, vob->ex_v_height,
-                     pd->srcfmt, IMG_YUV420P)) {
-        tc_log_warn(MOD_NAME, "image format conversion failed");
-        return TC_ERROR;
+    /* the input frame may share its payload with a clone: never
+     * convert it in place */
+    picture = inframe->video_buf;
+    if (pd->frame != NULL) {
+        if (!tcv_convert(pd->tcvhandle, inframe->video_buf, pd->frame,
+                         vob->ex_v_width, vob->ex_v_height,
+                         pd->srcfmt, IMG_YUV420P)) {
+            tc_log_warn(MOD_NAME, "image format conversion failed");
+            return TC_ERROR;
+        }
+        picture = pd->frame;
     }
 
 #ifdef USE_NEW_MJPEGTOOLS_CODE
@@ -285,7 +304,7 @@ static int tc_yuv4mpeg_encode_video(TCModuleInstance *self,
      * -- Looks like there is an outdated comment,
      *  a latent issue or both FR
      */
-    y4m_write_callback(outframe, inframe->video_buf, pd->size);
+    y4m_write_callback(outframe, picture, pd->size);
 
     return TC_OK;
 }
@@ -310,6 +329,7 @@ static int tc_yuv4mpeg_fini(TCModuleInstance *self)
     pd = self->userdata;
 
     tcv_free(pd->tcvhandle);
+    tc_free(pd->frame);
     tc_free(self->userdata);
     self->userdata = NULL;
 
@@ -40,7 +40,8 @@
 #include "subtitle_buffer.h"
 #include "subproc.h"
 
-#define BUFFER_SIZE SIZE_RGB_FRAME
+/* subpicture coordinates are 12 bits wide, so no subtitle is bigger */
+#define SUB_FRAME_SIZE (4096 * 4096)
 #define SUBTITLE_BUFFER 100
 
 static transfer_t import_para;
@@ -486,23 +487,23 @@ int tc_filter(frame_list_t *ptr_, char *options)
 
     codec = vob->im_v_codec;
 
-    if ((sub_frame = malloc(BUFFER_SIZE))==NULL) {
+    if ((sub_frame = malloc(SUB_FRAME_SIZE))==NULL) {
       tc_log_perror(MOD_NAME, "out of memory");
       return(TC_EXPORT_ERROR);
     } else
-      memset(sub_frame, 0, BUFFER_SIZE);
+      memset(sub_frame, 0, SUB_FRAME_SIZE);
 
-    if ((vid_frame = malloc(BUFFER_SIZE))==NULL) {
+    if ((vid_frame = malloc(TC_JOB_FRAME_SIZE(vob)))==NULL) {
       tc_log_perror(MOD_NAME, "out of memory");
       return(TC_EXPORT_ERROR);
     } else
-      memset(vid_frame, 0, BUFFER_SIZE);
+      memset(vid_frame, 0, TC_JOB_FRAME_SIZE(vob));
 
-    if ((tmp_frame = malloc(BUFFER_SIZE))==NULL) {
+    if ((tmp_frame = malloc(SUB_FRAME_SIZE))==NULL) {
       tc_log_perror(MOD_NAME, "out of memory");
       return(TC_EXPORT_ERROR);
     } else
-      memset(tmp_frame, 0, BUFFER_SIZE);
+      memset(tmp_frame, 0, SUB_FRAME_SIZE);
 
     aa_weight = vob->aa_weight;
     aa_bias = vob->aa_bias;
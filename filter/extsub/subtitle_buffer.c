@@ -32,9 +32,7 @@ sframe_list_t *sframe_list_head;
 sframe_list_t *sframe_list_tail;
 
 static int sub_buf_max = 0;
-#ifdef STATBUFFER
 static int sub_buf_next = 0;
-#endif
 
 static int sub_buf_fill=0;
 static int sub_buf_ready=0;
@@ -78,13 +76,11 @@ static int sub_buf_alloc(int ex_num)
 	sub_buf_ptr[n]->status = FRAME_NULL;
 	sub_buf_ptr[n]->bufid = n;
 
-#ifdef STATBUFFER
 	//allocate extra subeo memory:
 	if((sub_buf_ptr[n]->video_buf=tc_bufalloc(SUB_BUFFER_SIZE))==NULL) {
 	  tc_log_perror(__FILE__, "out of memory");
 	  return(-1);
 	}
-#endif /* STATBUFFER */
     }
 
     // assign to static
@@ -122,8 +118,6 @@ static void sub_buf_free(void)
 
 /* ------------------------------------------------------------------ */
 
-#ifdef STATBUFFER
-
 static sframe_list_t *sub_buf_retrieve(void)
 {
 
@@ -189,8 +183,6 @@ static int sub_buf_release(sframe_list_t *ptr)
     return(0);
 }
 
-#endif /* STATBUFFER */
-
 /* ------------------------------------------------------------------ */
 
 static FILE *fd = NULL;
@@ -234,18 +226,11 @@ sframe_list_t *sframe_register(int id)
 
   // retrive a valid pointer from the pool
 
-#ifdef STATBUFFER
   tc_debug(TC_DEBUG_FLIST, "frameid=%d", id);
   if((ptr = sub_buf_retrieve()) == NULL) {
     pthread_mutex_unlock(&sframe_list_lock);
     return(NULL);
   }
-#else
-  if((ptr = malloc(sizeof(sframe_list_t))) == NULL) {
-    pthread_mutex_unlock(&sframe_list_lock);
-    return(NULL);
-  }
-#endif
 
   ptr->status = FRAME_EMPTY;
 
@@ -311,11 +296,7 @@ void sframe_remove(sframe_list_t *ptr)
   // release valid pointer to pool
   ptr->status = FRAME_EMPTY;
 
-#ifdef STATBUFFER
   sub_buf_release(ptr);
-#else
-  free(ptr);
-#endif
 
   // adjust fill level
   --sub_buf_fill;
@@ -61,11 +61,7 @@ typedef struct sframe_list {
   struct sframe_list *next;
   struct sframe_list *prev;
 
-#ifdef STATBUFFER
   char *video_buf;
-#else
-  char video_buf[SUB_BUFFER_SIZE];
-#endif
 
 } sframe_list_t;
 
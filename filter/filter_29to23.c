@@ -23,140 +23,268 @@
  */
 
 #define MOD_NAME    "filter_29to23.so"
-#define MOD_VERSION "v0.3 (2003-07-18)"
+#define MOD_VERSION "v0.4 (2026-10-18)"
 #define MOD_CAP     "frame rate conversion filter (interpolating 29 to 23)"
 #define MOD_AUTHOR  "Tilmann Bitterberg, Max Alekseyev"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_DELAY|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
 
+static const char fr29to23_help[] = ""
+    "Overview\n"
+    "    Interpolates every 5 consecutive frames into 4 new ones,\n"
+    "    converting 29.97 fps to 23.976 fps.  No options.\n";
+
+/*************************************************************************/
+
+typedef struct FR29to23PrivateData_ {
+    int enabled;            /* input colorspace is supported */
+    uint8_t *f1;            /* the last two frames of the group */
+    uint8_t *f2;
+} FR29to23PrivateData;
+
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * fr29to23_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(fr29to23, FR29to23PrivateData)
+
+/*************************************************************************/
+
+/**
+ * fr29to23_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(fr29to23)
 
-static unsigned char *f1 = NULL;
-static unsigned char *f2 = NULL;
+/*************************************************************************/
 
-int tc_filter(frame_list_t *ptr_, char *options)
+/**
+ * fr29to23_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int fr29to23_configure(TCModuleInstance *self,
+                              const char *options,
+                              TCJob *vob,
+                              TCModuleExtraData *xdata[])
 {
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
+    FR29to23PrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    pd->enabled = (vob->im_v_codec == TC_CODEC_YUV420P
+                || vob->im_v_codec == TC_CODEC_RGB24);
+    pd->f1 = tc_malloc(TC_JOB_FRAME_SIZE(vob));
+    pd->f2 = tc_malloc(TC_JOB_FRAME_SIZE(vob));
+    if (!pd->f1 || !pd->f2) {
+        tc_log_error(MOD_NAME, "Malloc failed in %d", __LINE__);
+        tc_free(pd->f1);
+        tc_free(pd->f2);
+        pd->f1 = pd->f2 = NULL;
+        return TC_ERROR;
+    }
+
+    if (verbose)
+        tc_log_info(MOD_NAME, "options=%s", options);
 
-  if (ptr->tag & TC_AUDIO) return 0;
+    return TC_OK;
+}
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG && options) {
+/**
+ * fr29to23_stop:  Reset this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "Max Alekseyev, Tilmann Bitterberg", "VRYE", "1");
+static int fr29to23_stop(TCModuleInstance *self)
+{
+    FR29to23PrivateData *pd = NULL;
 
-    return 0;
-  }
+    TC_MODULE_SELF_CHECK(self, "stop");
 
-  if(ptr->tag & TC_FILTER_INIT) {
+    pd = self->userdata;
+    tc_free(pd->f1);
+    tc_free(pd->f2);
+    pd->f1 = pd->f2 = NULL;
+    return TC_OK;
+}
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+/*************************************************************************/
+
+/**
+ * fr29to23_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
+
+static int fr29to23_inspect(TCModuleInstance *self,
+                            const char *param, const char **value)
+{
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    if (optstr_lookup(param, "help")) {
+        *value = fr29to23_help;
+    }
+    return TC_OK;
+}
 
-    // filter init ok.
+/*************************************************************************/
 
-    f1 = tc_malloc (SIZE_RGB_FRAME);
-    f2 = tc_malloc (SIZE_RGB_FRAME);
+/**
+ * fr29to23_filter_video:  interpolate the given frame.  See
+ * tcmodule-data.h for function details.
+ *
+ * Interpolate every 5 consecutive frames with four ones
+ *
+ * Original frame/time scale:
+ * frame #: 0       1       2       3       4
+ *          *-------*-------*-------*-------*--...
+ * time:    0      .2      .4      .6      .8
+ *
+ * Interpolated frame/time scale:
+ * frame #: 0         1         2         3
+ *          *-------*-x-----*---x---*-----x-*--...
+ * time:    0        .25       .5        .75
+ *
+ * Linear interpolation suggests:
+ * NewFrame[0] = OldFrame[0]
+ * NewFrame[1] = ( 3*OldFrame[1] +   OldFrame[2] ) / 4
+ * NewFrame[2] = (   OldFrame[2] +   OldFrame[3] ) / 2
+ * NewFrame[3] = (   OldFrame[3] + 3*OldFrame[4] ) / 4
+ */
 
-    if (!f1 || !f2) {
-	    tc_log_error(MOD_NAME, "Malloc failed in %d", __LINE__);
-	    return -1;
+static int fr29to23_filter_video(TCModuleInstance *self,
+                                 vframe_list_t *frame)
+{
+    FR29to23PrivateData *pd = NULL;
+    uint8_t *f1 = NULL, *f2 = NULL, *f3 = NULL;
+    int i;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+    if (!pd->enabled)
+        return TC_OK;
+    f1 = pd->f1;
+    f2 = pd->f2;
+
+    switch (frame->id % 5) {
+      case 0:
+        break;
+
+      case 1:
+        ac_memcpy(f1, frame->video_buf, frame->video_size);
+        frame->attributes |= TC_FRAME_IS_SKIPPED;
+        break;
+
+      case 2:
+        ac_memcpy(f2, frame->video_buf, frame->video_size);
+        for (i = 0; i < frame->video_size; i++)
+            frame->video_buf[i] = (3*f1[i] + f2[i] + 1)/4;
+        break;
+
+      case 3:
+        ac_memcpy(f1, frame->video_buf, frame->video_size);
+        for (i = 0; i < frame->video_size; i++)
+            frame->video_buf[i] = (f1[i] + f2[i])/2;
+        break;
+
+      case 4:
+        f3 = frame->video_buf;
+        for (i = 0; i < frame->video_size; i++)
+            frame->video_buf[i] = (f1[i] + 3*f3[i] + 1)/4;
+        break;
     }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID fr29to23_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID fr29to23_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(fr29to23);
+TC_MODULE_FILTER_FORMATS(fr29to23);
+
+TC_MODULE_INFO(fr29to23);
+
+static const TCModuleClass fr29to23_class = {
+    TC_MODULE_CLASS_HEAD(fr29to23),
+
+    .init         = fr29to23_init,
+    .fini         = fr29to23_fini,
+    .configure    = fr29to23_configure,
+    .stop         = fr29to23_stop,
+    .inspect      = fr29to23_inspect,
+
+    .filter_video = fr29to23_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(fr29to23)
+
+/*************************************************************************/
 
-    if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-
-    if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
-
-    return(0);
-  }
-
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
-
-
-  if(ptr->tag & TC_FILTER_CLOSE) {
-
-      if (f1) free (f1);
-      if (f2) free (f2);
-      return(0);
-  }
-
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
-
-  /* Interpolate every 5 consecutive frames with four ones
-   *
-   * Original frame/time scale:
-   * frame #: 0       1       2       3       4
-   *          *-------*-------*-------*-------*--...
-   * time:    0      .2      .4      .6      .8
-   *
-   * Interpolated frame/time scale:
-   * frame #: 0         1         2         3
-   *          *-------*-x-----*---x---*-----x-*--...
-   * time:    0        .25       .5        .75
-   *
-   * Linear interpolation suggests:
-   * NewFrame[0] = OldFrame[0]
-   * NewFrame[1] = ( 3*OldFrame[1] +   OldFrame[2] ) / 4
-   * NewFrame[2] = (   OldFrame[2] +   OldFrame[3] ) / 2
-   * NewFrame[3] = (   OldFrame[3] + 3*OldFrame[4] ) / 4
-   */
-
-  if( ptr->tag & TC_PRE_S_PROCESS &&
-     (vob->im_v_codec == TC_CODEC_YUV420P || vob->im_v_codec == TC_CODEC_RGB24) ) {
-
-      int i;
-      unsigned char *f3;
-
-      switch ( ptr->id % 5 ) {
-
-          case 0:
-              break;
-
-          case 1:
-	      ac_memcpy (f1, ptr->video_buf, ptr->video_size);
-	      ptr->attributes |= TC_FRAME_IS_SKIPPED;
-	      break;
-
-          case 2:
-	      ac_memcpy (f2, ptr->video_buf, ptr->video_size);
-	      for (i = 0; i<ptr->video_size; i++)
-		  ptr->video_buf[i] = (3*f1[i] + f2[i] + 1)/4;
-	      break;
-
-          case 3:
-	      ac_memcpy (f1, ptr->video_buf, ptr->video_size);
-	      for (i = 0; i<ptr->video_size; i++)
-		  ptr->video_buf[i] = (f1[i] + f2[i])/2;
-	      break;
-
-          case 4:
-	      //ac_memcpy (f2, ptr->video_buf, ptr->video_size);
-              f3 = ptr->video_buf;
-	      for (i = 0; i<ptr->video_size; i++)
-		  ptr->video_buf[i] = (f1[i] + 3*f3[i] + 1)/4;
-	      break;
-      }
-  }
-  return(0);
+static int fr29to23_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       "Max Alekseyev, Tilmann Bitterberg", "VRYE", "1");
+    return TC_OK;
+}
+
+static int fr29to23_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    /* blends each run of five frames into four */
+    if (frame->tag & TC_PRE_S_PROCESS && frame->tag & TC_VIDEO) {
+        return fr29to23_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(fr29to23)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
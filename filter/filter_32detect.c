@@ -22,14 +22,20 @@
  */
 
 #define MOD_NAME    "filter_32detect.so"
-#define MOD_VERSION "v0.2.4 (2003-07-22)"
+#define MOD_VERSION "v0.3.0 (2026-10-18)"
 #define MOD_CAP     "3:2 pulldown / interlace detection plugin"
 #define MOD_AUTHOR  "Thomas Oestreich"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL|TC_MODULE_FLAG_READONLY
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include <stdint.h>
 
@@ -39,59 +45,45 @@
 #define COLOR_DIFF   30
 #define THRESHOLD     9
 
-/* FIXME: these all use the filter ID as an index--the ID can grow
- * arbitrarily large, so this needs to be fixed */
-static int color_diff_threshold1[100];  //=COLOR_EQUAL;
-static int color_diff_threshold2[100];  //=COLOR_DIFF;
-static int chroma_diff_threshold1[100]; //=COLOR_EQUAL/2;
-static int chroma_diff_threshold2[100]; //=COLOR_DIFF/2;
-
-static int force_mode=0;
-static int threshold[100];              //=THRESHOLD;
-static int chroma_threshold[100];       //=THRESHOLD/2;
-static int show_results[100];           //=0;
-
-static int pre[100];	// = 0;
-
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
-
-static inline int sq( int d ) { return d * d; }
-
-static void help_optstr(void)
-{
-    tc_log_info(MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"    This filter checks for interlaced video frames.\n"
-"    Subsequent de-interlacing with transcode can be enforced with 'force_mode' option\n"
-"\n"
-"* Options\n"
-"   'threshold' interlace detection threshold [%d]\n"
-"   'chromathres' interlace detection chroma threshold [%d]\n"
-"   'equal' threshold for equal colors [%d]\n"
-"   'chromaeq' threshold for equal chroma [%d]\n"
-"   'diff' threshold for different colors [%d]\n"
-"   'chromadi' threshold for different colors [%d]\n"
-"   'force_mode' set internal force de-interlace flag with mode -I N [0]\n"
-"   'pre' run as pre filter [1]\n"
-"   'verbose' show results [off]\n"
-		, MOD_CAP,
-		THRESHOLD,
-		THRESHOLD/2,
-		COLOR_EQUAL,
-		COLOR_EQUAL/2,
-		COLOR_DIFF,
-		COLOR_DIFF/2);
-}
-
-static int interlace_test(char *video_buf, int width, int height, int id, int instance, int thres, int eq, int diff)
+static const char detect32_help[] = ""
+    "Overview\n"
+    "    This filter checks for interlaced video frames.\n"
+    "    Subsequent de-interlacing with transcode can be enforced with\n"
+    "    'force_mode' option\n"
+    "Options\n"
+    "    threshold    interlace detection threshold [9]\n"
+    "    chromathres  interlace detection chroma threshold [4]\n"
+    "    equal        threshold for equal colors [10]\n"
+    "    chromaeq     threshold for equal chroma [5]\n"
+    "    diff         threshold for different colors [30]\n"
+    "    chromadi     threshold for different colors [15]\n"
+    "    force_mode   set internal force de-interlace flag with mode -I N [0]\n"
+    "    pre          run as pre filter [1]\n"
+    "    verbose      show results [off]\n";
+
+/*************************************************************************/
+
+typedef struct Detect32PrivateData_ {
+    int codec;
+    int color_diff_threshold1;
+    int color_diff_threshold2;
+    int chroma_diff_threshold1;
+    int chroma_diff_threshold2;
+    int threshold;
+    int chroma_threshold;
+    int force_mode;
+    int show_results;
+    int pre;
+    int id;             /* filter ID, for the results */
+} Detect32PrivateData;
+
+/*************************************************************************/
+
+static int interlace_test(const Detect32PrivateData *pd,
+                          const uint8_t *video_buf, int width, int height,
+                          int id, int thres, int eq, int diff)
 {
-
     int j, n, off, block, cc_1, cc_2, cc, flag;
-
     uint16_t s1, s2, s3, s4;
 
     cc_1 = 0;
@@ -99,28 +91,20 @@ static int interlace_test(char *video_buf, int width, int height, int id, int in
 
     block = width;
 
-    flag = 0;
-
-    for(j=0; j<block; ++j) {
+    for (j = 0; j < block; ++j) {
+        off = 0;
+        for (n = 0; n < (height-4); n = n+2) {
+            s1 = video_buf[off+j        ];
+            s2 = video_buf[off+j+  block];
+            s3 = video_buf[off+j+2*block];
+            s4 = video_buf[off+j+3*block];
 
-	off=0;
+            if ((abs(s1 - s3) < eq) && (abs(s1 - s2) > diff)) ++cc_1;
 
-	for(n=0; n<(height-4); n=n+2) {
+            if ((abs(s2 - s4) < eq) && (abs(s2 - s3) > diff)) ++cc_2;
 
-
-	    s1 = (video_buf[off+j        ] & 0xff);
-	    s2 = (video_buf[off+j+  block] & 0xff);
-	    s3 = (video_buf[off+j+2*block] & 0xff);
-	    s4 = (video_buf[off+j+3*block] & 0xff);
-
-	    if((abs(s1 - s3) < eq) &&
-	       (abs(s1 - s2) > diff)) ++cc_1;
-
-	    if((abs(s2 - s4) < eq) &&
-	       (abs(s2 - s3) > diff)) ++cc_2;
-
-	    off +=2*block;
-	}
+            off += 2*block;
+        }
     }
 
     // compare results
@@ -129,160 +113,273 @@ static int interlace_test(char *video_buf, int width, int height, int id, int in
 
     flag = (cc > thres) ? 1:0;
 
-
-    if(show_results[instance])
+    if (pd->show_results)
         tc_log_info(MOD_NAME, "(%d) frame [%06d]: (1) = %5d | (2) = %5d "
                               "| (3) = %3d | interlaced = %s",
-                              instance, id, cc_1, cc_2, cc,
+                              pd->id, id, cc_1, cc_2, cc,
                               ((flag)?"yes":"no"));
 
-    return(flag);
+    return flag;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
+/*************************************************************************/
 
-  int is_interlaced = 0;
-  int instance = ptr->filter_id;
+/* Module interface routines and data. */
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+/*************************************************************************/
 
+/**
+ * detect32_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-      char buf[255];
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "Thomas", "VRYMEO", "1");
+TC_MODULE_GENERIC_INIT(detect32, Detect32PrivateData)
 
-      tc_snprintf(buf, sizeof(buf), "%d", THRESHOLD);
-      optstr_param (options, "threshold", "Interlace detection threshold", "%d", buf, "0", "255");
+/*************************************************************************/
 
-      tc_snprintf(buf, sizeof(buf), "%d", THRESHOLD/2);
-      optstr_param (options, "chromathres", "Interlace detection chroma threshold", "%d", buf, "0", "255");
+/**
+ * detect32_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-      tc_snprintf(buf, sizeof(buf), "%d", COLOR_EQUAL);
-      optstr_param (options, "equal", "threshold for equal colors", "%d", buf, "0", "255");
+TC_MODULE_GENERIC_FINI(detect32)
 
-      tc_snprintf(buf, sizeof(buf), "%d", COLOR_EQUAL/2);
-      optstr_param (options, "chromaeq", "threshold for equal chroma", "%d", buf, "0", "255");
+/*************************************************************************/
 
-      tc_snprintf(buf, sizeof(buf), "%d", COLOR_DIFF);
-      optstr_param (options, "diff", "threshold for different colors", "%d", buf, "0", "255");
+/**
+ * detect32_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-      tc_snprintf(buf, sizeof(buf), "%d", COLOR_DIFF/2);
-      optstr_param (options, "chromadi", "threshold for different chroma", "%d", buf, "0", "255");
+static int detect32_configure(TCModuleInstance *self,
+                              const char *options,
+                              TCJob *vob,
+                              TCModuleExtraData *xdata[])
+{
+    Detect32PrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    pd->codec                  = vob->im_v_codec;
+    pd->color_diff_threshold1  = COLOR_EQUAL;
+    pd->chroma_diff_threshold1 = COLOR_EQUAL/2;
+    pd->color_diff_threshold2  = COLOR_DIFF;
+    pd->chroma_diff_threshold2 = COLOR_DIFF/2;
+    pd->threshold              = THRESHOLD;
+    pd->chroma_threshold       = THRESHOLD/2;
+    pd->force_mode             = 0;
+    pd->show_results           = 0;
+    pd->pre                    = 1;
+    pd->id                     = self->id;
+
+    if (options != NULL) {
+        if (verbose)
+            tc_log_info(MOD_NAME, "options=%s", options);
+
+        optstr_get(options, "threshold",   "%d", &pd->threshold);
+        optstr_get(options, "chromathres", "%d", &pd->chroma_threshold);
+        optstr_get(options, "force_mode",  "%d", &pd->force_mode);
+        optstr_get(options, "equal",       "%d", &pd->color_diff_threshold1);
+        optstr_get(options, "chromaeq",    "%d", &pd->chroma_diff_threshold1);
+        optstr_get(options, "diff",        "%d", &pd->color_diff_threshold2);
+        optstr_get(options, "chromadi",    "%d", &pd->chroma_diff_threshold2);
+        optstr_get(options, "pre",         "%d", &pd->pre);
+
+        if (optstr_lookup(options, "verbose") != NULL) {
+            pd->show_results = 1;
+        }
+        if (optstr_lookup(options, "help") != NULL) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, detect32_help);
+        }
+    }
+    return TC_OK;
+}
 
-      optstr_param (options, "force_mode", "set internal force de-interlace flag with mode -I N",
-	      "%d", "0", "0", "5");
+/*************************************************************************/
 
-      optstr_param (options, "pre", "run as pre filter", "%d", "1", "0", "1");
-      optstr_param (options, "verbose", "show results", "", "0");
-      return (0);
-  }
+/**
+ * detect32_stop:  Reset this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  if(ptr->tag & TC_FILTER_INIT) {
+static int detect32_stop(TCModuleInstance *self)
+{
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
+}
 
-      if((vob = tc_get_vob())==NULL) return(-1);
+/*************************************************************************/
 
-      color_diff_threshold1[instance]  = COLOR_EQUAL;
-      chroma_diff_threshold1[instance] = COLOR_EQUAL/2;
-      color_diff_threshold2[instance]  = COLOR_DIFF;
-      chroma_diff_threshold2[instance] = COLOR_DIFF/2;
-      threshold[instance]              = THRESHOLD;
-      chroma_threshold[instance]       = THRESHOLD/2;
-      show_results[instance]           = 0;
-      pre[instance]                    = 1;
+/**
+ * detect32_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
-      // filter init ok.
+static int detect32_inspect(TCModuleInstance *self,
+                            const char *param, const char **value)
+{
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-      if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+    if (optstr_lookup(param, "help")) {
+        *value = detect32_help;
+    }
+    return TC_OK;
+}
 
-      // process filter options:
+/*************************************************************************/
 
-      if (options != NULL) {
+/**
+ * detect32_filter_video:  check the given frame for interlacing.  See
+ * tcmodule-data.h for function details.
+ */
 
-	  if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
+static int detect32_filter_video(TCModuleInstance *self,
+                                 vframe_list_t *frame)
+{
+    Detect32PrivateData *pd = NULL;
+    int w, h, is_interlaced = 0;
 
-	  optstr_get (options, "threshold", "%d",  &threshold[instance]);
-	  optstr_get (options, "chromathres", "%d",  &chroma_threshold[instance]);
-	  optstr_get (options, "force_mode", "%d",  &force_mode);
-	  optstr_get (options, "equal", "%d",  &color_diff_threshold1[instance]);
-	  optstr_get (options, "chromaeq", "%d",  &chroma_diff_threshold1[instance]);
-	  optstr_get (options, "diff", "%d",  &color_diff_threshold2[instance]);
-	  optstr_get (options, "chromadi", "%d",  &chroma_diff_threshold2[instance]);
-	  optstr_get (options, "pre", "%d",  &pre[instance]);
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
 
-	  if (optstr_lookup (options, "verbose") != NULL) {
-	      show_results[instance]=1;
-	  }
+    pd = self->userdata;
+    w = frame->v_width;
+    h = frame->v_height;
 
-	  if (optstr_lookup (options, "help") != NULL) {
-	      help_optstr();
-	  }
-      }
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
 
-      return(0);
-  }
+    if (pd->codec == TC_CODEC_RGB24) {
+        is_interlaced = interlace_test(pd, frame->video_buf, 3*w, h,
+                                       frame->id, pd->threshold,
+                                       pd->color_diff_threshold1,
+                                       pd->color_diff_threshold2);
+    } else {
+        is_interlaced += interlace_test(pd, frame->video_buf, w, h,
+                                        frame->id, pd->threshold,
+                                        pd->color_diff_threshold1,
+                                        pd->color_diff_threshold2);
+        is_interlaced += interlace_test(pd, frame->video_buf + w*h,
+                                        w/2, h/2,
+                                        frame->id, pd->chroma_threshold,
+                                        pd->chroma_diff_threshold1,
+                                        pd->chroma_diff_threshold2);
+        is_interlaced += interlace_test(pd, frame->video_buf + w*h*5/4,
+                                        w/2, h/2,
+                                        frame->id, pd->chroma_threshold,
+                                        pd->chroma_diff_threshold1,
+                                        pd->chroma_diff_threshold2);
+    }
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
+    //force de-interlacing?
+    if (pd->force_mode && is_interlaced) {
+        frame->attributes  |= TC_FRAME_IS_INTERLACED;
+        frame->deinter_flag = pd->force_mode;
+    }
+    return TC_OK;
+}
 
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
-    return(0);
-  }
+static const TCCodecID detect32_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID detect32_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(detect32);
+TC_MODULE_FILTER_FORMATS(detect32);
 
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
+TC_MODULE_INFO(detect32);
 
+static const TCModuleClass detect32_class = {
+    TC_MODULE_CLASS_HEAD(detect32),
 
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
+    .init         = detect32_init,
+    .fini         = detect32_fini,
+    .configure    = detect32_configure,
+    .stop         = detect32_stop,
+    .inspect      = detect32_inspect,
 
-  if (!(ptr->tag & TC_VIDEO))
-	  return (0);
+    .filter_video = detect32_filter_video
+};
 
-  //if((ptr->tag & TC_PRE_M_PROCESS) && (ptr->tag & TC_VIDEO))  {
-  if(((ptr->tag & TC_PRE_M_PROCESS  && pre[instance]) ||
-	  (ptr->tag & TC_POST_M_PROCESS && !pre[instance])) && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
+TC_MODULE_ENTRY_POINT(detect32)
 
-    //if (ptr->tag & TC_PRE_M_PROCESS) tc_log_msg(MOD_NAME, "32#%d pre (%d)", instance, ptr->id);
-    //if (ptr->tag & TC_POST_M_PROCESS) tc_log_msg(MOD_NAME, "32#%d post (%d)", instance, ptr->id);
+/*************************************************************************/
 
-    if(vob->im_v_codec==TC_CODEC_RGB24) {
-	is_interlaced = interlace_test(ptr->video_buf, 3*ptr->v_width, ptr->v_height, ptr->id, instance,
-		threshold[instance], color_diff_threshold1[instance], color_diff_threshold2[instance]);
-    } else {
-	is_interlaced += interlace_test(ptr->video_buf, ptr->v_width, ptr->v_height, ptr->id, instance,
-		threshold[instance], color_diff_threshold1[instance], color_diff_threshold2[instance]);
-	is_interlaced += interlace_test(ptr->video_buf+ptr->v_width*ptr->v_height, ptr->v_width/2, ptr->v_height/2, ptr->id, instance,
-		chroma_threshold[instance], chroma_diff_threshold1[instance], chroma_diff_threshold2[instance]);
-	is_interlaced += interlace_test(ptr->video_buf+ptr->v_width*ptr->v_height*5/4, ptr->v_width/2, ptr->v_height/2, ptr->id, instance,
-		chroma_threshold[instance], chroma_diff_threshold1[instance], chroma_diff_threshold2[instance]);
-    }
+static int detect32_get_config(TCModuleInstance *self, char *options)
+{
+    char buf[255];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       "Thomas", "VRYMEO", "1");
+
+    tc_snprintf(buf, sizeof(buf), "%d", THRESHOLD);
+    optstr_param(options, "threshold", "Interlace detection threshold",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", THRESHOLD/2);
+    optstr_param(options, "chromathres",
+                 "Interlace detection chroma threshold",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", COLOR_EQUAL);
+    optstr_param(options, "equal", "threshold for equal colors",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", COLOR_EQUAL/2);
+    optstr_param(options, "chromaeq", "threshold for equal chroma",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", COLOR_DIFF);
+    optstr_param(options, "diff", "threshold for different colors",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", COLOR_DIFF/2);
+    optstr_param(options, "chromadi", "threshold for different chroma",
+                 "%d", buf, "0", "255");
+    optstr_param(options, "force_mode",
+                 "set internal force de-interlace flag with mode -I N",
+                 "%d", "0", "0", "5");
+    optstr_param(options, "pre", "run as pre filter", "%d", "1", "0", "1");
+    optstr_param(options, "verbose", "show results", "", "0");
+    return TC_OK;
+}
 
-    //force de-interlacing?
-    if(force_mode && is_interlaced) {
-	ptr->attributes  |= TC_FRAME_IS_INTERLACED;
-	ptr->deinter_flag = force_mode;
-    }
+static int detect32_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    Detect32PrivateData *pd = NULL;
 
-    //reset
-    is_interlaced=0;
+    TC_MODULE_SELF_CHECK(self, "process");
 
-  }
+    pd = self->userdata;
 
-  return(0);
+    if (!(frame->tag & TC_VIDEO))
+        return TC_OK;
+    if ((frame->tag & TC_PRE_M_PROCESS  && pd->pre)
+     || (frame->tag & TC_POST_M_PROCESS && !pd->pre)) {
+        return detect32_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
 
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(detect32)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -22,35 +22,51 @@
  */
 
 #define MOD_NAME    "filter_32drop.so"
-#define MOD_VERSION "v0.4 (2003-02-01)"
+#define MOD_VERSION "v0.5 (2026-10-18)"
 #define MOD_CAP     "3:2 inverse telecine removal plugin"
 #define MOD_AUTHOR  "Chad Page"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_DELAY|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include <stdint.h>
 
+
+static const char drop32_help[] = ""
+    "Overview\n"
+    "    Removes 3:2 telecine by dropping or merging the interlaced\n"
+    "    frames.  No options.\n";
+
 // basic parameter
-static int color_diff_threshold1=50;
-static int color_diff_threshold2=100;
-static double critical_threshold=0.00005;
+static const int color_diff_threshold1 = 50;
+static const int color_diff_threshold2 = 100;
+static const double critical_threshold = 0.00005;
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
+/*************************************************************************/
 
-// static int sq( int d ) { return d * d; } // unused, EMS
+typedef struct Drop32PrivateData_ {
+    int codec;
+    uint8_t *lastframe;     /* last progressive frame */
+    uint8_t *lastiframe;    /* last interlaced frame */
+    int linum, lfnum;       /* their numbers */
+    int fnum;               /* frames seen so far */
+    int dcnt;               /* drop counter, keeps the sync */
+    int dfnum;              /* frames dropped so far */
+} Drop32PrivateData;
 
-static int interlace_test(char *video_buf, int width, int height, int id, int verbose)
-{
+/*************************************************************************/
 
+static int interlace_test(const uint8_t *video_buf, int width, int height)
+{
     int j, n, off, block, cc_1, cc_2, cc;
-
     uint16_t s1, s2, s3, s4;
 
     cc_1 = 0;
@@ -58,163 +74,276 @@ static int interlace_test(char *video_buf, int width, int height, int id, int ve
 
     block = width;
 
-    for(j=0; j<block; ++j) {
+    for (j = 0; j < block; ++j) {
+        off = 0;
+        for (n = 0; n < (height-4); n = n+2) {
+            s1 = video_buf[off+j        ];
+            s2 = video_buf[off+j+  block];
+            s3 = video_buf[off+j+2*block];
+            s4 = video_buf[off+j+3*block];
 
-	off=0;
+            if ((abs(s1 - s3) < color_diff_threshold1) &&
+                (abs(s1 - s2) > color_diff_threshold2)) ++cc_1;
 
-	for(n=0; n<(height-4); n=n+2) {
+            if ((abs(s2 - s4) < color_diff_threshold1) &&
+                (abs(s2 - s3) > color_diff_threshold2)) ++cc_2;
 
-
-	    s1 = (video_buf[off+j        ] & 0xff);
-	    s2 = (video_buf[off+j+  block] & 0xff);
-	    s3 = (video_buf[off+j+2*block] & 0xff);
-	    s4 = (video_buf[off+j+3*block] & 0xff);
-
-	    if((abs(s1 - s3) < color_diff_threshold1) &&
-	       (abs(s1 - s2) > color_diff_threshold2)) ++cc_1;
-
-	    if((abs(s2 - s4) < color_diff_threshold1) &&
-	       (abs(s2 - s3) > color_diff_threshold2)) ++cc_2;
-
-	    off +=2*block;
-	}
+            off += 2*block;
+        }
     }
 
     // compare results
-
     cc = (((double) (cc_1 + cc_2))/(width*height) > critical_threshold) ? 1:0;
 
-    return(cc);
+    return cc;
 }
 
-static void merge_frames(unsigned char *f1, unsigned char *f2, int width, int height, int pw)
+static void merge_frames(const uint8_t *f1, uint8_t *f2,
+                         int width, int height, int pw)
 {
-	int i;
-	char *cbuf1, *cbuf2;
-
-	/* In YUV, only merge the Y plane, since CrCb planes can't be discerned
-	 * due to the merger.  This lets us also reuse the code for RGB */
-	for (i = 0; i < height; i += 2) {
-		ac_memcpy(&f2[i * width * pw], &f1[i * width * pw], width * pw);
-	}
-
-	/* If we're in YUV mode, the previous frame has the correct color data */
-	if (pw == 1) {
-		cbuf1 = &f1[height * width];
-		cbuf2 = &f2[height * width];
-		ac_memcpy(cbuf2, cbuf1, (height * width / 2));
-	}
+    int i;
+
+    /* In YUV, only merge the Y plane, since CrCb planes can't be discerned
+     * due to the merger.  This lets us also reuse the code for RGB */
+    for (i = 0; i < height; i += 2) {
+        ac_memcpy(&f2[i * width * pw], &f1[i * width * pw], width * pw);
+    }
+
+    /* If we're in YUV mode, the previous frame has the correct color data */
+    if (pw == 1) {
+        ac_memcpy(&f2[height * width], &f1[height * width],
+                  (height * width / 2));
+    }
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
-  static char *lastframe, *lastiframe;
-  static int linum = -1, lfnum = -1, fnum = 0, isint = 0, dcnt = 0, dfnum = 0;
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
+/* Module interface routines and data. */
 
-    optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "Thomas Oestreich", "VRYE", "1");
+/*************************************************************************/
 
-    return 0;
-  }
+/**
+ * drop32_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+TC_MODULE_GENERIC_INIT(drop32, Drop32PrivateData)
 
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_INIT) {
+/**
+ * drop32_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+TC_MODULE_GENERIC_FINI(drop32)
 
-    // filter init ok.
+/*************************************************************************/
 
-    if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+/**
+ * drop32_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    lastframe = tc_malloc(SIZE_RGB_FRAME);
-    lastiframe = tc_malloc(SIZE_RGB_FRAME);
+static int drop32_configure(TCModuleInstance *self,
+                            const char *options,
+                            TCJob *vob,
+                            TCModuleExtraData *xdata[])
+{
+    Drop32PrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    pd->codec = vob->im_v_codec;
+    pd->linum = -1;
+    pd->lfnum = -1;
+    pd->fnum  = 0;
+    pd->dcnt  = 0;
+    pd->dfnum = 0;
+
+    pd->lastframe  = tc_malloc(TC_JOB_FRAME_SIZE(vob));
+    pd->lastiframe = tc_malloc(TC_JOB_FRAME_SIZE(vob));
+    if (!pd->lastframe || !pd->lastiframe) {
+        tc_log_error(MOD_NAME, "can't allocate the frame buffers");
+        tc_free(pd->lastframe);
+        tc_free(pd->lastiframe);
+        pd->lastframe = pd->lastiframe = NULL;
+        return TC_ERROR;
+    }
+    return TC_OK;
+}
 
-    return(0);
-  }
+/*************************************************************************/
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
+/**
+ * drop32_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
 
+static int drop32_stop(TCModuleInstance *self)
+{
+    Drop32PrivateData *pd = NULL;
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
-     free(lastframe);
-     free(lastiframe);
-     return(0);
-  }
+    TC_MODULE_SELF_CHECK(self, "stop");
 
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
+    pd = self->userdata;
+    tc_free(pd->lastframe);
+    tc_free(pd->lastiframe);
+    pd->lastframe = pd->lastiframe = NULL;
+    return TC_OK;
+}
 
+/*************************************************************************/
 
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
+/**
+ * drop32_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
-  if((ptr->tag & TC_PRE_M_PROCESS) && (ptr->tag & TC_VIDEO))  {
+static int drop32_inspect(TCModuleInstance *self,
+                          const char *param, const char **value)
+{
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-    if(vob->im_v_codec==TC_CODEC_RGB24) {
-      isint = interlace_test(ptr->video_buf, 3*ptr->v_width, ptr->v_height, ptr->id, 1);
-    } else {
-      isint = interlace_test(ptr->video_buf, ptr->v_width, ptr->v_height, ptr->id, 1);
+    if (optstr_lookup(param, "help")) {
+        *value = drop32_help;
     }
+    return TC_OK;
+}
 
-    //tc_log_msg(MOD_NAME, "%d %d", fnum, dcnt);
+/*************************************************************************/
+
+/**
+ * drop32_filter_video:  drop or repair the interlaced frames.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int drop32_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    Drop32PrivateData *pd = NULL;
+    int isint = 0, pw = 1;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+    if (pd->codec == TC_CODEC_RGB24)
+        pw = 3;
+
+    isint = interlace_test(frame->video_buf, pw * frame->v_width,
+                           frame->v_height);
 
     if (isint) {
- 	linum = fnum;
-
-	/* If this is the second interlaced frame in a row, do a copy of the
-	 * bottom field of the previous frame.
-	 */
-
-	if ((fnum - lfnum) == 2) {
-	    merge_frames(lastiframe, ptr->video_buf, ptr->v_width, ptr->v_height, ((vob->im_v_codec == TC_CODEC_RGB24) ? 3:1) );
-	} else {
-          ac_memcpy(lastiframe, ptr->video_buf, ptr->video_size);
-	  /* The use of the drop counter ensures syncronization even with
-	   * video-based sources.  */
-	  if (dcnt < 8) {
-	      ptr->attributes |= TC_FRAME_IS_SKIPPED;
-	      dcnt += 5;
-	      dfnum++;
-	   } else {
-	       /* If we'd lose sync by dropping, copy the last frame in.
-	        * If there are more than 3 interlaced frames in a row, it's
-	        * probably video and we don't want to copy the last frame over */
-	       if (((fnum - lfnum) < 3) && fnum)
-		   ac_memcpy(ptr->video_buf, lastframe, ptr->video_size);
-	   }
-	}
+        pd->linum = pd->fnum;
+
+        /* If this is the second interlaced frame in a row, do a copy of the
+         * bottom field of the previous frame.
+         */
+        if ((pd->fnum - pd->lfnum) == 2) {
+            merge_frames(pd->lastiframe, frame->video_buf,
+                         frame->v_width, frame->v_height, pw);
+        } else {
+            ac_memcpy(pd->lastiframe, frame->video_buf, frame->video_size);
+            /* The use of the drop counter ensures syncronization even with
+             * video-based sources.  */
+            if (pd->dcnt < 8) {
+                frame->attributes |= TC_FRAME_IS_SKIPPED;
+                pd->dcnt += 5;
+                pd->dfnum++;
+            } else {
+                /* If we'd lose sync by dropping, copy the last frame in.
+                 * If there are more than 3 interlaced frames in a row,
+                 * it's probably video and we don't want to copy the last
+                 * frame over */
+                if (((pd->fnum - pd->lfnum) < 3) && pd->fnum)
+                    ac_memcpy(frame->video_buf, pd->lastframe,
+                              frame->video_size);
+            }
+        }
     } else {
-        ac_memcpy(lastframe, ptr->video_buf, ptr->video_size);
-        lfnum = fnum;
+        ac_memcpy(pd->lastframe, frame->video_buf, frame->video_size);
+        pd->lfnum = pd->fnum;
     }
-    /* If we're dealing with a non-interlaced source, or close to it, it won't
-     * drop enough interlaced frames, so drop here to keep sync */
-    if (dcnt <= -5) {
-	 ptr->attributes |= TC_FRAME_IS_SKIPPED;
-	 dcnt += 5;
-	dfnum++;
+    /* If we're dealing with a non-interlaced source, or close to it, it
+     * won't drop enough interlaced frames, so drop here to keep sync */
+    if (pd->dcnt <= -5) {
+        frame->attributes |= TC_FRAME_IS_SKIPPED;
+        pd->dcnt += 5;
+        pd->dfnum++;
     }
-    fnum++;
-    dcnt--;
-  }
+    pd->fnum++;
+    pd->dcnt--;
 
-  return(0);
+    return TC_OK;
 }
 
+/*************************************************************************/
+
+static const TCCodecID drop32_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID drop32_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(drop32);
+TC_MODULE_FILTER_FORMATS(drop32);
+
+TC_MODULE_INFO(drop32);
+
+static const TCModuleClass drop32_class = {
+    TC_MODULE_CLASS_HEAD(drop32),
+
+    .init         = drop32_init,
+    .fini         = drop32_fini,
+    .configure    = drop32_configure,
+    .stop         = drop32_stop,
+    .inspect      = drop32_inspect,
+
+    .filter_video = drop32_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(drop32)
+
+/*************************************************************************/
+
+static int drop32_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       "Thomas Oestreich", "VRYE", "1");
+    return TC_OK;
+}
+
+static int drop32_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    if ((frame->tag & TC_PRE_M_PROCESS) && (frame->tag & TC_VIDEO)) {
+        return drop32_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(drop32)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -22,139 +22,280 @@
  */
 
 #define MOD_NAME    "filter_aclip.so"
-#define MOD_VERSION "v0.1.1 (2003-09-04)"
+#define MOD_VERSION "v0.2.0 (2026-10-18)"
 #define MOD_CAP     "generate audio clips from source"
 #define MOD_AUTHOR  "Thomas Oestreich"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_AUDIO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_READONLY
+
 #include "src/transcode.h"
 #include "src/filter.h"
+#include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include <math.h>
 
 
-static uint64_t total=0;
+static const char aclip_help[] = ""
+    "Overview\n"
+    "    Skips the audio frames quieter than a given level, keeping\n"
+    "    `range' of them after each loud one.\n"
+    "Options\n"
+    "    level  The audio must be under this level to be skipped [10]\n"
+    "    range  Number of samples over level will be keyframes [25]\n";
 
-static int level=10, range=25, range_ctr=0, skip_mode=0;
+/*************************************************************************/
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
+typedef struct AClipPrivateData_ {
+    int level;
+    int range;
+    int range_ctr;
+    int skip_mode;
+    uint64_t total;
+
+    char opt_buf[TC_BUF_MIN];
+} AClipPrivateData;
 
-static int is_optstr(char *a)
+/*************************************************************************/
+
+static int is_optstr(const char *a)
 {
     if (strchr(a, '=')) return 1;
     if (strchr(a, 'h')) return 1;
     return 0;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  aframe_list_t *ptr = (aframe_list_t *)ptr_;
-  int n;
-  double sum;
+/*************************************************************************/
 
-  short *s;
+/* Module interface routines and data. */
 
-  vob_t *vob=NULL;
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "Thomas Oestreich", "AE", "1");
-      optstr_param (options, "level", "The audio must be under this level to be skipped", "%d", "10", "0", "255");
-      optstr_param (options, "range", "Number of samples over level will be keyframes", "%d", "25", "0", "255");
-      return 0;
-  }
+/**
+ * aclip_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+TC_MODULE_GENERIC_INIT(aclip, AClipPrivateData)
 
-  if(ptr->tag & TC_FILTER_INIT) {
+/*************************************************************************/
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+/**
+ * aclip_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    // filter init ok.
+TC_MODULE_GENERIC_FINI(aclip)
 
-    if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+/*************************************************************************/
 
-    if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
+/**
+ * aclip_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    if(options!=NULL) {
-	if (!is_optstr(options)) {
-	    n=sscanf(options,"%d:%d", &level, &range);
-	} else {
-	    optstr_get (options, "level", "%d", &level);
-	    optstr_get (options, "range", "%d", &range);
-	}
+static int aclip_configure(TCModuleInstance *self,
+                           const char *options,
+                           TCJob *vob,
+                           TCModuleExtraData *xdata[])
+{
+    AClipPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+    pd->level     = 10;
+    pd->range     = 25;
+    pd->skip_mode = 0;
+    pd->total     = 0;
+
+    if (verbose)
+        tc_log_info(MOD_NAME, "options=%s", options);
+
+    if (options != NULL) {
+        if (!is_optstr(options)) {
+            sscanf(options, "%d:%d", &pd->level, &pd->range);
+        } else {
+            optstr_get(options, "level", "%d", &pd->level);
+            optstr_get(options, "range", "%d", &pd->range);
+        }
     }
 
-    range_ctr=range;
+    pd->range_ctr = pd->range;
 
-    return(0);
-  }
+    return TC_OK;
+}
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
+/**
+ * aclip_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
 
-    return(0);
-  }
+static int aclip_stop(TCModuleInstance *self)
+{
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
+}
+
+/*************************************************************************/
 
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
+/**
+ * aclip_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
-  if(verbose & TC_STATS)
-    tc_log_info(MOD_NAME, "%s/%s %s %s",
-                vob->mod_path, MOD_NAME, MOD_VERSION, MOD_CAP);
+static int aclip_inspect(TCModuleInstance *self,
+                         const char *param, const char **value)
+{
+    AClipPrivateData *pd = NULL;
 
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-  if(ptr->tag & TC_PRE_S_PROCESS && ptr->tag & TC_AUDIO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
+    pd = self->userdata;
 
-    total += (uint64_t) ptr->audio_size;
+    if (optstr_lookup(param, "help")) {
+        *value = aclip_help;
+    }
+    if (optstr_lookup(param, "level")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->level);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "range")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->range);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
 
-    s=(short *) ptr->audio_buf;
+/*************************************************************************/
 
-    sum=0;
+/**
+ * aclip_filter_audio:  skip the given frame if it is too quiet.  See
+ * tcmodule-data.h for function details.
+ */
 
-    for(n=0; n<ptr->audio_size>>1; ++n) {
-      sum+=(double) ((int)(*s) * (int)(*s));
-      s++;
-    }
+static int aclip_filter_audio(TCModuleInstance *self, aframe_list_t *frame)
+{
+    AClipPrivateData *pd = NULL;
+    double sum = 0;
+    short *s = NULL;
+    int n;
 
-    if(ptr->audio_size>0) sum = sqrt(sum)/(ptr->audio_size>>1);
+    TC_MODULE_SELF_CHECK(self, "filter_audio");
+    TC_MODULE_SELF_CHECK(frame, "filter_audio");
 
-    sum *= 1000;
+    pd = self->userdata;
 
-    if(verbose & TC_DEBUG) tc_log_info(MOD_NAME, "frame=%d sum=%f", ptr->id, sum);
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
 
-    if(sum<level) {
+    pd->total += (uint64_t)frame->audio_size;
 
-      if(range_ctr == range) {
+    s = (short *)frame->audio_buf;
+    for (n = 0; n < frame->audio_size >> 1; ++n) {
+        sum += (double)((int)(*s) * (int)(*s));
+        s++;
+    }
+    if (frame->audio_size > 0)
+        sum = sqrt(sum) / (frame->audio_size >> 1);
+    sum *= 1000;
 
-	ptr->attributes |= TC_FRAME_IS_SKIPPED;
-	skip_mode=1;
-      } else ++range_ctr;
+    if (verbose & TC_DEBUG)
+        tc_log_info(MOD_NAME, "frame=%d sum=%f", frame->id, sum);
 
+    if (sum < pd->level) {
+        if (pd->range_ctr == pd->range) {
+            frame->attributes |= TC_FRAME_IS_SKIPPED;
+            pd->skip_mode = 1;
+        } else {
+            ++pd->range_ctr;
+        }
     } else {
+        if (pd->skip_mode)
+            frame->attributes |= TC_FRAME_IS_KEYFRAME;
+        pd->skip_mode = 0;
+        pd->range_ctr = 0;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID aclip_codecs_audio_in[] = {
+    TC_CODEC_PCM, TC_CODEC_ERROR
+};
+static const TCCodecID aclip_codecs_audio_out[] = {
+    TC_CODEC_PCM, TC_CODEC_ERROR
+};
+TC_MODULE_VIDEO_UNSUPPORTED(aclip);
+TC_MODULE_FILTER_FORMATS(aclip);
+
+TC_MODULE_INFO(aclip);
 
-      if(skip_mode) ptr->attributes |= TC_FRAME_IS_KEYFRAME;
-      skip_mode = 0;
-      range_ctr = 0;
+static const TCModuleClass aclip_class = {
+    TC_MODULE_CLASS_HEAD(aclip),
+
+    .init         = aclip_init,
+    .fini         = aclip_fini,
+    .configure    = aclip_configure,
+    .stop         = aclip_stop,
+    .inspect      = aclip_inspect,
+
+    .filter_audio = aclip_filter_audio
+};
+
+TC_MODULE_ENTRY_POINT(aclip)
+
+/*************************************************************************/
+
+static int aclip_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "AE", "1");
+    optstr_param(options, "level",
+                 "The audio must be under this level to be skipped",
+                 "%d", "10", "0", "255");
+    optstr_param(options, "range",
+                 "Number of samples over level will be keyframes",
+                 "%d", "25", "0", "255");
+    return TC_OK;
+}
+
+static int aclip_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    /* counts the frames since the last loud one */
+    if (frame->tag & TC_PRE_S_PROCESS && frame->tag & TC_AUDIO) {
+        return aclip_filter_audio(self, (aframe_list_t*)frame);
     }
-  }
-  return(0);
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(aclip)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -22,365 +22,432 @@
  *
  */
 
-#define MOD_NAME    		"filter_ascii.so"
-#define MOD_VERSION 		"v0.5 (2004-12-08)"
-#define MOD_CAP     		"Colored ascii-art filter plugin; render a movie into ascii-art."
-#define MOD_AUTHOR		"Julien Tierny"
+#define MOD_NAME    "filter_ascii.so"
+#define MOD_VERSION "v0.6 (2026-10-18)"
+#define MOD_CAP     "Colored ascii-art filter plugin; render a movie into ascii-art."
+#define MOD_AUTHOR  "Julien Tierny"
+
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL
 
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 /* For RGB->YUV conversion */
 #include "libtcvideo/tcvideo.h"
 
-#define MAX_LENGTH 		1024
-#define TMP_FILE		"raw"
-#define TMP_STRING_SIZE		7
+#define MAX_LENGTH      1024
+#define TMP_FILE        "raw"
+
+
+static const char ascii_help[] = ""
+    "Overview\n"
+    "    This filter renders a video sample into colored ascii art, using\n"
+    "    the `aart` package.  Both YUV and RGB formats are supported, in\n"
+    "    multithreaded mode.\n"
+    "Warning\n"
+    "    Rendering a video sample into colored ascii art might take a VERY\n"
+    "    LONG TIME for the moment.  Please only consider short video\n"
+    "    samples for this very version of the filter.\n"
+    "Options\n"
+    "    font     Valid PSF font file (provided with the `aart` package)\n"
+    "    pallete  Valid PAL pallete file (provided with the `aart` package)\n"
+    "    threads  Use multiple-threaded routine for picture rendering\n"
+    "             (recommended = 1)\n"
+    "    buffer   Use `aart` internal buffer for output (recommended off)\n";
+
+/*************************************************************************/
+
+typedef struct AsciiPrivateData_ {
+    char aart_font[PATH_MAX];
+    char aart_pallete[PATH_MAX];
+    int aart_threads;
+    int aart_buffer;
+    int id;
+    /* only converts between distinct buffers: no state in the handle */
+    TCVHandle tcvhandle;
+} AsciiPrivateData;
+
+/*************************************************************************/
+
+/* Each frame goes through its own temporary file, named after the filter
+ * instance and the frame, so frames can be rendered concurrently. */
+
+static int write_tmpfile(const char *filename, const char *header,
+                         const uint8_t *content, int content_size)
+{
+    FILE *tmp = fopen(filename, "w");
+
+    if (!tmp) {
+        tc_log_error(MOD_NAME, "Cannot write temporary file !");
+        return -1;
+    }
+    fputs(header, tmp);
+    fwrite(content, 1, content_size, tmp);
+    fclose(tmp);
+    return 0;
+}
 
+static int parse_stream_header(FILE *stream, int width)
+{
+    int cursor = 0;
+    int aart_width = 0;
+
+    /* Purge the first line of the header */
+    while (cursor != '\n' && cursor != EOF)
+        cursor = fgetc(stream);
+
+    /* Purge additionnal commentary lines */
+    while (cursor == '#')
+        while ((cursor = fgetc(stream)) != '\n' && cursor != EOF);
+    cursor = fgetc(stream);
+
+    /* Purge dimensions line */
+    while (cursor != ' ' && cursor != EOF) {
+        /* We have to check the width in case of re-size */
+        aart_width = 10*aart_width + (cursor - '0');
+        cursor = fgetc(stream);
+    }
+    if ((aart_width != width) && (verbose & TC_DEBUG))
+        tc_log_warn(MOD_NAME, "Picture has been re-sized by `aart`.");
+
+    /* Purge the rest of the line */
+    while (cursor != '\n' && cursor != EOF)
+        cursor = fgetc(stream);
+
+    cursor = fgetc(stream);
+
+    /* Purge dynamic line */
+    while (cursor != '\n' && cursor != EOF)
+        cursor = fgetc(stream);
+
+    return aart_width;
+}
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
+static int aart_render(const AsciiPrivateData *pd, uint8_t *buffer,
+                       int width, int height, int frame_id)
+{
+    char pnm_header[255] = "";
+    char cmd_line[MAX_LENGTH] = "";
+    char filename[PATH_MAX] = "";
+    FILE *aart_output = NULL;
+    int i = 0, j = 0, resize = 0, size = width*height*3;
+
+    tc_snprintf(filename, sizeof(filename), "%s-%d-%d.tmp",
+                TMP_FILE, pd->id, frame_id);
+    tc_snprintf(cmd_line, sizeof(cmd_line),
+                "aart %s --font %s --pallete %s --inmod=pnm --outmod=pnm"
+                " %s --threads=%d",
+                filename, pd->aart_font, pd->aart_pallete,
+                (pd->aart_buffer != 1) ?"--nobuffer" :"",
+                pd->aart_threads);
+    tc_snprintf(pnm_header, sizeof(pnm_header), "P6\n%d %d\n255\n",
+                width, height);
+
+    if (write_tmpfile(filename, pnm_header, buffer, size) == -1)
+        return -1;
+
+    aart_output = popen(cmd_line, "r");
+    if (!aart_output) {
+        tc_log_error(MOD_NAME, "`aart` call failure !");
+        remove(filename);
+        return -1;
+    }
+
+    resize = parse_stream_header(aart_output, width);
+
+    /* Now, let's fill the buffer */
+    for (i = 0; i < size; i++) {
+        if (j == width*3) {
+            /* We reached an end of row and skip aart additionnal pixels */
+            for (j = 0; j < 3*(resize - width); j++)
+                fgetc(aart_output);
+            j = 0;
+        }
+        buffer[i] = fgetc(aart_output);
+        j++;
+    }
+
+    pclose(aart_output);
+    remove(filename);
+    return 0;
+}
 
+static void clean_parameter(char *parameter)
+{
+    /* Purges extra character from parameter string */
+    char *eq = strchr(parameter, '=');
 
-typedef struct parameter_struct{
-	char	aart_font[PATH_MAX];
-	char	aart_pallete[PATH_MAX];
-	int	aart_threads;
-	int	aart_buffer;
-	TCVHandle tcvhandle;
-} parameter_struct;
+    if (eq)
+        *eq = '\0';
+}
 
-static parameter_struct *parameters = NULL;
+/*************************************************************************/
 
-static void help_optstr(void)
-{
-    tc_log_info(MOD_NAME, "(%s) help\n"
-"\n* Overview:\n"
-"  This filter renders a video sample into colored ascii art, using the `aart` package.\n"
-"  Both YUV and RGB formats are supported, in multithreaded mode.\n"
-"\n* Warning:\n"
-"  Rendering a video sample into colored ascii art might take a VERY LONG TIME for the moment.\n"
-"  Please only consider short video samples for this very version of the filter.\n"
-"\n"
-"* Options:\n"
-"  'font':    Valid PSF font file (provided with the `aart` package)\n"
-"  'pallete': Valid PAL pallete file (provided with the `aart` package)\n"
-"  'threads': Use multiple-threaded routine for picture rendering (recommended = 1)\n"
-"  'buffer':  Use `aart` internal buffer for output (recommended off)\n"
-		, MOD_CAP);
-}
+/* Module interface routines and data. */
 
-static int write_tmpfile(char* header, char* content, int content_size, int slot_id){
-	FILE* 	tmp = NULL;
-	int 	i = 0;
-	char*	filename = NULL;
-
-	filename = tc_malloc(sizeof(char)*(strlen(TMP_FILE) + TMP_STRING_SIZE));
-	if (!filename){
-		tc_log_error(MOD_NAME, "Out of memory !!!");
-		return -1;
-	}
-
-	if (verbose & TC_DEBUG)
-		tc_log_info(MOD_NAME, "Temporary filename correctly allocated.");
-	tc_snprintf(filename, strlen(TMP_FILE) + TMP_STRING_SIZE, "%s-%d.tmp", TMP_FILE, slot_id);
-
-	tmp = fopen(filename, "w");
-	if (!tmp){
-		tc_log_error(MOD_NAME, "Cannot write temporary file !");
-		return -1;
-	}
-	for(i=0; i<strlen(header); i++)
-		fputc(header[i], tmp);
-
-	for(i=0; i< content_size; i++)
-		fputc(content[i], tmp);
-
-	fclose(tmp);
-	free(filename);
-	return 0;
-}
+/*************************************************************************/
 
-static int parse_stream_header(FILE* stream, int width){
-	char	cursor = 0;
-	int		aart_width = 0;
+/**
+ * ascii_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-	/* Purge the first line of the header */
-	while (cursor!='\n')
-		cursor = fgetc(stream);
+TC_MODULE_GENERIC_INIT(ascii, AsciiPrivateData)
 
-	/* Purge additionnal commentary lines */
-	while (cursor == '#')
-		while ((cursor = fgetc(stream)) != '\n');
-	cursor = fgetc(stream);
+/*************************************************************************/
 
-	/* Purge dimensions line */
-	while (cursor!=' '){
-		/* We have to check the width in case of re-size */
-		aart_width = 10*aart_width + ((int) cursor - 48);
-		cursor = fgetc(stream);
-	}
-	if ((aart_width != width) && (verbose & TC_DEBUG))
-		tc_log_warn(MOD_NAME, "Picture has been re-sized by `aart`.");
+/**
+ * ascii_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-	/* Purge the rest of the line */
-	while (cursor!='\n')
-		cursor = fgetc(stream);
+TC_MODULE_GENERIC_FINI(ascii)
 
-	cursor = fgetc(stream);
+/*************************************************************************/
 
-	/* Purge dynamic line */
-	while (cursor!='\n')
-		cursor = fgetc(stream);
+/**
+ * ascii_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-	return aart_width;
+static int ascii_configure(TCModuleInstance *self,
+                           const char *options,
+                           TCJob *vob,
+                           TCModuleExtraData *xdata[])
+{
+    AsciiPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    /* aart sanity check */
+    if (tc_test_program("aart") != 0)
+        return TC_ERROR;
+
+    /* Filter default options */
+    strlcpy(pd->aart_font, "default8x9.psf", sizeof(pd->aart_font));
+    strlcpy(pd->aart_pallete, "colors.pal", sizeof(pd->aart_pallete));
+    pd->aart_threads = 1;
+    pd->aart_buffer  = -1;
+    pd->tcvhandle    = NULL;
+    pd->id           = self->id;
+
+    if (options) {
+        optstr_get(options, "font",    "%[^:]", pd->aart_font);
+        clean_parameter(pd->aart_font);
+        optstr_get(options, "pallete", "%[^:]", pd->aart_pallete);
+        clean_parameter(pd->aart_pallete);
+        optstr_get(options, "threads", "%d",    &pd->aart_threads);
+
+        if (optstr_lookup(options, "buffer") != NULL)
+            pd->aart_buffer = 1;
+        if (optstr_lookup(options, "help") != NULL)
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, ascii_help);
+    }
+
+    if (vob->im_v_codec == TC_CODEC_YUV420P) {
+        pd->tcvhandle = tcv_init();
+        if (!pd->tcvhandle) {
+            tc_log_error(MOD_NAME,
+                         "Error at image conversion initialization.");
+            return TC_ERROR;
+        }
+    }
+    return TC_OK;
 }
 
-static int aart_render(char* buffer, int width, int height, int slot_id, char* font, char* pallete, int threads, int buffer_option){
-	char 	pnm_header[255] = "",
-			cmd_line[MAX_LENGTH] = "",
-			buffer_option_string[PATH_MAX] = "";
-	FILE* 	aart_output = NULL;
-	int		i = 0,
-			j = 0,
-			resize = 0;
-
-	if (verbose & TC_DEBUG)
-		tc_log_info(MOD_NAME, "Formating buffer option string.");
-	if (buffer_option != 1)
-		tc_snprintf(buffer_option_string, strlen("--nobuffer"), "--nobuffer");
-	if (verbose & TC_DEBUG)
-		tc_log_info(MOD_NAME, "Buffer option string correctly formated.");
-
-
-	tc_snprintf(cmd_line, MAX_LENGTH, "aart %s-%d.tmp --font %s --pallete %s --inmod=pnm --outmod=pnm %s --threads=%d", TMP_FILE, slot_id, font, pallete, buffer_option_string, threads);
-
-	tc_snprintf(pnm_header, 255, "P6\n%d %d\n255\n", width, height);
-
-	if (write_tmpfile(pnm_header, buffer, width*height*3, slot_id) == -1)
-		return -1;
-
-	if (!(aart_output = popen(cmd_line, "r"))){
-		tc_log_error(MOD_NAME, "`aart` call failure !");
-		return -1;
-	}
-
-	resize = parse_stream_header(aart_output, width);
-
-	/* Now, let's fill the buffer */
-	for (i=0; i<=(width*height*3); i++){
-		if (j == width*3){
-			/* We reached an end of row and skip aart additionnal pixels */
-			for (j=0; j< 3*(resize - width); j++)
-				fgetc(aart_output);
-			j = 0;
-		}
-		buffer[i] = fgetc(aart_output);
-		j++;
-	}
-
-	pclose(aart_output);
-	return 0;
-}
+/*************************************************************************/
 
-static int clean_parameter(char* parameter){
-	/* Purges extra character from parameter string */
-	int i=0;
-
-	while (parameter[i] != '\0'){
-		if (parameter[i] == '=') parameter[i] = '\0';
-		i++;
-	}
-	if (verbose & TC_DEBUG)
-		tc_log_info(MOD_NAME, "Extra-paramater correctly cleaned.");
-	return 0;
+/**
+ * ascii_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int ascii_stop(TCModuleInstance *self)
+{
+    AsciiPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+
+    /*
+     * TODO :
+     * Provide a `aart` kill routine in case of cancel.
+     * For the moment, transcode waits for the `aart`
+     * process to finish before exiting.
+     */
+    if (pd->tcvhandle) {
+        tcv_free(pd->tcvhandle);
+        pd->tcvhandle = NULL;
+    }
+    return TC_OK;
 }
 
-static int init_slots(int slots[]){
-	int i = 0;
-	for (i=0; i<TC_FRAME_THREADS_MAX; i++)
-		slots[i] = 0;
-	return 0;
+/*************************************************************************/
+
+/**
+ * ascii_inspect:  Return the value of an option in this instance of the
+ * module.  See tcmodule-data.h for function details.
+ */
+
+static int ascii_inspect(TCModuleInstance *self,
+                         const char *param, const char **value)
+{
+    AsciiPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = ascii_help;
+    }
+    if (optstr_lookup(param, "font")) {
+        *value = pd->aart_font;
+    }
+    if (optstr_lookup(param, "pallete")) {
+        *value = pd->aart_pallete;
+    }
+    return TC_OK;
 }
 
-static int find_empty_slot(int frame_id, int *slots){
-	int i = 0;
-	while((slots[i]!=0)&&(i<TC_FRAME_THREADS_MAX))
-		i++;
-	if (i<TC_FRAME_THREADS_MAX)
-		slots[i] = frame_id;
-	if (verbose & TC_DEBUG)
-		tc_log_info(MOD_NAME, "Found empty slot %d for frame %d.", i, frame_id);
-	return i;
+/*************************************************************************/
+
+/**
+ * ascii_filter_video:  render the given frame into ascii art.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int ascii_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    AsciiPrivateData *pd = NULL;
+    uint8_t *rgb = NULL;
+    int ret, size;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+
+    if (!pd->tcvhandle) {
+        return aart_render(pd, frame->video_buf, frame->v_width,
+                           frame->v_height, frame->id);
+    }
+
+    size = frame->v_width * frame->v_height * 3;
+    rgb = tc_malloc(size);
+    if (!rgb) {
+        tc_log_error(MOD_NAME, "Out of memory !!!");
+        return TC_ERROR;
+    }
+    ret = TC_ERROR;
+    if (!tcv_convert(pd->tcvhandle, frame->video_buf, rgb,
+                     frame->v_width, frame->v_height,
+                     IMG_YUV_DEFAULT, IMG_RGB24)) {
+        tc_log_error(MOD_NAME, "cannot convert YUV stream to RGB format !");
+    } else if (aart_render(pd, rgb, frame->v_width, frame->v_height,
+                           frame->id) == 0) {
+        if (!tcv_convert(pd->tcvhandle, rgb, frame->video_buf,
+                         frame->v_width, frame->v_height,
+                         IMG_RGB24, IMG_YUV_DEFAULT)) {
+            tc_log_error(MOD_NAME,
+                         "cannot convert RGB stream to YUV format !");
+        } else {
+            ret = TC_OK;
+        }
+    }
+    tc_free(rgb);
+    return ret;
 }
 
-static int free_slot(int frame_id, int *slots){
-	int i = 0;
-	while ((slots[i]!=frame_id)&&(i<TC_FRAME_THREADS_MAX))
-		i++;
-	/*
-	 * TODO:
-	 * Provide a pthread_mutex lock system.
-	 * Right now, 2 threads might be able to write
-	 * in the same slot (case never encountered so far),
-	 * which would cause issues at free step.
-	 */
-	if (i<TC_FRAME_THREADS_MAX)
-		slots[i] = 0;
-	if (verbose & TC_DEBUG)
-		tc_log_info(MOD_NAME, "Slot %d correctly free.", i);
-	return 0;
+/*************************************************************************/
+
+static const TCCodecID ascii_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID ascii_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(ascii);
+TC_MODULE_FILTER_FORMATS(ascii);
+
+TC_MODULE_INFO(ascii);
+
+static const TCModuleClass ascii_class = {
+    TC_MODULE_CLASS_HEAD(ascii),
+
+    .init         = ascii_init,
+    .fini         = ascii_fini,
+    .configure    = ascii_configure,
+    .stop         = ascii_stop,
+    .inspect      = ascii_inspect,
+
+    .filter_video = ascii_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(ascii)
+
+/*************************************************************************/
+
+static int ascii_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRYMO", "1");
+    optstr_param(options, "font", "Valid PSF font file"
+                 " (provided with the `aart` package)",
+                 "%s", "default8x9.psf");
+    optstr_param(options, "pallete", "Valid pallete file"
+                 " (provided with the `aart` package)",
+                 "%s", "colors.pal");
+    optstr_param(options, "threads",
+                 "Use multiple-threaded routine for picture rendering",
+                 "%d", "0", "1", "oo");
+    /* Boolean parameter */
+    optstr_param(options, "buffer", "Use `aart` internal buffer for output",
+                 "", "-1");
+    return TC_OK;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options){
-	vframe_list_t *		ptr = (vframe_list_t *)ptr_;
-	int 			frame_slot = 0;
-	static 			vob_t *vob=NULL;
-	static int		slots[TC_FRAME_THREADS_MAX];
-
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-
-	optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "Julien Tierny", "VRYMO", "1");
-    optstr_param (options, "font", "Valid PSF font file (provided with the `aart` package)", "%s", "default8x9.psf");
-	optstr_param (options, "pallete", "Valid pallete file (provided with the `aart` package)", "%s", "colors.pal");
-	optstr_param(options, "threads", "Use multiple-threaded routine for picture rendering", "%d", "0", "1", "oo");
-
-	/* Boolean parameter */
-	optstr_param(options, "buffer", "Use `aart` internal buffer for output", "", "-1");
-
-	return 0;
-  }
-
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
-
-
-  if(ptr->tag & TC_FILTER_INIT) {
-
-    if((vob = tc_get_vob())==NULL)
-		return(-1);
-
-	/* aart sanity check */
-	if (tc_test_program("aart") !=0 )
-		return -1;
-
-	/* Now, let's handle the options ... */
-	if((parameters = tc_malloc (sizeof(parameter_struct))) == NULL){
-		tc_log_error(MOD_NAME, "Out of memory !!!");
-		return -1;
-	}
-
-	/* Filter default options */
-	if (verbose & TC_DEBUG)
-		tc_log_info(MOD_NAME, "Preparing default options.");
-	strncpy(parameters->aart_font, "default8x9.psf", strlen("default8x9.psf"));
-	if (verbose & TC_DEBUG)
-		tc_log_info(MOD_NAME, "Default options correctly formated.");
-	strncpy(parameters->aart_pallete, "colors.pal", strlen("colors.pal"));
-	parameters->aart_threads 		= 1;
-	parameters->aart_buffer 		= -1;
-	parameters->tcvhandle			= 0;
-
-	if (options){
-		/* Get filter options via transcode core */
-		if (verbose & TC_DEBUG)
-			tc_log_info(MOD_NAME, "Merging options from transcode.");
-		optstr_get(options, "font",			"%s",		parameters->aart_font);
-		clean_parameter(parameters->aart_font);
-		optstr_get(options, "pallete",		"%s",		parameters->aart_pallete);
-		clean_parameter(parameters->aart_pallete);
-		optstr_get(options, "threads",   	"%d",		&parameters->aart_threads);
-
-		if (optstr_lookup(options, "buffer") != NULL)
-			parameters->aart_buffer=1;
-		if (optstr_lookup(options, "help") != NULL)
-			help_optstr();
-		if (verbose & TC_DEBUG)
-			tc_log_info(MOD_NAME, "Options correctly merged.");
-	}
-
-	if (vob->im_v_codec == TC_CODEC_YUV420P){
-		if (!(parameters->tcvhandle = tcv_init())) {
-			tc_log_error(MOD_NAME, "Error at image conversion initialization.");
-			return(-1);
-		}
-	}
-
-	/* Init thread slots (multithread support)*/
-	init_slots(slots);
-
-	if(verbose)
-		tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-
-    return(0);
-  }
-
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
-
-
-  if(ptr->tag & TC_FILTER_CLOSE) {
-
-  	/*
-	 * TODO :
-	 * Provide a `aart` kill routine in case of cancel.
-	 * For the moment, transcode waits for the `aart`
-	 * process to finish before exiting.
-	 */
-
-	tcv_free(parameters->tcvhandle);
-
-	/* Let's free the parameter structure */
-	free(parameters);
-	parameters = NULL;
-
-    return(0);
-  }
-
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
-
-	if(ptr->tag & TC_POST_M_PROCESS && ptr->tag & TC_VIDEO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
-
-		frame_slot = find_empty_slot(ptr->id, slots);
-		switch(vob->im_v_codec){
-			case TC_CODEC_RGB24:
-				return aart_render(ptr->video_buf, ptr->v_width, ptr->v_height, frame_slot, parameters->aart_font, parameters->aart_pallete, parameters->aart_threads, parameters->aart_buffer);
-				break;
-
-			case TC_CODEC_YUV420P:
-
-				if (!tcv_convert(parameters->tcvhandle, ptr->video_buf, ptr->video_buf, ptr->v_width, ptr->v_height, IMG_YUV_DEFAULT, IMG_RGB24)){
-					tc_log_error(MOD_NAME, "cannot convert YUV stream to RGB format !");
-					return -1;
-				}
-
-				if (aart_render(ptr->video_buf, ptr->v_width, ptr->v_height, frame_slot, parameters->aart_font, parameters->aart_pallete, parameters->aart_threads, parameters->aart_buffer) == -1){return -1;}
-				if (!tcv_convert(parameters->tcvhandle, ptr->video_buf, ptr->video_buf, ptr->v_width, ptr->v_height, IMG_RGB24, IMG_YUV_DEFAULT)){
-					tc_log_error(MOD_NAME, "cannot convert RGB stream to YUV format !");
-					return -1;
-				}
-				break;
-
-			default:
-				tc_log_error(MOD_NAME, "Internal video codec is not supported.");
-				return -1;
-		}
-		free_slot(ptr->id, slots);
-	}
-	return(0);
+static int ascii_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    if (frame->tag & TC_POST_M_PROCESS && frame->tag & TC_VIDEO) {
+        return ascii_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(ascii)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
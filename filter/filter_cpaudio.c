@@ -31,119 +31,237 @@
  */
 
 #define MOD_NAME    "filter_cpaudio.so"
-#define MOD_VERSION "v0.1 (2003-04-30)"
+#define MOD_VERSION "v0.2 (2026-10-18)"
 #define MOD_CAP     "copy one audio channel to the other channel filter plugin"
 #define MOD_AUTHOR  "William H Wittig"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_AUDIO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
+
+
+static const char cpaudio_help[] = ""
+    "Overview\n"
+    "    Copies audio from one channel to another\n"
+    "Options\n"
+    "    'source=['l<eft>' or 'r<ight>']\n";
+
+/*************************************************************************/
+
+typedef struct CPAudioPrivateData_ {
+    int source;     /* 0 = left, 1 = right */
+    char opt_buf[TC_BUF_MIN];
+} CPAudioPrivateData;
+
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
 
+/**
+ * cpaudio_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(cpaudio, CPAudioPrivateData)
+
+/*************************************************************************/
+
+/**
+ * cpaudio_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(cpaudio)
 
-/*-------------------------------------------------
- * local utility functions
- *-------------------------------------------------*/
+/*************************************************************************/
+
+/**
+ * cpaudio_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-static void help_optstr(void)
+static int cpaudio_configure(TCModuleInstance *self,
+                             const char *options,
+                             TCJob *vob,
+                             TCModuleExtraData *xdata[])
 {
-    tc_log_info(MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"    Copies audio from one channel to another\n"
-"* Options\n"
-"     'source=['l<eft>' or 'r<ight>']\n"
-		, MOD_CAP);
+    CPAudioPrivateData *pd = NULL;
+    char source = 'l';
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    if (vob->dm_bits != 16) {
+        tc_log_error(MOD_NAME, "This filter only works for 16 bit samples");
+        return TC_ERROR;
+    }
+
+    if (options != NULL) {
+        if (verbose) {
+            tc_log_info(MOD_NAME, "options=%s", options);
+        }
+        optstr_get(options, "source", "%c", &source);
+        if (optstr_lookup(options, "help")) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, cpaudio_help);
+        }
+    }
+    pd->source = (source == 'l') ?0 :1;
+
+    return TC_OK;
 }
 
-/*-------------------------------------------------
- * single function interface
- *-------------------------------------------------*/
+/*************************************************************************/
 
-int tc_filter(frame_list_t *ptr_, char *options)
+/**
+ * cpaudio_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int cpaudio_stop(TCModuleInstance *self)
 {
-  aframe_list_t *ptr = (aframe_list_t *)ptr_;
-  vob_t *vob=NULL;
-  static int sourceChannel = 0;    // Init to left. '1' = right
-
-  if (ptr->tag & TC_FILTER_GET_CONFIG) {
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "William H Wittig", "AO", "1");
-      optstr_param (options, "source", "Source channel (l=left, r=right)", "%c", "l", "l", "r");
-      return 0;
-  }
-
-  //----------------------------------
-  // filter init
-  //----------------------------------
-
-  if (ptr->tag & TC_FILTER_INIT)
-  {
-    if ((vob = tc_get_vob()) == NULL)
-        return (-1);
-
-    if (vob->dm_bits != 16)
-    {
-      tc_log_error (MOD_NAME, "This filter only works for 16 bit samples\n");
-      return (-1);
-    }
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
+}
 
-    if (options != NULL)
-    {
-      char srcChannel;
+/*************************************************************************/
 
-      optstr_get(options, "source", "%c", &srcChannel);
+/**
+ * cpaudio_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
-      if (srcChannel == 'l')
-         sourceChannel = 0;
-      else
-         sourceChannel = 1;
-    }
+static int cpaudio_inspect(TCModuleInstance *self,
+                           const char *param, const char **value)
+{
+    CPAudioPrivateData *pd = NULL;
 
-    if (options)
-      if (optstr_lookup (options, "help"))
-      {
-        help_optstr();
-      }
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-    // filter init ok.
+    pd = self->userdata;
 
-    if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-    if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
+    if (optstr_lookup(param, "help")) {
+        *value = cpaudio_help;
+    }
+    if (optstr_lookup(param, "source")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%c",
+                    (pd->source == 0) ?'l' :'r');
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
 
-    return(0);
-  }
+/*************************************************************************/
 
-  //----------------------------------
-  // filter close
-  //----------------------------------
+/**
+ * cpaudio_filter_audio:  copy the source channel over the other one.
+ * See tcmodule-data.h for function details.
+ */
 
-  if(ptr->tag & TC_FILTER_CLOSE)
-  {
-    return(0);
-  }
+static int cpaudio_filter_audio(TCModuleInstance *self, aframe_list_t *frame)
+{
+    CPAudioPrivateData *pd = NULL;
+    int16_t *data = NULL;
+    int len = 0, i = 0;
 
-  //----------------------------------
-  // filter frame routine
-  //----------------------------------
+    TC_MODULE_SELF_CHECK(self, "filter_audio");
+    TC_MODULE_SELF_CHECK(frame, "filter_audio");
 
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
+    pd = self->userdata;
 
-  if(ptr->tag & TC_POST_M_PROCESS && ptr->tag & TC_AUDIO && !(ptr->attributes & TC_FRAME_IS_SKIPPED))
-  {
-    int16_t* data = (int16_t *)ptr->audio_buf;
-    int len = ptr->audio_size / 2; // 16 bits samples
-    int i;
+    if (frame->attributes & TC_FRAME_IS_SKIPPED) {
+        return TC_OK;
+    }
 
-    // if(verbose) tc_log_msg(MOD_NAME, "Length: %d, Source: %d", len, sourceChannel);
+    data = (int16_t *)frame->audio_buf;
+    len = frame->audio_size / 2; /* 16 bits samples */
 
-    for (i = 0; i < len; i += 2) // Implicitly assumes even number of samples (e.g. l,r pairs)
-    {
-        if (sourceChannel == 0)
+    /* Implicitly assumes even number of samples (e.g. l,r pairs) */
+    for (i = 0; i < len; i += 2) {
+        if (pd->source == 0)
             data[i+1] = data[i];
         else
             data[i] = data[i+1];
     }
-  }
-  return(0);
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID cpaudio_codecs_audio_in[] = {
+    TC_CODEC_PCM, TC_CODEC_ERROR
+};
+static const TCCodecID cpaudio_codecs_audio_out[] = {
+    TC_CODEC_PCM, TC_CODEC_ERROR
+};
+TC_MODULE_VIDEO_UNSUPPORTED(cpaudio);
+TC_MODULE_FILTER_FORMATS(cpaudio);
+
+TC_MODULE_INFO(cpaudio);
+
+static const TCModuleClass cpaudio_class = {
+    TC_MODULE_CLASS_HEAD(cpaudio),
+
+    .init         = cpaudio_init,
+    .fini         = cpaudio_fini,
+    .configure    = cpaudio_configure,
+    .stop         = cpaudio_stop,
+    .inspect      = cpaudio_inspect,
+
+    .filter_audio = cpaudio_filter_audio
+};
+
+TC_MODULE_ENTRY_POINT(cpaudio)
+
+/*************************************************************************/
+
+static int cpaudio_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "AO", "1");
+    optstr_param(options, "source", "Source channel (l=left, r=right)",
+                 "%c", "l", "l", "r");
+    return TC_OK;
+}
+
+static int cpaudio_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    if (frame->tag & TC_POST_M_PROCESS && frame->tag & TC_AUDIO) {
+        return cpaudio_filter_audio(self, (aframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(cpaudio)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
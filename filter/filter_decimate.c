@@ -23,170 +23,297 @@
  */
 
 #define MOD_NAME    "filter_decimate.so"
-#define MOD_VERSION "v0.4 (2003-04-22)"
+#define MOD_VERSION "v0.5 (2026-10-18)"
 #define MOD_CAP     "NTSC decimation plugin"
 #define MOD_AUTHOR  "Thanassis Tsiodras"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_DELAY|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
+#include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
+#include <limits.h>
 
-static int show_results=0;
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
+static const char decimate_help[] = ""
+    "Overview\n"
+    "    Drops one frame out of every five, the one which looks most\n"
+    "    like its successor (29.97 -> 23.976 fps).  Use after ivtc:\n"
+    "        -J ivtc,32detect=force_mode=3,decimate\n"
+    "Options\n"
+    "    verbose  print verbose information [off]\n";
 
 #define FRBUFSIZ 6
 
-int tc_filter(frame_list_t *ptr_, char *options)
+/*************************************************************************/
+
+typedef struct DecimatePrivateData_ {
+    int show_results;
+
+    uint8_t *lastFrames[FRBUFSIZ];  /* ring of the last input frames */
+    int lastFramesOK[FRBUFSIZ];     /* 0 if marked to be dropped */
+    int frameIn, frameOut;          /* ring indexes */
+    int frameCount;
+} DecimatePrivateData;
+
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * decimate_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(decimate, DecimatePrivateData)
+
+/*************************************************************************/
+
+/**
+ * decimate_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(decimate)
+
+/*************************************************************************/
+
+/**
+ * decimate_stop:  Reset this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int decimate_stop(TCModuleInstance *self)
 {
-    vframe_list_t *ptr = (vframe_list_t *)ptr_;
-    static vob_t *vob = NULL;
-    static char *lastFrames[FRBUFSIZ];
-    static int frameIn = 0, frameOut = 0;
-    static int frameCount = -1, lastFramesOK[FRBUFSIZ];
-
-    //----------------------------------
-    //
-    // filter init
-    //
-    //----------------------------------
-
-    if (ptr->tag & TC_FILTER_GET_CONFIG) {
-	if (options) {
-	    optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "Thanassis Tsiodras", "VYO", "1");
-	    optstr_param (options, "verbose", "print verbose information", "", "0");
-	}
+    DecimatePrivateData *pd = NULL;
+    int i;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+    for (i = 0; i < FRBUFSIZ; i++) {
+        tc_free(pd->lastFrames[i]);
+        pd->lastFrames[i] = NULL;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * decimate_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int decimate_configure(TCModuleInstance *self,
+                              const char *options,
+                              TCJob *vob,
+                              TCModuleExtraData *xdata[])
+{
+    DecimatePrivateData *pd = NULL;
+    int i;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    if (vob->im_v_codec != TC_CODEC_YUV420P) {
+        tc_log_error(MOD_NAME, "Sorry, only YUV input allowed for now");
+        return TC_ERROR;
+    }
+
+    pd->show_results = 0;
+    pd->frameIn      = 0;
+    pd->frameOut     = 0;
+    pd->frameCount   = -1;
+
+    if (options != NULL) {
+        if (optstr_lookup(options, "verbose") != NULL) {
+            pd->show_results = 1;
+        }
     }
 
-    if (ptr->tag & TC_FILTER_INIT) {
+    for (i = 0; i < FRBUFSIZ; i++) {
+        pd->lastFrames[i] = tc_malloc(TC_JOB_FRAME_SIZE(vob));
+        pd->lastFramesOK[i] = 1;
+        if (!pd->lastFrames[i]) {
+            tc_log_error(MOD_NAME, "can't allocate the frame buffers");
+            decimate_stop(self);
+            return TC_ERROR;
+        }
+    }
+    return TC_OK;
+}
 
-	int i;
+/*************************************************************************/
 
-	if ((vob = tc_get_vob()) == NULL)
-	    return (-1);
+/**
+ * decimate_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
-	if (vob->im_v_codec != TC_CODEC_YUV420P) {
-		tc_log_error(MOD_NAME, "Sorry, only YUV input allowed for now");
-		return (-1);
-	}
+static int decimate_inspect(TCModuleInstance *self,
+                            const char *param, const char **value)
+{
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-	// filter init ok.
-	if (options != NULL) {
+    if (optstr_lookup(param, "help")) {
+        *value = decimate_help;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
 
-	    if (optstr_lookup (options, "verbose") != NULL) {
-		show_results=1;
-	    }
+/**
+ * decimate_filter_video:  buffer the given frame and replace it with the
+ * oldest buffered frame which is not dropped.  See tcmodule-data.h for
+ * function details.
+ */
 
-	}
+static int decimate_filter_video(TCModuleInstance *self,
+                                 vframe_list_t *frame)
+{
+    DecimatePrivateData *pd = NULL;
+    int size;
 
-	if (verbose)
-	    tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
 
-	for(i=0; i<FRBUFSIZ; i++) {
-	    lastFrames[i] = tc_malloc(SIZE_RGB_FRAME);
-	    lastFramesOK[i] = 1;
-    	}
+    pd = self->userdata;
+    size = frame->v_width*frame->v_height;
 
-	return (0);
+    ac_memcpy(pd->lastFrames[pd->frameIn], frame->video_buf, size*3);
+    if (pd->show_results)
+        tc_log_info(MOD_NAME, "Inserted frame %d into slot %d ",
+                    pd->frameCount, pd->frameIn);
+    pd->lastFramesOK[pd->frameIn] = 1;
+    pd->frameIn = (pd->frameIn+1) % FRBUFSIZ;
+    pd->frameCount++;
+
+    // The first 5 frames are not processed; they are only buffered.
+    if (pd->frameCount <= 4) {
+        frame->attributes |= TC_FRAME_IS_SKIPPED;
+        return TC_OK;
     }
-    //----------------------------------
-    //
-    // filter close
-    //
-    //----------------------------------
 
+    // Having 6 frames in the buffer, we will now output one of them.
+    // From now on, for each group of 5 frames we will drop 1
+    // (FPS: 29.97->23.976). In fact, we will drop the frame
+    // that looks almost exactly like its successor.
+    if ((pd->frameCount % 5) == 0) {
+        // First, find which one of the first 5 frames in the group
+        // looks almost exactly like the frame that follows.
+        int i, j, diffMin = INT_MAX, indexMin = -1;
 
-    if (ptr->tag & TC_FILTER_CLOSE) {
-	int i;
+        for (j = 0; j < 5; j++) {
+            const uint8_t *f0 = pd->lastFrames[(pd->frameOut+j)%FRBUFSIZ];
+            const uint8_t *f1 = pd->lastFrames[(pd->frameOut+j+1)%FRBUFSIZ];
+            int diff = 0;
 
-	for(i=0; i<FRBUFSIZ; i++)
-	    free(lastFrames[i]);
-	return (0);
+            /* the frames were plain char buffers before, and the
+             * drop choices depend on it: keep comparing signed bytes */
+            for (i = 0; i < size; i += 16)
+                diff += abs((signed char)f1[i] - (signed char)f0[i]);
+            if (diff < diffMin) {
+                diffMin = diff;
+                indexMin = j;
+            }
+        }
+        // ...and mark it as junk
+        pd->lastFramesOK[(pd->frameOut+indexMin)%FRBUFSIZ] = 0;
     }
-    //----------------------------------
-    //
-    // filter frame routine
-    //
-    //----------------------------------
-
-
-    // tag variable indicates, if we are called before
-    // transcodes internal video/audio frame processing routines
-    // or after and determines video/audio context
-
-    if ((ptr->tag & TC_POST_S_PROCESS) && (ptr->tag & TC_VIDEO)) {
-
-	// After frame processing, the frames must be deinterlaced.
-	// For inverse telecine, this has been done by the ivtc filter
-	//     (you must use filter_ivtc before this filter)
-	// for example :
-	//     -J ivtc,decimate
-	// or (better) :
-	//     -J ivtc,32detect=force_mode=3,decimate
-	ac_memcpy( lastFrames[frameIn],
-		ptr->video_buf,
-		ptr->v_width*ptr->v_height*3);
-	if (show_results)
-	    tc_log_info(MOD_NAME, "Inserted frame %d into slot %d ",
-		    frameCount, frameIn);
-	lastFramesOK[frameIn] = 1;
-	frameIn = (frameIn+1) % FRBUFSIZ;
-	frameCount++;
-
-	// The first 5 frames are not processed; they are only buffered.
-	if (frameCount <= 4) {
-	    ptr->attributes |= TC_FRAME_IS_SKIPPED;
-	} else {
-	    // Having 6 frames in the buffer, we will now output one of them.
-	    // From now on, for each group of 5 frames we will drop 1
-	    // (FPS: 29.97->23.976). In fact, we will drop the frame
-	    // that looks almost exactly like its successor.
-	    if ((frameCount % 5) == 0) {
-
-		// First, find which one of the first 5 frames in the group
-		// looks almost exactly like the frame that follows.
-		int i, j, diffMin=INT_MAX, indexMin = -1;
-
-		for(j=0; j<5; j++) {
-		    int diff = 0;
-		    for(i=0; i<ptr->v_height*ptr->v_width; i+=16)
-			diff += abs(
-			    lastFrames[(frameOut+j+1)%FRBUFSIZ][i] -
-			    lastFrames[(frameOut+j)%FRBUFSIZ][i]);
-		    if (diff<diffMin) {
-			diffMin = diff;
-			indexMin = j;
-		    }
-		}
-		// ...and mark it as junk
-		lastFramesOK[(frameOut+indexMin)%FRBUFSIZ] = 0;
-	    }
-	    if (lastFramesOK[frameOut]) {
-		ac_memcpy(	ptr->video_buf,
-			lastFrames[frameOut],
-			ptr->v_width*ptr->v_height*3);
-		if (show_results)
-		    tc_log_info(MOD_NAME, "giving slot %d", frameOut);
-	    }
-	    else {
-		ptr->attributes |= TC_FRAME_IS_SKIPPED;
-		if (show_results)
-		    tc_log_info(MOD_NAME, "droping slot %d", frameOut);
-	    }
-	    // Regardless of the job we periodically do (for each group
-	    // of 5 frames) we must also advance the two indexes.
-	    // The frameIn index is increased at frame insertion.
-	    // Now it is time for the frameOut index.
-	    // Note that both indexes are moving at the same speed,
-	    // so no code for circular queue index-clashing is required.
-	    frameOut = (frameOut+1) % FRBUFSIZ;
-	}
+    if (pd->lastFramesOK[pd->frameOut]) {
+        ac_memcpy(frame->video_buf, pd->lastFrames[pd->frameOut], size*3);
+        if (pd->show_results)
+            tc_log_info(MOD_NAME, "giving slot %d", pd->frameOut);
+    } else {
+        frame->attributes |= TC_FRAME_IS_SKIPPED;
+        if (pd->show_results)
+            tc_log_info(MOD_NAME, "droping slot %d", pd->frameOut);
     }
+    // Both indexes move at the same speed, so no code for circular
+    // queue index-clashing is required.
+    pd->frameOut = (pd->frameOut+1) % FRBUFSIZ;
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID decimate_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+static const TCCodecID decimate_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(decimate);
+TC_MODULE_FILTER_FORMATS(decimate);
+
+TC_MODULE_INFO(decimate);
+
+static const TCModuleClass decimate_class = {
+    TC_MODULE_CLASS_HEAD(decimate),
+
+    .init         = decimate_init,
+    .fini         = decimate_fini,
+    .configure    = decimate_configure,
+    .stop         = decimate_stop,
+    .inspect      = decimate_inspect,
+
+    .filter_video = decimate_filter_video
+};
 
-    return (0);
+TC_MODULE_ENTRY_POINT(decimate)
+
+/*************************************************************************/
+
+static int decimate_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VYO", "1");
+    optstr_param(options, "verbose", "print verbose information", "", "0");
+    return TC_OK;
+}
+
+static int decimate_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    /* after the frame threads: the frames must be deinterlaced already
+     * (use filter_ivtc before this one) */
+    if ((frame->tag & TC_POST_S_PROCESS) && (frame->tag & TC_VIDEO)) {
+        return decimate_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(decimate)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -24,293 +24,408 @@
  */
 
 #define MOD_NAME    "filter_detectclipping.so"
-#define MOD_VERSION "v0.2.0 (2009-01-30)"
+#define MOD_VERSION "v0.3.0 (2026-10-18)"
 #define MOD_CAP     "detect clipping parameters (-j or -Y)"
 #define MOD_AUTHOR  "Tilmann Bitterberg, A'rpi, A. Beamud"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_SEQUENTIAL|TC_MODULE_FLAG_READONLY
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
-
-
-// basic parameter
-
-typedef struct MyFilterData {
+#include "libtcmodule/tcmodule-plugin.h"
+
+
+static const char detectclipping_help[] = ""
+    "Overview\n"
+    "    Detect black regions on top, bottom, left and right of an image\n"
+    "    It is suggested that the filter is run for around 100 frames.\n"
+    "    It will print its detected parameters every frame. If you\n"
+    "    don't notice any change in the printout for a while, the filter\n"
+    "    probably won't find any other values.\n"
+    "    The filter converges, meaning it will learn.\n"
+    "Options\n"
+    "    range  apply filter to [start-end]/step frames [0-oo/1]\n"
+    "    limit  the sum of a line must be below this limit to be\n"
+    "           considered black [24]\n"
+    "    post   run as a POST filter (calc -Y instead of the default -j)\n"
+    "    log    file to save a detailed values.\n";
+
+/*************************************************************************/
+
+/* The detected area narrows down frame after frame, so frames must come
+ * in order. */
+
+typedef struct DetectClippingPrivateData_ {
     /* configurable */
-        unsigned int start;
-        unsigned int end;
-        unsigned int step;
-        int post;
-	int limit;
-        FILE *log;
-        int frames;
-        int x1, y1, x2, y2;
+    unsigned int start;
+    unsigned int end;
+    unsigned int step;
+    int post;
+    int limit;
+    FILE *log;
+    int frames;
+    int x1, y1, x2, y2;
 
     /* internal */
-	int stride, bpp;
-	int fno;
-	int boolstep;
-} MyFilterData;
-
-static MyFilterData *mfd[16];
+    int stride, bpp;
+    int fno;
+    int boolstep;
+    int id;
+} DetectClippingPrivateData;
 
-/* should probably honor the other flags too */
+/*************************************************************************/
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
-
-static void help_optstr(void)
+static int checkline(const uint8_t *src, int stride, int len, int bpp)
 {
-    tc_log_info(MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"    Detect black regions on top, bottom, left and right of an image\n"
-"    It is suggested that the filter is run for around 100 frames.\n"
-"    It will print its detected parameters every frame. If you\n"
-"    don't notice any change in the printout for a while, the filter\n"
-"    probably won't find any other values.\n"
-"    The filter converges, meaning it will learn.\n"
-"* Options\n"
-"    'range' apply filter to [start-end]/step frames [0-oo/1]\n"
-"    'limit' the sum of a line must be below this limit to be considered black\n"
-"    'post' run as a POST filter (calc -Y instead of the default -j)\n"
-"    'log' file to save a detailed values.\n"
-		, MOD_CAP);
-}
-
-static int checkline(unsigned char* src,int stride,int len,int bpp){
-    int total=0;
-    int div=len;
-    switch(bpp){
-    case 1:
-	while(--len>=0){
-	    total+=src[0]; src+=stride;
-	}
-	break;
-    case 3:
-    case 4:
-	while(--len>=0){
-	    total+=src[0]+src[1]+src[2]; src+=stride;
-	}
-	div*=3;
-	break;
+    int total = 0;
+    int div = len;
+
+    switch (bpp) {
+      case 1:
+        while (--len >= 0) {
+            total += src[0];
+            src += stride;
+        }
+        break;
+      case 3:
+      case 4:
+        while (--len >= 0) {
+            total += src[0] + src[1] + src[2];
+            src += stride;
+        }
+        div *= 3;
+        break;
     }
-    total/=div;
+    total /= div;
     return total;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
+/*************************************************************************/
 
-  if (ptr->tag & TC_AUDIO)
-    return 0;
+/* Module interface routines and data. */
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-      char buf[128];
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VRYEOM", "1");
+/*************************************************************************/
 
-      tc_snprintf(buf, 128, "%u-%u/%d", mfd[ptr->filter_id]->start, mfd[ptr->filter_id]->end, mfd[ptr->filter_id]->step);
-      optstr_param (options, "range", "apply filter to [start-end]/step frames",
-	      "%u-%u/%d", buf, "0", "oo", "0", "oo", "1", "oo");
-      optstr_param (options, "limit", "the sum of a line must be below this limit to be considered as black", "%d", "24", "0", "255");
-      optstr_param (options, "post", "run as a POST filter (calc -Y instead of the default -j)", "", "0");
-      optstr_param(options, "log", "file to save a detailed values", "", "");
+/**
+ * detectclipping_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-      return 0;
-  }
+TC_MODULE_GENERIC_INIT(detectclipping, DetectClippingPrivateData)
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_INIT) {
+/**
+ * detectclipping_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+TC_MODULE_GENERIC_FINI(detectclipping)
 
-    mfd[ptr->filter_id] = tc_malloc (sizeof(MyFilterData));
-    if(mfd[ptr->filter_id] == NULL)
-        return (-1);
+/*************************************************************************/
 
+/**
+ * detectclipping_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int detectclipping_configure(TCModuleInstance *self,
+                                    const char *options,
+                                    TCJob *vob,
+                                    TCModuleExtraData *xdata[])
+{
+    DetectClippingPrivateData *pd = NULL;
     char log_name[PATH_MAX];
-    memset(log_name, 0, PATH_MAX);    
 
-    mfd[ptr->filter_id]->start=0;
-    mfd[ptr->filter_id]->end=(unsigned int)-1;
-    mfd[ptr->filter_id]->step=1;
-    mfd[ptr->filter_id]->limit=24;
-    mfd[ptr->filter_id]->post = 0;
-    mfd[ptr->filter_id]->log = NULL;
-    mfd[ptr->filter_id]->frames = 0;
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
 
-    if (options != NULL) {
+    pd = self->userdata;
+    memset(log_name, 0, sizeof(log_name));
 
-	if(verbose) tc_log_info (MOD_NAME, "options=%s", options);
+    pd->start  = 0;
+    pd->end    = (unsigned int)-1;
+    pd->step   = 1;
+    pd->limit  = 24;
+    pd->post   = 0;
+    pd->log    = NULL;
+    pd->frames = 0;
+    pd->id     = self->id;
 
-	optstr_get (options, "range",  "%u-%u/%d",    &mfd[ptr->filter_id]->start, &mfd[ptr->filter_id]->end, &mfd[ptr->filter_id]->step);
-	optstr_get (options, "limit",  "%d",    &mfd[ptr->filter_id]->limit);
-	if (optstr_lookup (options, "post")!=NULL) mfd[ptr->filter_id]->post = 1;
-        optstr_get (options, "log", "%[^:]", log_name);
+    if (options != NULL) {
+        if (verbose)
+            tc_log_info(MOD_NAME, "options=%s", options);
+
+        optstr_get(options, "range", "%u-%u/%d",
+                   &pd->start, &pd->end, &pd->step);
+        optstr_get(options, "limit", "%d", &pd->limit);
+        if (optstr_lookup(options, "post") != NULL)
+            pd->post = 1;
+        optstr_get(options, "log", "%[^:]", log_name);
+
+        if (optstr_lookup(options, "help")) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP,
+                        detectclipping_help);
+        }
     }
 
-
     if (verbose > 1) {
-	tc_log_info (MOD_NAME, " detectclipping#%d Settings:", ptr->filter_id);
-	tc_log_info (MOD_NAME, "              range = %u-%u", mfd[ptr->filter_id]->start, mfd[ptr->filter_id]->end);
-	tc_log_info (MOD_NAME, "               step = %u", mfd[ptr->filter_id]->step);
-	tc_log_info (MOD_NAME, "              limit = %u", mfd[ptr->filter_id]->limit);
-        tc_log_info (MOD_NAME, "                log = %s", log_name);
-	tc_log_info (MOD_NAME, "    run POST filter = %s", mfd[ptr->filter_id]->post?"yes":"no");
+        tc_log_info(MOD_NAME, " detectclipping#%d Settings:", pd->id);
+        tc_log_info(MOD_NAME, "              range = %u-%u",
+                    pd->start, pd->end);
+        tc_log_info(MOD_NAME, "               step = %u", pd->step);
+        tc_log_info(MOD_NAME, "              limit = %u", pd->limit);
+        tc_log_info(MOD_NAME, "                log = %s", log_name);
+        tc_log_info(MOD_NAME, "    run POST filter = %s",
+                    pd->post ?"yes" :"no");
     }
 
-    if (options)
-	if (optstr_lookup (options, "help")) {
-	    help_optstr();
-	}
-
-    if (mfd[ptr->filter_id]->start % mfd[ptr->filter_id]->step == 0)
-      mfd[ptr->filter_id]->boolstep = 0;
-    else
-      mfd[ptr->filter_id]->boolstep = 1;
-
-    if (!mfd[ptr->filter_id]->post) {
-	mfd[ptr->filter_id]->x1 = vob->im_v_width;
-	mfd[ptr->filter_id]->y1 = vob->im_v_height;
+    if (vob->im_v_codec == TC_CODEC_YUV420P) {
+        pd->stride = pd->post ?vob->ex_v_width :vob->im_v_width;
+        pd->bpp = 1;
+    } else if (vob->im_v_codec == TC_CODEC_RGB24) {
+        pd->stride = pd->post ?(vob->ex_v_width*3) :(vob->im_v_width*3);
+        pd->bpp = 3;
     } else {
-	mfd[ptr->filter_id]->x1 = vob->ex_v_width;
-	mfd[ptr->filter_id]->y1 = vob->ex_v_height;
+        tc_log_error(MOD_NAME, "unsupported colorspace");
+        return TC_ERROR;
     }
-    mfd[ptr->filter_id]->x2 = 0;
-    mfd[ptr->filter_id]->y2 = 0;
-    mfd[ptr->filter_id]->fno = 0;
-    if (strlen(log_name) != 0)
-        if (!(mfd[ptr->filter_id]->log = fopen(log_name, "w")))
-	     perror("could not open file for writing");
-		
 
+    pd->boolstep = (pd->start % pd->step == 0) ?0 :1;
 
-    if (vob->im_v_codec == TC_CODEC_YUV420P) {
-	mfd[ptr->filter_id]->stride = mfd[ptr->filter_id]->post?vob->ex_v_width:vob->im_v_width;
-	mfd[ptr->filter_id]->bpp = 1;
-    } else if (vob->im_v_codec == TC_CODEC_RGB24) {
-	mfd[ptr->filter_id]->stride = mfd[ptr->filter_id]->post?(vob->ex_v_width*3):(vob->im_v_width*3);
-	mfd[ptr->filter_id]->bpp = 3;
+    if (!pd->post) {
+        pd->x1 = vob->im_v_width;
+        pd->y1 = vob->im_v_height;
     } else {
-	tc_log_error (MOD_NAME, "unsupported colorspace");
-	return -1;
+        pd->x1 = vob->ex_v_width;
+        pd->y1 = vob->ex_v_height;
     }
+    pd->x2  = 0;
+    pd->y2  = 0;
+    pd->fno = 0;
+
+    if (strlen(log_name) != 0) {
+        pd->log = fopen(log_name, "w");
+        if (!pd->log) {
+            tc_log_perror(MOD_NAME, "could not open file for writing");
+        } else {
+            fprintf(pd->log, "#fps:%f\n", vob->fps);
+        }
+    }
+    return TC_OK;
+}
 
-    // filter init ok.
-    if (verbose) tc_log_info(MOD_NAME, "%s %s #%d", MOD_VERSION, MOD_CAP, ptr->filter_id);
-    if(mfd[ptr->filter_id]->log)
-        fprintf(mfd[ptr->filter_id]->log,"#fps:%f\n",vob->fps);
+/*************************************************************************/
 
-    return(0);
-  }
+/**
+ * detectclipping_stop:  Reset this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
+static int detectclipping_stop(TCModuleInstance *self)
+{
+    DetectClippingPrivateData *pd = NULL;
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
+    TC_MODULE_SELF_CHECK(self, "stop");
 
-    if (mfd[ptr->filter_id]) {
-        fprintf(mfd[ptr->filter_id]->log,"#total: %d",mfd[ptr->filter_id]->frames);
-        fclose(mfd[ptr->filter_id]->log);
-	free(mfd[ptr->filter_id]);
+    pd = self->userdata;
+    if (pd->log) {
+        fprintf(pd->log, "#total: %d", pd->frames);
+        fclose(pd->log);
+        pd->log = NULL;
     }
-    mfd[ptr->filter_id]=NULL;
-
-    return(0);
-
-  } /* filter close */
+    return TC_OK;
+}
 
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
+/*************************************************************************/
 
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
+/**
+ * detectclipping_inspect:  Return the value of an option in this
+ * instance of the module.  See tcmodule-data.h for function details.
+ */
 
-  if(((ptr->tag & TC_PRE_M_PROCESS && !mfd[ptr->filter_id]->post) ||
-      (ptr->tag & TC_POST_M_PROCESS && mfd[ptr->filter_id]->post)) &&
-     !(ptr->attributes & TC_FRAME_IS_SKIPPED))  {
+static int detectclipping_inspect(TCModuleInstance *self,
+                                  const char *param, const char **value)
+{
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-    int y;
-    char *p = ptr->video_buf;
-    int l,r,t,b;
+    if (optstr_lookup(param, "help")) {
+        *value = detectclipping_help;
+    }
+    return TC_OK;
+}
 
-    if (mfd[ptr->filter_id]->fno++ < 3)
-	return 0;
+/*************************************************************************/
 
-    if (mfd[ptr->filter_id]->start <= ptr->id && ptr->id <= mfd[ptr->filter_id]->end && ptr->id%mfd[ptr->filter_id]->step == mfd[ptr->filter_id]->boolstep) {
+/**
+ * detectclipping_filter_video:  narrow the valid area down with the
+ * given frame.  See tcmodule-data.h for function details.
+ */
 
-    for (y = 0; y < mfd[ptr->filter_id]->y1; y++) {
-	if(checkline(p+mfd[ptr->filter_id]->stride*y, mfd[ptr->filter_id]->bpp, ptr->v_width, mfd[ptr->filter_id]->bpp) > mfd[ptr->filter_id]->limit) {
-	    mfd[ptr->filter_id]->y1 = y;
-	    break;
-	}
+static int detectclipping_filter_video(TCModuleInstance *self,
+                                       vframe_list_t *frame)
+{
+    DetectClippingPrivateData *pd = NULL;
+    const uint8_t *p = NULL;
+    int y, l, r, t, b;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+    p = frame->video_buf;
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+    if (pd->fno++ < 3)
+        return TC_OK;
+    if (!(pd->start <= frame->id && frame->id <= pd->end
+       && frame->id % pd->step == pd->boolstep))
+        return TC_OK;
+
+    for (y = 0; y < pd->y1; y++) {
+        if (checkline(p + pd->stride*y, pd->bpp, frame->v_width,
+                      pd->bpp) > pd->limit) {
+            pd->y1 = y;
+            break;
+        }
     }
 
-    for (y=ptr->v_height-1; y>mfd[ptr->filter_id]->y2; y--) {
-	if (checkline(p+mfd[ptr->filter_id]->stride*y, mfd[ptr->filter_id]->bpp, ptr->v_width, mfd[ptr->filter_id]->bpp) > mfd[ptr->filter_id]->limit) {
-	    mfd[ptr->filter_id]->y2 = y;
-	    break;
-	}
+    for (y = frame->v_height-1; y > pd->y2; y--) {
+        if (checkline(p + pd->stride*y, pd->bpp, frame->v_width,
+                      pd->bpp) > pd->limit) {
+            pd->y2 = y;
+            break;
+        }
     }
 
-    for (y = 0; y < mfd[ptr->filter_id]->x1; y++) {
-	if(checkline(p+mfd[ptr->filter_id]->bpp*y, mfd[ptr->filter_id]->stride, ptr->v_height, mfd[ptr->filter_id]->bpp) > mfd[ptr->filter_id]->limit) {
-	    mfd[ptr->filter_id]->x1 = y;
-	    break;
-	}
+    for (y = 0; y < pd->x1; y++) {
+        if (checkline(p + pd->bpp*y, pd->stride, frame->v_height,
+                      pd->bpp) > pd->limit) {
+            pd->x1 = y;
+            break;
+        }
     }
 
-    for (y = ptr->v_width-1; y > mfd[ptr->filter_id]->x2; y--) {
-	if(checkline(p+mfd[ptr->filter_id]->bpp*y, mfd[ptr->filter_id]->stride, ptr->v_height, mfd[ptr->filter_id]->bpp) > mfd[ptr->filter_id]->limit) {
-	    mfd[ptr->filter_id]->x2 = y;
-	    break;
-	}
+    for (y = frame->v_width-1; y > pd->x2; y--) {
+        if (checkline(p + pd->bpp*y, pd->stride, frame->v_height,
+                      pd->bpp) > pd->limit) {
+            pd->x2 = y;
+            break;
+        }
     }
 
-    t = (mfd[ptr->filter_id]->y1+1)&(~1);
-    l = (mfd[ptr->filter_id]->x1+1)&(~1);
-    b = ptr->v_height - ((mfd[ptr->filter_id]->y2+1)&(~1));
-    r = ptr->v_width - ((mfd[ptr->filter_id]->x2+1)&(~1));
-
-    tc_log_info(MOD_NAME, "[detectclipping#%d] valid area: X: %d..%d Y: %d..%d  -> %s %d,%d,%d,%d",
-	ptr->filter_id,
-	mfd[ptr->filter_id]->x1,mfd[ptr->filter_id]->x2,
-	mfd[ptr->filter_id]->y1,mfd[ptr->filter_id]->y2,
-	mfd[ptr->filter_id]->post?"-Y":"-j",
-	t, l, b, r
-	  );
-    if(mfd[ptr->filter_id]->log)
-        fprintf(mfd[ptr->filter_id]->log, "%d %d %d %d %d\n",
-                mfd[ptr->filter_id]->frames,
-                t, l , b, r);
-    
+    t = (pd->y1+1)&(~1);
+    l = (pd->x1+1)&(~1);
+    b = frame->v_height - ((pd->y2+1)&(~1));
+    r = frame->v_width - ((pd->x2+1)&(~1));
 
+    tc_log_info(MOD_NAME, "[detectclipping#%d] valid area: X: %d..%d"
+                " Y: %d..%d  -> %s %d,%d,%d,%d",
+                pd->id, pd->x1, pd->x2, pd->y1, pd->y2,
+                pd->post ?"-Y" :"-j", t, l, b, r);
+    if (pd->log)
+        fprintf(pd->log, "%d %d %d %d %d\n", pd->frames, t, l, b, r);
 
-    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID detectclipping_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID detectclipping_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(detectclipping);
+TC_MODULE_FILTER_FORMATS(detectclipping);
+
+TC_MODULE_INFO(detectclipping);
+
+static const TCModuleClass detectclipping_class = {
+    TC_MODULE_CLASS_HEAD(detectclipping),
+
+    .init         = detectclipping_init,
+    .fini         = detectclipping_fini,
+    .configure    = detectclipping_configure,
+    .stop         = detectclipping_stop,
+    .inspect      = detectclipping_inspect,
+
+    .filter_video = detectclipping_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(detectclipping)
+
+/*************************************************************************/
+
+static int detectclipping_get_config(TCModuleInstance *self, char *options)
+{
+    DetectClippingPrivateData *pd = NULL;
+    char buf[128];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
 
-  }
-  if((ptr->tag & TC_PRE_S_PROCESS) && (ptr->tag & TC_VIDEO)){
-	  /* ever count the frames, and only analize the non skipped frames */
-	  mfd[ptr->filter_id]->frames++;
-  }
-  
-  return(0);
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRYEOM", "1");
+
+    tc_snprintf(buf, sizeof(buf), "%u-%u/%d", pd->start, pd->end, pd->step);
+    optstr_param(options, "range", "apply filter to [start-end]/step frames",
+                 "%u-%u/%d", buf, "0", "oo", "0", "oo", "1", "oo");
+    optstr_param(options, "limit", "the sum of a line must be below this"
+                 " limit to be considered as black", "%d", "24", "0", "255");
+    optstr_param(options, "post", "run as a POST filter"
+                 " (calc -Y instead of the default -j)", "", "0");
+    optstr_param(options, "log", "file to save a detailed values", "", "");
+    return TC_OK;
 }
 
+static int detectclipping_process(TCModuleInstance *self,
+                                  frame_list_t *frame)
+{
+    DetectClippingPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    pd = self->userdata;
+
+    if (!(frame->tag & TC_VIDEO))
+        return TC_OK;
+
+    if ((frame->tag & TC_PRE_M_PROCESS  && !pd->post)
+     || (frame->tag & TC_POST_M_PROCESS && pd->post)) {
+        return detectclipping_filter_video(self, (vframe_list_t*)frame);
+    }
+    if (frame->tag & TC_PRE_S_PROCESS) {
+        /* ever count the frames, and only analize the non skipped ones */
+        pd->frames++;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(detectclipping)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -36,7 +36,7 @@ typedef struct {
     int deinter_handle;     // For high-quality mode
     int saved_audio_len;    // Number of bytes of audio saved for second field
     uint8_t saved_audio[SIZE_PCM_FRAME];
-    uint8_t saved_frame[TC_MAX_V_FRAME_WIDTH*TC_MAX_V_FRAME_HEIGHT*3];
+    uint8_t *saved_frame;   // Second field (or frame) for the next call
     int saved_width, saved_height;  // For full-height operation
 } DfpsPrivateData;
 
@@ -68,6 +68,7 @@ static int doublefps_init(TCModuleInstance *self, uint32_t features)
     pd->topfirst = -1;
     pd->fullheight = 0;
     pd->have_first_frame = pd->saved_width = pd->saved_height = 0;
+    pd->saved_frame = NULL;
 
     /* FIXME: we need a proper way for filters to tell the core that
      * they're changing the export parameters */
@@ -110,6 +111,7 @@ static int doublefps_fini(TCModuleInstance *self)
         tcv_free(pd->tcvhandle);
         pd->tcvhandle = 0;
     }
+    tc_free(pd->saved_frame);
 
     tc_free(self->userdata);
     self->userdata = NULL;
@@ -165,6 +167,12 @@ static int doublefps_configure(TCModuleInstance *self,
         vob->export_attributes |= TC_EXPORT_ATTRIBUTE_FIELDS;
     }
 
+    tc_free(pd->saved_frame);
+    pd->saved_frame = tc_malloc(TC_JOB_FRAME_SIZE(vob));
+    if (!pd->saved_frame) {
+        tc_log_error(MOD_NAME, "configure: out of memory!");
+        return TC_ERROR;
+    }
     return TC_OK;
 }
 
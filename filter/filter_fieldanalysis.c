@@ -28,19 +28,38 @@
   */
 
 #define MOD_NAME    "filter_fieldanalysis.so"
-#define MOD_VERSION "v1.0 pl1 (2004-08-13)"
+#define MOD_VERSION "v1.1 (2026-10-18)"
 #define MOD_CAP     "Field analysis for detecting interlace and telecine"
 #define MOD_AUTHOR  "Matthias Hopf"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 #include "libtcvideo/tcvideo.h"
 
 #include <assert.h>
 
 
+static const char fieldanalysis_help[] = ""
+    "Overview:\n"
+    "    'fieldanalysis' scans video for interlacing artifacts and\n"
+    "    detects progressive / interlaced / telecined video.\n"
+    "    It also determines the major field for interlaced video.\n"
+    "Verbose Output:   [PtPb c t stsb]\n"
+    "    Pt, Pb:   progressivediff succeeded, per field.\n"
+    "    pt, pb:   unknowndiff succeeded, progressivediff failed.\n"
+    "    c:        progressivechange succeeded.\n"
+    "    t:        topFieldFirst / b: bottomFieldFirst detected.\n"
+    "    st, sb:   changedifmore failed (fields are similar to last"
+    " frame).\n";
+
 /*
  * State
  */
@@ -81,10 +100,9 @@ typedef struct {
 
     TCVHandle tcvhandle;
 
+    char  opt_buf[TC_BUF_MIN];
 } myfilter_t;
 
-static myfilter_t *myf_global = NULL;
-
 /* Internal state flag values */
 enum { IS_UNKNOWN = -1, IS_FALSE = 0, IS_TRUE = 1 };
 
@@ -377,308 +395,493 @@ static void check_interlace (myfilter_t *myf, int id) {
 }
 
 
-/*
- * transcode API
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * fieldanalysis_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(fieldanalysis, myfilter_t)
+
+/*************************************************************************/
+
+/**
+ * fieldanalysis_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
  */
-int tc_filter(frame_list_t *ptr_, char *options)
+
+TC_MODULE_GENERIC_FINI(fieldanalysis)
+
+/*************************************************************************/
+
+/* Print out the results of the analysis. */
+
+static void fieldanalysis_report(const myfilter_t *myf)
 {
-    vframe_list_t *ptr = (vframe_list_t *)ptr_;
-    vob_t *vob = NULL;
-    myfilter_t *myf = myf_global;
+    int total = myf->numFrames - myf->unknownFrames;
+    int totalfields = myf->topFirstFrames + myf->bottomFirstFrames;
+
+    if (totalfields < 1)
+        totalfields = 1;
+    tc_log_info(MOD_NAME, "RESULTS: Frames:      %d (100%%)"
+                          "  Unknown:      %d (%.3g%%)",
+                myf->numFrames, myf->unknownFrames,
+                100.0 * myf->unknownFrames / (double)myf->numFrames);
+    tc_log_info(MOD_NAME, "RESULTS: Progressive: %d (%.3g%%)"
+                          "  Interlaced:   %d (%.3g%%)",
+                myf->progressiveFrames,
+                100.0 * myf->progressiveFrames / (double)myf->numFrames,
+                myf->interlacedFrames,
+                100.0 * myf->interlacedFrames / (double)myf->numFrames);
+    tc_log_info(MOD_NAME, "RESULTS: FieldShift:  %d (%.3g%%)"
+                          "  Telecined:    %d (%.3g%%)",
+                myf->fieldShiftFrames,
+                100.0 * myf->fieldShiftFrames / (double)myf->numFrames,
+                myf->telecineFrames,
+                100.0 * myf->telecineFrames / (double)myf->numFrames);
+    tc_log_info(MOD_NAME, "RESULTS: MajorField: TopFirst %d (%.3g%%)"
+                          "  BottomFirst %d (%.3g%%)",
+                myf->topFirstFrames,
+                100.0 * myf->topFirstFrames / (double)totalfields,
+                myf->bottomFirstFrames,
+                100.0 * myf->bottomFirstFrames / (double)totalfields);
+
+    if (total < 50)
+        tc_log_warn(MOD_NAME, "less than 50 frames analyzed correctly,"
+                              " no conclusion.");
+    else if (myf->unknownFrames * 10 > myf->numFrames * 9)
+        tc_log_warn(MOD_NAME, "less than 10%% frames analyzed correctly,"
+                              " no conclusion.");
+    else if (myf->progressiveFrames * 8 > total * 7)
+        tc_log_info(MOD_NAME, "CONCLUSION: progressive video.");
+    else if (myf->topFirstFrames * 8 > myf->bottomFirstFrames
+          && myf->bottomFirstFrames * 8 > myf->topFirstFrames)
+        tc_log_info(MOD_NAME, "major field unsure, no conclusion."
+                              " Use deinterlacer for processing.");
+    else if (myf->telecineFrames * 4 > total * 3)
+        tc_log_info(MOD_NAME, "CONCLUSION: telecined video,"
+                              " %s field first.",
+                    myf->topFirstFrames > myf->bottomFirstFrames
+                        ? "top" : "bottom");
+    else if (myf->fieldShiftFrames * 4 > total * 3)
+        tc_log_info(MOD_NAME, "CONCLUSION: field shifted progressive"
+                              " video, %s field first.",
+                    myf->topFirstFrames > myf->bottomFirstFrames
+                        ? "top" : "bottom");
+    else if (myf->interlacedFrames > myf->fieldShiftFrames
+          && (myf->interlacedFrames+myf->fieldShiftFrames) * 8 > total * 7)
+        tc_log_info(MOD_NAME, "CONCLUSION: interlaced video,"
+                              " %s field first.",
+                    myf->topFirstFrames > myf->bottomFirstFrames
+                        ? "top" : "bottom");
+    else
+        tc_log_info(MOD_NAME, "mixed video, no conclusion."
+                              " Use deinterlacer for processing.");
+}
 
-    /*
-     * filter init
-     */
-    if (ptr->tag & TC_FILTER_INIT) {
+/*************************************************************************/
 
-	if (! (vob = tc_get_vob ()))
-	    return -1;
+/**
+ * fieldanalysis_stop:  Reset this instance of the module, reporting the
+ * results of the analysis.  See tcmodule-data.h for function details.
+ */
 
-	if (! (myf = myf_global = tc_zalloc (sizeof (myfilter_t)))) {
-	    return -1;
-	}
+static int fieldanalysis_stop(TCModuleInstance *self)
+{
+    myfilter_t *myf = NULL;
 
-	if (! (myf->tcvhandle = tcv_init())) {
-	    tc_log_error(MOD_NAME, "tcv_init() failed");
-	    free(myf);
-	    myf = myf_global = NULL;
-	    return -1;
-	}
+    TC_MODULE_SELF_CHECK(self, "stop");
 
-	if (verbose)			/* global verbose */
-	    tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-
-	/* default values */
-	myf->interlaceDiff       = 1.1;
-	myf->unknownDiff         = 1.5;
-	myf->progressiveDiff     = 8;
-	myf->progressiveChange   = 0.2;
-	myf->changedIfMore       = 10;
-
-	myf->forceTelecineDetect = 0;
-	myf->verbose             = 0;
-	myf->outDiff             = 0;
-
-	/* video parameters */
-	switch (vob->im_v_codec) {
-	case TC_CODEC_YUY2:
-	case TC_CODEC_YUV420P:
-	case TC_CODEC_YUV422P:
-	case TC_CODEC_RGB24:
-	    break;
-	default:
-	    tc_log_error(MOD_NAME,
-                     "Unsupported codec - need one of RGB24 YUV420P YUY2 YUV422P");
-	    return -1;
-	}
-	myf->codec     = vob->im_v_codec;
-	myf->width     = vob->im_v_width;
-	myf->height    = vob->im_v_height;
-	myf->fps       = vob->fps;
-	myf->size = myf->width * myf->height;
-
-	if (options) {
-	    optstr_get (options, "interlacediff",     "%lf",
-			&myf->interlaceDiff);
-	    optstr_get (options, "unknowndiff",       "%lf",
-			&myf->unknownDiff);
-	    optstr_get (options, "progressivediff",   "%lf",
-			&myf->progressiveDiff);
-	    optstr_get (options, "progressivechange", "%lf",
-			&myf->progressiveChange);
-	    optstr_get (options, "changedifmore",     "%lf",
-			&myf->changedIfMore);
-	    optstr_get (options, "forcetelecinedetect",
-		        "%d", &myf->forceTelecineDetect);
-	    optstr_get (options, "verbose",          "%d", &myf->verbose);
-	    optstr_get (options, "outdiff",          "%d", &myf->outDiff);
-
-	    if (optstr_lookup (options, "help") != NULL) {
-		tc_log_info (MOD_NAME, "(%s) help\n"
-"* Overview:\n"
-"  'fieldanalysis' scans video for interlacing artifacts and\n"
-"  detects progressive / interlaced / telecined video.\n"
-"  It also determines the major field for interlaced video.\n"
-"* Verbose Output:   [PtPb c t stsb]\n"
-"  Pt, Pb:   progressivediff succeeded, per field.\n"
-"  pt, pb:   unknowndiff succeeded, progressivediff failed.\n"
-"  c:        progressivechange succeeded.\n"
-"  t:        topFieldFirst / b: bottomFieldFirst detected.\n"
-"  st, sb:   changedifmore failed (fields are similar to last frame).\n"
-			     , MOD_CAP);
-	    }
-	}
+    myf = self->userdata;
 
-	/* frame memory */
-	if (! (myf->lumIn    = calloc (1, myf->size)) ||
-	    ! (myf->lumPrev  = calloc (1, myf->size)) ||
-	    ! (myf->lumInT   = calloc (1, myf->size)) ||
-	    ! (myf->lumInB   = calloc (1, myf->size)) ||
-	    ! (myf->lumPrevT = calloc (1, myf->size)) ||
-	    ! (myf->lumPrevB = calloc (1, myf->size))) {
-	    tc_log_error(MOD_NAME, "calloc() failed");
-	    return -1;
-	}
+    if (myf->numFrames > 0)
+        fieldanalysis_report(myf);
 
-	if (verbose) {			/* global verbose */
-	    tc_log_info(MOD_NAME, "interlacediff %.2f,  unknowndiff %.2f,  progressivediff %.2f",
-		                        myf->interlaceDiff, myf->unknownDiff, myf->progressiveDiff);
-        tc_log_info(MOD_NAME, "progressivechange %.2f, changedifmore %.2f",
-                    		   myf->progressiveChange, myf->changedIfMore);
-        tc_log_info(MOD_NAME, "forcetelecinedetect %s, verbose %d, outdiff %d",
-                    		   myf->forceTelecineDetect ? "True":"False", myf->verbose,
-                               myf->outDiff);
-	}
+    tc_free(myf->lumIn);
+    tc_free(myf->lumPrev);
+    tc_free(myf->lumInT);
+    tc_free(myf->lumInB);
+    tc_free(myf->lumPrevT);
+    tc_free(myf->lumPrevB);
+    myf->lumIn = myf->lumPrev = myf->lumInT = myf->lumInB =
+        myf->lumPrevT = myf->lumPrevB = NULL;
 
-	return 0;
+    if (myf->tcvhandle) {
+        tcv_free(myf->tcvhandle);
+        myf->tcvhandle = NULL;
     }
+    return TC_OK;
+}
 
-    /*
-     * filter close
-     */
+/*************************************************************************/
 
-    if (ptr->tag & TC_FILTER_CLOSE) {
-
-	int total = myf->numFrames - myf->unknownFrames;
-	int totalfields = myf->topFirstFrames + myf->bottomFirstFrames;
-
-	/* Cleanup */
-	free (myf->lumIn);
-	free (myf->lumPrev);
-	free (myf->lumInT);
-	free (myf->lumInB);
-	free (myf->lumPrevT);
-	free (myf->lumPrevB);
-	myf->lumIn = myf->lumPrev = myf->lumInT = myf->lumInB =
-	    myf->lumPrevT = myf->lumPrevB = NULL;
-
-	/* Output results */
-	if (totalfields < 1)
-	    totalfields = 1;
-	tc_log_info(MOD_NAME, "RESULTS: Frames:      %d (100%%)  Unknown:      %d (%.3g%%)",
-		                myf->numFrames, myf->unknownFrames,
-                		100.0 * myf->unknownFrames / (double)myf->numFrames);
-    tc_log_info(MOD_NAME, "RESULTS: Progressive: %d (%.3g%%)  Interlaced:   %d (%.3g%%)",
-		myf->progressiveFrames, 100.0 * myf->progressiveFrames / (double)myf->numFrames,
-		myf->interlacedFrames, 100.0 * myf->interlacedFrames / (double)myf->numFrames);
-    tc_log_info(MOD_NAME, "RESULTS: FieldShift:  %d (%.3g%%)  Telecined:    %d (%.3g%%)",
-		myf->fieldShiftFrames, 100.0 * myf->fieldShiftFrames / (double)myf->numFrames,
-		myf->telecineFrames, 100.0 * myf->telecineFrames / (double)myf->numFrames);
-    tc_log_info(MOD_NAME, "RESULTS: MajorField: TopFirst %d (%.3g%%)  BottomFirst %d (%.3g%%)",
-		myf->topFirstFrames, 100.0 * myf->topFirstFrames / (double)totalfields,
-		myf->bottomFirstFrames, 100.0 * myf->bottomFirstFrames / (double)totalfields);
-
-	if (total < 50)
-	    tc_log_warn (MOD_NAME, "less than 50 frames analyzed correctly, no conclusion.");
-	else if (myf->unknownFrames * 10 > myf->numFrames * 9)
-	    tc_log_warn (MOD_NAME, "less than 10%% frames analyzed correctly, no conclusion.");
-	else if (myf->progressiveFrames * 8 > total * 7)
-	    tc_log_info (MOD_NAME, "CONCLUSION: progressive video.");
-	else if (myf->topFirstFrames * 8 > myf->bottomFirstFrames &&
-		 myf->bottomFirstFrames * 8 > myf->topFirstFrames)
-	    tc_log_info (MOD_NAME, "major field unsure, no conclusion. Use deinterlacer for processing.");
-	else if (myf->telecineFrames * 4 > total * 3)
-	    tc_log_info (MOD_NAME, "CONCLUSION: telecined video, %s field first.",
-                        myf->topFirstFrames > myf->bottomFirstFrames ? "top" : "bottom");
-	else if (myf->fieldShiftFrames * 4 > total * 3)
-	    tc_log_info (MOD_NAME, "CONCLUSION: field shifted progressive video, %s field first.",
-                        myf->topFirstFrames > myf->bottomFirstFrames ? "top" : "bottom");
-	else if (myf->interlacedFrames > myf->fieldShiftFrames &&
-		 (myf->interlacedFrames+myf->fieldShiftFrames) * 8 > total * 7)
-	    tc_log_info (MOD_NAME, "CONCLUSION: interlaced video, %s field first.",
-                        myf->topFirstFrames > myf->bottomFirstFrames ? "top" : "bottom");
-	else
-	    tc_log_info (MOD_NAME, "mixed video, no conclusion. Use deinterlacer for processing.");
+/**
+ * fieldanalysis_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-	tcv_free(myf->tcvhandle);
-	myf->tcvhandle = 0;
+static int fieldanalysis_configure(TCModuleInstance *self,
+                                   const char *options,
+                                   TCJob *vob,
+                                   TCModuleExtraData *xdata[])
+{
+    myfilter_t *myf = NULL;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    myf = self->userdata;
+
+    if (verbose)                /* global verbose */
+        tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+
+    /* default values */
+    myf->interlaceDiff       = 1.1;
+    myf->unknownDiff         = 1.5;
+    myf->progressiveDiff     = 8;
+    myf->progressiveChange   = 0.2;
+    myf->changedIfMore       = 10;
+
+    myf->forceTelecineDetect = 0;
+    myf->verbose             = 0;
+    myf->outDiff             = 0;
+
+    /* a new analysis */
+    myf->telecineState     = 0;
+    myf->numFrames         = 0;
+    myf->unknownFrames     = 0;
+    myf->topFirstFrames    = 0;
+    myf->bottomFirstFrames = 0;
+    myf->interlacedFrames  = 0;
+    myf->progressiveFrames = 0;
+    myf->fieldShiftFrames  = 0;
+    myf->telecineFrames    = 0;
+
+    /* video parameters */
+    switch (vob->im_v_codec) {
+      case TC_CODEC_YUY2:
+      case TC_CODEC_YUV420P:
+      case TC_CODEC_YUV422P:
+      case TC_CODEC_RGB24:
+        break;
+      default:
+        tc_log_error(MOD_NAME, "Unsupported codec - need one of"
+                               " RGB24 YUV420P YUY2 YUV422P");
+        return TC_ERROR;
+    }
+    myf->codec  = vob->im_v_codec;
+    myf->width  = vob->im_v_width;
+    myf->height = vob->im_v_height;
+    myf->fps    = vob->fps;
+    myf->size   = myf->width * myf->height;
+
+    if (options) {
+        optstr_get(options, "interlacediff",     "%lf",
+                   &myf->interlaceDiff);
+        optstr_get(options, "unknowndiff",       "%lf",
+                   &myf->unknownDiff);
+        optstr_get(options, "progressivediff",   "%lf",
+                   &myf->progressiveDiff);
+        optstr_get(options, "progressivechange", "%lf",
+                   &myf->progressiveChange);
+        optstr_get(options, "changedifmore",     "%lf",
+                   &myf->changedIfMore);
+        optstr_get(options, "forcetelecinedetect",
+                   "%d", &myf->forceTelecineDetect);
+        optstr_get(options, "verbose",           "%d", &myf->verbose);
+        optstr_get(options, "outdiff",           "%d", &myf->outDiff);
+
+        if (optstr_lookup(options, "help") != NULL) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s",
+                        MOD_CAP, fieldanalysis_help);
+        }
+    }
 
-	return 0;
+    myf->tcvhandle = tcv_init();
+    if (!myf->tcvhandle) {
+        tc_log_error(MOD_NAME, "tcv_init() failed");
+        return TC_ERROR;
     }
 
-    /*
-     * filter description
-     */
-    if (ptr->tag & TC_FILTER_GET_CONFIG) {
-	char buf[255];
-	optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION,
-			    MOD_AUTHOR, "VRY4E", "2");
-	tc_snprintf (buf, sizeof(buf), "%g", myf->interlaceDiff);
-	optstr_param (options, "interlacediff", "Minimum temporal inter-field difference for detecting interlaced video", "%f", buf, "1.0", "inf");
-	tc_snprintf (buf, sizeof(buf), "%g", myf->unknownDiff);
-	optstr_param (options, "unknowndiff", "Maximum inter-frame change vs. detail differences for neglecting interlaced video", "%f", buf, "1.0", "inf");
-	tc_snprintf (buf, sizeof(buf), "%g", myf->progressiveDiff);
-	optstr_param (options, "progressivediff", "Minimum inter-frame change vs. detail differences for detecting progressive video" ,"%f", buf, "unknowndiff", "inf");
-	tc_snprintf (buf, sizeof(buf), "%g", myf->progressiveChange);
-	optstr_param (options, "progressivechange", "Minimum temporal change needed for detecting progressive video" ,"%f", buf, "0", "inf");
-	tc_snprintf (buf, sizeof(buf), "%g", myf->changedIfMore);
-	optstr_param (options, "changedifmore", "Minimum temporal change for detecting truly changed frames" ,"%f", buf, "0", "65025");
-	tc_snprintf (buf, sizeof(buf), "%d", myf->forceTelecineDetect);
-	optstr_param (options, "forcetelecinedetect", "Detect telecine even on non-NTSC (29.97fps) video", "%d", buf, "0", "1");
-	tc_snprintf (buf, sizeof(buf), "%d", myf->verbose);
-	optstr_param (options, "verbose", "Output analysis for every frame", "%d", buf, "0", "2");
-	tc_snprintf (buf, sizeof(buf), "%d", myf->outDiff);
-	optstr_param (options, "outdiff", "Output internal debug frames as luminance of YUV video (see source)", "%d", buf, "0", "11");
+    /* frame memory */
+    myf->lumIn    = tc_zalloc(myf->size);
+    myf->lumPrev  = tc_zalloc(myf->size);
+    myf->lumInT   = tc_zalloc(myf->size);
+    myf->lumInB   = tc_zalloc(myf->size);
+    myf->lumPrevT = tc_zalloc(myf->size);
+    myf->lumPrevB = tc_zalloc(myf->size);
+    if (!myf->lumIn || !myf->lumPrev || !myf->lumInT || !myf->lumInB
+     || !myf->lumPrevT || !myf->lumPrevB) {
+        tc_log_error(MOD_NAME, "calloc() failed");
+        fieldanalysis_stop(self);
+        return TC_ERROR;
     }
 
-    /*
-     * filter frame routine
-     */
-    /* need to process frames in-order */
-    if ((ptr->tag & TC_PRE_S_PROCESS) && (ptr->tag & TC_VIDEO)) {
-
-	uint8_t *tmp;
-	int i, j;
-
-	assert (ptr->free == 0 || ptr->free == 1);
-	assert (ptr->video_buf_Y[!ptr->free] == ptr->video_buf);
-
-	/* Convert / Copy to luminance only */
-	switch (myf->codec) {
-	case TC_CODEC_RGB24:
-	    tcv_convert(myf->tcvhandle, ptr->video_buf, myf->lumIn,
-			myf->width, myf->height, IMG_RGB_DEFAULT, IMG_Y8);
-	    break;
-	case TC_CODEC_YUY2:
-	    tcv_convert(myf->tcvhandle, ptr->video_buf, myf->lumIn,
-			myf->width, myf->height, IMG_YUY2, IMG_Y8);
-	    break;
-	case TC_CODEC_YUV420P:
-	    tcv_convert(myf->tcvhandle, ptr->video_buf, myf->lumIn,
-			myf->width, myf->height, IMG_YUV_DEFAULT, IMG_Y8);
-	    break;
-	case TC_CODEC_YUV422P:
-	    tcv_convert(myf->tcvhandle, ptr->video_buf, myf->lumIn,
-			myf->width, myf->height, IMG_YUV422P, IMG_Y8);
-	    break;
-	default:
-	    assert (0);
-	}
+    if (verbose) {              /* global verbose */
+        tc_log_info(MOD_NAME, "interlacediff %.2f,  unknowndiff %.2f,"
+                              "  progressivediff %.2f",
+                    myf->interlaceDiff, myf->unknownDiff,
+                    myf->progressiveDiff);
+        tc_log_info(MOD_NAME, "progressivechange %.2f,"
+                              " changedifmore %.2f",
+                    myf->progressiveChange, myf->changedIfMore);
+        tc_log_info(MOD_NAME, "forcetelecinedetect %s, verbose %d,"
+                              " outdiff %d",
+                    myf->forceTelecineDetect ? "True":"False",
+                    myf->verbose, myf->outDiff);
+    }
+    return TC_OK;
+}
 
-	/* Bob Top field */
-	bob_field (myf->lumIn, myf->lumInT, myf->width, myf->height/2-1);
-	/* Bob Bottom field */
-	ac_memcpy (myf->lumInB, myf->lumIn + myf->width, myf->width);
-	bob_field (myf->lumIn + myf->width, myf->lumInB + myf->width,
-	           myf->width, myf->height/2-1);
-	/* last copied line is ignored, buffer is large enough */
-
-	if (myf->numFrames == 0)
-	    myf->numFrames++;
-	else if (! (ptr->tag & TC_FRAME_IS_SKIPPED)) {
-	    /* check_it */
-	    check_interlace (myf, ptr->id);
-	}
+/*************************************************************************/
 
-	/* only works with YUV data correctly */
-	switch (myf->outDiff) {
-	case 1:				/* lumIn */
-	    ac_memcpy (ptr->video_buf, myf->lumIn, myf->size);
-	    break;
-	case 2:				/* field shift */
-	    for (i = 0 ; i < myf->height-2; i += 2)
-		for (j = 0; j < myf->width; j++) {
-		    ptr->video_buf [myf->width*i+j] =
-			myf->lumIn [myf->width*i+j];
-		    ptr->video_buf [myf->width*(i+1)+j] =
-			myf->lumPrev [myf->width*(i+1)+j];
-		}
-	    break;
-	case 3:				/* lumInT */
-	    ac_memcpy (ptr->video_buf, myf->lumInT, myf->size);
-	    break;
-	case 4:				/* lumInB */
-	    ac_memcpy (ptr->video_buf, myf->lumInB, myf->size);
-	    break;
-	case 5:				/* lumPrevT */
-	    ac_memcpy (ptr->video_buf, myf->lumPrevT, myf->size);
-	    break;
-	case 6:				/* lumPrevB */
-	    ac_memcpy (ptr->video_buf, myf->lumPrevB, myf->size);
-	    break;
-	case 7:				/* pixDiff */
-	    pic_diff (myf->lumInT, myf->lumInB,   ptr->video_buf, myf->size,4);
-	    break;
-	case 8:				/* pixShiftChangedT */
-	    pic_diff (myf->lumInT, myf->lumPrevB, ptr->video_buf, myf->size,4);
-	    break;
-	case 9:				/* pixShiftChangedB */
-	    pic_diff (myf->lumInB, myf->lumPrevT, ptr->video_buf, myf->size,4);
-	    break;
-	case 10:			/* pixLastT */
-	    pic_diff (myf->lumInT, myf->lumPrevT, ptr->video_buf, myf->size,4);
-	    break;
-	case 11:			/* pixLastB */
-	    pic_diff (myf->lumInB, myf->lumPrevB, ptr->video_buf, myf->size,4);
-	    break;
-	}
+/**
+ * fieldanalysis_inspect:  Return the value of an option in this instance
+ * of the module.  See tcmodule-data.h for function details.
+ */
 
-	/* The current frame gets the next previous frame :-P */
-	tmp = myf->lumPrev;   myf->lumPrev  = myf->lumIn;   myf->lumIn  = tmp;
-	tmp = myf->lumPrevT;  myf->lumPrevT = myf->lumInT;  myf->lumInT = tmp;
-	tmp = myf->lumPrevB;  myf->lumPrevB = myf->lumInB;  myf->lumInB = tmp;
+static int fieldanalysis_inspect(TCModuleInstance *self,
+                                 const char *param, const char **value)
+{
+    myfilter_t *myf = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    myf = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = fieldanalysis_help;
+    }
+    if (optstr_lookup(param, "verbose")) {
+        tc_snprintf(myf->opt_buf, sizeof(myf->opt_buf), "%i",
+                    myf->verbose);
+        *value = myf->opt_buf;
+    }
+    if (optstr_lookup(param, "outdiff")) {
+        tc_snprintf(myf->opt_buf, sizeof(myf->opt_buf), "%i",
+                    myf->outDiff);
+        *value = myf->opt_buf;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * fieldanalysis_filter_video:  analyse the given frame.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int fieldanalysis_filter_video(TCModuleInstance *self,
+                                      vframe_list_t *frame)
+{
+    myfilter_t *myf = NULL;
+    uint8_t *tmp;
+    int i, j;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    myf = self->userdata;
+
+    /* Convert / Copy to luminance only */
+    switch (myf->codec) {
+      case TC_CODEC_RGB24:
+        tcv_convert(myf->tcvhandle, frame->video_buf, myf->lumIn,
+                    myf->width, myf->height, IMG_RGB_DEFAULT, IMG_Y8);
+        break;
+      case TC_CODEC_YUY2:
+        tcv_convert(myf->tcvhandle, frame->video_buf, myf->lumIn,
+                    myf->width, myf->height, IMG_YUY2, IMG_Y8);
+        break;
+      case TC_CODEC_YUV420P:
+        tcv_convert(myf->tcvhandle, frame->video_buf, myf->lumIn,
+                    myf->width, myf->height, IMG_YUV_DEFAULT, IMG_Y8);
+        break;
+      case TC_CODEC_YUV422P:
+        tcv_convert(myf->tcvhandle, frame->video_buf, myf->lumIn,
+                    myf->width, myf->height, IMG_YUV422P, IMG_Y8);
+        break;
+      default:
+        assert(0);
     }
 
-    return 0;
+    /* Bob Top field */
+    bob_field(myf->lumIn, myf->lumInT, myf->width, myf->height/2-1);
+    /* Bob Bottom field */
+    ac_memcpy(myf->lumInB, myf->lumIn + myf->width, myf->width);
+    bob_field(myf->lumIn + myf->width, myf->lumInB + myf->width,
+              myf->width, myf->height/2-1);
+    /* last copied line is ignored, buffer is large enough */
+
+    if (myf->numFrames == 0)
+        myf->numFrames++;
+    else if (!(frame->attributes & TC_FRAME_IS_SKIPPED)) {
+        /* check_it */
+        check_interlace(myf, frame->id);
+    }
+
+    /* only works with YUV data correctly */
+    switch (myf->outDiff) {
+      case 1:                   /* lumIn */
+        ac_memcpy(frame->video_buf, myf->lumIn, myf->size);
+        break;
+      case 2:                   /* field shift */
+        for (i = 0 ; i < myf->height-2; i += 2)
+            for (j = 0; j < myf->width; j++) {
+                frame->video_buf[myf->width*i+j] =
+                    myf->lumIn[myf->width*i+j];
+                frame->video_buf[myf->width*(i+1)+j] =
+                    myf->lumPrev[myf->width*(i+1)+j];
+            }
+        break;
+      case 3:                   /* lumInT */
+        ac_memcpy(frame->video_buf, myf->lumInT, myf->size);
+        break;
+      case 4:                   /* lumInB */
+        ac_memcpy(frame->video_buf, myf->lumInB, myf->size);
+        break;
+      case 5:                   /* lumPrevT */
+        ac_memcpy(frame->video_buf, myf->lumPrevT, myf->size);
+        break;
+      case 6:                   /* lumPrevB */
+        ac_memcpy(frame->video_buf, myf->lumPrevB, myf->size);
+        break;
+      case 7:                   /* pixDiff */
+        pic_diff(myf->lumInT, myf->lumInB,   frame->video_buf, myf->size, 4);
+        break;
+      case 8:                   /* pixShiftChangedT */
+        pic_diff(myf->lumInT, myf->lumPrevB, frame->video_buf, myf->size, 4);
+        break;
+      case 9:                   /* pixShiftChangedB */
+        pic_diff(myf->lumInB, myf->lumPrevT, frame->video_buf, myf->size, 4);
+        break;
+      case 10:                  /* pixLastT */
+        pic_diff(myf->lumInT, myf->lumPrevT, frame->video_buf, myf->size, 4);
+        break;
+      case 11:                  /* pixLastB */
+        pic_diff(myf->lumInB, myf->lumPrevB, frame->video_buf, myf->size, 4);
+        break;
+    }
+
+    /* The current frame gets the next previous frame :-P */
+    tmp = myf->lumPrev;   myf->lumPrev  = myf->lumIn;   myf->lumIn  = tmp;
+    tmp = myf->lumPrevT;  myf->lumPrevT = myf->lumInT;  myf->lumInT = tmp;
+    tmp = myf->lumPrevB;  myf->lumPrevB = myf->lumInB;  myf->lumInB = tmp;
+
+    return TC_OK;
 }
 
+/*************************************************************************/
+
+static const TCCodecID fieldanalysis_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_YUV422P, TC_CODEC_YUY2, TC_CODEC_RGB24,
+    TC_CODEC_ERROR
+};
+static const TCCodecID fieldanalysis_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_YUV422P, TC_CODEC_YUY2, TC_CODEC_RGB24,
+    TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(fieldanalysis);
+TC_MODULE_FILTER_FORMATS(fieldanalysis);
+
+TC_MODULE_INFO(fieldanalysis);
+
+static const TCModuleClass fieldanalysis_class = {
+    TC_MODULE_CLASS_HEAD(fieldanalysis),
+
+    .init         = fieldanalysis_init,
+    .fini         = fieldanalysis_fini,
+    .configure    = fieldanalysis_configure,
+    .stop         = fieldanalysis_stop,
+    .inspect      = fieldanalysis_inspect,
+
+    .filter_video = fieldanalysis_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(fieldanalysis)
+
+/*************************************************************************/
+
+static int fieldanalysis_get_config(TCModuleInstance *self, char *options)
+{
+    myfilter_t *myf = NULL;
+    char buf[255];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    myf = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRY4E", "2");
+    tc_snprintf(buf, sizeof(buf), "%g", myf->interlaceDiff);
+    optstr_param(options, "interlacediff",
+                 "Minimum temporal inter-field difference for detecting"
+                 " interlaced video", "%f", buf, "1.0", "inf");
+    tc_snprintf(buf, sizeof(buf), "%g", myf->unknownDiff);
+    optstr_param(options, "unknowndiff",
+                 "Maximum inter-frame change vs. detail differences for"
+                 " neglecting interlaced video", "%f", buf, "1.0", "inf");
+    tc_snprintf(buf, sizeof(buf), "%g", myf->progressiveDiff);
+    optstr_param(options, "progressivediff",
+                 "Minimum inter-frame change vs. detail differences for"
+                 " detecting progressive video",
+                 "%f", buf, "unknowndiff", "inf");
+    tc_snprintf(buf, sizeof(buf), "%g", myf->progressiveChange);
+    optstr_param(options, "progressivechange",
+                 "Minimum temporal change needed for detecting"
+                 " progressive video", "%f", buf, "0", "inf");
+    tc_snprintf(buf, sizeof(buf), "%g", myf->changedIfMore);
+    optstr_param(options, "changedifmore",
+                 "Minimum temporal change for detecting truly changed"
+                 " frames", "%f", buf, "0", "65025");
+    tc_snprintf(buf, sizeof(buf), "%d", myf->forceTelecineDetect);
+    optstr_param(options, "forcetelecinedetect",
+                 "Detect telecine even on non-NTSC (29.97fps) video",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", myf->verbose);
+    optstr_param(options, "verbose", "Output analysis for every frame",
+                 "%d", buf, "0", "2");
+    tc_snprintf(buf, sizeof(buf), "%d", myf->outDiff);
+    optstr_param(options, "outdiff",
+                 "Output internal debug frames as luminance of YUV video"
+                 " (see source)", "%d", buf, "0", "11");
+    return TC_OK;
+}
+
+static int fieldanalysis_process(TCModuleInstance *self,
+                                 frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    /* need to process frames in-order */
+    if ((frame->tag & TC_PRE_S_PROCESS) && (frame->tag & TC_VIDEO)) {
+        return fieldanalysis_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(fieldanalysis)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
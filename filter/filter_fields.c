@@ -200,7 +200,7 @@ static int fields_configure(TCModuleInstance *self,
 
     // Some of the data in buffer may get used for half of the first frame (when
     // shifting) so make sure it's blank to start with.
-    pd->buffer = tc_zalloc(SIZE_RGB_FRAME);
+    pd->buffer = tc_zalloc(TC_JOB_FRAME_SIZE(vob));
     if (!pd->buffer) {
         tc_log_error(MOD_NAME, "Unable to allocate memory.  Aborting.");
         return TC_ERROR;
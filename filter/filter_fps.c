@@ -22,50 +22,66 @@
  */
 
 #define MOD_NAME    "filter_fps.so"
-#define MOD_VERSION "v1.1 (2004-05-01)"
+#define MOD_VERSION "v1.2 (2026-10-18)"
 #define MOD_CAP     "convert video frame rate, gets defaults from -f and --export_fps"
 #define MOD_AUTHOR  "Christopher Cramer"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_READONLY
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
+
+
+static const char fps_help[] = ""
+"This filter converts the video frame rate, by repeating or dropping frames.\n"
+"options: <input fps>:<output fps>\n"
+"example: -J fps=25:29.97 will convert from PAL to NTSC\n"
+"In addition to the frame rate options, you may also specify pre or post.\n"
+"If no rate options are given, defaults or -f/--export_fps/--export_frc will\n"
+"be used.\n"
+"If no pre or post options are given, decreasing rates will preprocess and\n"
+"increasing rates will postprocess.\n";
+
+/*************************************************************************/
 
+typedef struct FPSPrivateData_ {
+	double		infps, outfps;
+	unsigned long	framesin, framesout;
+	int		pre;
+
+	char		opt_buf[TC_BUF_MIN];
+} FPSPrivateData;
+
+/*************************************************************************/
 
 static int
-parse_options(char *options, int *pre, double *infps, double *outfps)
+parse_options(const char *options, int *pre, double *infps, double *outfps,
+	      const vob_t *vob)
 {
 	char	*p, *pbase, *q, *r;
 	size_t	len;
-	vob_t	*vob;
-	int	default_pre, i;
+	int	default_pre, i, ret = 0;
 
 	/* defaults from -f and --export_fps */
-	vob = tc_get_vob();
-	if (!vob) return -1;
 	*infps = vob->fps;
 	*outfps = vob->ex_fps;
 	default_pre = 1;
 
 	if (!options || !*options) return 0;
 	if (!strcmp(options, "help")) {
-		tc_log_info(MOD_NAME, "(%s) help\n"
-"This filter converts the video frame rate, by repeating or dropping frames.\n"
-"options: <input fps>:<output fps>\n"
-"example: -J fps=25:29.97 will convert from PAL to NTSC\n"
-"In addition to the frame rate options, you may also specify pre or post.\n"
-"If no rate options are given, defaults or -f/--export_fps/--export_frc will\n"
-"be used.\n"
-"If no pre or post options are given, decreasing rates will preprocess and\n"
-"increasing rates will postprocess.\n"
-			    , MOD_CAP);
+		tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, fps_help);
 		return -1;
 	}
 
 	len = strlen(options);
-	p = pbase = malloc(len + 1);
-	ac_memcpy(p, options, len);
-	p[len] = '\0';
+	p = pbase = tc_strdup(options);
+	if (!pbase) return -1;
 
 	i = 0;
 	do {
@@ -76,80 +92,239 @@ parse_options(char *options, int *pre, double *infps, double *outfps)
 			default_pre = 0;
 		} else if (!strncmp(p, "pre=", 4) && *(p + 4)) {
 			*pre = strtol(p + 4, &r, 0);
-			if (r == p) return -1;
+			if (r == p) { ret = -1; break; }
 			default_pre = 0;
 		} else if (!strcmp(p, "post")) {
 			*pre = 0;
 			default_pre = 0;
 		} else if (!strncmp(p, "post=", 5) && *(p + 5)) {
 			*pre = !strtol(p + 4, &r, 0);
-			if (r == p) return -1;
+			if (r == p) { ret = -1; break; }
 			default_pre = 0;
 		} else {
 			if (i == 0) {
 				*infps = strtod(p, &r);
-				if (r == p) return -1;
+				if (r == p) { ret = -1; break; }
 			} else if (i == 1) {
 				*outfps = strtod(p, &r);
-				if (r == p) return -1;
-			} else return -1;
+				if (r == p) { ret = -1; break; }
+			} else { ret = -1; break; }
 			i++;
 		}
 	} while (q && (p = q));
 
-	free(pbase);
+	tc_free(pbase);
 
 	if (default_pre) {
 		if (*infps > *outfps) *pre = 1;
 		else if (*infps < *outfps) *pre = 0;
 	}
 
-	return 0;
+	return ret;
 }
 
-int
-tc_filter(frame_list_t *ptr_, char *options)
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * fps_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(fps, FPSPrivateData)
+
+/*************************************************************************/
+
+/**
+ * fps_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(fps)
+
+/*************************************************************************/
+
+/**
+ * fps_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int fps_configure(TCModuleInstance *self,
+                         const char *options,
+                         TCJob *vob,
+                         TCModuleExtraData *xdata[])
 {
-	vframe_list_t *ptr = (vframe_list_t *)ptr_;
-	static double		infps, outfps;
-	static unsigned long	framesin = 0, framesout = 0;
-	static int		pre = 0;
-
-	if(ptr->tag & TC_FILTER_GET_CONFIG) {
-	    optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION,
-		"Christopher Cramer", "VRYEO", "1");
-	    return 0;
-	}
+    FPSPrivateData *pd = NULL;
 
-	if(ptr->tag & TC_FILTER_INIT) {
-		if (verbose) tc_log_info(MOD_NAME, "%s %s",
-			MOD_VERSION, MOD_CAP);
-		if (parse_options(options, &pre, &infps, &outfps) == -1)
-			return -1;
-		if (verbose && options) tc_log_info(MOD_NAME, "options=%s",
-			options);
-		if (verbose && !options) tc_log_info(MOD_NAME, "no options");
-		if (verbose) tc_log_info(MOD_NAME, "converting from %g fps to %g fps,"
-			" %sprocessing", infps, outfps, pre ? "pre" : "post");
-		return 0;
-	}
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
 
-	if (ptr->tag & TC_VIDEO && ((pre && ptr->tag & TC_PRE_S_PROCESS)
-			|| (!pre && ptr->tag & TC_POST_S_PROCESS))) {
-		if (infps > outfps) {
-			if ((double)++framesin / infps >
-					(double)framesout / outfps)
-				framesout++;
-			else ptr->attributes |= TC_FRAME_IS_SKIPPED;
-			return 0;
-		} else if (infps < outfps) {
-			if (!(ptr->attributes & TC_FRAME_WAS_CLONED))
-				framesin++;
-			if ((double)framesin / infps >
-				(double)++framesout / outfps)
-				ptr->attributes |= TC_FRAME_IS_CLONED;
-		}
-	}
+    pd = self->userdata;
+    pd->framesin  = 0;
+    pd->framesout = 0;
+    pd->pre       = 0;
+
+    if (parse_options(options, &pd->pre, &pd->infps, &pd->outfps, vob) < 0)
+        return TC_ERROR;
+
+    if (verbose) {
+        if (options)
+            tc_log_info(MOD_NAME, "options=%s", options);
+        else
+            tc_log_info(MOD_NAME, "no options");
+        tc_log_info(MOD_NAME, "converting from %g fps to %g fps,"
+                    " %sprocessing", pd->infps, pd->outfps,
+                    pd->pre ? "pre" : "post");
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * fps_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int fps_stop(TCModuleInstance *self)
+{
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * fps_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
+
+static int fps_inspect(TCModuleInstance *self,
+                       const char *param, const char **value)
+{
+    FPSPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = fps_help;
+    }
+    if (optstr_lookup(param, "fps")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%g:%g:%s",
+                    pd->infps, pd->outfps, pd->pre ? "pre" : "post");
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * fps_filter_video:  drop or clone the given frame to match the output
+ * frame rate.  See tcmodule-data.h for function details.
+ */
+
+static int fps_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    FPSPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+
+    if (pd->infps > pd->outfps) {
+        if ((double)++pd->framesin / pd->infps >
+                (double)pd->framesout / pd->outfps)
+            pd->framesout++;
+        else
+            frame->attributes |= TC_FRAME_IS_SKIPPED;
+    } else if (pd->infps < pd->outfps) {
+        if (!(frame->attributes & TC_FRAME_WAS_CLONED))
+            pd->framesin++;
+        if ((double)pd->framesin / pd->infps >
+                (double)++pd->framesout / pd->outfps)
+            frame->attributes |= TC_FRAME_IS_CLONED;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID fps_codecs_video_in[] = {
+    TC_CODEC_ANY, TC_CODEC_ERROR
+};
+static const TCCodecID fps_codecs_video_out[] = {
+    TC_CODEC_ANY, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(fps);
+TC_MODULE_FILTER_FORMATS(fps);
 
-	return 0;
+TC_MODULE_INFO(fps);
+
+static const TCModuleClass fps_class = {
+    TC_MODULE_CLASS_HEAD(fps),
+
+    .init         = fps_init,
+    .fini         = fps_fini,
+    .configure    = fps_configure,
+    .stop         = fps_stop,
+    .inspect      = fps_inspect,
+
+    .filter_video = fps_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(fps)
+
+/*************************************************************************/
+
+static int fps_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRYEO", "1");
+    return TC_OK;
+}
+
+static int fps_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    FPSPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    pd = self->userdata;
+
+    /* single-threaded stages only: frames come in order */
+    if (frame->tag & TC_VIDEO
+     && ((pd->pre && frame->tag & TC_PRE_S_PROCESS)
+      || (!pd->pre && frame->tag & TC_POST_S_PROCESS))) {
+        return fps_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(fps)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -18,14 +18,21 @@
 */
 
 #define MOD_NAME    "filter_hqdn3d.so"
-#define MOD_VERSION "v1.0.2 (2003-08-15)"
+#define MOD_VERSION "v1.1.0 (2026-10-18)"
 #define MOD_CAP     "High Quality 3D Denoiser"
 #define MOD_AUTHOR  "Daniel Moreno, A'rpi"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_BUFFERING|TC_MODULE_FLAG_SLICE_PARALLEL
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
+#include "libtcmodule/tcmodule-slice.h"
 
 #include <math.h>
 
@@ -34,14 +41,33 @@
 #define PARAM2_DEFAULT 3.0
 #define PARAM3_DEFAULT 6.0
 
+static const char hqdn3d_help[] = ""
+    "Overview\n"
+    "    This filter aims to reduce image noise producing\n"
+    "    smooth images and making still images really still\n"
+    "    (This should enhance compressibility).\n"
+    "Options\n"
+    "    luma             spatial luma strength [4.0]\n"
+    "    chroma           spatial chroma strength [3.0]\n"
+    "    luma_strength    temporal luma strength [6.0]\n"
+    "    chroma_strength  temporal chroma strength [4.5]\n"
+    "    pre              run as a pre filter [0]\n";
+
 //===========================================================================//
 
-typedef struct vf_priv_s {
-        int Coefs[4][512*16];
-        unsigned int *Line;
-	unsigned short *Frame[3];
-	int pre;
-} MyFilterData;
+/* The temporal low-pass feeds on the previous output (Frame[]), so the
+ * frames must come in order. */
+
+typedef struct Hqdn3dPrivateData_ {
+    int Coefs[4][512*16];
+    unsigned int *Work;
+    int WorkSize;
+    unsigned short *Frame[3];
+    int pre;
+    double LumSpac, LumTmp, ChromSpac, ChromTmp;
+
+    char opt_buf[TC_BUF_MIN];
+} Hqdn3dPrivateData;
 
 
 /***************************************************************************/
@@ -53,17 +79,85 @@ static inline unsigned int LowPassMul(unsigned int PrevMul, unsigned int CurrMul
     return CurrMul + Coef[d];
 }
 
+/*
+ * The denoiser is a cascade of three first order IIR low-passes:
+ * left to right, top to bottom and previous frame to current frame.
+ * The horizontal one only depends on the row, the vertical and the
+ * temporal ones only on the column: so the first pass is split into
+ * bands of rows, the second into bands of columns, and the two passes
+ * are run back to back through the slice pool. The results are the
+ * same, bit by bit, as running the three filters interleaved.
+ */
+
+typedef struct denoiseplane_ {
+    unsigned char *Frame;       /* source (may be the same as FrameDest) */
+    unsigned char *FrameDest;
+    unsigned int *Work;         /* W*H, low-passed pixels in 16.16 */
+    unsigned short *FrameAnt;   /* W*H, previous output in 8.8 */
+    int W, H, sStride, dStride;
+    int *Horizontal, *Vertical, *Temporal;
+} DeNoisePlane;
+
+/* rows [first, last) of the horizontal low-pass */
+static void deNoiseRows(void *data, int first, int last, int slot)
+{
+    DeNoisePlane *P = data;
+    int X, Y;
+
+    for (Y = first; Y < last; Y++) {
+        unsigned char *src = P->Frame + Y*P->sStride;
+        unsigned int *dst = P->Work + Y*P->W;
+        unsigned int PixelAnt = src[0]<<16;
+
+        /* First pixel on each line doesn't have previous pixel */
+        dst[0] = PixelAnt;
+        for (X = 1; X < P->W; X++) {
+            dst[X] = PixelAnt = LowPassMul(PixelAnt, src[X]<<16,
+                                           P->Horizontal);
+        }
+    }
+}
+
+/* columns [first, last) of the vertical and temporal low-passes */
+static void deNoiseColumns(void *data, int first, int last, int slot)
+{
+    DeNoisePlane *P = data;
+    unsigned int *LineAnt = P->Work;
+    int X, Y;
+    int PixelDst;
+
+    /* Fist line has no top neightbour. Only left one for each pixel and
+     * last frame */
+    for (X = first; X < last; X++) {
+        PixelDst = LowPassMul(P->FrameAnt[X]<<8, LineAnt[X], P->Temporal);
+        P->FrameAnt[X] = ((PixelDst+0x1000007F)/256);
+        P->FrameDest[X] = ((PixelDst+0x10007FFF)/65536);
+    }
+
+    for (Y = 1; Y < P->H; Y++) {
+        unsigned int *Line = P->Work + Y*P->W;
+        unsigned short *LinePrev = P->FrameAnt + Y*P->W;
+        unsigned char *dst = P->FrameDest + Y*P->dStride;
+
+        for (X = first; X < last; X++) {
+            Line[X] = LowPassMul(LineAnt[X], Line[X], P->Vertical);
+            PixelDst = LowPassMul(LinePrev[X]<<8, Line[X], P->Temporal);
+            LinePrev[X] = ((PixelDst+0x1000007F)/256);
+            dst[X] = ((PixelDst+0x10007FFF)/65536);
+        }
+        LineAnt = Line;
+    }
+}
+
 static void deNoise(unsigned char *Frame,        // mpi->planes[x]
                     unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,      // vf->priv->Line (width bytes)
+                    unsigned int *Work,         // vf->priv->Work (W*H)
 		    unsigned short **FrameAntPtr,
                     int W, int H, int sStride, int dStride,
                     int *Horizontal, int *Vertical, int *Temporal)
 {
     int X, Y;
-    int sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
-    int PixelDst;
+    DeNoisePlane P;
     unsigned short* FrameAnt=(*FrameAntPtr);
 
     if(!FrameAnt){
@@ -75,42 +169,20 @@ static void deNoise(unsigned char *Frame,        // mpi->planes[x]
 	}
     }
 
-    /* First pixel has no left nor top neightbour. Only previous frame */
-    LineAnt[0] = PixelAnt = Frame[0]<<16;
-    PixelDst = LowPassMul(FrameAnt[0]<<8, PixelAnt, Temporal);
-    FrameAnt[0] = ((PixelDst+0x1000007F)/256);
-    FrameDest[0]= ((PixelDst+0x10007FFF)/65536);
-
-    /* Fist line has no top neightbour. Only left one for each pixel and
-     * last frame */
-    for (X = 1; X < W; X++){
-        LineAnt[X] = PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        PixelDst = LowPassMul(FrameAnt[X]<<8, PixelAnt, Temporal);
-	FrameAnt[X] = ((PixelDst+0x1000007F)/256);
-	FrameDest[X]= ((PixelDst+0x10007FFF)/65536);
-    }
-
-    for (Y = 1; Y < H; Y++){
-	unsigned int PixelAnt;
-	unsigned short* LinePrev=&FrameAnt[Y*W];
-	sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-	PixelDst = LowPassMul(LinePrev[0]<<8, LineAnt[0], Temporal);
-	LinePrev[0] = ((PixelDst+0x1000007F)/256);
-	FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)/65536);
-
-        for (X = 1; X < W; X++){
-	    int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-	    PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
-	    LinePrev[X] = ((PixelDst+0x1000007F)/256);
-	    FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)/65536);
-        }
-    }
+    P.Frame = Frame;
+    P.FrameDest = FrameDest;
+    P.Work = Work;
+    P.FrameAnt = FrameAnt;
+    P.W = W;
+    P.H = H;
+    P.sStride = sStride;
+    P.dStride = dStride;
+    P.Horizontal = Horizontal;
+    P.Vertical = Vertical;
+    P.Temporal = Temporal;
+
+    tc_module_slice_run(deNoiseRows, &P, H, 16);
+    tc_module_slice_run(deNoiseColumns, &P, W, 64);
 }
 
 
@@ -132,203 +204,319 @@ static void PrecalcCoefs(int *Ct, double Dist25)
     }
 }
 
-static void help_optstr(void)
-{
-    tc_log_info(MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"  This filter aims to reduce image noise producing\n"
-"  smooth images and making still images really still\n"
-"  (This should enhance compressibility).\n"
-"* Options\n"
-"             luma : spatial luma strength (%f)\n"
-"           chroma : spatial chroma strength (%f)\n"
-"    luma_strength : temporal luma strength (%f)\n"
-"  chroma_strength : temporal chroma strength (%f)\n"
-"              pre : run as a pre filter (0)\n"
-		, MOD_CAP,
-		PARAM1_DEFAULT,
-		PARAM2_DEFAULT,
-		PARAM3_DEFAULT,
-		PARAM3_DEFAULT*PARAM2_DEFAULT/PARAM1_DEFAULT);
-}
+/*************************************************************************/
 
-// main filter routine
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
-  /* FIXME: these use the filter ID as an index--the ID can grow
-   * arbitrarily large, so this needs to be fixed */
-  static MyFilterData *mfd[100];
-  static char *buffer[100];
-  int instance = ptr->filter_id;
+/* Module interface routines and data. */
 
+/*************************************************************************/
 
-  if(ptr->tag & TC_AUDIO)
-      return 0;
+/**
+ * hqdn3d_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
+TC_MODULE_GENERIC_INIT(hqdn3d, Hqdn3dPrivateData)
 
-      char buf[128];
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VYMOE", "2");
+/*************************************************************************/
 
-      tc_snprintf(buf, 128, "%f", PARAM1_DEFAULT);
-      optstr_param (options, "luma", "spatial luma strength", "%f", buf, "0.0", "100.0" );
+/**
+ * hqdn3d_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-      tc_snprintf(buf, 128, "%f", PARAM2_DEFAULT);
-      optstr_param (options, "chroma", "spatial chroma strength", "%f", buf, "0.0", "100.0" );
+TC_MODULE_GENERIC_FINI(hqdn3d)
 
-      tc_snprintf(buf, 128, "%f", PARAM3_DEFAULT);
-      optstr_param (options, "luma_strength", "temporal luma strength", "%f", buf, "0.0", "100.0" );
+/*************************************************************************/
 
-      tc_snprintf(buf, 128, "%f", PARAM3_DEFAULT*PARAM2_DEFAULT/PARAM1_DEFAULT);
-      optstr_param (options, "chroma_strength", "temporal chroma strength", "%f", buf, "0.0", "100.0" );
-      tc_snprintf(buf, 128, "%d", mfd[instance]->pre);
-      optstr_param (options, "pre", "run as a pre filter", "%d", buf, "0", "1" );
+/**
+ * hqdn3d_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-      return 0;
-  }
+static int hqdn3d_configure(TCModuleInstance *self,
+                            const char *options,
+                            TCJob *vob,
+                            TCModuleExtraData *xdata[])
+{
+    Hqdn3dPrivateData *pd = NULL;
+    double Param1 = 0.0, Param2 = 0.0, Param3 = 0.0, Param4 = 0.0;
 
-  if(ptr->tag & TC_FILTER_INIT) {
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
 
-      double LumSpac, LumTmp, ChromSpac, ChromTmp;
-      double Param1=0.0, Param2=0.0, Param3=0.0, Param4=0.0;
+    pd = self->userdata;
 
-      if((vob = tc_get_vob())==NULL) return(-1);
+    if (vob->im_v_codec != TC_CODEC_YUV420P) {
+        tc_log_error(MOD_NAME, "This filter is only capable of YUV 4:2:0 mode");
+        return TC_ERROR;
+    }
 
-      if (vob->im_v_codec != TC_CODEC_YUV420P) {
-	  tc_log_error(MOD_NAME, "This filter is only capable of YUV 4:2:0 mode");
-	  return -1;
-      }
+    // defaults
 
-      mfd[instance] = tc_zalloc(sizeof(MyFilterData));
+    pd->pre = 0;
+    pd->LumSpac = PARAM1_DEFAULT;
+    pd->LumTmp = PARAM3_DEFAULT;
 
-      if (mfd[instance]) {
-	  mfd[instance]->Line = tc_zalloc(TC_MAX_V_FRAME_WIDTH*sizeof(int));
-      }
+    pd->ChromSpac = PARAM2_DEFAULT;
+    pd->ChromTmp = pd->LumTmp * pd->ChromSpac / pd->LumSpac;
 
-      buffer[instance] = tc_zalloc(SIZE_RGB_FRAME);
+    if (options) {
+        if (optstr_lookup(options, "help")) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, hqdn3d_help);
+        }
 
-      if (!mfd[instance] || !mfd[instance]->Line || !buffer[instance]) {
-	  tc_log_error(MOD_NAME, "Malloc failed");
-	  return -1;
-      }
+        optstr_get(options, "luma",            "%lf", &Param1);
+        optstr_get(options, "luma_strength",   "%lf", &Param3);
+        optstr_get(options, "chroma",          "%lf", &Param2);
+        optstr_get(options, "chroma_strength", "%lf", &Param4);
+        optstr_get(options, "pre",             "%d",  &pd->pre);
 
+        // recalculate only the needed params
 
-      // defaults
+        if (Param1 != 0.0) {
+            pd->LumSpac = Param1;
+            pd->LumTmp = PARAM3_DEFAULT * Param1 / PARAM1_DEFAULT;
 
-      LumSpac = PARAM1_DEFAULT;
-      LumTmp = PARAM3_DEFAULT;
+            pd->ChromSpac = PARAM2_DEFAULT * Param1 / PARAM1_DEFAULT;
+            pd->ChromTmp = pd->LumTmp * pd->ChromSpac / pd->LumSpac;
+        }
+        if (Param2 != 0.0) {
+            pd->ChromSpac = Param2;
+            pd->ChromTmp = pd->LumTmp * pd->ChromSpac / pd->LumSpac;
+        }
+        if (Param3 != 0.0) {
+            pd->LumTmp = Param3;
+            pd->ChromTmp = pd->LumTmp * pd->ChromSpac / pd->LumSpac;
+        }
+        if (Param4 != 0.0) {
+            pd->ChromTmp = Param4;
+        }
+    }
 
-      ChromSpac = PARAM2_DEFAULT;
-      ChromTmp = LumTmp * ChromSpac / LumSpac;
+    PrecalcCoefs(pd->Coefs[0], pd->LumSpac);
+    PrecalcCoefs(pd->Coefs[1], pd->LumTmp);
+    PrecalcCoefs(pd->Coefs[2], pd->ChromSpac);
+    PrecalcCoefs(pd->Coefs[3], pd->ChromTmp);
 
-      if (options) {
+    if (verbose) {
+        tc_log_info(MOD_NAME, "Settings luma=%.2f chroma=%.2f"
+                    " luma_strength=%.2f chroma_strength=%.2f",
+                    pd->LumSpac, pd->ChromSpac, pd->LumTmp, pd->ChromTmp);
+    }
+    return TC_OK;
+}
 
-	  if (optstr_lookup (options, "help")) {
-	      help_optstr();
-	  }
+/*************************************************************************/
 
-	  optstr_get (options, "luma",           "%lf",    &Param1);
-	  optstr_get (options, "luma_strength",  "%lf",    &Param3);
-	  optstr_get (options, "chroma",         "%lf",    &Param2);
-	  optstr_get (options, "chroma_strength","%lf",    &Param4);
-	  optstr_get (options, "pre", "%d",    &mfd[instance]->pre);
+/**
+ * hqdn3d_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
 
-	  // recalculate only the needed params
+static int hqdn3d_stop(TCModuleInstance *self)
+{
+    Hqdn3dPrivateData *pd = NULL;
+    int i;
 
-	  if (Param1!=0.0) {
+    TC_MODULE_SELF_CHECK(self, "stop");
 
-	      LumSpac = Param1;
-	      LumTmp = PARAM3_DEFAULT * Param1 / PARAM1_DEFAULT;
+    pd = self->userdata;
 
-	      ChromSpac = PARAM2_DEFAULT * Param1 / PARAM1_DEFAULT;
-	      ChromTmp = LumTmp * ChromSpac / LumSpac;
-	  }
-	  if (Param2!=0.0) {
+    tc_free(pd->Work);
+    pd->Work = NULL;
+    pd->WorkSize = 0;
+    for (i = 0; i < 3; i++) {
+        tc_free(pd->Frame[i]);
+        pd->Frame[i] = NULL;
+    }
+    return TC_OK;
+}
 
-	      ChromSpac = Param2;
-	      ChromTmp = LumTmp * ChromSpac / LumSpac;
-	  }
-	  if (Param3!=0.0) {
+/*************************************************************************/
 
-	      LumTmp = Param3;
-	      ChromTmp = LumTmp * ChromSpac / LumSpac;
+/**
+ * hqdn3d_inspect:  Return the value of an option in this instance of the
+ * module.  See tcmodule-data.h for function details.
+ */
 
-	  }
-	  if (Param4!=0.0) {
+static int hqdn3d_inspect(TCModuleInstance *self,
+                          const char *param, const char **value)
+{
+    Hqdn3dPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-	      ChromTmp = Param4;
-	  }
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = hqdn3d_help;
+    }
+    if (optstr_lookup(param, "luma")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%f", pd->LumSpac);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "chroma")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%f", pd->ChromSpac);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "luma_strength")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%f", pd->LumTmp);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "chroma_strength")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%f", pd->ChromTmp);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "pre")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->pre);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
 
-      }
+/*************************************************************************/
 
-      PrecalcCoefs(mfd[instance]->Coefs[0], LumSpac);
-      PrecalcCoefs(mfd[instance]->Coefs[1], LumTmp);
-      PrecalcCoefs(mfd[instance]->Coefs[2], ChromSpac);
-      PrecalcCoefs(mfd[instance]->Coefs[3], ChromTmp);
+/**
+ * hqdn3d_filter_video:  denoise the given frame.  See tcmodule-data.h
+ * for function details.
+ */
 
+static int hqdn3d_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    Hqdn3dPrivateData *pd = NULL;
+    int w, h;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+    w = frame->v_width;
+    h = frame->v_height;
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+
+    if (pd->WorkSize < w*h) {
+        tc_free(pd->Work);
+        pd->WorkSize = w*h;
+        pd->Work = tc_malloc(pd->WorkSize*sizeof(int));
+        if (!pd->Work) {
+            tc_log_error(MOD_NAME, "Malloc failed");
+            pd->WorkSize = 0;
+            return TC_ERROR;
+        }
+    }
 
-      if(verbose) {
-	  tc_log_info(MOD_NAME, "%s %s #%d", MOD_VERSION, MOD_CAP, instance);
-	  tc_log_info(MOD_NAME, "Settings luma=%.2f chroma=%.2f luma_strength=%.2f chroma_strength=%.2f",
-		  LumSpac, ChromSpac, LumTmp, ChromTmp);
-      }
-      return 0;
-  }
+    /* every source pixel is read before the first one is written
+     * (see above), so the frame can be denoised in place */
+    deNoise(frame->video_buf, frame->video_buf,
+            pd->Work, &pd->Frame[0], w, h, w, w,
+            pd->Coefs[0], pd->Coefs[0], pd->Coefs[1]);
 
+    deNoise(frame->video_buf + w*h, frame->video_buf + w*h,
+            pd->Work, &pd->Frame[1], w>>1, h>>1, w>>1, w>>1,
+            pd->Coefs[2], pd->Coefs[2], pd->Coefs[3]);
 
+    deNoise(frame->video_buf + 5*w*h/4, frame->video_buf + 5*w*h/4,
+            pd->Work, &pd->Frame[2], w>>1, h>>1, w>>1, w>>1,
+            pd->Coefs[2], pd->Coefs[2], pd->Coefs[3]);
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
+    return TC_OK;
+}
 
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
+static const TCCodecID hqdn3d_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+static const TCCodecID hqdn3d_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(hqdn3d);
+TC_MODULE_FILTER_FORMATS(hqdn3d);
 
-      if (buffer[instance]) {free(buffer[instance]); buffer[instance]=NULL;}
-      if (mfd[instance]) {
-	  if(mfd[instance]->Line){free(mfd[instance]->Line);mfd[instance]->Line=NULL;}
-	  if(mfd[instance]->Frame[0]){free(mfd[instance]->Frame[0]);mfd[instance]->Frame[0]=NULL;}
-	  if(mfd[instance]->Frame[1]){free(mfd[instance]->Frame[1]);mfd[instance]->Frame[1]=NULL;}
-	  if(mfd[instance]->Frame[2]){free(mfd[instance]->Frame[2]);mfd[instance]->Frame[2]=NULL;}
-	  free(mfd[instance]);
-      }
-      mfd[instance]=NULL;
+TC_MODULE_INFO(hqdn3d);
 
-      return(0);
+static const TCModuleClass hqdn3d_class = {
+    TC_MODULE_CLASS_HEAD(hqdn3d),
 
-  } /* filter close */
+    .init         = hqdn3d_init,
+    .fini         = hqdn3d_fini,
+    .configure    = hqdn3d_configure,
+    .stop         = hqdn3d_stop,
+    .inspect      = hqdn3d_inspect,
 
-  //actually do the filter
+    .filter_video = hqdn3d_filter_video
+};
 
-  if(((ptr->tag & TC_PRE_M_PROCESS  && mfd[instance]->pre) ||
-	  (ptr->tag & TC_POST_M_PROCESS && !mfd[instance]->pre)) &&
-	  !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
+TC_MODULE_ENTRY_POINT(hqdn3d)
 
-      ac_memcpy (buffer[instance], ptr->video_buf, ptr->video_size);
+/*************************************************************************/
 
-      deNoise(buffer[instance],                                  ptr->video_buf,
-	      mfd[instance]->Line, &mfd[instance]->Frame[0], ptr->v_width, ptr->v_height,
-	      ptr->v_width,  ptr->v_width,
-	      mfd[instance]->Coefs[0], mfd[instance]->Coefs[0], mfd[instance]->Coefs[1]);
+static int hqdn3d_get_config(TCModuleInstance *self, char *options)
+{
+    Hqdn3dPrivateData *pd = NULL;
+    char buf[128];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VYMOE", "2");
+
+    tc_snprintf(buf, sizeof(buf), "%f", PARAM1_DEFAULT);
+    optstr_param(options, "luma", "spatial luma strength",
+                 "%f", buf, "0.0", "100.0");
+    tc_snprintf(buf, sizeof(buf), "%f", PARAM2_DEFAULT);
+    optstr_param(options, "chroma", "spatial chroma strength",
+                 "%f", buf, "0.0", "100.0");
+    tc_snprintf(buf, sizeof(buf), "%f", PARAM3_DEFAULT);
+    optstr_param(options, "luma_strength", "temporal luma strength",
+                 "%f", buf, "0.0", "100.0");
+    tc_snprintf(buf, sizeof(buf), "%f",
+                PARAM3_DEFAULT*PARAM2_DEFAULT/PARAM1_DEFAULT);
+    optstr_param(options, "chroma_strength", "temporal chroma strength",
+                 "%f", buf, "0.0", "100.0");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->pre);
+    optstr_param(options, "pre", "run as a pre filter",
+                 "%d", buf, "0", "1");
+    return TC_OK;
+}
 
-      deNoise(buffer[instance] + ptr->v_width*ptr->v_height,     ptr->video_buf + ptr->v_width*ptr->v_height,
-	      mfd[instance]->Line, &mfd[instance]->Frame[1], ptr->v_width>>1, ptr->v_height>>1,
-	      ptr->v_width>>1,  ptr->v_width>>1,
-	      mfd[instance]->Coefs[2], mfd[instance]->Coefs[2], mfd[instance]->Coefs[3]);
+static int hqdn3d_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    Hqdn3dPrivateData *pd = NULL;
 
-      deNoise(buffer[instance] + 5*ptr->v_width*ptr->v_height/4, ptr->video_buf + 5*ptr->v_width*ptr->v_height/4,
-	      mfd[instance]->Line, &mfd[instance]->Frame[2], ptr->v_width>>1, ptr->v_height>>1,
-	      ptr->v_width>>1,  ptr->v_width>>1,
-	      mfd[instance]->Coefs[2], mfd[instance]->Coefs[2], mfd[instance]->Coefs[3]);
+    TC_MODULE_SELF_CHECK(self, "process");
 
-  }
-  return 0;
+    pd = self->userdata;
 
+    if (!(frame->tag & TC_VIDEO))
+        return TC_OK;
+    if ((frame->tag & TC_PRE_M_PROCESS  && pd->pre)
+     || (frame->tag & TC_POST_M_PROCESS && !pd->pre)) {
+        return hqdn3d_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
 
+/*************************************************************************/
 
-//===========================================================================//
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(hqdn3d)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
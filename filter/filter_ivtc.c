@@ -23,267 +23,398 @@
  */
 
 #define MOD_NAME    "filter_ivtc.so"
-#define MOD_VERSION "v0.4.1 (2004-06-01)"
+#define MOD_VERSION "v0.5.0 (2026-10-18)"
 #define MOD_CAP     "NTSC inverse telecine plugin"
 #define MOD_AUTHOR  "Thanassis Tsiodras"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_DELAY|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
+#include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
+
+
+static const char ivtc_help[] = ""
+    "Overview\n"
+    "    Inverse telecine: rebuilds each frame from the best matching\n"
+    "    fields of the previous, current and next frames.\n"
+    "Options\n"
+    "    verbose  print verbose information [off]\n"
+    "    field    which field to replace (0=top 1=bottom) [0]\n"
+    "    magic    perform magic? (0=no 1=yes) [0]\n";
+
+#define FRBUFSIZ 3
 
+/*************************************************************************/
 
-static int show_results=0;
+typedef struct IVTCPrivateData_ {
+    int show_results;
+    int field;
+    int magic;
 
-static void ivtc_copy_field (unsigned char *dest, unsigned char *src, vframe_list_t * ptr, int field) {
+    uint8_t *lastFrames[FRBUFSIZ];  /* ring of the last input frames */
+    int frameIn;                    /* next slot of the ring */
+    int frameCount;                 /* frames seen so far */
+
+    char opt_buf[TC_BUF_MIN];
+} IVTCPrivateData;
+
+/*************************************************************************/
+
+static void ivtc_copy_field(uint8_t *dest, const uint8_t *src,
+                            const vframe_list_t *frame, int field)
+{
     int y;
 
     if (field == 1) {
-	src  += ptr->v_width;
-	dest += ptr->v_width;
+        src  += frame->v_width;
+        dest += frame->v_width;
     }
 
-    for (y = 0; y < (ptr->v_height+1)/2; y++) {
-	ac_memcpy(dest, src, ptr->v_width);
-	src  += ptr->v_width*2;
-	dest += ptr->v_width*2;
+    for (y = 0; y < (frame->v_height+1)/2; y++) {
+        ac_memcpy(dest, src, frame->v_width);
+        src  += frame->v_width*2;
+        dest += frame->v_width*2;
     }
 
     if (field == 1) {
-	src  -= (ptr->v_width+1) / 2;
-	dest -= (ptr->v_width+1) / 2;
+        src  -= (frame->v_width+1) / 2;
+        dest -= (frame->v_width+1) / 2;
     }
 
-    for (y = 0; y < (ptr->v_height+1)/2; y++) {
-	ac_memcpy(dest, src, ptr->v_width/2);
-	src  += ptr->v_width;
-	dest += ptr->v_width;
+    for (y = 0; y < (frame->v_height+1)/2; y++) {
+        ac_memcpy(dest, src, frame->v_width/2);
+        src  += frame->v_width;
+        dest += frame->v_width;
     }
 }
 
+/* We have the last 3 frames in the buffer: previous, current, next.
+ * Try to match the top field of the current frame to the bottom fields
+ * of the previous, current, and next frames, and output the assembled
+ * frame that matches up best. For matching, subsample the frames in the
+ * x dimension for speed. */
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
+static void ivtc_telecide(IVTCPrivateData *pd, vframe_list_t *frame)
+{
+    const int w = frame->v_width;
+    const uint8_t *curr, *pprev, *pnext, *cprev, *cnext, *nprev, *nnext;
+    int idxp, idxc, idxn;
+    int p, c, n, lowest, chosen;
+    int C, x, y;
+    int comb;
+
+    idxn = pd->frameIn-1; while (idxn < 0) idxn += FRBUFSIZ;
+    idxc = pd->frameIn-2; while (idxc < 0) idxc += FRBUFSIZ;
+    idxp = pd->frameIn-3; while (idxp < 0) idxp += FRBUFSIZ;
+
+    y = (pd->field ? 2 : 1) * w;
+
+    // bottom field of current
+    curr =  &pd->lastFrames[idxc][y];
+    // top field of previous
+    pprev = &pd->lastFrames[idxp][y - w];
+    // top field of previous - 2nd scanline
+    pnext = &pd->lastFrames[idxp][y + w];
+    // top field of current
+    cprev = &pd->lastFrames[idxc][y - w];
+    // top field of current - 2nd scanline
+    cnext = &pd->lastFrames[idxc][y + w];
+    // top field of next
+    nprev = &pd->lastFrames[idxn][y - w];
+    // top field of next - 2nd scanline
+    nnext = &pd->lastFrames[idxn][y + w];
+
+    p = c = n = 0;
+    for (y = 0; y < frame->v_height-2; y += 4) {
+        for (x = 0; x < w;) {
+            C = curr[x];
+#define T 100
+            /* This combing metric is based on
+               an original idea of Gunnar Thalin. */
+            comb = ((long)pprev[x] - C) * ((long)pnext[x] - C);
+            if (comb > T) p++;
+
+            comb = ((long)cprev[x] - C) * ((long)cnext[x] - C);
+            if (comb > T) c++;
+
+            comb = ((long)nprev[x] - C) * ((long)nnext[x] - C);
+            if (comb > T) n++;
+
+            if (!(++x&3)) x += 12;
+        }
+        curr  += w*4;
+        pprev += w*4;
+        pnext += w*4;
+        cprev += w*4;
+        cnext += w*4;
+        nprev += w*4;
+        nnext += w*4;
+    }
 
-#define FRBUFSIZ 3
+    lowest = c;
+    chosen = 1;
+    if (p < lowest) {
+        lowest = p;
+        chosen = 0;
+    }
+    if (n < lowest) {
+        lowest = n;
+        chosen = 2;
+    }
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-    vframe_list_t *ptr = (vframe_list_t *)ptr_;
-    static vob_t *vob = NULL;
-    static char *lastFrames[FRBUFSIZ];
-    static int frameIn = 0;
-    static int frameCount = 0;
-    static int field = 0;
-    static int magic = 0;
-
-    //----------------------------------
-    //
-    // filter init
-    //
-    //----------------------------------
-
-
-    if (ptr->tag & TC_FILTER_GET_CONFIG) {
-	if (options) {
-	    optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "Thanassis Tsiodras", "VYE", "1");
-	    optstr_param (options, "verbose", "print verbose information", "", "0");
-	    optstr_param (options, "field", "which field to replace (0=top 1=bottom)",  "%d", "0",  "0", "1");
-	    optstr_param (options, "magic", "perform magic? (0=no 1=yes)",  "%d", "0",  "0", "1");
-	}
+    if (pd->magic && c < 50 && abs(lowest - c) < 10 && (p+c+n) > 1000) {
+        lowest = c;
+        chosen = 1;
     }
 
-    if (ptr->tag & TC_FILTER_INIT) {
+    if (pd->show_results)
+        tc_log_info(MOD_NAME,
+                    "Telecide => frame %d: p=%u  c=%u  n=%u [using %d]",
+                    pd->frameCount, p, c, n, chosen);
+
+    // First output the top field selected
+    // from the set of three stored frames.
+    curr = pd->lastFrames[(chosen == 0) ?idxp :(chosen == 1) ?idxc :idxn];
+    ivtc_copy_field(frame->video_buf, curr, frame, pd->field);
+
+    // The bottom field of the current frame unchanged
+    ivtc_copy_field(frame->video_buf, pd->lastFrames[idxc], frame,
+                    1 - pd->field);
+}
+
+/*************************************************************************/
+
+/* Module interface routines and data. */
 
-	int i;
+/*************************************************************************/
+
+/**
+ * ivtc_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-	if ((vob = tc_get_vob()) == NULL)
-	    return (-1);
+TC_MODULE_GENERIC_INIT(ivtc, IVTCPrivateData)
 
-	if (vob->im_v_codec != TC_CODEC_YUV420P) {
-		tc_log_error(MOD_NAME, "Sorry, only YUV 420 input allowed for now");
-		return (-1);
-	}
+/*************************************************************************/
 
-	// filter init ok.
-	if (options != NULL) {
+/**
+ * ivtc_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-	    if (optstr_lookup (options, "verbose") != NULL) {
-		show_results=1;
-	    }
+TC_MODULE_GENERIC_FINI(ivtc)
 
-	    optstr_get(options, "field", "%d", &field);
-	    optstr_get(options, "magic", "%d", &magic);
+/*************************************************************************/
 
-	}
+/**
+ * ivtc_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
 
-	if (verbose)
-	    tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+static int ivtc_stop(TCModuleInstance *self)
+{
+    IVTCPrivateData *pd = NULL;
+    int i;
 
-	for(i=0; i<FRBUFSIZ; i++) {
-	    lastFrames[i] = tc_malloc(SIZE_RGB_FRAME);
-    	}
+    TC_MODULE_SELF_CHECK(self, "stop");
 
-	return (0);
+    pd = self->userdata;
+    for (i = 0; i < FRBUFSIZ; i++) {
+        tc_free(pd->lastFrames[i]);
+        pd->lastFrames[i] = NULL;
     }
-    //----------------------------------
-    //
-    // filter close
-    //
-    //----------------------------------
+    return TC_OK;
+}
+
+/*************************************************************************/
 
+/**
+ * ivtc_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int ivtc_configure(TCModuleInstance *self,
+                          const char *options,
+                          TCJob *vob,
+                          TCModuleExtraData *xdata[])
+{
+    IVTCPrivateData *pd = NULL;
+    int i;
 
-    if (ptr->tag & TC_FILTER_CLOSE) {
-	int i;
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
 
-	for(i=0; i<FRBUFSIZ; i++)
-	    free(lastFrames[i]);
-	return (0);
+    pd = self->userdata;
+
+    if (vob->im_v_codec != TC_CODEC_YUV420P) {
+        tc_log_error(MOD_NAME, "Sorry, only YUV 420 input allowed for now");
+        return TC_ERROR;
     }
-    //----------------------------------
-    //
-    // filter frame routine
-    //
-    //----------------------------------
-
-
-    // tag variable indicates, if we are called before
-    // transcodes internal video/audio frame processing routines
-    // or after and determines video/audio context
-
-    if ((ptr->tag & TC_PRE_S_PROCESS) && (ptr->tag & TC_VIDEO)) {
-
-	ac_memcpy(	lastFrames[frameIn],
-		ptr->video_buf,
-		ptr->v_width*ptr->v_height*3);
-	if (show_results)
-	    tc_log_info(MOD_NAME, "Inserted frame %d into slot %d",
-		    frameCount, frameIn);
-	frameIn = (frameIn+1) % FRBUFSIZ;
-	frameCount++;
-
-	// The first 2 frames are not output - they are only buffered
-	if (frameCount <= 2) {
-	    ptr->attributes |= TC_FRAME_IS_SKIPPED;
-	} else {
-	    // We have the last 3 frames in the buffer...
-	    //
-	    //		Previous Current Next
-	    //
-	    // OK, time to work...
-
-	    unsigned char *curr,
-		*pprev, *pnext, *cprev, *cnext, *nprev, *nnext, *dstp;
-	    int idxp, idxc, idxn;
-	    int p, c, n, lowest, chosen;
-	    int C, x, y;
-	    int comb;
-
-	    idxn = frameIn-1; while(idxn<0) idxn+=FRBUFSIZ;
-	    idxc = frameIn-2; while(idxc<0) idxc+=FRBUFSIZ;
-	    idxp = frameIn-3; while(idxp<0) idxp+=FRBUFSIZ;
-
-            y = (field ? 2 : 1) * ptr->v_width;
-
-	    // bottom field of current
-	    curr =  &lastFrames[idxc][y];
-	    // top field of previous
-	    pprev = &lastFrames[idxp][y - ptr->v_width];
-	    // top field of previous - 2nd scanline
-	    pnext = &lastFrames[idxp][y + ptr->v_width];
-	    // top field of current
-	    cprev = &lastFrames[idxc][y - ptr->v_width];
-	    // top field of current - 2nd scanline
-	    cnext = &lastFrames[idxc][y + ptr->v_width];
-	    // top field of next
-	    nprev = &lastFrames[idxn][y - ptr->v_width];
-	    // top field of next - 2nd scanline
-	    nnext = &lastFrames[idxn][y + ptr->v_width];
-
-	    // Blatant copy begins...
-
-	    p = c = n = 0;
-	    /* Try to match the top field of the current frame to the
-	       bottom fields of the previous, current, and next frames.
-	       Output the assembled frame that matches up best. For
-	       matching, subsample the frames in the x dimension
-	       for speed. */
-	    for (y = 0; y < ptr->v_height-2; y+=4)
-	    {
-		for (x = 0; x < ptr->v_width;)
-		{
-		    C = curr[x];
-#define T 100
-		    /* This combing metric is based on
-		       an original idea of Gunnar Thalin. */
-		    comb = ((long)pprev[x] - C) * ((long)pnext[x] - C);
-		    if (comb > T) p++;
-
-		    comb = ((long)cprev[x] - C) * ((long)cnext[x] - C);
-		    if (comb > T) c++;
-
-		    comb = ((long)nprev[x] - C) * ((long)nnext[x] - C);
-		    if (comb > T) n++;
-
-		    if (!(++x&3)) x += 12;
-		}
-		curr  += ptr->v_width*4;
-		pprev += ptr->v_width*4;
-		pnext += ptr->v_width*4;
-		cprev += ptr->v_width*4;
-		cnext += ptr->v_width*4;
-		nprev += ptr->v_width*4;
-		nnext += ptr->v_width*4;
-	    }
-
-	    lowest = c;
-	    chosen = 1;
-	    if (p < lowest)
-	    {
-		    lowest = p;
-		    chosen = 0;
-	    }
-	    if (n < lowest)
-	    {
-		    lowest = n;
-		    chosen = 2;
-	    }
-
-	    if (magic && c < 50 && abs(lowest - c) < 10 && (p+c+n) > 1000) {
-		lowest = c;
-		chosen = 1;
-            }
-
-	    // Blatant copy ends... :)
-
-	    if (show_results)
-		tc_log_info(MOD_NAME,
-		    "Telecide => frame %d: p=%u  c=%u  n=%u [using %d]",
-		    frameCount, p, c, n, chosen);
-
-	    // Set up the pointers in preparation to output final frame.
-
-	    // First, the Y plane
-	    if (chosen == 0)
-		curr = lastFrames[idxp];
-	    else if (chosen == 1)
-		curr = lastFrames[idxc];
-	    else
-		curr = lastFrames[idxn];
-
-	    dstp = ptr->video_buf;
-
-	    // First output the top field selected
-	    // from the set of three stored frames.
-	    ivtc_copy_field(dstp, curr, ptr, field);
-
-	    // The bottom field of the current frame unchanged
-	    ivtc_copy_field(dstp, lastFrames[idxc], ptr, 1-field);
-
-	}
+
+    pd->show_results = 0;
+    pd->field        = 0;
+    pd->magic        = 0;
+    pd->frameIn      = 0;
+    pd->frameCount   = 0;
+
+    if (options != NULL) {
+        if (optstr_lookup(options, "verbose") != NULL) {
+            pd->show_results = 1;
+        }
+        optstr_get(options, "field", "%d", &pd->field);
+        optstr_get(options, "magic", "%d", &pd->magic);
+    }
+
+    for (i = 0; i < FRBUFSIZ; i++) {
+        pd->lastFrames[i] = tc_malloc(TC_JOB_FRAME_SIZE(vob));
+        if (!pd->lastFrames[i]) {
+            tc_log_error(MOD_NAME, "can't allocate the frame buffers");
+            ivtc_stop(self);
+            return TC_ERROR;
+        }
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * ivtc_inspect:  Return the value of an option in this instance of the
+ * module.  See tcmodule-data.h for function details.
+ */
+
+static int ivtc_inspect(TCModuleInstance *self,
+                        const char *param, const char **value)
+{
+    IVTCPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = ivtc_help;
+    }
+    if (optstr_lookup(param, "field")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->field);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "magic")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->magic);
+        *value = pd->opt_buf;
     }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * ivtc_filter_video:  buffer the given frame and replace it with the
+ * best match of fields.  See tcmodule-data.h for function details.
+ */
+
+static int ivtc_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    IVTCPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+
+    ac_memcpy(pd->lastFrames[pd->frameIn], frame->video_buf,
+              frame->v_width*frame->v_height*3);
+    if (pd->show_results)
+        tc_log_info(MOD_NAME, "Inserted frame %d into slot %d",
+                    pd->frameCount, pd->frameIn);
+    pd->frameIn = (pd->frameIn+1) % FRBUFSIZ;
+    pd->frameCount++;
+
+    // The first 2 frames are not output - they are only buffered
+    if (pd->frameCount <= 2) {
+        frame->attributes |= TC_FRAME_IS_SKIPPED;
+    } else {
+        ivtc_telecide(pd, frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID ivtc_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+static const TCCodecID ivtc_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(ivtc);
+TC_MODULE_FILTER_FORMATS(ivtc);
 
-    return (0);
+TC_MODULE_INFO(ivtc);
+
+static const TCModuleClass ivtc_class = {
+    TC_MODULE_CLASS_HEAD(ivtc),
+
+    .init         = ivtc_init,
+    .fini         = ivtc_fini,
+    .configure    = ivtc_configure,
+    .stop         = ivtc_stop,
+    .inspect      = ivtc_inspect,
+
+    .filter_video = ivtc_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(ivtc)
+
+/*************************************************************************/
+
+static int ivtc_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VYE", "1");
+    optstr_param(options, "verbose", "print verbose information", "", "0");
+    optstr_param(options, "field", "which field to replace (0=top 1=bottom)",
+                 "%d", "0", "0", "1");
+    optstr_param(options, "magic", "perform magic? (0=no 1=yes)",
+                 "%d", "0", "0", "1");
+    return TC_OK;
+}
+
+static int ivtc_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    /* buffers the last three frames, so they must come in order */
+    if ((frame->tag & TC_PRE_S_PROCESS) && (frame->tag & TC_VIDEO)) {
+        return ivtc_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(ivtc)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -22,293 +22,427 @@
  */
 
 #define MOD_NAME    "filter_mask.so"
-#define MOD_VERSION "v0.2.3 (2003-10-12)"
+#define MOD_VERSION "v0.3.0 (2026-10-18)"
 #define MOD_CAP     "Filter through a rectangular Mask"
 #define MOD_AUTHOR  "Thomas Oestreich, Chad Page"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 
-static char *buffer;
+static const char mask_help[] = ""
+    "Overview\n"
+    "    This filter applies an rectangular mask to the video.\n"
+    "    Everything outside the mask is set to black.\n"
+    "Options\n"
+    "    lefttop   Upper left corner of the box\n"
+    "    rightbot  Lower right corner of the box\n";
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
+/*************************************************************************/
+
+typedef struct MaskPrivateData_ {
+    int codec;
+    int width, height;
+    int lc, rc, tc, bc;     /* the box */
+
+    char opt_buf[TC_BUF_MIN];
+} MaskPrivateData;
 
-static void ymask_yuv(unsigned char *buf, vob_t *vob, int top, int bottom)
+/*************************************************************************/
+
+static void ymask_yuv(uint8_t *buf, int width, int height,
+                      int top, int bottom)
 {
-	int i;
-	unsigned char *bufcb, *bufcr;
-	int w2 = vob->im_v_width / 2;
-
-	bufcb = buf + vob->im_v_width * vob->im_v_height;
-	bufcr = buf + vob->im_v_width * vob->im_v_height * 5 / 4;
-
-	for (i = top; i <= bottom; i+=2) {
-		memset(&buf[i * vob->im_v_width], 0x10, vob->im_v_width);
-		memset(&buf[(i + 1) * vob->im_v_width], 0x10, vob->im_v_width);
-	    	memset(&bufcb[(i / 2) * w2], 128, w2);
-	    	memset(&bufcr[(i / 2) * w2], 128, w2);
-	}
+    int i;
+    uint8_t *bufcb, *bufcr;
+    int w2 = width / 2;
+
+    bufcb = buf + width * height;
+    bufcr = buf + width * height * 5 / 4;
+
+    for (i = top; i <= bottom; i += 2) {
+        memset(&buf[i * width], 0x10, width);
+        memset(&buf[(i + 1) * width], 0x10, width);
+        memset(&bufcb[(i / 2) * w2], 128, w2);
+        memset(&bufcr[(i / 2) * w2], 128, w2);
+    }
 }
 
-static void ymask_yuv422(unsigned char *buf, vob_t *vob, int top, int bottom)
+static void ymask_yuv422(uint8_t *buf, int width, int height,
+                         int top, int bottom)
 {
-	int i;
-	unsigned char *bufcb, *bufcr;
-	int w2 = vob->im_v_width / 2;
-
-	bufcb = buf + vob->im_v_width * vob->im_v_height;
-	bufcr = buf + vob->im_v_width * vob->im_v_height * 3 / 2;
-
-	for (i = top; i <= bottom; i++) {
-		memset(&buf[i * vob->im_v_width], 0x10, vob->im_v_width);
-	    	memset(&bufcb[i * w2], 128, w2);
-	    	memset(&bufcr[i * w2], 128, w2);
-	}
+    int i;
+    uint8_t *bufcb, *bufcr;
+    int w2 = width / 2;
+
+    bufcb = buf + width * height;
+    bufcr = buf + width * height * 3 / 2;
+
+    for (i = top; i <= bottom; i++) {
+        memset(&buf[i * width], 0x10, width);
+        memset(&bufcb[i * w2], 128, w2);
+        memset(&bufcr[i * w2], 128, w2);
+    }
 }
 
-static void ymask_rgb(unsigned char *buf, vob_t *vob, int top, int bottom)
+static void ymask_rgb(uint8_t *buf, int width, int height,
+                      int top, int bottom)
 {
-	int i;
+    int i;
 
-	for (i = top; i <= bottom; i++) {
-		memset(&buf[i * vob->im_v_width * 3], 0, vob->im_v_width * 3);
-	}
+    for (i = top; i <= bottom; i++) {
+        memset(&buf[i * width * 3], 0, width * 3);
+    }
 }
 
-static void xmask_yuv(unsigned char *buf, vob_t *vob, int left, int right)
+static void xmask_yuv(uint8_t *buf, int width, int height,
+                      int left, int right)
 {
-	int i;
-	unsigned char *bufcb, *bufcr;
-	unsigned char *ptr, *ptrmax;
-
-	bufcb = buf + vob->im_v_width * vob->im_v_height;
-	bufcr = buf + vob->im_v_width * vob->im_v_height * 5 / 4;
-
-	/* Y */
-	for (i = left; i < right; i++) {
-		ptr = &buf[i];
-		ptrmax = &buf[i + (vob->im_v_height * vob->im_v_width)];
-		while (ptr < ptrmax) {
-			*ptr = 0x10;
-			ptr += vob->im_v_width;
-		}
-	}
-
-	/* Cb */
-	for (i = left & ~1; i < right; i += 2) {
-		ptr = &bufcb[i/2];
-		ptrmax = &bufcr[i/2 + (vob->im_v_height/2 * vob->im_v_width/2)];
-		while (ptr < ptrmax) {
-			*ptr = 128;
-			ptr += vob->im_v_width/2;
-		}
-	}
-
-	/* Cr */
-	for (i = left & ~1; i < right; i += 2) {
-		ptr = &bufcr[i/2];
-		ptrmax = &bufcb[i/2 + (vob->im_v_height/2 * vob->im_v_width/2)];
-		while (ptr < ptrmax) {
-			*ptr = 128;
-			ptr += vob->im_v_width/2;
-		}
-	}
+    int i;
+    uint8_t *bufcb, *bufcr;
+    uint8_t *ptr, *ptrmax;
+
+    bufcb = buf + width * height;
+    bufcr = buf + width * height * 5 / 4;
+
+    /* Y */
+    for (i = left; i < right; i++) {
+        ptr = &buf[i];
+        ptrmax = &buf[i + (height * width)];
+        while (ptr < ptrmax) {
+            *ptr = 0x10;
+            ptr += width;
+        }
+    }
+
+    /* Cb */
+    for (i = left & ~1; i < right; i += 2) {
+        ptr = &bufcb[i/2];
+        ptrmax = &bufcr[i/2 + (height/2 * width/2)];
+        while (ptr < ptrmax) {
+            *ptr = 128;
+            ptr += width/2;
+        }
+    }
+
+    /* Cr */
+    for (i = left & ~1; i < right; i += 2) {
+        ptr = &bufcr[i/2];
+        ptrmax = &bufcb[i/2 + (height/2 * width/2)];
+        while (ptr < ptrmax) {
+            *ptr = 128;
+            ptr += width/2;
+        }
+    }
 }
 
-static void xmask_yuv422(unsigned char *buf, vob_t *vob, int left, int right)
+static void xmask_yuv422(uint8_t *buf, int width, int height,
+                         int left, int right)
 {
-	int i;
-	unsigned char *bufcb, *bufcr;
-	unsigned char *ptr, *ptrmax;
-
-	bufcb = buf + vob->im_v_width * vob->im_v_height;
-	bufcr = buf + vob->im_v_width * vob->im_v_height * 3 / 2;
-
-	/* Y */
-	for (i = left; i < right; i++) {
-		ptr = &buf[i];
-		ptrmax = &buf[i + (vob->im_v_height * vob->im_v_width)];
-		while (ptr < ptrmax) {
-			*ptr = 0x10;
-			ptr += vob->im_v_width;
-		}
-	}
-
-	/* Cb */
-	for (i = left & ~1; i < right; i += 2) {
-		ptr = &bufcb[i/2];
-		ptrmax = &bufcr[i/2 + (vob->im_v_height * vob->im_v_width/2)];
-		while (ptr < ptrmax) {
-			*ptr = 128;
-			ptr += vob->im_v_width/2;
-		}
-	}
-
-	/* Cr */
-	for (i = left & ~1; i < right; i += 2) {
-		ptr = &bufcr[i/2];
-		ptrmax = &bufcb[i/2 + (vob->im_v_height * vob->im_v_width/2)];
-		while (ptr < ptrmax) {
-			*ptr = 128;
-			ptr += vob->im_v_width/2;
-		}
-	}
+    int i;
+    uint8_t *bufcb, *bufcr;
+    uint8_t *ptr, *ptrmax;
+
+    bufcb = buf + width * height;
+    bufcr = buf + width * height * 3 / 2;
+
+    /* Y */
+    for (i = left; i < right; i++) {
+        ptr = &buf[i];
+        ptrmax = &buf[i + (height * width)];
+        while (ptr < ptrmax) {
+            *ptr = 0x10;
+            ptr += width;
+        }
+    }
+
+    /* Cb */
+    for (i = left & ~1; i < right; i += 2) {
+        ptr = &bufcb[i/2];
+        ptrmax = &bufcr[i/2 + (height * width/2)];
+        while (ptr < ptrmax) {
+            *ptr = 128;
+            ptr += width/2;
+        }
+    }
+
+    /* Cr */
+    for (i = left & ~1; i < right; i += 2) {
+        ptr = &bufcr[i/2];
+        ptrmax = &bufcb[i/2 + (height * width/2)];
+        while (ptr < ptrmax) {
+            *ptr = 128;
+            ptr += width/2;
+        }
+    }
 }
 
-static void xmask_rgb(unsigned char *buf, vob_t *vob, int left, int right)
+static void xmask_rgb(uint8_t *buf, int width, int height,
+                      int left, int right)
 {
-	int y;
-	unsigned char *ptr;
+    int y;
 
-	for (y = 0; y < vob->im_v_height; y++) {
-		ptr = &buf[(y * vob->im_v_width * 3) + (left * 3)];
-		memset(ptr, 0, (right - left) * 3);
-	}
+    for (y = 0; y < height; y++) {
+        memset(&buf[(y * width * 3) + (left * 3)], 0, (right - left) * 3);
+    }
 }
 
-
 // old or new syntax?
-static int is_optstr (char *buf) {
+static int is_optstr(const char *buf)
+{
     if (strchr(buf, '='))
-	return 1;
+        return 1;
     if (strchr(buf, 't'))
-	return 1;
+        return 1;
     if (strchr(buf, 'h'))
-	return 1;
+        return 1;
     return 0;
 }
 
-static void help_optstr(void)
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * mask_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(mask, MaskPrivateData)
+
+/*************************************************************************/
+
+/**
+ * mask_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(mask)
+
+/*************************************************************************/
+
+/**
+ * mask_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int mask_configure(TCModuleInstance *self,
+                          const char *options,
+                          TCJob *vob,
+                          TCModuleExtraData *xdata[])
 {
-    tc_log_info(MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"    This filter applies an rectangular mask to the video.\n"
-"    Everything outside the mask is set to black.\n"
-"* Options\n"
-"    lefttop : Upper left corner of the box\n"
-"   rightbot : Lower right corner of the box\n"
-		, MOD_CAP);
+    MaskPrivateData *pd = NULL;
+    int _rc = 0, _bc = 0;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    if (verbose)
+        tc_log_info(MOD_NAME, "options=%s", options);
+
+    pd->codec  = vob->im_v_codec;
+    pd->width  = vob->im_v_width;
+    pd->height = vob->im_v_height;
+    pd->lc     = 0;
+    pd->tc     = 0;
+    pd->rc     = vob->im_v_width;
+    pd->bc     = vob->im_v_height;
+
+    if (options != NULL) {
+        if (!is_optstr(options)) { // old syntax
+            sscanf(options, "%d:%d:%d:%d", &pd->lc, &_rc, &pd->tc, &_bc);
+            pd->rc = vob->im_v_width - _rc;
+            pd->bc = vob->im_v_height - _bc;
+        } else {
+            optstr_get(options, "lefttop",  "%dx%d", &pd->lc, &pd->tc);
+            optstr_get(options, "rightbot", "%dx%d", &pd->rc, &pd->bc);
+            if (optstr_lookup(options, "help"))
+                tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, mask_help);
+        }
+    }
+    return TC_OK;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
+/*************************************************************************/
+
+/**
+ * mask_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int mask_stop(TCModuleInstance *self)
 {
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
-  static int lc, rc, tc, bc;
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
+}
 
-  int _rc, _bc;
+/*************************************************************************/
+
+/**
+ * mask_inspect:  Return the value of an option in this instance of the
+ * module.  See tcmodule-data.h for function details.
+ */
+
+static int mask_inspect(TCModuleInstance *self,
+                        const char *param, const char **value)
+{
+    MaskPrivateData *pd = NULL;
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-      char buf[32];
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VRY4E", "1");
+    pd = self->userdata;
 
-      tc_snprintf(buf, 32, "%dx%d", lc, tc);
-      optstr_param (options, "lefttop", "Upper left corner of the box", "%dx%d", buf, "0", "width", "0", "height");
+    if (optstr_lookup(param, "help")) {
+        *value = mask_help;
+    }
+    if (optstr_lookup(param, "lefttop")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%dx%d",
+                    pd->lc, pd->tc);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "rightbot")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%dx%d",
+                    pd->rc, pd->bc);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
 
-      tc_snprintf(buf, 32, "%dx%d", rc, bc);
-      optstr_param (options, "rightbot", "Lower right corner of the box", "%dx%d", buf, "0", "width", "0", "height");
+/*************************************************************************/
 
-      return 0;
-  }
+/**
+ * mask_filter_video:  black out everything outside of the box.  See
+ * tcmodule-data.h for function details.
+ */
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+static int mask_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    MaskPrivateData *pd = NULL;
+    uint8_t *buf = NULL;
+    int w, h;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+    buf = frame->video_buf;
+    w = pd->width;
+    h = pd->height;
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+
+    switch (pd->codec) {
+      case TC_CODEC_YUV420P:
+        if (pd->tc > 2)          ymask_yuv(buf, w, h, 0, pd->tc - 1);
+        if ((h - pd->bc) > 1)    ymask_yuv(buf, w, h, pd->bc, h - 1);
+        if (pd->lc > 2)          xmask_yuv(buf, w, h, 0, pd->lc - 1);
+        if ((w - pd->rc) > 1)    xmask_yuv(buf, w, h, pd->rc, w - 1);
+        break;
+      case TC_CODEC_RGB24:
+        if (pd->tc > 2)          ymask_rgb(buf, w, h, 0, pd->tc - 1);
+        if ((h - pd->bc) > 1)    ymask_rgb(buf, w, h, pd->bc, h - 1);
+        if (pd->lc > 2)          xmask_rgb(buf, w, h, 0, pd->lc - 1);
+        if ((w - pd->rc) > 1)    xmask_rgb(buf, w, h, pd->rc, w - 1);
+        break;
+      case TC_CODEC_YUV422P:
+        if (pd->tc > 2)          ymask_yuv422(buf, w, h, 0, pd->tc - 1);
+        if ((h - pd->bc) > 1)    ymask_yuv422(buf, w, h, pd->bc, h - 1);
+        if (pd->lc > 2)          xmask_yuv422(buf, w, h, 0, pd->lc - 1);
+        if ((w - pd->rc) > 1)    xmask_yuv422(buf, w, h, pd->rc, w - 1);
+        break;
+    }
+    return TC_OK;
+}
 
-  if(ptr->tag & TC_FILTER_INIT) {
+/*************************************************************************/
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+static const TCCodecID mask_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_YUV422P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID mask_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_YUV422P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(mask);
+TC_MODULE_FILTER_FORMATS(mask);
 
-    // filter init ok.
+TC_MODULE_INFO(mask);
 
-    if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+static const TCModuleClass mask_class = {
+    TC_MODULE_CLASS_HEAD(mask),
 
-    if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
+    .init         = mask_init,
+    .fini         = mask_fini,
+    .configure    = mask_configure,
+    .stop         = mask_stop,
+    .inspect      = mask_inspect,
 
-    if (!buffer)
-	buffer = tc_malloc(SIZE_RGB_FRAME);
+    .filter_video = mask_filter_video
+};
 
-    lc = 0;
-    tc = 0;
-    _rc = 0;
-    _bc = 0;
-    rc = vob->im_v_width;
-    bc = vob->im_v_height;
+TC_MODULE_ENTRY_POINT(mask)
 
-    if(options != NULL) {
-	if (!is_optstr(options)) { // old syntax
-	    sscanf(options, "%d:%d:%d:%d", &lc, &_rc, &tc, &_bc);
-	    rc = vob->im_v_width - _rc;
-	    bc = vob->im_v_height - _bc;
-	} else {
-           optstr_get (options, "lefttop", "%dx%d", &lc, &tc);
-           optstr_get (options, "rightbot", "%dx%d", &rc, &bc);
-	   if (optstr_lookup(options, "help"))
-	       help_optstr();
-	}
-    }
+/*************************************************************************/
 
-    return(0);
-  }
-
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
-
-  if(ptr->tag & TC_FILTER_CLOSE) {
-
-      if (buffer)
-	  free(buffer);
-      buffer = NULL;
-
-    return(0);
-  }
-
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
-
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
-
-  if(ptr->tag & TC_PRE_M_PROCESS && ptr->tag & TC_VIDEO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
-  //    ac_memcpy(buffer, ptr->video_buf, SIZE_RGB_FRAME);
-  //    ac_memcpy(ptr->video_buf, buffer, SIZE_RGB_FRAME);
-
-      if (vob->im_v_codec==TC_CODEC_YUV420P) {
-	  if (tc > 2) ymask_yuv(ptr->video_buf, vob, 0, tc - 1);
-	  if ((vob->im_v_height - bc) > 1) ymask_yuv(ptr->video_buf, vob, bc, vob->im_v_height - 1);
-	  if (lc > 2) xmask_yuv(ptr->video_buf, vob, 0, lc - 1);
-	  if ((vob->im_v_width - rc) > 1) xmask_yuv(ptr->video_buf, vob, rc, vob->im_v_width - 1);
-      }
-      if (vob->im_v_codec==TC_CODEC_RGB24) {
-	  if (tc > 2) ymask_rgb(ptr->video_buf, vob, 0, tc - 1);
-	  if ((vob->im_v_height - bc) > 1) ymask_rgb(ptr->video_buf, vob, bc, vob->im_v_height - 1);
-	  if (lc > 2) xmask_rgb(ptr->video_buf, vob, 0, lc - 1);
-	  if ((vob->im_v_width - rc) > 1) xmask_rgb(ptr->video_buf, vob, rc, vob->im_v_width - 1);
-      }
-      if (vob->im_v_codec==TC_CODEC_YUV422P) {
-	  if (tc > 2) ymask_yuv422(ptr->video_buf, vob, 0, tc - 1);
-	  if ((vob->im_v_height - bc) > 1) ymask_yuv422(ptr->video_buf, vob, bc, vob->im_v_height - 1);
-	  if (lc > 2) xmask_yuv422(ptr->video_buf, vob, 0, lc - 1);
-	  if ((vob->im_v_width - rc) > 1) xmask_yuv422(ptr->video_buf, vob, rc, vob->im_v_width - 1);
-      }
-  }
-
-  return(0);
+static int mask_get_config(TCModuleInstance *self, char *options)
+{
+    MaskPrivateData *pd = NULL;
+    char buf[32];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRY4E", "1");
+
+    tc_snprintf(buf, sizeof(buf), "%dx%d", pd->lc, pd->tc);
+    optstr_param(options, "lefttop", "Upper left corner of the box",
+                 "%dx%d", buf, "0", "width", "0", "height");
+    tc_snprintf(buf, sizeof(buf), "%dx%d", pd->rc, pd->bc);
+    optstr_param(options, "rightbot", "Lower right corner of the box",
+                 "%dx%d", buf, "0", "width", "0", "height");
+    return TC_OK;
+}
+
+static int mask_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    if (frame->tag & TC_PRE_M_PROCESS && frame->tag & TC_VIDEO) {
+        return mask_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(mask)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -49,80 +49,88 @@
 //             Fix a bug related to scanrange.
 
 #define MOD_NAME    "filter_modfps.so"
-#define MOD_VERSION "v0.10 (2003-08-18)"
+#define MOD_VERSION "v0.11 (2026-10-18)"
 #define MOD_CAP     "plugin to modify framerate"
 #define MOD_AUTHOR  "Marrq"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_DELAY|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtc/ratiocodes.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include <math.h>
 
 
 //#define DEBUG 1
 
-static int show_results=0;
-
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
-
-static int mode=1;
-static double infps  = 29.97;
-static double outfps = 23.976;
-static int infrc  = 0;
-// default settings for NTSC 29.97 -> 23.976
-static int numSample=5;
-static int offset = 32;
-static int runnow = 0;
-
-static char **frames = NULL;
-static int frbufsize;
-static int frameIn = 0, frameOut = 0;
-static int *framesOK, *framesScore;
-static int scanrange = 0;
-static int clonetype = 0;
-
-static void help_optstr(void)
-{
-    tc_log_info(MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"  This filter aims to allow transcode to alter the fps\n"
-"  of video.  While one can reduce the fps to any amount,\n"
-"  one can only increase the fps to at most twice the\n"
-"  original fps\n"
-"  There are two modes of operation, buffered and unbuffered,\n"
-"  unbuffered is quick, but buffered, especially when dropping frames\n"
-"  should look better\n"
-"  For most users, modfps will need either no options, or just mode=1\n"
-"* Options\n"
-"    mode : (0=unbuffered, 1=buffered [%d]\n"
-"    infps : original fps (override what transcode supplies) [%f]\n"
-"    infrc : original frc (overwrite infps) [%d]\n"
-"    buffer : number of frames to buffer [%d]\n"
-"    subsample : number of pixels to subsample when examining buffers [%d]\n"
-"    clonetype : when cloning and mode=1 do something special [%d]\n"
-"        0 = none\n"
-"        1 = merge fields, cloned frame first(good for interlaced displays)\n"
-"        2 = merge fields, cloned frame 2nd (good for interlaced displays)\n"
-"        3 = average frames\n"
-"        4 = temporally average frame\n"
-"        5 = pseudo-phosphor average frames (YUV only) (slow)\n"
-"    verbose : 0 = not verbose, 1 is verbose [%d]\n"
-		, MOD_CAP,
-		mode,
-		infps,
-		infrc,
-		numSample,
-		offset,
-		clonetype,
-		show_results);
-}
+static const char modfps_help[] = ""
+    "Overview\n"
+    "    This filter aims to allow transcode to alter the fps\n"
+    "    of video.  While one can reduce the fps to any amount,\n"
+    "    one can only increase the fps to at most twice the\n"
+    "    original fps\n"
+    "    There are two modes of operation, buffered and unbuffered,\n"
+    "    unbuffered is quick, but buffered, especially when dropping\n"
+    "    frames should look better\n"
+    "    For most users, modfps will need either no options, or just\n"
+    "    mode=1\n"
+    "Options\n"
+    "    mode : (0=unbuffered, 1=buffered [1]\n"
+    "    infps : original fps (override what transcode supplies)\n"
+    "    infrc : original frc (overwrite infps) [0]\n"
+    "    buffer : number of frames to buffer [5]\n"
+    "    subsample : number of pixels to subsample when examining"
+    " buffers [32]\n"
+    "    clonetype : when cloning and mode=1 do something special [0]\n"
+    "        0 = none\n"
+    "        1 = merge fields, cloned frame first(good for interlaced"
+    " displays)\n"
+    "        2 = merge fields, cloned frame 2nd (good for interlaced"
+    " displays)\n"
+    "        3 = average frames\n"
+    "        4 = temporally average frame\n"
+    "        5 = pseudo-phosphor average frames (YUV only) (slow)\n"
+    "    verbose : 0 = not verbose, 1 is verbose [0]\n";
+
+/*************************************************************************/
+
+/* The window of buffered frames and the frame counters: the frames must
+ * come in order, and the output lags numSample frames behind. */
+
+typedef struct ModfpsPrivateData_ {
+    int show_results;
+
+    int mode;
+    double infps;
+    double outfps;
+    int infrc;
+    int numSample;
+    int offset;
+    int runnow;
+
+    uint8_t **frames;
+    int frbufsize;
+    int frameIn, frameOut;
+    int *framesOK, *framesScore;
+    int scanrange;
+    int clonetype;
+
+    int framesin;
+    int init;
+    int cloneq;     /* queue'd clones ;) */
+    int outframes;
+
+    char opt_buf[TC_BUF_MIN];
+} ModfpsPrivateData;
+
+/*************************************************************************/
 
 #define ABS_u8(a) (((a)^((a)>>7))-((a)>>7))
 
@@ -220,7 +228,7 @@ static void clone_average(unsigned char *clone, unsigned char *next, vframe_list
   }
 }
 
-static void clone_temporal_average(unsigned char *clone, unsigned char*next, vframe_list_t *ptr, int tin, int tout){
+static void clone_temporal_average(ModfpsPrivateData *pd, unsigned char *clone, unsigned char*next, vframe_list_t *ptr, int tin, int tout){
   // basic algorithm is to weight the pixels of a frame based
   // on how close the blended frame should be if this frame was
   // perfectly placed  since's we'll be merging the tin and the tin+1
@@ -235,19 +243,18 @@ static void clone_temporal_average(unsigned char *clone, unsigned char*next, vfr
 
   double weight1,weight2;
   int i;
-  static int first=1;
 
-  weight1 = 1.0 - ( (double)tout/outfps*infps - (double)tin );
-  weight2 = 1.0 - ( (double)(tin+1) - (double)(tout)/outfps*infps );
+  weight1 = 1.0 - ( (double)tout/pd->outfps*pd->infps - (double)tin );
+  weight2 = 1.0 - ( (double)(tin+1) - (double)(tout)/pd->outfps*pd->infps );
   // weight2 is also 1.0-weight1
 
-  if (show_results){
+  if (pd->show_results){
     tc_log_info(MOD_NAME, "temporal_clone tin=%4d tout=%4d w1=%1.5f w2=%1.5f",
                     tin,tout,weight1,weight2);
   }
 
   if (weight1 < 0.0){
-    if (show_results){
+    if (pd->show_results){
       tc_log_info(MOD_NAME, "temporal_clone: w1 is weak, copying next frame");
     }
     ac_memcpy(ptr->video_buf,next,ptr->video_size);
@@ -255,7 +262,7 @@ static void clone_temporal_average(unsigned char *clone, unsigned char*next, vfr
   } // else
   if (weight2 < 0.0){
     // I think this case cannot happen
-    if (show_results){
+    if (pd->show_results){
       tc_log_info(MOD_NAME, "temporal_clone: w2 is weak, simple cloning of frame");
     }
     // no memcpy needed, as we're keeping the orig
@@ -275,12 +282,11 @@ static void clone_temporal_average(unsigned char *clone, unsigned char*next, vfr
   for(i=0; i<ptr->video_size; i++){
     ptr->video_buf[i] = (unsigned char)( (double)(clone[i])*weight1 + (double)(next[i])*weight2);
   }
-  first=0;
 }
 
-static void clone_interpolate(char *clone, char *next, vframe_list_t *ptr){
+static void clone_interpolate(uint8_t *clone, uint8_t *next, vframe_list_t *ptr){
   int i,width = 0,height;
-  char *dest, *s1, *s2;
+  uint8_t *dest, *s1, *s2;
 
   if (TC_CODEC_RGB24 == ptr->v_codec){
     // in RGB, the data is packed, three bytes per pixel
@@ -336,12 +342,12 @@ static void clone_interpolate(char *clone, char *next, vframe_list_t *ptr){
  * and the frame number in the input and the output
  * stream and will then do anything fancy needed
  ******/
-static void fancy_clone(char* clone, char* next, vframe_list_t *ptr, int tin, int tout){
+static void fancy_clone(ModfpsPrivateData *pd, uint8_t *clone, uint8_t *next, vframe_list_t *ptr, int tin, int tout){
   if ((ptr == NULL) || (clone == NULL) || (next == NULL) || (ptr->video_buf == NULL)){
     tc_log_error(MOD_NAME, "Big error; we're about to dereference NULL");
     return;
   }
-  switch (clonetype){
+  switch (pd->clonetype){
     case 0:
       ac_memcpy(ptr->video_buf,clone,ptr->video_size);
       break;
@@ -355,7 +361,7 @@ static void fancy_clone(char* clone, char* next, vframe_list_t *ptr, int tin, in
       clone_average(clone,next,ptr);
       break;
     case 4:
-      clone_temporal_average(clone,next,ptr,tin,tout);
+      clone_temporal_average(pd,clone,next,ptr,tin,tout);
       break;
     case 5:
       if (ptr->v_codec != TC_CODEC_YUV420P){
@@ -371,226 +377,111 @@ static void fancy_clone(char* clone, char* next, vframe_list_t *ptr, int tin, in
   return;
 }
 
-static int memory_init(vframe_list_t * ptr){
+static int memory_init(ModfpsPrivateData *pd, vframe_list_t * ptr){
 
   int i;
-  frbufsize = numSample +1;
+  pd->frbufsize = pd->numSample +1;
   if (ptr->v_codec == TC_CODEC_YUV420P){
     // we only care about luminance
-    scanrange = ptr->v_height*ptr->v_width;
+    pd->scanrange = ptr->v_height*ptr->v_width;
   } else if (ptr->v_codec == TC_CODEC_RGB24){
-    scanrange = ptr->v_height*ptr->v_width*3;
+    pd->scanrange = ptr->v_height*ptr->v_width*3;
   } else if (ptr->v_codec == TC_CODEC_YUY2){
     // we only care about luminance, but since this is packed
     // we'll look at everything.
-    scanrange = ptr->v_height*ptr->v_width*2;
+    pd->scanrange = ptr->v_height*ptr->v_width*2;
   }
 
-  if (scanrange > ptr->video_size){
+  if (pd->scanrange > ptr->video_size){
     // error, we'll overwalk boundaries later on
     tc_log_error(MOD_NAME, "video_size doesn't look to be big enough (scan=%d video_size=%d).",
-                    scanrange,ptr->video_size);
+                    pd->scanrange,ptr->video_size);
     return -1;
   }
 
-  frames = tc_malloc(sizeof (char*)*frbufsize);
-  if (NULL == frames){
+  pd->frames = tc_zalloc(sizeof (uint8_t*)*pd->frbufsize);
+  if (NULL == pd->frames){
     tc_log_error(MOD_NAME, "Error allocating memory in init");
     return -1;
   } // else
-  for (i=0;i<frbufsize; i++){
-    frames[i] = tc_malloc(sizeof(char)*ptr->video_size);
-    if (NULL == frames[i]){
+  for (i=0;i<pd->frbufsize; i++){
+    pd->frames[i] = tc_malloc(ptr->video_size);
+    if (NULL == pd->frames[i]){
       tc_log_error(MOD_NAME, "Error allocating memory in init");
       return -1;
     }
   }
-  framesOK = tc_malloc(sizeof(int)*frbufsize);
-  if (NULL == framesOK){
+  pd->framesOK = tc_malloc(sizeof(int)*pd->frbufsize);
+  if (NULL == pd->framesOK){
     tc_log_error(MOD_NAME, "Error allocating memory in init");
     return -1;
   }
-  framesScore = tc_malloc(sizeof(int)*frbufsize);
-  if (NULL == framesScore){
+  pd->framesScore = tc_malloc(sizeof(int)*pd->frbufsize);
+  if (NULL == pd->framesScore){
     tc_log_error(MOD_NAME, "Error allocating memory in init");
     return -1;
   }
-  if (mode == 1){
+  if (pd->mode == 1){
     return 0;
   }
   return -1;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-    vframe_list_t *ptr = (vframe_list_t *)ptr_;
-    static vob_t *vob = NULL;
-    static int framesin = 0;
-    static int init = 1;
-    static int cloneq = 0; // queue'd clones ;)
-    static int outframes = 0;
-
-    //----------------------------------
-    //
-    // filter init
-    //
-    //----------------------------------
-
-
-    if (ptr->tag & TC_FILTER_INIT) {
-
-	if ((vob = tc_get_vob()) == NULL)
-	    return (-1);
-
-	// defaults
-	outfps = vob->ex_fps;
-	infps  = vob->fps;
-	infrc  = vob->im_frc;
-
-	// filter init ok.
-	if (options != NULL) {
-	  if (optstr_lookup (options, "help")) {
-	    help_optstr();
-	  }
-	  optstr_get (options, "verbose", "%d", &show_results);
-	  optstr_get (options, "mode", "%d", &mode);
-	  optstr_get (options, "infps", "%lf", &infps);
-	  optstr_get (options, "infrc", "%d", &infrc);
-	  optstr_get (options, "buffer", "%d", &numSample);
-	  optstr_get (options, "subsample", "%d", &offset);
-	  optstr_get (options, "clonetype", "%d", &clonetype);
-
-	}
-
-	if (infrc>0 && infrc < 16){
-	  tc_frc_code_to_value(infrc, &infps);
-	}
-
-	if (verbose){
-	  tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-	  tc_log_info(MOD_NAME, "converting from %2.4ffps to %2.4ffps",infps,outfps);
-	}
-
-	if (outfps > infps*2.0){
-	  tc_log_error(MOD_NAME, "desired output fps can not be greater");
-	  tc_log_error(MOD_NAME, "than twice the input fps");
-	  return -1;
-	}
-
-	if ( (outfps == infps) || (infrc && infrc == vob->ex_frc)) {
-	  tc_log_error(MOD_NAME, "No framerate conversion requested, exiting");
-	  return -1;
-	}
-
-	// clone in POST_S skip in PRE_S
-	if (outfps > infps){
-	  runnow = TC_POST_S_PROCESS;
-	} else {
-	  runnow = TC_PRE_S_PROCESS;
-	}
-
-	if ((mode >= 0) && (mode < 2)){
-	  return 0;
-	} // else
-
-	tc_log_error(MOD_NAME, "only two modes of operation.");
-	return -1;
-    }
-
-    if (ptr->tag & TC_FILTER_GET_CONFIG){
-      char buf[255];
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VYRE", "1");
-
-      tc_snprintf(buf, sizeof(buf), "%d",mode);
-      optstr_param(options,"mode","mode of operation", "%d", buf, "0", "1");
-      tc_snprintf(buf, sizeof(buf), "%f", infps);
-      optstr_param(options, "infps", "Original fps", "%f", buf, "MIN_FPS", "200.0");
-      tc_snprintf(buf, sizeof(buf), "%d", infrc);
-      optstr_param(options, "infrc", "Original frc", "%d", buf, "0", "16");
-      tc_snprintf(buf, sizeof(buf), "%d", numSample);
-      optstr_param(options,"examine", "How many frames to buffer", "%d", buf, "2", "25");
-      tc_snprintf(buf, sizeof(buf), "%d", offset);
-      optstr_param(options, "subsample", "How many pixels to subsample", "%d", buf, "1", "256");
-      tc_snprintf(buf, sizeof(buf), "%d", clonetype);
-      optstr_param(options, "clonetype", "How to clone frames", "%d", buf, "0", "16");
-      tc_snprintf(buf, sizeof(buf), "%d", verbose);
-      optstr_param(options, "verbose", "run in verbose mode", "%d", buf, "0", "1");
-      return 0;
-    }
-
-    //----------------------------------
-    //
-    // filter close
-    //
-    //----------------------------------
-
+/* Skip or clone the given frame, deciding over a window of frames
+ * in the buffered mode. */
 
-    if (ptr->tag & TC_FILTER_CLOSE) {
-
-	return (0);
-    }
-    //----------------------------------
-    //
-    // filter frame routine
-    //
-    //----------------------------------
-
-
-    // tag variable indicates, if we are called before
-    // transcodes internal video/audio frame processing routines
-    // or after and determines video/audio context
-
-    if ((ptr->tag & runnow) && (ptr->tag & TC_VIDEO)) {
-      if (mode == 0){
-        if (show_results){
+static int modfps_frame(ModfpsPrivateData *pd, vframe_list_t *ptr)
+{
+      if (pd->mode == 0){
+        if (pd->show_results){
           tc_log_info(MOD_NAME, "in=%5d out=%5d win=%05.3f wout=%05.3f ",
-                          framesin,outframes,(double)framesin/infps,outframes/outfps);
+                          pd->framesin,pd->outframes,(double)pd->framesin/pd->infps,pd->outframes/pd->outfps);
 	}
-        if (infps < outfps){
+        if (pd->infps < pd->outfps){
 	  // Notes; since we currently only can clone frames (and just clone
 	  // them once, we can at most double the input framerate.
 	  if (ptr->attributes & TC_FRAME_WAS_CLONED){
 	    // we can't clone it again, so we'll record the outframe and exit
-	    ++outframes;
-	    if (show_results){
+	    ++pd->outframes;
+	    if (pd->show_results){
 	      tc_log_info(MOD_NAME, "\n");
 	    }
 	    return 0;
 	  } // else
-	  if ((double)framesin++/infps > (double)outframes++/outfps){
-	    if (show_results){
+	  if ((double)pd->framesin++/pd->infps > (double)pd->outframes++/pd->outfps){
+	    if (pd->show_results){
 	      tc_log_info(MOD_NAME, "FRAME IS CLONED");
 	    }
 	    ptr->attributes |= TC_FRAME_IS_CLONED;
 	  }
 	} else {
-	  if ((double)framesin++/infps > outframes / outfps){
-	       ++outframes;
+	  if ((double)pd->framesin++/pd->infps > pd->outframes / pd->outfps){
+	       ++pd->outframes;
 	  } else {
-	    if (show_results){
+	    if (pd->show_results){
 	      tc_log_info(MOD_NAME, "FRAME IS SKIPPED");
 	    }
 	    ptr->attributes |= TC_FRAME_IS_SKIPPED;
 	  }
 	}
-	if (show_results){
+	if (pd->show_results){
 	  tc_log_info(MOD_NAME, "\n");
 	}
 	return(0);
       } // else
-      if (mode == 1){
+      if (pd->mode == 1){
         int i;
-	if (init){
-	  init = 0;
-	  i = memory_init(ptr);
+	if (pd->init){
+	  pd->init = 0;
+	  i = memory_init(pd, ptr);
 	  if(i!=0){
 	    return i;
 	  }
 	}
-	if (show_results){
+	if (pd->show_results){
           tc_log_info(MOD_NAME, "frameIn=%d frameOut=%d in=%5d out=%5d win=%05.3f wout=%05.3f ",
-                          frameIn,frameOut,framesin-numSample,outframes+cloneq,
-                          (double)(framesin-numSample)/infps,(double)(outframes+cloneq)/outfps);
+                          pd->frameIn,pd->frameOut,pd->framesin-pd->numSample,pd->outframes+pd->cloneq,
+                          (double)(pd->framesin-pd->numSample)/pd->infps,(double)(pd->outframes+pd->cloneq)/pd->outfps);
 	}
 	if (ptr->attributes & TC_FRAME_WAS_CLONED){
 	  // don't do anything.  Since it's cloned, we don't
@@ -598,39 +489,40 @@ int tc_filter(frame_list_t *ptr_, char *options)
 	  // them up.  Later, we can try some merging/interpolation
 	  // as the user requests and then leave, but for now, we'll
 	  // just flee.
-	  if (framesOK[(frameIn+0)%frbufsize]){
+	  if (pd->framesOK[(pd->frameIn+0)%pd->frbufsize]){
 	    tc_log_warn(MOD_NAME, "this frame wasn't cloned but we thought it was");
 	  }
-	  ++outframes;
-	  --cloneq;
-	  if (show_results){
+	  ++pd->outframes;
+	  --pd->cloneq;
+	  if (pd->show_results){
 	    tc_log_info(MOD_NAME, "no slot needed for clones");
 	  }
-	  fancy_clone(frames[frameIn],frames[(frameIn+1)%frbufsize],ptr,framesin-numSample,outframes+cloneq+1);
+	  fancy_clone(pd, pd->frames[pd->frameIn],pd->frames[(pd->frameIn+1)%pd->frbufsize],ptr,pd->framesin-pd->numSample,pd->outframes+pd->cloneq+1);
 	  return 0;
 	} // else
-	ac_memcpy(frames[frameIn], ptr->video_buf, ptr->video_size);
-	framesOK[frameIn] = 1;
+	ac_memcpy(pd->frames[pd->frameIn], ptr->video_buf, ptr->video_size);
+	pd->framesOK[pd->frameIn] = 1;
 #ifdef DEBUG
-	tc_log_info(MOD_NAME, "Inserted frame %d into slot %d",framesin, frameIn);
+	tc_log_info(MOD_NAME, "Inserted frame %d into slot %d",pd->framesin, pd->frameIn);
 #endif // DEBUG
 
 	// Now let's look and see if we should compute a frame's
 	// score.
-	if (framesin > 0){
-	  char *t1, *t2;
+	if (pd->framesin > 0){
+	  uint8_t *t1, *t2;
 	  int *score,t;
-	  t=(frameIn+numSample)%frbufsize;
-	  score = &framesScore[t];
-	  t1 = frames[t];
-	  t2 = frames[frameIn];
+	  t=(pd->frameIn+pd->numSample)%pd->frbufsize;
+	  score = &pd->framesScore[t];
+	  t1 = pd->frames[t];
+	  t2 = pd->frames[pd->frameIn];
 #ifdef DEBUG
 	    tc_log_info(MOD_NAME, "score: slot=%d, t1=%p t2=%p ",
 	      t,t1,t2);
 #endif // DEBUG
 	  *score=0;
-	  for(i=0; i<ptr->video_size; i+=offset){
-	    *score += abs(t2[i] - t1[i]);
+	  for(i=0; i<ptr->video_size; i+=pd->offset){
+	    /* the score has always been taken on signed bytes */
+	    *score += abs((signed char)t2[i] - (signed char)t1[i]);
 	  }
 #ifdef DEBUG
 	    tc_log_info(MOD_NAME, "score = %d\n",*score);
@@ -640,11 +532,11 @@ int tc_filter(frame_list_t *ptr_, char *options)
 	// the first frbufsize-1 frames are not processed; only buffered
 	// so that we might be able to effectively see the future frames
 	// when deciding about a frame.
-	if(framesin < frbufsize-1){
+	if(pd->framesin < pd->frbufsize-1){
 	  ptr->attributes |= TC_FRAME_IS_SKIPPED;
-	  frameIn = (frameIn+1) % frbufsize;
-	  ++framesin;
-	  if (show_results){
+	  pd->frameIn = (pd->frameIn+1) % pd->frbufsize;
+	  ++pd->framesin;
+	  if (pd->show_results){
 	    tc_log_info(MOD_NAME, "\n");
 	  }
 	  return 0;
@@ -653,23 +545,23 @@ int tc_filter(frame_list_t *ptr_, char *options)
 	// having filled the buffer, we will now check to see if we
 	// are ready to clone/skip a frame.  If we are, we look for the frame to skip
 	// in the buffer
-	if (infps < outfps){
-	  if ((double)(framesin-numSample)/infps > (double)(cloneq+outframes++)/outfps){
+	if (pd->infps < pd->outfps){
+	  if ((double)(pd->framesin-pd->numSample)/pd->infps > (double)(pd->cloneq+pd->outframes++)/pd->outfps){
 	    // we have to find a frame to clone
 	    int diff=-1, mod=-1;
 #ifdef DEBUG
-	      tc_log_info(MOD_NAME, "start=%d end=%d",(frameIn+1)%frbufsize,frameIn);
+	      tc_log_info(MOD_NAME, "start=%d end=%d",(pd->frameIn+1)%pd->frbufsize,pd->frameIn);
 #endif // DEBUG
 	    fflush(stdout);
-	    for(i=((frameIn+1)%frbufsize); i!=frameIn; i=((i+1)%frbufsize)){
+	    for(i=((pd->frameIn+1)%pd->frbufsize); i!=pd->frameIn; i=((i+1)%pd->frbufsize)){
 #ifdef DEBUG
-	        tc_log_info(MOD_NAME, "i=%d Ok=%d Score=%d",i,framesOK[i],framesScore[i]);
+	        tc_log_info(MOD_NAME, "i=%d Ok=%d Score=%d",i,pd->framesOK[i],pd->framesScore[i]);
 #endif // DEBUG
 	      // make sure we haven't skipped/cloned this frame already
-	      if(framesOK[i]){
+	      if(pd->framesOK[i]){
 	        // look for the frame with the most difference from it's next neighbor
-	        if (framesScore[i] > diff){
-		  diff = framesScore[i];
+	        if (pd->framesScore[i] > diff){
+		  diff = pd->framesScore[i];
 		  mod = i;
 		}
 	      }
@@ -681,36 +573,36 @@ int tc_filter(frame_list_t *ptr_, char *options)
 #ifdef DEBUG
 	    tc_log_info(MOD_NAME, "cloning  %d",mod);
 #endif // DEBUG
-	    ++cloneq;
-	    framesOK[mod] = 0;
+	    ++pd->cloneq;
+	    pd->framesOK[mod] = 0;
 	  }
-	  ac_memcpy(ptr->video_buf,frames[frameOut],ptr->video_size);
-	  if (framesOK[frameOut]){
-	    if (show_results){
-	      tc_log_info(MOD_NAME, "giving   slot %2d frame %6d",frameOut,ptr->id);
+	  ac_memcpy(ptr->video_buf,pd->frames[pd->frameOut],ptr->video_size);
+	  if (pd->framesOK[pd->frameOut]){
+	    if (pd->show_results){
+	      tc_log_info(MOD_NAME, "giving   slot %2d frame %6d",pd->frameOut,ptr->id);
 	    }
 	  } else {
 	    ptr->attributes |= TC_FRAME_IS_CLONED;
-	    if (show_results){
-	      tc_log_info(MOD_NAME, "cloning  slot %2d frame %6d",frameOut,ptr->id);
+	    if (pd->show_results){
+	      tc_log_info(MOD_NAME, "cloning  slot %2d frame %6d",pd->frameOut,ptr->id);
 	    }
 	  }
-	  frameOut = (frameOut+1) % frbufsize;
+	  pd->frameOut = (pd->frameOut+1) % pd->frbufsize;
 	} else {
 	  // check to skip frames
-	  if ((double)(framesin-numSample)/infps < (double)(outframes)/outfps){
+	  if ((double)(pd->framesin-pd->numSample)/pd->infps < (double)(pd->outframes)/pd->outfps){
 	    int diff=INT_MAX, mod=-1;
 
 	    // since we're skipping, we look for the frame with the lowest
 	    // difference between the frame which follows it.
-	    for(i=((frameIn+1)%frbufsize); i!=frameIn; i=((i+1)%frbufsize)){
+	    for(i=((pd->frameIn+1)%pd->frbufsize); i!=pd->frameIn; i=((i+1)%pd->frbufsize)){
 #ifdef DEBUG
-	        tc_log_info(MOD_NAME, "i=%d Ok=%d Score=%d",i,framesOK[i],framesScore[i]);
+	        tc_log_info(MOD_NAME, "i=%d Ok=%d Score=%d",i,pd->framesOK[i],pd->framesScore[i]);
 #endif // debug
 	      // make sure we haven't skipped/cloned this frame already
-	      if(framesOK[i]){
-	        if (framesScore[i] < diff){
-		  diff = framesScore[i];
+	      if(pd->framesOK[i]){
+	        if (pd->framesScore[i] < diff){
+		  diff = pd->framesScore[i];
 		  mod = i;
 		}
 	      }
@@ -719,30 +611,315 @@ int tc_filter(frame_list_t *ptr_, char *options)
 	      tc_log_error(MOD_NAME, "Error calculating frame to skip");
 	      return -1;
 	    }
-	    framesOK[mod] = 0;
+	    pd->framesOK[mod] = 0;
 	  } else {
-	    ++outframes;
+	    ++pd->outframes;
 	  }
-	  if (framesOK[frameOut]){
-	    ac_memcpy(ptr->video_buf,frames[frameOut],ptr->video_size);
-	    if (show_results){
-	      tc_log_info(MOD_NAME, "giving   slot %2d frame %6d",frameOut,ptr->id);
+	  if (pd->framesOK[pd->frameOut]){
+	    ac_memcpy(ptr->video_buf,pd->frames[pd->frameOut],ptr->video_size);
+	    if (pd->show_results){
+	      tc_log_info(MOD_NAME, "giving   slot %2d frame %6d",pd->frameOut,ptr->id);
 	    }
 	  } else {
 	    ptr->attributes |= TC_FRAME_IS_SKIPPED;
-	    if (show_results){
-	      tc_log_warn(MOD_NAME, "skipping slot %2d frame %6d",frameOut,ptr->id);
+	    if (pd->show_results){
+	      tc_log_warn(MOD_NAME, "skipping slot %2d frame %6d",pd->frameOut,ptr->id);
 	    }
 	  }
-	  frameOut = (frameOut+1) % frbufsize;
+	  pd->frameOut = (pd->frameOut+1) % pd->frbufsize;
 	}
-	frameIn = (frameIn+1) % frbufsize;
-	++framesin;
+	pd->frameIn = (pd->frameIn+1) % pd->frbufsize;
+	++pd->framesin;
 	return 0;
       }
       tc_log_error(MOD_NAME, "currently only 2 modes of operation");
       return(-1);
+}
+
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * modfps_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(modfps, ModfpsPrivateData)
+
+/*************************************************************************/
+
+/**
+ * modfps_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(modfps)
+
+/*************************************************************************/
+
+/**
+ * modfps_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int modfps_stop(TCModuleInstance *self)
+{
+    ModfpsPrivateData *pd = NULL;
+    int i;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+
+    if (pd->frames) {
+        for (i = 0; i < pd->frbufsize; i++)
+            tc_free(pd->frames[i]);
+        tc_free(pd->frames);
+        pd->frames = NULL;
     }
+    tc_free(pd->framesOK);
+    pd->framesOK = NULL;
+    tc_free(pd->framesScore);
+    pd->framesScore = NULL;
+    return TC_OK;
+}
+
+/*************************************************************************/
 
-    return (0);
+/**
+ * modfps_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int modfps_configure(TCModuleInstance *self,
+                            const char *options,
+                            TCJob *vob,
+                            TCModuleExtraData *xdata[])
+{
+    ModfpsPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    /* drop the buffers of a previous configuration, if any */
+    modfps_stop(self);
+
+    // defaults
+    pd->show_results = 0;
+    pd->mode         = 1;
+    pd->outfps       = vob->ex_fps;
+    pd->infps        = vob->fps;
+    pd->infrc        = vob->im_frc;
+    // default settings for NTSC 29.97 -> 23.976
+    pd->numSample    = 5;
+    pd->offset       = 32;
+    pd->clonetype    = 0;
+
+    pd->frbufsize    = 0;
+    pd->frameIn      = 0;
+    pd->frameOut     = 0;
+    pd->framesin     = 0;
+    pd->init         = 1;
+    pd->cloneq       = 0;
+    pd->outframes    = 0;
+
+    if (options != NULL) {
+        if (optstr_lookup(options, "help")) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, modfps_help);
+        }
+        optstr_get(options, "verbose",   "%d",  &pd->show_results);
+        optstr_get(options, "mode",      "%d",  &pd->mode);
+        optstr_get(options, "infps",     "%lf", &pd->infps);
+        optstr_get(options, "infrc",     "%d",  &pd->infrc);
+        optstr_get(options, "buffer",    "%d",  &pd->numSample);
+        optstr_get(options, "subsample", "%d",  &pd->offset);
+        optstr_get(options, "clonetype", "%d",  &pd->clonetype);
+    }
+
+    if (pd->infrc > 0 && pd->infrc < 16) {
+        tc_frc_code_to_value(pd->infrc, &pd->infps);
+    }
+
+    if (verbose) {
+        tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+        tc_log_info(MOD_NAME, "converting from %2.4ffps to %2.4ffps",
+                    pd->infps, pd->outfps);
+    }
+
+    if (pd->outfps > pd->infps*2.0) {
+        tc_log_error(MOD_NAME, "desired output fps can not be greater");
+        tc_log_error(MOD_NAME, "than twice the input fps");
+        return TC_ERROR;
+    }
+
+    if ((pd->outfps == pd->infps)
+     || (pd->infrc && pd->infrc == vob->ex_frc)) {
+        tc_log_error(MOD_NAME, "No framerate conversion requested,"
+                               " exiting");
+        return TC_ERROR;
+    }
+
+    // clone in POST_S skip in PRE_S
+    if (pd->outfps > pd->infps) {
+        pd->runnow = TC_POST_S_PROCESS;
+    } else {
+        pd->runnow = TC_PRE_S_PROCESS;
+    }
+
+    if (pd->mode < 0 || pd->mode >= 2) {
+        tc_log_error(MOD_NAME, "only two modes of operation.");
+        return TC_ERROR;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * modfps_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
+
+static int modfps_inspect(TCModuleInstance *self,
+                          const char *param, const char **value)
+{
+    ModfpsPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = modfps_help;
+    }
+    if (optstr_lookup(param, "mode")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->mode);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "clonetype")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->clonetype);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/**
+ * modfps_filter_video:  skip or clone the given frame.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int modfps_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    return modfps_frame(self->userdata, frame);
+}
+
+/*************************************************************************/
+
+static const TCCodecID modfps_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_YUY2, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID modfps_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_YUY2, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(modfps);
+TC_MODULE_FILTER_FORMATS(modfps);
+
+TC_MODULE_INFO(modfps);
+
+static const TCModuleClass modfps_class = {
+    TC_MODULE_CLASS_HEAD(modfps),
+
+    .init         = modfps_init,
+    .fini         = modfps_fini,
+    .configure    = modfps_configure,
+    .stop         = modfps_stop,
+    .inspect      = modfps_inspect,
+
+    .filter_video = modfps_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(modfps)
+
+/*************************************************************************/
+
+static int modfps_get_config(TCModuleInstance *self, char *options)
+{
+    ModfpsPrivateData *pd = NULL;
+    char buf[255];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VYRE", "1");
+
+    tc_snprintf(buf, sizeof(buf), "%d", pd->mode);
+    optstr_param(options, "mode", "mode of operation",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%f", pd->infps);
+    optstr_param(options, "infps", "Original fps",
+                 "%f", buf, "MIN_FPS", "200.0");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->infrc);
+    optstr_param(options, "infrc", "Original frc",
+                 "%d", buf, "0", "16");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->numSample);
+    optstr_param(options, "examine", "How many frames to buffer",
+                 "%d", buf, "2", "25");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->offset);
+    optstr_param(options, "subsample", "How many pixels to subsample",
+                 "%d", buf, "1", "256");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->clonetype);
+    optstr_param(options, "clonetype", "How to clone frames",
+                 "%d", buf, "0", "16");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->show_results);
+    optstr_param(options, "verbose", "run in verbose mode",
+                 "%d", buf, "0", "1");
+    return TC_OK;
+}
+
+static int modfps_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    ModfpsPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    pd = self->userdata;
+
+    /* skips in the decoder, clones in the encoder: always in order */
+    if ((frame->tag & pd->runnow) && (frame->tag & TC_VIDEO)) {
+        return modfps_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(modfps)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
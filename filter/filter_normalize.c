@@ -34,18 +34,35 @@
  * */
 
 #define MOD_NAME    "filter_normalize.so"
-#define MOD_VERSION "v0.1.1 (2002-06-18)"
+#define MOD_VERSION "v0.2.0 (2026-10-18)"
 #define MOD_CAP     "Volume normalizer"
 #define MOD_AUTHOR  "pl, Tilmann Bitterberg"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_AUDIO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_SEQUENTIAL
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include <math.h>
 
 
+static const char normalize_help[] = ""
+    "Overview\n"
+    "    normalizes audio\n"
+    "Options\n"
+    "    smooth      double for smoothing ]0.0 1.0[  [0.06]\n"
+    "    smoothlast  double for smoothing last sample ]0.0, 1.0[  [0.06]\n"
+    "    algo        Which algorithm to use (1 or 2) [1]\n"
+    "                1: uses a 1 value memory and coefficients\n"
+    "                   new=a*old+b*cur (with a+b=1)\n"
+    "                2: uses several samples to smooth the variations\n"
+    "                   (standard weighted mean on past samples)\n";
 
 // basic parameter
 // mul is the value by which the samples are scaled
@@ -67,246 +84,320 @@
 // FIXME: should be relative to the level of the samples
 #define SIL_S16 (MAX_S16 * 0.01)
 
+#define NSAMPLES 128
 
-// Local data
+#define CLAMP(x,m,M) do { if ((x)<(m)) (x) = (m); else if ((x)>(M)) (x) = (M); } while(0)
 
-#define NSAMPLES 128
+/*************************************************************************/
 
 struct mem_t {
-    double avg;		// average level of the sample
-    int32_t len;	// sample size (weight)
+    double avg;         // average level of the sample
+    int32_t len;        // sample size (weight)
 };
 
-typedef struct MyFilterData {
-	int format;
-	double mul;
-	double SMOOTH_MUL;
-	double SMOOTH_LASTAVG;
-	double lastavg;
-	int idx;
-	struct mem_t mem[NSAMPLES];
-	int AVG;
-} MyFilterData;
-
-static MyFilterData *mfd = NULL;
-
-/* should probably honor the other flags too */
-
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
-
-static void help_optstr(void)
-{
-   tc_log_info (MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"    normalizes audio\n"
-"* Options\n"
-"     'smooth' double for smoothing ]0.0 1.0[  [0.06]\n"
-" 'smoothlast' double for smoothing last sample ]0.0, 1.0[  [0.06]\n"
-"       'algo' Which algorithm to use (1 or 2) [1]\n"
-"            1: uses a 1 value memory and coefficients new=a*old+b*cur (with a+b=1)\n"
-"            2: uses several samples to smooth the variations (standard weighted mean\n"
-"            on past samples)\n"
-		, MOD_CAP);
-}
+/* The gain follows the level of the previous frames, so frames must come
+ * in order. */
 
-static void reset(void)
-{
-  int i;
-  mfd->mul = MUL_INIT;
-  switch(mfd->format) {
-      case(1): /* XXX: bogus */
-      mfd->lastavg = MID_S16;
-      for(i=0; i < NSAMPLES; ++i) {
-	      mfd->mem[i].len = 0;
-	      mfd->mem[i].avg = 0;
-      }
-      mfd->idx = 0;
-
-      break;
-    default:
-      break;
-  }
-}
+typedef struct NormalizePrivateData_ {
+    double mul;
+    double SMOOTH_MUL;
+    double SMOOTH_LASTAVG;
+    double lastavg;
+    int idx;
+    struct mem_t mem[NSAMPLES];
+    int AVG;
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  aframe_list_t *ptr = (aframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
-
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "pl, Tilmann Bitterberg", "AE", "1");
-      optstr_param (options, "smooth", "Value for smoothing ]0.0 1.0[", "%f", "0.06", "0.0", "1.0");
-      optstr_param (options, "smoothlast", "Value for smoothing last sample ]0.0, 1.0[", "%f", "0.06", "0.0", "1.0");
-      optstr_param (options, "algo", "Algorithm to use (1 or 2). 1=uses a 1 value memory and coefficients new=a*old+b*cur (with a+b=1).   2=uses several samples to smooth the variations (standard weighted mean on past samples)", "%d", "1", "1", "2");
-      return 0;
-  }
+    char opt_buf[TC_BUF_MIN];
+} NormalizePrivateData;
 
+/*************************************************************************/
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+/* Module interface routines and data. */
 
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_INIT) {
+/**
+ * normalize_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+TC_MODULE_GENERIC_INIT(normalize, NormalizePrivateData)
 
-    if (vob->a_bits != 16) {
-	tc_log_error(MOD_NAME, "This filter only works for 16 bit samples");
-	return (-1);
+/*************************************************************************/
 
-    }
-    if((mfd = tc_malloc (sizeof(MyFilterData))) == NULL) return (-1);
+/**
+ * normalize_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    mfd->format  = 1; /* XXX bogus */
-    mfd->mul     = MUL_INIT;
-    mfd->lastavg = MID_S16;
-    mfd->idx     = 0;
-    mfd->SMOOTH_MUL     = 0.06;
-    mfd->SMOOTH_LASTAVG = 0.06;
-    mfd->AVG     = 1;
+TC_MODULE_GENERIC_FINI(normalize)
 
-    reset();
+/*************************************************************************/
 
-    if (options != NULL) {
+/**
+ * normalize_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-	if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
+static int normalize_configure(TCModuleInstance *self,
+                               const char *options,
+                               TCJob *vob,
+                               TCModuleExtraData *xdata[])
+{
+    NormalizePrivateData *pd = NULL;
+    int i;
 
-	optstr_get(options, "smooth", "%lf", &mfd->SMOOTH_MUL);
-	optstr_get(options, "smoothlast", "%lf", &mfd->SMOOTH_LASTAVG);
-	optstr_get(options, "algo", "%d", &mfd->AVG);
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
 
-	if (mfd->AVG > 2) mfd->AVG = 2;
-	if (mfd->AVG < 1) mfd->AVG = 1;
+    pd = self->userdata;
 
+    if (vob->a_bits != 16) {
+        tc_log_error(MOD_NAME, "This filter only works for 16 bit samples");
+        return TC_ERROR;
     }
 
-#if 0
-    if (verbose > 1) {
-	tc_log_info (MOD_NAME, " Normalize Filter Settings:");
+    pd->mul            = MUL_INIT;
+    pd->lastavg        = MID_S16;
+    pd->idx            = 0;
+    pd->SMOOTH_MUL     = 0.06;
+    pd->SMOOTH_LASTAVG = 0.06;
+    pd->AVG            = 1;
+    for (i = 0; i < NSAMPLES; ++i) {
+        pd->mem[i].len = 0;
+        pd->mem[i].avg = 0;
     }
-#endif
-
-    if (options)
-	if (optstr_lookup (options, "help")) {
-	    help_optstr();
-	}
-
-    // filter init ok.
-    if (verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
 
+    if (options != NULL) {
+        if (verbose)
+            tc_log_info(MOD_NAME, "options=%s", options);
 
-    return(0);
-  }
+        optstr_get(options, "smooth",     "%lf", &pd->SMOOTH_MUL);
+        optstr_get(options, "smoothlast", "%lf", &pd->SMOOTH_LASTAVG);
+        optstr_get(options, "algo",       "%d",  &pd->AVG);
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
+        if (pd->AVG > 2) pd->AVG = 2;
+        if (pd->AVG < 1) pd->AVG = 1;
 
+        if (optstr_lookup(options, "help")) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, normalize_help);
+        }
+    }
+    return TC_OK;
+}
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
+/*************************************************************************/
 
-    if (mfd) {
-	free(mfd);
-    }
+/**
+ * normalize_stop:  Reset this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    return(0);
+static int normalize_stop(TCModuleInstance *self)
+{
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
+}
 
-  } /* filter close */
+/*************************************************************************/
 
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
+/**
+ * normalize_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
+static int normalize_inspect(TCModuleInstance *self,
+                             const char *param, const char **value)
+{
+    NormalizePrivateData *pd = NULL;
 
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-  if((ptr->tag & TC_PRE_M_PROCESS) && (ptr->tag & TC_AUDIO) && !(ptr->attributes & TC_FRAME_IS_SKIPPED))  {
+    pd = self->userdata;
 
+    if (optstr_lookup(param, "help")) {
+        *value = normalize_help;
+    }
+    if (optstr_lookup(param, "smooth")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%f", pd->SMOOTH_MUL);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "smoothlast")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%f",
+                    pd->SMOOTH_LASTAVG);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "algo")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->AVG);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
 
-#define CLAMP(x,m,M) do { if ((x)<(m)) (x) = (m); else if ((x)>(M)) (x) = (M); } while(0)
+/*************************************************************************/
 
-    int16_t* data=(int16_t *)ptr->audio_buf;
-    int len=ptr->audio_size / 2; // 16 bits samples
+/**
+ * normalize_filter_audio:  scale the given frame toward the ideal level.
+ * See tcmodule-data.h for function details.
+ */
 
+static int normalize_filter_audio(TCModuleInstance *self,
+                                  aframe_list_t *frame)
+{
+    NormalizePrivateData *pd = NULL;
+    int16_t *data = NULL;
+    int len;
     int32_t i, tmp;
     double curavg, newavg;
-
     double neededmul;
-
     double avg;
     int32_t totallen;
 
+    TC_MODULE_SELF_CHECK(self, "filter_audio");
+    TC_MODULE_SELF_CHECK(frame, "filter_audio");
+
+    pd = self->userdata;
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+
+    data = (int16_t *)frame->audio_buf;
+    len = frame->audio_size / 2; // 16 bits samples
+
     // Evaluate current samples average level
     curavg = 0.0;
     for (i = 0; i < len ; ++i) {
-      tmp = data[i];
-      curavg += tmp * tmp;
+        tmp = data[i];
+        curavg += tmp * tmp;
     }
     curavg = sqrt(curavg / (double) len);
 
-    // Evaluate an adequate 'mul' coefficient based on previous state, current
-    // samples level, etc
-    if (mfd->AVG == 1) {
-	if (curavg > SIL_S16) {
-	    neededmul = MID_S16 / ( curavg * mfd->mul);
-	    mfd->mul = (1.0 - mfd->SMOOTH_MUL) * mfd->mul + mfd->SMOOTH_MUL * neededmul;
-
-	    // Clamp the mul coefficient
-	    CLAMP(mfd->mul, MUL_MIN, MUL_MAX);
-	}
-    } else if (mfd->AVG == 2) {
-	avg = 0.0;
-	totallen = 0;
-
-	for (i = 0; i < NSAMPLES; ++i) {
-	    avg += mfd->mem[i].avg * (double) mfd->mem[i].len;
-	    totallen += mfd->mem[i].len;
-	}
-
-	if (totallen > MIN_SAMPLE_SIZE) {
-	    avg /= (double) totallen;
-	    if (avg >= SIL_S16) {
-		mfd->mul = (double) MID_S16 / avg;
-		CLAMP(mfd->mul, MUL_MIN, MUL_MAX);
-	    }
-	}
+    // Evaluate an adequate 'mul' coefficient based on previous state,
+    // current samples level, etc
+    if (pd->AVG == 1) {
+        if (curavg > SIL_S16) {
+            neededmul = MID_S16 / (curavg * pd->mul);
+            pd->mul = (1.0 - pd->SMOOTH_MUL) * pd->mul
+                    + pd->SMOOTH_MUL * neededmul;
+
+            // Clamp the mul coefficient
+            CLAMP(pd->mul, MUL_MIN, MUL_MAX);
+        }
+    } else if (pd->AVG == 2) {
+        avg = 0.0;
+        totallen = 0;
+
+        for (i = 0; i < NSAMPLES; ++i) {
+            avg += pd->mem[i].avg * (double) pd->mem[i].len;
+            totallen += pd->mem[i].len;
+        }
+
+        if (totallen > MIN_SAMPLE_SIZE) {
+            avg /= (double) totallen;
+            if (avg >= SIL_S16) {
+                pd->mul = (double) MID_S16 / avg;
+                CLAMP(pd->mul, MUL_MIN, MUL_MAX);
+            }
+        }
     }
 
     // Scale & clamp the samples
     for (i = 0; i < len ; ++i) {
-      tmp = mfd->mul * data[i];
-      CLAMP(tmp, MIN_S16, MAX_S16);
-      data[i] = tmp;
+        tmp = pd->mul * data[i];
+        CLAMP(tmp, MIN_S16, MAX_S16);
+        data[i] = tmp;
     }
 
     // Evaluation of newavg (not 100% accurate because of values clamping)
-    newavg = mfd->mul * curavg;
+    newavg = pd->mul * curavg;
 
     // Stores computed values for future smoothing
-    if (mfd->AVG == 1) {
-	mfd->lastavg = (1.0-mfd->SMOOTH_LASTAVG)*mfd->lastavg + mfd->SMOOTH_LASTAVG*newavg;
-    } else if (mfd->AVG == 2) {
-	mfd->mem[mfd->idx].len = len;
-	mfd->mem[mfd->idx].avg = newavg;
-	mfd->idx = (mfd->idx + 1) % NSAMPLES;
+    if (pd->AVG == 1) {
+        pd->lastavg = (1.0 - pd->SMOOTH_LASTAVG) * pd->lastavg
+                    + pd->SMOOTH_LASTAVG * newavg;
+    } else if (pd->AVG == 2) {
+        pd->mem[pd->idx].len = len;
+        pd->mem[pd->idx].avg = newavg;
+        pd->idx = (pd->idx + 1) % NSAMPLES;
     }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID normalize_codecs_audio_in[] = {
+    TC_CODEC_PCM, TC_CODEC_ERROR
+};
+static const TCCodecID normalize_codecs_audio_out[] = {
+    TC_CODEC_PCM, TC_CODEC_ERROR
+};
+TC_MODULE_VIDEO_UNSUPPORTED(normalize);
+TC_MODULE_FILTER_FORMATS(normalize);
 
+TC_MODULE_INFO(normalize);
 
-  }
+static const TCModuleClass normalize_class = {
+    TC_MODULE_CLASS_HEAD(normalize),
 
-  return(0);
+    .init         = normalize_init,
+    .fini         = normalize_fini,
+    .configure    = normalize_configure,
+    .stop         = normalize_stop,
+    .inspect      = normalize_inspect,
+
+    .filter_audio = normalize_filter_audio
+};
+
+TC_MODULE_ENTRY_POINT(normalize)
+
+/*************************************************************************/
+
+static int normalize_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "AE", "1");
+    optstr_param(options, "smooth", "Value for smoothing ]0.0 1.0[",
+                 "%f", "0.06", "0.0", "1.0");
+    optstr_param(options, "smoothlast",
+                 "Value for smoothing last sample ]0.0, 1.0[",
+                 "%f", "0.06", "0.0", "1.0");
+    optstr_param(options, "algo", "Algorithm to use (1 or 2)."
+                 " 1=uses a 1 value memory and coefficients"
+                 " new=a*old+b*cur (with a+b=1)."
+                 "   2=uses several samples to smooth the variations"
+                 " (standard weighted mean on past samples)",
+                 "%d", "1", "1", "2");
+    return TC_OK;
+}
+
+static int normalize_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    if ((frame->tag & TC_PRE_M_PROCESS) && (frame->tag & TC_AUDIO)) {
+        return normalize_filter_audio(self, (aframe_list_t*)frame);
+    }
+    return TC_OK;
 }
 
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(normalize)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -22,7 +22,7 @@
     TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO|TC_MODULE_FEATURE_AUDIO
 /* How this module can work (see NMS documentation for details) */
 #define MOD_FLAGS \
-    TC_MODULE_FLAG_RECONFIGURABLE
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL
 
 
 /* API reminder (mostly for OMS, but take in mind for NMS too):
@@ -35,129 +35,268 @@
  */
 
 #define MOD_NAME    "filter_skip.so"
-#define MOD_VERSION "v0.2 (2005-01-05)"
+#define MOD_VERSION "v0.3 (2026-10-18)"
 #define MOD_CAP     "skip all listed frames"
 #define MOD_AUTHOR  "Thomas Oestreich, Thomas Wehrspann"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO|TC_MODULE_FEATURE_AUDIO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL|TC_MODULE_FLAG_READONLY
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include "libtc/framecode.h"
 
 
+static const char skip_help[] = ""
+    "Overview\n"
+    "    This filter skips all listed frames.\n"
+    "\n"
+    "Options\n"
+    "                    'help' Prints out this help text\n"
+    "    'start-end/step [...]' List of frame ranges to skip (start-end/step) []\n";
+
+/*************************************************************************/
+
+typedef struct SkipPrivateData_ {
+    struct fc_time *list;   /* frame ranges to skip */
+    double avoffset;        /* audio frame id -> video frame id */
+} SkipPrivateData;
+
+/*************************************************************************/
+
+/* Skip the frame if `id' is listed. */
+
+static void skip_frame(const SkipPrivateData *pd, frame_list_t *frame,
+                       int id)
+{
+    /* fc_frame_in_time returns the step frequency */
+    int ret = fc_frame_in_time(pd->list, id);
+
+    if (ret && !(id % ret))
+        frame->attributes |= TC_FRAME_IS_SKIPPED;
+}
+
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * skip_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(skip, SkipPrivateData)
+
+/*************************************************************************/
+
 /**
- * Help text.
- * This function prints out a small description of this filter and
- * the command-line options when the "help" parameter is given
- *********************************************************/
-static void help_optstr(void)
+ * skip_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(skip)
+
+/*************************************************************************/
+
+/**
+ * skip_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int skip_configure(TCModuleInstance *self,
+                          const char *options,
+                          TCJob *vob,
+                          TCModuleExtraData *xdata[])
 {
-  tc_log_info (MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"    This filter skips all listed frames.\n"
-"\n"
-"* Options\n"
-"                    'help' Prints out this help text\n"
-"    'start-end/step [...]' List of frame ranges to skip (start-end/step) []\n"
-	       , MOD_CAP);
+    SkipPrivateData *pd = NULL;
+    char separator[] = " ";
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+    pd->list = NULL;
+    pd->avoffset = vob->fps / vob->ex_fps;
+
+    if (verbose & TC_DEBUG)
+        tc_log_info(MOD_NAME, "options=%s", options);
+
+    if (options == NULL)
+        return TC_OK;
+    if (optstr_lookup(options, "help")) {
+        tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, skip_help);
+        return TC_OK;
+    }
+    if (parse_fc_time_string(options, vob->fps, separator, verbose,
+                             &pd->list) == -1) {
+        tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, skip_help);
+        return TC_ERROR;
+    }
+    return TC_OK;
 }
 
+/*************************************************************************/
 
 /**
- * Main function of a filter.
- * This is the single function interface to transcode. This is the only function needed for a filter plugin.
- * @param ptr     frame accounting structure
- * @param options command-line options of the filter
- *
- * @return 0, if everything went OK.
- *********************************************************/
-int tc_filter(frame_list_t *ptr_, char *options)
+ * skip_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int skip_stop(TCModuleInstance *self)
 {
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static struct fc_time *list;
-  static double avoffset=1.0;
-  char separator[] = " ";
-
-  vob_t *vob=NULL;
-
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-    optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VARY4E", "1");
-
-    optstr_param (options, "start-end/step [...]", "Skip frames", "%s", "");
-      return 0;
-  }
-
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
-  if(ptr->tag & TC_FILTER_INIT) {
-
-    if((vob = tc_get_vob())==NULL) return(-1);
-
-    // filter init ok.
-
-    if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-    if(verbose & TC_DEBUG) tc_log_info(MOD_NAME, "options=%s", options);
-
-    if(options == NULL) return(0);
-
-    // Parameter parsing
-    if(options == NULL) return(0);
-    else if (optstr_lookup (options, "help")) {
-      help_optstr();
-      return (0);
-    } else {
-      if( parse_fc_time_string( options, vob->fps, separator, verbose, &list ) == -1 ) {
-        help_optstr();
-        return (-1);
-      }
+    SkipPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+    if (pd->list) {
+        free_fc_time(pd->list);
+        pd->list = NULL;
     }
+    return TC_OK;
+}
 
-    avoffset = vob->fps/vob->ex_fps;
+/*************************************************************************/
 
-    return(0);
-  }
+/**
+ * skip_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
-  if(ptr->tag & TC_FILTER_CLOSE) {
-    return(0);
-  }
+static int skip_inspect(TCModuleInstance *self,
+                        const char *param, const char **value)
+{
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    if (optstr_lookup(param, "help")) {
+        *value = skip_help;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * skip_filter_video:  skip the given video frame if listed.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int skip_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    SkipPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+    if (pd->list)
+        skip_frame(pd, (frame_list_t *)frame, frame->id);
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * skip_filter_audio:  skip the given audio frame if the matching video
+ * frame is listed.  See tcmodule-data.h for function details.
+ */
+
+static int skip_filter_audio(TCModuleInstance *self, aframe_list_t *frame)
+{
+    SkipPrivateData *pd = NULL;
 
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audio frame processing routines
-  // or after and determines video/audio context
-  if((ptr->tag & TC_PRE_S_PROCESS) && (ptr->tag & TC_VIDEO)) {
+    TC_MODULE_SELF_CHECK(self, "filter_audio");
+    TC_MODULE_SELF_CHECK(frame, "filter_audio");
 
-      // fc_frame_in_time returns the step frequency
-      int ret = fc_frame_in_time(list, ptr->id);
+    pd = self->userdata;
+    if (pd->list)
+        skip_frame(pd, (frame_list_t *)frame,
+                   (int)((double)frame->id * pd->avoffset));
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID skip_codecs_video_in[] = {
+    TC_CODEC_ANY, TC_CODEC_ERROR
+};
+static const TCCodecID skip_codecs_video_out[] = {
+    TC_CODEC_ANY, TC_CODEC_ERROR
+};
+static const TCCodecID skip_codecs_audio_in[] = {
+    TC_CODEC_ANY, TC_CODEC_ERROR
+};
+static const TCCodecID skip_codecs_audio_out[] = {
+    TC_CODEC_ANY, TC_CODEC_ERROR
+};
+TC_MODULE_FILTER_FORMATS(skip);
+
+TC_MODULE_INFO(skip);
+
+static const TCModuleClass skip_class = {
+    TC_MODULE_CLASS_HEAD(skip),
 
-      if ((ret && !(ptr->id%ret)))
-        ptr->attributes |= TC_FRAME_IS_SKIPPED;
+    .init         = skip_init,
+    .fini         = skip_fini,
+    .configure    = skip_configure,
+    .stop         = skip_stop,
+    .inspect      = skip_inspect,
 
-  } else if ((ptr->tag & TC_PRE_S_PROCESS) && (ptr->tag & TC_AUDIO)){
+    .filter_video = skip_filter_video,
+    .filter_audio = skip_filter_audio
+};
 
-    int ret;
-    int tmp_id;
+TC_MODULE_ENTRY_POINT(skip)
 
-    tmp_id = (int)((double)ptr->id*avoffset);
-    ret = fc_frame_in_time(list, tmp_id);
-    if ((ret && !(tmp_id%ret)))
-      ptr->attributes |= TC_FRAME_IS_SKIPPED;
+/*************************************************************************/
 
-  }
+static int skip_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
 
-  return(0);
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VARY4E", "1");
+    optstr_param(options, "start-end/step [...]", "Skip frames", "%s", "");
+    return TC_OK;
 }
+
+static int skip_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    if (frame->tag & TC_PRE_S_PROCESS) {
+        if (frame->tag & TC_VIDEO)
+            return skip_filter_video(self, (vframe_list_t*)frame);
+        if (frame->tag & TC_AUDIO)
+            return skip_filter_audio(self, (aframe_list_t*)frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(skip)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -22,117 +22,237 @@
  */
 
 #define MOD_NAME    "filter_slowmo.so"
-#define MOD_VERSION "v0.3.1 (2006-09-10)"
+#define MOD_VERSION "v0.4.0 (2026-10-18)"
 #define MOD_CAP     "very cheap slow-motion effect"
 #define MOD_AUTHOR  "Tilmann Bitterberg"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_READONLY
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
 
-static void help_optstr(void)
-{
-    tc_log_info(MOD_NAME, "(%s) help", MOD_CAP);
-    tc_log_info(MOD_NAME,
-"\n* Overview\n"
-"   This filter produces a simple slow-motion effect by\n"
-"   duplicating certain frames. I have seen this effect\n"
-"   on TV and despite its the simple algorithm it works\n"
-"   quite well. The filter has no options.\n");
-}
+static const char slowmo_help[] = ""
+    "Overview\n"
+    "   This filter produces a simple slow-motion effect by\n"
+    "   duplicating certain frames. I have seen this effect\n"
+    "   on TV and despite its the simple algorithm it works\n"
+    "   quite well. The filter has no options.\n";
 
-static int do_clone(int id)
-{
-    static int last = 0;
+/*************************************************************************/
+
+typedef struct SlowmoPrivateData_ {
+    int last;   /* clone countdown, see slowmo_do_clone() */
+} SlowmoPrivateData;
 
+/*************************************************************************/
+
+static int slowmo_do_clone(SlowmoPrivateData *pd, int id)
+{
     if ((id) % 3 == 0) {
-        last = 0;
+        pd->last = 0;
         return 1;
     }
-    if (last > 0) {
-        last--;
+    if (pd->last > 0) {
+        pd->last--;
         return 0;
     }
-    if (last == 0) {
-        last = -1;
+    if (pd->last == 0) {
+        pd->last = -1;
         return 1;
     }
     return 0;
 }
 
-static inline int slowmo_init(const char *options)
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * slowmo_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(slowmo, SlowmoPrivateData)
+
+/*************************************************************************/
+
+/**
+ * slowmo_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(slowmo)
+
+/*************************************************************************/
+
+/**
+ * slowmo_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int slowmo_configure(TCModuleInstance *self,
+                            const char *options,
+                            TCJob *vob,
+                            TCModuleExtraData *xdata[])
 {
-    if (verbose) {
-        tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-    }
+    SlowmoPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+    pd->last = 0;
+
     if (options != NULL) {
         if (verbose) {
             tc_log_info(MOD_NAME, "options=%s", options);
         }
         if (optstr_lookup(options, "help") != NULL) {
-            help_optstr();
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, slowmo_help);
         }
     }
-    return 0;
+    return TC_OK;
 }
- 
-static inline int slowmo_exec(vframe_list_t *ptr)
+
+/*************************************************************************/
+
+/**
+ * slowmo_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int slowmo_stop(TCModuleInstance *self)
 {
-    /*
-     * tag variable indicates, if we are called before
-     * transcodes internal video/audo frame processing routines
-     * or after and determines video/audio context
-     *
-     *  1 <-
-     *  2 <-
-     *  3 = 2
-     *  4 <-
-     *  5 = 4
-     *  6 <-
-     *  7 <-
-     *  8 = 7
-     *  9 <-
-     * 10 = 9
-     * 11 <-
-     * 12 <-
-     * 13 = 12
-     * 14 <-
-     * 15 = 14
-     */
-
-    if (ptr->tag & TC_PRE_S_PROCESS && ptr->tag & TC_VIDEO) {
-        if (!(ptr->tag & TC_FRAME_WAS_CLONED) && do_clone(ptr->id))  {
-	        ptr->attributes |= TC_FRAME_IS_CLONED;
-        }
-    }
-    return 0;
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
+/*************************************************************************/
+
+/**
+ * slowmo_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
+
+static int slowmo_inspect(TCModuleInstance *self,
+                          const char *param, const char **value)
 {
-    vframe_list_t *ptr = (vframe_list_t*)ptr_;
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-    if (ptr->tag & TC_FILTER_INIT) {
-        return slowmo_init(options);
+    if (optstr_lookup(param, "help")) {
+        *value = slowmo_help;
     }
+    return TC_OK;
+}
 
-    if (ptr->tag & TC_FILTER_CLOSE) {
-        return 0;
-    }
+/*************************************************************************/
 
-    if (ptr->tag & TC_FILTER_GET_CONFIG) {
-        optstr_filter_desc(options, MOD_NAME, MOD_CAP,
-                           MOD_VERSION, MOD_AUTHOR, "VRYE", "1");
-        return 0;
+/**
+ * slowmo_filter_video:  mark the frames to be duplicated.  See
+ * tcmodule-data.h for function details.
+ *
+ *  1 <-
+ *  2 <-
+ *  3 = 2
+ *  4 <-
+ *  5 = 4
+ *  6 <-
+ *  7 <-
+ *  8 = 7
+ *  9 <-
+ * 10 = 9
+ * 11 <-
+ * 12 <-
+ * 13 = 12
+ * 14 <-
+ * 15 = 14
+ */
+
+static int slowmo_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    if (!(frame->attributes & TC_FRAME_WAS_CLONED)
+     && slowmo_do_clone(self->userdata, frame->id)) {
+        frame->attributes |= TC_FRAME_IS_CLONED;
     }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID slowmo_codecs_video_in[] = {
+    TC_CODEC_ANY, TC_CODEC_ERROR
+};
+static const TCCodecID slowmo_codecs_video_out[] = {
+    TC_CODEC_ANY, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(slowmo);
+TC_MODULE_FILTER_FORMATS(slowmo);
+
+TC_MODULE_INFO(slowmo);
+
+static const TCModuleClass slowmo_class = {
+    TC_MODULE_CLASS_HEAD(slowmo),
+
+    .init         = slowmo_init,
+    .fini         = slowmo_fini,
+    .configure    = slowmo_configure,
+    .stop         = slowmo_stop,
+    .inspect      = slowmo_inspect,
 
-    return slowmo_exec(ptr);
+    .filter_video = slowmo_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(slowmo)
+
+/*************************************************************************/
+
+static int slowmo_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP,
+                       MOD_VERSION, MOD_AUTHOR, "VRYE", "1");
+    return TC_OK;
 }
 
+static int slowmo_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    /* cloning a frame is up to the decoder */
+    if (frame->tag & TC_PRE_S_PROCESS && frame->tag & TC_VIDEO) {
+        return slowmo_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(slowmo)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
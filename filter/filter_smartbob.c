@@ -45,19 +45,36 @@
 */
 
 #define MOD_NAME    "filter_smartbob.so"
-#define MOD_VERSION "v1.1beta2 (2003-06-23)"
+#define MOD_VERSION "v1.2 (2026-10-18)"
 #define MOD_CAP     "Motion-adaptive deinterlacing for double-frame-rate output."
 #define MOD_AUTHOR  "Donald Graft, Tilmann Bitterberg"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include "libtcvideo/tcvideo.h"
 
 
-static vob_t *vob=NULL;
+static const char smartbob_help[] = ""
+    "Overview\n"
+    "    This filter only makes sence when fed by -J doublefps.\n"
+    "    It will take the field-frames which filter_doublefps\n"
+    "    produces and generates full-sized motion adaptive deinterlaced\n"
+    "    output at the double import framerate.\n"
+    "\n"
+    "Options\n"
+    "    'motionOnly' Show motion areas only (0=off, 1=on) [1]\n"
+    "     'threshold' Motion Threshold (0-255) [15]\n"
+    "       'denoise' denoise (0=off, 1=on) [0]\n"
+    "     'shiftEven' Phase shift (0=off, 1=on) [0]\n";
 
 /* vdub compat */
 typedef unsigned int	Pixel;
@@ -73,171 +90,28 @@ typedef	int		PixOffset;
 #define DENOISE_DIAMETER 5
 #define DENOISE_THRESH 7
 
-typedef struct MyFilterData {
-	Pixel32			*convertFrameIn;
-	Pixel32			*convertFrameOut;
-	int			*prevFrame;
-	unsigned char		*moving;
-	unsigned char		*fmoving;
-	int 			bShiftEven;
-	int			bMotionOnly;
-	int 			bDenoise;
-	int 			threshold;
-	int                     codec;
-	TCVHandle		tcvhandle;
-} MyFilterData;
-
-static MyFilterData *mfd;
-
-static void help_optstr(void)
-{
-   tc_log_info (MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"   This filter only makes sence when fed by -J doublefps.\n"
-"   It will take the field-frames which filter_doublefps\n"
-"   produces and generates full-sized motion adaptive deinterlaced\n"
-"   output at the double import framerate.\n"
-"\n"
-"* Options\n"
-"      'motionOnly' Show motion areas only (0=off, 1=on) [1]\n"
-"       'threshold' Motion Threshold (0-255) [15]\n"
-"         'denoise' denoise (0=off, 1=on) [0]\n"
-"       'shiftEven' Phase shift (0=off, 1=on) [0]\n"
-, MOD_CAP);
-}
-
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
-
-
-  if(ptr->tag & TC_FILTER_INIT) {
-
-	unsigned int width, height;
-
-	if((vob = tc_get_vob())==NULL) return(-1);
-
-
-	mfd = tc_zalloc(sizeof(MyFilterData));
-
-	if (!mfd) {
-		tc_log_error(MOD_NAME, "No memory!");
-	        return (-1);
-	}
-
-	width  = vob->im_v_width;
-	height = vob->im_v_height;
-
-	/* default values */
-	mfd->bShiftEven = 0;
-	mfd->bMotionOnly = 0;
-	mfd->bDenoise = 1;
-	mfd->threshold = 12;
-	mfd->codec          = vob->im_v_codec;
-
-	if (options != NULL) {
-
-	  if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
-
-	  optstr_get (options, "motionOnly",     "%d",  &mfd->bMotionOnly       );
-	  optstr_get (options, "shiftEven",      "%d",  &mfd->bShiftEven        );
-	  optstr_get (options, "threshold",      "%d",  &mfd->threshold        );
-	  optstr_get (options, "denoise",        "%d",  &mfd->bDenoise         );
-
-	  if (optstr_lookup (options, "help") != NULL) {
-		  help_optstr();
-	  }
-	}
-
-	if (verbose > 1) {
-
-	  tc_log_info (MOD_NAME, " Smart Deinterlacer Filter Settings (%dx%d):", width, height);
-	  tc_log_info (MOD_NAME, "        motionOnly = %d", mfd->bMotionOnly);
-	  tc_log_info (MOD_NAME, "           denoise = %d", mfd->bDenoise);
-	  tc_log_info (MOD_NAME, "         threshold = %d", mfd->threshold);
-	  tc_log_info (MOD_NAME, "         shiftEven = %d", mfd->bShiftEven);
-	}
-
-	/* fetch memory */
+/* prevFrame keeps the previous field: the frames must come in order. */
 
-	mfd->convertFrameIn = tc_zalloc (width * height * sizeof(Pixel32));
-	mfd->convertFrameOut = tc_zalloc (width * height * sizeof(Pixel32));
-	mfd->prevFrame = tc_zalloc (width*height*sizeof(int));
-	mfd->moving = tc_zalloc (sizeof(unsigned char)*width*height);
-	mfd->fmoving = tc_zalloc (sizeof(unsigned char)*width*height);
+typedef struct SmartbobPrivateData_ {
+    Pixel32 *convertFrameIn;
+    Pixel32 *convertFrameOut;
+    int *prevFrame;
+    unsigned char *moving;
+    unsigned char *fmoving;
+    int bShiftEven;
+    int bMotionOnly;
+    int bDenoise;
+    int threshold;
+    int codec;
+    TCVHandle tcvhandle;
 
-	mfd->tcvhandle = tcv_init();
+    char opt_buf[TC_BUF_MIN];
+} SmartbobPrivateData;
 
-	// filter init ok.
-	if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-
-	return 0;
-
-  } /* TC_FILTER_INIT */
-
-
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-      char buf[255];
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VRYO", "1");
-
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->bMotionOnly);
-      optstr_param (options, "motionOnly", "Show motion areas only" ,"%d", buf, "0", "1");
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->bShiftEven);
-      optstr_param (options, "shiftEven", "Blend instead of interpolate in motion areas", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->threshold);
-      optstr_param (options, "threshold", "Motion Threshold", "%d", buf, "0", "255" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->bDenoise);
-      optstr_param (options, "denoise", "Phase shift", "%d", buf, "0", "1" );
-
-      return (0);
-  }
-
-  if(ptr->tag & TC_FILTER_CLOSE) {
-
-	if (!mfd)
-		return 0;
-
-	if (mfd->prevFrame)
-	    free(mfd->prevFrame);
-	mfd->prevFrame = NULL;
-
-	if (mfd->moving)
-	    free(mfd->moving);
-	mfd->moving = NULL;
-
-	if (mfd->fmoving)
-	    free(mfd->fmoving);
-	mfd->fmoving = NULL;
-
-	if (mfd->convertFrameIn) {
-		free (mfd->convertFrameIn);
-		mfd->convertFrameIn = NULL;
-	}
-
-	if (mfd->convertFrameOut) {
-		free (mfd->convertFrameOut);
-		mfd->convertFrameOut = NULL;
-	}
-
-	tcv_free(mfd->tcvhandle);
-
-	if (mfd)
-		free(mfd);
-
-	return 0;
-
-  } /* TC_FILTER_CLOSE */
-
-///////////////////////////////////////////////////////////////////////////
-
-  if(ptr->tag & TC_POST_S_PROCESS && ptr->tag & TC_VIDEO) {
+/* Deinterlace one field-frame, buffering it for the next one. */
 
+static void smartbob_field(SmartbobPrivateData *mfd, vframe_list_t *ptr)
+{
 	Pixel32 *src, *dst, *srcn, *srcnn, *srcp;
 	unsigned char *moving, *fmoving;
 	int x, y, *prev;
@@ -522,8 +396,279 @@ int tc_filter(frame_list_t *ptr_, char *options)
 		    ptr->video_buf, ptr->v_width, ptr->v_height,
 		    ac_endian()==AC_LITTLE_ENDIAN ? IMG_BGRA32 : IMG_ARGB32,
 		    mfd->codec==TC_CODEC_YUV420P ? IMG_YUV_DEFAULT : IMG_RGB24);
+}
 
-	return 0;
-  }
-  return 0;
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * smartbob_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(smartbob, SmartbobPrivateData)
+
+/*************************************************************************/
+
+/**
+ * smartbob_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(smartbob)
+
+/*************************************************************************/
+
+/**
+ * smartbob_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int smartbob_stop(TCModuleInstance *self)
+{
+    SmartbobPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+
+    tc_free(pd->prevFrame);
+    pd->prevFrame = NULL;
+    tc_free(pd->moving);
+    pd->moving = NULL;
+    tc_free(pd->fmoving);
+    pd->fmoving = NULL;
+    tc_free(pd->convertFrameIn);
+    pd->convertFrameIn = NULL;
+    tc_free(pd->convertFrameOut);
+    pd->convertFrameOut = NULL;
+
+    if (pd->tcvhandle) {
+        tcv_free(pd->tcvhandle);
+        pd->tcvhandle = NULL;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * smartbob_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int smartbob_configure(TCModuleInstance *self,
+                              const char *options,
+                              TCJob *vob,
+                              TCModuleExtraData *xdata[])
+{
+    SmartbobPrivateData *pd = NULL;
+    unsigned int width, height;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    width  = vob->im_v_width;
+    height = vob->im_v_height;
+
+    /* default values */
+    pd->bShiftEven  = 0;
+    pd->bMotionOnly = 0;
+    pd->bDenoise    = 1;
+    pd->threshold   = 12;
+    pd->codec       = vob->im_v_codec;
+
+    if (options != NULL) {
+        if (verbose)
+            tc_log_info(MOD_NAME, "options=%s", options);
+
+        optstr_get(options, "motionOnly", "%d", &pd->bMotionOnly);
+        optstr_get(options, "shiftEven",  "%d", &pd->bShiftEven);
+        optstr_get(options, "threshold",  "%d", &pd->threshold);
+        optstr_get(options, "denoise",    "%d", &pd->bDenoise);
+
+        if (optstr_lookup(options, "help") != NULL) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, smartbob_help);
+        }
+    }
+
+    if (verbose > 1) {
+        tc_log_info(MOD_NAME, " Smart Deinterlacer Filter Settings (%dx%d):",
+                    width, height);
+        tc_log_info(MOD_NAME, "        motionOnly = %d", pd->bMotionOnly);
+        tc_log_info(MOD_NAME, "           denoise = %d", pd->bDenoise);
+        tc_log_info(MOD_NAME, "         threshold = %d", pd->threshold);
+        tc_log_info(MOD_NAME, "         shiftEven = %d", pd->bShiftEven);
+    }
+
+    /* fetch memory */
+    pd->convertFrameIn  = tc_zalloc(width * height * sizeof(Pixel32));
+    pd->convertFrameOut = tc_zalloc(width * height * sizeof(Pixel32));
+    pd->prevFrame       = tc_zalloc(width * height * sizeof(int));
+    pd->moving          = tc_zalloc(width * height * sizeof(unsigned char));
+    pd->fmoving         = tc_zalloc(width * height * sizeof(unsigned char));
+    pd->tcvhandle       = tcv_init();
+
+    if (!pd->convertFrameIn || !pd->convertFrameOut || !pd->prevFrame
+     || !pd->moving || !pd->fmoving || !pd->tcvhandle) {
+        tc_log_error(MOD_NAME, "No memory!");
+        smartbob_stop(self);
+        return TC_ERROR;
+    }
+
+    if (verbose)
+        tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * smartbob_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
+
+static int smartbob_inspect(TCModuleInstance *self,
+                            const char *param, const char **value)
+{
+    SmartbobPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = smartbob_help;
+    }
+    if (optstr_lookup(param, "motionOnly")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->bMotionOnly);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "shiftEven")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->bShiftEven);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "threshold")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->threshold);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "denoise")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->bDenoise);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * smartbob_filter_video:  deinterlace the given field-frame.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int smartbob_filter_video(TCModuleInstance *self,
+                                 vframe_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    smartbob_field(self->userdata, frame);
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID smartbob_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID smartbob_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(smartbob);
+TC_MODULE_FILTER_FORMATS(smartbob);
+
+TC_MODULE_INFO(smartbob);
+
+static const TCModuleClass smartbob_class = {
+    TC_MODULE_CLASS_HEAD(smartbob),
+
+    .init         = smartbob_init,
+    .fini         = smartbob_fini,
+    .configure    = smartbob_configure,
+    .stop         = smartbob_stop,
+    .inspect      = smartbob_inspect,
+
+    .filter_video = smartbob_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(smartbob)
+
+/*************************************************************************/
+
+static int smartbob_get_config(TCModuleInstance *self, char *options)
+{
+    SmartbobPrivateData *pd = NULL;
+    char buf[255];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRYO", "1");
+
+    tc_snprintf(buf, sizeof(buf), "%d", pd->bMotionOnly);
+    optstr_param(options, "motionOnly", "Show motion areas only",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->bShiftEven);
+    optstr_param(options, "shiftEven",
+                 "Blend instead of interpolate in motion areas",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->threshold);
+    optstr_param(options, "threshold", "Motion Threshold",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->bDenoise);
+    optstr_param(options, "denoise", "Phase shift",
+                 "%d", buf, "0", "1");
+    return TC_OK;
+}
+
+static int smartbob_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    /* needs the fields doublefps made, in order */
+    if (frame->tag & TC_POST_S_PROCESS && frame->tag & TC_VIDEO) {
+        return smartbob_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(smartbob)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
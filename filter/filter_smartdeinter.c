@@ -33,19 +33,47 @@
 */
 
 #define MOD_NAME    "filter_smartdeinter.so"
-#define MOD_VERSION "v2.7b (2003-02-01)"
+#define MOD_VERSION "v2.8 (2026-10-18)"
 #define MOD_CAP     "VirtualDub's smart deinterlacer"
 #define MOD_AUTHOR  "Donald Graft, Tilmann Bitterberg"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include "libtcvideo/tcvideo.h"
 
 
-static vob_t *vob=NULL;
+static const char smartdeinter_help[] = ""
+    "Overview\n"
+    "    This filter provides a smart, motion-based deinterlacing\n"
+    "    capability. In static picture areas, interlacing artifacts do not\n"
+    "    appear, so data from both fields is used to provide full detail. In\n"
+    "    moving areas, deinterlacing is performed\n"
+    "\n"
+    "Options\n"
+    "       'threshold' Motion Threshold (0-255) [15]\n"
+    "  'scenethreshold' Scene Change Threshold (0-255) [100]:\n"
+    "        'diffmode' Motion Detection (0=frame, 1=field, 2=both) [0] \n"
+    "       'colordiff' Compare color channels instead of luma"
+                                                " (0=off, 1=on) [1]\n"
+    "      'motionOnly' Show motion areas only (0=off, 1=on) [0]\n"
+    "           'Blend' Blend instead of interpolate in motion areas"
+                                                " (0=off, 1=on) [0]\n"
+    "           'cubic' Use cubic for interpolation (0=off, 1=on) [0]\n"
+    "      'fieldShift' Phase shift (0=off, 1=on) [0]\n"
+    "          'inswap' Field swap before phase shift (0=off, 1=on) [0]\n"
+    "         'outswap' Field swap after phase shift (0=off, 1=on) [0]\n"
+    "           'highq' Motion map denoising for field-only"
+                                                " (0=off, 1=on) [0]\n"
+    "        'noMotion' Disable motion processing (0=off, 1=on) [0]\n";
 
 /* vdub compat */
 typedef unsigned int	Pixel;
@@ -62,259 +90,40 @@ typedef	int		PixOffset;
 #define FIELD_ONLY 1
 #define FRAME_AND_FIELD 2
 
-typedef struct MyFilterData {
-	int			*prevFrame;
-	int			*saveFrame;
-	Pixel32			*convertFrameIn;
-	Pixel32			*convertFrameOut;
-	unsigned char		*moving;
-	unsigned char		*fmoving;
-	int			srcPitch;
-	int			dstPitch;
-	int			motionOnly;
-	int 			Blend;
-	int 			threshold;
-	int			scenethreshold;
-	int			fieldShift;
-	int			inswap;
-	int			outswap;
-	int			highq;
-	int			diffmode;
-	int			colordiff;
-	int			noMotion;
-	int			cubic;
-	int			codec;
-	TCVHandle		tcvhandle;
-} MyFilterData;
-
-static MyFilterData *mfd;
-
-static void help_optstr(void)
+/* prevFrame and saveFrame carry state across frames: keep them in order. */
+
+typedef struct SmartdeinterPrivateData_ {
+    int *prevFrame;
+    int *saveFrame;
+    Pixel32 *convertFrameIn;
+    Pixel32 *convertFrameOut;
+    unsigned char *moving;
+    unsigned char *fmoving;
+    int srcPitch;
+    int dstPitch;
+    int motionOnly;
+    int Blend;
+    int threshold;
+    int scenethreshold;
+    int fieldShift;
+    int inswap;
+    int outswap;
+    int highq;
+    int diffmode;
+    int colordiff;
+    int noMotion;
+    int cubic;
+    int codec;
+    TCVHandle tcvhandle;
+
+    char opt_buf[TC_BUF_MIN];
+} SmartdeinterPrivateData;
+
+/* Deinterlace one frame, keeping it as history for the next one. */
+
+static void smartdeinter_frame(SmartdeinterPrivateData *mfd,
+                               vframe_list_t *ptr)
 {
-   tc_log_info (MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"    This filter provides a smart, motion-based deinterlacing\n"
-"    capability. In static picture areas, interlacing artifacts do not\n"
-"    appear, so data from both fields is used to provide full detail. In\n"
-"    moving areas, deinterlacing is performed\n"
-"\n"
-"* Options\n"
-"       'threshold' Motion Threshold (0-255) [15]\n"
-"  'scenethreshold' Scene Change Threshold (0-255) [100]:\n"
-"        'diffmode' Motion Detection (0=frame, 1=field, 2=both) [0] \n"
-"       'colordiff' Compare color channels instead of luma (0=off, 1=on) [1]\n"
-"      'motionOnly' Show motion areas only (0=off, 1=on) [0]\n"
-"           'Blend' Blend instead of interpolate in motion areas (0=off, 1=on) [0]\n"
-"           'cubic' Use cubic for interpolation (0=off, 1=on) [0]\n"
-"      'fieldShift' Phase shift (0=off, 1=on) [0]\n"
-"          'inswap' Field swap before phase shift (0=off, 1=on) [0]\n"
-"         'outswap' Field swap after phase shift (0=off, 1=on) [0]\n"
-"           'highq' Motion map denoising for field-only (0=off, 1=on) [0]\n"
-"        'noMotion' Disable motion processing (0=off, 1=on) [0]\n"
-		, MOD_CAP);
-}
-
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
-
-
-  if(ptr->tag & TC_FILTER_INIT) {
-
-	unsigned int width, height;
-
-	if((vob = tc_get_vob())==NULL) return(-1);
-
-
-	mfd = tc_zalloc(sizeof(MyFilterData));
-
-	if (!mfd) {
-		tc_log_error(MOD_NAME, "No memory!");
-		return (-1);
-	}
-
-	width  = vob->im_v_width;
-	height = vob->im_v_height;
-
-	/* default values */
-	mfd->threshold      = 15;
-	mfd->scenethreshold = 100;
-	mfd->highq          = 0;
-	mfd->diffmode       = FRAME_ONLY;
-	mfd->colordiff      = 1;
-	mfd->noMotion       = 0;
-	mfd->cubic          = 0;
-	mfd->codec          = vob->im_v_codec;
-
-	if (options != NULL) {
-
-	  if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
-
-	  optstr_get (options, "motionOnly",     "%d",  &mfd->motionOnly       );
-	  optstr_get (options, "Blend",          "%d",  &mfd->Blend            );
-	  optstr_get (options, "threshold",      "%d",  &mfd->threshold        );
-	  optstr_get (options, "scenethreshold", "%d",  &mfd->scenethreshold   );
-	  optstr_get (options, "fieldShift",     "%d",  &mfd->fieldShift       );
-	  optstr_get (options, "inswap",         "%d",  &mfd->inswap           );
-	  optstr_get (options, "outswap",        "%d",  &mfd->outswap          );
-	  optstr_get (options, "noMotion",       "%d",  &mfd->noMotion         );
-	  optstr_get (options, "highq",          "%d",  &mfd->highq            );
-	  optstr_get (options, "diffmode",       "%d",  &mfd->diffmode         );
-	  optstr_get (options, "colordiff",      "%d",  &mfd->colordiff        );
-	  optstr_get (options, "cubic",          "%d",  &mfd->cubic            );
-
-	  if (optstr_lookup (options, "help") != NULL) {
-		  help_optstr();
-	  }
-	}
-
-	if (verbose > 1) {
-
-	  tc_log_info (MOD_NAME, " Smart Deinterlacer Filter Settings (%dx%d):", width, height);
-	  tc_log_info (MOD_NAME, "        motionOnly = %d", mfd->motionOnly);
-	  tc_log_info (MOD_NAME, "             Blend = %d", mfd->Blend);
-	  tc_log_info (MOD_NAME, "         threshold = %d", mfd->threshold);
-	  tc_log_info (MOD_NAME, "    scenethreshold = %d", mfd->scenethreshold);
-	  tc_log_info (MOD_NAME, "        fieldShift = %d", mfd->fieldShift);
-	  tc_log_info (MOD_NAME, "            inswap = %d", mfd->inswap);
-	  tc_log_info (MOD_NAME, "           outswap = %d", mfd->outswap);
-	  tc_log_info (MOD_NAME, "          noMotion = %d", mfd->noMotion);
-	  tc_log_info (MOD_NAME, "             highq = %d", mfd->highq);
-	  tc_log_info (MOD_NAME, "          diffmode = %d", mfd->diffmode);
-	  tc_log_info (MOD_NAME, "         colordiff = %d", mfd->colordiff);
-	  tc_log_info (MOD_NAME, "             cubic = %d", mfd->cubic);
-	}
-
-	/* fetch memory */
-
-	mfd->convertFrameIn = tc_zalloc (width * height * sizeof(Pixel32));
-	mfd->convertFrameOut = tc_zalloc (width * height * sizeof(Pixel32));
-
-	if (mfd->diffmode == FRAME_ONLY || mfd->diffmode == FRAME_AND_FIELD)
-	{
-		mfd->prevFrame = tc_zalloc (width*height*sizeof(int));
-	}
-
-	if (mfd->fieldShift ||
-		(mfd->inswap && !mfd->outswap) || (!mfd->inswap && mfd->outswap))
-	{
-		mfd->saveFrame = tc_malloc (width*height*sizeof(int));
-	}
-
-	if (!mfd->noMotion)
-	{
-		mfd->moving = tc_zalloc (sizeof(unsigned char)*width*height);
-	}
-
-	if (mfd->highq)
-	{
-		mfd->fmoving = tc_malloc (sizeof(unsigned char)*width*height);
-	}
-
-	mfd->tcvhandle = tcv_init();
-
-	// filter init ok.
-	if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-
-	return 0;
-
-  } /* TC_FILTER_INIT */
-
-
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-      char buf[255];
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VRYE", "1");
-
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->motionOnly);
-      optstr_param (options, "motionOnly", "Show motion areas only" ,"%d", buf, "0", "1");
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->Blend);
-      optstr_param (options, "Blend", "Blend instead of interpolate in motion areas", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->threshold);
-      optstr_param (options, "threshold", "Motion Threshold", "%d", buf, "0", "255" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->scenethreshold);
-      optstr_param (options, "scenethreshold", "Scene Change Threshold", "%d", buf, "0", "255" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->fieldShift);
-      optstr_param (options, "fieldShift", "Phase shift", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->inswap);
-      optstr_param (options, "inswap", "Field swap before phase shift", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->outswap);
-      optstr_param (options, "outswap", "Field swap after phase shift", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->noMotion);
-      optstr_param (options, "noMotion", "Disable motion processing", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->highq);
-      optstr_param (options, "highq", "Motion map denoising for field-only", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->diffmode);
-      optstr_param (options, "diffmode", "Motion Detection (0=frame, 1=field, 2=both)", "%d", buf, "0", "2" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->colordiff);
-      optstr_param (options, "colordiff", "Compare color channels instead of luma", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->cubic);
-      optstr_param (options, "cubic", "Use cubic for interpolation", "%d", buf, "0", "1" );
-
-      return (0);
-  }
-
-  if(ptr->tag & TC_FILTER_CLOSE) {
-
-	if (!mfd)
-		return 0;
-
-	if (mfd->diffmode == FRAME_ONLY || mfd->diffmode == FRAME_AND_FIELD)
-	{
-		if (mfd->prevFrame)
-			free(mfd->prevFrame);
-		mfd->prevFrame = NULL;
-	}
-
-	if (mfd->fieldShift ||
-		(mfd->inswap && !mfd->outswap) || (!mfd->inswap && mfd->outswap))
-	{
-		if (mfd->saveFrame)
-			free(mfd->saveFrame);
-		mfd->saveFrame = NULL;
-	}
-
-	if (!mfd->noMotion)
-	{
-		if (mfd->moving)
-			free(mfd->moving);
-		mfd->moving = NULL;
-	}
-
-	if (mfd->highq)
-	{
-		if (mfd->fmoving)
-			free(mfd->fmoving);
-		mfd->fmoving = NULL;
-	}
-
-	if (mfd->convertFrameIn) {
-		free (mfd->convertFrameIn);
-		mfd->convertFrameIn = NULL;
-	}
-
-	if (mfd->convertFrameOut) {
-		free (mfd->convertFrameOut);
-		mfd->convertFrameOut = NULL;
-	}
-
-	tcv_free(mfd->tcvhandle);
-
-	if (mfd)
-		free(mfd);
-
-	return 0;
-
-  } /* TC_FILTER_CLOSE */
-
-///////////////////////////////////////////////////////////////////////////
-
-      if(ptr->tag & TC_PRE_M_PROCESS && ptr->tag & TC_VIDEO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
 
 	const int		srcpitch = ptr->v_width*sizeof(Pixel32);
 	const int		srcpitchtimes2 = 2 * srcpitch;
@@ -1070,9 +879,344 @@ filter_done:
 		    ptr->video_buf, ptr->v_width, ptr->v_height,
 		    ac_endian()==AC_LITTLE_ENDIAN ? IMG_BGRA32 : IMG_ARGB32,
 		    mfd->codec==TC_CODEC_YUV420P ? IMG_YUV_DEFAULT : IMG_RGB24);
+}
+
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * smartdeinter_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(smartdeinter, SmartdeinterPrivateData)
+
+/*************************************************************************/
+
+/**
+ * smartdeinter_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_FINI(smartdeinter)
+
+/*************************************************************************/
 
-	return 0;
-  }
-  return 0;
+/**
+ * smartdeinter_stop:  Reset this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int smartdeinter_stop(TCModuleInstance *self)
+{
+    SmartdeinterPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+
+    tc_free(pd->prevFrame);
+    pd->prevFrame = NULL;
+    tc_free(pd->saveFrame);
+    pd->saveFrame = NULL;
+    tc_free(pd->moving);
+    pd->moving = NULL;
+    tc_free(pd->fmoving);
+    pd->fmoving = NULL;
+    tc_free(pd->convertFrameIn);
+    pd->convertFrameIn = NULL;
+    tc_free(pd->convertFrameOut);
+    pd->convertFrameOut = NULL;
+
+    if (pd->tcvhandle) {
+        tcv_free(pd->tcvhandle);
+        pd->tcvhandle = NULL;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * smartdeinter_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int smartdeinter_configure(TCModuleInstance *self,
+                                  const char *options,
+                                  TCJob *vob,
+                                  TCModuleExtraData *xdata[])
+{
+    SmartdeinterPrivateData *pd = NULL;
+    unsigned int width, height;
+    int nomem = 0;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    width  = vob->im_v_width;
+    height = vob->im_v_height;
+
+    /* default values */
+    pd->motionOnly     = 0;
+    pd->Blend          = 0;
+    pd->threshold      = 15;
+    pd->scenethreshold = 100;
+    pd->fieldShift     = 0;
+    pd->inswap         = 0;
+    pd->outswap        = 0;
+    pd->highq          = 0;
+    pd->diffmode       = FRAME_ONLY;
+    pd->colordiff      = 1;
+    pd->noMotion       = 0;
+    pd->cubic          = 0;
+    pd->codec          = vob->im_v_codec;
+
+    if (options != NULL) {
+        if (verbose)
+            tc_log_info(MOD_NAME, "options=%s", options);
+
+        optstr_get(options, "motionOnly",     "%d", &pd->motionOnly);
+        optstr_get(options, "Blend",          "%d", &pd->Blend);
+        optstr_get(options, "threshold",      "%d", &pd->threshold);
+        optstr_get(options, "scenethreshold", "%d", &pd->scenethreshold);
+        optstr_get(options, "fieldShift",     "%d", &pd->fieldShift);
+        optstr_get(options, "inswap",         "%d", &pd->inswap);
+        optstr_get(options, "outswap",        "%d", &pd->outswap);
+        optstr_get(options, "noMotion",       "%d", &pd->noMotion);
+        optstr_get(options, "highq",          "%d", &pd->highq);
+        optstr_get(options, "diffmode",       "%d", &pd->diffmode);
+        optstr_get(options, "colordiff",      "%d", &pd->colordiff);
+        optstr_get(options, "cubic",          "%d", &pd->cubic);
+
+        if (optstr_lookup(options, "help") != NULL) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s",
+                        MOD_CAP, smartdeinter_help);
+        }
+    }
+
+    if (verbose > 1) {
+        tc_log_info(MOD_NAME, " Smart Deinterlacer Filter Settings (%dx%d):",
+                    width, height);
+        tc_log_info(MOD_NAME, "        motionOnly = %d", pd->motionOnly);
+        tc_log_info(MOD_NAME, "             Blend = %d", pd->Blend);
+        tc_log_info(MOD_NAME, "         threshold = %d", pd->threshold);
+        tc_log_info(MOD_NAME, "    scenethreshold = %d", pd->scenethreshold);
+        tc_log_info(MOD_NAME, "        fieldShift = %d", pd->fieldShift);
+        tc_log_info(MOD_NAME, "            inswap = %d", pd->inswap);
+        tc_log_info(MOD_NAME, "           outswap = %d", pd->outswap);
+        tc_log_info(MOD_NAME, "          noMotion = %d", pd->noMotion);
+        tc_log_info(MOD_NAME, "             highq = %d", pd->highq);
+        tc_log_info(MOD_NAME, "          diffmode = %d", pd->diffmode);
+        tc_log_info(MOD_NAME, "         colordiff = %d", pd->colordiff);
+        tc_log_info(MOD_NAME, "             cubic = %d", pd->cubic);
+    }
+
+    /* fetch memory; the optional buffers depend on the options above */
+    pd->convertFrameIn  = tc_zalloc(width * height * sizeof(Pixel32));
+    pd->convertFrameOut = tc_zalloc(width * height * sizeof(Pixel32));
+    nomem = (!pd->convertFrameIn || !pd->convertFrameOut);
+
+    if (pd->diffmode == FRAME_ONLY || pd->diffmode == FRAME_AND_FIELD) {
+        pd->prevFrame = tc_zalloc(width * height * sizeof(int));
+        nomem |= !pd->prevFrame;
+    }
+    if (pd->fieldShift || pd->inswap != pd->outswap) {
+        pd->saveFrame = tc_zalloc(width * height * sizeof(int));
+        nomem |= !pd->saveFrame;
+    }
+    if (!pd->noMotion) {
+        pd->moving = tc_zalloc(width * height * sizeof(unsigned char));
+        nomem |= !pd->moving;
+    }
+    if (pd->highq) {
+        pd->fmoving = tc_zalloc(width * height * sizeof(unsigned char));
+        nomem |= !pd->fmoving;
+    }
+    pd->tcvhandle = tcv_init();
+
+    if (nomem || !pd->tcvhandle) {
+        tc_log_error(MOD_NAME, "No memory!");
+        smartdeinter_stop(self);
+        return TC_ERROR;
+    }
+
+    if (verbose)
+        tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+    return TC_OK;
 }
 
+/*************************************************************************/
+
+/**
+ * smartdeinter_inspect:  Return the value of an option in this instance
+ * of the module.  See tcmodule-data.h for function details.
+ */
+
+static int smartdeinter_inspect(TCModuleInstance *self,
+                                const char *param, const char **value)
+{
+    SmartdeinterPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = smartdeinter_help;
+    }
+    if (optstr_lookup(param, "threshold")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->threshold);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "scenethreshold")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->scenethreshold);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "diffmode")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->diffmode);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * smartdeinter_filter_video:  deinterlace the given frame.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int smartdeinter_filter_video(TCModuleInstance *self,
+                                     vframe_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+
+    smartdeinter_frame(self->userdata, frame);
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID smartdeinter_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID smartdeinter_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(smartdeinter);
+TC_MODULE_FILTER_FORMATS(smartdeinter);
+
+TC_MODULE_INFO(smartdeinter);
+
+static const TCModuleClass smartdeinter_class = {
+    TC_MODULE_CLASS_HEAD(smartdeinter),
+
+    .init         = smartdeinter_init,
+    .fini         = smartdeinter_fini,
+    .configure    = smartdeinter_configure,
+    .stop         = smartdeinter_stop,
+    .inspect      = smartdeinter_inspect,
+
+    .filter_video = smartdeinter_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(smartdeinter)
+
+/*************************************************************************/
+
+static int smartdeinter_get_config(TCModuleInstance *self, char *options)
+{
+    SmartdeinterPrivateData *pd = NULL;
+    char buf[255];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRYE", "1");
+
+    tc_snprintf(buf, sizeof(buf), "%d", pd->motionOnly);
+    optstr_param(options, "motionOnly", "Show motion areas only",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->Blend);
+    optstr_param(options, "Blend",
+                 "Blend instead of interpolate in motion areas",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->threshold);
+    optstr_param(options, "threshold", "Motion Threshold",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->scenethreshold);
+    optstr_param(options, "scenethreshold", "Scene Change Threshold",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->fieldShift);
+    optstr_param(options, "fieldShift", "Phase shift",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->inswap);
+    optstr_param(options, "inswap", "Field swap before phase shift",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->outswap);
+    optstr_param(options, "outswap", "Field swap after phase shift",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->noMotion);
+    optstr_param(options, "noMotion", "Disable motion processing",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->highq);
+    optstr_param(options, "highq", "Motion map denoising for field-only",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->diffmode);
+    optstr_param(options, "diffmode",
+                 "Motion Detection (0=frame, 1=field, 2=both)",
+                 "%d", buf, "0", "2");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->colordiff);
+    optstr_param(options, "colordiff",
+                 "Compare color channels instead of luma",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->cubic);
+    optstr_param(options, "cubic", "Use cubic for interpolation",
+                 "%d", buf, "0", "1");
+    return TC_OK;
+}
+
+static int smartdeinter_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    if (frame->tag & TC_PRE_M_PROCESS && frame->tag & TC_VIDEO) {
+        return smartdeinter_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(smartdeinter)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
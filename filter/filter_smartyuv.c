@@ -21,14 +21,22 @@
 */
 
 #define MOD_NAME    "filter_smartyuv.so"
-#define MOD_VERSION "0.1.6 (2007-05-31)"
+#define MOD_VERSION "0.1.7 (2026-10-18)"
 #define MOD_CAP     "Motion-adaptive deinterlacing"
 #define MOD_AUTHOR  "Tilmann Bitterberg"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_BUFFERING|\
+    TC_MODULE_FLAG_SLICE_PARALLEL
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
+#include "libtcmodule/tcmodule-slice.h"
 
 //#undef HAVE_ASM_MMX
 //#undef CAN_COMPILE_C_ALTIVEC
@@ -48,9 +56,6 @@
 
 #define rdtscll(val) __asm__ __volatile__("rdtsc" : "=A" (val))
 
-
-static vob_t *vob  = NULL;
-
 ///////////////////////////////////////////////////////////////////////////
 
 // this value is "hardcoded" in the optimized code for speed reasons
@@ -98,14 +103,11 @@ count: 1-256
 stride: -32000 - 320000
 */
 
-static void smartyuv_core (char *_src, char *_dst, char *_prev, int _width, int _height,
-                           int _srcpitch, int _dstpitch,
-                           unsigned char *_moving, unsigned char *_fmoving,
-                           yuv_clamp_fn clamp_f, int _threshold );
+/* prevFrame keeps the previous frame: the frames must come in order. */
 
-typedef struct MyFilterData {
-    char            *buf;
-    char            *prevFrame;
+typedef struct SmartyuvPrivateData_ {
+    uint8_t         *buf;
+    uint8_t         *prevFrame;
     unsigned char   *movingY;
     unsigned char   *movingU;
     unsigned char   *movingV;
@@ -123,46 +125,50 @@ typedef struct MyFilterData {
     int             Blend;
     int             doChroma;
     int             verbose;
-} MyFilterData;
+    int             counter;
 
-static MyFilterData *mfd = NULL;
+    char            opt_buf[TC_BUF_MIN];
+} SmartyuvPrivateData;
+
+static void smartyuv_core (SmartyuvPrivateData *mfd,
+                           uint8_t *_src, uint8_t *_dst, uint8_t *_prev, int _width, int _height,
+                           int _srcpitch, int _dstpitch,
+                           unsigned char *_moving, unsigned char *_fmoving,
+                           yuv_clamp_fn clamp_f, int _threshold );
 
-static void help_optstr(void)
-{
-   tc_log_info (MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"   This filter is basically a rewrite of the\n"
-"   smartdeinter filter by Donald Graft (without advanced processing\n"
-"   options) for YUV mode only. Its faster than using the smartdeinter\n"
-"   in YUV mode and is also tuned with its threshold settings for YUV\n"
-"   mode. The filter detects motion and static areas in an image and\n"
-"   only deinterlaces (either by blending or by cubic interpolation)\n"
-"   the moving areas. The result is an image with high detail in\n"
-"   static areas, no information is lost there.\n"
-"\n"
-"   The threshold settings should be sufficent for most users. As a\n"
-"   rule of thumb, I recommend setting the chroma threshold to about\n"
-"   the half of the luma threshold. If you want more deinterlacing,\n"
-"   lower the thresholds. The scene threshold can be easily found by\n"
-"   turning on verbose mode and the preview filter. In verbose mode,\n"
-"   the filter will print out, when it detects a scene change. If\n"
-"   scenechanges go by unnoticed, lower the scene threshold. You can\n"
-"   completly disable chroma processing with the doChroma=0 option.\n"
-"   Here is a sample commandline\n"
-"   -J smartyuv=highq=1:diffmode=2:cubic=1:Blend=1:chromathres=4:threshold=8:doChroma=1\n"
-"* Options\n"
-"  'motionOnly' Show motion areas only (0=off, 1=on) [0]\n"
-"    'diffmode' Motion Detection (0=frame, 1=field, 2=both) [0]\n"
-"   'threshold' Motion Threshold (luma) (0-255) [14]\n"
-" 'chromathres' Motion Threshold (chroma) (0-255) [7]\n"
-"  'scenethres' Threshold for detecting scenechanges (0-255) [31]\n"
-"       'cubic' Do cubic interpolation (0=off 1=on) [1]\n"
-"       'highq' High-Quality processing (motion Map denoising) (0=off 1=on) [1]\n"
-"       'Blend' Blend the frames for deinterlacing (0=off 1=on) [1]\n"
-"    'doChroma' Enable chroma processing (slower but more accurate) (0=off 1=on) [1]\n"
-"     'verbose' Verbose mode (0=off 1=on) [1]\n"
-		, MOD_CAP);
-}
+
+static const char smartyuv_help[] = ""
+    "Overview\n"
+    "   This filter is basically a rewrite of the\n"
+    "   smartdeinter filter by Donald Graft (without advanced processing\n"
+    "   options) for YUV mode only. Its faster than using the smartdeinter\n"
+    "   in YUV mode and is also tuned with its threshold settings for YUV\n"
+    "   mode. The filter detects motion and static areas in an image and\n"
+    "   only deinterlaces (either by blending or by cubic interpolation)\n"
+    "   the moving areas. The result is an image with high detail in\n"
+    "   static areas, no information is lost there.\n"
+    "\n"
+    "   The threshold settings should be sufficent for most users. As a\n"
+    "   rule of thumb, I recommend setting the chroma threshold to about\n"
+    "   the half of the luma threshold. If you want more deinterlacing,\n"
+    "   lower the thresholds. The scene threshold can be easily found by\n"
+    "   turning on verbose mode and the preview filter. In verbose mode,\n"
+    "   the filter will print out, when it detects a scene change. If\n"
+    "   scenechanges go by unnoticed, lower the scene threshold. You can\n"
+    "   completly disable chroma processing with the doChroma=0 option.\n"
+    "   Here is a sample commandline\n"
+    "   -J smartyuv=highq=1:diffmode=2:cubic=1:Blend=1:chromathres=4:threshold=8:doChroma=1\n"
+    "Options\n"
+    "  'motionOnly' Show motion areas only (0=off, 1=on) [0]\n"
+    "    'diffmode' Motion Detection (0=frame, 1=field, 2=both) [0]\n"
+    "   'threshold' Motion Threshold (luma) (0-255) [14]\n"
+    " 'chromathres' Motion Threshold (chroma) (0-255) [7]\n"
+    "  'scenethres' Threshold for detecting scenechanges (0-255) [31]\n"
+    "       'cubic' Do cubic interpolation (0=off 1=on) [1]\n"
+    "       'highq' High-Quality processing (motion Map denoising) (0=off 1=on) [1]\n"
+    "       'Blend' Blend the frames for deinterlacing (0=off 1=on) [1]\n"
+    "    'doChroma' Enable chroma processing (slower but more accurate) (0=off 1=on) [1]\n"
+    "     'verbose' Verbose mode (0=off 1=on) [1]\n";
 
 static void Erode_Dilate (uint8_t *_moving, uint8_t *_fmoving, int width, int height)
 {
@@ -328,34 +334,34 @@ static void inline Blendline_c (uint8_t *dst, uint8_t *src, uint8_t *srcminus, u
 // this works fine on OSX too
 #define ABS_u8(a) (((a)^((a)>>7))-((a)>>7))
 
-static void smartyuv_core (char *_src, char *_dst, char *_prev, int _width, int _height,
-                           int _srcpitch, int _dstpitch,
-                           unsigned char *_moving, unsigned char *_fmoving,
-                           yuv_clamp_fn clamp_f, int _threshold )
+typedef struct SmartyuvRender {
+	const SmartyuvPrivateData *mfd;
+	uint8_t			*src_buf, *dst_buf;
+	unsigned char		*moving;
+	int			w, h, srcpitch, dstpitch;
+	int			scenechange;
+	yuv_clamp_fn		clamp_f;
+} SmartyuvRender;
+
+// Render rows [first+1, last+1); every row only depends on the source
+// and on the motion map, so the bands can be rendered concurrently.
+static void smartyuv_render (void *data, int first, int last, int slot)
 {
-	const int		srcpitch = _srcpitch;
-	const int		dstpitch = _dstpitch;
-
-	const int		w = _width;
-	const int		wminus1 = w - 1;
-
-	const int		h = _height;
-	const int		hminus1 = h - 1;
-	const int		hminus3 = h - 3;
-
-	char			*src, *dst, *srcminus=NULL, *srcplus, *srcminusminus=NULL, *srcplusplus=NULL;
+	SmartyuvRender		*S = data;
+	const SmartyuvPrivateData *mfd = S->mfd;
+	const int		srcpitch = S->srcpitch;
+	const int		dstpitch = S->dstpitch;
+	const int		w = S->w;
+	const int		hminus3 = S->h - 3;
+	const int		scenechange = S->scenechange;
+	const yuv_clamp_fn	clamp_f = S->clamp_f;
+	const int		cubic = mfd->cubic;
+
+	uint8_t			*src, *dst, *srcminus, *srcplus, *srcminusminus=NULL, *srcplusplus=NULL;
 	unsigned char		*moving, *movingminus, *movingplus;
-	unsigned char		*fmoving;
-	char    		*prev;
-	int			scenechange=0;
-	long			count=0;
 	int			x, y;
-	int			luma, luman, lumap, T;
 	int 			p1, p2;
 	int 			rp, rn, rpp, rnn, R;
-	unsigned char		fiMotion;
-	int			cubic = mfd->cubic;
-	static int 		counter=0;
 #ifdef HAVE_ASM_MMX
 	const int		can_use_mmx = !(w%8); // width must a multiple of 8
 #endif
@@ -363,132 +369,428 @@ static void smartyuv_core (char *_src, char *_dst, char *_prev, int _width, int
 	const int		can_use_altivec = !(w%16); // width must a multiple of 16
 #endif
 
+	first++;
+	last++;
 
-	char * dst_buf;
-	char * src_buf;
-
-	//memset(ptr->video_buf+h*w, BLACK_BYTE_UV, h*w/2);
-	src_buf = _src;
-	dst_buf = _dst;
-
-	/* Not much deinterlacing to do if there aren't at least 2 lines. */
-	if (h < 2) return;
-
-	/* Skip first and last lines, they'll get a free ride. */
-	src = src_buf + srcpitch;
+	src = S->src_buf + first * srcpitch;
 	srcminus = src - srcpitch;
 	srcplus = src + srcpitch;
-	moving = _moving + w+PAD;
-	prev = _prev + w;
 
-	if (mfd->diffmode == FRAME_ONLY || mfd->diffmode == FRAME_AND_FIELD)
+	if (cubic)
 	{
-		if (mfd->diffmode == FRAME_ONLY) {
+		srcminusminus = src - 3 * srcpitch;
+		srcplusplus = src + 3 * srcpitch;
+	}
 
-#ifdef HAVE_ASM_MMX
-		  if (can_use_mmx) {
+	dst = S->dst_buf + first * dstpitch;
+	moving = S->moving + first * (w+PAD);
+	movingminus = moving - (w+PAD);
+	movingplus = moving + (w+PAD);
 
-		    uint64_t mask1 = 0x00FF00FF00FF00FFULL;
 
-		    uint64_t thres = (_threshold<<16) | (_threshold);
-		    thres = (thres << 32) | (thres);
+	if (mfd->motionOnly)
+	{
+	    for (y = first; y < last; y++)
+	    {
+		if (mfd->Blend)
+		{
+		    x = 0;
+		    do {
+			if (!(movingminus[x] | moving[x] | movingplus[x]) && !scenechange)
+			    dst[x] = (clamp_f==clamp_Y)?BLACK_BYTE_Y:BLACK_BYTE_UV;
+			else
+			{
+			    /* Blend fields. */
+			    dst[x] = (((src[x]&0xff)>>1) + ((srcminus[x]&0xff)>>2) + ((srcplus[x]&0xff)>>2))&0xff;
+			}
+		    } while(++x < w);
+		}
+		else
+		{
+		    x = 0;
+		    do {
+			if (!(movingminus[x] | moving[x] | movingplus[x]) && !scenechange)
+			    dst[x] = (clamp_f==clamp_Y)?BLACK_BYTE_Y:BLACK_BYTE_UV;
+			else if (y & 1)
+			{
+			    if (cubic && (y > 2) && (y < hminus3))
+			    {
+				rpp = (srcminusminus[x]) & 0xff;
+				rp =  (srcminus[x]) & 0xff;
+				rn =  (srcplus[x]) & 0xff;
+				rnn = (srcplusplus[x]) & 0xff;
+				R = (5 * (rp + rn) - (rpp + rnn)) >> 3;
+				dst[x] = clamp_f(R);
+			    }
+			    else
+			    {
+				p1 = srcminus[x] &0xff;
+				p1 &= 0xfe;
 
-		    movq_m2r (mask1, mm6);
-		    movq_m2r (thres, mm5);        // thres -> mm6
+				p2 = srcplus[x] &0xff;
+				p2 &= 0xfe;
+				dst[x] = ((p1>>1) + (p2>>1)) &0xff;
+			    }
+			}
+			else
+			    dst[x] = src[x];
+		    } while(++x < w);
+		}
+		src = src + srcpitch;
+		srcminus = srcminus + srcpitch;
+		srcplus = srcplus + srcpitch;
 
-		    count = 0;
-		    for (y = 1; y < hminus1; y++)
-		    {
-			for (x=0; x<w; x+=4) {
+		if (cubic)
+		{
+		    srcminusminus = srcminusminus + srcpitch;
+		    srcplusplus = srcplusplus + srcpitch;
+		}
 
-			    movd_m2r (*src, mm0);         // a b c d 0 0 0 0
+		dst = dst + dstpitch;
+		moving += (w+PAD);
+		movingminus += (w+PAD);
+		movingplus += (w+PAD);
+	    }
+	    return;
 
-			    punpcklbw_r2r (mm0, mm0);     // a a b b c c d d
-			    pand_r2r (mm6, mm0);          // 0 a 0 b 0 c 0 d
+	}
 
-			    movd_m2r(*prev, mm1);         // e f g h 0 0 0 0
+	if (mfd->Blend)
+	{
+	    // linear blend, see Blendline_c for a plainC version
+	    for (y = first; y < last; y++)
+	    {
+#ifdef HAVE_ASM_MMX
+	      if (can_use_mmx) {
 
-			    punpcklbw_r2r (mm1, mm1);     // e e f f g g h h
-			    pand_r2r (mm6, mm1);          // 0 e 0 f 0 g 0 h
+		uint64_t scmask = (scenechange<<24) | (scenechange<<16) | (scenechange<<8) | scenechange;
+		scmask = (scmask << 32) | scmask;
 
-			    psubsw_r2r(mm1, mm0);         // mm0 = mm0 - mm1; !!
+		pcmpeqw_r2r(mm4, mm4);
+		psrlw_i2r(9,mm4);
+		packuswb_r2r(mm4, mm4);         // build 0x7f7f7f7f7f7f7f7f
 
-			    movq_r2r(mm0, mm3);
+		pcmpeqw_r2r(mm6, mm6);
+		psrlw_i2r(10,mm6);
+		packuswb_r2r(mm6, mm6);         // build 0x3f3f3f3f3f3f3f3f
 
-			    // abs()
-			    psraw_i2r(15, mm3);
-			    pxor_r2r(mm3, mm0);
-			    psubw_r2r(mm3, mm0);
+		for (x=0; x<w; x+=8) {
 
-			    // compare if greater than thres
-			    pcmpgtw_r2r(mm5, mm0);
+		    movq_m2r(scmask, mm0);          // has a scenechange happend?
 
-			    // norm
-			    psrlw_i2r(15, mm0);
-			    // pack to bytes
-			    packuswb_r2r(mm0, mm0);
+		    pxor_r2r(mm5, mm5);             // clear mm5
 
-			    // write to moving
-			    movd_r2m(mm0, *moving);
+		    por_m2r (moving     [x], mm0);
+		    movq_m2r(src        [x], mm1);   // load src
+		    por_m2r (movingminus[x], mm0);   // motion detected?
+		    movq_m2r(src        [x-w], mm2);   // load srcminus
+		    por_m2r (movingplus [x], mm0);
+		    movq_m2r(src        [x+w], mm3);   // load srcplus
 
-			    ac_memcpy(prev, src, 4);
+		    movq_r2r (mm1, mm7);
 
-			    src+=4;
-			    prev+=4;
+		    pcmpgtb_r2r(mm5, mm0);  // make FF out 1 and 0 out of 0
 
-			    count += *moving++;
-			    count += *moving++;
-			    count += *moving++;
-			    count += *moving++;
+		    pcmpeqw_r2r(mm5, mm5);  // make all ff's (recycle mm5)
+		    psubb_r2r  (mm0, mm5);  // inverse mask
+		    pand_r2r   (mm0, mm7);
+		    pand_r2r   (mm5, mm1);
+		    psrlw_i2r  (1,   mm7);
 
-			}
+		    pand_r2r   (mm4, mm7);  // clear highest bit
+		    por_r2r    (mm7, mm1);  // merge src>>1 and src together dependand on moving mask
 
-			moving += PAD;
-		    }
-		    emms();
+		    // mm0: mask, if 0 don't shift, if ff shift
+		    // mm1: complete src
+		    // mm2: srcminus
+		    // mm3: srcplus
+		    // mm4: 0x7f mask
+		    // mm5: free
+		    // mm6: 0x3f mask
+		    // mm7: free
 
-		  }  else  // cannot use mmx
-#elif CAN_COMPILE_C_ALTIVEC
-		  if (can_use_altivec) {
-		      vector unsigned char vthres;
-		      vector unsigned char shift = vec_splat_u8(7);
-		      unsigned char __attribute__ ((aligned(16))) tdata[16];
-		      int i;
-		      memset(tdata, _threshold, 16);
-		      vthres = vec_ld(0, tdata);
+		    // handle srcm(inus) and srcp(lus)
 
-		      count = 0;
-		      for (y = 1; y < hminus1; y++)
-		      {
-			  for (x=0; x<w; x+=16) {
+		    pand_r2r (mm0, mm2);
+		    pand_r2r (mm0, mm3);
 
-			      vector unsigned char luma = vec_ld(0, (unsigned char *)src);
-			      vector unsigned char prv = vec_ld(0, (unsigned char *)prev);
-			      vector unsigned char vmov;
-			      vmov = vec_sub (vec_max (luma, prv), vec_min(luma, prv));
+		    psrlw_i2r(2,   mm2);  // srcm>>2
+		    psrlw_i2r(2,   mm3);  // srcp>>2
+		    pand_r2r (mm6, mm2);  // clear highest two bits
+		    pand_r2r (mm6, mm3);
 
-			      // FF -> 01
-			      vmov = (vector unsigned char)vec_cmpgt(vmov, vthres);
-			      vmov = vec_sr(vmov, shift);
+		    paddusb_r2r (mm2, mm1);   // src>>1 + srcn>>2 + srcp>>2
+		    paddusb_r2r (mm3, mm1);
 
-			      vec_st(vmov, 0, (unsigned char *)moving);
+		    movq_r2m(mm1, dst[x]);
 
-			      /* Keep a count of the number of moving pixels for the
-				 scene change detection. */
-			      for (i=0; i<16; i++) {
-				  count += *moving++;
-				  *prev++ = *src++;
-			      }
+		}
+	      } else // cannot use mmx
+#elif CAN_COMPILE_C_ALTIVEC
+	      if (can_use_altivec) {
+		  unsigned char tdata[16];
+		  memset (tdata, scenechange, 16);
+		  vector unsigned char vscene = vec_ld(0, tdata);
+		  vector unsigned char vmov, vsrc2, vdest;
+		  vector unsigned char vsrc, vsrcminus, vsrcplus;
+		  vector unsigned char zero = vec_splat_u8(0);
+		  vector unsigned char ones = vec_splat_u8(1);
+		  vector unsigned char twos = vec_splat_u8(2);
 
-			  }
 
-			  moving += PAD;
-		    }
+		  for (x=0; x<w; x+=16) {
+		      vmov = vec_xor(vmov, vmov);
+		      vmov = vec_or (vmov, vec_ld(x, moving));
+		      vsrc = vec_ld(x, (unsigned char *)src);
+		      vmov = vec_or (vmov, vec_ld(x, movingminus));
+		      vsrcminus = vec_ld(x-w, (unsigned char *)src);
+		      vmov = vec_or (vmov, vec_ld(x, movingplus));
+		      vsrcplus = vec_ld(x+w, (unsigned char *)src);
+		      vmov = vec_or(vmov, vscene);
 
-		  } else
-#endif
-		  {
-		    count = 0;
+		      vsrc2 = vec_sr(vsrc, ones);
+		      vsrc2 = vec_add(vsrc2, vec_sr(vsrcminus, twos));
+		      vsrc2 = vec_add(vsrc2, vec_sr(vsrcplus, twos));
+		      vmov = (vector unsigned char)vec_cmpgt (vmov, zero);
+		 vdest = vec_or (vec_sel(vsrc, zero, vmov), vec_sel (vsrc2, zero, vec_nor(vmov, vmov)));
+		      vec_st(vdest, x, (unsigned char *)dst);
+		  }
+
+
+
+
+
+	      } else
+#endif
+	      {
+		Blendline_c (dst, src, srcminus, srcplus, moving, movingminus, movingplus, w, scenechange);
+	      }
+
+		src +=  srcpitch;
+		srcminus += srcpitch;
+		srcplus += srcpitch;
+
+		dst += dstpitch;
+		moving += (w+PAD);
+		movingminus += (w+PAD);
+		movingplus += (w+PAD);
+	    }
+
+	    emms();
+	    return;
+	}
+
+	emms();
+
+	// Doing line interpolate. Thus, even lines are going through
+	// for moving and non-moving mode. Odd line pixels will be subject
+	// to the motion test.
+
+	for (y = first; y < last; y++)
+	{
+	    if (y&1)
+	    {
+		x = 0;
+		do {
+		    if (movingminus[x] | moving[x] | movingplus[x] | scenechange)
+			if (cubic & (y > 2) & (y < hminus3))
+			{
+			    R = (5 * ((srcminus[x] & 0xff) + (srcplus[x] & 0xff))
+				    - ((srcminusminus[x] & 0xff) + (srcplusplus[x] & 0xff))) >> 3;
+			    dst[x] = clamp_f(R);
+			}
+			else
+			{
+			    dst[x] = (((srcminus[x]&0xff) >> 1) + ((srcplus[x]&0xff) >> 1)) & 0xff;
+			}
+		    else
+		    {
+			dst[x] = src[x];
+		    }
+		} while(++x < w);
+	    }
+	    else
+	    {
+		// Even line; pass it through.
+		ac_memcpy(dst, src, w);
+	    }
+	    src +=  srcpitch;
+	    srcminus += srcpitch;
+	    srcplus += srcpitch;
+
+	    if (cubic)
+	    {
+		srcminusminus += srcpitch;
+		srcplusplus += srcpitch;
+	    }
+
+	    dst += dstpitch;
+	    moving += (w+PAD);
+	    movingminus += (w+PAD);
+	    movingplus += (w+PAD);
+	}
+
+	return;
+}
+
+static void smartyuv_core (SmartyuvPrivateData *mfd,
+                           uint8_t *_src, uint8_t *_dst, uint8_t *_prev, int _width, int _height,
+                           int _srcpitch, int _dstpitch,
+                           unsigned char *_moving, unsigned char *_fmoving,
+                           yuv_clamp_fn clamp_f, int _threshold )
+{
+	const int		srcpitch = _srcpitch;
+	const int		dstpitch = _dstpitch;
+
+	const int		w = _width;
+	const int		wminus1 = w - 1;
+
+	const int		h = _height;
+	const int		hminus1 = h - 1;
+
+	uint8_t			*src, *srcminus=NULL, *srcplus;
+	unsigned char		*moving;
+	unsigned char		*fmoving;
+	uint8_t    		*prev;
+	int			scenechange=0;
+	long			count=0;
+	int			x, y;
+	int			luma, luman, lumap, T;
+	unsigned char		fiMotion;
+	SmartyuvRender		render;
+#ifdef HAVE_ASM_MMX
+	const int		can_use_mmx = !(w%8); // width must a multiple of 8
+#endif
+#ifdef CAN_COMPILE_C_ALTIVEC
+	const int		can_use_altivec = !(w%16); // width must a multiple of 16
+#endif
+
+
+	uint8_t * dst_buf;
+	uint8_t * src_buf;
+
+	//memset(ptr->video_buf+h*w, BLACK_BYTE_UV, h*w/2);
+	src_buf = _src;
+	dst_buf = _dst;
+
+	/* Not much deinterlacing to do if there aren't at least 2 lines. */
+	if (h < 2) return;
+
+	/* Skip first and last lines, they'll get a free ride. */
+	src = src_buf + srcpitch;
+	srcminus = src - srcpitch;
+	srcplus = src + srcpitch;
+	moving = _moving + w+PAD;
+	prev = _prev + w;
+
+	if (mfd->diffmode == FRAME_ONLY || mfd->diffmode == FRAME_AND_FIELD)
+	{
+		if (mfd->diffmode == FRAME_ONLY) {
+
+#ifdef HAVE_ASM_MMX
+		  if (can_use_mmx) {
+
+		    uint64_t mask1 = 0x00FF00FF00FF00FFULL;
+
+		    uint64_t thres = (_threshold<<16) | (_threshold);
+		    thres = (thres << 32) | (thres);
+
+		    movq_m2r (mask1, mm6);
+		    movq_m2r (thres, mm5);        // thres -> mm6
+
+		    count = 0;
+		    for (y = 1; y < hminus1; y++)
+		    {
+			for (x=0; x<w; x+=4) {
+
+			    movd_m2r (*src, mm0);         // a b c d 0 0 0 0
+
+			    punpcklbw_r2r (mm0, mm0);     // a a b b c c d d
+			    pand_r2r (mm6, mm0);          // 0 a 0 b 0 c 0 d
+
+			    movd_m2r(*prev, mm1);         // e f g h 0 0 0 0
+
+			    punpcklbw_r2r (mm1, mm1);     // e e f f g g h h
+			    pand_r2r (mm6, mm1);          // 0 e 0 f 0 g 0 h
+
+			    psubsw_r2r(mm1, mm0);         // mm0 = mm0 - mm1; !!
+
+			    movq_r2r(mm0, mm3);
+
+			    // abs()
+			    psraw_i2r(15, mm3);
+			    pxor_r2r(mm3, mm0);
+			    psubw_r2r(mm3, mm0);
+
+			    // compare if greater than thres
+			    pcmpgtw_r2r(mm5, mm0);
+
+			    // norm
+			    psrlw_i2r(15, mm0);
+			    // pack to bytes
+			    packuswb_r2r(mm0, mm0);
+
+			    // write to moving
+			    movd_r2m(mm0, *moving);
+
+			    ac_memcpy(prev, src, 4);
+
+			    src+=4;
+			    prev+=4;
+
+			    count += *moving++;
+			    count += *moving++;
+			    count += *moving++;
+			    count += *moving++;
+
+			}
+
+			moving += PAD;
+		    }
+		    emms();
+
+		  }  else  // cannot use mmx
+#elif CAN_COMPILE_C_ALTIVEC
+		  if (can_use_altivec) {
+		      vector unsigned char vthres;
+		      vector unsigned char shift = vec_splat_u8(7);
+		      unsigned char __attribute__ ((aligned(16))) tdata[16];
+		      int i;
+		      memset(tdata, _threshold, 16);
+		      vthres = vec_ld(0, tdata);
+
+		      count = 0;
+		      for (y = 1; y < hminus1; y++)
+		      {
+			  for (x=0; x<w; x+=16) {
+
+			      vector unsigned char luma = vec_ld(0, (unsigned char *)src);
+			      vector unsigned char prv = vec_ld(0, (unsigned char *)prev);
+			      vector unsigned char vmov;
+			      vmov = vec_sub (vec_max (luma, prv), vec_min(luma, prv));
+
+			      // FF -> 01
+			      vmov = (vector unsigned char)vec_cmpgt(vmov, vthres);
+			      vmov = vec_sr(vmov, shift);
+
+			      vec_st(vmov, 0, (unsigned char *)moving);
+
+			      /* Keep a count of the number of moving pixels for the
+				 scene change detection. */
+			      for (i=0; i<16; i++) {
+				  count += *moving++;
+				  *prev++ = *src++;
+			      }
+
+			  }
+
+			  moving += PAD;
+		    }
+
+		  } else
+#endif
+		  {
+		    count = 0;
 		    for (y = 1; y < hminus1; y++)
 		    {
 			for (x=0; x<w; x++) {
@@ -788,10 +1090,10 @@ static void smartyuv_core (char *_src, char *_dst, char *_prev, int _width, int
 		else scenechange = 0;
 
 		if (scenechange && mfd->verbose)
-		    tc_log_info(MOD_NAME, "Scenechange at %6d (%6ld moving pixels)", counter, count);
+		    tc_log_info(MOD_NAME, "Scenechange at %6d (%6ld moving pixels)", mfd->counter, count);
 		/*
 		tc_log_msg(MOD_NAME, "Frame (%04d) count (%8ld) sc (%d) calc (%02ld)",
-				counter, count, scenechange, (100 * count) / (h * w));
+				mfd->counter, count, scenechange, (100 * count) / (h * w));
 				*/
 
 
@@ -924,569 +1226,423 @@ static void smartyuv_core (char *_src, char *_dst, char *_prev, int _width, int
 	// -----------------
 
 	// The first line gets a free ride.
-	src = src_buf;
-	dst = dst_buf;
+	ac_memcpy(dst_buf, src_buf, w);
+
+	render.mfd = mfd;
+	render.src_buf = src_buf;
+	render.dst_buf = dst_buf;
+	render.moving = _moving;
+	render.w = w;
+	render.h = h;
+	render.srcpitch = srcpitch;
+	render.dstpitch = dstpitch;
+	render.scenechange = scenechange;
+	render.clamp_f = clamp_f;
+	tc_module_slice_run(smartyuv_render, &render, h - 2, 16);
+
+	// Blending never touched the last line.
+	if (mfd->Blend && !mfd->motionOnly)
+	    return;
 
-	ac_memcpy(dst, src, w);
-	src = src_buf + srcpitch;
-	srcminus = src - srcpitch;
-	srcplus = src + srcpitch;
+	// The last line gets a free ride.
+	ac_memcpy(dst_buf + hminus1 * dstpitch, src_buf + hminus1 * srcpitch, w);
+	if (clamp_f == clamp_Y)
+	    mfd->counter++;
 
-	if (cubic)
-	{
-		srcminusminus = src - 3 * srcpitch;
-		srcplusplus = src + 3 * srcpitch;
-	}
+	return;
+}
 
-	dst = dst_buf + dstpitch;
-	moving = _moving + w+PAD;
-	movingminus = _moving;
-	movingplus = moving + w+PAD;
+/*************************************************************************/
 
-	/*
-	*/
+/* Module interface routines and data. */
 
-	if (mfd->motionOnly)
-	{
-	    for (y = 1; y < hminus1; y++)
-	    {
-		if (mfd->Blend)
-		{
-		    x = 0;
-		    do {
-			if (!(movingminus[x] | moving[x] | movingplus[x]) && !scenechange)
-			    dst[x] = (clamp_f==clamp_Y)?BLACK_BYTE_Y:BLACK_BYTE_UV;
-			else
-			{
-			    /* Blend fields. */
-			    dst[x] = (((src[x]&0xff)>>1) + ((srcminus[x]&0xff)>>2) + ((srcplus[x]&0xff)>>2))&0xff;
-			}
-		    } while(++x < w);
-		}
-		else
-		{
-		    x = 0;
-		    do {
-			if (!(movingminus[x] | moving[x] | movingplus[x]) && !scenechange)
-			    dst[x] = (clamp_f==clamp_Y)?BLACK_BYTE_Y:BLACK_BYTE_UV;
-			else if (y & 1)
-			{
-			    if (cubic && (y > 2) && (y < hminus3))
-			    {
-				rpp = (srcminusminus[x]) & 0xff;
-				rp =  (srcminus[x]) & 0xff;
-				rn =  (srcplus[x]) & 0xff;
-				rnn = (srcplusplus[x]) & 0xff;
-				R = (5 * (rp + rn) - (rpp + rnn)) >> 3;
-				dst[x] = clamp_f(R);
-			    }
-			    else
-			    {
-				p1 = srcminus[x] &0xff;
-				p1 &= 0xfe;
-
-				p2 = srcplus[x] &0xff;
-				p2 &= 0xfe;
-				dst[x] = ((p1>>1) + (p2>>1)) &0xff;
-			    }
-			}
-			else
-			    dst[x] = src[x];
-		    } while(++x < w);
-		}
-		src = src + srcpitch;
-		srcminus = srcminus + srcpitch;
-		srcplus = srcplus + srcpitch;
-
-		if (cubic)
-		{
-		    srcminusminus = srcminusminus + srcpitch;
-		    srcplusplus = srcplusplus + srcpitch;
-		}
-
-		dst = dst + dstpitch;
-		moving += (w+PAD);
-		movingminus += (w+PAD);
-		movingplus += (w+PAD);
-	    }
-	    // The last line gets a free ride.
-	    ac_memcpy(dst, src, w);
-
-	    if (clamp_f == clamp_Y)
-		counter++;
-
-	    return;
-
-	}
-
-	if (mfd->Blend)
-	{
-	    // linear blend, see Blendline_c for a plainC version
-	    for (y = 1; y < hminus1; y++)
-	    {
-#ifdef HAVE_ASM_MMX
-	      if (can_use_mmx) {
-
-		uint64_t scmask = (scenechange<<24) | (scenechange<<16) | (scenechange<<8) | scenechange;
-		scmask = (scmask << 32) | scmask;
+/*************************************************************************/
 
-		pcmpeqw_r2r(mm4, mm4);
-		psrlw_i2r(9,mm4);
-		packuswb_r2r(mm4, mm4);         // build 0x7f7f7f7f7f7f7f7f
+/**
+ * smartyuv_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-		pcmpeqw_r2r(mm6, mm6);
-		psrlw_i2r(10,mm6);
-		packuswb_r2r(mm6, mm6);         // build 0x3f3f3f3f3f3f3f3f
+TC_MODULE_GENERIC_INIT(smartyuv, SmartyuvPrivateData)
 
-		for (x=0; x<w; x+=8) {
+/*************************************************************************/
 
-		    movq_m2r(scmask, mm0);          // has a scenechange happend?
+/**
+ * smartyuv_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-		    pxor_r2r(mm5, mm5);             // clear mm5
+TC_MODULE_GENERIC_FINI(smartyuv)
 
-		    por_m2r (moving     [x], mm0);
-		    movq_m2r(src        [x], mm1);   // load src
-		    por_m2r (movingminus[x], mm0);   // motion detected?
-		    movq_m2r(src        [x-w], mm2);   // load srcminus
-		    por_m2r (movingplus [x], mm0);
-		    movq_m2r(src        [x+w], mm3);   // load srcplus
+/*************************************************************************/
 
-		    movq_r2r (mm1, mm7);
+/**
+ * smartyuv_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
 
-		    pcmpgtb_r2r(mm5, mm0);  // make FF out 1 and 0 out of 0
-
-		    pcmpeqw_r2r(mm5, mm5);  // make all ff's (recycle mm5)
-		    psubb_r2r  (mm0, mm5);  // inverse mask
-		    pand_r2r   (mm0, mm7);
-		    pand_r2r   (mm5, mm1);
-		    psrlw_i2r  (1,   mm7);
-
-		    pand_r2r   (mm4, mm7);  // clear highest bit
-		    por_r2r    (mm7, mm1);  // merge src>>1 and src together dependand on moving mask
-
-		    // mm0: mask, if 0 don't shift, if ff shift
-		    // mm1: complete src
-		    // mm2: srcminus
-		    // mm3: srcplus
-		    // mm4: 0x7f mask
-		    // mm5: free
-		    // mm6: 0x3f mask
-		    // mm7: free
-
-		    // handle srcm(inus) and srcp(lus)
-
-		    pand_r2r (mm0, mm2);
-		    pand_r2r (mm0, mm3);
-
-		    psrlw_i2r(2,   mm2);  // srcm>>2
-		    psrlw_i2r(2,   mm3);  // srcp>>2
-		    pand_r2r (mm6, mm2);  // clear highest two bits
-		    pand_r2r (mm6, mm3);
-
-		    paddusb_r2r (mm2, mm1);   // src>>1 + srcn>>2 + srcp>>2
-		    paddusb_r2r (mm3, mm1);
+static int smartyuv_stop(TCModuleInstance *self)
+{
+    SmartyuvPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+
+    tc_buffree(pd->buf);
+    pd->buf = NULL;
+    tc_buffree(pd->prevFrame);
+    pd->prevFrame = NULL;
+
+    tc_buffree(pd->movingY);
+    pd->movingY = NULL;
+    tc_buffree(pd->movingU);
+    pd->movingU = NULL;
+    tc_buffree(pd->movingV);
+    pd->movingV = NULL;
+
+    tc_buffree(pd->fmovingY);
+    pd->fmovingY = NULL;
+    tc_buffree(pd->fmovingU);
+    pd->fmovingU = NULL;
+    tc_buffree(pd->fmovingV);
+    pd->fmovingV = NULL;
+    return TC_OK;
+}
 
-		    movq_r2m(mm1, dst[x]);
+/*************************************************************************/
 
-		}
-	      } else // cannot use mmx
-#elif CAN_COMPILE_C_ALTIVEC
-	      if (can_use_altivec) {
-		  unsigned char tdata[16];
-		  memset (tdata, scenechange, 16);
-		  vector unsigned char vscene = vec_ld(0, tdata);
-		  vector unsigned char vmov, vsrc2, vdest;
-		  vector unsigned char vsrc, vsrcminus, vsrcplus;
-		  vector unsigned char zero = vec_splat_u8(0);
-		  vector unsigned char ones = vec_splat_u8(1);
-		  vector unsigned char twos = vec_splat_u8(2);
+/**
+ * smartyuv_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
+static int smartyuv_configure(TCModuleInstance *self,
+                              const char *options,
+                              TCJob *vob,
+                              TCModuleExtraData *xdata[])
+{
+    SmartyuvPrivateData *pd = NULL;
+    unsigned int width, height;
+    int msize, csize;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
+    width  = vob->im_v_width;
+    height = vob->im_v_height;
+
+    /* default values */
+    pd->motionOnly     = 0;
+    pd->threshold      = LUMA_THRESHOLD;
+    pd->chromathres    = CHROMA_THRESHOLD;
+    pd->scenethreshold = SCENE_THRESHOLD;
+    pd->diffmode       = FRAME_ONLY;
+    pd->codec          = vob->im_v_codec;
+    pd->highq          = 1;
+    pd->cubic          = 1;
+    pd->doChroma       = 1;
+    pd->Blend          = 1;
+    pd->verbose        = 0;
+    pd->counter        = 0;
+
+    if (pd->codec != TC_CODEC_YUV420P) {
+        tc_log_error(MOD_NAME, "This filter is only capable of YUV mode");
+        return TC_ERROR;
+    }
 
-		  for (x=0; x<w; x+=16) {
-		      vmov = vec_xor(vmov, vmov);
-		      vmov = vec_or (vmov, vec_ld(x, moving));
-		      vsrc = vec_ld(x, (unsigned char *)src);
-		      vmov = vec_or (vmov, vec_ld(x, movingminus));
-		      vsrcminus = vec_ld(x-w, (unsigned char *)src);
-		      vmov = vec_or (vmov, vec_ld(x, movingplus));
-		      vsrcplus = vec_ld(x+w, (unsigned char *)src);
-		      vmov = vec_or(vmov, vscene);
+    if (options != NULL) {
+        if (verbose)
+            tc_log_info(MOD_NAME, "options=%s", options);
+
+        optstr_get(options, "motionOnly",  "%d", &pd->motionOnly);
+        optstr_get(options, "threshold",   "%d", &pd->threshold);
+        optstr_get(options, "chromathres", "%d", &pd->chromathres);
+        optstr_get(options, "Blend",       "%d", &pd->Blend);
+        optstr_get(options, "scenethres",  "%d", &pd->scenethreshold);
+        optstr_get(options, "highq",       "%d", &pd->highq);
+        optstr_get(options, "cubic",       "%d", &pd->cubic);
+        optstr_get(options, "diffmode",    "%d", &pd->diffmode);
+        optstr_get(options, "doChroma",    "%d", &pd->doChroma);
+        optstr_get(options, "verbose",     "%d", &pd->verbose);
+
+        if (optstr_lookup(options, "help") != NULL) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, smartyuv_help);
+        }
+    }
 
-		      vsrc2 = vec_sr(vsrc, ones);
-		      vsrc2 = vec_add(vsrc2, vec_sr(vsrcminus, twos));
-		      vsrc2 = vec_add(vsrc2, vec_sr(vsrcplus, twos));
-		      vmov = (vector unsigned char)vec_cmpgt (vmov, zero);
-		 vdest = vec_or (vec_sel(vsrc, zero, vmov), vec_sel (vsrc2, zero, vec_nor(vmov, vmov)));
-		      vec_st(vdest, x, (unsigned char *)dst);
-		  }
+    if (verbose > 1) {
+        tc_log_info(MOD_NAME, " Smart YUV Deinterlacer Test Filter"
+                              " Settings (%dx%d):", width, height);
+        tc_log_info(MOD_NAME, "        motionOnly = %d", pd->motionOnly);
+        tc_log_info(MOD_NAME, "          diffmode = %d", pd->diffmode);
+        tc_log_info(MOD_NAME, "         threshold = %d", pd->threshold);
+        tc_log_info(MOD_NAME, "       chromathres = %d", pd->chromathres);
+        tc_log_info(MOD_NAME, "        scenethres = %d", pd->scenethreshold);
+        tc_log_info(MOD_NAME, "             cubic = %d", pd->cubic);
+        tc_log_info(MOD_NAME, "             highq = %d", pd->highq);
+        tc_log_info(MOD_NAME, "             Blend = %d", pd->Blend);
+        tc_log_info(MOD_NAME, "          doChroma = %d", pd->doChroma);
+        tc_log_info(MOD_NAME, "           verbose = %d", pd->verbose);
+    }
 
+    /*
+     * fetch memory. The motion maps are padded on every side, so the
+     * erode and dilate routines need no conditional borders.
+     */
+    msize = width*height + 4*(width+PAD) + PAD*height;
+    csize = width*height/4 + 4*(width+PAD) + PAD*height;
+
+    pd->buf       = tc_bufalloc(width*height*3);
+    pd->prevFrame = tc_bufalloc(width*height*3);
+    pd->movingY   = tc_bufalloc(msize);
+    pd->fmovingY  = tc_bufalloc(msize);
+    pd->movingU   = tc_bufalloc(csize);
+    pd->movingV   = tc_bufalloc(csize);
+    pd->fmovingU  = tc_bufalloc(csize);
+    pd->fmovingV  = tc_bufalloc(csize);
+
+    if (!pd->movingY || !pd->movingU || !pd->movingV || !pd->fmovingY
+     || !pd->fmovingU || !pd->fmovingV || !pd->buf || !pd->prevFrame) {
+        tc_log_error(MOD_NAME, "Memory allocation error");
+        smartyuv_stop(self);
+        return TC_ERROR;
+    }
 
+    memset(pd->prevFrame, BLACK_BYTE_Y, width*height);
+    memset(pd->prevFrame + width*height, BLACK_BYTE_UV, width*height/2);
 
+    memset(pd->buf, BLACK_BYTE_Y, width*height);
+    memset(pd->buf + width*height, BLACK_BYTE_UV, width*height/2);
 
+    memset(pd->movingY,  0, msize);
+    memset(pd->fmovingY, 0, msize);
+    memset(pd->movingU,  0, csize);
+    memset(pd->movingV,  0, csize);
+    memset(pd->fmovingU, 0, csize);
+    memset(pd->fmovingV, 0, csize);
 
-	      } else
+    if (verbose)
+        tc_log_info(MOD_NAME,
+#ifdef HAVE_ASM_MMX
+                    "(MMX) "
 #endif
-	      {
-		Blendline_c (dst, src, srcminus, srcplus, moving, movingminus, movingplus, w, scenechange);
-	      }
-
-		src +=  srcpitch;
-		srcminus += srcpitch;
-		srcplus += srcpitch;
-
-		dst += dstpitch;
-		moving += (w+PAD);
-		movingminus += (w+PAD);
-		movingplus += (w+PAD);
-	    }
-
-	    emms();
-	    return;
-	}
-
-	emms();
-
-	// Doing line interpolate. Thus, even lines are going through
-	// for moving and non-moving mode. Odd line pixels will be subject
-	// to the motion test.
-
-	for (y = 1; y < hminus1; y++)
-	{
-	    if (y&1)
-	    {
-		x = 0;
-		do {
-		    if (movingminus[x] | moving[x] | movingplus[x] | scenechange)
-			if (cubic & (y > 2) & (y < hminus3))
-			{
-			    R = (5 * ((srcminus[x] & 0xff) + (srcplus[x] & 0xff))
-				    - ((srcminusminus[x] & 0xff) + (srcplusplus[x] & 0xff))) >> 3;
-			    dst[x] = clamp_f(R);
-			}
-			else
-			{
-			    dst[x] = (((srcminus[x]&0xff) >> 1) + ((srcplus[x]&0xff) >> 1)) & 0xff;
-			}
-		    else
-		    {
-			dst[x] = src[x];
-		    }
-		} while(++x < w);
-	    }
-	    else
-	    {
-		// Even line; pass it through.
-		ac_memcpy(dst, src, w);
-	    }
-	    src +=  srcpitch;
-	    srcminus += srcpitch;
-	    srcplus += srcpitch;
-
-	    if (cubic)
-	    {
-		srcminusminus += srcpitch;
-		srcplusplus += srcpitch;
-	    }
-
-	    dst += dstpitch;
-	    moving += (w+PAD);
-	    movingminus += (w+PAD);
-	    movingplus += (w+PAD);
-	}
-
-	// The last line gets a free ride.
-	ac_memcpy(dst, src, w);
-	if (clamp_f == clamp_Y)
-	    counter++;
-
-	return;
+#ifdef CAN_COMPILE_C_ALTIVEC
+                    "(ALTIVEC) "
+#endif
+                    "%s %s", MOD_VERSION, MOD_CAP);
+    return TC_OK;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
-
-
-  if(ptr->tag & TC_FILTER_INIT) {
-
-	unsigned int width, height;
-	int msize;
-
-	if((vob = tc_get_vob())==NULL) return(-1);
-
-
-	mfd = tc_zalloc(sizeof(MyFilterData));
-
-	if (!mfd) {
-		tc_log_error(MOD_NAME, "No memory!");
-	        return (-1);
-	}
-
-	width  = vob->im_v_width;
-	height = vob->im_v_height;
-
-	/* default values */
-	mfd->motionOnly     = 0;
-	mfd->threshold      = LUMA_THRESHOLD;
-	mfd->chromathres    = CHROMA_THRESHOLD;
-	mfd->scenethreshold = SCENE_THRESHOLD;
-	mfd->diffmode       = FRAME_ONLY;
-	mfd->codec          = vob->im_v_codec;
-	mfd->highq          = 1;
-	mfd->cubic          = 1;
-	mfd->doChroma       = 1;
-	mfd->Blend          = 1;
-	mfd->verbose        = 0;
-
-	if (mfd->codec != TC_CODEC_YUV420P) {
-	    tc_log_error (MOD_NAME, "This filter is only capable of YUV mode");
-	    return -1;
-	}
-
-	if (options != NULL) {
-
-	  if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
+/*************************************************************************/
 
-	  optstr_get (options, "motionOnly",     "%d",  &mfd->motionOnly     );
-	  optstr_get (options, "threshold",      "%d",  &mfd->threshold      );
-	  optstr_get (options, "chromathres",    "%d",  &mfd->chromathres    );
-	  optstr_get (options, "Blend",          "%d",  &mfd->Blend          );
-	  optstr_get (options, "scenethres",     "%d",  &mfd->scenethreshold );
-	  optstr_get (options, "highq",          "%d",  &mfd->highq          );
-	  optstr_get (options, "cubic",          "%d",  &mfd->cubic          );
-	  optstr_get (options, "diffmode",       "%d",  &mfd->diffmode       );
-	  optstr_get (options, "doChroma",       "%d",  &mfd->doChroma       );
-	  optstr_get (options, "verbose",        "%d",  &mfd->verbose        );
-
-	  if (optstr_lookup (options, "help") != NULL) {
-		  help_optstr();
-	  }
-	}
-
-	if (verbose > 1) {
-
-	  tc_log_info (MOD_NAME, " Smart YUV Deinterlacer Test Filter Settings (%dx%d):", width, height);
-	  tc_log_info (MOD_NAME, "        motionOnly = %d", mfd->motionOnly);
-	  tc_log_info (MOD_NAME, "          diffmode = %d", mfd->diffmode);
-	  tc_log_info (MOD_NAME, "         threshold = %d", mfd->threshold);
-	  tc_log_info (MOD_NAME, "       chromathres = %d", mfd->chromathres);
-	  tc_log_info (MOD_NAME, "        scenethres = %d", mfd->scenethreshold);
-	  tc_log_info (MOD_NAME, "             cubic = %d", mfd->cubic);
-	  tc_log_info (MOD_NAME, "             highq = %d", mfd->highq);
-	  tc_log_info (MOD_NAME, "             Blend = %d", mfd->Blend);
-	  tc_log_info (MOD_NAME, "          doChroma = %d", mfd->doChroma);
-	  tc_log_info (MOD_NAME, "           verbose = %d", mfd->verbose);
-	}
+/**
+ * smartyuv_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
-	/* fetch memory */
+static int smartyuv_inspect(TCModuleInstance *self,
+                            const char *param, const char **value)
+{
+    SmartyuvPrivateData *pd = NULL;
 
-	mfd->buf =  tc_bufalloc (width*height*3);
-	mfd->prevFrame =  tc_bufalloc (width*height*3);
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
-	msize = width*height + 4*(width+PAD) + PAD*height;
-	mfd->movingY = (unsigned char *) tc_bufalloc(sizeof(unsigned char)*msize);
-	mfd->fmovingY = (unsigned char *) tc_bufalloc(sizeof(unsigned char)*msize);
+    pd = self->userdata;
 
-	msize = width*height/4 + 4*(width+PAD) + PAD*height;
-	mfd->movingU  = (unsigned char *) tc_bufalloc(sizeof(unsigned char)*msize);
-	mfd->movingV  = (unsigned char *) tc_bufalloc(sizeof(unsigned char)*msize);
-	mfd->fmovingU = (unsigned char *) tc_bufalloc(sizeof(unsigned char)*msize);
-	mfd->fmovingV = (unsigned char *) tc_bufalloc(sizeof(unsigned char)*msize);
+    if (optstr_lookup(param, "help")) {
+        *value = smartyuv_help;
+    }
+    if (optstr_lookup(param, "threshold")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->threshold);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "chromathres")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->chromathres);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "diffmode")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i",
+                    pd->diffmode);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
 
-	if ( !mfd->movingY || !mfd->movingU || !mfd->movingV || !mfd->fmovingY ||
-	      !mfd->fmovingU || !mfd->fmovingV || !mfd->buf || !mfd->prevFrame) {
-	    tc_log_msg(MOD_NAME, "Memory allocation error");
-	    return -1;
-	}
+/*************************************************************************/
 
-	memset(mfd->prevFrame, BLACK_BYTE_Y, width*height);
-	memset(mfd->prevFrame+width*height, BLACK_BYTE_UV, width*height/2);
-
-	memset(mfd->buf, BLACK_BYTE_Y, width*height);
-	memset(mfd->buf+width*height, BLACK_BYTE_UV, width*height/2);
-
-	msize = width*height + 4*(width+PAD) + PAD*height;
-	memset(mfd->movingY,  0, msize);
-	memset(mfd->fmovingY, 0, msize);
-
-	msize = width*height/4 + 4*(width+PAD) + PAD*height;
-	memset(mfd->movingU,  0, msize);
-	memset(mfd->movingV,  0, msize);
-	memset(mfd->fmovingU, 0, msize);
-	memset(mfd->fmovingV, 0, msize);
-
-	// Optimisation
-	// For the motion maps a little bit more than the needed memory is
-	// allocated. This is done, because than we don't have to use
-	// conditional borders int the erode and dilate routines. 2 extra lines
-	// on top and bottom and 2 pixels left and right for each line.
-	// This is also the reason for the w+4's all over the place.
-	//
-	// This gives an speedup factor in erode+denoise of about 3.
-	//
-	// A lot of brain went into the optimisations, here are some numbers of
-	// the separate steps. Note, to get these numbers I used the rdtsc
-	// instruction to read the CPU cycle counter in seperate programms:
-	// o  Motion map creation
-	//      orig: 26.283.387 Cycles
-	//       now:  8.991.686 Cycles
-	//       mmx:  5.062.952
-	// o  Erode+dilate
-	//      orig: 55.847.077
-	//       now: 21.764.997
-	//  Erodemmx: 18.765.878
-	// o  Blending
-	//      orig: 8.162.287
-	//       now: 5.384.433
-	//       mmx: 4.569.875
-	//   new mmx: 3.656.537
-	// o  Cubic interpolation
-	//      orig: 7.487.338
-	//       now: 6.684.908
-	//      more: 3.554.580
-	//
-	// Overall improvement in transcode:
-	// 11.57 -> 22.78 frames per second for the test clip.
-	//
-
-	// filter init ok.
-
-	if(verbose) tc_log_info(MOD_NAME,
-#ifdef HAVE_ASM_MMX
-		"(MMX) "
-#endif
-#ifdef CAN_COMPILE_C_ALTIVEC
-		"(ALTIVEC) "
-#endif
-		"%s %s", MOD_VERSION, MOD_CAP);
+/**
+ * smartyuv_filter_video:  deinterlace the given frame, one plane at a
+ * time.  See tcmodule-data.h for function details.
+ */
 
-	return 0;
+static int smartyuv_filter_video(TCModuleInstance *self,
+                                 vframe_list_t *frame)
+{
+    SmartyuvPrivateData *pd = NULL;
+    int width, height, w2, h2, U, V, msize, off;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+
+    width  = frame->v_width;
+    height = frame->v_height;
+    w2     = width/2;
+    h2     = height/2;
+    U      = width*height;
+    V      = width*height*5/4;
+
+    msize = width*height + 4*(width+PAD) + PAD*height;
+    off   = 2*(width+PAD) + PAD/2;
+
+    memset(pd->movingY,  0, msize);
+    memset(pd->fmovingY, 0, msize);
+
+    smartyuv_core(pd, frame->video_buf, pd->buf, pd->prevFrame,
+                  width, height, width, width,
+                  pd->movingY + off, pd->fmovingY + off,
+                  clamp_Y, pd->threshold);
+
+    if (pd->doChroma) {
+        msize = width*height/4 + 4*(width+PAD) + PAD*height;
+        off   = 2*(w2+PAD) + PAD/2;
+
+        memset(pd->movingU,  0, msize);
+        memset(pd->fmovingU, 0, msize);
+        memset(pd->movingV,  0, msize);
+        memset(pd->fmovingV, 0, msize);
+
+        smartyuv_core(pd, frame->video_buf + U, pd->buf + U,
+                      pd->prevFrame + U, w2, h2, w2, w2,
+                      pd->movingU + off, pd->fmovingU + off,
+                      clamp_UV, pd->chromathres);
+        smartyuv_core(pd, frame->video_buf + V, pd->buf + V,
+                      pd->prevFrame + V, w2, h2, w2, w2,
+                      pd->movingV + off, pd->fmovingV + off,
+                      clamp_UV, pd->chromathres);
+    } else {
+        /* pass through */
+        ac_memcpy(pd->buf + U, frame->video_buf + U, width*height/2);
+    }
 
-  } /* TC_FILTER_INIT */
+    ac_memcpy(frame->video_buf, pd->buf, frame->video_size);
+    return TC_OK;
+}
 
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
-      char buf[255];
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VYE", "1");
+static const TCCodecID smartyuv_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+static const TCCodecID smartyuv_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(smartyuv);
+TC_MODULE_FILTER_FORMATS(smartyuv);
 
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->motionOnly);
-      optstr_param (options, "motionOnly", "Show motion areas only, blacking out static areas" ,"%d", buf, "0", "1");
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->diffmode);
-      optstr_param (options, "diffmode", "Motion Detection (0=frame, 1=field, 2=both)", "%d", buf, "0", "2" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->threshold);
-      optstr_param (options, "threshold", "Motion Threshold (luma)", "%d", buf, "0", "255" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->chromathres);
-      optstr_param (options, "chromathres", "Motion Threshold (chroma)", "%d", buf, "0", "255" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->scenethreshold);
-      optstr_param (options, "scenethres", "Threshold for detecting scenechanges", "%d", buf, "0", "255" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->highq);
-      optstr_param (options, "highq", "High-Quality processing (motion Map denoising)", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->cubic);
-      optstr_param (options, "cubic", "Do cubic interpolation", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->Blend);
-      optstr_param (options, "Blend", "Blend the frames for deinterlacing", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->doChroma);
-      optstr_param (options, "doChroma", "Enable chroma processing (slower but more accurate)", "%d", buf, "0", "1" );
-      tc_snprintf (buf, sizeof(buf), "%d", mfd->verbose);
-      optstr_param (options, "verbose", "Verbose mode", "%d", buf, "0", "1" );
+TC_MODULE_INFO(smartyuv);
 
-      return (0);
-  }
+static const TCModuleClass smartyuv_class = {
+    TC_MODULE_CLASS_HEAD(smartyuv),
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
+    .init         = smartyuv_init,
+    .fini         = smartyuv_fini,
+    .configure    = smartyuv_configure,
+    .stop         = smartyuv_stop,
+    .inspect      = smartyuv_inspect,
 
-	if (!mfd)
-		return 0;
+    .filter_video = smartyuv_filter_video
+};
 
-	tc_buffree (mfd->buf);
-	mfd->buf = NULL;
+TC_MODULE_ENTRY_POINT(smartyuv)
 
-	tc_buffree (mfd->prevFrame);
-	mfd->prevFrame = NULL;
+/*************************************************************************/
 
-	tc_buffree (mfd->movingY);
-	mfd->movingY = NULL;
-	tc_buffree (mfd->movingU);
-	mfd->movingU = NULL;
-	tc_buffree (mfd->movingV);
-	mfd->movingV = NULL;
+static int smartyuv_get_config(TCModuleInstance *self, char *options)
+{
+    SmartyuvPrivateData *pd = NULL;
+    char buf[255];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VYE", "1");
+
+    tc_snprintf(buf, sizeof(buf), "%d", pd->motionOnly);
+    optstr_param(options, "motionOnly",
+                 "Show motion areas only, blacking out static areas",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->diffmode);
+    optstr_param(options, "diffmode",
+                 "Motion Detection (0=frame, 1=field, 2=both)",
+                 "%d", buf, "0", "2");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->threshold);
+    optstr_param(options, "threshold", "Motion Threshold (luma)",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->chromathres);
+    optstr_param(options, "chromathres", "Motion Threshold (chroma)",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->scenethreshold);
+    optstr_param(options, "scenethres",
+                 "Threshold for detecting scenechanges",
+                 "%d", buf, "0", "255");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->highq);
+    optstr_param(options, "highq",
+                 "High-Quality processing (motion Map denoising)",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->cubic);
+    optstr_param(options, "cubic", "Do cubic interpolation",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->Blend);
+    optstr_param(options, "Blend", "Blend the frames for deinterlacing",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->doChroma);
+    optstr_param(options, "doChroma",
+                 "Enable chroma processing (slower but more accurate)",
+                 "%d", buf, "0", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->verbose);
+    optstr_param(options, "verbose", "Verbose mode",
+                 "%d", buf, "0", "1");
+    return TC_OK;
+}
 
-	tc_buffree (mfd->fmovingY);
-	mfd->fmovingY = NULL;
-	tc_buffree (mfd->fmovingU);
-	mfd->fmovingU = NULL;
-	tc_buffree (mfd->fmovingV);
-	mfd->fmovingV = NULL;
+static int smartyuv_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
 
-	if (mfd)
-		free(mfd);
+    if (frame->tag & TC_PRE_M_PROCESS && frame->tag & TC_VIDEO) {
+        return smartyuv_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
+}
 
-	return 0;
+/*************************************************************************/
 
-  } /* TC_FILTER_CLOSE */
+/* Old-fashioned module interface. */
 
-///////////////////////////////////////////////////////////////////////////
+TC_FILTER_OLDINTERFACE(smartyuv)
 
-  //if(ptr->tag & TC_PRE_S_PROCESS && ptr->tag & TC_VIDEO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
-  if(ptr->tag & TC_PRE_M_PROCESS && ptr->tag & TC_VIDEO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
-
-	  int U  = ptr->v_width*ptr->v_height;
-	  int V  = ptr->v_width*ptr->v_height*5/4;
-	  int w2 = ptr->v_width/2;
-	  int h2 = ptr->v_height/2;
-	  int msize = ptr->v_width*ptr->v_height + 4*(ptr->v_width+PAD) + PAD*ptr->v_height;
-	  int off = 2*(ptr->v_width+PAD)+PAD/2;
-
-	  memset(mfd->movingY,  0, msize);
-	  memset(mfd->fmovingY, 0, msize);
-	  /*
-	  */
-
-
-	  smartyuv_core(ptr->video_buf, mfd->buf, mfd->prevFrame,
-		        ptr->v_width, ptr->v_height, ptr->v_width, ptr->v_width,
-		        mfd->movingY+off, mfd->fmovingY+off, clamp_Y, mfd->threshold);
-
-
-	  if (mfd->doChroma) {
-	      msize = ptr->v_width*ptr->v_height/4 + 4*(ptr->v_width+PAD) + PAD*ptr->v_height;
-	      off = 2*(ptr->v_width/2+PAD)+PAD/2;
-
-	      memset(mfd->movingU,  0, msize);
-	      memset(mfd->fmovingU, 0, msize);
-	      memset(mfd->movingV,  0, msize);
-	      memset(mfd->fmovingV, 0, msize);
-	      /*
-	      */
-
-	      smartyuv_core(ptr->video_buf+U, mfd->buf+U, mfd->prevFrame+U,
-			  w2, h2, w2, w2,
-			  mfd->movingU+off, mfd->fmovingU+off, clamp_UV, mfd->chromathres);
-
-	      smartyuv_core(ptr->video_buf+V, mfd->buf+V, mfd->prevFrame+V,
-			  w2, h2, w2, w2,
-			  mfd->movingV+off, mfd->fmovingV+off, clamp_UV, mfd->chromathres);
-	  } else {
-	      //pass through
-	      ac_memcpy(mfd->buf+U, ptr->video_buf+U, ptr->v_width*ptr->v_height/2);
-	      //memset(mfd->buf+U, BLACK_BYTE_UV, ptr->v_width*ptr->v_height/2);
-	  }
-
-	  /*
-	  memset(mfd->buf, BLACK_BYTE_Y, ptr->v_width*ptr->v_height);
-	  memset(mfd->buf+U, BLACK_BYTE_UV, ptr->v_width*ptr->v_height/2);
-			  */
-
-	  ac_memcpy (ptr->video_buf, mfd->buf, ptr->video_size);
-
-	  return 0;
-  }
-  return 0;
-}
+/*************************************************************************/
 
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
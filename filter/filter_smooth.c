@@ -22,211 +22,353 @@
  */
 
 #define MOD_NAME    "filter_smooth.so"
-#define MOD_VERSION "v0.2.3 (2003-03-27)"
+#define MOD_VERSION "v0.3.0 (2026-10-18)"
 #define MOD_CAP     "(single-frame) smoothing plugin"
 #define MOD_AUTHOR  "Chad Page"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL
+
 #include "src/transcode.h"
 #include "src/filter.h"
+#include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
-/* FIXME: this uses the filter ID as an index--the ID can grow
- * arbitrarily large, so this needs to be fixed */
-static unsigned char *tbuf[100];
 
-static void smooth_yuv(unsigned char *buf, int width, int height, int maxdiff,
-		       int maxldiff, int maxdist, float level, int instance)
-{
-	int x, y, pu, cpu, cdiff;
-	int xa, ya, oval, ldiff;
-	unsigned char *bufcr, *bufcb;
-	unsigned char *tbufcr, *tbufcb, *ltbuf;
-	float dist, ratio, nval;
-
-	ltbuf = tbuf[instance];
-	tbufcb = &ltbuf[width * height];
-	tbufcr = &tbufcb[(width/2) * (height/2)];
-
-	ac_memcpy(ltbuf, buf, (width * height) * 3 / 2);
-
-	bufcb = &buf[width * height];
-	bufcr = &bufcb[(width/2) * (height/2)];
-
-
-	/* First pass - horizontal */
-
-	for (y = 0; y < (height); y++) {
-		for (x = 0; x < width; x++) {
-			pu = ((y * width) / 2) + (x / 2);
-			nval = ((float)buf[x + (y * width)]);
-			oval = buf[x + (y * width)];
-			for (xa = x - maxdist; (xa <= (x + maxdist)) && (xa < width); xa++) {
-				if (xa < 0) xa = 0;
-				if (xa == x) xa++;
-				cpu = ((y * width) / 2) + (xa / 2);
-				cdiff = abs(tbufcr[pu] - tbufcr[cpu]);
-				cdiff += abs(tbufcb[pu] - tbufcb[cpu]);
-
-				/* If color difference not too great, average the pixel according to distance */
-				ldiff = abs(ltbuf[xa + (y * width)] - oval);
-				if ((cdiff < maxdiff) && (ldiff < maxldiff)) {
-					dist = abs(xa - x);
-					ratio = level / dist;
-					nval = nval * (1 - ratio);
-					nval += ((float)ltbuf[xa + (y * width)]) * ratio;
-				}
-			}
-			buf[x + (y * width)] = (unsigned char)(nval + 0.5);
-		}
-	}
-
-	/* Second pass - vertical lines */
-
-	ac_memcpy(ltbuf, buf, (width * height) * 3 / 2);
-
-	for (y = 0; y < (height); y++) {
-		for (x = 0; x < width; x++) {
-			pu = ((y * width) / 2) + (x / 2);
-			nval = ((float)buf[x + (y * width)]);
-			oval = buf[x + (y * width)];
-			for (ya = y - maxdist; (ya <= (y + maxdist)) && (ya < height); ya++) {
-				if (ya < 0) ya = 0;
-				if (ya == y) ya++;
-				cpu = ((ya * width) / 2) + (x / 2);
-				cdiff = abs(tbufcr[pu] - tbufcr[cpu]);
-				cdiff += abs(tbufcb[pu] - tbufcb[cpu]);
-
-				/* If color difference not too great, average the pixel according to distance */
-				ldiff = abs(ltbuf[x + (ya * width)] - oval);
-				if ((cdiff < maxdiff) && (ldiff < maxldiff)) {
-					dist = abs(ya - y);
-					ratio = level / dist;
-					nval = nval * (1 - ratio);
-					nval += ((float)ltbuf[x + (ya * width)]) * ratio;
-				}
-			}
-			buf[x + (y * width)] = (unsigned char)(nval + 0.5);
-		}
-	}
-}
+static const char smooth_help[] = ""
+    "Overview\n"
+    "    Single-frame smoothing: blends each pixel with its neighbours\n"
+    "    of similar color.\n"
+    "Options\n"
+    "    strength  Blending factor [0.25]\n"
+    "    cdiff     Max difference in chroma values [6]\n"
+    "    ldiff     Max difference in luma value [8]\n"
+    "    range     Search Range [4]\n";
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
+/*************************************************************************/
+
+typedef struct SmoothPrivateData_ {
+    float strength;     /* blending factor, do not exceed 2 ever */
+    int cdiff;          /* max difference in UV values */
+    int ldiff;          /* max difference in Y value */
+    int range;          /* search range */
+
+    char opt_buf[TC_BUF_MIN];
+} SmoothPrivateData;
 
-int tc_filter(frame_list_t *ptr_, char *options)
+/*************************************************************************/
+
+/* `tbuf' is a scratch buffer of one YUV420P frame, owned by the caller. */
+
+static void smooth_yuv(uint8_t *buf, uint8_t *tbuf, int width, int height,
+                       int maxdiff, int maxldiff, int maxdist, float level)
 {
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
-  /* FIXME: these use the filter ID as an index--the ID can grow
-   * arbitrarily large, so this needs to be fixed */
-  static int cdiff[100], ldiff[100], range[100];
-  static float strength[100];
-  int instance = ptr->filter_id;
+    int x, y, pu, cpu, cdiff;
+    int xa, ya, oval, ldiff;
+    uint8_t *tbufcr, *tbufcb;
+    float dist, ratio, nval;
+
+    tbufcb = &tbuf[width * height];
+    tbufcr = &tbufcb[(width/2) * (height/2)];
+
+    ac_memcpy(tbuf, buf, (width * height) * 3 / 2);
+
+    /* First pass - horizontal */
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            pu = ((y * width) / 2) + (x / 2);
+            nval = ((float)buf[x + (y * width)]);
+            oval = buf[x + (y * width)];
+            for (xa = x - maxdist; (xa <= (x + maxdist)) && (xa < width); xa++) {
+                if (xa < 0) xa = 0;
+                if (xa == x) xa++;
+                cpu = ((y * width) / 2) + (xa / 2);
+                cdiff = abs(tbufcr[pu] - tbufcr[cpu]);
+                cdiff += abs(tbufcb[pu] - tbufcb[cpu]);
+
+                /* If color difference not too great, average the pixel
+                 * according to distance */
+                ldiff = abs(tbuf[xa + (y * width)] - oval);
+                if ((cdiff < maxdiff) && (ldiff < maxldiff)) {
+                    dist = abs(xa - x);
+                    ratio = level / dist;
+                    nval = nval * (1 - ratio);
+                    nval += ((float)tbuf[xa + (y * width)]) * ratio;
+                }
+            }
+            buf[x + (y * width)] = (uint8_t)(nval + 0.5);
+        }
+    }
 
+    /* Second pass - vertical lines */
+
+    ac_memcpy(tbuf, buf, (width * height) * 3 / 2);
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            pu = ((y * width) / 2) + (x / 2);
+            nval = ((float)buf[x + (y * width)]);
+            oval = buf[x + (y * width)];
+            for (ya = y - maxdist; (ya <= (y + maxdist)) && (ya < height); ya++) {
+                if (ya < 0) ya = 0;
+                if (ya == y) ya++;
+                cpu = ((ya * width) / 2) + (x / 2);
+                cdiff = abs(tbufcr[pu] - tbufcr[cpu]);
+                cdiff += abs(tbufcb[pu] - tbufcb[cpu]);
+
+                /* If color difference not too great, average the pixel
+                 * according to distance */
+                ldiff = abs(tbuf[x + (ya * width)] - oval);
+                if ((cdiff < maxdiff) && (ldiff < maxldiff)) {
+                    dist = abs(ya - y);
+                    ratio = level / dist;
+                    nval = nval * (1 - ratio);
+                    nval += ((float)tbuf[x + (ya * width)]) * ratio;
+                }
+            }
+            buf[x + (y * width)] = (uint8_t)(nval + 0.5);
+        }
+    }
+}
 
-  //----------------------------------
-  //
-  // filter print configure
-  //
-  //----------------------------------
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
+/* Module interface routines and data. */
 
-      char buf[32];
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VYEM", "1");
+/*************************************************************************/
 
-      // buf, name, comment, format, val, from, to
-      tc_snprintf (buf, 32, "%.2f", strength[instance]);
-      optstr_param (options, "strength", "Blending factor",                 "%f", buf, "0.0", "0.9");
+/**
+ * smooth_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-      tc_snprintf (buf, 32, "%d", cdiff[instance]);
-      optstr_param (options, "cdiff",    "Max difference in chroma values", "%d", buf, "0", "16");
+TC_MODULE_GENERIC_INIT(smooth, SmoothPrivateData)
 
-      tc_snprintf (buf, 32, "%d", ldiff[instance]);
-      optstr_param (options, "ldiff",    "Max difference in luma value",    "%d", buf, "0", "16");
+/*************************************************************************/
 
-      tc_snprintf (buf, 32, "%d", range[instance]);
-      optstr_param (options, "range",    "Search Range",                    "%d", buf, "0", "16");
+/**
+ * smooth_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-	return 0;
-  }
+TC_MODULE_GENERIC_FINI(smooth)
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_INIT) {
+/**
+ * smooth_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+static int smooth_configure(TCModuleInstance *self,
+                            const char *options,
+                            TCJob *vob,
+                            TCModuleExtraData *xdata[])
+{
+    SmoothPrivateData *pd = NULL;
 
-    // filter init ok.
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
 
-    // set defaults
+    pd = self->userdata;
 
-    strength[instance] = 0.25;	/* Blending factor.  Do not exceed 2 ever */
-    cdiff[instance] = 6;		/* Max difference in UV values */
-    ldiff[instance] = 8;		/* Max difference in Y value */
-    range[instance] = 4;		/* Search range */
+    pd->strength = 0.25;
+    pd->cdiff    = 6;
+    pd->ldiff    = 8;
+    pd->range    = 4;
 
     if (options != NULL) {
-    	if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
+        if (verbose)
+            tc_log_info(MOD_NAME, "options=%s", options);
+        optstr_get(options, "strength", "%f", &pd->strength);
+        optstr_get(options, "cdiff",    "%d", &pd->cdiff);
+        optstr_get(options, "ldiff",    "%d", &pd->ldiff);
+        optstr_get(options, "range",    "%d", &pd->range);
+    }
+    if (pd->strength > 0.9)
+        pd->strength = 0.9;
+
+    if (vob->im_v_codec != TC_CODEC_YUV420P) {
+        tc_log_error(MOD_NAME, "only capable of YUV mode");
+        return TC_ERROR;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * smooth_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
+
+static int smooth_stop(TCModuleInstance *self)
+{
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
+}
+
+/*************************************************************************/
 
-	optstr_get (options, "strength",  "%f", &strength[instance]);
-	optstr_get (options, "cdiff",  "%d", &cdiff[instance]);
-	optstr_get (options, "ldiff",  "%d", &ldiff[instance]);
-	optstr_get (options, "range",  "%d", &range[instance]);
+/**
+ * smooth_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
+
+static int smooth_inspect(TCModuleInstance *self,
+                          const char *param, const char **value)
+{
+    SmoothPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = smooth_help;
+    }
+    if (optstr_lookup(param, "strength")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%.2f", pd->strength);
+        *value = pd->opt_buf;
     }
+    if (optstr_lookup(param, "cdiff")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->cdiff);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "ldiff")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->ldiff);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "range")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->range);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
 
-    tbuf[instance] = tc_malloc(SIZE_RGB_FRAME);
-    if (strength[instance]> 0.9) strength[instance] = 0.9;
-    memset(tbuf[instance], 0, SIZE_RGB_FRAME);
+/*************************************************************************/
 
-    if (vob->im_v_codec == TC_CODEC_RGB24) {
-	if (verbose) tc_log_error(MOD_NAME, "only capable of YUV mode");
-	return -1;
+/**
+ * smooth_filter_video:  smooth the given frame.  See tcmodule-data.h for
+ * function details.
+ */
+
+static int smooth_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    SmoothPrivateData *pd = NULL;
+    uint8_t *tbuf = NULL;
+    int size;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+
+    /* scratch space of the frame's own: frames run concurrently.
+     * The chroma lookups in smooth_yuv() reach up to half a plane past
+     * the frame, into what used to be the zeroed tail of a whole
+     * SIZE_RGB_FRAME buffer: keep that tail, and keep it zeroed. */
+    size = frame->v_width * frame->v_height * 2;
+    tbuf = tc_zalloc(size);
+    if (!tbuf) {
+        tc_log_error(MOD_NAME, "Could not allocate %d bytes", size);
+        return TC_ERROR;
     }
+    smooth_yuv(frame->video_buf, tbuf, frame->v_width, frame->v_height,
+               pd->cdiff, pd->ldiff, pd->range, pd->strength);
+    tc_free(tbuf);
+    return TC_OK;
+}
 
-    if(verbose) tc_log_info(MOD_NAME, "%s %s #%d", MOD_VERSION, MOD_CAP, ptr->filter_id);
+/*************************************************************************/
 
-    return(0);
-  }
+static const TCCodecID smooth_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+static const TCCodecID smooth_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(smooth);
+TC_MODULE_FILTER_FORMATS(smooth);
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
+TC_MODULE_INFO(smooth);
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
-    if (tbuf[instance])
-      free(tbuf[instance]);
-    tbuf[instance] = NULL;
+static const TCModuleClass smooth_class = {
+    TC_MODULE_CLASS_HEAD(smooth),
 
-    return(0);
-  }
+    .init         = smooth_init,
+    .fini         = smooth_fini,
+    .configure    = smooth_configure,
+    .stop         = smooth_stop,
+    .inspect      = smooth_inspect,
 
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
+    .filter_video = smooth_filter_video
+};
 
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
+TC_MODULE_ENTRY_POINT(smooth)
 
-  if(ptr->tag & TC_PRE_M_PROCESS && ptr->tag & TC_VIDEO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
+/*************************************************************************/
 
-	if (vob->im_v_codec == TC_CODEC_YUV420P)
-		smooth_yuv(ptr->video_buf, ptr->v_width, ptr->v_height, cdiff[instance],
-		    ldiff[instance], range[instance], strength[instance], instance);
+static int smooth_get_config(TCModuleInstance *self, char *options)
+{
+    SmoothPrivateData *pd = NULL;
+    char buf[32];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VYEM", "1");
+
+    tc_snprintf(buf, sizeof(buf), "%.2f", pd->strength);
+    optstr_param(options, "strength", "Blending factor",
+                 "%f", buf, "0.0", "0.9");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->cdiff);
+    optstr_param(options, "cdiff", "Max difference in chroma values",
+                 "%d", buf, "0", "16");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->ldiff);
+    optstr_param(options, "ldiff", "Max difference in luma value",
+                 "%d", buf, "0", "16");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->range);
+    optstr_param(options, "range", "Search Range",
+                 "%d", buf, "0", "16");
+    return TC_OK;
+}
 
-  }
+static int smooth_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
 
-  return(0);
+    if (frame->tag & TC_PRE_M_PROCESS && frame->tag & TC_VIDEO) {
+        return smooth_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(smooth)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -22,216 +22,344 @@
  */
 
 #define MOD_NAME    "filter_testframe.so"
-#define MOD_VERSION "v0.1.3 (2003-09-04)"
+#define MOD_VERSION "v0.2.0 (2026-10-18)"
 #define MOD_CAP     "generate stream of testframes"
 #define MOD_AUTHOR  "Thomas Oestreich"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL
+
 #include "src/transcode.h"
 #include "src/filter.h"
+#include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
-static int mode=0;
-static vob_t *vob=NULL;
 
-static void generate_rgb_frame(char *buffer, int width, int height)
-{
-  int n, j, row_bytes;
+static const char testframe_help[] = ""
+    "Overview\n"
+    "    Replaces every frame with a test pattern.\n"
+    "Options\n"
+    "    mode  Choose the test pattern (0-4 interlaced, 5 colorfull) [0]\n";
 
-  row_bytes = width*3;
+/*************************************************************************/
 
-  memset(buffer, 0, width*height*3);
+typedef struct TestframePrivateData_ {
+    int mode;
+    int codec;
 
-  switch(mode) {
+    char opt_buf[TC_BUF_MIN];
+} TestframePrivateData;
 
-  case 0:
+/*************************************************************************/
 
-      for(n=0; n<height; ++n) {
+static void generate_rgb_frame(uint8_t *buffer, int width, int height,
+                               int mode)
+{
+    int n, j, row_bytes;
+
+    row_bytes = width*3;
+
+    memset(buffer, 0, width*height*3);
+
+    switch (mode) {
+      case 0:
+        for (n = 0; n < height; ++n) {
+            for (j = 0; j < row_bytes; ++j)
+                buffer[n*row_bytes+j] = (n & 1) ? 255 : 0;
+        }
+        break;
+
+      case 1:
+        for (n = 0; n < height*width; n = n+2) {
+            buffer[n*3]   = 255;
+            buffer[n*3+1] = 255;
+            buffer[n*3+2] = 255;
+        }
+        break;
+
+      case 2:  /* red picture */
+        for (n = 0; n < height*width; ++n) {
+            buffer[n*3]   = 255;
+            buffer[n*3+1] = 0;
+            buffer[n*3+2] = 0;
+        }
+        break;
+
+      case 3:  /* green picture */
+        for (n = 0; n < height*width; ++n) {
+            buffer[n*3]   = 0;
+            buffer[n*3+1] = 255;
+            buffer[n*3+2] = 0;
+        }
+        break;
+
+      case 4:  /* blue picture */
+        for (n = 0; n < height*width; ++n) {
+            buffer[n*3]   = 0;
+            buffer[n*3+1] = 0;
+            buffer[n*3+2] = 255;
+        }
+        break;
+    }
+}
 
-	  if(n & 1) {
-	      for(j=0; j<row_bytes; ++j) buffer[n*row_bytes+j] = 255;
-	  } else {
-	      for(j=0; j<row_bytes; ++j) buffer[n*row_bytes+j] = 0;
-	  }
-      }
+/* The moving pattern of mode 5 is a function of the frame number, so
+ * frames can be generated in any order. */
 
-      break;
+static void generate_yuv_frame(uint8_t *buffer, int width, int height,
+                               int mode, int indx)
+{
+    int n, j, row_bytes;
+
+    row_bytes = width;
+
+    memset(buffer, 0x80, width*height*3/2);
+
+    switch (mode) {
+      case 0:
+        for (n = 0; n < height; ++n) {
+            for (j = 0; j < row_bytes; ++j)
+                buffer[n*row_bytes+j] = (n & 1) ? 255 : 0;
+        }
+        break;
+
+      case 1:
+        for (n = 0; n < height*width; ++n)
+            buffer[n] = (n & 1) ? 255 : 0;
+        break;
+
+      case 5: /* from libavformat */
+        {
+            int x, y;
+            uint8_t *Y = buffer,
+                    *U = Y + width*height,
+                    *V = U + (width/2)*(height/2);
+
+            for (y = 0; y < height; y++) {
+                for (x = 0; x < width; x++) {
+                    Y[y * width + x] = x + y + indx * 3;
+                }
+            }
+
+            /* Cb and Cr */
+            for (y = 0; y < height/2; y++) {
+                for (x = 0; x < width/2; x++) {
+                    U[y * width/2 + x] = 128 + y + indx * 2;
+                    V[y * width/2 + x] = 64 + x + indx * 5;
+                }
+            }
+        }
+        break;
+    }
+}
 
-  case 1:
+static int is_optstr(const char *options)
+{
+    if (strchr(options, 'm')) return 1;
+    if (strchr(options, 'h')) return 1;
+    if (strchr(options, '=')) return 1;
+    return 0;
+}
 
-      for(n=0; n<height*width; n=n+2) {
-	  buffer[n*3]   = 255;
-	  buffer[n*3+1] = 255;
-	  buffer[n*3+2] = 255;
-      }
+/*************************************************************************/
 
-      break;
+/* Module interface routines and data. */
 
-  case 2:  //red picture
+/*************************************************************************/
 
-    for(n=0; n<height*width; ++n) {
-      buffer[n*3]   = 255;
-      buffer[n*3+1] = 0;
-      buffer[n*3+2] = 0;
-    }
-    break;
+/**
+ * testframe_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  case 3:  //green picture
+TC_MODULE_GENERIC_INIT(testframe, TestframePrivateData)
 
-    for(n=0; n<height*width; ++n) {
-      buffer[n*3]   = 0;
-      buffer[n*3+1] = 255;
-      buffer[n*3+2] = 0;
-    }
-    break;
-  case 4:  //blue
+/*************************************************************************/
 
-    for(n=0; n<height*width; ++n) {
-      buffer[n*3]   = 0;
-      buffer[n*3+1] = 0;
-      buffer[n*3+2] = 255;
-    }
-    break;
-  }
-}
+/**
+ * testframe_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-static void generate_yuv_frame(char *buffer, int width, int height)
-{
-  int n, j, row_bytes;
+TC_MODULE_GENERIC_FINI(testframe)
 
-  row_bytes = width;
+/*************************************************************************/
 
-  memset(buffer, 0x80, width*height*3/2);
+/**
+ * testframe_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  switch(mode) {
+static int testframe_configure(TCModuleInstance *self,
+                               const char *options,
+                               TCJob *vob,
+                               TCModuleExtraData *xdata[])
+{
+    TestframePrivateData *pd = NULL;
 
-  case 0:
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
 
-      for(n=0; n<height; ++n) {
+    pd = self->userdata;
+    pd->mode  = 0;
+    pd->codec = vob->im_v_codec;
 
-	  if(n & 1) {
-	      for(j=0; j<row_bytes; ++j) buffer[n*row_bytes+j]   = 255;
-	  } else {
-	      for(j=0; j<row_bytes; ++j) buffer[n*row_bytes+j]   = 0;
-	  }
-      }
+    if (verbose)
+        tc_log_info(MOD_NAME, "options=%s", options);
 
-      break;
+    if (options) {
+        if (is_optstr(options)) {
+            optstr_get(options, "mode", "%d", &pd->mode);
+        } else {
+            sscanf(options, "%d", &pd->mode);
+        }
+    }
 
-  case 1:
+    if (pd->mode < 0) {
+        tc_log_error(MOD_NAME, "Invalid mode");
+        return TC_ERROR;
+    }
+    return TC_OK;
+}
 
-      for(n=0; n<height*width; ++n) buffer[n]=(n&1)?255:0;
+/*************************************************************************/
 
-      break;
+/**
+ * testframe_stop:  Reset this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-  case 5: // from libavformat
-      {
-	  static int indx = 0;
-	  int x, y;
-	  unsigned char
-	      *Y = buffer,
-	      *U = Y + width*height,
-	      *V = U + (width/2)*(height/2);
+static int testframe_stop(TCModuleInstance *self)
+{
+    TC_MODULE_SELF_CHECK(self, "stop");
+    return TC_OK;
+}
 
-	  for(y=0;y<height;y++) {
-	      for(x=0;x<width;x++) {
-		  Y[y * width + x] = x + y + indx * 3;
-	      }
-	  }
+/*************************************************************************/
 
-	  /* Cb and Cr */
-	  for(y=0;y<height/2;y++) {
-	      for(x=0;x<width/2;x++) {
-		  U[y * width/2 + x] = 128 + y + indx * 2;
-		  V[y * width/2 + x] = 64 + x + indx * 5;
-	      }
-	  }
-	  indx++;
-      }
-      break;
-  }
-}
+/**
+ * testframe_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
 
+static int testframe_inspect(TCModuleInstance *self,
+                             const char *param, const char **value)
+{
+    TestframePrivateData *pd = NULL;
 
-/*-------------------------------------------------
- *
- * single function interface
- *
- *-------------------------------------------------*/
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
+    pd = self->userdata;
 
-static int is_optstr(char *options)
-{
-    if (strchr(options, 'm')) return 1;
-    if (strchr(options, 'h')) return 1;
-    if (strchr(options, '=')) return 1;
-    return 0;
+    if (optstr_lookup(param, "help")) {
+        *value = testframe_help;
+    }
+    if (optstr_lookup(param, "mode")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->mode);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
+/**
+ * testframe_filter_video:  overwrite the given frame with the test
+ * pattern.  See tcmodule-data.h for function details.
+ */
 
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, "Thomas Oestreich", "VRYE", "1");
-      optstr_param (options, "mode",   "Choose the test pattern (0-4 interlaced, 5 colorfull)", "%d", "0", "0", "5");
-  }
+static int testframe_filter_video(TCModuleInstance *self,
+                                  vframe_list_t *frame)
+{
+    TestframePrivateData *pd = NULL;
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
 
-  if(ptr->tag & TC_FILTER_INIT) {
+    pd = self->userdata;
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
 
-    // filter init ok.
+    if (pd->codec == TC_CODEC_RGB24) {
+        generate_rgb_frame(frame->video_buf, frame->v_width,
+                           frame->v_height, pd->mode);
+    } else {
+        generate_yuv_frame(frame->video_buf, frame->v_width,
+                           frame->v_height, pd->mode, frame->id);
+    }
+    return TC_OK;
+}
 
-    if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
+/*************************************************************************/
 
-    if(verbose) tc_log_info(MOD_NAME, "options=%s", options);
+static const TCCodecID testframe_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID testframe_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(testframe);
+TC_MODULE_FILTER_FORMATS(testframe);
 
-    if (options) {
-	if (is_optstr(options)) {
-	    optstr_get(options, "mode", "%d", &mode);
-	} else
-	    sscanf(options, "%d", &mode);
-    }
+TC_MODULE_INFO(testframe);
 
-    if(mode <0) { tc_log_error(MOD_NAME, "Invalid mode"); return(-1); }
+static const TCModuleClass testframe_class = {
+    TC_MODULE_CLASS_HEAD(testframe),
 
-    return(0);
-  }
+    .init         = testframe_init,
+    .fini         = testframe_fini,
+    .configure    = testframe_configure,
+    .stop         = testframe_stop,
+    .inspect      = testframe_inspect,
 
-  //----------------------------------
-  //
-  // filter close
-  //
-  //----------------------------------
+    .filter_video = testframe_filter_video
+};
 
-  if(ptr->tag & TC_FILTER_CLOSE) {
-    return(0);
-  }
+TC_MODULE_ENTRY_POINT(testframe)
 
-  //----------------------------------
-  //
-  // filter frame routine
-  //
-  //----------------------------------
+/*************************************************************************/
+
+static int testframe_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
 
-  // tag variable indicates, if we are called before
-  // transcodes internal video/audo frame processing routines
-  // or after and determines video/audio context
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRYE", "1");
+    optstr_param(options, "mode", "Choose the test pattern"
+                 " (0-4 interlaced, 5 colorfull)", "%d", "0", "0", "5");
+    return TC_OK;
+}
 
-  if(ptr->tag & TC_PRE_M_PROCESS && ptr->tag & TC_VIDEO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
+static int testframe_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
 
-    if(vob->im_v_codec==TC_CODEC_RGB24) {
-      generate_rgb_frame(ptr->video_buf, ptr->v_width, ptr->v_height);
-    } else {
-      generate_yuv_frame(ptr->video_buf, ptr->v_width, ptr->v_height);
+    if (frame->tag & TC_PRE_M_PROCESS && frame->tag & TC_VIDEO) {
+        return testframe_filter_video(self, (vframe_list_t*)frame);
     }
-  }
-  return(0);
+    return TC_OK;
 }
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(testframe)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
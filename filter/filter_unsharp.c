@@ -18,34 +18,82 @@
 */
 
 #define MOD_NAME      "filter_unsharp.so"
-#define MOD_VERSION   "v1.0.1 (2003-10-27)"
+#define MOD_VERSION   "v1.1.0 (2026-10-18)"
 #define MOD_CAP       "unsharp mask & gaussian blur"
 #define MOD_AUTHOR    "Rmi Guyomarch"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_SLICE_PARALLEL
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
+#include "libtcmodule/tcmodule-slice.h"
 
 #include <math.h>
 
 
+static const char unsharp_help[] = ""
+    "Overview\n"
+    "    This filter blurs or sharpens an image depending on\n"
+    "    the sign of \"amount\". You can either set amount for\n"
+    "    both luma and chroma or you can set it individually\n"
+    "    (recommended). A positive value for amount will sharpen\n"
+    "    the image, a negative value will blur it. A sane range\n"
+    "    for amount is -1.5 to 1.5.\n"
+    "    The matrix sizes must be odd and define the\n"
+    "    range/strength of the effect. Sensible ranges are 3x3\n"
+    "    to 7x7.\n"
+    "    It sometimes makes sense to sharpen the sharpen the\n"
+    "    luma and to blur the chroma. Sample string is:\n"
+    "\n"
+    "    luma=0.8:luma_matrix=7x5:chroma=-0.2:chroma_matrix=3x3\n"
+    "\n"
+    "Options\n"
+    "    amount         Luma and chroma (un)sharpness amount [0.00]\n"
+    "    matrix         Luma and chroma search matrix size [0x0]\n"
+    "    luma           Luma (un)sharpness amount [0.00]\n"
+    "    chroma         Chroma (un)sharpness amount [0.00]\n"
+    "    luma_matrix    Luma search matrix size [0x0]\n"
+    "    chroma_matrix  Chroma search matrix size [0x0]\n"
+    "    pre            run as a pre filter [0]\n";
+
 //===========================================================================//
 
 #define MIN_MATRIX_SIZE 3
 #define MAX_MATRIX_SIZE 63
 
+typedef uint32_t *FilterState[MAX_MATRIX_SIZE-1];
+
 typedef struct FilterParam {
     int msizeX, msizeY;
     double amount;
-    uint32_t *SC[MAX_MATRIX_SIZE-1];
+    int slots;
+    FilterState *SC;    /* one set of column states per slice slot */
 } FilterParam;
 
-typedef struct vf_priv_s {
+typedef struct UnsharpPlane {
+    uint8_t *dst, *src;
+    int dstStride, srcStride;
+    int width, height;
+    FilterParam *fp;
+} UnsharpPlane;
+
+/* The slot column states and the source copy are shared by the frames,
+ * so the frames are taken one at a time, each split in bands of rows. */
+
+typedef struct UnsharpPrivateData_ {
     FilterParam lumaParam;
     FilterParam chromaParam;
     int pre;
-} MyFilterData;
+    uint8_t *buffer;    /* copy of the source frame */
+
+    char opt_buf[TC_BUF_MIN];
+} UnsharpPrivateData;
 
 
 //===========================================================================//
@@ -60,36 +108,34 @@ Originally published Boston, Nov 98
 
 */
 
-static void unsharp( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height, FilterParam *fp ) {
-
-    uint32_t **SC = fp->SC;
+/*
+ * The filter is a FIR one, so a band of rows can be computed on its own:
+ * it just needs to start stepsY rows early (with the source clamped at
+ * the frame borders, as the full frame version does) to prime the column
+ * states, and to run stepsY rows past its end.
+ */
+static void unsharpRows(void *data, int first, int last, int slot) {
+
+    UnsharpPlane *P = data;
+    FilterParam *fp = P->fp;
+    uint32_t **SC = fp->SC[slot];
     uint32_t SR[MAX_MATRIX_SIZE-1], Tmp1, Tmp2;
-    uint8_t* src2 = src; // avoid gcc warning
+    uint8_t *src2;
 
     int32_t res;
     int x, y, z;
+    int width = P->width;
     int amount = fp->amount * 65536.0;
     int stepsX = fp->msizeX/2;
     int stepsY = fp->msizeY/2;
     int scalebits = (stepsX+stepsY)*2;
     int32_t halfscale = 1 << ((stepsX+stepsY)*2-1);
 
-    if( !fp->amount ) {
-	if( src == dst )
-	    return;
-	if( dstStride == srcStride )
-	    ac_memcpy( dst, src, srcStride*height );
-	else
-	    for( y=0; y<height; y++, dst+=dstStride, src+=srcStride )
-		ac_memcpy( dst, src, width );
-	return;
-    }
-
     for( y=0; y<2*stepsY; y++ )
 	memset( SC[y], 0, sizeof(SC[y][0]) * (width+2*stepsX) );
 
-    for( y=-stepsY; y<height+stepsY; y++ ) {
-	if( y < height ) src2 = src;
+    for( y=first-stepsY; y<last+stepsY; y++ ) {
+	src2 = P->src + TC_CLAMP(y, 0, P->height-1) * P->srcStride;
 	memset( SR, 0, sizeof(SR[0]) * (2*stepsX-1) );
 	for( x=-stepsX; x<width+stepsX; x++ ) {
 	    Tmp1 = x<=0 ? src2[0] : x>=width ? src2[width-1] : src2[x];
@@ -101,243 +147,400 @@ static void unsharp( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, i
 		Tmp2 = SC[z+0][x+stepsX] + Tmp1; SC[z+0][x+stepsX] = Tmp1;
 		Tmp1 = SC[z+1][x+stepsX] + Tmp2; SC[z+1][x+stepsX] = Tmp2;
 	    }
-	    if( x>=stepsX && y>=stepsY ) {
-		uint8_t* srx = src - stepsY*srcStride + x - stepsX;
-		uint8_t* dsx = dst - stepsY*dstStride + x - stepsX;
+	    if( x>=stepsX && y>=first+stepsY ) {
+		uint8_t* srx = P->src + (y-stepsY)*P->srcStride + x - stepsX;
+		uint8_t* dsx = P->dst + (y-stepsY)*P->dstStride + x - stepsX;
 
 		res = (int32_t)*srx + ( ( ( (int32_t)*srx - (int32_t)((Tmp1+halfscale) >> scalebits) ) * amount ) >> 16 );
 		*dsx = res>255 ? 255 : res<0 ? 0 : (uint8_t)res;
 	    }
 	}
-	if( y >= 0 ) {
-	    dst += dstStride;
-	    src += srcStride;
-	}
     }
 }
 
-//===========================================================================//
+static void unsharp( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height, FilterParam *fp ) {
 
-static void help_optstr(void)
-{
-    tc_log_info (MOD_NAME, "(%s) help\n"
-"* Overview\n"
-"  This filter blurs or sharpens an image depending on\n"
-"  the sign of \"amount\". You can either set amount for\n"
-"  both luma and chroma or you can set it individually\n"
-"  (recommended). A positive value for amount will sharpen\n"
-"  the image, a negative value will blur it. A sane range\n"
-"  for amount is -1.5 to 1.5.\n"
-"  The matrix sizes must be odd and define the\n"
-"  range/strength of the effect. Sensible ranges are 3x3\n"
-"  to 7x7.\n"
-"  It sometimes makes sense to sharpen the sharpen the\n"
-"  luma and to blur the chroma. Sample string is:\n"
-"\n"
-"  luma=0.8:luma_matrix=7x5:chroma=-0.2:chroma_matrix=3x3\n"
-"\n"
-"* Options\n"
-"         amount : Luma and chroma (un)sharpness amount (%f)\n"
-"         matrix : Luma and chroma search matrix size (%dx%d)\n"
-"           luma : Luma (un)sharpness amount (%02.2f)\n"
-"         chroma : Chroma (un)sharpness amount (%02.2f)\n"
-"    luma_matrix : Luma search matrix size (%dx%d)\n"
-"  chroma_matrix : Chroma search matrix size (%dx%d)\n"
-"              pre : run as a pre filter (0)\n"
-		 , MOD_CAP,
-		 0.0,
-		 0, 0,
-		 0.0,
-		 0.0,
-		 0, 0,
-		 0, 0);
+    UnsharpPlane P;
+    int y;
+
+    if( !fp->amount ) {
+	if( src == dst )
+	    return;
+	if( dstStride == srcStride )
+	    ac_memcpy( dst, src, srcStride*height );
+	else
+	    for( y=0; y<height; y++, dst+=dstStride, src+=srcStride )
+		ac_memcpy( dst, src, width );
+	return;
+    }
+
+    P.dst = dst;
+    P.src = src;
+    P.dstStride = dstStride;
+    P.srcStride = srcStride;
+    P.width = width;
+    P.height = height;
+    P.fp = fp;
+
+    /* each band recomputes 2*stepsY rows: keep the bands tall enough */
+    tc_module_slice_run(unsharpRows, &P, height, 4*fp->msizeY);
+}
+
+static void freeParam( FilterParam *fp ) {
+
+    int slot, z;
+
+    if( !fp->SC )
+	return;
+    for( slot=0; slot<fp->slots; slot++ )
+	for( z=0; z<MAX_MATRIX_SIZE-1; z++ )
+	    tc_buffree(fp->SC[slot][z]);
+    free( fp->SC );
+    fp->SC = NULL;
+    fp->slots = 0;
+}
+
+static int allocParam( FilterParam *fp, int width ) {
+
+    int slot, z;
+    int stepsX = fp->msizeX/2;
+    int stepsY = fp->msizeY/2;
+
+    fp->slots = tc_module_slice_slots();
+    fp->SC = tc_zalloc( fp->slots * sizeof(FilterState) );
+    if( !fp->SC )
+	return -1;
+    for( slot=0; slot<fp->slots; slot++ ) {
+	for( z=0; z<2*stepsY; z++ ) {
+	    fp->SC[slot][z] = tc_bufalloc(sizeof(*(fp->SC[slot][z])) * (width+2*stepsX));
+	    if( !fp->SC[slot][z] ) {
+		freeParam(fp);
+		return -1;
+	    }
+	}
+    }
+    return 0;
 }
 
 //===========================================================================//
 
-int tc_filter(frame_list_t *ptr_, char *options)
-{
-  vframe_list_t *ptr = (vframe_list_t *)ptr_;
-  static vob_t *vob=NULL;
-  static MyFilterData *mfd=NULL;
-  static char *buffer;
+/* Module interface routines and data. */
 
-  if(ptr->tag & TC_AUDIO) return 0;
+/*************************************************************************/
 
-  if(ptr->tag & TC_FILTER_GET_CONFIG) {
+/**
+ * unsharp_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-      optstr_filter_desc (options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VYO", "1");
+TC_MODULE_GENERIC_INIT(unsharp, UnsharpPrivateData)
 
-      optstr_param (options, "amount", "Luma and chroma (un)sharpness amount", "%f", "0.0", "-2.0", "2.0" );
-      optstr_param (options, "matrix", "Luma and chroma search matrix size", "%dx%d", "0x0",
-	      "3", "63", "3", "63");
+/*************************************************************************/
 
-      optstr_param (options, "luma", "Luma (un)sharpness amount", "%f", "0.0", "-2.0", "2.0" );
+/**
+ * unsharp_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-      optstr_param (options, "chroma", "Chroma (un)sharpness amount", "%f", "0.0", "-2.0", "2.0" );
+TC_MODULE_GENERIC_FINI(unsharp)
 
-      optstr_param (options, "luma_matrix", "Luma search matrix size", "%dx%d", "0x0",
-	      "3", "63", "3", "63");
+/*************************************************************************/
 
-      optstr_param (options, "chroma_matrix", "Chroma search matrix size", "%dx%d", "0x0",
-	      "3", "63", "3", "63");
+/**
+ * unsharp_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
+ */
 
-      optstr_param (options, "pre", "run as a pre filter", "%d", "0", "0", "1" );
+static int unsharp_stop(TCModuleInstance *self)
+{
+    UnsharpPrivateData *pd = NULL;
 
-      return 0;
-  }
+    TC_MODULE_SELF_CHECK(self, "stop");
 
-  //----------------------------------
-  //
-  // filter init
-  //
-  //----------------------------------
+    pd = self->userdata;
 
+    freeParam(&pd->lumaParam);
+    freeParam(&pd->chromaParam);
+    tc_free(pd->buffer);
+    pd->buffer = NULL;
+    return TC_OK;
+}
 
-  if(ptr->tag & TC_FILTER_INIT) {
+/*************************************************************************/
 
-    int width, height;
-    int z, stepsX, stepsY;
+/**
+ * unsharp_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int unsharp_configure(TCModuleInstance *self,
+                             const char *options,
+                             TCJob *vob,
+                             TCModuleExtraData *xdata[])
+{
+    UnsharpPrivateData *pd = NULL;
+    int width;
     FilterParam *fp;
-    char *effect;
-    double amount=0.0;
-    int msizeX=0, msizeY=0;
+    const char *effect;
+    double amount = 0.0;
+    int msizeX = 0, msizeY = 0;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
 
-    if((vob = tc_get_vob())==NULL) return(-1);
+    pd = self->userdata;
 
     if (vob->im_v_codec != TC_CODEC_YUV420P) {
-	tc_log_error(MOD_NAME, "This filter is only capable of YUV 4:2:0 mode");
-	return -1;
+        tc_log_error(MOD_NAME, "This filter is only capable of YUV 4:2:0 mode");
+        return TC_ERROR;
     }
 
-    mfd   = tc_zalloc( sizeof(MyFilterData) );
-    buffer = tc_zalloc(SIZE_RGB_FRAME);
+    memset(&pd->lumaParam, 0, sizeof(FilterParam));
+    memset(&pd->chromaParam, 0, sizeof(FilterParam));
+    pd->pre = 0;
 
     // GET OPTIONS
     if (options) {
+        // l7x5:0.8:c3x3:-0.2
 
-	// l7x5:0.8:c3x3:-0.2
-
-	if (optstr_lookup (options, "help")) {
-	    help_optstr();
-	}
+        if (optstr_lookup(options, "help")) {
+            tc_log_info(MOD_NAME, "(%s) help\n%s", MOD_CAP, unsharp_help);
+        }
 
-	optstr_get (options, "amount",         "%lf",   &amount);
-	optstr_get (options, "matrix",         "%dx%d", &msizeX, &msizeY);
-	optstr_get (options, "luma",           "%lf",   &mfd->lumaParam.amount);
-	optstr_get (options, "luma_matrix",    "%dx%d", &mfd->lumaParam.msizeX, &mfd->lumaParam.msizeY);
-	optstr_get (options, "chroma",         "%lf",   &mfd->chromaParam.amount);
-	optstr_get (options, "chroma_matrix",  "%dx%d", &mfd->chromaParam.msizeX, &mfd->chromaParam.msizeY);
-	optstr_get (options, "pre",            "%d",    &mfd->pre);
+        optstr_get(options, "amount",        "%lf",   &amount);
+        optstr_get(options, "matrix",        "%dx%d", &msizeX, &msizeY);
+        optstr_get(options, "luma",          "%lf",   &pd->lumaParam.amount);
+        optstr_get(options, "luma_matrix",   "%dx%d",
+                   &pd->lumaParam.msizeX, &pd->lumaParam.msizeY);
+        optstr_get(options, "chroma",        "%lf",   &pd->chromaParam.amount);
+        optstr_get(options, "chroma_matrix", "%dx%d",
+                   &pd->chromaParam.msizeX, &pd->chromaParam.msizeY);
+        optstr_get(options, "pre",           "%d",    &pd->pre);
+
+        if (amount != 0.0 && msizeX && msizeY) {
+            msizeX = 1 | TC_CLAMP(msizeX, MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
+            msizeY = 1 | TC_CLAMP(msizeY, MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
+            pd->lumaParam.msizeX = msizeX;
+            pd->lumaParam.msizeY = msizeY;
+            pd->chromaParam.msizeX = msizeX;
+            pd->chromaParam.msizeY = msizeY;
+
+            pd->lumaParam.amount = pd->chromaParam.amount = amount;
+        } else {
+            // min/max & odd
+            pd->lumaParam.msizeX   = 1 | TC_CLAMP(pd->lumaParam.msizeX,
+                                                  MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
+            pd->lumaParam.msizeY   = 1 | TC_CLAMP(pd->lumaParam.msizeY,
+                                                  MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
+            pd->chromaParam.msizeX = 1 | TC_CLAMP(pd->chromaParam.msizeX,
+                                                  MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
+            pd->chromaParam.msizeY = 1 | TC_CLAMP(pd->chromaParam.msizeY,
+                                                  MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
+        }
+    }
 
-	if (amount!=0.0 && msizeX && msizeY) {
+    width = (pd->pre) ?vob->im_v_width :vob->ex_v_width;
 
-	    msizeX = 1 | TC_CLAMP(msizeX, MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
-	    msizeY = 1 | TC_CLAMP(msizeY, MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
-	    mfd->lumaParam.msizeX = msizeX;
-	    mfd->lumaParam.msizeY = msizeY;
-	    mfd->chromaParam.msizeX = msizeX;
-	    mfd->chromaParam.msizeY = msizeY;
+    // allocate buffers
 
-	    mfd->lumaParam.amount = mfd->chromaParam.amount = amount;
+    pd->buffer = tc_zalloc(TC_JOB_FRAME_SIZE(vob));
+    if (!pd->buffer) {
+        tc_log_error(MOD_NAME, "Malloc failed");
+        return TC_ERROR;
+    }
 
-	} else {
+    fp = &pd->lumaParam;
+    effect = fp->amount == 0 ? "don't touch" : fp->amount < 0 ? "blur" : "sharpen";
+    tc_log_info(MOD_NAME, "unsharp: %dx%d:%0.2f (%s luma)",
+                fp->msizeX, fp->msizeY, fp->amount, effect);
+    if (allocParam(fp, width) < 0) {
+        tc_log_error(MOD_NAME, "Malloc failed");
+        unsharp_stop(self);
+        return TC_ERROR;
+    }
 
-	    // min/max & odd
-	    mfd->lumaParam.msizeX   = 1 | TC_CLAMP(mfd->lumaParam.msizeX, MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
-	    mfd->lumaParam.msizeY   = 1 | TC_CLAMP(mfd->lumaParam.msizeY, MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
-	    mfd->chromaParam.msizeX = 1 | TC_CLAMP(mfd->chromaParam.msizeX, MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
-	    mfd->chromaParam.msizeY = 1 | TC_CLAMP(mfd->chromaParam.msizeY, MIN_MATRIX_SIZE, MAX_MATRIX_SIZE);
-	}
+    fp = &pd->chromaParam;
+    effect = fp->amount == 0 ? "don't touch" : fp->amount < 0 ? "blur" : "sharpen";
+    tc_log_info(MOD_NAME, "unsharp: %dx%d:%0.2f (%s chroma)",
+                fp->msizeX, fp->msizeY, fp->amount, effect);
+    if (allocParam(fp, width) < 0) {
+        tc_log_error(MOD_NAME, "Malloc failed");
+        unsharp_stop(self);
+        return TC_ERROR;
     }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * unsharp_inspect:  Return the value of an option in this instance of
+ * the module.  See tcmodule-data.h for function details.
+ */
+
+static int unsharp_inspect(TCModuleInstance *self,
+                           const char *param, const char **value)
+{
+    UnsharpPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
 
-    if (mfd->pre) {
-	width  = vob->im_v_width;
-	height = vob->im_v_height;
-    } else {
-	width  = vob->ex_v_width;
-	height = vob->ex_v_height;
+    if (optstr_lookup(param, "help")) {
+        *value = unsharp_help;
     }
+    if (optstr_lookup(param, "luma")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%f",
+                    pd->lumaParam.amount);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "chroma")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%f",
+                    pd->chromaParam.amount);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "luma_matrix")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%dx%d",
+                    pd->lumaParam.msizeX, pd->lumaParam.msizeY);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "chroma_matrix")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%dx%d",
+                    pd->chromaParam.msizeX, pd->chromaParam.msizeY);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "pre")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->pre);
+        *value = pd->opt_buf;
+    }
+    return TC_OK;
+}
 
-    // allocate buffers
+/*************************************************************************/
 
-    fp = &mfd->lumaParam;
-    effect = fp->amount == 0 ? "don't touch" : fp->amount < 0 ? "blur" : "sharpen";
-    tc_log_info(MOD_NAME, "unsharp: %dx%d:%0.2f (%s luma)",
-                    fp->msizeX, fp->msizeY, fp->amount, effect );
-    memset( fp->SC, 0, sizeof( fp->SC ) );
-    stepsX = fp->msizeX/2;
-    stepsY = fp->msizeY/2;
-    for( z=0; z<2*stepsY; z++ )
-        {
-	fp->SC[z] = tc_bufalloc(sizeof(*(fp->SC[z])) * (width+2*stepsX));
-        }
+/**
+ * unsharp_filter_video:  sharpen or blur the given frame.  See
+ * tcmodule-data.h for function details.
+ */
 
-    fp = &mfd->chromaParam;
-    effect = fp->amount == 0 ? "don't touch" : fp->amount < 0 ? "blur" : "sharpen";
-    tc_log_info(MOD_NAME, "unsharp: %dx%d:%0.2f (%s chroma)",
-                    fp->msizeX, fp->msizeY, fp->amount, effect );
-    memset( fp->SC, 0, sizeof( fp->SC ) );
-    stepsX = fp->msizeX/2;
-    stepsY = fp->msizeY/2;
-    for( z=0; z<2*stepsY; z++ )
-        {
-	fp->SC[z] = tc_bufalloc(sizeof(*(fp->SC[z])) * (width+2*stepsX));
-        }
+static int unsharp_filter_video(TCModuleInstance *self, vframe_list_t *frame)
+{
+    UnsharpPrivateData *pd = NULL;
+    int off, h2, w2;
 
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
 
-    if(verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-    return 0;
-  }
+    pd = self->userdata;
 
+    if (frame->attributes & TC_FRAME_IS_SKIPPED)
+        return TC_OK;
+    if (!pd->lumaParam.msizeX && !pd->chromaParam.msizeX)
+        return TC_OK; // nothing to do
 
-  if (ptr->tag & TC_FILTER_CLOSE) {
-      unsigned int z;
-      FilterParam *fp;
+    off = frame->v_width * frame->v_height;
+    h2  = frame->v_height>>1;
+    w2  = frame->v_width>>1;
 
-      if( !mfd ) return -1;
+    ac_memcpy(pd->buffer, frame->video_buf, frame->video_size);
 
-      fp = &mfd->lumaParam;
-      for( z=0; z<sizeof(fp->SC)/sizeof(fp->SC[0]); z++ ) {
-          tc_buffree(fp->SC[z]);
-	  fp->SC[z] = NULL;
-      }
-      fp = &mfd->chromaParam;
-      for( z=0; z<sizeof(fp->SC)/sizeof(fp->SC[0]); z++ ) {
-          tc_buffree(fp->SC[z]);
-	  fp->SC[z] = NULL;
-      }
+    unsharp(frame->video_buf, pd->buffer,
+            frame->v_width, frame->v_width, frame->v_width, frame->v_height,
+            &pd->lumaParam);
+    unsharp(frame->video_buf+off, pd->buffer+off,
+            w2, w2, w2, h2, &pd->chromaParam);
+    unsharp(frame->video_buf+5*off/4, pd->buffer+5*off/4,
+            w2, w2, w2, h2, &pd->chromaParam);
 
-      free( mfd );
-      mfd = NULL;
-      return 0;
-  }
+    return TC_OK;
+}
 
+/*************************************************************************/
 
-  if( mfd && !mfd->lumaParam.msizeX && !mfd->chromaParam.msizeX ) {
-      return 0; // nothing to do
-  }
+static const TCCodecID unsharp_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+static const TCCodecID unsharp_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(unsharp);
+TC_MODULE_FILTER_FORMATS(unsharp);
 
+TC_MODULE_INFO(unsharp);
 
-  if(((ptr->tag & TC_PRE_M_PROCESS  && mfd->pre) ||
-	  (ptr->tag & TC_POST_M_PROCESS && !mfd->pre)) &&
-	  !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
+static const TCModuleClass unsharp_class = {
+    TC_MODULE_CLASS_HEAD(unsharp),
 
-      int off = ptr->v_width * ptr->v_height;
-      int h2  = ptr->v_height>>1, w2 = ptr->v_width>>1;
+    .init         = unsharp_init,
+    .fini         = unsharp_fini,
+    .configure    = unsharp_configure,
+    .stop         = unsharp_stop,
+    .inspect      = unsharp_inspect,
 
-      ac_memcpy (buffer, ptr->video_buf, ptr->video_size);
+    .filter_video = unsharp_filter_video
+};
 
-      unsharp( ptr->video_buf, buffer, ptr->v_width, ptr->v_width, ptr->v_width,   ptr->v_height,   &mfd->lumaParam );
+TC_MODULE_ENTRY_POINT(unsharp)
 
-      unsharp( ptr->video_buf+off, buffer+off, w2, w2, w2, h2, &mfd->chromaParam );
+/*************************************************************************/
 
-      unsharp( ptr->video_buf+5*off/4, buffer+5*off/4, w2, w2, w2, h2, &mfd->chromaParam );
+static int unsharp_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VYO", "1");
+    optstr_param(options, "amount", "Luma and chroma (un)sharpness amount",
+                 "%f", "0.0", "-2.0", "2.0");
+    optstr_param(options, "matrix", "Luma and chroma search matrix size",
+                 "%dx%d", "0x0", "3", "63", "3", "63");
+    optstr_param(options, "luma", "Luma (un)sharpness amount",
+                 "%f", "0.0", "-2.0", "2.0");
+    optstr_param(options, "chroma", "Chroma (un)sharpness amount",
+                 "%f", "0.0", "-2.0", "2.0");
+    optstr_param(options, "luma_matrix", "Luma search matrix size",
+                 "%dx%d", "0x0", "3", "63", "3", "63");
+    optstr_param(options, "chroma_matrix", "Chroma search matrix size",
+                 "%dx%d", "0x0", "3", "63", "3", "63");
+    optstr_param(options, "pre", "run as a pre filter",
+                 "%d", "0", "0", "1");
+    return TC_OK;
+}
 
-      return 0;
-  }
+static int unsharp_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    UnsharpPrivateData *pd = NULL;
 
-  return 0;
+    TC_MODULE_SELF_CHECK(self, "process");
 
-} // tc_filter
+    pd = self->userdata;
 
+    if (!(frame->tag & TC_VIDEO))
+        return TC_OK;
+    if ((frame->tag & TC_PRE_M_PROCESS  && pd->pre)
+     || (frame->tag & TC_POST_M_PROCESS && !pd->pre)) {
+        return unsharp_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(unsharp)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -25,14 +25,20 @@
 */
 
 #define MOD_NAME    "filter_whitebalance.so"
-#define MOD_VERSION "v0.1 (2003-10-01)"
+#define MOD_VERSION "v0.2 (2026-10-18)"
 #define MOD_CAP     "White Balance Filter - correct images with a broken white balance"
 #define MOD_AUTHOR  "Guillaume Cottenceau"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_FRAME_PARALLEL
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include "libtcvideo/tcvideo.h"
 
@@ -40,156 +46,340 @@
 #include <ctype.h>
 
 
-static TCVHandle tcvhandle = 0;
-static unsigned char * buffer = NULL;
-static int level = 40;
-static char limit[PATH_MAX];
+static const char whitebalance_help[] = ""
+    "Overview\n"
+    "    Corrects images with a broken white balance, shifting the\n"
+    "    red and blue curves.\n"
+    "Options\n"
+    "    level  Level of blue-to-yellow white balance shifting\n"
+    "           (can be negative) [40]\n"
+    "    limit  Limit to specified ranges (+fnumber toggles on,\n"
+    "           -fnumber toggles off) []\n";
+
+/* Most frame numbers in the `limit' option. */
+#define MAX_SWITCHES    64
+
+/*************************************************************************/
+
+typedef struct WhitebalancePrivateData_ {
+    TCVHandle tcvhandle;    /* only for YUV input */
+    int yuv;
+    int level;
+    char limit[PATH_MAX];
+
+    /* frames where the filter is switched off, on, off... in order */
+    int switches[MAX_SWITCHES];
+    int nswitches;
+
+    uint8_t red_filter[256];
+    uint8_t blue_filter[256];
+
+    char opt_buf[TC_BUF_MIN];
+} WhitebalancePrivateData;
+
+/*************************************************************************/
+
+/* Parse the `limit' option: starting from the filter on, look for the
+ * next -frame (switch off), then for the next +frame (switch on) and so
+ * on. */
+
+static void parse_switches(WhitebalancePrivateData *pd)
+{
+    const char *ptr = pd->limit;
+    int state = 1;
+
+    pd->nswitches = 0;
+    while (pd->nswitches < MAX_SWITCHES) {
+        int next = 0;
+
+        ptr = strchr(ptr, state ? '-' : '+');
+        if (!ptr)
+            break;
+        ptr++;
+        while (*ptr && isdigit(*ptr)) {
+            next = (next * 10) + (*ptr - '0');
+            ptr++;
+        }
+        pd->switches[pd->nswitches++] = next;
+        state = !state;
+    }
+}
+
+/* Is the filter on for the given frame?  Frames come in increasing order,
+ * so a switch at an earlier frame than the one before it never happens. */
+
+static int filter_is_on(const WhitebalancePrivateData *pd, int id)
+{
+    int i, state = 1;
+
+    for (i = 0; i < pd->nswitches; i++) {
+        if (pd->switches[i] > id
+         || (i > 0 && pd->switches[i] <= pd->switches[i-1]))
+            break;
+        state = !state;
+    }
+    return state;
+}
+
+/*************************************************************************/
+
+/* Module interface routines and data. */
+
+/*************************************************************************/
+
+/**
+ * whitebalance_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+TC_MODULE_GENERIC_INIT(whitebalance, WhitebalancePrivateData)
+
+/*************************************************************************/
+
+/**
+ * whitebalance_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-static double factor;
-static int state = 1;
-static int next_switchoff = -1;
-static int next_switchon = -1;
+TC_MODULE_GENERIC_FINI(whitebalance)
 
-static void update_switches(void)
+/*************************************************************************/
+
+/**
+ * whitebalance_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int whitebalance_configure(TCModuleInstance *self,
+                                  const char *options,
+                                  TCJob *vob,
+                                  TCModuleExtraData *xdata[])
 {
-	static char * ptr = limit;
-	int next = 0;
-	if (!ptr)
-		return;
-
-	ptr = strchr(ptr, state ? '-' : '+');
-	if (ptr) {
-		ptr++;
-		while (*ptr && isdigit(*ptr)) {
-			next = (next * 10) + (*ptr - '0');
-			ptr++;
-		}
-	} else {
-		next = -1;
-		ptr = NULL;
-		return;
-	}
-	if (state)
-		next_switchoff = next;
-	else
-		next_switchon = next;
+    WhitebalancePrivateData *pd = NULL;
+    double factor;
+    int i;
+
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+    pd->tcvhandle = NULL;
+    pd->level = 40;
+    memset(pd->limit, 0, sizeof(pd->limit));
+
+    if (options != NULL) {
+        if (verbose)
+            tc_log_info(MOD_NAME, "options=%s", options);
+        optstr_get(options, "level", "%d", &pd->level);
+        optstr_get(options, "limit", "%[^:]", pd->limit);
+    }
+    if (verbose)
+        tc_log_info(MOD_NAME, "options set to: level=%d limit=%s",
+                    pd->level, pd->limit);
+
+    factor = 1 + ((double)abs(pd->level))/100;
+    if (pd->level < 0)
+        factor = 1/factor;
+    /* preprocess filters for performance */
+    for (i = 0; i <= 255; i++) {
+        pd->red_filter[i]  = pow(((double) i)/255, 1/factor) * 255;
+        pd->blue_filter[i] = pow(((double) i)/255, factor)   * 255;
+    }
+    parse_switches(pd);
+
+    pd->yuv = (vob->im_v_codec == TC_CODEC_YUV420P);
+    if (pd->yuv) {
+        if (verbose)
+            tc_log_warn(MOD_NAME, "will need to convert YUV to RGB"
+                        " before filtering");
+        /* only used for conversions between distinct buffers, which
+         * keep no state in the handle: shared by all the frames */
+        pd->tcvhandle = tcv_init();
+        if (!pd->tcvhandle) {
+            tc_log_error(MOD_NAME, "image conversion init failed");
+            return TC_ERROR;
+        }
+    }
+    return TC_OK;
 }
 
-int tc_filter(frame_list_t *ptr_, char *options)
+/*************************************************************************/
+
+/**
+ * whitebalance_stop:  Reset this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
+
+static int whitebalance_stop(TCModuleInstance *self)
 {
-	vframe_list_t *ptr = (vframe_list_t *)ptr_;
-	static vob_t *vob = NULL;
-	static unsigned char red_filter[256];
-	static unsigned char blue_filter[256];
-
-	if (ptr->tag & TC_FILTER_GET_CONFIG) {
-		char buf[32];
-		optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION, MOD_AUTHOR, "VRYE", "1");
-
-		tc_snprintf(buf, 32, "%d", level);
-		optstr_param(options, "level", "Level of blue-to-yellow white balance shifting (can be negative)", "%d", buf, "-1000", "+1000");
-		optstr_param(options, "limit", "Limit to specified ranges (+fnumber toggles on, -fnumber toggles off)", "%s", "");
-		return 0;
-	}
-
-	if (ptr->tag & TC_FILTER_INIT) {
-		unsigned int width, height;
-		int i;
-
-		if (verbose) tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-
-		if (!(vob = tc_get_vob())) {
-			tc_log_error(MOD_NAME, "Could not get vob");
-			return -1;
-		}
-
-		width  = vob->im_v_width;
-		height = vob->im_v_height;
-
-		if (options != NULL) {
-			if (verbose) tc_log_info(MOD_NAME, "options=%s", options);
-
-			optstr_get(options, "level", "%d", &level);
-			memset(limit, 0, PATH_MAX);
-			optstr_get(options, "limit", "%[^:]", limit);
-		}
-		if (verbose) tc_log_info(MOD_NAME, "options set to: level=%d limit=%s", level, limit);
-		factor = 1 + ((double)abs(level))/100;
-		if (level < 0)
-			factor = 1/factor;
-		/* preprocess filters for performance */
-		for (i=0; i<=255; i++) {
-			red_filter[i]  = pow(((double) i)/255, 1/factor) * 255;
-			blue_filter[i] = pow(((double) i)/255, factor)   * 255;
-		}
-		update_switches();
-
-		if (vob->im_v_codec == TC_CODEC_YUV420P) {
-			if (verbose) tc_log_warn(MOD_NAME, "will need to convert YUV to RGB before filtering");
-			if (!(tcvhandle = tcv_init())) {
-				tc_log_error(MOD_NAME, "image conversion init failed");
-				return -1;
-			}
-		}
-
-		if (!buffer)
-			buffer = tc_malloc(SIZE_RGB_FRAME);
-		if (!buffer) {
-			tc_log_error(MOD_NAME, "Could not allocate %d bytes",
-				     SIZE_RGB_FRAME);
-			return -1;
-		}
-
-		return 0;
-	}
-
-	if (ptr->tag & TC_FILTER_CLOSE) {
-		if (buffer)
-			free(buffer);
-		buffer = NULL;
-
-		return 0;
-	}
-
-	if (ptr->tag & TC_PRE_M_PROCESS && ptr->tag & TC_VIDEO && !(ptr->attributes & TC_FRAME_IS_SKIPPED)) {
-		int x, y;
-
-		if (!state && ptr->id == next_switchon) {
-			state = 1;
-			update_switches();
-		} else if (state && ptr->id == next_switchoff) {
-			state = 0;
-			update_switches();
-		}
-
-		if (state) {
-			if (vob->im_v_codec == TC_CODEC_YUV420P)
-				tcv_convert(tcvhandle,
-					    ptr->video_buf, ptr->video_buf,
-					    ptr->v_width, ptr->v_height,
-					    IMG_YUV_DEFAULT, IMG_RGB24);
-			ac_memcpy(buffer, ptr->video_buf, ptr->v_width*ptr->v_height*3);
-
-
-			for (y = 0; y < vob->im_v_height; y++) {
-				unsigned char * line = &buffer[y * (vob->im_v_width * 3)];
-				for (x = 0; x < vob->im_v_width*3; x += 3) {
-					/* we modify red and blue curves to enhance/reduce mostly mediums */
-					line[x]   = red_filter[line[x]];
-					line[x+2] = blue_filter[line[x+2]];
-				}
-			}
-
-
-			ac_memcpy(ptr->video_buf, buffer, ptr->v_width*ptr->v_height*3);
-			if (vob->im_v_codec == TC_CODEC_YUV420P)
-				tcv_convert(tcvhandle,
-					    ptr->video_buf, ptr->video_buf,
-					    ptr->v_width, ptr->v_height,
-					    IMG_RGB24, IMG_YUV_DEFAULT);
-		}
-	}
-
-	return 0;
+    WhitebalancePrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+    if (pd->tcvhandle) {
+        tcv_free(pd->tcvhandle);
+        pd->tcvhandle = NULL;
+    }
+    return TC_OK;
 }
 
+/*************************************************************************/
+
+/**
+ * whitebalance_inspect:  Return the value of an option in this instance
+ * of the module.  See tcmodule-data.h for function details.
+ */
+
+static int whitebalance_inspect(TCModuleInstance *self,
+                                const char *param, const char **value)
+{
+    WhitebalancePrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
+
+    pd = self->userdata;
+
+    if (optstr_lookup(param, "help")) {
+        *value = whitebalance_help;
+    }
+    if (optstr_lookup(param, "level")) {
+        tc_snprintf(pd->opt_buf, sizeof(pd->opt_buf), "%i", pd->level);
+        *value = pd->opt_buf;
+    }
+    if (optstr_lookup(param, "limit")) {
+        *value = pd->limit;
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/**
+ * whitebalance_filter_video:  correct the white balance of the given
+ * frame.  See tcmodule-data.h for function details.
+ */
+
+static int whitebalance_filter_video(TCModuleInstance *self,
+                                     vframe_list_t *frame)
+{
+    WhitebalancePrivateData *pd = NULL;
+    uint8_t *rgb = NULL;
+    int i, size;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(frame, "filter_video");
+
+    pd = self->userdata;
+
+    if (frame->attributes & TC_FRAME_IS_SKIPPED
+     || !filter_is_on(pd, frame->id))
+        return TC_OK;
+
+    size = frame->v_width * frame->v_height * 3;
+    if (pd->yuv) {
+        rgb = tc_malloc(size);
+        if (!rgb) {
+            tc_log_error(MOD_NAME, "Could not allocate %d bytes", size);
+            return TC_ERROR;
+        }
+        tcv_convert(pd->tcvhandle, frame->video_buf, rgb,
+                    frame->v_width, frame->v_height,
+                    IMG_YUV_DEFAULT, IMG_RGB24);
+    } else {
+        rgb = frame->video_buf;
+    }
+
+    /* we modify red and blue curves to enhance/reduce mostly mediums */
+    for (i = 0; i < size; i += 3) {
+        rgb[i]   = pd->red_filter[rgb[i]];
+        rgb[i+2] = pd->blue_filter[rgb[i+2]];
+    }
+
+    if (pd->yuv) {
+        tcv_convert(pd->tcvhandle, rgb, frame->video_buf,
+                    frame->v_width, frame->v_height,
+                    IMG_RGB24, IMG_YUV_DEFAULT);
+        tc_free(rgb);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID whitebalance_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID whitebalance_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(whitebalance);
+TC_MODULE_FILTER_FORMATS(whitebalance);
+
+TC_MODULE_INFO(whitebalance);
+
+static const TCModuleClass whitebalance_class = {
+    TC_MODULE_CLASS_HEAD(whitebalance),
+
+    .init         = whitebalance_init,
+    .fini         = whitebalance_fini,
+    .configure    = whitebalance_configure,
+    .stop         = whitebalance_stop,
+    .inspect      = whitebalance_inspect,
+
+    .filter_video = whitebalance_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(whitebalance)
+
+/*************************************************************************/
+
+static int whitebalance_get_config(TCModuleInstance *self, char *options)
+{
+    WhitebalancePrivateData *pd = NULL;
+    char buf[32];
+
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    pd = self->userdata;
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP, MOD_VERSION,
+                       MOD_AUTHOR, "VRYE", "1");
+    tc_snprintf(buf, sizeof(buf), "%d", pd->level);
+    optstr_param(options, "level", "Level of blue-to-yellow white balance"
+                 " shifting (can be negative)", "%d", buf,
+                 "-1000", "+1000");
+    optstr_param(options, "limit", "Limit to specified ranges (+fnumber"
+                 " toggles on, -fnumber toggles off)", "%s", "");
+    return TC_OK;
+}
+
+static int whitebalance_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    if (frame->tag & TC_PRE_M_PROCESS && frame->tag & TC_VIDEO) {
+        return whitebalance_filter_video(self, (vframe_list_t*)frame);
+    }
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(whitebalance)
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -36,7 +36,8 @@
 #define MOD_FEATURES \
     TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
 #define MOD_FLAGS \
-    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_BUFFERING|TC_MODULE_FLAG_CONVERSION
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_BUFFERING|\
+    TC_MODULE_FLAG_CONVERSION|TC_MODULE_FLAG_SLICE_PARALLEL
     // XXX
 
 /* -------------------------------------------------
@@ -50,6 +51,7 @@
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
 #include "libtcmodule/tcmodule-plugin.h"
+#include "libtcmodule/tcmodule-slice.h"
 #include "aclib/imgconvert.h"
 
 
@@ -102,6 +104,13 @@ struct myfilterdata_ {
     uint8_t *dst_buf;
 };
 
+/* what the slice functions work on */
+typedef struct xsharpenslice_ XsharpenSlice;
+struct xsharpenslice_ {
+    XsharpenPrivateData *mfd;
+    vframe_list_t       *frame;
+};
+
 /* forward declarations */
 static int xsharpen_rgb_frame(XsharpenPrivateData *mfd,
                               vframe_list_t *frame);
@@ -306,51 +315,21 @@ static int xsharpen_inspect(TCModuleInstance *self,
 } while (0)
 
 
-static int xsharpen_rgb_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
+/* convert rows [first, last) and store their luminances */
+static void xsharpen_rgb_luma(void *data, int first, int last, int slot)
 {
-    const PixDim    width  = frame->v_width;
-    const PixDim    height = frame->v_height;
-    Pixel32         *src= NULL, *dst = NULL;
-    int             x, y;
-    int             r, g, b, R, G, B;
-    Pixel32         p, min=1000, max=-1;
-    int             luma, lumac, lumamax, lumamin, mindiff, maxdiff;
-    const int       srcpitch = frame->v_width*sizeof(Pixel32);
-    const int       dstpitch = frame->v_width*sizeof(Pixel32);
-
-    Pixel32 *dst_buf = NULL;
-    Pixel32 *src_buf = NULL;
-
-    tcv_convert(mfd->tcvhandle, frame->video_buf,
-                (uint8_t *)mfd->convertFrameIn, frame->v_width, frame->v_height,
-                IMG_RGB24, IMG_BGRA32);
-
-    src_buf = mfd->convertFrameIn;
-    dst_buf = mfd->convertFrameOut;
-
-    /* First copy through the four border lines. */
-    src = src_buf;
-    dst = dst_buf;
-    for (x = 0; x < width; x++){
-        dst[x] = src[x];
-    }
-    src = (Pixel *)((char *)src_buf + (height - 1) * srcpitch);
-    dst = (Pixel *)((char *)dst_buf + (height - 1) * dstpitch);
-    for (x = 0; x < width; x++){
-        dst[x] = src[x];
-    }
-    src = src_buf;
-    dst = dst_buf;
-    for (y = 0; y < height; y++){
-        dst[0] = src[0];
-        dst[width-1] = src[width-1];
-        src = (Pixel *)((char *)src + srcpitch);
-        dst = (Pixel *)((char *)dst + dstpitch);
-    }
-
-    /* Now calculate and store the pixel luminances for the remaining pixels. */
-    src = src_buf;
-    for (y = 0; y < height; y++){
+    XsharpenSlice   *S = data;
+    const PixDim    width = S->frame->v_width;
+    Pixel32         *src = NULL;
+    int             x, y, r, g, b, luma;
+
+    tcv_convert(S->mfd->tcvhandle,
+                S->frame->video_buf + first * width * 3,
+                (uint8_t *)(S->mfd->convertFrameIn + first * width),
+                width, last - first, IMG_RGB24, IMG_BGRA32);
+
+    src = S->mfd->convertFrameIn + first * width;
+    for (y = first; y < last; y++){
         for (x = 0; x < width; x++){
             r = (src[x] >> 16) & 0xff;
             g = (src[x] >> 8) & 0xff;
@@ -359,13 +338,38 @@ static int xsharpen_rgb_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
             src[x] &= 0x00ffffff;
             src[x] |= (luma << 24);
         }
-        src = (Pixel *)((char *)src + srcpitch);
+        src += width;
     }
+}
 
-    /* Finally run the 3x3 rank-order sharpening kernel over the pixels. */
-    src = (Pixel *)((char *)src_buf + srcpitch);
-    dst = (Pixel *)((char *)dst_buf + dstpitch);
-    for (y = 1; y < height - 1; y++){
+/* sharpen rows [first, last) and convert them back */
+static void xsharpen_rgb_rows(void *data, int first, int last, int slot)
+{
+    XsharpenSlice   *S = data;
+    XsharpenPrivateData *mfd = S->mfd;
+    const PixDim    width  = S->frame->v_width;
+    const PixDim    height = S->frame->v_height;
+    Pixel32         *src= NULL, *dst = NULL;
+    int             x, y;
+    int             r, g, b, R, G, B;
+    Pixel32         p, min=1000, max=-1;
+    int             luma, lumac, lumamax, lumamin, mindiff, maxdiff;
+    const int       srcpitch = width*sizeof(Pixel32);
+
+    src = mfd->convertFrameIn + first * width;
+    dst = mfd->convertFrameOut + first * width;
+    for (y = first; y < last; y++, src += width, dst += width){
+        /* First copy through the four border lines. */
+        if (y == 0 || y == height - 1) {
+            for (x = 0; x < width; x++){
+                dst[x] = src[x];
+            }
+            continue;
+        }
+        dst[0] = src[0];
+        dst[width-1] = src[width-1];
+
+        /* Then run the 3x3 rank-order sharpening kernel over the pixels. */
         for (x = 1; x < width - 1; x++){
             /* Find the brightest and dimmest pixels in the 3x3 window
             surrounding the current pixel. */
@@ -422,14 +426,26 @@ static int xsharpen_rgb_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
                 dst[x] = (r << 16) | (g << 8) | b;
             }
         }
-        src = (Pixel *)((char *)src + srcpitch);
-        dst = (Pixel *)((char *)dst + dstpitch);
     }
 
-    tcv_convert(mfd->tcvhandle, (uint8_t *)mfd->convertFrameOut,
-                frame->video_buf, frame->v_width, frame->v_height,
-                IMG_BGRA32, IMG_RGB24);
+    tcv_convert(mfd->tcvhandle,
+                (uint8_t *)(mfd->convertFrameOut + first * width),
+                S->frame->video_buf + first * width * 3,
+                width, last - first, IMG_BGRA32, IMG_RGB24);
+}
+
+/*
+ * The kernel needs the luminances of the rows around the current one,
+ * so the frame goes through the slice pool twice: the first time to
+ * unpack the pixels and compute the luminances, the second time to
+ * sharpen and pack them again.
+ */
+static int xsharpen_rgb_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
+{
+    XsharpenSlice S = { mfd, frame };
 
+    tc_module_slice_run(xsharpen_rgb_luma, &S, frame->v_height, 16);
+    tc_module_slice_run(xsharpen_rgb_rows, &S, frame->v_height, 16);
     return TC_OK;
 }
 
@@ -455,49 +471,23 @@ static int xsharpen_rgb_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
 } while (0)
 
 
-static int xsharpen_yuv_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
+/* sharpen rows [first+1, last+1) */
+static void xsharpen_yuv_rows(void *data, int first, int last, int slot)
 {
-    const PixDim       width = frame->v_width;
-    const PixDim       height = frame->v_height;
-    char              *src, *dst;
+    XsharpenSlice     *S = data;
+    XsharpenPrivateData *mfd = S->mfd;
+    const PixDim       width = S->frame->v_width;
+    uint8_t           *src, *dst;
     int                x, y;
     int                luma = 0, lumac = 0, lumamax, lumamin;
     int                p, mindiff, maxdiff;
-    const int          srcpitch = frame->v_width;
-    const int          dstpitch = frame->v_width;
-
-    char *src_buf = frame->video_buf;
-
-    /* First copy through the four border lines. */
-    /* first */
-    src = src_buf;
-    dst = mfd->dst_buf;
-    ac_memcpy(dst, src, width);
+    const int          srcpitch = S->frame->v_width;
+    const int          dstpitch = S->frame->v_width;
 
-    /* last */
-    src = src_buf+srcpitch*(height-1);
-    dst = mfd->dst_buf+dstpitch*(height-1);
-    ac_memcpy(dst, src, width);
-
-    /* copy Cb and Cr */
-    ac_memcpy(mfd->dst_buf+dstpitch*height,
-              src_buf+srcpitch*height,
-              width*height>>1);
-
-    src = src_buf;
-    dst = mfd->dst_buf;
-    for (y = 0; y < height; y++){
-        *dst = *src;
-        *(dst+width-1) = *(src+width-1);
-        dst += dstpitch;
-        src += srcpitch;
-    }
+    src = S->frame->video_buf + srcpitch * (first + 1);
+    dst = mfd->dst_buf + dstpitch * (first + 1);
 
-    src = src_buf + srcpitch;
-    dst = mfd->dst_buf + dstpitch;
-
-    /* Finally run the 3x3 rank-order sharpening kernel over the pixels. */
-    for (y = 1; y < height - 1; y++){
+    for (y = first + 1; y < last + 1; y++){
         for (x = 1; x < width - 1; x++){
             /* Find the brightest and dimmest pixels in the 3x3 window
                surrounding the current pixel. */
@@ -514,6 +504,7 @@ static int xsharpen_yuv_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
                threshold, map the current pixel to the closest pixel;
                otherwise pass it through. */
 
+            lumac = src[x] & 0xff;
             p = -1;
             if (mfd->strength != 0){
                 mindiff = lumac   - lumamin;
@@ -530,7 +521,6 @@ static int xsharpen_yuv_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
                 dst[x] = src[x];
             } else {
                 int t;
-                lumac = src[x] & 0xff;
                 t = ((mfd->strength*p + mfd->strengthInv*lumac)/255) & 0xff;
                 t = TC_CLAMP(t, 16, 240);
                 dst[x] = t & 0xff;
@@ -539,6 +529,47 @@ static int xsharpen_yuv_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
         src += srcpitch;
         dst += dstpitch;
     }
+}
+
+static int xsharpen_yuv_frame(XsharpenPrivateData *mfd, vframe_list_t *frame)
+{
+    const PixDim       width = frame->v_width;
+    const PixDim       height = frame->v_height;
+    uint8_t           *src, *dst;
+    int                y;
+    const int          srcpitch = frame->v_width;
+    const int          dstpitch = frame->v_width;
+    XsharpenSlice      S = { mfd, frame };
+
+    uint8_t *src_buf = frame->video_buf;
+
+    /* First copy through the four border lines. */
+    /* first */
+    src = src_buf;
+    dst = mfd->dst_buf;
+    ac_memcpy(dst, src, width);
+
+    /* last */
+    src = src_buf+srcpitch*(height-1);
+    dst = mfd->dst_buf+dstpitch*(height-1);
+    ac_memcpy(dst, src, width);
+
+    /* copy Cb and Cr */
+    ac_memcpy(mfd->dst_buf+dstpitch*height,
+              src_buf+srcpitch*height,
+              width*height>>1);
+
+    src = src_buf;
+    dst = mfd->dst_buf;
+    for (y = 0; y < height; y++){
+        *dst = *src;
+        *(dst+width-1) = *(src+width-1);
+        dst += dstpitch;
+        src += srcpitch;
+    }
+
+    /* Finally run the 3x3 rank-order sharpening kernel over the pixels. */
+    tc_module_slice_run(xsharpen_yuv_rows, &S, height - 2, 16);
 
     ac_memcpy(frame->video_buf, mfd->dst_buf, width*height*3/2);
     return TC_OK;
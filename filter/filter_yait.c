@@ -21,14 +21,20 @@
  */
 
 #define MOD_NAME    "filter_yait.so"
-#define MOD_VERSION "v0.1.1 (2007-12-04)"
+#define MOD_VERSION "v0.2.0 (2026-10-18)"
 #define MOD_CAP     "Yet Another Inverse Telecine filter"
 #define MOD_AUTHOR  "Allan Snider"
 
+#define MOD_FEATURES \
+    TC_MODULE_FEATURE_FILTER|TC_MODULE_FEATURE_VIDEO
+#define MOD_FLAGS \
+    TC_MODULE_FLAG_RECONFIGURABLE|TC_MODULE_FLAG_BUFFERING
+
 #include "src/transcode.h"
 #include "src/filter.h"
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
+#include "libtcmodule/tcmodule-plugin.h"
 
 #include <stdlib.h>
 
@@ -162,147 +168,185 @@
  */
 
 
+static const char yait_help[] = ""
+    "Overview\n"
+    "    Yet Another Inverse Telecine filter: a two pass inverse\n"
+    "    telecine, driven by the tcyait analysis tool.\n"
+    "Options\n"
+    "    log[=file]  Compute and write yait delta log file [yait.log]\n"
+    "    ops[=file]  Read and apply yait frame operation file [yait.ops]\n";
+
+
 /*
- *  Prototypes:
+ *  Private data:
  */
 
-static int yait_get_config(char *opt);
-static int yait_init(char *opt);
-static int yait_fini(void);
-static int yait_process(vframe_list_t * ptr);
-
-static void yait_compare(vframe_list_t * ptr, uint8_t * lv, int fn);
 typedef void (*yait_cmp_fn) (uint8_t * lv, uint8_t * cv,
                              int w, int h, int *ed, int *od);
+
+typedef struct YaitPrivateData_ {
+    FILE *log_fp;               /* output log file */
+    FILE *ops_fp;               /* input frame ops file */
+
+    uint8_t *fbuf;              /* video frame buffer */
+    int codec;                  /* internal codec */
+    int fn;                     /* frame number */
+    yait_cmp_fn cmp_hook;
+} YaitPrivateData;
+
+
+/*
+ *  Prototypes:
+ */
+
+static void yait_compare(YaitPrivateData *pd, vframe_list_t * ptr,
+                         uint8_t * lv, int fn);
 static void yait_cmp_rgb(uint8_t * lv, uint8_t * cv, int w, int h,
                          int *ed, int *od);
 static void yait_cmp_yuv(uint8_t * lv, uint8_t * cv, int w, int h,
                          int *ed, int *od);
-static int yait_ops(vframe_list_t *);
-static int yait_ops_chk(void);
-static int yait_ops_get(char *, int, int *);
+static int yait_ops(YaitPrivateData *pd, vframe_list_t *);
+static int yait_ops_chk(YaitPrivateData *pd);
+static int yait_ops_get(YaitPrivateData *pd, char *, int, int *);
 static int yait_ops_decode(char *, int *);
-static void yait_put_rows(uint8_t *, uint8_t *, int, int, int);
+static void yait_put_rows(int, uint8_t *, uint8_t *, int, int, int);
 
-/*
- *  Globals:
- */
 
-static FILE *Log_fp;            /* output log file */
-static FILE *Ops_fp;            /* input frame ops file */
+/*************************************************************************/
 
-static uint8_t *Fbuf;           /* video frame buffer */
-static int Codec;               /* internal codec */
-static int Fn;                  /* frame number */
-static yait_cmp_fn cmp_hook;
+/* Module interface routines and data. */
 
+/*************************************************************************/
 
-/*
- *  tc_filter:
- *      YAIT filter main entry point.  Single instance.
+/**
+ * yait_init:  Initialize this instance of the module.  See
+ * tcmodule-data.h for function details.
  */
-int tc_filter(frame_list_t * ptr_, char *opt)
-{
-    vframe_list_t *ptr = (vframe_list_t *) ptr_;
-
-    if (ptr->tag & TC_AUDIO)
-        return TC_OK;
 
-    if (ptr->tag & TC_FILTER_GET_CONFIG)
-        return yait_get_config(opt);
+TC_MODULE_GENERIC_INIT(yait, YaitPrivateData)
 
-    if (ptr->tag & TC_FILTER_INIT)
-        return yait_init(opt);
+/*************************************************************************/
 
-    if (ptr->tag & TC_FILTER_CLOSE)
-        return yait_fini();
-
-    if (ptr->tag & TC_PRE_S_PROCESS)
-        return yait_process(ptr);
+/**
+ * yait_fini:  Clean up after this instance of the module.  See
+ * tcmodule-data.h for function details.
+ */
 
-    return TC_OK;
-}
+TC_MODULE_GENERIC_FINI(yait)
 
+/*************************************************************************/
 
-/*
- *  yait_get_config:
+/**
+ * yait_stop:  Reset this instance of the module.  See tcmodule-data.h
+ * for function details.
  */
 
-static int yait_get_config(char *opt)
+static int yait_stop(TCModuleInstance *self)
 {
-    optstr_filter_desc(opt, MOD_NAME, MOD_CAP,
-                       MOD_VERSION, MOD_AUTHOR, "VRYE", "1");
-    optstr_param(opt, "log",
-                 "Compute and write yait delta log file", "%s", "");
-    optstr_param(opt, "ops",
-                 "Read and apply yait frame operation file", "%s", "");
+    YaitPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "stop");
+
+    pd = self->userdata;
+
+    if (pd->log_fp) {
+        fclose(pd->log_fp);
+        pd->log_fp = NULL;
+    }
+    if (pd->ops_fp) {
+        fclose(pd->ops_fp);
+        pd->ops_fp = NULL;
+    }
+    if (pd->fbuf) {
+        tc_free(pd->fbuf);
+        pd->fbuf = NULL;
+    }
 
     return TC_OK;
 }
 
+/*************************************************************************/
 
-/*
- *  yait_init:
+/**
+ * yait_configure:  Configure this instance of the module.  See
+ * tcmodule-data.h for function details.
  */
 
-static int yait_init(char *opt)
+static int yait_configure(TCModuleInstance *self,
+                          const char *options,
+                          TCJob *vob,
+                          TCModuleExtraData *xdata[])
 {
-    vob_t *vob = tc_get_vob();
+    YaitPrivateData *pd = NULL;
     char buf[256], *fn = NULL;
     const char *p = NULL;
     int n;
 
+    TC_MODULE_SELF_CHECK(vob, "configure");
+    TC_MODULE_SELF_CHECK(self, "configure");
+
+    pd = self->userdata;
+
     if (verbose) {
         tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
-        tc_log_info(MOD_NAME, "options=%s", opt);
+        tc_log_info(MOD_NAME, "options=%s", (options) ?options :"");
+    }
+
+    if (options == NULL) {
+        tc_log_error(MOD_NAME,
+                     "at least one operation (log|ops) must be specified");
+        return TC_ERROR;
     }
 
-    Codec = vob->im_v_codec;
+    pd->codec = vob->im_v_codec;
 
     /* log file */
-    p = optstr_lookup(opt, "log");
+    p = optstr_lookup(options, "log");
     if (p) {
         fn = Y_LOG_FN;
-        n = optstr_get(opt, "log", "%[^:]", buf);
+        n = optstr_get(options, "log", "%[^:]", buf);
         if (n > 0)
             fn = buf;
 
-        Log_fp = fopen(fn, "w");
-        if (!Log_fp) {
-            tc_log_error(MOD_NAME, "cannot create log file, '%s'", buf);
+        pd->log_fp = fopen(fn, "w");
+        if (!pd->log_fp) {
+            tc_log_error(MOD_NAME, "cannot create log file, '%s'", fn);
             return TC_ERROR;
         }
     }
 
     /* ops file */
-    p = optstr_lookup(opt, "ops");
+    p = optstr_lookup(options, "ops");
     if (p) {
         fn = Y_OPS_FN;
-        n = optstr_get(opt, "ops", "%[^:]", buf);
+        n = optstr_get(options, "ops", "%[^:]", buf);
         if (n > 0)
             fn = buf;
 
-        Ops_fp = fopen(fn, "r");
-        if (!Ops_fp) {
-            tc_log_error(MOD_NAME, "cannot open yait ops file, '%s'", buf);
+        pd->ops_fp = fopen(fn, "r");
+        if (!pd->ops_fp) {
+            tc_log_error(MOD_NAME, "cannot open yait ops file, '%s'", fn);
+            yait_stop(self);
             return TC_ERROR;
         }
 
-        if (!yait_ops_chk()) {
+        if (!yait_ops_chk(pd)) {
             tc_log_error(MOD_NAME, "invalid yait ops file");
+            yait_stop(self);
             return TC_ERROR;
         }
     }
 
-    if (!Log_fp && !Ops_fp) {
+    if (!pd->log_fp && !pd->ops_fp) {
         tc_log_error(MOD_NAME,
                      "at least one operation (log|ops) must be specified");
         return TC_ERROR;
     }
 
-    if (Log_fp && Ops_fp) {
+    if (pd->log_fp && pd->ops_fp) {
         tc_log_error(MOD_NAME,
                      "only one operation (log|ops) may be specified");
+        yait_stop(self);
         return TC_ERROR;
     }
 
@@ -311,7 +355,7 @@ static int yait_init(char *opt)
     vob->im_frc = 4;
     vob->fps = NTSC_VIDEO;
 
-    if (Log_fp) {
+    if (pd->log_fp) {
         tc_log_info(MOD_NAME, "Generating YAIT delta log file '%s'", fn);
         tc_log_info(MOD_NAME,
                     "Forcing --hard_fps, -f 30,4, --export_fps 30,4");
@@ -321,7 +365,7 @@ static int yait_init(char *opt)
         vob->ex_fps = NTSC_VIDEO;
     }
 
-    if (Ops_fp) {
+    if (pd->ops_fp) {
         tc_log_info(MOD_NAME, "Applying YAIT frame operations file '%s'",
                     fn);
         tc_log_info(MOD_NAME,
@@ -332,96 +376,165 @@ static int yait_init(char *opt)
         vob->ex_fps = NTSC_FILM;
     }
 
-    Fbuf = tc_zalloc(SIZE_RGB_FRAME);
-    if (!Fbuf) {
+    pd->fbuf = tc_zalloc(TC_JOB_FRAME_SIZE(vob));
+    if (!pd->fbuf) {
         tc_log_error(MOD_NAME, "cannot allocate frame buffer");
+        yait_stop(self);
         return TC_ERROR;
     }
 
-    Fn = -1;
+    pd->fn = -1;
 
-    if (Codec == TC_CODEC_RGB24)
-        cmp_hook = yait_cmp_rgb;
+    if (pd->codec == TC_CODEC_RGB24)
+        pd->cmp_hook = yait_cmp_rgb;
     else
-        cmp_hook = yait_cmp_yuv;
+        pd->cmp_hook = yait_cmp_yuv;
 
     return TC_OK;
 }
 
+/*************************************************************************/
 
-/*
- *  yait_fini:
+/**
+ * yait_inspect:  Return the value of an option in this instance of the
+ * module.  See tcmodule-data.h for function details.
  */
 
-static int yait_fini(void)
+static int yait_inspect(TCModuleInstance *self,
+                        const char *param, const char **value)
 {
-    if (Log_fp) {
-        fclose(Log_fp);
-        Log_fp = NULL;
-    }
-    if (Ops_fp) {
-        fclose(Ops_fp);
-        Ops_fp = NULL;
-    }
-    if (Fbuf) {
-        tc_free(Fbuf);
-        Fbuf = NULL;
-    }
+    TC_MODULE_SELF_CHECK(self, "inspect");
+    TC_MODULE_SELF_CHECK(param, "inspect");
+    TC_MODULE_SELF_CHECK(value, "inspect");
 
+    if (optstr_lookup(param, "help")) {
+        *value = yait_help;
+    }
     return TC_OK;
 }
 
+/*************************************************************************/
 
-/*
- *  yait_process:
+/**
+ * yait_filter_video:  log or apply the frame operations to the given
+ * frame.  See tcmodule-data.h for function details.
  */
 
-static int yait_process(vframe_list_t * ptr)
+static int yait_filter_video(TCModuleInstance *self, vframe_list_t *ptr)
 {
-    if (Fn == -1) {
-        Fn = ptr->id;
-        ac_memcpy(Fbuf, ptr->video_buf, ptr->video_size);
+    YaitPrivateData *pd = NULL;
+
+    TC_MODULE_SELF_CHECK(self, "filter_video");
+    TC_MODULE_SELF_CHECK(ptr, "filter_video");
+
+    pd = self->userdata;
+
+    if (pd->fn == -1) {
+        pd->fn = ptr->id;
+        ac_memcpy(pd->fbuf, ptr->video_buf, ptr->video_size);
     }
 
-    if (ptr->id != Fn) {
+    if (ptr->id != pd->fn) {
         tc_log_error(MOD_NAME, "inconsistent frame numbers");
-        yait_fini();
+        yait_stop(self);
         return TC_ERROR;
     }
 
-    if (Log_fp) {
-        yait_compare(ptr, Fbuf, Fn);
-        ac_memcpy(Fbuf, ptr->video_buf, ptr->video_size);
+    if (pd->log_fp) {
+        yait_compare(pd, ptr, pd->fbuf, pd->fn);
+        ac_memcpy(pd->fbuf, ptr->video_buf, ptr->video_size);
     }
 
-    if (Ops_fp)
-        if (!yait_ops(ptr)) {
-            yait_fini();
+    if (pd->ops_fp)
+        if (!yait_ops(pd, ptr)) {
+            yait_stop(self);
             return TC_ERROR;
         }
 
-    Fn++;
+    pd->fn++;
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+static const TCCodecID yait_codecs_video_in[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+static const TCCodecID yait_codecs_video_out[] = {
+    TC_CODEC_YUV420P, TC_CODEC_RGB24, TC_CODEC_ERROR
+};
+TC_MODULE_AUDIO_UNSUPPORTED(yait);
+TC_MODULE_FILTER_FORMATS(yait);
+
+TC_MODULE_INFO(yait);
+
+static const TCModuleClass yait_class = {
+    TC_MODULE_CLASS_HEAD(yait),
+
+    .init         = yait_init,
+    .fini         = yait_fini,
+    .configure    = yait_configure,
+    .stop         = yait_stop,
+    .inspect      = yait_inspect,
+
+    .filter_video = yait_filter_video
+};
+
+TC_MODULE_ENTRY_POINT(yait)
+
+/*************************************************************************/
+
+static int yait_get_config(TCModuleInstance *self, char *options)
+{
+    TC_MODULE_SELF_CHECK(self, "get_config");
+
+    optstr_filter_desc(options, MOD_NAME, MOD_CAP,
+                       MOD_VERSION, MOD_AUTHOR, "VRYE", "1");
+    optstr_param(options, "log",
+                 "Compute and write yait delta log file", "%s", "");
+    optstr_param(options, "ops",
+                 "Read and apply yait frame operation file", "%s", "");
+
+    return TC_OK;
+}
+
+static int yait_process(TCModuleInstance *self, frame_list_t *frame)
+{
+    TC_MODULE_SELF_CHECK(self, "process");
+
+    /* the ops file is indexed by frame number */
+    if (frame->tag & TC_PRE_S_PROCESS && frame->tag & TC_VIDEO) {
+        return yait_filter_video(self, (vframe_list_t*)frame);
+    }
     return TC_OK;
 }
 
+/*************************************************************************/
+
+/* Old-fashioned module interface. */
+
+TC_FILTER_OLDINTERFACE(yait)
+
+/*************************************************************************/
 
 /*
  *  yait_compare:
  */
 
-static void yait_compare(vframe_list_t * ptr, uint8_t * lv, int fn)
+static void yait_compare(YaitPrivateData *pd, vframe_list_t * ptr,
+                         uint8_t * lv, int fn)
 {
     uint8_t *cv = ptr->video_buf;
     int w = ptr->v_width, h = ptr->v_height;
     int ed, od;
 
-    cmp_hook(lv, cv, w, h, &ed, &od);
+    pd->cmp_hook(lv, cv, w, h, &ed, &od);
 
-    fprintf(Log_fp, "%d: e: %d, o: %d\n", fn, ed, od);
+    fprintf(pd->log_fp, "%d: e: %d, o: %d\n", fn, ed, od);
 
     /* BUG: until the blocked tcdecode pipe problem is fixed... */
     if (!(fn % 5))
-        fflush(Log_fp);
+        fflush(pd->log_fp);
 }
 
 
@@ -521,7 +634,7 @@ static void yait_cmp_yuv(uint8_t * lv, uint8_t * cv, int w, int h, int *ed, int
  *  yait_ops:
  */
 
-static int yait_ops(vframe_list_t * ptr)
+static int yait_ops(YaitPrivateData *pd, vframe_list_t * ptr)
 {
     char buf[256];
     uint8_t *v;
@@ -532,19 +645,19 @@ static int yait_ops(vframe_list_t * ptr)
     w = ptr->v_width;
     h = ptr->v_height;
 
-    if (!fgets(buf, 256, Ops_fp))
+    if (!fgets(buf, 256, pd->ops_fp))
 	return (TC_FALSE);
 
-    op = yait_ops_get(buf, Fn, &mode);
+    op = yait_ops_get(pd, buf, pd->fn, &mode);
 
     if (op < 0)
         return (TC_FALSE);
 
     if (op & Y_OP_SAVE)
-        yait_put_rows(Fbuf, v, w, h, op & Y_OP_PAT);
+        yait_put_rows(pd->codec, pd->fbuf, v, w, h, op & Y_OP_PAT);
 
     if (op & Y_OP_COPY)
-        yait_put_rows(v, Fbuf, w, h, op & Y_OP_PAT);
+        yait_put_rows(pd->codec, v, pd->fbuf, w, h, op & Y_OP_PAT);
 
     if (op & Y_OP_DROP)
         ptr->attributes |= TC_FRAME_IS_SKIPPED;
@@ -562,27 +675,27 @@ static int yait_ops(vframe_list_t * ptr)
  *  yait_ops_chk:
  */
 
-static int yait_ops_chk(void)
+static int yait_ops_chk(YaitPrivateData *pd)
 {
     char buf[256], *p;
     int fn, op;
 
-    if (fscanf(Ops_fp, "%d:", &fn) != 1)
+    if (fscanf(pd->ops_fp, "%d:", &fn) != 1)
 	return (TC_FALSE);
 
-    rewind(Ops_fp);
+    rewind(pd->ops_fp);
     for (;;) {
-        p = fgets(buf, 256, Ops_fp);
+        p = fgets(buf, 256, pd->ops_fp);
         if (!p)
             break;
 
-        op = yait_ops_get(buf, fn, NULL);
+        op = yait_ops_get(pd, buf, fn, NULL);
         if (op < 0)
             return (TC_FALSE);
         fn++;
     }
 
-    rewind(Ops_fp);
+    rewind(pd->ops_fp);
     return (TC_TRUE);
 }
 
@@ -591,7 +704,7 @@ static int yait_ops_chk(void)
  *  yait_ops_get:
  */
 
-static int yait_ops_get(char *buf, int fn, int *mode)
+static int yait_ops_get(YaitPrivateData *pd, char *buf, int fn, int *mode)
 {
     char str[256];
     int op, f, n;
@@ -601,7 +714,7 @@ static int yait_ops_get(char *buf, int fn, int *mode)
 
     n = sscanf(buf, "%d: %s\n", &f, str);
     if (n < 1) {
-        if (feof(Ops_fp))
+        if (feof(pd->ops_fp))
             tc_log_error(MOD_NAME, "truncated yait ops file, frame: %d",
                          fn);
         else
@@ -674,13 +787,14 @@ static int yait_ops_decode(char *str, int *mode)
  *  yait_put_rows:
  */
 
-static void yait_put_rows(uint8_t * dst, uint8_t * src, int w, int h, int flg)
+static void yait_put_rows(int codec, uint8_t * dst, uint8_t * src,
+                          int w, int h, int flg)
 {
     int y, o;
 
     y = (flg == Y_OP_EVEN) ? 0 : 1;
 
-    if (Codec == TC_CODEC_RGB24) {
+    if (codec == TC_CODEC_RGB24) {
         for (; y < h; y += 2) {
             o = y * w * 3;
             ac_memcpy(dst + o, src + o, w * 3);
@@ -698,3 +812,14 @@ static void yait_put_rows(uint8_t * dst, uint8_t * src, int w, int h, int flg)
         }
     }
 }
+
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -74,6 +74,9 @@ static int preview_xv_port=0;
 static char *undo_buffer = NULL;
 static char *run_buffer[2] = {NULL, NULL};
 static char *process_buffer[3] = {NULL, NULL, NULL};
+static int process_size[3] = {0, 0, 0};
+/* largest frame seen through the chain, sizes the buffers above */
+static int frame_w, frame_h;
 
 static int process_ctr_cur=0;
 
@@ -183,6 +186,9 @@ int tc_filter(frame_list_t *ptr_, char *options)
 
     size = w*h* 3/2;
 
+    frame_w = TC_MAX(vob->im_v_width, vob->ex_v_width);
+    frame_h = TC_MAX(vob->im_v_height, vob->ex_v_height);
+
     if(verbose) tc_log_info(MOD_NAME, "preview window %dx%d", w, h);
 
     tcvhandle = tcv_init();
@@ -228,17 +234,17 @@ int tc_filter(frame_list_t *ptr_, char *options)
       if(preview_cache_init()<0) return(-1);
 
       /* FIXME: these are never freed! */
-      if ((undo_buffer = tc_bufalloc(SIZE_RGB_FRAME)) == NULL)
+      if ((undo_buffer = tc_bufalloc(TC_JOB_FRAME_SIZE(vob))) == NULL)
 	  return (-1);
-      if ((run_buffer[0] = tc_bufalloc (SIZE_RGB_FRAME)) == NULL)
+      if ((run_buffer[0] = tc_bufalloc(TC_JOB_FRAME_SIZE(vob))) == NULL)
 	  return (-1);
-      if ((run_buffer[1] = tc_bufalloc (SIZE_RGB_FRAME)) == NULL)
+      if ((run_buffer[1] = tc_bufalloc(TC_JOB_FRAME_SIZE(vob))) == NULL)
 	  return (-1);
-      if ((process_buffer[0] = tc_bufalloc (SIZE_RGB_FRAME)) == NULL)
+      if ((process_buffer[0] = tc_bufalloc(TC_JOB_FRAME_SIZE(vob))) == NULL)
 	  return (-1);
-      if ((process_buffer[1] = tc_bufalloc (SIZE_RGB_FRAME)) == NULL)
+      if ((process_buffer[1] = tc_bufalloc(TC_JOB_FRAME_SIZE(vob))) == NULL)
 	  return (-1);
-      if ((process_buffer[2] = tc_bufalloc (SIZE_RGB_FRAME)) == NULL)
+      if ((process_buffer[2] = tc_bufalloc(TC_JOB_FRAME_SIZE(vob))) == NULL)
 	  return (-1);
 
     }
@@ -291,6 +297,7 @@ int tc_filter(frame_list_t *ptr_, char *options)
   if( (ptr->tag & TC_PRE_M_PROCESS) && vid && cache_enabled) {
       process_ctr_cur = (process_ctr_cur+1)%3;
       ac_memcpy (process_buffer[process_ctr_cur], ptr->video_buf, ptr->video_size);
+      process_size[process_ctr_cur] = ptr->video_size;
       return 0;
   }
   if(pre && vid) {
@@ -394,8 +401,10 @@ int preview_filter_buffer(int frames_needed)
 	ac_memcpy (run_buffer[0], (char *)vid_buf[cache_ptr-(current-1)], size);
 	ac_memcpy (run_buffer[1], (char *)vid_buf[cache_ptr-(current-1)], size);
 #else
-	ac_memcpy (run_buffer[0], process_buffer[(process_ctr_cur+1)%3], SIZE_RGB_FRAME);
-	ac_memcpy (run_buffer[1], process_buffer[(process_ctr_cur+1)%3], SIZE_RGB_FRAME);
+	ac_memcpy (run_buffer[0], process_buffer[(process_ctr_cur+1)%3],
+		   process_size[(process_ctr_cur+1)%3]);
+	ac_memcpy (run_buffer[1], process_buffer[(process_ctr_cur+1)%3],
+		   process_size[(process_ctr_cur+1)%3]);
 #endif
 
 	if (i == 1) {
@@ -408,10 +417,8 @@ int preview_filter_buffer(int frames_needed)
 	ptr->filter_id = 0;
 	ptr->v_codec = TC_CODEC_YUV420P;
 	ptr->id  = i; // frame
-#ifdef STATBUFFER
 	ptr->internal_video_buf_0 = run_buffer[0];
 	ptr->internal_video_buf_1 = run_buffer[1];
-#endif /* STATBUFFER */
 
 	// RGB
 	ptr->video_buf_RGB[0]=run_buffer[0];
@@ -422,14 +429,14 @@ int preview_filter_buffer(int frames_needed)
 	ptr->video_buf_Y[1] = run_buffer[1];
 
 	ptr->video_buf_U[0] = ptr->video_buf_Y[0]
-	    + TC_MAX_V_FRAME_WIDTH * TC_MAX_V_FRAME_HEIGHT;
+	    + frame_w * frame_h;
 	ptr->video_buf_U[1] = ptr->video_buf_Y[1]
-	    + TC_MAX_V_FRAME_WIDTH * TC_MAX_V_FRAME_HEIGHT;
+	    + frame_w * frame_h;
 
 	ptr->video_buf_V[0] = ptr->video_buf_U[0]
-	    + (TC_MAX_V_FRAME_WIDTH * TC_MAX_V_FRAME_HEIGHT)/4;
+	    + (frame_w * frame_h)/4;
 	ptr->video_buf_V[1] = ptr->video_buf_U[1]
-	    + (TC_MAX_V_FRAME_WIDTH * TC_MAX_V_FRAME_HEIGHT)/4;
+	    + (frame_w * frame_h)/4;
 
 	//default pointer
 	ptr->video_buf  = run_buffer[0];
@@ -601,10 +608,8 @@ redisplay_frame:
 	ptr.filter_id = 0;
 	ptr.v_codec = CODEC_YUV;
 	ptr.id  = i; // frame
-#ifdef STATBUFFER	
 	ptr.internal_video_buf_0 = run_buffer[0];
 	ptr.internal_video_buf_1 = run_buffer[1];
-#endif /* STATBUFFER */
 
 	// RGB
 	ptr.video_buf_RGB[0]=run_buffer[0];
@@ -615,14 +620,14 @@ redisplay_frame:
 	ptr.video_buf_Y[1] = run_buffer[1];
 
 	ptr.video_buf_U[0] = ptr.video_buf_Y[0]
-	    + TC_MAX_V_FRAME_WIDTH * TC_MAX_V_FRAME_HEIGHT;
+	    + frame_w * frame_h;
 	ptr.video_buf_U[1] = ptr.video_buf_Y[1]
-	    + TC_MAX_V_FRAME_WIDTH * TC_MAX_V_FRAME_HEIGHT;
+	    + frame_w * frame_h;
 
 	ptr.video_buf_V[0] = ptr.video_buf_U[0]
-	    + (TC_MAX_V_FRAME_WIDTH * TC_MAX_V_FRAME_HEIGHT)/4;
+	    + (frame_w * frame_h)/4;
 	ptr.video_buf_V[1] = ptr.video_buf_U[1]
-	    + (TC_MAX_V_FRAME_WIDTH * TC_MAX_V_FRAME_HEIGHT)/4;
+	    + (frame_w * frame_h)/4;
 
 	//default pointer
 	ptr.video_buf  = run_buffer[0];
@@ -29,7 +29,7 @@
 */
 
 #define MOD_NAME    "filter_stabilize.so"
-#define MOD_VERSION "v0.75 (2010-04-07)"
+#define MOD_VERSION "v0.77 (2026-10-18)"
 #define MOD_CAP     "extracts relative transformations of \n\
     subsequent frames (used for stabilization together with the\n\
     transform filter in a second pass)"
@@ -53,6 +53,7 @@
 #include "libtc/tccodecs.h"
 #include "libtcutil/optstr.h"
 #include "libtcutil/tclist.h"
+#include "libtcutil/tctaskpool.h"
 #include "libtcmodule/tcmodule-plugin.h"
 
 #include "transform.h"
@@ -64,6 +65,9 @@
  * this is really just for debugging and development */
 // #define STABVERBOSE
 
+/* maximal number of levels of the coarse-to-fine search */
+#define STAB_MAX_LEVELS 4
+
 typedef struct _field {
     int x;     // middle position x
     int y;     // middle position y
@@ -91,6 +95,7 @@ typedef struct _stab_data {
     TCList* transs;
 
     Field* fields;
+    struct _field_task* tasks; // one search job per field
 
 
     /* Options */
@@ -113,6 +118,18 @@ typedef struct _stab_data {
     int shakiness;   
     int accuracy;   // meta parameter for number of fields between 1 and 10
   
+    /* worker threads searching the fields (NULL: the filter thread) */
+    int threads;
+    TCTaskPool* pool;
+
+    /* pyramid levels for the coarse-to-fine search (1: plain search) */
+    int levels;
+    uint8_t* pyrbuf[2];  // smaller levels of the two luminance pyramids
+    int pyrcurr;         // which of them belongs to the current frame
+    const uint8_t* pyr_c[STAB_MAX_LEVELS]; // levels of the current frame
+    const uint8_t* pyr_p[STAB_MAX_LEVELS]; // levels of the previous frame
+    int pyr_stride[STAB_MAX_LEVELS];
+
     int t;
     char* result;
     FILE* f;
@@ -128,6 +145,14 @@ typedef Transform (*calcFieldTransFunc)(StabData*, const Field*, int);
  */
 typedef double (*contrastSubImgFunc)(StabData* sd, const Field* field);
 
+/* search job for one measurement field, run by the worker threads */
+typedef struct _field_task {
+    StabData* sd;
+    calcFieldTransFunc fieldfunc;
+    int index;     // index of the field
+    Transform t;   // resulting transformation
+} FieldTask;
+
 static const char stabilize_help[] = ""
     "Overview:\n"
     "    Generates a file with relative transform information\n"
@@ -147,6 +172,10 @@ static const char stabilize_help[] = ""
     "    'mincontrast' below this contrast a field is discarded (0-1) (def: 0.3)\n"
     "    'show'        0: draw nothing (def); 1,2: show fields and transforms\n"
     "                  in the resulting frames. Consider the 'preview' filter\n"
+    "    'threads'     number of threads searching the fields; 0: one per\n"
+    "                  CPU (def: 1)\n"
+    "    'pyramid'     levels of the coarse-to-fine search, instead of the\n"
+    "                  stepsize grid (YUV only); 1: off (def: 1, max: 4)\n"
     "    'help'        print this help message\n";
 
 int initFields(StabData* sd);
@@ -180,6 +209,8 @@ void drawFieldTrans(StabData* sd, const Field* field, const Transform* t);
 void drawBox(unsigned char* I, int width, int height, int bytesPerPixel, 
              int x, int y, int sizex, int sizey, unsigned char color);
 void addTrans(StabData* sd, Transform sl);
+void buildPyramid(StabData* sd);
+static void stabilize_field_run(void *task, int worker, void *userdata);
 
 void addTrans(StabData* sd, Transform sl)
 {
@@ -213,8 +244,10 @@ int initFields(StabData* sd)
         int i, j;
         // the border is the amount by which the field centers
         // have to be away from the image boundary
-        // (stepsize is added in case shift is increased through stepsize)
-        int border   = size/2 + sd->maxshift + sd->stepsize;
+        // (stepsize is added in case shift is increased through stepsize,
+        //  the pyramid search can overshoot by one pixel per level)
+        int border   = size/2 + sd->maxshift
+                       + TC_MAX(sd->stepsize, 1 << (sd->levels - 1));
         int step_x   = (sd->width  - 2*border)/TC_MAX(cols-1,1);
         int step_y   = (sd->height - 2*border) / TC_MAX(rows-1,1);
         for (j = 0; j < rows; j++) {
@@ -238,51 +271,29 @@ int initFields(StabData* sd)
 double compareImg(unsigned char* I1, unsigned char* I2, 
                   int width, int height,  int bytesPerPixel, int d_x, int d_y)
 {
-    int i, j;
-    unsigned char* p1 = NULL;
-    unsigned char* p2 = NULL;
-    long int sum = 0;  
+    int i;
+    unsigned char* p1 = I1;
+    unsigned char* p2 = I2;
+    int64_t sum = 0;
     int effectWidth = width - abs(d_x);
     int effectHeight = height - abs(d_y);
+    int stride = width * bytesPerPixel;
 
-/*   DEBUGGING code to export single frames */
-/*   char buffer[100]; */
-/*   sprintf(buffer, "pic_%02ix%02i_1.ppm", d_x, d_y); */
-/*   FILE *pic1 = fopen(buffer, "w"); */
-/*   sprintf(buffer, "pic_%02ix%02i_2.ppm", d_x, d_y); */
-/*   FILE *pic2 = fopen(buffer, "w"); */
-/*   fprintf(pic1, "P6\n%i %i\n255\n", effectWidth, effectHeight); */
-/*   fprintf(pic2, "P6\n%i %i\n255\n", effectWidth, effectHeight); */
-
+    if (d_y > 0) {
+        p1 += d_y * stride;
+    } else {
+        p2 -= d_y * stride;
+    }
+    if (d_x > 0) {
+        p1 += d_x * bytesPerPixel;
+    } else {
+        p2 -= d_x * bytesPerPixel;
+    }
+    // row by row, so that the sum cannot overflow ac_sad() on big frames
     for (i = 0; i < effectHeight; i++) {
-        p1 = I1;
-        p2 = I2;
-        if (d_y > 0 ){ 
-            p1 += (i + d_y) * width * bytesPerPixel;
-            p2 += i * width * bytesPerPixel;
-        } else {
-            p1 += i * width * bytesPerPixel;
-            p2 += (i - d_y) * width * bytesPerPixel;
-        }
-        if (d_x > 0) { 
-            p1 += d_x * bytesPerPixel;
-        } else {
-            p2 -= d_x * bytesPerPixel; 
-        }
-        // TODO: use some mmx or sse stuff here
-        for (j = 0; j < effectWidth * bytesPerPixel; j++) {
-            /* debugging code continued */
-            /* fwrite(p1,1,1,pic1);fwrite(p1,1,1,pic1);fwrite(p1,1,1,pic1);
-               fwrite(p2,1,1,pic2);fwrite(p2,1,1,pic2);fwrite(p2,1,1,pic2); 
-             */
-            sum += abs((int)*p1 - (int)*p2);
-            p1++;
-            p2++;      
-        }
+        sum += ac_sad(p1 + i*stride, stride, p2 + i*stride, stride,
+                      effectWidth * bytesPerPixel, 1);
     }
-    /*  fclose(pic1);
-        fclose(pic2); 
-     */
     return sum/((double) effectWidth * effectHeight * bytesPerPixel);
 }
 
@@ -300,24 +311,15 @@ double compareSubImg(unsigned char* const I1, unsigned char* const I2,
                      const Field* field, 
                      int width, int height, int bytesPerPixel, int d_x, int d_y)
 {
-    int k, j;
     unsigned char* p1 = NULL;
     unsigned char* p2 = NULL;
     int s2 = field->size / 2;
-    double sum = 0;
+    uint32_t sum;
 
     p1=I1 + ((field->x - s2) + (field->y - s2)*width)*bytesPerPixel;
     p2=I2 + ((field->x - s2 + d_x) + (field->y - s2 + d_y)*width)*bytesPerPixel;
-    // TODO: use some mmx or sse stuff here
-    for (j = 0; j < field->size; j++){
-        for (k = 0; k < field->size * bytesPerPixel; k++) {
-            sum += abs((int)*p1 - (int)*p2);
-            p1++;
-            p2++;     
-        }
-        p1 += (width - field->size) * bytesPerPixel;
-        p2 += (width - field->size) * bytesPerPixel;
-    }
+    sum = ac_sad(p1, width * bytesPerPixel, p2, width * bytesPerPixel,
+                 field->size * bytesPerPixel, field->size);
     return sum/((double) field->size *field->size* bytesPerPixel);
 }
 
@@ -473,7 +475,12 @@ Transform calcFieldTransYUV(StabData* sd, const Field* field, int fieldnum)
     Transform t = null_transform();
     uint8_t *Y_c = sd->curr, *Y_p = sd->prev;
     // we only use the luminance part of the image
+    int s2 = field->size / 2;
+    int offset = (field->x - s2) + (field->y - s2)*sd->width;
+    ACMotionVector mv = { 0, 0, 0 };
+#ifdef STABVERBOSE
     int i, j;
+#endif
 
 /*     // check contrast in sub image */
 /*     double contr = contrastSubImg(Y_c, field, sd->width, sd->height, 1); */
@@ -490,54 +497,43 @@ Transform calcFieldTransYUV(StabData* sd, const Field* field, int fieldnum)
     fprintf(f, "# splot \"%s\"\n", buffer);
 #endif    
 
-    double minerror = 1e10;  
-    double error = 1e10;
+#ifdef STABVERBOSE
+    // the error surface on the coarse grid, for plotting
     for (i = -sd->maxshift; i <= sd->maxshift; i += sd->stepsize) {
         for (j = -sd->maxshift; j <= sd->maxshift; j += sd->stepsize) {
-            error = compareSubImg(Y_c, Y_p, field, 
-                                         sd->width, sd->height, 1, i, j);
-#ifdef STABVERBOSE
-            fprintf(f, "%i %i %f\n", i, j, error);
-#endif 
-            if (error < minerror) {
-                minerror = error;
-                t.x = i;
-                t.y = j;
-            }	
+            fprintf(f, "%i %i %f\n", i, j,
+                    compareSubImg(Y_c, Y_p, field,
+                                  sd->width, sd->height, 1, i, j));
         }
     }
+#endif
 
-    if (sd->stepsize > 1) {    // make fine grain check around the best match
-        int r = sd->stepsize - 1;
-        for (i = t.x - r; i <= t.x + r; i += 1) {
-            for (j = -t.y - r; j <= t.y + r; j += 1) {
-                if (i == t.x && j == t.y) 
-                    continue; //no need to check this since already done
-                error = compareSubImg(Y_c, Y_p, field, 
-                                      sd->width, sd->height, 1, i, j);
-#ifdef STABVERBOSE
-                fprintf(f, "%i %i %f\n", i, j, error);
-#endif 	
-                if (error < minerror){
-                    minerror = error;
-                    t.x = i;
-                    t.y = j;
-                }	
-            }
-        }
+    if (sd->levels > 1) {
+        // full search on the smallest level, refined on each larger one
+        ac_motion_search_hier(sd->pyr_c, sd->pyr_p, sd->pyr_stride,
+                              sd->levels, field->x - s2, field->y - s2,
+                              field->size, field->size, sd->maxshift, &mv);
+    } else {
+        // coarse grid at stepsize, then a fine grain check around the best
+        ac_motion_search(Y_c + offset, sd->width, Y_p + offset, sd->width,
+                         field->size, field->size, sd->maxshift,
+                         sd->stepsize, &mv);
     }
+    t.x = mv.x;
+    t.y = mv.y;
 #ifdef STABVERBOSE 
     fclose(f); 
-    tc_log_msg(MOD_NAME, "Minerror: %f\n", minerror);
+    tc_log_msg(MOD_NAME, "Minerror: %f\n",
+               mv.cost / ((double)field->size * field->size));
 #endif
 
-    if (!sd->allowmax && fabs(t.x) == sd->maxshift) {
+    if (!sd->allowmax && fabs(t.x) >= sd->maxshift) {
 #ifdef STABVERBOSE 
         tc_log_msg(MOD_NAME, "maximal x shift ");
 #endif
         t.x = 0;
     }
-    if (!sd->allowmax && fabs(t.y) == sd->maxshift) {
+    if (!sd->allowmax && fabs(t.y) >= sd->maxshift) {
 #ifdef STABVERBOSE 
         tc_log_msg(MOD_NAME, "maximal y shift ");
 #endif
@@ -553,7 +549,7 @@ Transform calcFieldTransRGB(StabData* sd, const Field* field, int fieldnum)
 {
     Transform t = null_transform();
     uint8_t *I_c = sd->curr, *I_p = sd->prev;
-    int i, j;
+    int i, j, cx, cy;
   
     double minerror = 1e20;  
     for (i = -sd->maxshift; i <= sd->maxshift; i += 2) {
@@ -567,10 +563,16 @@ Transform calcFieldTransRGB(StabData* sd, const Field* field, int fieldnum)
             }	
         }
     }
-    for (i = t.x - 1; i <= t.x + 1; i += 2) {
-        for (j = -t.y - 1; j <= t.y + 1; j += 2) {
-            double error = compareSubImg(I_c, I_p, field, 
-                                         sd->width, sd->height, 3, i, j);
+    // fine grain check around the best match
+    cx = t.x;
+    cy = t.y;
+    for (i = cx - 1; i <= cx + 1; i++) {
+        for (j = cy - 1; j <= cy + 1; j++) {
+            double error;
+            if (i == cx && j == cy)
+                continue; // already done
+            error = compareSubImg(I_c, I_p, field,
+                                  sd->width, sd->height, 3, i, j);
             if (error < minerror) {
                 minerror = error;
                 t.x = i;
@@ -685,7 +687,8 @@ Transform calcTransFields(StabData* sd, calcFieldTransFunc fieldfunc,
     Transform* ts  = tc_malloc(sizeof(Transform) * sd->field_num);
     Field** fs     = tc_malloc(sizeof(Field*) * sd->field_num);
     double *angles = tc_malloc(sizeof(double) * sd->field_num);
-    int i, index=0, num_trans;
+    FieldTask* tasks = sd->tasks;
+    int i, j, index=0, num_tasks=0, num_trans;
     Transform t;
 #ifdef STABVERBOSE
     FILE *f = NULL;
@@ -698,10 +701,25 @@ Transform calcTransFields(StabData* sd, calcFieldTransFunc fieldfunc,
     TCList* goodflds = selectfields(sd, contrastfunc);
 
     // use all "good" fields and calculate optimal match to previous frame 
-    contrast_idx* f;
-    while((f = (contrast_idx*)tc_list_pop(goodflds,0)) != 0){
-        int i = f->index;
-        t =  fieldfunc(sd, &sd->fields[i], i); // e.g. calcFieldTransYUV
+    // (on the worker threads if any: the fields are searched in parallel
+    // and their results taken in the same order afterwards)
+    contrast_idx* ci;
+    while((ci = (contrast_idx*)tc_list_pop(goodflds,0)) != 0){
+        FieldTask* task = &tasks[num_tasks++];
+        task->sd        = sd;
+        task->fieldfunc = fieldfunc; // e.g. calcFieldTransYUV
+        task->index     = ci->index;
+        if (!sd->pool || tc_task_pool_submit(sd->pool, task) != TC_OK)
+            stabilize_field_run(task, 0, NULL);
+        tc_free(ci);
+    }
+    tc_list_fini(goodflds);
+    if (sd->pool)
+        tc_task_pool_wait(sd->pool);
+
+    for (j = 0; j < num_tasks; j++) {
+        i = tasks[j].index;
+        t = tasks[j].t;
 #ifdef STABVERBOSE
         fprintf(f, "%i %i\n%f %f %i\n \n\n", sd->fields[i].x, sd->fields[i].y, 
                 sd->fields[i].x + t.x, sd->fields[i].y + t.y, t.extra);
@@ -712,13 +730,15 @@ Transform calcTransFields(StabData* sd, calcFieldTransFunc fieldfunc,
             index++;
         }
     }
-    tc_list_fini(goodflds);
 
     t = null_transform();
     num_trans = index; // amount of transforms we actually have    
     if (num_trans < 1) {
         tc_log_warn(MOD_NAME, "too low contrast! No field remains.\n \
                     (no translations are detected in frame %i)", sd->t);
+        tc_free(ts);
+        tc_free(fs);
+        tc_free(angles);
         return t;
     }
         
@@ -777,9 +797,43 @@ Transform calcTransFields(StabData* sd, calcFieldTransFunc fieldfunc,
 #ifdef STABVERBOSE
     fclose(f);
 #endif
+    tc_free(ts);
+    tc_free(fs);
+    tc_free(angles);
     return t;
 }
 
+/* task function of the worker threads: search one measurement field */
+static void stabilize_field_run(void *task, int worker, void *userdata)
+{
+    FieldTask* ft = task;
+    StabData* sd  = ft->sd;
+
+    ft->t = ft->fieldfunc(sd, &sd->fields[ft->index], ft->index);
+}
+
+/* builds the smaller levels of the luminance pyramid of the current
+   frame for the coarse-to-fine search. The pyramid of the previous frame
+   is the one built when it was current, so each level is made only once.
+*/
+void buildPyramid(StabData* sd)
+{
+    uint8_t* buf  = sd->pyrbuf[sd->pyrcurr];
+    uint8_t* prev = sd->pyrbuf[!sd->pyrcurr];
+    int l;
+
+    sd->pyr_c[0] = sd->curr;
+    sd->pyr_p[0] = sd->prev;
+    for (l = 1; l < sd->levels; l++) {
+        int w = sd->width >> l, h = sd->height >> l;
+        ac_downsample2(sd->pyr_c[l-1], sd->pyr_stride[l-1], buf, w, w, h);
+        sd->pyr_c[l] = buf;
+        sd->pyr_p[l] = prev;
+        buf  += w*h;
+        prev += w*h;
+    }
+}
+
 /** draws the field scanning area */
 void drawFieldScanArea(StabData* sd, const Field* field, const Transform* t)
 {
@@ -952,6 +1006,8 @@ static int stabilize_configure(TCModuleInstance *self,
     sd->show        = 0;
     sd->contrast_threshold = 0.3; 
     sd->maxanglevariation = 1;
+    sd->threads     = 1;
+    sd->levels      = 1;
     
     if (options != NULL) {            
         // for some reason this plugin is called in the old fashion 
@@ -968,6 +1024,17 @@ static int stabilize_configure(TCModuleInstance *self,
         optstr_get(options, "algo",       "%d", &sd->algo);
         optstr_get(options, "mincontrast","%lf",&sd->contrast_threshold);
         optstr_get(options, "show",       "%d", &sd->show);
+        optstr_get(options, "threads",    "%d", &sd->threads);
+        optstr_get(options, "pyramid",    "%d", &sd->levels);
+    }
+    if (sd->threads < 1 && tc_sys_get_hw_threads(&sd->threads) != TC_OK)
+        sd->threads = 1;
+    sd->levels = TC_MIN(STAB_MAX_LEVELS, TC_MAX(1, sd->levels));
+    if (sd->levels > 1
+     && (sd->algo != 1 || sd->vob->im_v_codec != TC_CODEC_YUV420P)) {
+        tc_log_warn(MOD_NAME, "pyramid search needs algo=1 and YUV,"
+                    " switched off");
+        sd->levels = 1;
     }
     sd->shakiness = TC_MIN(10,TC_MAX(1,sd->shakiness));
     sd->accuracy  = TC_MAX(sd->shakiness,TC_MIN(15,TC_MAX(1,sd->accuracy)));
@@ -979,12 +1046,17 @@ static int stabilize_configure(TCModuleInstance *self,
         tc_log_info(MOD_NAME, "          algo = %d", sd->algo);
         tc_log_info(MOD_NAME, "   mincontrast = %f", sd->contrast_threshold);
         tc_log_info(MOD_NAME, "          show = %d", sd->show);
+        tc_log_info(MOD_NAME, "       threads = %d", sd->threads);
+        tc_log_info(MOD_NAME, "       pyramid = %d", sd->levels);
         tc_log_info(MOD_NAME, "        result = %s", sd->result);
     }
 
     // shift and size: shakiness 1: height/40; 10: height/4
     sd->maxshift    = TC_MIN(sd->width, sd->height)*sd->shakiness/40;
     sd->field_size   = TC_MIN(sd->width, sd->height)*sd->shakiness/40;
+    // the smallest level must keep a few pixels of each field
+    while (sd->levels > 1 && (sd->field_size >> (sd->levels - 1)) < 4)
+        sd->levels--;
   
     tc_log_info(MOD_NAME, "Fieldsize: %i, Maximal translation: %i pixel", 
                 sd->field_size, sd->maxshift);
@@ -996,6 +1068,34 @@ static int stabilize_configure(TCModuleInstance *self,
         sd->maxfields = (sd->accuracy) * sd->field_num / 15;
         tc_log_info(MOD_NAME, "Number of used measurement fields: %i out of %i",
                     sd->maxfields, sd->field_num);
+        sd->tasks = tc_malloc(sizeof(FieldTask) * sd->field_num);
+        if (!sd->tasks) {
+            tc_log_error(MOD_NAME, "malloc failed!");
+            return TC_ERROR;
+        }
+        if (sd->threads > 1) {
+            sd->pool = tc_task_pool_new(sd->threads, stabilize_field_run,
+                                        NULL, "stabilize");
+            if (!sd->pool)
+                tc_log_warn(MOD_NAME, "cannot start %i threads,"
+                            " searching in the filter thread", sd->threads);
+        }
+    }
+    if (sd->levels > 1) {
+        size_t pyrsize = 0;
+        int l;
+        for (l = 0; l < sd->levels; l++) {
+            sd->pyr_stride[l] = sd->width >> l;
+            if (l > 0)
+                pyrsize += (size_t)(sd->width >> l) * (sd->height >> l);
+        }
+        sd->pyrbuf[0] = tc_malloc(pyrsize);
+        sd->pyrbuf[1] = tc_malloc(pyrsize);
+        if (!sd->pyrbuf[0] || !sd->pyrbuf[1]) {
+            tc_log_error(MOD_NAME, "malloc failed!");
+            return TC_ERROR;
+        }
+        sd->pyrcurr = 0;
     }
     sd->f = fopen(sd->result, "w");
     if (sd->f == NULL) {
@@ -1036,8 +1136,11 @@ static int stabilize_filter_video(TCModuleInstance *self,
     if(sd->show)  // save the buffer to restore at the end for prev
         memcpy(sd->currcopy, frame->video_buf, sd->framesize);
     
+    sd->curr = frame->video_buf;
+    if (sd->levels > 1)
+        buildPyramid(sd);
+
     if (sd->hasSeenOneFrame) {
-        sd->curr = frame->video_buf;
         if (sd->vob->im_v_codec == TC_CODEC_RGB24) {
             if (sd->algo == 0)
                 addTrans(sd, calcShiftRGBSimple(sd));
@@ -1065,6 +1168,7 @@ static int stabilize_filter_video(TCModuleInstance *self,
     } else { // use the copy because we changed the original frame
         memcpy(sd->prev, sd->currcopy, sd->framesize);
     }
+    sd->pyrcurr = !sd->pyrcurr; // this pyramid is the previous one now
     sd->t++;
     return TC_OK;
 }
@@ -1101,6 +1205,18 @@ static int stabilize_stop(TCModuleInstance *self)
         sd->f = NULL;
     }
     tc_list_del(sd->transs, 1 );
+    sd->transs = NULL;
+    if (sd->pool) {
+        tc_task_pool_del(sd->pool);
+        sd->pool = NULL;
+    }
+    tc_free(sd->tasks);
+    sd->tasks = NULL;
+    tc_free(sd->fields);
+    sd->fields = NULL;
+    tc_free(sd->pyrbuf[0]);
+    tc_free(sd->pyrbuf[1]);
+    sd->pyrbuf[0] = sd->pyrbuf[1] = NULL;
     if (sd->prev) {
         tc_free(sd->prev);
         sd->prev = NULL;
@@ -1143,6 +1259,8 @@ static int stabilize_inspect(TCModuleInstance *self,
     CHECKPARAM("stepsize", "stepsize=%d",  sd->stepsize);
     CHECKPARAM("allowmax", "allowmax=%d",  sd->allowmax);
     CHECKPARAM("algo",     "algo=%d",      sd->algo);
+    CHECKPARAM("threads",  "threads=%d",   sd->threads);
+    CHECKPARAM("pyramid",  "pyramid=%d",   sd->levels);
     CHECKPARAM("result",   "result=%s",    sd->result);
     return TC_OK;
 }
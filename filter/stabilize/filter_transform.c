@@ -25,7 +25,7 @@
  */
 
 #define MOD_NAME    "filter_transform.so"
-#define MOD_VERSION "v0.77 (2010-05-02)"
+#define MOD_VERSION "v0.78 (2026-10-18)"
 #define MOD_CAP     "transforms each frame according to transformations\n\
  given in an input file (e.g. translation, rotate) see also filter stabilize"
 #define MOD_AUTHOR  "Georg Martius"
@@ -40,6 +40,7 @@
 #include "libtc/libtc.h"
 #include "libtc/tccodecs.h"
 #include "libtcutil/optstr.h"
+#include "libtcutil/tctaskpool.h"
 #include "libtcmodule/tcmodule-plugin.h"
 
 #include "transform.h"
@@ -56,6 +57,85 @@
 #define PIXELN(img, x, y, w, h, N,channel , def) ((x) < 0 || (y) < 0) ? def  \
     : (((x) >=w || (y) >= h) ? def : img[((x) + (y) * w)*N + channel]) 
 
+/* source coordinates are stepped along the rows in fixed point */
+#define TRANS_FRAC_BITS 16
+#define TRANS_ONE       (1 << TRANS_FRAC_BITS)
+/* fraction bits of the bi-cubic weights */
+#define BICUB_BITS      10
+
+/** 
+ * interpolateFunc: general interpolation function for one channel image data
+ *
+ * Parameters:
+ *             rv: destination pixel (call by reference)
+ *            x,y: the source coordinates in the image img. Note this 
+ *                 are real-value coordinates, that's why we interpolate
+ *            img: source image
+ *   width,height: dimension of image
+ *            def: default value if coordinates are out of range
+ * Return value:  None
+ */
+typedef void (*interpolateFunc)(unsigned char *rv, float x, float y, 
+                                unsigned char* img, int width, int height, 
+                                unsigned char def);
+
+/**
+ * interpolateRowFunc: interpolation of a run of pixels of one destination
+ *  row, all of them far enough inside the source image to need no border
+ *  handling (see TransInterpol).
+ *
+ * Parameters:
+ *           dest: first destination pixel
+ *              n: number of pixels
+ *         xs, ys: source coordinates of the first pixel (fixed point)
+ *       dxs, dys: source coordinate steps from one pixel to the next
+ *            img: source image
+ *         stride: bytes per row of the source image
+ *              N: bytes per pixel, each one interpolated separately
+ * Return value:  None
+ */
+typedef void (*interpolateRowFunc)(unsigned char* dest, int n,
+                                   int32_t xs, int32_t ys,
+                                   int32_t dxs, int32_t dys,
+                                   const unsigned char* img, int stride,
+                                   int N);
+
+/* row version of an interpolation type: pixels whose source coordinates
+ * have integer parts in [lo, size-hi) are done by `row', the others
+ * by the per pixel function */
+typedef struct {
+    interpolateRowFunc row; // NULL: per pixel only
+    int lo, hi;
+} TransInterpol;
+
+/* one plane of a frame to transform: the source of the destination
+ * pixel p_d is p_s = M^{-1}(p_d - c_d) + o, that is
+ *   x_s =  a*(x_d - c_d_x) + b*(y_d - c_d_y) + o_x
+ *   y_s = -b*(x_d - c_d_x) + a*(y_d - c_d_y) + o_y
+ */
+typedef struct {
+    unsigned char* src;
+    unsigned char* dest;
+    int width_src, height_src;
+    int width_dest, height_dest;
+    int N;                // bytes per pixel
+    int crop;             // 1: fill the background, 0: keep it
+    unsigned char fill;   // background value
+    int shift;            // 1: translation only, by shift_x, shift_y
+    int shift_x, shift_y;
+    double a, b;          // scaled cosine and sine of the rotation
+    double c_d_x, c_d_y;  // destination center
+    double o_x, o_y;      // source center minus translation
+    interpolateFunc interpolate;   // per pixel function (N == 1)
+    const TransInterpol* interpol; // row function
+} TransPlane;
+
+/* a band of rows of a plane: the work unit of the threads */
+typedef struct {
+    const TransPlane* plane;
+    int first, last;
+} TransBand;
+
 typedef struct {
     size_t framesize_src;  // size of frame buffer in bytes (src)
     size_t framesize_dest; // size of frame buffer in bytes (dest)
@@ -90,6 +170,11 @@ typedef struct {
     int optzoom;      // 1: determine optimal zoom, 0: nothing
     int interpoltype; // type of interpolation: 0->Zero,1->Lin,2->BiLin,3->Sqr
     double sharpen;   // amount of sharpening
+    interpolateFunc interpolate; // per pixel function of interpoltype
+
+    /* worker threads transforming bands of rows (NULL: filter thread) */
+    int threads;
+    TCTaskPool* pool;
 
     char input[TC_BUF_LINE];
     FILE* f;
@@ -125,6 +210,8 @@ static const char transform_help[] = ""
     "                3: quadratic 4: bi-cubic\n"
     "    'sharpen'   amount of sharpening: 0: no sharpening (def: 0.8)\n"
     "                uses filter unsharp with 5x5 matrix\n"
+    "    'threads'   number of threads transforming the rows; 0: one per\n"
+    "                CPU (def: 1)\n"
     "    'help'      print this help message\n";
 
 /* forward declarations, please look below for documentation*/
@@ -143,27 +230,41 @@ void interpolateZero(unsigned char *rv, float x, float y,
 void interpolateN(unsigned char *rv, float x, float y, 
                   unsigned char* img, int width, int height, 
                   unsigned char N, unsigned char channel, unsigned char def);
+static void interpolateZeroRow(unsigned char* dest, int n,
+                               int32_t xs, int32_t ys,
+                               int32_t dxs, int32_t dys,
+                               const unsigned char* img, int stride, int N);
+static void interpolateLinRow(unsigned char* dest, int n,
+                              int32_t xs, int32_t ys,
+                              int32_t dxs, int32_t dys,
+                              const unsigned char* img, int stride, int N);
+static void interpolateBiLinRow(unsigned char* dest, int n,
+                                int32_t xs, int32_t ys,
+                                int32_t dxs, int32_t dys,
+                                const unsigned char* img, int stride, int N);
+static void interpolateBiCubRow(unsigned char* dest, int n,
+                                int32_t xs, int32_t ys,
+                                int32_t dxs, int32_t dys,
+                                const unsigned char* img, int stride, int N);
+static void transform_band_run(void *task, int worker, void *userdata);
 int transformRGB(TransformData* td);
 int transformYUV(TransformData* td);
 int read_input_file(TransformData* td);
 int preprocess_transforms(TransformData* td);
 
 
-/** 
- * interpolate: general interpolation function pointer for one channel image data
- *
- * Parameters:
- *             rv: destination pixel (call by reference)
- *            x,y: the source coordinates in the image img. Note this 
- *                 are real-value coordinates, that's why we interpolate
- *            img: source image
- *   width,height: dimension of image
- *            def: default value if coordinates are out of range
- * Return value:  None
- */
-void (*interpolate)(unsigned char *rv, float x, float y, 
-                    unsigned char* img, int width, int height, 
-                    unsigned char def) = 0;
+/* row versions of the interpolation types, in interpoltype order
+ * (quadratic has none); the bi-linear one also serves RGB */
+static const TransInterpol interpolRows[5] = {
+    { interpolateZeroRow,  0, 1 },
+    { interpolateLinRow,   0, 1 },
+    { interpolateBiLinRow, 0, 1 },
+    { NULL,                0, 1 },
+    { interpolateBiCubRow, 1, 3 },
+};
+
+/* bi-cubic weights of the four neighbours for each 1/256 pixel position */
+static int16_t bicub_weights[256][4];
 
 /** interpolateBiLinBorder: bi-linear interpolation function that also works at the border.
     This is used by many other interpolation methods at and outsize the border, see interpolate */
@@ -340,6 +441,322 @@ void interpolateN(unsigned char *rv, float x, float y,
 }
 
 
+/** initBiCubWeights: fills bicub_weights, see bicub_kernel */
+static void initBiCubWeights(void)
+{
+    int i, k;
+    for (i = 0; i < 256; i++) {
+        double t = i / 256.0;
+        double w[4] = { (-t + 2*t*t - t*t*t) / 2,
+                        (2 - 5*t*t + 3*t*t*t) / 2,
+                        (t + 4*t*t - 3*t*t*t) / 2,
+                        (-t*t + t*t*t) / 2 };
+        int sum = 0;
+        for (k = 0; k < 4; k++) {
+            bicub_weights[i][k] = lrint(w[k] * (1 << BICUB_BITS));
+            sum += bicub_weights[i][k];
+        }
+        // the weights must add up to exactly one
+        bicub_weights[i][t < 0.5 ? 1 : 2] += (1 << BICUB_BITS) - sum;
+    }
+}
+
+/** interpolateZeroRow: nearest neighbor, see interpolateRowFunc */
+static void interpolateZeroRow(unsigned char* dest, int n,
+                               int32_t xs, int32_t ys,
+                               int32_t dxs, int32_t dys,
+                               const unsigned char* img, int stride, int N)
+{
+    int i;
+    xs += TRANS_ONE/2;
+    ys += TRANS_ONE/2;
+    for (i = 0; i < n; i++) {
+        dest[i] = img[(ys >> TRANS_FRAC_BITS) * stride
+                      + (xs >> TRANS_FRAC_BITS)];
+        xs += dxs;
+        ys += dys;
+    }
+}
+
+/** interpolateLinRow: linear (only x), see interpolateRowFunc */
+static void interpolateLinRow(unsigned char* dest, int n,
+                              int32_t xs, int32_t ys,
+                              int32_t dxs, int32_t dys,
+                              const unsigned char* img, int stride, int N)
+{
+    int i;
+    ys += TRANS_ONE/2;
+    for (i = 0; i < n; i++) {
+        const unsigned char* p = img + (ys >> TRANS_FRAC_BITS) * stride
+                                     + (xs >> TRANS_FRAC_BITS);
+        int fx = (xs >> (TRANS_FRAC_BITS - 8)) & 0xFF;
+        dest[i] = (p[0] * (256 - fx) + p[1] * fx + 128) >> 8;
+        xs += dxs;
+        ys += dys;
+    }
+}
+
+/** interpolateBiLinRow: bi-linear, for N channels, see interpolateRowFunc */
+static void interpolateBiLinRow(unsigned char* dest, int n,
+                                int32_t xs, int32_t ys,
+                                int32_t dxs, int32_t dys,
+                                const unsigned char* img, int stride, int N)
+{
+    int i, z;
+    if (N == 1) { // the common case, without the channel loop
+        for (i = 0; i < n; i++) {
+            const unsigned char* p = img + (ys >> TRANS_FRAC_BITS) * stride
+                                         + (xs >> TRANS_FRAC_BITS);
+            int fx = (xs >> (TRANS_FRAC_BITS - 8)) & 0xFF;
+            int fy = (ys >> (TRANS_FRAC_BITS - 8)) & 0xFF;
+            int top = p[0] * (256 - fx) + p[1] * fx;
+            int bot = p[stride] * (256 - fx) + p[stride + 1] * fx;
+            dest[i] = (top * (256 - fy) + bot * fy + 32768) >> 16;
+            xs += dxs;
+            ys += dys;
+        }
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        const unsigned char* p = img + (ys >> TRANS_FRAC_BITS) * stride
+                                     + (xs >> TRANS_FRAC_BITS) * N;
+        int fx = (xs >> (TRANS_FRAC_BITS - 8)) & 0xFF;
+        int fy = (ys >> (TRANS_FRAC_BITS - 8)) & 0xFF;
+        for (z = 0; z < N; z++) {
+            int top = p[z] * (256 - fx) + p[z + N] * fx;
+            int bot = p[z + stride] * (256 - fx) + p[z + stride + N] * fx;
+            dest[z] = (top * (256 - fy) + bot * fy + 32768) >> 16;
+        }
+        dest += N;
+        xs += dxs;
+        ys += dys;
+    }
+}
+
+/** interpolateBiCubRow: bi-cubic with tabulated weights, 
+    see interpolateRowFunc */
+static void interpolateBiCubRow(unsigned char* dest, int n,
+                                int32_t xs, int32_t ys,
+                                int32_t dxs, int32_t dys,
+                                const unsigned char* img, int stride, int N)
+{
+    int i, j;
+    for (i = 0; i < n; i++) {
+        const unsigned char* p = img
+            + ((ys >> TRANS_FRAC_BITS) - 1) * stride
+            + (xs >> TRANS_FRAC_BITS) - 1;
+        const int16_t* wx = bicub_weights[(xs >> (TRANS_FRAC_BITS-8)) & 0xFF];
+        const int16_t* wy = bicub_weights[(ys >> (TRANS_FRAC_BITS-8)) & 0xFF];
+        int32_t s = 0;
+        for (j = 0; j < 4; j++, p += stride) {
+            s += wy[j] * (wx[0]*p[0] + wx[1]*p[1] + wx[2]*p[2] + wx[3]*p[3]);
+        }
+        s = (s + (1 << (2*BICUB_BITS - 1))) >> (2*BICUB_BITS);
+        dest[i] = TC_CLAMP(s, 0, 255);
+        xs += dxs;
+        ys += dys;
+    }
+}
+
+/**
+ * clipSpan: narrows the run [*x0, *x1) of destination pixels to those
+ *  whose source coordinate c + x*dc (fixed point) lies in [min, max).
+ *  The run is estimated in floating point and its ends then checked
+ *  exactly, so it may come out short but never too long.
+ */
+static void clipSpan(int32_t c, int32_t dc, int32_t min, int32_t max,
+                     int* x0, int* x1)
+{
+    int a = *x0, b = *x1;
+    if (dc == 0) {
+        if (c < min || c >= max)
+            b = a;
+    } else {
+        double lo = ((double)min - c) / dc;
+        double hi = ((double)max - c) / dc;
+        if (dc < 0) {
+            double tmp = lo;
+            lo = hi;
+            hi = tmp;
+        }
+        if (lo > a)
+            a = (lo > b) ? b : (int)ceil(lo);
+        if (hi < b)
+            b = (hi < a) ? a : (int)floor(hi) + 1;
+        while (a < b && (c + (int64_t)a*dc < min || c + (int64_t)a*dc >= max))
+            a++;
+        while (a < b && (c + (int64_t)(b-1)*dc < min
+                         || c + (int64_t)(b-1)*dc >= max))
+            b--;
+    }
+    *x0 = a;
+    *x1 = b;
+}
+
+/**
+ * transformPixels: per pixel interpolation of the destination pixels
+ *  [from, to) of a row, which also handles the image border.
+ */
+static void transformPixels(const TransPlane* p, unsigned char* row,
+                            int from, int to, int32_t xs, int32_t ys,
+                            int32_t dxs, int32_t dys)
+{
+    int x, z;
+    for (x = from; x < to; x++) {
+        float x_s = (xs + x*dxs) / (float)TRANS_ONE;
+        float y_s = (ys + x*dys) / (float)TRANS_ONE;
+        for (z = 0; z < p->N; z++) {
+            unsigned char* dest = &row[x*p->N + z];
+            unsigned char def = p->crop ? p->fill : *dest;
+            if (p->N == 1)
+                p->interpolate(dest, x_s, y_s, p->src,
+                               p->width_src, p->height_src, def);
+            else
+                interpolateN(dest, x_s, y_s, p->src,
+                             p->width_src, p->height_src, p->N, z, def);
+        }
+    }
+}
+
+/**
+ * transformRows: transforms the rows [first, last) of a plane.
+ *  The source coordinates advance by a constant step along a row, so
+ *  only the start of each row is computed from the rotation matrix; the
+ *  run of pixels clear of the border is handed to the row function.
+ */
+static void transformRows(const TransPlane* p, int first, int last)
+{
+    int N = p->N;
+    int y;
+
+    if (p->shift) { // no rotation, no zoom, just translation
+        int x0 = TC_MAX(0, p->shift_x);
+        int x1 = TC_MIN(p->width_dest, p->width_src + p->shift_x);
+        for (y = first; y < last; y++) {
+            unsigned char* row = p->dest + (size_t)y * p->width_dest * N;
+            int y_s = y - p->shift_y;
+            if (y_s < 0 || y_s >= p->height_src || x0 >= x1) {
+                if (p->crop)
+                    memset(row, p->fill, p->width_dest * N);
+                continue;
+            }
+            memcpy(row + x0*N, p->src + ((size_t)y_s * p->width_src
+                                         + x0 - p->shift_x) * N,
+                   (x1 - x0) * N);
+            if (p->crop) {
+                memset(row, p->fill, x0*N);
+                memset(row + x1*N, p->fill, (p->width_dest - x1) * N);
+            }
+        }
+    } else {
+        int32_t dxs  = lrint(p->a * TRANS_ONE);
+        int32_t dys  = lrint(-p->b * TRANS_ONE);
+        int32_t xmin = p->interpol->lo << TRANS_FRAC_BITS;
+        int32_t ymin = p->interpol->lo << TRANS_FRAC_BITS;
+        int32_t xmax = (p->width_src - p->interpol->hi) << TRANS_FRAC_BITS;
+        int32_t ymax = (p->height_src - p->interpol->hi) << TRANS_FRAC_BITS;
+        for (y = first; y < last; y++) {
+            unsigned char* row = p->dest + (size_t)y * p->width_dest * N;
+            double x_d1 = -p->c_d_x;
+            double y_d1 = y - p->c_d_y;
+            int32_t xs = lrint(( p->a*x_d1 + p->b*y_d1 + p->o_x) * TRANS_ONE);
+            int32_t ys = lrint((-p->b*x_d1 + p->a*y_d1 + p->o_y) * TRANS_ONE);
+            int x0 = 0, x1 = p->width_dest;
+            if (p->interpol->row) {
+                clipSpan(xs, dxs, xmin, xmax, &x0, &x1);
+                clipSpan(ys, dys, ymin, ymax, &x0, &x1);
+            } else {
+                x0 = x1 = p->width_dest;
+            }
+            transformPixels(p, row, 0, x0, xs, ys, dxs, dys);
+            if (x0 < x1)
+                p->interpol->row(row + x0*N, x1 - x0, xs + x0*dxs,
+                                 ys + x0*dys, dxs, dys, p->src,
+                                 p->width_src * N, N);
+            transformPixels(p, row, x1, p->width_dest, xs, ys, dxs, dys);
+        }
+    }
+}
+
+/* task function of the worker threads: transform one band of rows */
+static void transform_band_run(void *task, int worker, void *userdata)
+{
+    TransBand* band = task;
+
+    transformRows(band->plane, band->first, band->last);
+}
+
+/**
+ * transformPlanes: transforms the given planes, in bands of rows on the
+ *  worker threads if there are any.
+ */
+static void transformPlanes(TransformData* td, const TransPlane* planes,
+                            int nplanes)
+{
+    int nbands = td->pool ? tc_task_pool_workers(td->pool) : 1;
+    int i, b;
+
+    if (nbands > 1) {
+        TransBand bands[nplanes * nbands];
+        for (i = 0; i < nplanes; i++) {
+            for (b = 0; b < nbands; b++) {
+                TransBand* band = &bands[i*nbands + b];
+                band->plane = &planes[i];
+                band->first = planes[i].height_dest * b / nbands;
+                band->last  = planes[i].height_dest * (b+1) / nbands;
+                if (tc_task_pool_submit(td->pool, band) != TC_OK)
+                    transform_band_run(band, 0, NULL);
+            }
+        }
+        tc_task_pool_wait(td->pool);
+    } else {
+        for (i = 0; i < nplanes; i++)
+            transformRows(&planes[i], 0, planes[i].height_dest);
+    }
+}
+
+/**
+ * setupPlane: fills in a TransPlane for the current transformation.
+ *
+ * Parameters:
+ *         td: private data structure of this filter
+ *          p: plane to set up
+ *   src,dest: source and destination plane
+ *        div: subsampling of the plane (1: full size, 2: half size)
+ *          N: bytes per pixel
+ *       fill: background value for crop
+ *          t: the transformation
+ *       zoom: scale factor
+ *     rotate: 0 to only translate by whole pixels
+ * Return value:  None
+ */
+static void setupPlane(TransformData* td, TransPlane* p,
+                       unsigned char* src, unsigned char* dest,
+                       int div, int N, unsigned char fill,
+                       const Transform* t, double zoom, int rotate)
+{
+    p->src         = src;
+    p->dest        = dest;
+    p->width_src   = td->width_src / div;
+    p->height_src  = td->height_src / div;
+    p->width_dest  = td->width_dest / div;
+    p->height_dest = td->height_dest / div;
+    p->N           = N;
+    p->crop        = td->crop;
+    p->fill        = fill;
+    p->shift       = !rotate;
+    p->shift_x     = myround(t->x / div);
+    p->shift_y     = myround(t->y / div);
+    p->a           = zoom * cos(-t->alpha);
+    p->b           = zoom * sin(-t->alpha);
+    p->c_d_x       = td->width_dest / 2.0 / div;
+    p->c_d_y       = td->height_dest / 2.0 / div;
+    p->o_x         = (td->width_src / 2.0 - t->x) / div;
+    p->o_y         = (td->height_src / 2.0 - t->y) / div;
+    p->interpolate = td->interpolate;
+    p->interpol    = &interpolRows[N == 1 ? td->interpoltype : 2];
+}
+
 /** 
  * transformRGB: applies current transformation to frame
  * Parameters:
@@ -351,17 +768,8 @@ void interpolateN(unsigned char *rv, float x, float y,
  */
 int transformRGB(TransformData* td)
 {
-    Transform t;
-    int x = 0, y = 0, z = 0;
-    unsigned char *D_1, *D_2;
-    t = td->trans[td->current_trans];
-  
-    D_1  = td->src;  
-    D_2  = td->dest;  
-    float c_s_x = td->width_src/2.0;
-    float c_s_y = td->height_src/2.0;
-    float c_d_x = td->width_dest/2.0;
-    float c_d_y = td->height_dest/2.0;    
+    Transform t = td->trans[td->current_trans];
+    TransPlane plane;
 
     /* for each pixel in the destination image we calc the source
      * coordinate and make an interpolation: 
@@ -370,46 +778,13 @@ int transformRGB(TransformData* td)
      *  _s source and _d destination, 
      *  t the translation, and M the rotation matrix
      *      p_s = M^{-1}(p_d - c_d - t) + c_s
+     * All 3 channels are interpolated bi-linearly. Without rotation
+     * there is just translation (also no interpolation, since no size
+     * change (so far))
      */
-    /* All 3 channels */
-    if (fabs(t.alpha) > td->rotation_threshhold) {
-        for (x = 0; x < td->width_dest; x++) {
-            for (y = 0; y < td->height_dest; y++) {
-                float x_d1 = (x - c_d_x);
-                float y_d1 = (y - c_d_y);
-                float x_s  =  cos(-t.alpha) * x_d1 
-                    + sin(-t.alpha) * y_d1 + c_s_x -t.x;
-                float y_s  = -sin(-t.alpha) * x_d1 
-                    + cos(-t.alpha) * y_d1 + c_s_y -t.y;                
-                for (z = 0; z < 3; z++) { // iterate over colors 
-                    unsigned char* dest = &D_2[(x + y * td->width_dest)*3+z];
-                    interpolateN(dest, x_s, y_s, D_1, 
-                                 td->width_src, td->height_src, 
-                                 3, z, td->crop ? 16 : *dest);
-                }
-            }
-        }
-     }else { 
-        /* no rotation, just translation 
-         *(also no interpolation, since no size change (so far) 
-         */
-        int round_tx = myround(t.x);
-        int round_ty = myround(t.y);
-        for (x = 0; x < td->width_dest; x++) {
-            for (y = 0; y < td->height_dest; y++) {
-                for (z = 0; z < 3; z++) { // iterate over colors
-                    short p = PIXELN(D_1, x - round_tx, y - round_ty, 
-                                     td->width_src, td->height_src, 3, z, -1);
-                    if (p == -1) {
-                        if (td->crop == 1)
-                            D_2[(x + y * td->width_dest)*3+z] = 16;
-                    } else {
-                        D_2[(x + y * td->width_dest)*3+z] = (unsigned char)p;
-                    }
-                }
-            }
-        }
-    }
+    setupPlane(td, &plane, td->src, td->dest, 1, 3, 16, &t, 1.0,
+               fabs(t.alpha) > td->rotation_threshhold);
+    transformPlanes(td, &plane, 1);
     return 1;
 }
 
@@ -425,25 +800,12 @@ int transformRGB(TransformData* td)
  */
 int transformYUV(TransformData* td)
 {
-    Transform t;
-    int x = 0, y = 0;
-    unsigned char *Y_1, *Y_2, *Cb_1, *Cb_2, *Cr_1, *Cr_2;
-    t = td->trans[td->current_trans];
-  
-    Y_1  = td->src;  
-    Y_2  = td->dest;  
-    Cb_1 = td->src + td->width_src * td->height_src;
-    Cb_2 = td->dest + td->width_dest * td->height_dest;
-    Cr_1 = td->src + 5*td->width_src * td->height_src/4;
-    Cr_2 = td->dest + 5*td->width_dest * td->height_dest/4;
-    float c_s_x = td->width_src/2.0;
-    float c_s_y = td->height_src/2.0;
-    float c_d_x = td->width_dest/2.0;
-    float c_d_y = td->height_dest/2.0;    
-    
-    float z = 1.0-t.zoom/100;
-    float zcos_a = z*cos(-t.alpha); // scaled cos
-    float zsin_a = z*sin(-t.alpha); // scaled sin
+    Transform t = td->trans[td->current_trans];
+    TransPlane planes[3];
+    int size_src  = td->width_src * td->height_src;
+    int size_dest = td->width_dest * td->height_dest;
+    double z = 1.0 - t.zoom/100;
+    int rotate = fabs(t.alpha) > td->rotation_threshhold || t.zoom != 0;
 
     /* for each pixel in the destination image we calc the source
      * coordinate and make an interpolation: 
@@ -452,86 +814,16 @@ int transformYUV(TransformData* td)
      *  _s source and _d destination, 
      *  t the translation, and M the rotation and scaling matrix
      *      p_s = M^{-1}(p_d - c_d - t) + c_s
+     * Without rotation and zoom there is just translation (also no
+     * interpolation, since no size change)
      */
-    /* Luminance channel */
-    if (fabs(t.alpha) > td->rotation_threshhold || t.zoom != 0) {
-        for (x = 0; x < td->width_dest; x++) {
-            for (y = 0; y < td->height_dest; y++) {
-                float x_d1 = (x - c_d_x);
-                float y_d1 = (y - c_d_y);
-                float x_s  =  zcos_a * x_d1 
-                    + zsin_a * y_d1 + c_s_x -t.x;
-                float y_s  = -zsin_a * x_d1 
-                    + zcos_a * y_d1 + c_s_y -t.y;
-                unsigned char* dest = &Y_2[x + y * td->width_dest];
-                interpolate(dest, x_s, y_s, Y_1, 
-                            td->width_src, td->height_src, 
-                            td->crop ? 16 : *dest);
-            }
-        }
-     }else { 
-        /* no rotation, no zooming, just translation 
-         *(also no interpolation, since no size change) 
-         */
-        int round_tx = myround(t.x);
-        int round_ty = myround(t.y);
-        for (x = 0; x < td->width_dest; x++) {
-            for (y = 0; y < td->height_dest; y++) {
-                short p = PIXEL(Y_1, x - round_tx, y - round_ty, 
-                                td->width_src, td->height_src, -1);
-                if (p == -1) {
-                    if (td->crop == 1)
-                        Y_2[x + y * td->width_dest] = 16;
-                } else {
-                    Y_2[x + y * td->width_dest] = (unsigned char)p;
-                }
-            }
-        }
-    }
-
-    /* Color channels */
-    int ws2 = td->width_src/2;
-    int wd2 = td->width_dest/2;
-    int hs2 = td->height_src/2;
-    int hd2 = td->height_dest/2;
-    if (fabs(t.alpha) > td->rotation_threshhold || t.zoom != 0) {
-        for (x = 0; x < wd2; x++) {
-            for (y = 0; y < hd2; y++) {
-                float x_d1 = x - (c_d_x)/2;
-                float y_d1 = y - (c_d_y)/2;
-                float x_s  =  zcos_a * x_d1 
-                    + zsin_a * y_d1 + (c_s_x -t.x)/2;
-                float y_s  = -zsin_a * x_d1 
-                    + zcos_a * y_d1 + (c_s_y -t.y)/2;
-                unsigned char* dest = &Cr_2[x + y * wd2];
-                interpolate(dest, x_s, y_s, Cr_1, ws2, hs2, 
-                            td->crop ? 128 : *dest);
-                dest = &Cb_2[x + y * wd2];
-                interpolate(dest, x_s, y_s, Cb_1, ws2, hs2, 
-                            td->crop ? 128 : *dest);      	
-            }
-        }
-    } else { // no rotation, no zoom, no interpolation, just translation 
-        int round_tx2 = myround(t.x/2.0);
-        int round_ty2 = myround(t.y/2.0);        
-        for (x = 0; x < wd2; x++) {
-            for (y = 0; y < hd2; y++) {
-                short cr = PIXEL(Cr_1, x - round_tx2, y - round_ty2, 
-                                 wd2, hd2, -1);
-                short cb = PIXEL(Cb_1, x - round_tx2, y - round_ty2, 
-                                 wd2, hd2, -1);
-                if (cr == -1) {
-                    if (td->crop==1) { 
-                        Cr_2[x + y * wd2] = 128;
-                        Cb_2[x + y * wd2] = 128;
-                    }
-                } else {
-                    Cr_2[x + y * wd2] = (unsigned char)cr;
-                    Cb_2[x + y * wd2] = (unsigned char)cb;
-                }
-            }
-        }
-    }
+    setupPlane(td, &planes[0], td->src, td->dest, 1, 1, 16,
+               &t, z, rotate);
+    setupPlane(td, &planes[1], td->src + size_src, td->dest + size_dest,
+               2, 1, 128, &t, z, rotate);
+    setupPlane(td, &planes[2], td->src + 5*size_src/4,
+               td->dest + 5*size_dest/4, 2, 1, 128, &t, z, rotate);
+    transformPlanes(td, planes, 3);
     return 1;
 }
 
@@ -834,6 +1126,7 @@ static int transform_configure(TCModuleInstance *self,
     td->optzoom = 1;
     td->interpoltype = 2; // bi-linear
     td->sharpen = 0.8;
+    td->threads = 1;
   
     if (options != NULL) {
         optstr_get(options, "input", "%[^:]", (char*)&td->input);
@@ -864,8 +1157,11 @@ static int transform_configure(TCModuleInstance *self,
         optstr_get(options, "optzoom"  , "%d", &td->optzoom);
         optstr_get(options, "interpol" , "%d", &td->interpoltype);
         optstr_get(options, "sharpen"  , "%lf",&td->sharpen);
+        optstr_get(options, "threads"  , "%d", &td->threads);
     }
-    td->interpoltype = TC_MIN(td->interpoltype,4);
+    td->interpoltype = TC_MAX(0, TC_MIN(td->interpoltype,4));
+    if (td->threads < 1 && tc_sys_get_hw_threads(&td->threads) != TC_OK)
+        td->threads = 1;
     if (verbose) {
         tc_log_info(MOD_NAME, "Image Transformation/Stabilization Settings:");
         tc_log_info(MOD_NAME, "    input     = %s", td->input);
@@ -884,6 +1180,7 @@ static int transform_configure(TCModuleInstance *self,
         tc_log_info(MOD_NAME, "    interpol  = %s", 
                     interpoltypes[td->interpoltype]);
         tc_log_info(MOD_NAME, "    sharpen   = %f", td->sharpen);
+        tc_log_info(MOD_NAME, "    threads   = %d", td->threads);
     }
   
     if (td->maxshift > td->width_dest/2
@@ -897,12 +1194,26 @@ static int transform_configure(TCModuleInstance *self,
     }  
 
     switch(td->interpoltype){
-      case 0:  interpolate = &interpolateZero; break;
-      case 1:  interpolate = &interpolateLin; break;
-      case 2:  interpolate = &interpolateBiLin; break;
-      case 3:  interpolate = &interpolateSqr; break;
-      case 4:  interpolate = &interpolateBiCub; break;
-      default: interpolate = &interpolateBiLin;
+      case 0:  td->interpolate = &interpolateZero; break;
+      case 1:  td->interpolate = &interpolateLin; break;
+      case 2:  td->interpolate = &interpolateBiLin; break;
+      case 3:  td->interpolate = &interpolateSqr; break;
+      case 4:  td->interpolate = &interpolateBiCub; break;
+      default: td->interpolate = &interpolateBiLin;
+    }
+    if (td->interpoltype == 4)
+        initBiCubWeights();
+
+    if (td->pool) {
+        tc_task_pool_del(td->pool);
+        td->pool = NULL;
+    }
+    if (td->threads > 1) {
+        td->pool = tc_task_pool_new(td->threads, transform_band_run, NULL,
+                                    "transform");
+        if (!td->pool)
+            tc_log_warn(MOD_NAME, "cannot start %i threads, transforming"
+                        " in the filter thread", td->threads);
     }
 
     /* Is this the right point to add the filter? Seems to be the case.*/
@@ -993,6 +1304,10 @@ static int transform_stop(TCModuleInstance *self)
         fclose(td->f);
         td->f = NULL;
     }
+    if (td->pool) {
+        tc_task_pool_del(td->pool);
+        td->pool = NULL;
+    }
     return TC_OK;
 }
 
@@ -1031,6 +1346,7 @@ static int transform_inspect(TCModuleInstance *self,
     CHECKPARAM("optzoom",  "optzoom=%i",   td->optzoom);
     CHECKPARAM("zoom",     "zoom=%f",      td->zoom);
     CHECKPARAM("sharpen",  "sharpen=%f",   td->sharpen);
+    CHECKPARAM("threads",  "threads=%d",   td->threads);
         
     return TC_OK;
 };
@@ -1091,7 +1407,6 @@ TC_FILTER_OLDINTERFACE(transform)
 /*
   TODO:
   - add also linear interapolation
-  - check for optimization, e.g. mmx stuff
 */
 
 /*
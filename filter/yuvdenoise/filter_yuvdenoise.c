@@ -23,7 +23,7 @@
  */
 
 #define MOD_NAME    "filter_yuvdenoise.so"
-#define MOD_VERSION "v0.2.1 (2003-11-26)"
+#define MOD_VERSION "v0.2.2 (2026-10-18)"
 #define MOD_CAP     "mjpegs YUV denoiser"
 #define MOD_AUTHOR  "Stefan Fendt, Tilmann Bitterberg"
 
@@ -55,9 +55,6 @@ void display_help(void);
 
 struct DNSR_GLOBAL denoiser;
 
-extern uint32_t (*calc_SAD)         (uint8_t * , uint8_t * );
-extern uint32_t (*calc_SAD_uv)      (uint8_t * , uint8_t * );
-extern uint32_t (*calc_SAD_half)    (uint8_t * , uint8_t * ,uint8_t *);
 extern void     (*deinterlace)      (void);
 
 
@@ -525,40 +522,24 @@ void print_settings(void)
 void turn_on_accels(void)
 {
 /* XXX: very weird effects, #undef'ed in global.h -- tibit */
-#ifdef HAVE_ASM_MMX
+/* The block SADs come from aclib; only the deinterlacer is chosen here,
+ * and its MMX version only exists for 32-bit x86. */
+#if defined(HAVE_ASM_MMX) && defined(ARCH_X86)
   uint32_t CPU_CAP = tc_get_session()->acceleration; /* XXX ugly */
 
-  if( (CPU_CAP & AC_MMXEXT)!=0 ||
-      (CPU_CAP & AC_SSE   )!=0
-    ) /* MMX+SSE */
+  if( (CPU_CAP & AC_MMX)!=0 ) /* MMX */
   {
-    calc_SAD    = &calc_SAD_mmxe;
-    calc_SAD_uv = &calc_SAD_uv_mmxe;
-    calc_SAD_half = &calc_SAD_half_mmxe;
     deinterlace = &deinterlace_mmx;
     if (filter_verbose)
-	tc_log_info(MOD_NAME, "Using extended MMX SIMD optimisations.");
+      tc_log_info(MOD_NAME, "Using MMX SIMD optimisations.");
   }
   else
-    if( (CPU_CAP & AC_MMX)!=0 ) /* MMX */
-    {
-      calc_SAD    = &calc_SAD_mmx;
-      calc_SAD_uv = &calc_SAD_uv_mmx;
-      calc_SAD_half = &calc_SAD_half_mmx;
-      deinterlace = &deinterlace_mmx;
-      if (filter_verbose)
-	  tc_log_info(MOD_NAME, "Using MMX SIMD optimisations.");
-    }
-    else
 #endif
-    {
-      calc_SAD    = &calc_SAD_noaccel;
-      calc_SAD_uv = &calc_SAD_uv_noaccel;
-      calc_SAD_half = &calc_SAD_half_noaccel;
-      deinterlace = &deinterlace_noaccel;
-      if (filter_verbose)
-	  tc_log_info(MOD_NAME, "Sorry, no SIMD optimisations available.");
-    }
+  {
+    deinterlace = &deinterlace_noaccel;
+    if (filter_verbose)
+      tc_log_info(MOD_NAME, "Sorry, no SIMD optimisations available.");
+  }
 }
 
 void
@@ -13,11 +13,7 @@
 #include "mjpeg_types.h"
 #include "global.h"
 #include "motion.h"
-
-/* pointers on SAD functions */
-uint32_t (*calc_SAD)         (uint8_t * , uint8_t * );
-uint32_t (*calc_SAD_uv)      (uint8_t * , uint8_t * );
-uint32_t (*calc_SAD_half)    (uint8_t * , uint8_t * ,uint8_t *);
+#include "aclib/ac.h"
 
 /* global denoiser structure defined in main.c and global.h */
 extern struct DNSR_GLOBAL denoiser;
@@ -111,315 +107,28 @@ subsample_frame (uint8_t * dst[3], uint8_t * src[3])
 
 /*********************************************************************
  *                                                                   *
- * SAD-function for Y without MMX/MMXE                               *
- *                                                                   *
- *********************************************************************/
-
-uint32_t
-calc_SAD_noaccel (uint8_t * frm, uint8_t * ref)
-{
-  uint8_t dx = 0;
-  uint8_t dy = 0;
-  int32_t Y = 0;
-  uint32_t d = 0;
-
-  for(dy=0;dy<8;dy++)
-    for(dx=0;dx<8;dx++)
-    {
-      Y=*(frm+dx+dy*denoiser.frame.w)-*(ref+dx+dy*denoiser.frame.w);
-      d+=(Y<0)? -Y:Y;
-    }
-  return d;
-}
-
-/*********************************************************************
- *                                                                   *
- * SAD-function for Y with MMX                                       *
- *                                                                   *
- *********************************************************************/
-
-uint32_t
-calc_SAD_mmx (uint8_t * frm, uint8_t * ref)
-{
-  static uint16_t a[4];
-
-#ifdef ARCH_X86
-#ifdef HAVE_ASM_MMX
-  __asm__ __volatile__
-    (
-    " pxor        %%mm0 , %%mm0;           /* clear mm0                                          */\n"
-    " pxor        %%mm7 , %%mm7;           /* clear mm7                                          */\n"
-    "                                      /*                                                    */\n"
-    ".rept 8                    ;          /* Loop for 8 lines                                   */\n"
-    " movq        (%%esi), %%mm1;          /* 8 Pixels from filtered frame to mm1                */\n"
-    " movq        (%%edi), %%mm2;          /* 8 Pixels from reference frame to mm2               */\n"
-    " movq         %%mm2 , %%mm3;          /* hold a copy of mm2 in mm3                          */\n"
-    " psubusb      %%mm1 , %%mm3;          /* positive differences between mm2 and mm1           */\n"
-    " psubusb      %%mm2 , %%mm1;          /* positive differences between mm1 and mm3           */\n"
-    " paddusb      %%mm3 , %%mm1;          /* mm1 now contains abs(mm1-mm2)                      */\n"
-    " movq         %%mm1 , %%mm2;          /* copy mm1 to mm2                                    */\n"
-    " punpcklbw    %%mm7 , %%mm1;          /* unpack mm1 into mm1 and mm2                        */\n"
-    " punpckhbw    %%mm7 , %%mm2;          /*                                                    */\n"
-    " paddusw      %%mm1 , %%mm0;          /* add mm1 (stored in mm1 and mm2...)                 */\n"
-    " paddusw      %%mm2 , %%mm0;          /* to mm0                                             */\n"
-    " addl         %%ecx , %%esi;          /* add framewidth to frameaddress                     */\n"
-    " addl         %%ecx , %%edi;          /* add framewidth to frameaddress                     */\n"
-    " .endr                                /* end loop                                           */\n"
-    "                                      /*                                                    */\n"
-    " movq         %%mm0 , %0   ;          /* make mm0 available to gcc ...                      */\n"
-    :"=g" (a)
-    :"S" (frm), "D" (ref), "c" (denoiser.frame.w)
-    );
-#endif
-#endif
-
-  return (uint32_t)(a[0]+a[1]+a[2]+a[3]);
-}
-
-/*********************************************************************
- *                                                                   *
- * SAD-function for Y with MMXE                                      *
- *                                                                   *
- *********************************************************************/
-
-uint32_t
-calc_SAD_mmxe (uint8_t * frm, uint8_t * ref)
-{
-  static uint32_t a;
-
-#ifdef ARCH_X86
-#ifdef HAVE_ASM_MMX
-  __asm__ __volatile__
-    (
-    " pxor         %%mm0 , %%mm0;          /* clear mm0                                          */\n"
-    "                           ;          /*                                                    */\n"
-    " .rept 8                   ;          /*                                                    */\n"
-    " movq        (%%esi), %%mm1;          /* 8 Pixels from filtered frame to mm1                */\n"
-    " psadbw      (%%edi), %%mm1;          /* 8 Pixels difference to mm1                         */\n"
-    " paddusw      %%mm1 , %%mm0;          /* add result to mm0                                  */\n"
-    " addl         %%ecx , %%esi;          /* add framewidth to frameaddress                     */\n"
-    " addl         %%ecx , %%edi;          /* add framewidth to frameaddress                     */\n"
-    " .endr                     ;          /*                                                    */\n"
-    "                                      /*                                                    */\n"
-    " movq         %%mm0 , %0   ;          /* make mm0 available to gcc ...                      */\n"
-    :"=g" (a)
-    :"S" (frm), "D" (ref), "c" (denoiser.frame.w)
-    );
-#endif
-#endif
-  return a;
-}
-
-
-/*********************************************************************
- *                                                                   *
- * SAD-function for UV without MMX/MMXE                              *
- *                                                                   *
- *********************************************************************/
-
-uint32_t
-calc_SAD_uv_noaccel (uint8_t * frm, uint8_t * ref)
-{
-  register uint8_t dx = 0;
-  register uint8_t dy = 0;
-  int32_t Y = 0;
-  uint32_t d = 0;
-
-  for(dy=0;dy<4;dy++)
-    for(dx=0;dx<4;dx++)
-    {
-      Y=*(frm+dx+dy*W2)-*(ref+dx+dy*W2);
-      d+=(Y<0)? -Y:Y;
-    }
-  return d;
-}
-
-/*********************************************************************
- *                                                                   *
- * SAD-function for UV with MMX                                      *
- *                                                                   *
- *********************************************************************/
-
-uint32_t
-calc_SAD_uv_mmx (uint8_t * frm, uint8_t * ref)
-{
-  static uint16_t a[4];
-
-#ifdef ARCH_X86
-#ifdef HAVE_ASM_MMX
-  __asm__ __volatile__
-    (
-    " pxor        %%mm0 , %%mm0;           /* clear mm0                                          */\n"
-    " pxor        %%mm7 , %%mm7;           /* clear mm7                                          */\n"
-    "                                      /*                                                    */\n"
-    ".rept 4                    ;          /* Loop for 4 lines                                   */\n"
-    " movd        (%%esi), %%mm1;          /* 4 Pixels from filtered frame to mm1                */\n"
-    " movd        (%%edi), %%mm2;          /* 4 Pixels from reference frame to mm2               */\n"
-    " movq         %%mm2 , %%mm3;          /* hold a copy of mm2 in mm3                          */\n"
-    " psubusb      %%mm1 , %%mm3;          /* positive differences between mm2 and mm1           */\n"
-    " psubusb      %%mm2 , %%mm1;          /* positive differences between mm1 and mm3           */\n"
-    " paddusb      %%mm3 , %%mm1;          /* mm2 now contains abs(mm1-mm2)                      */\n"
-    " movq         %%mm1 , %%mm2;          /* copy mm1 to mm2                                    */\n"
-    " punpcklbw    %%mm7 , %%mm1;          /* unpack mm1 into mm1 and mm2                        */\n"
-    " punpckhbw    %%mm7 , %%mm2;          /*                                                    */\n"
-    " paddusw      %%mm1 , %%mm2;          /* add mm1 (stored in mm1 and mm2...)                 */\n"
-    " paddusw      %%mm2 , %%mm0;          /* to mm0                                             */\n"
-    " addl         %%ecx , %%esi;          /* add framewidth to frameaddress                     */\n"
-    " addl         %%ecx , %%edi;          /* add framewidth to frameaddress                     */\n"
-    " .endr                                /* end loop                                           */\n"
-    "                                      /*                                                    */\n"
-    " movq         %%mm0 , %0   ;          /* make mm0 available to gcc ...                      */\n"
-    :"=g" (a)
-    :"S" (frm), "D" (ref), "c" (denoiser.frame.w/2)
-    );
-#endif
-#endif
-  return (uint32_t)(a[0]+a[1]+a[2]+a[3]);
-}
-
-/*********************************************************************
- *                                                                   *
- * SAD-function for UV with MMXE                                     *
- *                                                                   *
- *********************************************************************/
-
-uint32_t
-calc_SAD_uv_mmxe (uint8_t * frm, uint8_t * ref)
-{
-  static uint32_t a;
-
-#ifdef ARCH_X86
-#ifdef HAVE_ASM_MMX
-  __asm__ __volatile__
-    (
-    " pxor         %%mm0 , %%mm0;          /* clear mm0                                          */\n"
-    "                           ;          /*                                                    */\n"
-    " .rept 4                   ;          /*                                                    */\n"
-    " movd        (%%esi), %%mm1;          /* 4 Pixels from filtered frame to mm1                */\n"
-    " movd        (%%edi), %%mm2;          /* 4 Pixels from filtered frame to mm2                */\n"
-    " psadbw       %%mm2 , %%mm1;          /* 4 Pixels difference to mm1                         */\n"
-    " paddusw      %%mm1 , %%mm0;          /* add result to mm0                                  */\n"
-    " addl         %%ecx , %%esi;          /* add framewidth to frameaddress                     */\n"
-    " addl         %%ecx , %%edi;          /* add framewidth to frameaddress                     */\n"
-    " .endr                     ;          /*                                                    */\n"
-    "                                      /*                                                    */\n"
-    " movq         %%mm0 , %0   ;          /* make mm0 available to gcc ...                      */\n"
-    :"=g" (a)
-    :"S" (frm), "D" (ref), "c" (denoiser.frame.w/2)
-    );
-#endif
-#endif
-  return a;
-}
-
-/*********************************************************************
- *                                                                   *
- * halfpel SAD-function for Y without MMX/MMXE                       *
+ * SAD-functions, on top of aclib (which picks the fastest version   *
+ * for this CPU)                                                     *
  *                                                                   *
  *********************************************************************/
 
 uint32_t
-calc_SAD_half_noaccel (uint8_t * ref, uint8_t * frm1, uint8_t * frm2)
+calc_SAD (uint8_t * frm, uint8_t * ref)
 {
-  uint8_t dx = 0;
-  uint8_t dy = 0;
-  int32_t Y = 0;
-  uint32_t d = 0;
-
-  for(dy=0;dy<8;dy++)
-    for(dx=0;dx<8;dx++)
-    {
-      Y=((*(frm1+dx+dy*denoiser.frame.w)+*(frm2+dx+dy*denoiser.frame.w))>>1)-*(ref+dx+dy*denoiser.frame.w);
-      d+=(Y<0)? -Y:Y;
-    }
-  return d;
+  return ac_sad (frm, W, ref, W, 8, 8);
 }
 
-/*********************************************************************
- *                                                                   *
- * halfpel SAD-function for Y with MMX                               *
- *                                                                   *
- *********************************************************************/
-
 uint32_t
-calc_SAD_half_mmx (uint8_t * ref, uint8_t * frm1, uint8_t * frm2)
+calc_SAD_uv (uint8_t * frm, uint8_t * ref)
 {
-  static uint32_t a;
-#ifdef ARCH_X86
-#ifdef HAVE_ASM_MMX
-
-  __asm__ __volatile__
-      (
-	  " pxor         %%mm0 , %%mm0;          /* clear mm0                                          */"
-	  " pcmpeqw      %%mm6 , %%mm6;          /* Build 7f7f7f7f7f7f7f in a register                 */"
-	  " psrlw        $9    , %%mm6;          /*                                                    */"
-	  " packuswb     %%mm6 , %%mm6;          /*                                                    */"
-	  "                           ;          /*                                                    */"
-	  " .rept 8                   ;          /*                                                    */"
-	  " movq        (%%esi), %%mm1;          /* 8 Pixels from filtered frame to mm1                */"
-	  " movq        (%%edi), %%mm2;          /* 8 Pixels from filtered frame to mm2 (displaced)    */"
-	  " movq        (%%eax), %%mm3;          /* reference to mm3                                   */"
-	  " psrlq        $1    , %%mm1;          /* average source pixels                              */"
-	  " psrlq        $1    , %%mm2;          /* shift right by one (divide by two)                 */"
-	  " pand         %%mm6 , %%mm1;          /* kill downshifted bits                              */"
-	  " pand         %%mm6 , %%mm2;          /* kill downshifted bits                              */"
-	  " paddusw      %%mm2 , %%mm1;          /* add up ...                                         */"
-
-	  " movq         %%mm3 , %%mm4;          /* copy reference to mm4                              */"
-	  " psubusb      %%mm1 , %%mm3;          /* positive differences between mm2 and mm1 */"
-	  " psubusb      %%mm4 , %%mm1;          /* positive differences between mm1 and mm3 */"
-	  " paddusb      %%mm3 , %%mm1;          /* mm1 now contains abs(mm1-mm2) */"
-	  " paddusw      %%mm1 , %%mm0;          /* add result to mm0                                  */"
-	  " addl         %%ecx , %%esi;          /* add framewidth to frameaddress                     */"
-	  " addl         %%ecx , %%edi;          /* add framewidth to frameaddress                     */"
-	  " addl         %%ecx , %%ecx;          /* add framewidth to frameaddress                     */"
-	  " .endr                     ;          /*                                                    */"
-	  "                                      /*                                                    */"
-	  " movq         %%mm0 , %0   ;          /* make mm0 available to gcc ...                      */"
-	  :"=g" (a)
-	  :"S" (frm1),"D" (frm2), "a" (ref), "c" (denoiser.frame.w)
-	  );
-#endif
-#endif
-  return a;
+  return ac_sad (frm, W2, ref, W2, 4, 4);
 }
 
-/*********************************************************************
- *                                                                   *
- * halfpel SAD-function for Y with MMXE                              *
- *                                                                   *
- *********************************************************************/
-
+/* halfpel: frm1 and frm2 are averaged, rounding up */
 uint32_t
-calc_SAD_half_mmxe (uint8_t * ref, uint8_t * frm1, uint8_t * frm2)
+calc_SAD_half (uint8_t * ref, uint8_t * frm1, uint8_t * frm2)
 {
-  static uint32_t a;
-
-#ifdef ARCH_X86
-#ifdef HAVE_ASM_MMX
-  __asm__ __volatile__
-      (
-	  " pxor         %%mm0 , %%mm0;          /* clear mm0                                          */\n"
-	  "                           ;          /*                                                    */\n"
-	  " .rept 8                   ;          /*                                                    */\n"
-	  " movq        (%%esi), %%mm1;          /* 8 Pixels from filtered frame to mm1                */\n"
-	  " movq        (%%edi), %%mm2;          /* 8 Pixels from filtered frame to mm2 (displaced)    */\n"
-	  " movq        (%%eax), %%mm3;          /* 8 Pixels from reference frame to mm3               */\n"
-	  " pavgb        %%mm2 , %%mm1;          /* average source pixels                              */\n"
-	  " psadbw       %%mm3 , %%mm1;          /* 8 Pixels difference to mm1                         */\n"
-	  " paddusw      %%mm1 , %%mm0;          /* add result to mm0                                  */\n"
-	  " addl         %%ecx , %%esi;          /* add framewidth to frameaddress                     */\n"
-	  " addl         %%ecx , %%edi;          /* add framewidth to frameaddress                     */\n"
-	  " addl         %%ecx , %%eax;          /* add framewidth to frameaddress                     */\n"
-	  " .endr                     ;          /*                                                    */\n"
-	  "                                      /*                                                    */\n"
-	  " movq         %%mm0 , %0   ;          /* make mm0 available to gcc ...                      */\n"
-	  :"=g" (a)
-	  :"S" (frm1),"D" (frm2), "a" (ref), "c" (denoiser.frame.w)
-	  );
-#endif
-#endif
-  return a;
+  return ac_sad_avg (ref, W, frm1, frm2, W, 8, 8);
 }
 
 /*********************************************************************
@@ -15,33 +15,12 @@ mb_search_11 (uint16_t x, uint16_t y);
 uint32_t
 mb_search_00 (uint16_t x, uint16_t y);
 
-/* no accel */
+/* block SADs */
 uint32_t
-calc_SAD_noaccel (uint8_t * frm, uint8_t * ref);
+calc_SAD (uint8_t * frm, uint8_t * ref);
 
 uint32_t
-calc_SAD_uv_noaccel (uint8_t * frm, uint8_t * ref);
+calc_SAD_uv (uint8_t * frm, uint8_t * ref);
 
 uint32_t
-calc_SAD_half_noaccel (uint8_t * ref, uint8_t * frm1, uint8_t * frm2);
-
-/* MMXE */
-uint32_t
-calc_SAD_mmxe (uint8_t * frm, uint8_t * ref);
-
-uint32_t
-calc_SAD_uv_mmxe (uint8_t * frm, uint8_t * ref);
-
-uint32_t
-calc_SAD_half_mmxe (uint8_t * ref, uint8_t * frm1, uint8_t * frm2);
-
-/* MMX */
-uint32_t
-calc_SAD_mmx (uint8_t * frm, uint8_t * ref);
-
-uint32_t
-calc_SAD_uv_mmx (uint8_t * frm, uint8_t * ref);
-
-uint32_t
-calc_SAD_half_mmx (uint8_t * ref, uint8_t * frm1, uint8_t * frm2);
-
+calc_SAD_half (uint8_t * ref, uint8_t * frm1, uint8_t * frm2);
@@ -129,7 +129,9 @@ void decode_lavc(decode_t *decode)
   // decoder
   int        len = 0;
   long       bytes_read = 0;
-  uint8_t   *planes[3];
+  ACImage    src_image, dest_image;
+  ImageFormat src_fmt;
+  int        i;
 
   verbose_flag = decode->verbose;
 
@@ -281,100 +283,48 @@ void decode_lavc(decode_t *decode)
 
       buf_len += len;
 
-      YUV_INIT_PLANES(planes, out_buffer, IMG_YUV420P,
-		      lavc_dec_context->width, lavc_dec_context->height);
-
       // Convert avcodec image to the requested YUV or RGB format
       switch (lavc_dec_context->pix_fmt) {
 	case PIX_FMT_YUVJ420P:
 	case PIX_FMT_YUV420P:
-	    // Remove "dead space" at right edge of planes, if any
-	    if (picture.linesize[0] != lavc_dec_context->width) {
-		int y;
-		for (y = 0; y < lavc_dec_context->height; y++) {
-		    ac_memcpy(picture.data[0] + y*lavc_dec_context->width,
-			      picture.data[0] + y*picture.linesize[0],
-			      lavc_dec_context->width);
-		    if (y%2 == 0) {
-			ac_memcpy(picture.data[1] + y*(lavc_dec_context->width/2),
-				  picture.data[1] + y*picture.linesize[1],
-				  lavc_dec_context->width/2);
-			ac_memcpy(picture.data[2] + y*(lavc_dec_context->width/2),
-				  picture.data[2] + y*picture.linesize[2],
-				  lavc_dec_context->width/2);
-		    }
-		}
-	    }
-            /* FIXME: we can't use tcv_convert here because it assumes
-             * contiguous planes, which libavcodec might not give us  --AC */
-	    ac_imgconvert(picture.data, IMG_YUV420P, planes,
-			  pix_fmt==TC_CODEC_YUV420P ? IMG_YUV420P : IMG_RGB_DEFAULT,
-			  lavc_dec_context->width, lavc_dec_context->height);
+	    src_fmt = IMG_YUV420P;
 	    break;
 	case PIX_FMT_YUV411P:
-	    if (picture.linesize[0] != lavc_dec_context->width) {
-		int y;
-		for (y = 0; y < lavc_dec_context->height; y++) {
-		    ac_memcpy(picture.data[0] + y*lavc_dec_context->width,
-			      picture.data[0] + y*picture.linesize[0],
-			      lavc_dec_context->width);
-		    ac_memcpy(picture.data[1] + y*(lavc_dec_context->width/4),
-			      picture.data[1] + y*picture.linesize[1],
-			      lavc_dec_context->width/4);
-		    ac_memcpy(picture.data[2] + y*(lavc_dec_context->width/4),
-			      picture.data[2] + y*picture.linesize[2],
-			      lavc_dec_context->width/4);
-		}
-	    }
-	    ac_imgconvert(picture.data, IMG_YUV411P, planes,
-			  pix_fmt==TC_CODEC_YUV420P ? IMG_YUV420P : IMG_RGB_DEFAULT,
-			  lavc_dec_context->width, lavc_dec_context->height);
+	    src_fmt = IMG_YUV411P;
 	    break;
 	case PIX_FMT_YUVJ422P:
 	case PIX_FMT_YUV422P:
-	    if (picture.linesize[0] != lavc_dec_context->width) {
-		int y;
-		for (y = 0; y < lavc_dec_context->height; y++) {
-		    ac_memcpy(picture.data[0] + y*lavc_dec_context->width,
-			      picture.data[0] + y*picture.linesize[0],
-			      lavc_dec_context->width);
-		    ac_memcpy(picture.data[1] + y*(lavc_dec_context->width/2),
-			      picture.data[1] + y*picture.linesize[1],
-			      lavc_dec_context->width/2);
-		    ac_memcpy(picture.data[2] + y*(lavc_dec_context->width/2),
-			      picture.data[2] + y*picture.linesize[2],
-			      lavc_dec_context->width/2);
-		}
-	    }
-	    ac_imgconvert(picture.data, IMG_YUV422P, planes,
-			  pix_fmt==TC_CODEC_YUV420P ? IMG_YUV420P : IMG_RGB_DEFAULT,
-			  lavc_dec_context->width, lavc_dec_context->height);
+	    src_fmt = IMG_YUV422P;
 	    break;
 	case PIX_FMT_YUVJ444P:
 	case PIX_FMT_YUV444P:
-	    if (picture.linesize[0] != lavc_dec_context->width) {
-		int y;
-		for (y = 0; y < lavc_dec_context->height; y++) {
-		    ac_memcpy(picture.data[0] + y*lavc_dec_context->width,
-			      picture.data[0] + y*picture.linesize[0],
-			      lavc_dec_context->width);
-		    ac_memcpy(picture.data[1] + y*lavc_dec_context->width,
-			      picture.data[1] + y*picture.linesize[1],
-			      lavc_dec_context->width);
-		    ac_memcpy(picture.data[2] + y*lavc_dec_context->width,
-			      picture.data[2] + y*picture.linesize[2],
-			      lavc_dec_context->width);
-		}
-	    }
-	    ac_imgconvert(picture.data, IMG_YUV444P, planes,
-			  pix_fmt==TC_CODEC_YUV420P ? IMG_YUV420P : IMG_RGB_DEFAULT,
-			  lavc_dec_context->width, lavc_dec_context->height);
+	    src_fmt = IMG_YUV444P;
 	    break;
 	default:
 	    tc_log_error(__FILE__, "Unsupported decoded frame format");
 	    goto decoder_error;
       }
 
+      /* libavcodec may leave "dead space" at the right edge of the
+       * planes: let aclib skip it, instead of packing the rows first */
+      src_image.format = src_fmt;
+      src_image.width  = lavc_dec_context->width;
+      src_image.height = lavc_dec_context->height;
+      for (i = 0; i < 3; i++) {
+	  src_image.planes[i] = picture.data[i];
+	  src_image.stride[i] = picture.linesize[i];
+      }
+      src_image.planes[3] = NULL;
+      src_image.stride[3] = 0;
+      if (!ac_image_init(&dest_image,
+			 pix_fmt==TC_CODEC_YUV420P ? IMG_YUV420P : IMG_RGB_DEFAULT,
+			 out_buffer, lavc_dec_context->width,
+			 lavc_dec_context->height, 0)
+       || !ac_imgconvert_image(&src_image, &dest_image)) {
+	  tc_log_error(__FILE__, "Image format conversion failed");
+	  goto decoder_error;
+      }
+
       /* buffer more than half empty -> Fill it */
       if (!flush && buf_len > mp4_size/2+1) {
 	  int rest = mp4_size - buf_len;
@@ -35,13 +35,23 @@
 
 #define MOD_NAME    "decode_lzo"
 
-#define BUFFER_SIZE SIZE_RGB_FRAME<<1
-
 static int r;
 static lzo_byte *out;
 static lzo_byte *inbuf;
 static lzo_byte *wrkmem;
 static lzo_uint out_len;
+static lzo_uint out_size, in_size;
+
+/* make room for `size' bytes in a buffer, dropping its contents */
+static int buffer_reserve(lzo_bytep *buf, lzo_uint *cur, lzo_uint size)
+{
+    if (size > *cur) {
+        lzo_free(*buf);
+        *buf = (lzo_bytep) lzo_malloc(size);
+        *cur = (*buf) ?size :0;
+    }
+    return (*buf) ?0 :-1;
+}
 
 
 inline static void str2long(unsigned char *bb, long *bytes)
@@ -64,11 +74,19 @@ void decode_lzo(decode_t *decode)
       goto decoder_error;
     }
 
+    /* the frames are not larger than the given geometry in RGB, and
+     * we grow the buffers as needed when it's unknown */
     wrkmem = (lzo_bytep) lzo_malloc(LZO1X_1_MEM_COMPRESS);
-    out = (lzo_bytep) lzo_malloc(BUFFER_SIZE);
-    inbuf = (lzo_bytep) lzo_malloc(BUFFER_SIZE);
+    if (decode->width > 0 && decode->height > 0) {
+        out_size = decode->width * decode->height * 3;
+    } else {
+        out_size = PAL_W * PAL_H * 3;
+    }
+    out = (lzo_bytep) lzo_malloc(out_size);
+    in_size = out_size;
+    inbuf = (lzo_bytep) lzo_malloc(in_size);
 
-    if (wrkmem == NULL || out == NULL) {
+    if (wrkmem == NULL || out == NULL || inbuf == NULL) {
       tc_log_error(__FILE__, "out of memory");
       goto decoder_error;
     }
@@ -94,6 +112,12 @@ void decode_lzo(decode_t *decode)
 
 	if (verbose & TC_DEBUG)
 	    tc_log_msg(__FILE__, "got bytes (%ld)", bytes);
+	if (buffer_reserve(&inbuf, &in_size, bytes) < 0
+	 || ((h.flags & TC_LZO_NOT_COMPRESSIBLE)
+	     && buffer_reserve(&out, &out_size, bytes) < 0)) {
+	    tc_log_error(__FILE__, "out of memory");
+	    goto decoder_error;
+	}
 	if ( (ss=tc_pread (decode->fd_in, inbuf, bytes))!=bytes) {
 	    tc_log_error(__FILE__, "failed to read frame: expected (%ld) got (%lu)", bytes, (unsigned long)ss);
 	    goto decoder_error;
@@ -104,7 +128,16 @@ void decode_lzo(decode_t *decode)
 	  out_len = bytes;
 	  r = LZO_E_OK;
 	} else {
-	  r = lzo1x_decompress(inbuf, bytes, out, &out_len, wrkmem);
+	  for (;;) {
+	    out_len = out_size;
+	    r = lzo1x_decompress_safe(inbuf, bytes, out, &out_len, wrkmem);
+	    if (r != LZO_E_OUTPUT_OVERRUN)
+	      break;
+	    if (buffer_reserve(&out, &out_size, out_size * 2) < 0) {
+	      tc_log_error(__FILE__, "out of memory");
+	      goto decoder_error;
+	    }
+	  }
 	}
 
 	if (r == LZO_E_OK) {
@@ -64,7 +64,8 @@ void probe_avi(info_t *ipipe)
 	}
     }
 
-    ipipe->probe_info->frames = AVI_video_frames(avifile);
+    /* don't wait for an index still to be built */
+    ipipe->probe_info->frames = AVI_video_frames_hint(avifile);
 
     ipipe->probe_info->width  =  AVI_video_width(avifile);
     ipipe->probe_info->height =  AVI_video_height(avifile);
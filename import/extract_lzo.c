@@ -34,8 +34,6 @@
 #include <lzo/lzo1x.h>
 #include <lzo/lzoutil.h>
 
-#define BUFFER_SIZE SIZE_RGB_FRAME<<1
-
 inline static void long2str(long a, unsigned char *b)
 {
       b[0] = (a&0xff000000)>>24;
@@ -48,7 +46,7 @@ void extract_lzo(info_t *ipipe)
 {
 
   avi_t *avifile=NULL;
-  char *video;
+  const uint8_t *video=NULL;
 
   int key, error=0;
 
@@ -83,17 +81,10 @@ void extract_lzo(info_t *ipipe)
     if(ipipe->verbose & TC_STATS)
       tc_log_msg(__FILE__, "%ld video frames", frames);
 
-    // allocate space, assume max buffer size
-    if((video = tc_zalloc(SIZE_RGB_FRAME))==NULL) {
-      tc_log_msg(__FILE__, "out of memory");
-      error=1;
-      break;
-    }
-
     (int)AVI_set_video_position(avifile,ipipe->frame_limit[0]);
     for (n=ipipe->frame_limit[0]; n<=frames; ++n) {
       // video
-      if((bytes = AVI_read_frame(avifile, video, &key))<0) {
+      if((bytes = AVI_read_frame_ref(avifile, &video, &key))<0) {
 	error=1;
 	break;
       }
@@ -103,8 +94,6 @@ void extract_lzo(info_t *ipipe)
       }
     }
 
-    free(video);
-
     break;
 
   case TC_MAGIC_RAW:
@@ -44,7 +44,7 @@
 
 void extract_rgb(info_t *ipipe)
 {
-    uint8_t *video;
+    const uint8_t *video = NULL;
     avi_t *avifile = NULL;
     int key, error = 0;
     long frames, bytes, n;
@@ -70,16 +70,10 @@ void extract_rgb(info_t *ipipe)
             tc_log_msg(__FILE__, "%ld video frames", frames);
         }
 
-        video = tc_bufalloc(SIZE_RGB_FRAME);
-        if (!video) {
-            error = 1;
-            break;
-        }
-
         AVI_set_video_position(avifile, ipipe->frame_limit[0]);
         /* FIXME: should this be < rather than <= ? */
         for (n = ipipe->frame_limit[0]; n <= frames; n++) {
-            bytes = AVI_read_frame(avifile, video, &key);
+            bytes = AVI_read_frame_ref(avifile, &video, &key);
             if (bytes < 0) {
                 error = 1;
                 break;
@@ -89,8 +83,6 @@ void extract_rgb(info_t *ipipe)
                 break;
             }
         }
-
-        tc_buffree(video);
         break;
 
       case TC_MAGIC_RAW: /* fallthrough */
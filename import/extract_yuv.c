@@ -128,7 +128,7 @@ static int extract_yuv_y4m(info_t *ipipe)
 static int extract_yuv_avi(info_t *ipipe)
 {
     avi_t *avifile=NULL;
-    char *video;
+    const uint8_t *video = NULL;
 
     int key;
     long frames, bytes, n;
@@ -152,16 +152,9 @@ static int extract_yuv_avi(info_t *ipipe)
     if (ipipe->verbose & TC_STATS) {
         tc_log_info(__FILE__, "%ld video frames", frames);
     }
-    // allocate space, assume max buffer size
-    video = tc_bufalloc(SIZE_RGB_FRAME);
-    if (video == NULL) {
-        tc_log_error(__FILE__, "out of memory");
-        return 1;
-    }
-
     AVI_set_video_position(avifile, ipipe->frame_limit[0]);
     for (n = ipipe->frame_limit[0]; n <= frames; ++n) {
-        bytes = AVI_read_frame(avifile, video, &key);
+        bytes = AVI_read_frame_ref(avifile, &video, &key);
         if (bytes < 0) {
             return 1;
         }
@@ -170,7 +163,6 @@ static int extract_yuv_avi(info_t *ipipe)
             return 1;
         }
     }
-    tc_buffree(video);
 
     return 0;
 }
@@ -49,6 +49,7 @@ static int width = 0, height = 0;
 static TCVHandle tcvhandle = NULL;
 static ImageFormat srcfmt = IMG_NONE, dstfmt = IMG_NONE;
 static int destsize = 0;
+static int frame_size = 0;  /* what the frames we read into can hold */
 
 static const struct {
     const char *name;  // fourcc
@@ -197,7 +198,10 @@ MOD_open
         tc_log_info(MOD_NAME, "codec=%s, fps=%6.3f, width=%d, height=%d",
                     codec, fps, width, height);
 
-        if (AVI_max_video_chunk(avifile_vid) > SIZE_RGB_FRAME) {
+        /* not told by the host: frames hold at least this much */
+        frame_size = (param->buffer_size > 0)
+                     ?param->buffer_size :(int)TC_JOB_FRAME_SIZE(vob);
+        if (AVI_max_video_chunk(avifile_vid) > frame_size) {
             tc_log_error(MOD_NAME, "invalid AVI video frame chunk size detected");
             return TC_ERROR;
         }
@@ -254,7 +258,11 @@ MOD_decode
             return TC_OK;
         }
 
-        param->size = AVI_read_frame(avifile_vid, param->buffer, &key);
+        /* with a lazily built index max_video_chunk isn't final */
+        param->size = AVI_read_video(avifile_vid, param->buffer,
+                                     (param->buffer_size > 0)
+                                     ?param->buffer_size :frame_size,
+                                     &key);
 
         // Fixup: For uncompressed AVIs, it must be aligned at
         // a 4-byte boundary
@@ -81,6 +81,9 @@ typedef struct tbuf_t {
 	char *d;
 } tbuf_t;
 
+// big enough for a whole MPEG-2 sequence; unrelated to the frame size
+#define TBUF_SIZE   (16 * 1024 * 1024)
+
 // m2v passthru
 static int can_read = 1;
 static tbuf_t tbuf;
@@ -466,8 +469,8 @@ MOD_open
       f = param->fd;
       param->fd = NULL;
 
-      tbuf.d = tc_malloc (SIZE_RGB_FRAME);
-      tbuf.len = SIZE_RGB_FRAME;
+      tbuf.d = tc_malloc (TBUF_SIZE);
+      tbuf.len = TBUF_SIZE;
       tbuf.off = 0;
 
       if ((tbuf.len = fread(tbuf.d, 1, tbuf.len, f)) < 0)
@@ -578,8 +581,8 @@ MOD_decode
 	    tbuf.off = 0;
 
 	    if (can_read>0) {
-	      can_read = fread (tbuf.d+tbuf.len, SIZE_RGB_FRAME-tbuf.len, 1, f);
-	      tbuf.len += (SIZE_RGB_FRAME-tbuf.len);
+	      can_read = fread (tbuf.d+tbuf.len, TBUF_SIZE-tbuf.len, 1, f);
+	      tbuf.len += (TBUF_SIZE-tbuf.len);
 	    } else {
 		tc_log_info(MOD_NAME, "No 1 Read %d", can_read);
 	      /* XXX: Flush buffers */
@@ -639,8 +642,8 @@ MOD_decode
 	      tbuf.off = 0;
 
 	      if (can_read>0) {
-		can_read = fread (tbuf.d+tbuf.len, SIZE_RGB_FRAME-tbuf.len, 1, f);
-		tbuf.len += (SIZE_RGB_FRAME-tbuf.len);
+		can_read = fread (tbuf.d+tbuf.len, TBUF_SIZE-tbuf.len, 1, f);
+		tbuf.len += (TBUF_SIZE-tbuf.len);
 	      } else {
 		tc_log_info(MOD_NAME, "No 1 Read %d", can_read);
 		/* XXX: Flush buffers */
@@ -44,10 +44,8 @@ static uint32_t video_codec;
 static int audio_codec;
 static int aframe_count=0, vframe_count=0;
 
-#define BUFFER_SIZE SIZE_RGB_FRAME<<1
-
 static int r;
-static lzo_byte *out;
+static const uint8_t *out; /* compressed frame, points into the AVI */
 static lzo_byte *wrkmem;
 static lzo_uint out_len;
 
@@ -123,9 +121,8 @@ MOD_open
     }
 
     wrkmem = (lzo_bytep) lzo_malloc(LZO1X_1_MEM_COMPRESS);
-    out = (lzo_bytep) lzo_malloc(BUFFER_SIZE);
 
-    if (wrkmem == NULL || out == NULL) {
+    if (wrkmem == NULL) {
       tc_log_warn(MOD_NAME, "out of memory");
       return(TC_IMPORT_ERROR);
     }
@@ -156,21 +153,22 @@ MOD_decode
       return(TC_IMPORT_OK);
     }
 
-    out_len = AVI_read_frame(avifile2, out, &key);
+    bytes_read = AVI_read_frame_ref(avifile2, &out, &key);
 
     if(verbose & TC_STATS && key)
       tc_log_info(MOD_NAME, "keyframe %d", vframe_count);
 
-    if(out_len<=0) {
+    if(bytes_read<=0) {
       if(verbose & TC_DEBUG) AVI_print_error("AVI read video frame");
       return(TC_IMPORT_ERROR);
     }
+    out_len = bytes_read;
 
     if (video_codec == TC_CODEC_LZO1) {
       r = lzo1x_decompress(out, out_len, param->buffer, &size, wrkmem);
     } else {
-      tc_lzo_header_t *h = (tc_lzo_header_t *)out;
-      uint8_t *compdata = out + sizeof(*h);
+      const tc_lzo_header_t *h = (const tc_lzo_header_t *)out;
+      const uint8_t *compdata = out + sizeof(*h);
       int compsize = out_len - sizeof(*h);
       if (h->magic != video_codec) {
           tc_log_warn(MOD_NAME, "frame with invalid magic 0x%08X", h->magic);
@@ -261,7 +259,7 @@ MOD_close
   if(param->flag == TC_VIDEO) {
 
     lzo_free(wrkmem);
-    lzo_free(out);
+    out = NULL;
 
     if(avifile2!=NULL) {
       AVI_close(avifile2);
@@ -26,6 +26,16 @@
 #define MOD_CODEC   "(video) MPEG2"
 
 #include "src/transcode.h"
+#include "libtcutil/optstr.h"
+
+#include "mpeg_reader.h"
+
+/*
+ * For the m2v passthrough the elementary stream is extracted in-process;
+ * the tcextract pipeline is still used for transport streams,
+ * requantization, or when the `pipe' option is given. Decoding always
+ * goes through tcdecode.
+ */
 
 static int verbose_flag = TC_QUIET;
 static int capability_flag = TC_CAP_RGB | TC_CAP_YUV | TC_CAP_VID;
@@ -42,12 +52,64 @@ typedef struct tbuf_t {
 	char *d;
 } tbuf_t;
 
+// big enough for a whole MPEG-2 sequence; unrelated to the frame size
+#define TBUF_SIZE   (16 * 1024 * 1024)
+
 // m2v passthru
 static int can_read = 1;
 static tbuf_t tbuf;
 static int m2v_passthru=0;
 static FILE *f; // video fd
 
+// in-process extraction
+static TCMpegReader *reader = NULL;
+
+static int inproc_open(vob_t *vob)
+{
+  if (vob->im_v_string && optstr_lookup(vob->im_v_string, "pipe"))
+    return(TC_ERROR);
+  if (vob->im_v_codec != TC_CODEC_RAW
+   || vob->m2v_requant > M2V_REQUANT_FACTOR)
+    return(TC_ERROR);
+
+  reader = tc_mpeg_reader_open(vob->video_in_file, 0, vob->verbose);
+  if (reader == NULL)
+    return(TC_ERROR);
+  return(TC_OK);
+}
+
+// fill the m2v buffer, from the pipe or in-process
+static int tbuf_read(char *buf, int len)
+{
+  if (reader != NULL)
+    return tc_mpeg_reader_read(reader, (uint8_t *)buf, len);
+  return fread(buf, 1, len, f);
+}
+
+// prime the m2v buffer, up to the first sequence header
+static int m2v_open(void)
+{
+  tbuf.d = tc_malloc (TBUF_SIZE);
+  tbuf.len = TBUF_SIZE;
+  tbuf.off = 0;
+
+  if ((tbuf.len = tbuf_read(tbuf.d, tbuf.len)) < 0)
+    return(TC_IMPORT_ERROR);
+
+  // find a sync word
+  while (tbuf.off+4<tbuf.len) {
+    if (tbuf.d[tbuf.off+0]==0x0 && tbuf.d[tbuf.off+1]==0x0 &&
+	  tbuf.d[tbuf.off+2]==0x1 &&
+	  (unsigned char)tbuf.d[tbuf.off+3]==0xb3) break;
+    else tbuf.off++;
+  }
+  if (tbuf.off+4>=tbuf.len)  {
+    tc_log_warn(MOD_NAME, "Internal Error. No sync word");
+    return (TC_IMPORT_ERROR);
+  }
+  return(TC_IMPORT_OK);
+}
+
 
 /* ------------------------------------------------------------
  *
@@ -63,6 +125,15 @@ MOD_open
 
   if(param->flag != TC_VIDEO) return(TC_IMPORT_ERROR);
 
+  if(vob->ts_pid1==0 && inproc_open(vob) == TC_OK) {
+
+    if(verbose_flag) tc_log_info(MOD_NAME, "in-process extraction"
+                                 " of \"%s\"", vob->video_in_file);
+    param->fd = NULL;
+    m2v_passthru=1;
+    return(m2v_open());
+  }
+
   if(vob->ts_pid1==0) { // no transport stream
 
     switch(vob->im_v_codec) {
@@ -160,25 +231,7 @@ MOD_open
     f = param->fd;
     param->fd = NULL;
 
-    tbuf.d = tc_malloc (SIZE_RGB_FRAME);
-    tbuf.len = SIZE_RGB_FRAME;
-    tbuf.off = 0;
-
-    if ((tbuf.len = fread(tbuf.d, 1, tbuf.len, f)) < 0)
-      return(TC_IMPORT_ERROR);
-
-    // find a sync word
-    while (tbuf.off+4<tbuf.len) {
-      if (tbuf.d[tbuf.off+0]==0x0 && tbuf.d[tbuf.off+1]==0x0 &&
-	  tbuf.d[tbuf.off+2]==0x1 &&
-	  (unsigned char)tbuf.d[tbuf.off+3]==0xb3) break;
-      else tbuf.off++;
-    }
-    if (tbuf.off+4>=tbuf.len)  {
-      tc_log_warn(MOD_NAME, "Internal Error. No sync word");
-      return (TC_IMPORT_ERROR);
-    }
-
+    return(m2v_open());
   }
 
   return(TC_IMPORT_OK);
@@ -248,8 +301,10 @@ MOD_decode{
 	  tbuf.off = 0;
 
 	  if (can_read>0) {
-	    can_read = fread (tbuf.d+tbuf.len, SIZE_RGB_FRAME-tbuf.len, 1, f);
-	    tbuf.len += (SIZE_RGB_FRAME-tbuf.len);
+	    int want = TBUF_SIZE-tbuf.len;
+	    int got = tbuf_read(tbuf.d+tbuf.len, want);
+	    can_read = (got == want);
+	    tbuf.len += (got > 0) ?got :0;
 	  } else {
 	    tc_log_info(MOD_NAME, "No 1 Read %d", can_read);
 	    /* XXX: Flush buffers */
@@ -309,8 +364,10 @@ MOD_decode{
 	    tbuf.off = 0;
 
 	    if (can_read>0) {
-	      can_read = fread (tbuf.d+tbuf.len, SIZE_RGB_FRAME-tbuf.len, 1, f);
-	      tbuf.len += (SIZE_RGB_FRAME-tbuf.len);
+	      int want = TBUF_SIZE-tbuf.len;
+	      int got = tbuf_read(tbuf.d+tbuf.len, want);
+	      can_read = (got == want);
+	      tbuf.len += (got > 0) ?got :0;
 	    } else {
 	      tc_log_info(MOD_NAME, "No 1 Read %d", can_read);
 	      /* XXX: Flush buffers */
@@ -344,5 +401,8 @@ MOD_close
     if(f != NULL) pclose(f);
     param->fd = f = NULL;
 
+    tc_mpeg_reader_del(reader);
+    reader = NULL;
+
     return(TC_IMPORT_OK);
 }
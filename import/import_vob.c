@@ -30,6 +30,8 @@
 #include "libtc/libtc.h"
 #include "libtcutil/optstr.h"
 
+#include "mpeg_reader.h"
+
 /*%*
  *%* DESCRIPTION 
  *%*   This module imports audio/video from VOB files. If you need direct
@@ -53,6 +55,10 @@
  *%* OPTION
  *%*   nodemux (flag)
  *%*     skip demuxing processing stage. This sometimes improves A/V sync.
+ *%*   pipe (flag)
+ *%*     always use the external tccat/tcdemux/tcextract pipeline for the
+ *%*     video passthrough (-P 1), instead of the in-process extraction
+ *%*     used when the demuxer is off (-M 0).
  *%*/
 
 static int verbose_flag = TC_QUIET;
@@ -73,6 +79,9 @@ typedef struct tbuf_t {
 	char *d;
 } tbuf_t;
 
+// big enough for a whole MPEG-2 sequence; unrelated to the frame size
+#define TBUF_SIZE   (16 * 1024 * 1024)
+
 // m2v passthru
 static int can_read = 1;
 static tbuf_t tbuf;
@@ -84,6 +93,65 @@ static int pseudo_frame_size=0, real_frame_size=0, effective_frame_size=0;
 static int ac3_bytes_to_go=0;
 static FILE *fd;
 
+// in-process m2v passthrough, when there is nothing to demultiplex
+#define VOB_BLOCK_SIZE  2048
+
+static TCMpegReader *reader = NULL;
+
+static int inproc_open(vob_t *vob)
+{
+  if (vob->demuxer != TC_DEMUX_OFF
+   || vob->ps_seq1 != 0 || vob->ps_seq2 != TC_FRAME_LAST)
+    return(TC_ERROR);
+  if (vob->im_v_string && optstr_lookup(vob->im_v_string, "pipe"))
+    return(TC_ERROR);
+  if (vob->im_v_codec != TC_CODEC_RAW
+   || vob->m2v_requant > M2V_REQUANT_FACTOR)
+    return(TC_ERROR);
+  // directories are concatenated by tccat
+  if (tc_file_check(vob->video_in_file) != 0)
+    return(TC_ERROR);
+
+  reader = tc_mpeg_reader_open(vob->video_in_file,
+                               (off_t)vob->vob_offset * VOB_BLOCK_SIZE,
+                               vob->verbose);
+  if (reader == NULL)
+    return(TC_ERROR);
+  return(TC_OK);
+}
+
+// fill the m2v buffer, from the pipe or in-process
+static int tbuf_read(char *buf, int len)
+{
+  if (reader != NULL)
+    return tc_mpeg_reader_read(reader, (uint8_t *)buf, len);
+  return fread(buf, 1, len, f);
+}
+
+// prime the m2v buffer, up to the first sequence header
+static int m2v_open(void)
+{
+  tbuf.d = tc_malloc (TBUF_SIZE);
+  tbuf.len = TBUF_SIZE;
+  tbuf.off = 0;
+
+  if ((tbuf.len = tbuf_read(tbuf.d, tbuf.len)) < 0)
+    return(TC_IMPORT_ERROR);
+
+  // find a sync word
+  while (tbuf.off+4<tbuf.len) {
+    if (tbuf.d[tbuf.off+0]==0x0 && tbuf.d[tbuf.off+1]==0x0 &&
+	tbuf.d[tbuf.off+2]==0x1 &&
+	(unsigned char)tbuf.d[tbuf.off+3]==0xb3) break;
+    else tbuf.off++;
+  }
+  if (tbuf.off+4>=tbuf.len)  {
+    tc_log_warn(MOD_NAME, "Internal Error. No sync word");
+    return (TC_IMPORT_ERROR);
+  }
+  return(TC_IMPORT_OK);
+}
+
 /* ------------------------------------------------------------
  *
  * open stream
@@ -280,6 +348,14 @@ MOD_open
 
       char requant_buf[256];
 
+      if (inproc_open(vob) == TC_OK) {
+	if(verbose_flag) tc_log_info(MOD_NAME, "in-process extraction"
+				     " of \"%s\"", vob->video_in_file);
+	param->fd = NULL;
+	m2v_passthru=1;
+	return(m2v_open());
+      }
+
       if (vob->demuxer==TC_DEMUX_SEQ_FSYNC || vob->demuxer==TC_DEMUX_SEQ_FSYNC2) {
 
 	if((logfile=clone_fifo())==NULL) {
@@ -393,24 +469,7 @@ MOD_open
 	f = param->fd;
 	param->fd = NULL;
 
-	tbuf.d = tc_malloc (SIZE_RGB_FRAME);
-	tbuf.len = SIZE_RGB_FRAME;
-	tbuf.off = 0;
-
-	if ( (tbuf.len = fread(tbuf.d, 1, tbuf.len, f))<0) return -1;
-
-	// find a sync word
-	while (tbuf.off+4<tbuf.len) {
-	  if (tbuf.d[tbuf.off+0]==0x0 && tbuf.d[tbuf.off+1]==0x0 &&
-	      tbuf.d[tbuf.off+2]==0x1 &&
-	      (unsigned char)tbuf.d[tbuf.off+3]==0xb3) break;
-	  else tbuf.off++;
-	}
-	if (tbuf.off+4>=tbuf.len)  {
-	  tc_log_warn(MOD_NAME, "Internal Error. No sync word");
-	  return (TC_IMPORT_ERROR);
-	}
-
+	return(m2v_open());
       }
 
       return(0);
@@ -496,8 +555,10 @@ MOD_decode
 	    tbuf.off = 0;
 
 	    if (can_read>0) {
-	      can_read = fread (tbuf.d+tbuf.len, SIZE_RGB_FRAME-tbuf.len, 1, f);
-	      tbuf.len += (SIZE_RGB_FRAME-tbuf.len);
+	      int want = TBUF_SIZE-tbuf.len;
+	      int got = tbuf_read(tbuf.d+tbuf.len, want);
+	      can_read = (got == want);
+	      tbuf.len += (got > 0) ?got :0;
 	    } else {
 		tc_log_info(MOD_NAME, "No 1 Read %d", can_read);
 	      /* XXX: Flush buffers */
@@ -557,8 +618,10 @@ MOD_decode
 	      tbuf.off = 0;
 
 	      if (can_read>0) {
-		can_read = fread (tbuf.d+tbuf.len, SIZE_RGB_FRAME-tbuf.len, 1, f);
-		tbuf.len += (SIZE_RGB_FRAME-tbuf.len);
+		int want = TBUF_SIZE-tbuf.len;
+		int got = tbuf_read(tbuf.d+tbuf.len, want);
+		can_read = (got == want);
+		tbuf.len += (got > 0) ?got :0;
 	      } else {
 		tc_log_info(MOD_NAME, "No 1 Read %d", can_read);
 		/* XXX: Flush buffers */
@@ -681,6 +744,9 @@ MOD_close
 	//safe
       clone_close();
 
+      tc_mpeg_reader_del(reader);
+      reader = NULL;
+
       return(0);
     }
 
@@ -0,0 +1,361 @@
+/*
+ * mpeg_reader.c -- in-process extraction of MPEG video elementary streams.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libtc/libtc.h"
+#include "mpeg_reader.h"
+
+/*************************************************************************/
+
+#define READER_NAME "mpeg_reader"
+
+enum {
+    /* way bigger than the largest PES packet (64k + header) */
+    READER_BUFFER_SIZE = 262144,
+};
+
+struct tcmpegreader_ {
+    int         fd;
+    int         owned;      /* fd opened by the reader itself? */
+    int         program;    /* demultiplex or pass through? */
+    int         verbose;
+
+    int         eof;        /* nothing more to read from fd */
+    int         done;       /* program end code seen */
+    int         complain;   /* missing start codes, warn just once */
+    off_t       pos;        /* file position of `end' */
+
+    uint8_t     *buf;
+    uint8_t     *cur;       /* first byte not parsed yet */
+    uint8_t     *end;       /* one past the last valid byte */
+
+    const uint8_t *chunk;   /* leftover of the last chunk (for read) */
+    int         chunk_len;
+};
+
+/* same as tcextract for MPEG-1 packets */
+static const int mpeg1_skip_table[16] = {
+         1, 0xffff,      5,     10, 0xffff, 0xffff, 0xffff, 0xffff,
+    0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff
+};
+
+/*************************************************************************/
+
+/*
+ * move the unparsed bytes at the start of the buffer and fill the rest.
+ * Returns the number of new bytes.
+ */
+static int reader_refill(TCMpegReader *R)
+{
+    int keep = R->end - R->cur, want = READER_BUFFER_SIZE - keep;
+    ssize_t got = 0;
+
+    if (keep > 0 && R->cur != R->buf) {
+        memmove(R->buf, R->cur, keep);
+    }
+    R->cur = R->buf;
+    R->end = R->buf + keep;
+
+    got = tc_pread(R->fd, R->end, want);
+    if (got < want) {
+        R->eof = TC_TRUE;
+    }
+    if (got > 0) {
+        R->end += got;
+        R->pos += got;
+    }
+    return (got > 0) ?got :0;
+}
+
+/* elementary stream: the buffer content is the chunk */
+static int reader_next_es(TCMpegReader *R, const uint8_t **data)
+{
+    int len = 0;
+
+    if (R->cur >= R->end) {
+        if (R->eof) {
+            return 0;
+        }
+        R->cur = R->end = R->buf; /* nothing to keep */
+        reader_refill(R);
+    }
+    len   = R->end - R->cur;
+    *data = R->cur;
+    R->cur = R->end;
+    return len;
+}
+
+/*
+ * program stream: walk the packs, hand out the payload of the video
+ * packets and skip everything else. Incomplete packets are completed
+ * on the next refill; an incomplete packet at the end of the stream
+ * is dropped.
+ */
+static int reader_next_ps(TCMpegReader *R, const uint8_t **data)
+{
+    while (!R->done) {
+        while (R->cur + 6 <= R->end) {
+            uint8_t *p = R->cur, *next = NULL, *payload = NULL;
+
+            /* check for a valid start code */
+            if (p[0] || p[1] || p[2] != 0x01) {
+                if (R->complain) {
+                    tc_log_warn(READER_NAME, "missing start code at %#lx",
+                                (unsigned long)(R->pos - (R->end - p)));
+                    if (p[0] == 0 && p[1] == 0 && p[2] == 0) {
+                        tc_log_warn(READER_NAME, "incorrect zero-byte"
+                                                 " padding detected - ignored");
+                    }
+                    R->complain = TC_FALSE;
+                }
+                R->cur++;
+                continue;
+            }
+
+            switch (p[3]) {
+              case 0xb9: /* program end code */
+                R->done = TC_TRUE;
+                return 0;
+
+              case 0xba: /* pack header */
+                if ((p[4] & 0xc0) == 0x40) {        /* MPEG-2 */
+                    if (p + 14 > R->end) {
+                        goto refill;
+                    }
+                    next = p + 14 + (p[13] & 7);
+                } else if ((p[4] & 0xf0) == 0x20) { /* MPEG-1 */
+                    next = p + 12;
+                } else {
+                    tc_log_error(READER_NAME, "weird pack header");
+                    return TC_ERROR;
+                }
+                if (next > R->end) {
+                    goto refill;
+                }
+                R->cur = next;
+                break;
+
+              case 0xe0: case 0xe1: case 0xe2: case 0xe3: /* video */
+              case 0xe4: case 0xe5: case 0xe6: case 0xe7:
+              case 0xe8: case 0xe9: case 0xea: case 0xeb:
+              case 0xec: case 0xed: case 0xee: case 0xef:
+                next = p + 6 + (p[4] << 8) + p[5];
+                if (next > R->end) {
+                    goto refill;
+                }
+                if (next < p + 9) {
+                    payload = next; /* no room for a payload */
+                } else if ((p[6] & 0xc0) == 0x80) { /* MPEG-2 */
+                    payload = p + 9 + p[8];
+                } else {                            /* MPEG-1 */
+                    for (payload = p + 6;
+                         payload < next && *payload == 0xff; payload++) {
+                        if (payload == p + 6 + 16) {
+                            tc_log_warn(READER_NAME, "too much stuffing");
+                            break;
+                        }
+                    }
+                    if (payload >= next || *payload == 0xff) {
+                        payload = next; /* skip the whole packet */
+                    } else {
+                        if ((*payload & 0xc0) == 0x40) {
+                            payload += 2;
+                        }
+                        payload += mpeg1_skip_table[*payload >> 4];
+                    }
+                }
+                R->cur = next;
+                if (payload < next) {
+                    *data = payload;
+                    return next - payload;
+                }
+                break;
+
+              default:
+                if (p[3] < 0xb9) {
+                    tc_log_warn(READER_NAME, "broken stream - skipping data");
+                }
+                next = p + 6 + (p[4] << 8) + p[5];
+                if (next > R->end) {
+                    goto refill;
+                }
+                R->cur = next;
+                break;
+            }
+        }
+
+      refill:
+        if (R->eof || reader_refill(R) == 0) {
+            break;
+        }
+    }
+    return 0;
+}
+
+/*************************************************************************/
+
+TCMpegReader *tc_mpeg_reader_new(int fd, int program, int verbose)
+{
+    TCMpegReader *R = NULL;
+
+    if (fd < 0) {
+        return NULL;
+    }
+    R = tc_zalloc(sizeof(TCMpegReader));
+    if (R == NULL) {
+        return NULL;
+    }
+    R->buf = tc_malloc(READER_BUFFER_SIZE);
+    if (R->buf == NULL) {
+        tc_free(R);
+        return NULL;
+    }
+    R->fd       = fd;
+    R->program  = program;
+    R->verbose  = verbose;
+    R->complain = TC_TRUE;
+    R->cur      = R->buf;
+    R->end      = R->buf;
+    return R;
+}
+
+TCMpegReader *tc_mpeg_reader_open(const char *name, off_t offset,
+                                  int verbose)
+{
+    TCMpegReader *R = NULL;
+    uint8_t magic[4];
+    int fd = -1;
+
+    fd = open(name, O_RDONLY);
+    if (fd < 0) {
+        tc_log_perror(READER_NAME, "open file");
+        return NULL;
+    }
+    if (offset > 0 && lseek(fd, offset, SEEK_SET) != offset) {
+        tc_log_warn(READER_NAME, "unable to seek to %lu in %s",
+                    (unsigned long)offset, name);
+        close(fd);
+        return NULL;
+    }
+    if (tc_pread(fd, magic, sizeof(magic)) != sizeof(magic)) {
+        tc_log_warn(READER_NAME, "%s: file too short", name);
+        close(fd);
+        return NULL;
+    }
+    if (!memcmp(magic, "RIFF", 4)) {
+        /* CDXA, that is AVI_dump(); not worth an in-process path */
+        close(fd);
+        return NULL;
+    }
+
+    R = tc_mpeg_reader_new(fd, (magic[0] == 0 && magic[1] == 0
+                                && magic[2] == 1 && magic[3] == 0xba),
+                           verbose);
+    if (R == NULL) {
+        close(fd);
+        return NULL;
+    }
+    R->owned = TC_TRUE;
+
+    /* the magic bytes are data too */
+    memcpy(R->end, magic, sizeof(magic));
+    R->end += sizeof(magic);
+    R->pos  = offset + sizeof(magic);
+
+    if (verbose & TC_DEBUG) {
+        tc_log_info(READER_NAME, "%s: %s stream", name,
+                    (R->program) ?"program" :"elementary");
+    }
+    return R;
+}
+
+void tc_mpeg_reader_del(TCMpegReader *R)
+{
+    if (R != NULL) {
+        if (R->owned) {
+            close(R->fd);
+        }
+        tc_free(R->buf);
+        tc_free(R);
+    }
+}
+
+int tc_mpeg_reader_next(TCMpegReader *R, const uint8_t **data)
+{
+    if (R == NULL || data == NULL) {
+        return TC_ERROR;
+    }
+    if (R->chunk_len > 0) {
+        int len = R->chunk_len;
+
+        *data = R->chunk;
+        R->chunk_len = 0;
+        return len;
+    }
+    return (R->program) ?reader_next_ps(R, data) :reader_next_es(R, data);
+}
+
+int tc_mpeg_reader_read(TCMpegReader *R, uint8_t *buf, int len)
+{
+    int done = 0;
+
+    if (R == NULL || buf == NULL || len < 0) {
+        return TC_ERROR;
+    }
+    while (done < len) {
+        const uint8_t *data = NULL;
+        int n = tc_mpeg_reader_next(R, &data);
+
+        if (n <= 0) {
+            if (n < 0 && done == 0) {
+                return TC_ERROR;
+            }
+            break;
+        }
+        if (n > len - done) {
+            /* keep the rest for later */
+            R->chunk     = data + (len - done);
+            R->chunk_len = n - (len - done);
+            n = len - done;
+        }
+        memcpy(buf + done, data, n);
+        done += n;
+    }
+    return done;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,122 @@
+/*
+ * mpeg_reader.h -- in-process extraction of MPEG video elementary streams.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MPEG_READER_H
+#define MPEG_READER_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Quick Summary:
+ * a reader gives the MPEG video elementary stream found in a program
+ * stream (VOB) or in a plain elementary stream (m2v), in the same way
+ * `tcextract -x mpeg2' does, but through plain function calls.
+ * tcextract itself is built on top of it, and the import modules use
+ * it to avoid a chain of processes and pipes for the common cases.
+ *
+ * Data is handed out in chunks which point straight into the reader
+ * buffer, so it can be given to a decoder with no copy at all.
+ */
+
+typedef struct tcmpegreader_ TCMpegReader;
+
+/*
+ * tc_mpeg_reader_new:
+ *     create a reader over an already open file descriptor.
+ *     The descriptor is not closed by tc_mpeg_reader_del.
+ *
+ * Parameters:
+ *          fd: file descriptor to read from (can be a pipe).
+ *     program: if TC_TRUE, the data is a program stream to be
+ *              demultiplexed; otherwise it is already an elementary
+ *              stream, and it is just passed through.
+ *     verbose: verbosity level.
+ * Return Value:
+ *     pointer to the new reader on success, NULL on error.
+ */
+TCMpegReader *tc_mpeg_reader_new(int fd, int program, int verbose);
+
+/*
+ * tc_mpeg_reader_open:
+ *     create a reader over a file, autodetecting its kind.
+ *
+ * Parameters:
+ *        name: path of the file to open.
+ *      offset: where to start reading, in bytes.
+ *     verbose: verbosity level.
+ * Return Value:
+ *     pointer to the new reader on success, NULL on error or if the
+ *     file can't be handled in-process (e.g. CDXA). The caller should
+ *     fall back to the tcextract pipeline in that case.
+ */
+TCMpegReader *tc_mpeg_reader_open(const char *name, off_t offset,
+                                  int verbose);
+
+/*
+ * tc_mpeg_reader_del:
+ *     release a reader and all its resources.
+ *
+ * Parameters:
+ *     R: reader to release.
+ * Return Value:
+ *     None.
+ */
+void tc_mpeg_reader_del(TCMpegReader *R);
+
+/*
+ * tc_mpeg_reader_next:
+ *     get the next chunk of the elementary stream.
+ *
+ * Parameters:
+ *        R: reader to use.
+ *     data: will point to the chunk. The chunk is owned by the reader
+ *           and stays valid only until the next call on the reader.
+ * Return Value:
+ *     size of the chunk in bytes, 0 at the end of the stream,
+ *     TC_ERROR if the stream is broken beyond repair.
+ */
+int tc_mpeg_reader_next(TCMpegReader *R, const uint8_t **data);
+
+/*
+ * tc_mpeg_reader_read:
+ *     copy the next bytes of the elementary stream.
+ *
+ * Parameters:
+ *       R: reader to use.
+ *     buf: buffer to fill.
+ *     len: bytes wanted.
+ * Return Value:
+ *     number of bytes copied: less than `len' only at the end of the
+ *     stream. TC_ERROR if the stream is broken beyond repair.
+ */
+int tc_mpeg_reader_read(TCMpegReader *R, uint8_t *buf, int len);
+
+#endif  /* MPEG_READER_H */
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
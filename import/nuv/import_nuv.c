@@ -45,8 +45,9 @@ typedef struct {
     int dec_initted;     // Decompressor initted?
 
     // Previous video frame, for frame cloning
-    uint8_t saved_vframe[TC_MAX_V_FRAME_WIDTH*TC_MAX_V_FRAME_HEIGHT*3];
+    uint8_t *saved_vframe;
     int saved_vframelen;
+    uint8_t *demux_vframe;  // Demultiplexed frame, for the old interface
     uint8_t saved_vcomptype;
     struct rtframeheader framehdr;  // Next video frame header
 } PrivateData;
@@ -54,6 +55,10 @@ typedef struct {
 /* NuppelVideo always uses 44100 sps */
 #define NUV_ARATE   44100
 
+/* Largest video packet we accept: neither RTjpeg nor LZO output comes
+ * anywhere near twice the size of a raw YUV 4:2:0 frame. */
+#define NUV_MAX_VPACKET(pd) ((pd)->width * (pd)->height * 3)
+
 /*************************************************************************/
 /*************************************************************************/
 
@@ -80,6 +85,8 @@ static int nuv_init(TCModuleInstance *self, uint32_t features)
     }
     pd->fd = -1;
     pd->dec_initted = 0;
+    pd->saved_vframe = NULL;
+    pd->demux_vframe = NULL;
 
     if (verbose) {
         tc_log_info(MOD_NAME, "%s %s", MOD_VERSION, MOD_CAP);
@@ -107,6 +114,8 @@ static int nuv_fini(TCModuleInstance *self)
         close(pd->fd);
         pd->fd = -1;
     }
+    tc_free(pd->saved_vframe);
+    tc_free(pd->demux_vframe);
 
     tc_free(self->userdata);
     self->userdata = NULL;
@@ -157,8 +166,25 @@ static int nuv_configure(TCModuleInstance *self, const char *options,
         pd->fd = -1;
         return TC_OK;
     }
+    if (hdr.width <= 0 || hdr.width > TC_MAX_V_FRAME_WIDTH
+     || hdr.height <= 0 || hdr.height > TC_MAX_V_FRAME_HEIGHT) {
+        tc_log_error(MOD_NAME, "Bad frame size %dx%d in %s",
+                     hdr.width, hdr.height, filename);
+        close(pd->fd);
+        pd->fd = -1;
+        return TC_OK;
+    }
     pd->width = hdr.width;
     pd->height = hdr.height;
+    tc_free(pd->saved_vframe);
+    tc_free(pd->demux_vframe);
+    pd->saved_vframe = tc_malloc(NUV_MAX_VPACKET(pd));
+    pd->demux_vframe = tc_malloc(5 + sizeof(pd->cdata)
+                                 + NUV_MAX_VPACKET(pd));
+    if (!pd->saved_vframe || !pd->demux_vframe) {
+        tc_log_error(MOD_NAME, "configure: out of memory!");
+        return TC_ERROR;
+    }
     pd->fps = hdr.fps;
     pd->tsoffset = 0;
     pd->framenum = 0;
@@ -396,6 +422,12 @@ static int nuv_demultiplex(TCModuleInstance *self,
     }
     if ((timestamp - pd->tsoffset) < (pd->framenum+0.5)/pd->fps) {
         if (pd->framehdr.comptype != 'L') {  // 'L'ast frame: keep saved data
+            if (pd->framehdr.packetlength > NUV_MAX_VPACKET(pd)) {
+                tc_log_warn(MOD_NAME, "Video packet too large (%d bytes)",
+                            pd->framehdr.packetlength);
+                nuv_stop(self);
+                return TC_ERROR;
+            }
             if (pd->framehdr.packetlength > 0) {
                 if (read(pd->fd, pd->saved_vframe, pd->framehdr.packetlength) 
                     != pd->framehdr.packetlength
@@ -651,8 +683,7 @@ MOD_decode
 
     if (param->flag == TC_VIDEO) {
         vframe_list_t vframe1, vframe2;
-        static uint8_t tempvbuf[TC_MAX_V_FRAME_WIDTH*TC_MAX_V_FRAME_HEIGHT*3];
-        vframe1.video_buf = tempvbuf;
+        vframe1.video_buf = pd->demux_vframe;
         vframe2.video_buf = param->buffer;
         if (param->attributes & TC_FRAME_IS_OUT_OF_RANGE) {
             if (nuv_demultiplex(mod, &vframe2, NULL) < 0)
@@ -77,19 +77,11 @@ packet_list_t *packet_register(int id)
 
   // retrieve a valid pointer from the pool
 
-#ifdef STATBUFFER
   tc_debug(TC_DEBUG_FLIST, "packet id=%d", id);
   if((ptr = sbuf_retrieve()) == NULL) {
     pthread_mutex_unlock(&packet_list_lock);
     return(NULL);
   }
-#else
-
-  if((ptr = tc_malloc(sizeof(packet_list_t))) == NULL) {
-    pthread_mutex_unlock(&packet_list_lock);
-    return(NULL);
-  }
-#endif
 
   ptr->status = PACKET_EMPTY;
 
@@ -150,11 +142,7 @@ void packet_remove(packet_list_t *ptr)
   // release valid pointer to pool
   ptr->status = PACKET_EMPTY;
 
-#ifdef STATBUFFER
-      sbuf_release(ptr);
-#else
-      free(ptr);
-#endif
+  sbuf_release(ptr);
 
   pthread_mutex_unlock(&packet_list_lock);
 
@@ -434,18 +422,13 @@ int flush_buffer_init(int _ifd, int _verbose)
 
     pack_fill_ctr=0;
 
-#ifdef STATBUFFER
   // allocate buffer
   if(verbose_flag & TC_DEBUG)
-    tc_log_msg(__FILE__, "allocating %d framebuffer (static)", FLUSH_BUFFER_MAX);
+    tc_log_msg(__FILE__, "allocating %d packet buffers", FLUSH_BUFFER_MAX);
   if(sbuf_alloc(FLUSH_BUFFER_MAX)<0) {
-    tc_log_error(__FILE__, "static framebuffer allocation failed");
+    tc_log_error(__FILE__, "packet buffer allocation failed");
     exit(1);
   }
-#else
-  if(verbose_flag & TC_DEBUG)
-    tc_log_msg(__FILE__, "%d framebuffer (dynamic) requested", FLUSH_BUFFER_MAX);
-#endif
 
 
   // start the flush thread
@@ -144,33 +144,12 @@ void tc_init_audio_frame(TCFrameAudio *aptr,
 TCFrameVideo *tc_new_video_frame(int width, int height, int format,
                                   int partial)
 {
-    TCFrameVideo *vptr = NULL;
-    size_t psizes[3] = { 0, 0, 0 };
-
-    int ret = tc_video_planes_size(psizes, width, height, format);
-    if (ret == 0) {
-        vptr = tc_alloc_video_frame(psizes[0] + psizes[1] + psizes[2],
-                                    partial);
-
-        if (vptr != NULL) {
-            tc_init_video_frame(vptr, width, height, format);
-        }
-    }
-    return vptr;
+    return tc_new_video_frame_arena(NULL, width, height, format, partial);
 }
 
 TCFrameAudio *tc_new_audio_frame(double samples, int channels, int bits)
 {
-    TCFrameAudio *aptr = NULL;
-    int unused = 0;
-    size_t asize = tc_audio_frame_size(samples, channels, bits, &unused);
-
-    aptr = tc_alloc_audio_frame(asize);
-
-    if (aptr != NULL) {
-        tc_init_audio_frame(aptr, samples, channels, bits);
-    }
-    return aptr;
+    return tc_new_audio_frame_arena(NULL, samples, channels, bits);
 }
 
 #define TC_FRAME_EXTRA_SIZE     128
@@ -201,25 +180,64 @@ TCFrameAudio *tc_new_audio_frame(double samples, int channels, int bits)
  * allocating them on-demand isn't a viable alternative.
  */
 
-TCFrameVideo *tc_alloc_video_frame(size_t size, int partial)
+size_t tc_video_frame_buffer_size(int width, int height, int format)
 {
-    TCFrameVideo *vptr = tc_zalloc(sizeof(TCFrameVideo));
+    size_t psizes[3] = { 0, 0, 0 };
+    size_t size = 0;
+
+    if (tc_video_planes_size(psizes, width, height, format) != 0) {
+        return 0;
+    }
+    size = psizes[0] + psizes[1] + psizes[2];
+#ifdef TC_FRAME_EXTRA_SIZE
+    size += TC_FRAME_EXTRA_SIZE;
+#endif
+    return size;
+}
+
+size_t tc_audio_frame_buffer_size(double samples, int channels, int bits)
+{
+    int unused = 0;
+    size_t size = tc_audio_frame_size(samples, channels, bits, &unused);
 
 #ifdef TC_FRAME_EXTRA_SIZE
     size += TC_FRAME_EXTRA_SIZE;
 #endif
+    return size;
+}
+
+/* buffers come either from the given arena or from the heap */
+
+static uint8_t *frame_buffer_get(TCArena *arena, size_t size)
+{
+    return (arena != NULL) ?tc_arena_get(arena) :tc_bufalloc(size);
+}
+
+static void frame_buffer_put(TCArena *arena, uint8_t *buf)
+{
+    if (arena != NULL) {
+        tc_arena_put(arena, buf);
+    } else {
+        tc_buffree(buf);
+    }
+}
+
+static TCFrameVideo *alloc_video_frame(TCArena *arena, size_t size,
+                                       int partial)
+{
+    TCFrameVideo *vptr = tc_zalloc(sizeof(TCFrameVideo));
 
     if (vptr != NULL) {
-#ifdef STATBUFFER
-        vptr->internal_video_buf_0 = tc_bufalloc(size);
+        vptr->arena = arena;
+        vptr->internal_video_buf_0 = frame_buffer_get(arena, size);
         if (vptr->internal_video_buf_0 == NULL) {
             tc_free(vptr);
             return NULL;
         }
         if (!partial) {
-            vptr->internal_video_buf_1 = tc_bufalloc(size);
+            vptr->internal_video_buf_1 = frame_buffer_get(arena, size);
             if (vptr->internal_video_buf_1 == NULL) {
-                tc_buffree(vptr->internal_video_buf_0);
+                frame_buffer_put(arena, vptr->internal_video_buf_0);
                 tc_free(vptr);
                 return NULL;
             }
@@ -227,29 +245,68 @@ TCFrameVideo *tc_alloc_video_frame(size_t size, int partial)
             vptr->internal_video_buf_1 = NULL;
         }
         vptr->video_size = size;
-#endif /* STATBUFFER */
     }
     return vptr;
-
 }
 
-TCFrameAudio *tc_alloc_audio_frame(size_t size)
+static TCFrameAudio *alloc_audio_frame(TCArena *arena, size_t size)
 {
     TCFrameAudio *aptr = tc_zalloc(sizeof(TCFrameAudio));
 
-#ifdef TC_FRAME_EXTRA_SIZE
-    size += TC_FRAME_EXTRA_SIZE;
-#endif
-
     if (aptr != NULL) {
-#ifdef STATBUFFER
-        aptr->internal_audio_buf = tc_bufalloc(size);
+        aptr->arena = arena;
+        aptr->internal_audio_buf = frame_buffer_get(arena, size);
         if (aptr->internal_audio_buf == NULL) {
             tc_free(aptr);
             return NULL;
         }
         aptr->audio_size = size;
-#endif /* STATBUFFER */
+    }
+    return aptr;
+}
+
+TCFrameVideo *tc_alloc_video_frame(size_t size, int partial)
+{
+#ifdef TC_FRAME_EXTRA_SIZE
+    size += TC_FRAME_EXTRA_SIZE;
+#endif
+    return alloc_video_frame(NULL, size, partial);
+}
+
+TCFrameAudio *tc_alloc_audio_frame(size_t size)
+{
+#ifdef TC_FRAME_EXTRA_SIZE
+    size += TC_FRAME_EXTRA_SIZE;
+#endif
+    return alloc_audio_frame(NULL, size);
+}
+
+TCFrameVideo *tc_new_video_frame_arena(TCArena *arena,
+                                       int width, int height, int format,
+                                       int partial)
+{
+    TCFrameVideo *vptr = NULL;
+    size_t size = tc_video_frame_buffer_size(width, height, format);
+
+    if (size > 0) {
+        vptr = alloc_video_frame(arena, size, partial);
+        if (vptr != NULL) {
+            tc_init_video_frame(vptr, width, height, format);
+        }
+    }
+    return vptr;
+}
+
+TCFrameAudio *tc_new_audio_frame_arena(TCArena *arena,
+                                       double samples, int channels,
+                                       int bits)
+{
+    TCFrameAudio *aptr = NULL;
+    size_t size = tc_audio_frame_buffer_size(samples, channels, bits);
+
+    aptr = alloc_audio_frame(arena, size);
+    if (aptr != NULL) {
+        tc_init_audio_frame(aptr, samples, channels, bits);
     }
     return aptr;
 }
@@ -257,12 +314,10 @@ TCFrameAudio *tc_alloc_audio_frame(size_t size)
 void tc_del_video_frame(TCFrameVideo *vptr)
 {
     if (vptr != NULL) {
-#ifdef STATBUFFER
         if (vptr->internal_video_buf_1 != NULL) {
-            tc_buffree(vptr->internal_video_buf_1);
+            frame_buffer_put(vptr->arena, vptr->internal_video_buf_1);
         }
-        tc_buffree(vptr->internal_video_buf_0);
-#endif
+        frame_buffer_put(vptr->arena, vptr->internal_video_buf_0);
         tc_free(vptr);
     }
 }
@@ -270,9 +325,7 @@ void tc_del_video_frame(TCFrameVideo *vptr)
 void tc_del_audio_frame(TCFrameAudio *aptr)
 {
     if (aptr != NULL) {
-#ifdef STATBUFFER
-        tc_buffree(aptr->internal_audio_buf);
-#endif
+        frame_buffer_put(aptr->arena, aptr->internal_audio_buf);
         tc_free(aptr);
     }
 }
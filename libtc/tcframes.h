@@ -32,6 +32,7 @@
 #include <sys/types.h>
 
 #include "libtcutil/tctimer.h"
+#include "libtcutil/tcarena.h"
 #include "libtc/tccodecs.h"
 
 /*************************************************************************/
@@ -222,6 +223,43 @@ TCFrameVideo *tc_new_video_frame(int width, int height, int format,
  */
 TCFrameAudio *tc_new_audio_frame(double samples, int channels, int bits);
 
+/*
+ * tc_{video,audio}_frame_buffer_size:
+ *     compute the size of a single buffer of a frame allocated by
+ *     tc_new_{video,audio}_frame with the same parameters.
+ *     Useful to size an arena for tc_new_{video,audio}_frame_arena.
+ *
+ * Parameters:
+ *     see tc_new_{video,audio}_frame.
+ * Return Value:
+ *     size in bytes of the buffer, 0 on error (bad parameters).
+ */
+size_t tc_video_frame_buffer_size(int width, int height, int format);
+size_t tc_audio_frame_buffer_size(double samples, int channels, int bits);
+
+/*
+ * tc_new_{video,audio}_frame_arena:
+ *     like tc_new_{video,audio}_frame, but take the buffers from
+ *     an arena instead of the heap. The arena must outlive the frame,
+ *     and its blocks must be at least tc_{video,audio}_frame_buffer_size
+ *     bytes large. A video frame takes two blocks (one if `partial'),
+ *     an audio frame takes one.
+ *
+ * Parameters:
+ *     arena: arena to take the buffers from.
+ *     others: see tc_new_{video,audio}_frame.
+ * Return Value:
+ *     pointer to a new TCFrame{Video,Audio} (free it using
+ *     tc_del_{video,audio}_frame) if succesfull, NULL otherwise
+ *     (including the case of an exhausted arena).
+ */
+TCFrameVideo *tc_new_video_frame_arena(TCArena *arena,
+                                       int width, int height, int format,
+                                       int partial);
+TCFrameAudio *tc_new_audio_frame_arena(TCArena *arena,
+                                       double samples, int channels,
+                                       int bits);
+
 
 /*
  * tc_del_{video,audio}_frame:
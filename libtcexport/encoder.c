@@ -168,43 +168,63 @@ int tc_encoder_close(TCEncoder *enc)
 }
 
 
+int tc_encoder_process_video(TCEncoder *enc,
+                             TCFrameVideo *vin, TCFrameVideo *vout,
+                             int *delayed)
+{
+    int ret;
+
+    /* remove spurious attributes */
+    vin->attributes = 0;
+
+    ret = tc_module_encode_video(enc->vid_mod, vin, vout);
+    if (ret != TC_OK) {
+        tc_log_error(__FILE__, "error encoding video frame");
+    }
+    *delayed = (vin->attributes & TC_FRAME_IS_DELAYED) ?1 :0;
+    vin->attributes &= ~TC_FRAME_IS_DELAYED;
+    return (ret == TC_OK) ?TC_OK :TC_ERROR;
+}
+
+int tc_encoder_process_audio(TCEncoder *enc,
+                             TCFrameAudio *ain, TCFrameAudio *aout)
+{
+    int ret;
+
+    /* remove spurious attributes */
+    ain->attributes = 0;
+
+    ret = tc_module_encode_audio(enc->aud_mod, ain, aout);
+    if (ret != TC_OK) {
+        tc_log_error(__FILE__, "error encoding audio frame");
+    }
+    return (ret == TC_OK) ?TC_OK :TC_ERROR;
+}
+
 int tc_encoder_process(TCEncoder *enc,
                        TCFrameVideo *vin, TCFrameVideo *vout,
                        TCFrameAudio *ain, TCFrameAudio *aout)
 {
     int video_delayed = 0;
-    int ret, result = TC_OK;
+    int result = TC_OK;
 
     CLEAN(enc);
-    /* remove spurious attributes */
-    vin->attributes = 0;
-    ain->attributes = 0;
 
     /* step 1: encode video */
-    ret = tc_module_encode_video(enc->vid_mod, vin, vout);
-    if (ret == TC_OK) {
+    if (tc_encoder_process_video(enc, vin, vout, &video_delayed) == TC_OK) {
         SETOK(enc, TC_VIDEO);
     } else {
-        tc_log_error(__FILE__, "error encoding video frame");
         result = TC_ERROR;
     }
-    if (vin->attributes & TC_FRAME_IS_DELAYED) {
-        vin->attributes &= ~TC_FRAME_IS_DELAYED;
-        video_delayed = 1;
-    }
 
     /* step 2: encode audio */
     if (video_delayed) {
-        ain->attributes |= TC_FRAME_IS_CLONED;
+        ain->attributes = TC_FRAME_IS_CLONED;
         tc_log_info(__FILE__, "Delaying audio");
+    } else if (tc_encoder_process_audio(enc, ain, aout) == TC_OK) {
+        SETOK(enc, TC_AUDIO);
     } else {
-        ret = tc_module_encode_audio(enc->aud_mod, ain, aout);
-        if (ret == TC_OK) {
-            SETOK(enc, TC_AUDIO);
-        } else {
-            tc_log_error(__FILE__, "error encoding audio frame");
-            result = TC_ERROR;
-        }
+        result = TC_ERROR;
     }
 
     return result;
@@ -37,7 +37,8 @@
 /*************************************************************************
  * MULTITHREADING WARNING:                                               *
  * It is *NOT SAFE* to call functions declared on this header from       *
- * different threads. See comments below.                                *
+ * different threads, except tc_encoder_process_{video,audio}.           *
+ * See comments below.                                                   *
  *************************************************************************/
 
 /*************************************************************************/
@@ -78,6 +79,28 @@ int tc_encoder_process(TCEncoder *enc,
                        TCFrameVideo *vin, TCFrameVideo *vout,
                        TCFrameAudio *ain, TCFrameAudio *aout);
 
+/*
+ * tc_encoder_process_video, tc_encoder_process_audio:
+ *      the two halves of tc_encoder_process, for the pipelined export.
+ *      They can run concurrently, each one on its own thread, as long
+ *      as every call of a kind is made by the same thread.
+ * Parameters:
+ *      enc: Pointer to an encoder instance.
+ *      vin, ain: Pointer to the raw frame to encode.
+ *      vout, aout: Pointer to a frame buffer to receive encoded data.
+ *      delayed: the video half stores here if the encoder delayed the
+ *               video frame; if so, the caller must hold back the audio
+ *               frame of the pair too, and encode it with the next one.
+ * Return Value:
+ *      TC_OK on success, TC_ERROR on error.
+ */
+int tc_encoder_process_video(TCEncoder *enc,
+                             TCFrameVideo *vin, TCFrameVideo *vout,
+                             int *delayed);
+
+int tc_encoder_process_audio(TCEncoder *enc,
+                             TCFrameAudio *ain, TCFrameAudio *aout);
+
 /*
  * tc_encoder_flush:
  *      Flush any frames buffered internally by the encoder to the output
@@ -25,9 +25,11 @@
 #endif
 
 #include <stdint.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "libtcutil/tcthread.h"
+#include "libtcutil/tccounter.h"
 
 #include "libtc/libtc.h"
 #include "libtc/tcframes.h"
@@ -43,106 +45,91 @@
 /*************************************************************************/
 
 /* counter, for stats and more */
-static uint32_t frames_encoded = 0;
-static uint32_t frames_dropped = 0;
-static uint32_t frames_skipped = 0;
-static uint32_t frames_cloned  = 0;
-/* counters can be accessed by other (ex: import) threads */
-static TCMutex frame_counter_lock;
+enum {
+    FRAMES_ENCODED = 0,
+    FRAMES_DROPPED,
+    FRAMES_SKIPPED,
+    FRAMES_CLONED,
+    FRAMES_COUNTERS,
+};
+
+/*
+ * counters are bumped by many (ex: import, filter) threads for each frame,
+ * so they are sharded. They live as long as the process: they are still
+ * read after the export layer is gone.
+ */
+static TCCounterSet *frame_counters = NULL;
 
 static void init_counters(void)
 {
-    frames_encoded = 0;
-    frames_dropped = 0;
-    frames_skipped = 0;
-    frames_cloned  = 0;
-
-    tc_mutex_init(&frame_counter_lock);
+    if (frame_counters == NULL) {
+        frame_counters = tc_counter_set_new(FRAMES_COUNTERS);
+        if (frame_counters == NULL) {
+            tc_log_warn(__FILE__, "can't allocate the frame counters");
+        }
+    } else {
+        tc_counter_reset(frame_counters);
+    }
 }
 
 
 uint32_t tc_get_frames_encoded(void)
 {
-    uint32_t val;
-
-    tc_mutex_lock(&frame_counter_lock);
-    val = frames_encoded;
-    tc_mutex_unlock(&frame_counter_lock);
-
-    return val;
+    return tc_counter_get(frame_counters, FRAMES_ENCODED);
 }
 
 void tc_update_frames_encoded(uint32_t val)
 {
-    tc_mutex_lock(&frame_counter_lock);
-    frames_encoded += val;
-    tc_mutex_unlock(&frame_counter_lock);
+    tc_counter_add(frame_counters, FRAMES_ENCODED, val);
 }
 
 uint32_t tc_get_frames_dropped(void)
 {
-    uint32_t val;
-
-    tc_mutex_lock(&frame_counter_lock);
-    val = frames_dropped;
-    tc_mutex_unlock(&frame_counter_lock);
-
-    return val;
+    return tc_counter_get(frame_counters, FRAMES_DROPPED);
 }
 
 void tc_update_frames_dropped(uint32_t val)
 {
-    tc_mutex_lock(&frame_counter_lock);
-    frames_dropped += val;
-    tc_mutex_unlock(&frame_counter_lock);
+    tc_counter_add(frame_counters, FRAMES_DROPPED, val);
 }
 
 uint32_t tc_get_frames_skipped(void)
 {
-    uint32_t val;
-
-    tc_mutex_lock(&frame_counter_lock);
-    val = frames_skipped;
-    tc_mutex_unlock(&frame_counter_lock);
-
-    return val;
+    return tc_counter_get(frame_counters, FRAMES_SKIPPED);
 }
 
 void tc_update_frames_skipped(uint32_t val)
 {
-    tc_mutex_lock(&frame_counter_lock);
-    frames_skipped += val;
-    tc_mutex_unlock(&frame_counter_lock);
+    tc_counter_add(frame_counters, FRAMES_SKIPPED, val);
 }
 
 uint32_t tc_get_frames_cloned(void)
 {
-    uint32_t val;
-
-    tc_mutex_lock(&frame_counter_lock);
-    val = frames_cloned;
-    tc_mutex_unlock(&frame_counter_lock);
-
-    return val;
+    return tc_counter_get(frame_counters, FRAMES_CLONED);
 }
 
 void tc_update_frames_cloned(uint32_t val)
 {
-    tc_mutex_lock(&frame_counter_lock);
-    frames_cloned += val;
-    tc_mutex_unlock(&frame_counter_lock);
+    tc_counter_add(frame_counters, FRAMES_CLONED, val);
 }
 
 uint32_t tc_get_frames_skipped_cloned(void)
 {
-    uint32_t s, c;
+    unsigned long vals[FRAMES_COUNTERS] = { 0 };
+
+    tc_counter_snapshot(frame_counters, vals);
+    return (uint32_t)(vals[FRAMES_CLONED] - vals[FRAMES_SKIPPED]);
+}
 
-    tc_mutex_lock(&frame_counter_lock);
-    s = frames_skipped;
-    c = frames_cloned;
-    tc_mutex_unlock(&frame_counter_lock);
+void tc_get_frames_counters(TCFrameCounters *counters)
+{
+    unsigned long vals[FRAMES_COUNTERS] = { 0 };
 
-    return (c - s);
+    tc_counter_snapshot(frame_counters, vals);
+    counters->encoded = vals[FRAMES_ENCODED];
+    counters->dropped = vals[FRAMES_DROPPED];
+    counters->skipped = vals[FRAMES_SKIPPED];
+    counters->cloned  = vals[FRAMES_CLONED];
 }
 
 /*************************************************************************/
@@ -218,6 +205,8 @@ struct tcexportdata_ {
     int                 has_aux;
     int                 progress_meter;
     int                 cluster_mode;
+
+    int                 pipeline_depth; /* 0: synchronous export */
 };
 
 /* for the remaining fields, we're fine with 0/NULL */
@@ -236,6 +225,7 @@ static TCExportData expdata = {
     .has_aux            = 0,
     .progress_meter     = 1,
     .cluster_mode       = 0,
+    .pipeline_depth     = 0,
 };
 
 
@@ -454,6 +444,343 @@ static int tc_export_skip(int frame_id,
     return TC_OK;
 }
 
+/*************************************************************************/
+/* pipelined export                                                      */
+/*************************************************************************/
+
+/*
+ * With a pipeline, video encoding, audio encoding and multiplexing run
+ * on three threads: the export loop feeds frame pairs in a ring of
+ * slots, the video thread encodes them in order, then the audio thread,
+ * and the export loop multiplexes and releases them in order. So frames
+ * can't be reordered, and the A/V interleaving is the same as without
+ * the pipeline; but the audio encoding of a frame overlaps the video
+ * encoding of the next ones.
+ *
+ * The audio encoding of a frame needs to know if the video encoder
+ * delayed the frame of the same pair; in that case the audio frame is
+ * held back (like tc_encoder_process does, reinjecting it), and encoded
+ * with the next pair: the audio thread keeps a queue of those. The
+ * encoder may delay any number of frames in a row, and the frames of
+ * the later pairs are already in flight, so the frame can't go back to
+ * the source: the queue holds private copies, and grows as needed, so
+ * the input frames still go back in order with their slots.
+ *
+ * All the counters only grow: muxed <= audio <= video <= filled, and
+ * filled - muxed <= depth. Slot `n' is slots[n % depth].
+ */
+
+typedef struct tcexportslot_ TCExportSlot;
+struct tcexportslot_ {
+    TCFramePair     input;
+    TCFramePair     priv;
+    TCFrameAudio    *held;      /* held back copy encoded here, if any */
+    int             frame_id;
+    int             delayed;
+    int             error;
+};
+
+typedef struct tcexportpipe_ TCExportPipe;
+struct tcexportpipe_ {
+    TCMutex         lock;
+    TCCondition     cond;       /* some counter moved */
+
+    TCExportSlot    *slots;
+    int             depth;
+
+    int             filled;
+    int             video;
+    int             audio;
+    int             muxed;
+    int             stop;
+
+    TCFrameAudio    **held;     /* copies of the audio frames held back,
+                                   oldest first */
+    int             held_num;
+    int             held_size;
+
+    TCThread        video_th;
+    TCThread        audio_th;
+};
+
+static TCExportPipe pipe_data;
+
+static void pipe_free_slots(TCExportPipe *P, int num)
+{
+    int i = 0;
+
+    for (i = 0; i < num; i++) {
+        tc_del_video_frame(P->slots[i].priv.video);
+        tc_del_audio_frame(P->slots[i].priv.audio);
+        tc_del_audio_frame(P->slots[i].held);
+    }
+    for (i = 0; i < P->held_num; i++) {
+        tc_del_audio_frame(P->held[i]);
+    }
+    tc_free(P->slots);
+    tc_free(P->held);
+    P->slots = NULL;
+    P->held  = NULL;
+}
+
+static int pipe_alloc_slots(TCExportPipe *P, TCExportData *data)
+{
+    int i = 0;
+
+    P->slots = tc_zalloc(P->depth * sizeof(TCExportSlot));
+    /* grows if the video encoder delays more frames in a row */
+    P->held  = tc_zalloc(P->depth * sizeof(TCFrameAudio *));
+    P->held_size = P->depth;
+    if (P->slots == NULL || P->held == NULL) {
+        pipe_free_slots(P, 0);
+        return TC_ERROR;
+    }
+    for (i = 0; i < P->depth; i++) {
+        TCExportSlot *S = &P->slots[i];
+
+        S->priv.video = tc_new_video_frame(data->specs->width,
+                                           data->specs->height,
+                                           data->specs->format,
+                                           TC_FALSE);
+        S->priv.audio = tc_new_audio_frame(data->specs->samples,
+                                           data->specs->channels,
+                                           data->specs->bits);
+        if (S->priv.video == NULL || S->priv.audio == NULL) {
+            tc_del_video_frame(S->priv.video);
+            tc_del_audio_frame(S->priv.audio);
+            pipe_free_slots(P, i);
+            return TC_ERROR;
+        }
+    }
+    return TC_OK;
+}
+
+/* wait until `*next' can be processed; returns the slot, NULL to quit */
+static TCExportSlot *pipe_wait(TCExportPipe *P, const int *next,
+                               const int *prev)
+{
+    TCExportSlot *S = NULL;
+
+    tc_mutex_lock(&P->lock);
+    while (*next == *prev && !P->stop) {
+        tc_condition_wait(&P->cond, &P->lock);
+    }
+    if (*next < *prev) {
+        S = &P->slots[*next % P->depth];
+    }
+    tc_mutex_unlock(&P->lock);
+    return S;
+}
+
+static void pipe_advance(TCExportPipe *P, int *counter)
+{
+    tc_mutex_lock(&P->lock);
+    (*counter)++;
+    tc_condition_broadcast(&P->cond);
+    tc_mutex_unlock(&P->lock);
+}
+
+static int pipe_video_thread(TCThreadData *td, void *datum)
+{
+    TCExportPipe *P = datum;
+    TCExportSlot *S = NULL;
+
+    while ((S = pipe_wait(P, &P->video, &P->filled)) != NULL) {
+        if (tc_encoder_process_video(&expdata.enc,
+                                     S->input.video, S->priv.video,
+                                     &S->delayed) != TC_OK) {
+            S->error = TC_TRUE;
+        }
+        pipe_advance(P, &P->video);
+    }
+    return 0;
+}
+
+/* queue a private copy of an audio frame held back */
+static int pipe_hold(TCExportPipe *P, const TCFrameAudio *ain)
+{
+    TCFrameAudio *copy = NULL;
+
+    if (P->held_num == P->held_size) {
+        TCFrameAudio **held = tc_realloc(P->held, P->held_size * 2
+                                                  * sizeof(TCFrameAudio *));
+        if (held == NULL) {
+            return TC_ERROR;
+        }
+        P->held = held;
+        P->held_size *= 2;
+    }
+
+    copy = tc_alloc_audio_frame(ain->audio_size);
+    if (copy == NULL) {
+        return TC_ERROR;
+    }
+    copy->id         = ain->id;
+    copy->bufid      = ain->bufid;
+    copy->tag        = ain->tag;
+    copy->attributes = ain->attributes;
+    copy->timestamp  = ain->timestamp;
+    copy->a_codec    = ain->a_codec;
+    copy->a_rate     = ain->a_rate;
+    copy->a_bits     = ain->a_bits;
+    copy->a_chan     = ain->a_chan;
+    copy->audio_buf  = copy->internal_audio_buf;
+    copy->audio_size = ain->audio_size;
+    copy->audio_len  = ain->audio_len;
+    memcpy(copy->audio_buf, ain->audio_buf, ain->audio_len);
+
+    P->held[P->held_num++] = copy;
+    return TC_OK;
+}
+
+static int pipe_audio_thread(TCThreadData *td, void *datum)
+{
+    TCExportPipe *P = datum;
+    TCExportSlot *S = NULL;
+
+    while ((S = pipe_wait(P, &P->audio, &P->video)) != NULL) {
+        TCFrameAudio *ain = S->input.audio;
+
+        if (S->delayed || P->held_num > 0) {
+            /* keep the audio stream in order */
+            if (pipe_hold(P, ain) != TC_OK) {
+                tc_log_error(__FILE__, "can't hold back an audio frame");
+                S->error = TC_TRUE;
+            }
+            ain = NULL;
+            if (!S->delayed && P->held_num > 0) {
+                /* the encoded data may point into it until muxed */
+                ain = S->held = P->held[0];
+                P->held_num--;
+                memmove(P->held, P->held + 1,
+                        P->held_num * sizeof(TCFrameAudio *));
+            }
+        }
+        if (ain == NULL) {
+            tc_log_info(__FILE__, "Delaying audio");
+        } else if (tc_encoder_process_audio(&expdata.enc,
+                                            ain, S->priv.audio) != TC_OK) {
+            S->error = TC_TRUE;
+        }
+        pipe_advance(P, &P->audio);
+    }
+    return 0;
+}
+
+static int pipe_start(TCExportPipe *P, TCExportData *data)
+{
+    memset(P, 0, sizeof(TCExportPipe));
+    P->depth = data->pipeline_depth;
+    if (pipe_alloc_slots(P, data) != TC_OK) {
+        tc_log_error(__FILE__, "can't allocate the export pipeline");
+        return TC_ERROR;
+    }
+    tc_mutex_init(&P->lock);
+    tc_condition_init(&P->cond);
+
+    tc_thread_init(&P->video_th, "export video");
+    tc_thread_init(&P->audio_th, "export audio");
+    tc_thread_start(&P->video_th, pipe_video_thread, P);
+    tc_thread_start(&P->audio_th, pipe_audio_thread, P);
+
+    tc_debug(TC_DEBUG_THREADS, "export pipeline started (%i slots)",
+             P->depth);
+    return TC_OK;
+}
+
+/*
+ * multiplex the oldest slot, once both the encoders are done with it,
+ * and give its frames back. If `wait' is false, just returns TC_ERROR
+ * if it isn't ready yet, or if there is nothing in flight.
+ */
+static int pipe_mux_one(TCExportPipe *P, TCFrameSource *fs, int wait)
+{
+    TCExportSlot *S = NULL;
+
+    tc_mutex_lock(&P->lock);
+    while (wait && P->muxed == P->audio && P->muxed < P->filled) {
+        tc_condition_wait(&P->cond, &P->lock);
+    }
+    if (P->muxed < P->audio) {
+        S = &P->slots[P->muxed % P->depth];
+    }
+    tc_mutex_unlock(&P->lock);
+
+    if (S == NULL) {
+        return TC_ERROR;
+    }
+
+    if (S->error) {
+        expdata.error_flag = 1;
+    } else if (!expdata.error_flag) {
+        if (tc_multiplexor_export(&expdata.mux,
+                                  S->priv.video, S->priv.audio) != TC_OK) {
+            expdata.error_flag = 1;
+        }
+    }
+    if (expdata.progress_meter) {
+        int last = (expdata.frame_last == TC_FRAME_LAST)
+                        ?(-1) :expdata.frame_last;
+        expdata.fill_flag = 1;
+        SHOW_PROGRESS(1, S->frame_id, expdata.frame_first, last);
+    }
+    tc_update_frames_encoded(1);
+
+    fs->free_video_frame(fs, S->input.video);
+    fs->free_audio_frame(fs, S->input.audio);
+    tc_del_audio_frame(S->held);
+    S->held = NULL;
+    pipe_advance(P, &P->muxed);
+    return TC_OK;
+}
+
+/* hand a frame pair to the encoder threads, multiplexing when full */
+static void pipe_push(TCExportPipe *P, TCFrameSource *fs, int frame_id,
+                      TCFrameVideo *vframe, TCFrameAudio *aframe)
+{
+    TCExportSlot *S = NULL;
+
+    /* take out what is ready anyway, then make room */
+    while (pipe_mux_one(P, fs, TC_FALSE) == TC_OK) {
+        ; /* nothing else */
+    }
+    while (P->filled - P->muxed >= P->depth) {
+        pipe_mux_one(P, fs, TC_TRUE);
+    }
+
+    S = &P->slots[P->filled % P->depth];
+    tc_reset_video_frame(S->priv.video);
+    tc_reset_audio_frame(S->priv.audio);
+    S->input.video = vframe;
+    S->input.audio = aframe;
+    S->frame_id    = frame_id;
+    S->delayed     = 0;
+    S->error       = TC_FALSE;
+    S->held        = NULL;
+
+    pipe_advance(P, &P->filled);
+}
+
+static void pipe_stop(TCExportPipe *P, TCFrameSource *fs)
+{
+    while (pipe_mux_one(P, fs, TC_TRUE) == TC_OK) {
+        ; /* drain */
+    }
+
+    tc_mutex_lock(&P->lock);
+    P->stop = TC_TRUE;
+    tc_condition_broadcast(&P->cond);
+    tc_mutex_unlock(&P->lock);
+
+    tc_thread_wait(&P->video_th, NULL);
+    tc_thread_wait(&P->audio_th, NULL);
+
+    /* the held back copies never encoded (the stream ended first) go
+     * with the slots */
+    pipe_free_slots(P, P->depth);
+    tc_debug(TC_DEBUG_THREADS, "export pipeline stopped");
+}
+
 static int is_running(TCRunControl *rc)
 {
     TCRunStatus S = rc->status(rc);
@@ -474,6 +801,7 @@ void tc_export_loop(TCFrameSource *fs, int frame_first, int frame_last)
 {
     int eos  = 0; /* End Of Stream flag */
     int skip = 0; /* Frames to skip before next frame to encode */
+    int pipelined = TC_FALSE;
     TCRunControl *RC = expdata.run_control; /* shortcut */
 
     tc_log_debug(TC_DEBUG_PRIVATE, __FILE__,
@@ -490,6 +818,10 @@ void tc_export_loop(TCFrameSource *fs, int frame_first, int frame_last)
     expdata.frame_last  = frame_last;
     expdata.saved_frame_last = expdata.old_frame_last;
 
+    if (expdata.pipeline_depth > 0) {
+        pipelined = (pipe_start(&pipe_data, &expdata) == TC_OK);
+    }
+
     while (!eos && !need_stop(RC, &expdata)) {
         /* stop here if pause requested */
         RC->pause(RC);
@@ -518,6 +850,11 @@ void tc_export_loop(TCFrameSource *fs, int frame_first, int frame_last)
                 tc_export_skip(expdata.frame_id,
                                expdata.input.video, expdata.input.audio, 0);
                 skip--;
+            } else if (pipelined) { /* encode frame, later */
+                pipe_push(&pipe_data, fs, expdata.frame_id,
+                          expdata.input.video, expdata.input.audio);
+                skip = expdata.job->frame_interval - 1;
+                continue; /* frames released once multiplexed */
             } else { /* encode frame */
                 tc_export_frames(expdata.frame_id,
                                  expdata.input.video, expdata.input.audio);
@@ -534,6 +871,10 @@ void tc_export_loop(TCFrameSource *fs, int frame_first, int frame_last)
     }
     /* main frame decoding loop */
 
+    if (pipelined) {
+        pipe_stop(&pipe_data, fs);
+    }
+
     if (eos) {
         tc_debug(TC_DEBUG_CLEANUP,
                  "encoder last frame finished (%i/%i)",
@@ -550,7 +891,8 @@ void tc_export_loop(TCFrameSource *fs, int frame_first, int frame_last)
  * new encoder module design principles
  * 1) keep it simple, stupid
  * 2) to have more than one encoder doesn't make sense in transcode, so
- * 3) new encoder will be monothread, like the old one
+ * 3) each encoder module is driven by a single thread; audio and video
+ *    can overlap only through the (optional) export pipeline.
  */
 
 /* FIXME: uint32_t VS int */
@@ -574,6 +916,12 @@ int tc_export_config(int verbose, int progress_meter, int cluster_mode)
     return TC_OK;
 }
 
+int tc_export_pipeline(int depth)
+{
+    expdata.pipeline_depth = (depth > 0) ?depth :0;
+    return TC_OK;
+}
+
 
 int tc_export_new(TCJob *job, TCFactory factory,
                   TCRunControl *run_control,
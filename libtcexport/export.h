@@ -56,6 +56,27 @@ uint32_t tc_get_frames_encoded(void);
 uint32_t tc_get_frames_cloned(void);
 uint32_t tc_get_frames_skipped_cloned(void);
 
+typedef struct tcframecounters_ TCFrameCounters;
+struct tcframecounters_ {
+    uint32_t encoded;
+    uint32_t dropped;
+    uint32_t skipped;
+    uint32_t cloned;
+};
+
+/*
+ * tc_get_frames_counters:
+ *     get all the frame counters at once. Unlike separate calls of the
+ *     getters above, every update made by a thread is seen completely
+ *     or not at all.
+ *
+ * Parameters:
+ *     counters: structure to fill with the current values.
+ * Return Value:
+ *     None
+ */
+void tc_get_frames_counters(TCFrameCounters *counters);
+
 /*
  * tc_update_frames_{dropped,skipped,encoded,cloned}:
  *     update the current value of a frame counter of a given value.
@@ -110,6 +131,21 @@ void tc_export_rotation_limit_frames(int frames);
 
 void tc_export_rotation_limit_megabytes(int megabytes);
 
+/*
+ * tc_export_pipeline:
+ *      encode the video, encode the audio and multiplex each frame on
+ *      three threads, with up to `depth' frames in flight between them.
+ *      The output is the same as without the pipeline. Every frame in
+ *      flight holds a frame buffer of the frame source: leave enough of
+ *      them for the import layer.
+ * Parameters:
+ *      depth: frames in flight. 0 (default) exports each frame
+ *             synchronously in tc_export_loop.
+ * Return Value:
+ *      TC_OK.
+ */
+int tc_export_pipeline(int depth);
+
 
 /*************************************************************************/
 
@@ -55,6 +55,16 @@
 /* module require extra internal buffering */ 
 #define TC_MODULE_FLAG_CONVERSION       0x00000010
 /* module requires an unavoidable csp conversion) */
+#define TC_MODULE_FLAG_FRAME_PARALLEL   0x00000020
+/* filter keeps no state across frames, can run on many frames at once */
+#define TC_MODULE_FLAG_SLICE_PARALLEL   0x00000040
+/* filter can process disjoint row ranges of a frame concurrently */
+#define TC_MODULE_FLAG_SEQUENTIAL       0x00000080
+/* filter must see frames one at a time, in order. This is assumed
+ * for any filter not flagged as FRAME_PARALLEL */
+#define TC_MODULE_FLAG_READONLY        0x00000100
+/* filter never writes on the frame payload (attributes excluded), so a
+ * frame sharing its payload with a clone can be given as is */
 
 /*
  * this structure will hold all the interesting informations
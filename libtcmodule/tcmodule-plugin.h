@@ -117,7 +117,7 @@ static int tc_module_cap_check(uint32_t flags)
         TC_MODULE_SELF_CHECK(self, "init"); \
         TC_MODULE_INIT_CHECK(self, MOD_FEATURES, features); \
         \
-        pd = tc_malloc(sizeof(MODDATA)); \
+        pd = tc_zalloc(sizeof(MODDATA)); \
         if (pd == NULL) { \
             tc_log_error(MOD_NAME, "init: out of memory!"); \
             return TC_ERROR; \
@@ -208,53 +208,80 @@ const TCModuleClass *tc_plugin_setup(void);
     }
 
 
-/* TODO: unify in a proper way OLDINTERFACE and OLDINTERFACE_M */
+#define TC_FILTER_OLDINTERFACE_INSTANCES	128	/* a power of 2 */
+
+enum {
+    TC_FILTER_SLOT_FREE = 0,    /* never used: ends a lookup */
+    TC_FILTER_SLOT_USED,
+    TC_FILTER_SLOT_GONE,        /* used before: lookups go past it */
+};
+
+/*
+ * Old-fashioned module interface: a tc_filter() entry point driving the
+ * module functions.  Each filter ID (that is, each occurrence of the
+ * filter in the chain) gets its own module instance, so instances never
+ * share their private data.  The instances are hashed on the filter ID,
+ * so a frame finds its own in a probe or two.
+ */
 #define TC_FILTER_OLDINTERFACE(name) \
-    /* Old-fashioned module interface. */ \
-    static TCModuleInstance mod; \
+    static struct { \
+        int state; \
+        int id; \
+        TCModuleInstance mod; \
+    } name ## _instances[TC_FILTER_OLDINTERFACE_INSTANCES]; \
     \
-    int tc_filter(frame_list_t *frame, char *options) \
+    static int name ## _instance_slot(int id, int create) \
     { \
-        if (frame->tag & TC_FILTER_INIT) { \
-            TCModuleExtraData *xdata[] = { NULL, NULL }; \
-            if (name ## _init(&mod, TC_MODULE_FEATURE_FILTER) < 0) { \
-                return TC_ERROR; \
-            } \
-            return name ## _configure(&mod, options, tc_get_vob(), xdata); \
-        \
-        } else if (frame->tag & TC_FILTER_GET_CONFIG) { \
-            return name ## _get_config(&mod, options); \
+        int i, slot, free_slot = -1; \
         \
-        } else if (frame->tag & TC_FILTER_CLOSE) { \
-            if (name ## _stop(&mod) < 0) { \
-                return TC_ERROR; \
+        for (i = 0; i < TC_FILTER_OLDINTERFACE_INSTANCES; i++) { \
+            slot = ((unsigned)id + i) \
+                   & (TC_FILTER_OLDINTERFACE_INSTANCES - 1); \
+            if (name ## _instances[slot].state == TC_FILTER_SLOT_USED) { \
+                if (name ## _instances[slot].id == id) { \
+                    return slot; \
+                } \
+                continue; \
+            } \
+            if (free_slot < 0) { \
+                free_slot = slot; \
+            } \
+            if (name ## _instances[slot].state == TC_FILTER_SLOT_FREE) { \
+                break; \
             } \
-            return name ## _fini(&mod); \
         } \
-        \
-        return name ## _process(&mod, frame); \
-    } 
-
-
-
-#define TC_FILTER_OLDINTERFACE_INSTANCES	128
-
-/* FIXME:
- * this uses the filter ID as an index--the ID can grow
- * arbitrarily large, so this needs to be fixed
- */
-#define TC_FILTER_OLDINTERFACE_M(name) \
-    /* Old-fashioned module interface. */ \
-    static TCModuleInstance mods[TC_FILTER_OLDINTERFACE_INSTANCES]; \
+        if (!create) { \
+            tc_log_error(MOD_NAME, "no instance for filter ID %i", id); \
+            return -1; \
+        } \
+        if (free_slot < 0) { \
+            tc_log_error(MOD_NAME, "too many instances (%i at most)", \
+                         TC_FILTER_OLDINTERFACE_INSTANCES); \
+            return -1; \
+        } \
+        memset(&name ## _instances[free_slot].mod, 0, \
+               sizeof(TCModuleInstance)); \
+        name ## _instances[free_slot].mod.id = id; \
+        name ## _instances[free_slot].id = id; \
+        name ## _instances[free_slot].state = TC_FILTER_SLOT_USED; \
+        return free_slot; \
+    } \
     \
     int tc_filter(frame_list_t *frame, char *options) \
     { \
-	TCModuleInstance *mod = &mods[frame->filter_id]; \
-	\
+        TCModuleInstance *mod = NULL; \
+        int slot = name ## _instance_slot(frame->filter_id, \
+                                          frame->tag & TC_FILTER_INIT); \
+        \
+        if (slot < 0) { \
+            return TC_ERROR; \
+        } \
+        mod = &name ## _instances[slot].mod; \
+        \
         if (frame->tag & TC_FILTER_INIT) { \
             TCModuleExtraData *xdata[] = { NULL, NULL }; \
-            tc_log_info(MOD_NAME, "instance #%i", frame->filter_id); \
             if (name ## _init(mod, TC_MODULE_FEATURE_FILTER) < 0) { \
+                name ## _instances[slot].state = TC_FILTER_SLOT_GONE; \
                 return TC_ERROR; \
             } \
             return name ## _configure(mod, options, tc_get_vob(), xdata); \
@@ -263,14 +290,19 @@ const TCModuleClass *tc_plugin_setup(void);
             return name ## _get_config(mod, options); \
         \
         } else if (frame->tag & TC_FILTER_CLOSE) { \
-            if (name ## _stop(mod) < 0) { \
-                return TC_ERROR; \
+            int ret = name ## _stop(mod); \
+            if (name ## _fini(mod) < 0) { \
+                ret = TC_ERROR; \
             } \
-            return name ## _fini(mod); \
+            name ## _instances[slot].state = TC_FILTER_SLOT_GONE; \
+            return (ret < 0) ?TC_ERROR :TC_OK; \
         } \
         \
         return name ## _process(mod, frame); \
-    } 
+    }
+
+/* kept for the filters written when only this one was per-instance */
+#define TC_FILTER_OLDINTERFACE_M(name)  TC_FILTER_OLDINTERFACE(name)
 
 
 
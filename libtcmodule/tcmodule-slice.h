@@ -0,0 +1,131 @@
+/*
+ * tcmodule-slice.h -- slice-parallel processing helpers for modules.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TCMODULESLICE_H
+#define TCMODULESLICE_H
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/*************************************************************************/
+
+/*
+ * A module flagged TC_MODULE_FLAG_SLICE_PARALLEL splits the work on a
+ * frame into independent ranges (usually ranges of rows) and hands
+ * them to tc_module_slice_run(). The core fans the ranges out, as
+ * horizontal bands, over a thread pool shared by all the modules;
+ * the calling thread works on the bands too, and the call returns
+ * only when every band is done.
+ *
+ * The slice function must only touch the given range of the output,
+ * and any scratch memory it needs must be indexed by `slot': no two
+ * bands running at the same time ever get the same slot.
+ * Scratch arrays should be sized with tc_module_slice_slots().
+ * Each running call gets slots of its own, the calling thread too, so
+ * an instance can use the same scratch arrays on many frames at once
+ * (TC_MODULE_FLAG_FRAME_PARALLEL).
+ *
+ * If the pool was not started (or it has no threads) everything runs
+ * in the caller, as a single band.
+ */
+
+/*
+ * TCModuleSliceFn:
+ *     typedef for the slice processing function.
+ *
+ * Parameters:
+ *      data: opaque pointer given to tc_module_slice_run.
+ *     first: first item (row) of the range to process.
+ *      last: one past the last item (row) of the range to process.
+ *      slot: scratch slot to use, in [0, tc_module_slice_slots()).
+ * Return Value:
+ *     None.
+ */
+typedef void (*TCModuleSliceFn)(void *data, int first, int last, int slot);
+
+/*
+ * tc_module_slice_init:
+ *     start the shared slice thread pool. Must be called only once,
+ *     before any module is configured.
+ *
+ * Parameters:
+ *     threads: total number of threads working on a frame, including
+ *              the caller; 0 or 1 means no extra thread at all.
+ *     callers: how many threads may call tc_module_slice_run at once
+ *              (>= 1); any further caller waits for a free slot.
+ * Return Value:
+ *     TC_OK on success, TC_ERROR on error.
+ */
+int tc_module_slice_init(int threads, int callers);
+
+/*
+ * tc_module_slice_fini:
+ *     stop the shared slice thread pool. Must be called when no module
+ *     is using it anymore.
+ *
+ * Parameters:
+ *     None.
+ * Return Value:
+ *     None.
+ */
+void tc_module_slice_fini(void);
+
+/*
+ * tc_module_slice_slots:
+ *     query the number of scratch slots needed by a slice function.
+ *
+ * Parameters:
+ *     None.
+ * Return Value:
+ *     number of slots (>= 1).
+ */
+int tc_module_slice_slots(void);
+
+/*
+ * tc_module_slice_run (Thread safe):
+ *     process the range [0, count) by calling `fn' over bands of at
+ *     least `grain' items, possibly in parallel. Blocks until every
+ *     band is done.
+ *
+ * Parameters:
+ *        fn: slice processing function.
+ *      data: opaque pointer passed to `fn'.
+ *     count: number of items (rows) to process.
+ *     grain: minimum number of items in a band (>= 1).
+ * Return Value:
+ *     TC_OK on success, TC_ERROR on bad parameters.
+ */
+int tc_module_slice_run(TCModuleSliceFn fn, void *data, int count,
+                        int grain);
+
+/*************************************************************************/
+
+#endif  /* TCMODULESLICE_H */
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,270 @@
+/*
+ * tcmoduleslice.c -- slice-parallel processing helpers for modules
+ *                    (implementation).
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libtcutil/tcutil.h"
+#include "libtcutil/tcthread.h"
+#include "libtcutil/tctaskpool.h"
+
+#include "tcmodule-slice.h"
+
+/* how many bands per thread, for load balancing */
+#define SLICE_BANDS_PER_THREAD  4
+
+/*************************************************************************/
+
+/*
+ * A slice job lives on the heap and it is refcounted: helpers queued
+ * in the pool may start after the caller is gone (all the bands were
+ * already done by somebody else), and they still need the job to find
+ * out that there is nothing left to do.
+ */
+typedef struct tcslicejob_ TCSliceJob;
+struct tcslicejob_ {
+    TCModuleSliceFn fn;
+    void            *data;
+    int             count;
+    int             bands;
+
+    TCMutex         lock;
+    TCCondition     finished;
+    int             next;   /* next band to run */
+    int             done;   /* bands completed */
+    int             refs;   /* caller + queued helpers */
+};
+
+static TCTaskPool *slice_pool = NULL;
+
+/*
+ * Slots [0, workers) belong to the pool workers, the next `callers'
+ * ones to the threads calling tc_module_slice_run: each call takes a
+ * free caller slot and gives it back at the end, so that two frames
+ * handled at once by the same instance never share the scratch memory.
+ * Before tc_module_slice_init there is a single caller slot, unlocked.
+ */
+static TCMutex     slice_lock;
+static TCCondition slice_idle;
+static int         *slice_free  = NULL; /* stack of idle caller slots */
+static int         slice_nfree  = 0;
+static int         slice_callers = 0;  /* 0: not initialized */
+
+
+static int slice_job_next(TCSliceJob *job)
+{
+    int band = -1;
+
+    tc_mutex_lock(&job->lock);
+    if (job->next < job->bands) {
+        band = job->next++;
+    }
+    tc_mutex_unlock(&job->lock);
+    return band;
+}
+
+static void slice_job_band(TCSliceJob *job, int band, int slot)
+{
+    int first = (int)((long)job->count * band / job->bands);
+    int last  = (int)((long)job->count * (band + 1) / job->bands);
+
+    job->fn(job->data, first, last, slot);
+
+    tc_mutex_lock(&job->lock);
+    job->done++;
+    if (job->done == job->bands) {
+        tc_condition_broadcast(&job->finished);
+    }
+    tc_mutex_unlock(&job->lock);
+}
+
+static void slice_job_release(TCSliceJob *job)
+{
+    int refs;
+
+    tc_mutex_lock(&job->lock);
+    refs = --job->refs;
+    tc_mutex_unlock(&job->lock);
+
+    if (refs == 0) {
+        tc_free(job);
+    }
+}
+
+static void slice_helper(void *task, int worker, void *userdata)
+{
+    TCSliceJob *job = task;
+    int band;
+
+    while ((band = slice_job_next(job)) >= 0) {
+        slice_job_band(job, band, worker);
+    }
+    slice_job_release(job);
+}
+
+/* waits if every caller slot is taken already */
+static int slice_caller_get(void)
+{
+    int slot = 0;
+
+    if (slice_callers == 0) {
+        return 0;
+    }
+    tc_mutex_lock(&slice_lock);
+    while (slice_nfree == 0) {
+        tc_condition_wait(&slice_idle, &slice_lock);
+    }
+    slot = slice_free[--slice_nfree];
+    tc_mutex_unlock(&slice_lock);
+    return slot;
+}
+
+static void slice_caller_put(int slot)
+{
+    if (slice_callers == 0) {
+        return;
+    }
+    tc_mutex_lock(&slice_lock);
+    slice_free[slice_nfree++] = slot;
+    tc_condition_signal(&slice_idle);
+    tc_mutex_unlock(&slice_lock);
+}
+
+/*************************************************************************/
+
+int tc_module_slice_init(int threads, int callers)
+{
+    int workers = 0, i = 0;
+
+    if (slice_callers > 0) {
+        tc_log_warn(__FILE__, "slice pool already initialized");
+        return TC_ERROR;
+    }
+    if (threads > 1) {
+        slice_pool = tc_task_pool_new(threads - 1, slice_helper, NULL,
+                                      "slice");
+        if (!slice_pool) {
+            return TC_ERROR;
+        }
+        workers = tc_task_pool_workers(slice_pool);
+    }
+
+    callers = TC_MAX(callers, 1);
+    slice_free = tc_malloc(callers * sizeof(int));
+    if (!slice_free) {
+        tc_module_slice_fini();
+        return TC_ERROR;
+    }
+    for (i = 0; i < callers; i++) {
+        slice_free[i] = workers + callers - 1 - i;
+    }
+    slice_nfree = callers;
+    tc_mutex_init(&slice_lock);
+    tc_condition_init(&slice_idle);
+    slice_callers = callers;
+    return TC_OK;
+}
+
+void tc_module_slice_fini(void)
+{
+    if (slice_pool) {
+        tc_task_pool_del(slice_pool);
+        slice_pool = NULL;
+    }
+    tc_free(slice_free);
+    slice_free    = NULL;
+    slice_nfree   = 0;
+    slice_callers = 0;
+}
+
+int tc_module_slice_slots(void)
+{
+    return tc_task_pool_workers(slice_pool) + TC_MAX(slice_callers, 1);
+}
+
+int tc_module_slice_run(TCModuleSliceFn fn, void *data, int count,
+                        int grain)
+{
+    TCSliceJob *job = NULL;
+    int helpers = 0, bands = 0, band = 0, slot = 0, i = 0;
+
+    if (!fn || count < 0 || grain < 1) {
+        return TC_ERROR;
+    }
+
+    if (count == 0) {
+        return TC_OK;
+    }
+
+    bands = (count + grain - 1) / grain;
+    bands = TC_MIN(bands, (tc_task_pool_workers(slice_pool) + 1)
+                          * SLICE_BANDS_PER_THREAD);
+    slot  = slice_caller_get();
+    job   = (bands > 1 && slice_pool) ?tc_malloc(sizeof(TCSliceJob)) :NULL;
+    if (!job) {
+        /* a single band, or degraded but still correct */
+        fn(data, 0, count, slot);
+        slice_caller_put(slot);
+        return TC_OK;
+    }
+    job->fn    = fn;
+    job->data  = data;
+    job->count = count;
+    job->bands = bands;
+    job->next  = 0;
+    job->done  = 0;
+    job->refs  = 1;
+    tc_mutex_init(&job->lock);
+    tc_condition_init(&job->finished);
+
+    helpers = TC_MIN(bands - 1, tc_task_pool_workers(slice_pool));
+    for (i = 0; i < helpers; i++) {
+        tc_mutex_lock(&job->lock);
+        job->refs++;
+        tc_mutex_unlock(&job->lock);
+        if (tc_task_pool_submit(slice_pool, job) != TC_OK) {
+            slice_job_release(job);
+            break;
+        }
+    }
+
+    while ((band = slice_job_next(job)) >= 0) {
+        slice_job_band(job, band, slot);
+    }
+
+    tc_mutex_lock(&job->lock);
+    while (job->done < job->bands) {
+        tc_condition_wait(&job->finished, &job->lock);
+    }
+    tc_mutex_unlock(&job->lock);
+    slice_caller_put(slot);
+
+    slice_job_release(job);
+    return TC_OK;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
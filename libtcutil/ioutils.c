@@ -19,6 +19,9 @@
  *
  */
 
+/* for splice() and F_SETPIPE_SZ */
+#define _GNU_SOURCE 1
+
 #include "common.h"
 #include "logging.h"
 #include "ioutils.h"
@@ -31,6 +34,8 @@
 #include <unistd.h>
 
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -161,12 +166,61 @@ ssize_t tc_pwrite(int fd, const uint8_t *buf, size_t len)
 # define BLOCKSIZE 4096
 #endif
 
+/* plain xio descriptors are real ones, and can be spliced */
+#if defined(HAVE_SPLICE) && !defined(HAVE_IBP)
+# define TC_USE_SPLICE 1
+#endif
+
+#ifdef TC_USE_SPLICE
+
+/* as much as a (grown) pipe can hold */
+#define SPLICE_SIZE (1024 * 1024)
+
+/*
+ * Returns 0 when done, -1 on error, 1 if splice() can't be used on
+ * these descriptors (and nothing was moved yet).
+ */
+static int splice_all(int fd_in, int fd_out)
+{
+    int moved = TC_FALSE;
+    ssize_t n = 0;
+
+    for (;;) {
+        n = splice(fd_in, NULL, fd_out, NULL, SPLICE_SIZE,
+                   SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n == 0) {   /* EOF */
+            return 0;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (!moved && (errno == EINVAL || errno == ENOSYS)) {
+                return 1;
+            }
+            /* the reader went away: not a read error */
+            return (errno == EPIPE) ?0 :-1;
+        }
+        moved = TC_TRUE;
+    }
+}
+
+#endif /* TC_USE_SPLICE */
+
 int tc_preadwrite(int fd_in, int fd_out)
 {
     uint8_t buffer[BLOCKSIZE];
     ssize_t bytes;
     int error = 0;
 
+#ifdef TC_USE_SPLICE
+    error = splice_all(fd_in, fd_out);
+    if (error <= 0) {
+        return error;
+    }
+    error = 0;
+#endif
+
     do {
         bytes = tc_pread(fd_in, buffer, BLOCKSIZE);
 
@@ -191,6 +245,56 @@ int tc_preadwrite(int fd_in, int fd_out)
     return 0;
 }
 
+#ifdef TC_USE_SPLICE
+
+/* unprivileged upper bound of the pipe size */
+static int pipe_max_size(void)
+{
+    FILE *f = fopen("/proc/sys/fs/pipe-max-size", "r");
+    int size = -1;
+
+    if (f != NULL) {
+        if (fscanf(f, "%i", &size) != 1) {
+            size = -1;
+        }
+        fclose(f);
+    }
+    return size;
+}
+
+int tc_pipe_grow(int fd, size_t size)
+{
+    int cur = fcntl(fd, F_GETPIPE_SZ);
+    int ret = -1;
+
+    if (cur < 0) {
+        return -1; /* not a pipe */
+    }
+    if (size <= (size_t)cur) {
+        return cur;
+    }
+    if (size > INT_MAX) {
+        size = INT_MAX;
+    }
+    ret = fcntl(fd, F_SETPIPE_SZ, (int)size);
+    if (ret < 0 && errno == EPERM) {
+        int max = pipe_max_size();
+        if (max > cur) {
+            ret = fcntl(fd, F_SETPIPE_SZ, max);
+        }
+    }
+    return (ret < 0) ?cur :ret;
+}
+
+#else /* !TC_USE_SPLICE */
+
+int tc_pipe_grow(int fd, size_t size)
+{
+    return -1;
+}
+
+#endif /* TC_USE_SPLICE */
+
 int tc_file_check(const char *name)
 {
     struct stat fbuf;
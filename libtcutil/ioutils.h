@@ -128,7 +128,8 @@ ssize_t tc_pwrite(int fd, const uint8_t *buf, size_t len);
 /*
  * tc_preadwrite:
  *     read all data avalaible from a file descriptor, putting it on the
- *     other one.
+ *     other one. If one of them is a pipe, and the system supports it,
+ *     data is moved with splice(2) and never copied in user space.
  * Parameters:
  *      in: read data from this file descriptor
  *     out: write readed data on this file descriptor
@@ -141,6 +142,22 @@ ssize_t tc_pwrite(int fd, const uint8_t *buf, size_t len);
  */
 int tc_preadwrite(int in, int out);
 
+/*
+ * tc_pipe_grow:
+ *     enlarge the kernel buffer of a pipe, so it can hold at least
+ *     `size' bytes. A whole frame can then cross the pipe with a single
+ *     write(2) on one side and a single read(2) on the other. The buffer
+ *     is never shrinked; if `size' is over the system limit, the buffer
+ *     grows up to the limit.
+ * Parameters:
+ *       fd: either end of the pipe.
+ *     size: wanted capacity in bytes.
+ * Return Value:
+ *     the capacity of the pipe in bytes, or -1 if `fd' is not a pipe or
+ *     the system can't resize pipes.
+ */
+int tc_pipe_grow(int fd, size_t size);
+
 enum {
     TC_PROBE_PATH_INVALID = 0,
     TC_PROBE_PATH_ABSPATH,
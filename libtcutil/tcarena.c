@@ -0,0 +1,263 @@
+/*
+ * tcarena.c -- fixed size memory block arenas for transcode.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+#include "memutils.h"
+#include "logging.h"
+#include "tcthread.h"
+#include "tcarena.h"
+
+#include <stdint.h>
+#include <unistd.h>
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+# include <sys/mman.h>
+# define TC_ARENA_MMAP 1
+# if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#  define MAP_ANONYMOUS MAP_ANON
+# endif
+#endif
+
+
+/*************************************************************************/
+
+#define ARENA_NAME  "arena"
+
+enum {
+    TC_ARENA_HUGEPAGE_SIZE = 2 * 1024 * 1024, /* the common case */
+};
+
+struct tcarena_ {
+    TCMutex     lock;
+    uint8_t     *base;      /* first block */
+    uint8_t     *region;    /* what must be released */
+    size_t      region_size;
+    int         mapped;
+    int         hugepages;
+
+    size_t      block_size;
+    int         blocks;
+    int         *free;      /* stack of the free block indexes */
+    int         free_num;
+};
+
+/*************************************************************************/
+
+static size_t round_up(size_t size, size_t align)
+{
+    return ((size + align - 1) / align) * align;
+}
+
+static size_t page_size(void)
+{
+#ifdef HAVE_GETPAGESIZE
+    return getpagesize();
+#else
+    return 4096;
+#endif
+}
+
+#ifdef TC_ARENA_MMAP
+
+/*
+ * Explicit huge pages first: they are guaranteed, but only if the
+ * admin reserved them. Otherwise, align a plain mapping to the huge
+ * page size and ask for transparent huge pages.
+ */
+static int arena_map(TCArena *A, size_t size, int flags)
+{
+    void *ptr = MAP_FAILED;
+
+    if (flags & TC_ARENA_HUGEPAGES) {
+        size = round_up(size, TC_ARENA_HUGEPAGE_SIZE);
+#ifdef MAP_HUGETLB
+        ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            A->region      = ptr;
+            A->region_size = size;
+            A->base        = ptr;
+            A->hugepages   = TC_TRUE;
+            return TC_OK;
+        }
+#endif
+#ifdef MADV_HUGEPAGE
+        ptr = mmap(NULL, size + TC_ARENA_HUGEPAGE_SIZE,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr != MAP_FAILED) {
+            uint8_t *region = ptr;
+            uint8_t *base = (uint8_t *)round_up((uintptr_t)region,
+                                                TC_ARENA_HUGEPAGE_SIZE);
+            size_t head = base - region;
+            size_t tail = TC_ARENA_HUGEPAGE_SIZE - head;
+
+            /* trim the unaligned edges */
+            if (head > 0) {
+                munmap(region, head);
+            }
+            if (tail > 0) {
+                munmap(base + size, tail);
+            }
+            A->region      = base;
+            A->region_size = size;
+            A->base        = base;
+            A->hugepages   = (madvise(base, size, MADV_HUGEPAGE) == 0);
+            return TC_OK;
+        }
+#endif
+    }
+
+    ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return TC_ERROR;
+    }
+    A->region      = ptr;
+    A->region_size = size;
+    A->base        = ptr;
+    return TC_OK;
+}
+
+#else  /* !TC_ARENA_MMAP */
+
+static int arena_map(TCArena *A, size_t size, int flags)
+{
+    A->region = tc_bufalloc(size);
+    if (A->region == NULL) {
+        return TC_ERROR;
+    }
+    A->region_size = size;
+    A->base        = A->region;
+    return TC_OK;
+}
+
+#endif  /* TC_ARENA_MMAP */
+
+static void arena_unmap(TCArena *A)
+{
+#ifdef TC_ARENA_MMAP
+    munmap(A->region, A->region_size);
+#else
+    tc_buffree(A->region);
+#endif
+}
+
+/*************************************************************************/
+
+TCArena *tc_arena_new(size_t block_size, int blocks, int flags)
+{
+    TCArena *A = NULL;
+    int i = 0;
+
+    if (block_size == 0 || blocks <= 0) {
+        return NULL;
+    }
+
+    A = tc_zalloc(sizeof(TCArena));
+    if (A == NULL) {
+        return NULL;
+    }
+    A->block_size = round_up(block_size, page_size());
+    A->blocks     = blocks;
+    A->free       = tc_malloc(blocks * sizeof(int));
+    if (A->free == NULL) {
+        tc_free(A);
+        return NULL;
+    }
+    if (arena_map(A, A->block_size * blocks, flags) != TC_OK) {
+        tc_log_error(ARENA_NAME, "can't reserve %lu bytes",
+                     (unsigned long)(A->block_size * blocks));
+        tc_free(A->free);
+        tc_free(A);
+        return NULL;
+    }
+
+    /* hand out the lowest addresses first */
+    for (i = 0; i < blocks; i++) {
+        A->free[i] = blocks - 1 - i;
+    }
+    A->free_num = blocks;
+    tc_mutex_init(&A->lock);
+    return A;
+}
+
+void tc_arena_del(TCArena *A)
+{
+    if (A != NULL) {
+        arena_unmap(A);
+        tc_free(A->free);
+        tc_free(A);
+    }
+}
+
+void *tc_arena_get(TCArena *A)
+{
+    void *ptr = NULL;
+
+    if (A != NULL) {
+        tc_mutex_lock(&A->lock);
+        if (A->free_num > 0) {
+            A->free_num--;
+            ptr = A->base + A->free[A->free_num] * A->block_size;
+        }
+        tc_mutex_unlock(&A->lock);
+    }
+    return ptr;
+}
+
+void tc_arena_put(TCArena *A, void *ptr)
+{
+    if (A != NULL && ptr != NULL) {
+        size_t offset = (uint8_t *)ptr - A->base;
+
+        tc_mutex_lock(&A->lock);
+        if (offset % A->block_size != 0
+         || offset / A->block_size >= A->blocks
+         || A->free_num >= A->blocks) {
+            tc_log_warn(ARENA_NAME, "block %p does not belong here", ptr);
+        } else {
+            A->free[A->free_num] = offset / A->block_size;
+            A->free_num++;
+        }
+        tc_mutex_unlock(&A->lock);
+    }
+}
+
+size_t tc_arena_size(const TCArena *A)
+{
+    return (A != NULL) ?A->region_size :0;
+}
+
+int tc_arena_hugepages(const TCArena *A)
+{
+    return (A != NULL) ?A->hugepages :TC_FALSE;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
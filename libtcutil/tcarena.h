@@ -0,0 +1,130 @@
+/*
+ * tcarena.h -- fixed size memory block arenas for transcode.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TCARENA_H
+#define TCARENA_H
+
+#include <stddef.h>
+
+/*
+ * Quick Summary:
+ * an arena hands out blocks of memory all of the same size (the size
+ * class of the arena), carved from a single region reserved up front.
+ * That's exactly the shape of the frame buffers: many identical,
+ * long-lived, big buffers. A single region costs one mapping instead
+ * of one per buffer, and it can be backed by huge pages, which saves
+ * a lot of TLB misses when the buffers are walked row by row.
+ *
+ * Blocks are page aligned, like the ones given by tc_bufalloc().
+ * Memory is reserved, not touched: pages get committed by the OS only
+ * when the blocks are first written.
+ */
+
+typedef struct tcarena_ TCArena;
+
+typedef enum tcarenaflags_ TCArenaFlags;
+enum tcarenaflags_ {
+    TC_ARENA_HUGEPAGES = 1, /* try to use huge pages for the region */
+};
+
+/*
+ * tc_arena_new:
+ *     reserve a new arena.
+ *
+ * Parameters:
+ *     block_size: size of each block, in bytes. Will be rounded up
+ *                 to the page size.
+ *         blocks: number of blocks in the arena. Must be > 0.
+ *          flags: any combination of TCArenaFlags.
+ * Return Value:
+ *     pointer to the new arena on success, NULL on error.
+ */
+TCArena *tc_arena_new(size_t block_size, int blocks, int flags);
+
+/*
+ * tc_arena_del:
+ *     release an arena and all its memory. Blocks still in use
+ *     become invalid.
+ *
+ * Parameters:
+ *     arena: arena to release.
+ * Return Value:
+ *     None.
+ */
+void tc_arena_del(TCArena *arena);
+
+/*
+ * tc_arena_get (Thread safe):
+ *     take a block from an arena.
+ *
+ * Parameters:
+ *     arena: arena to use.
+ * Return Value:
+ *     pointer to a block of (at least) the arena block size,
+ *     NULL if the arena is exhausted.
+ */
+void *tc_arena_get(TCArena *arena);
+
+/*
+ * tc_arena_put (Thread safe):
+ *     give back a block to the arena it was taken from.
+ *
+ * Parameters:
+ *     arena: arena owning the block.
+ *       ptr: block obtained from tc_arena_get on the same arena.
+ * Return Value:
+ *     None.
+ */
+void tc_arena_put(TCArena *arena, void *ptr);
+
+/*
+ * tc_arena_size:
+ *     query the amount of memory reserved by an arena.
+ *
+ * Parameters:
+ *     arena: arena to query.
+ * Return Value:
+ *     reserved memory, in bytes.
+ */
+size_t tc_arena_size(const TCArena *arena);
+
+/*
+ * tc_arena_hugepages:
+ *     query if an arena is backed by huge pages.
+ *
+ * Parameters:
+ *     arena: arena to query.
+ * Return Value:
+ *     TC_TRUE if the region is (or was advised to be) backed by huge
+ *     pages, TC_FALSE otherwise.
+ */
+int tc_arena_hugepages(const TCArena *arena);
+
+#endif  /* TCARENA_H */
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,82 @@
+/*
+ * tcatomic.h -- minimal atomic operations for transcode.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TCATOMIC_H
+#define TCATOMIC_H
+
+#include "config.h"
+
+/*
+ * Quick Summary:
+ * thin wrappers around the compiler atomic builtins.
+ * Only the few operations needed by transcode are provided;
+ * all of them operate on naturally aligned int/long/pointer objects.
+ *
+ * Code using those helpers must check for TC_HAVE_ATOMICS and provide
+ * a lock-based fallback if it is not defined.
+ */
+
+#ifdef HAVE_GCC_ATOMIC_BUILTINS
+
+#define TC_HAVE_ATOMICS 1
+
+/* relaxed load/store: no ordering, only atomicity */
+#define tc_atomic_load_relaxed(P)       __atomic_load_n((P), __ATOMIC_RELAXED)
+#define tc_atomic_store_relaxed(P, V)   __atomic_store_n((P), (V), __ATOMIC_RELAXED)
+
+/* acquire load/release store: for publishing data between threads */
+#define tc_atomic_load(P)               __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define tc_atomic_store(P, V)           __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+
+/* read-modify-write operations, all sequentially consistent */
+#define tc_atomic_add(P, V)             __atomic_add_fetch((P), (V), __ATOMIC_SEQ_CST)
+#define tc_atomic_sub(P, V)             __atomic_sub_fetch((P), (V), __ATOMIC_SEQ_CST)
+#define tc_atomic_inc(P)                tc_atomic_add((P), 1)
+#define tc_atomic_dec(P)                tc_atomic_sub((P), 1)
+#define tc_atomic_exchange(P, V)        __atomic_exchange_n((P), (V), __ATOMIC_SEQ_CST)
+
+/*
+ * tc_atomic_cas: if *P == *E, store V into *P and return nonzero;
+ * otherwise store the current value of *P into *E and return zero.
+ */
+#define tc_atomic_cas(P, E, V) \
+    __atomic_compare_exchange_n((P), (E), (V), 0, \
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+/* full memory barrier */
+#define tc_atomic_fence()               __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/* one-way barriers, for pairing with relaxed accesses (seqlocks) */
+#define tc_atomic_fence_acquire()       __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define tc_atomic_fence_release()       __atomic_thread_fence(__ATOMIC_RELEASE)
+
+#endif /* HAVE_GCC_ATOMIC_BUILTINS */
+
+#endif /* TCATOMIC_H */
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
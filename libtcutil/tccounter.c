@@ -0,0 +1,367 @@
+/*
+ * tccounter.c -- sharded statistic counters for transcode.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+#include "memutils.h"
+#include "tcatomic.h"
+#include "tcthread.h"
+#include "tccounter.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+
+/*************************************************************************/
+
+enum {
+    TC_COUNTER_CACHELINE = 64,
+};
+
+/*
+ * Only the owner thread writes a shard, so the values need no atomic
+ * read-modify-write; `seq' makes it a seqlock for the readers: it is odd
+ * while an update is in progress, and changes at each update.
+ *
+ * A reset can't write the shards then: it bumps the generation of the
+ * set instead.  The values of a shard from an older generation count as
+ * zero, and its owner clears them, under the seqlock, on its next update.
+ */
+typedef struct tccountershard_ TCCounterShard;
+struct tccountershard_ {
+    char            pad[TC_COUNTER_CACHELINE];  /* from the previous one */
+    TCCounterShard  *next;
+    unsigned long   seq;
+    unsigned long   gen;    /* of the set, when the values were cleared */
+    int             owned;  /* by a live thread */
+    unsigned long   vals[1];    /* `num' of them, really */
+};
+
+struct tccounterset_ {
+    int             num;
+
+    TCMutex         lock;   /* for shard list changes */
+    TCCounterShard  *common;    /* shared: without atomics, or if a */
+                                /* thread can't have its own shard   */
+#ifdef TC_HAVE_ATOMICS
+    pthread_key_t   key;
+    TCCounterShard  *shards;    /* only grows, until the set goes away */
+    unsigned long   gen;        /* bumped by each reset */
+#endif
+};
+
+/*************************************************************************/
+
+static TCCounterShard *shard_new(int num)
+{
+    /* tail padding keeps the next allocation off our cache line */
+    return tc_zalloc(sizeof(TCCounterShard)
+                     + (num - 1) * sizeof(unsigned long)
+                     + TC_COUNTER_CACHELINE);
+}
+
+#ifdef TC_HAVE_ATOMICS
+
+/* last resort, when out of memory: the updates aren't paired anymore */
+static void add_common(TCCounterSet *set, int idx1, unsigned long val1,
+                       int idx2, unsigned long val2)
+{
+    tc_atomic_add(&set->common->vals[idx1], val1);
+    if (idx2 >= 0) {
+        tc_atomic_add(&set->common->vals[idx2], val2);
+    }
+}
+
+#define COMMON_GET(SET, IDX) \
+    tc_atomic_load_relaxed(&(SET)->common->vals[(IDX)])
+
+static void shard_release(void *datum)
+{
+    TCCounterShard *S = datum;
+
+    tc_atomic_store(&S->owned, 0);
+}
+
+/* the shard of the calling thread; NULL if it can't have one */
+static TCCounterShard *shard_get(TCCounterSet *set)
+{
+    TCCounterShard *S = pthread_getspecific(set->key);
+
+    if (S != NULL) {
+        return S;
+    }
+
+    tc_mutex_lock(&set->lock);
+    for (S = set->shards; S != NULL; S = S->next) {
+        if (!tc_atomic_load(&S->owned)) {
+            break; /* left by a thread gone */
+        }
+    }
+    if (S == NULL) {
+        S = shard_new(set->num);
+        if (S != NULL) {
+            S->next = set->shards;
+            tc_atomic_store(&set->shards, S);
+        }
+    }
+    if (S != NULL) {
+        tc_atomic_store(&S->owned, 1);
+    }
+    tc_mutex_unlock(&set->lock);
+
+    if (S != NULL && pthread_setspecific(set->key, S) != 0) {
+        shard_release(S);
+        S = NULL;
+    }
+    return S;
+}
+
+static void add_sharded(TCCounterSet *set, int idx1, unsigned long val1,
+                        int idx2, unsigned long val2)
+{
+    TCCounterShard *S = shard_get(set);
+    unsigned long seq = 0, gen = 0;
+    int i = 0;
+
+    if (S == NULL) {
+        add_common(set, idx1, val1, idx2, val2);
+        return;
+    }
+
+    seq = S->seq;
+    tc_atomic_store_relaxed(&S->seq, seq + 1);
+    tc_atomic_fence_release();
+    gen = tc_atomic_load(&set->gen);
+    if (S->gen != gen) {
+        for (i = 0; i < set->num; i++) {
+            tc_atomic_store_relaxed(&S->vals[i], 0);
+        }
+        tc_atomic_store_relaxed(&S->gen, gen);
+    }
+    tc_atomic_store_relaxed(&S->vals[idx1], S->vals[idx1] + val1);
+    if (idx2 >= 0) {
+        tc_atomic_store_relaxed(&S->vals[idx2], S->vals[idx2] + val2);
+    }
+    tc_atomic_store(&S->seq, seq + 2);
+}
+
+/* add a consistent copy of the values first..last-1 of a shard to
+ * `vals', which is indexed from `first' */
+static void shard_sum(TCCounterSet *set, TCCounterShard *S,
+                      int first, int last,
+                      unsigned long *vals, unsigned long *tmp)
+{
+    unsigned long seq0, seq1;
+    int i = 0, stale = 0;
+
+    for (;;) {
+        seq0 = tc_atomic_load(&S->seq);
+        if (seq0 & 1) {
+            sched_yield(); /* the owner is in the middle of an update */
+            continue;
+        }
+        stale = (tc_atomic_load_relaxed(&S->gen)
+                 != tc_atomic_load(&set->gen));
+        for (i = first; i < last; i++) {
+            tmp[i - first] = tc_atomic_load_relaxed(&S->vals[i]);
+        }
+        tc_atomic_fence_acquire();
+        seq1 = tc_atomic_load_relaxed(&S->seq);
+        if (seq0 == seq1) {
+            break;
+        }
+    }
+    if (!stale) { /* else reset since its last update */
+        for (i = first; i < last; i++) {
+            vals[i - first] += tmp[i - first];
+        }
+    }
+}
+
+#else /* !TC_HAVE_ATOMICS */
+
+static void add_common(TCCounterSet *set, int idx1, unsigned long val1,
+                       int idx2, unsigned long val2)
+{
+    tc_mutex_lock(&set->lock);
+    set->common->vals[idx1] += val1;
+    if (idx2 >= 0) {
+        set->common->vals[idx2] += val2;
+    }
+    tc_mutex_unlock(&set->lock);
+}
+
+#endif /* TC_HAVE_ATOMICS */
+
+/*************************************************************************/
+
+TCCounterSet *tc_counter_set_new(int num)
+{
+    TCCounterSet *set = NULL;
+
+    if (num <= 0) {
+        return NULL;
+    }
+    set = tc_zalloc(sizeof(TCCounterSet));
+    if (set == NULL) {
+        return NULL;
+    }
+    set->common = shard_new(num);
+    if (set->common == NULL) {
+        tc_free(set);
+        return NULL;
+    }
+#ifdef TC_HAVE_ATOMICS
+    if (pthread_key_create(&set->key, shard_release) != 0) {
+        tc_free(set->common);
+        tc_free(set);
+        return NULL;
+    }
+    set->shards = NULL;
+#endif
+    set->num = num;
+    tc_mutex_init(&set->lock);
+    return set;
+}
+
+void tc_counter_set_del(TCCounterSet *set)
+{
+    if (set != NULL) {
+#ifdef TC_HAVE_ATOMICS
+        TCCounterShard *S = set->shards, *next = NULL;
+
+        pthread_key_delete(set->key);
+        for (; S != NULL; S = next) {
+            next = S->next;
+            tc_free(S);
+        }
+#endif
+        tc_free(set->common);
+        tc_free(set);
+    }
+}
+
+void tc_counter_reset(TCCounterSet *set)
+{
+    int i = 0;
+
+    if (set == NULL) {
+        return;
+    }
+    tc_mutex_lock(&set->lock);
+#ifdef TC_HAVE_ATOMICS
+    /* the shards are left to their owners, see TCCounterShard */
+    for (i = 0; i < set->num; i++) {
+        tc_atomic_store(&set->common->vals[i], 0);
+    }
+    tc_atomic_inc(&set->gen);
+#else
+    for (i = 0; i < set->num; i++) {
+        set->common->vals[i] = 0;
+    }
+#endif
+    tc_mutex_unlock(&set->lock);
+}
+
+void tc_counter_add(TCCounterSet *set, int idx, unsigned long val)
+{
+    if (set == NULL) {
+        return;
+    }
+#ifdef TC_HAVE_ATOMICS
+    add_sharded(set, idx, val, -1, 0);
+#else
+    add_common(set, idx, val, -1, 0);
+#endif
+}
+
+void tc_counter_add2(TCCounterSet *set, int idx1, unsigned long val1,
+                     int idx2, unsigned long val2)
+{
+    if (set == NULL) {
+        return;
+    }
+#ifdef TC_HAVE_ATOMICS
+    add_sharded(set, idx1, val1, idx2, val2);
+#else
+    add_common(set, idx1, val1, idx2, val2);
+#endif
+}
+
+unsigned long tc_counter_get(TCCounterSet *set, int idx)
+{
+    unsigned long val = 0;
+
+    if (set == NULL) {
+        return 0;
+    }
+#ifdef TC_HAVE_ATOMICS
+    {
+        TCCounterShard *S = tc_atomic_load(&set->shards);
+        unsigned long tmp = 0;
+
+        val = COMMON_GET(set, idx);
+        for (; S != NULL; S = S->next) {
+            shard_sum(set, S, idx, idx + 1, &val, &tmp);
+        }
+    }
+#else
+    tc_mutex_lock(&set->lock);
+    val = set->common->vals[idx];
+    tc_mutex_unlock(&set->lock);
+#endif
+    return val;
+}
+
+void tc_counter_snapshot(TCCounterSet *set, unsigned long *vals)
+{
+    if (set == NULL || vals == NULL) {
+        return;
+    }
+#ifdef TC_HAVE_ATOMICS
+    {
+        unsigned long tmp[set->num];
+        TCCounterShard *S = tc_atomic_load(&set->shards);
+        int i = 0;
+
+        for (i = 0; i < set->num; i++) {
+            vals[i] = COMMON_GET(set, i);
+        }
+        for (; S != NULL; S = S->next) {
+            shard_sum(set, S, 0, set->num, vals, tmp);
+        }
+    }
+#else
+    tc_mutex_lock(&set->lock);
+    memcpy(vals, set->common->vals, set->num * sizeof(unsigned long));
+    tc_mutex_unlock(&set->lock);
+#endif
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
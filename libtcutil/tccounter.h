@@ -0,0 +1,132 @@
+/*
+ * tccounter.h -- sharded statistic counters for transcode.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TCCOUNTER_H
+#define TCCOUNTER_H
+
+/*
+ * Quick Summary:
+ * a set of counters which many threads can bump, each frame, without
+ * sharing a lock or even a cache line. Every thread updating a set gets
+ * its own shard of it, that is a private copy of all the counters of the
+ * set; readers add up the shards. Shards of threads gone are recycled
+ * by the next thread joining the set, so they never lose their counts.
+ *
+ * A snapshot of the whole set is consistent with the updates done by
+ * each thread: if a thread bumps two counters with tc_counter_add2, no
+ * snapshot will see only one of the two updates.
+ *
+ * Without atomics support from the compiler, the set falls back to a
+ * single, locked, shard.
+ */
+
+typedef struct tccounterset_ TCCounterSet;
+
+/*
+ * tc_counter_set_new:
+ *     create a new set of counters, all set to zero.
+ *
+ * Parameters:
+ *     num: number of counters in the set. Must be > 0.
+ * Return Value:
+ *     pointer to the new set on success, NULL on error.
+ */
+TCCounterSet *tc_counter_set_new(int num);
+
+/*
+ * tc_counter_set_del:
+ *     release a set of counters. No thread must use it anymore.
+ *
+ * Parameters:
+ *     set: set to release.
+ * Return Value:
+ *     None.
+ */
+void tc_counter_set_del(TCCounterSet *set);
+
+/*
+ * tc_counter_reset (Thread safe):
+ *     set all the counters of a set to zero. An update done meantime is
+ *     seen either before the reset or after it, but never in part.
+ *
+ * Parameters:
+ *     set: set to reset.
+ * Return Value:
+ *     None.
+ */
+void tc_counter_reset(TCCounterSet *set);
+
+/*
+ * tc_counter_add (Thread safe):
+ *     add a value to a counter of a set. Does nothing if the set is NULL.
+ *
+ * Parameters:
+ *     set: set to update.
+ *     idx: counter to update, in [0, num).
+ *     val: value to add.
+ * Return Value:
+ *     None.
+ */
+void tc_counter_add(TCCounterSet *set, int idx, unsigned long val);
+
+/*
+ * tc_counter_add2 (Thread safe):
+ *     as tc_counter_add, for two counters at once; snapshots see both
+ *     the updates or none.
+ */
+void tc_counter_add2(TCCounterSet *set, int idx1, unsigned long val1,
+                     int idx2, unsigned long val2);
+
+/*
+ * tc_counter_get (Thread safe):
+ *     read the current value of a counter of a set.
+ *
+ * Parameters:
+ *     set: set to read.
+ *     idx: counter to read, in [0, num).
+ * Return Value:
+ *     value of the counter, 0 if the set is NULL.
+ */
+unsigned long tc_counter_get(TCCounterSet *set, int idx);
+
+/*
+ * tc_counter_snapshot (Thread safe):
+ *     read all the counters of a set at once (see Quick Summary).
+ *
+ * Parameters:
+ *      set: set to read.
+ *     vals: array of `num' elements which receives the values.
+ *           Left untouched if the set is NULL.
+ * Return Value:
+ *     None.
+ */
+void tc_counter_snapshot(TCCounterSet *set, unsigned long *vals);
+
+#endif /* TCCOUNTER_H */
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
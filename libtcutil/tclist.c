@@ -350,7 +350,7 @@ int tc_list_insert_dup(TCList *L, int pos, void *data, size_t size)
     void *mem = tc_malloc(size);
     if (mem) {
         memcpy(mem, data, size);
-        ret = tc_list_insert(L, pos, data);
+        ret = tc_list_insert(L, pos, mem);
         if (ret == TC_ERROR) {
             tc_free(mem);
         }
@@ -0,0 +1,419 @@
+/*
+ * tctaskpool.c -- work-stealing task pool for transcode.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+#include "memutils.h"
+#include "logging.h"
+#include "strutils.h"
+#include "tcthread.h"
+#include "tctaskpool.h"
+
+#include <stdio.h>
+
+
+/*************************************************************************/
+
+enum {
+    TC_TASK_DEQUE_SIZE = 64, /* initial size, grows as needed */
+    TC_TASK_CACHELINE  = 64,
+};
+
+/*
+ * The deques are plain ring buffers guarded by a mutex each. Every
+ * task is a whole filter invocation on a whole frame, so the cost
+ * of an uncontended lock is lost in the noise; what matters is that
+ * the workers do not all fight for the same lock, and they do not,
+ * since each one normally touches only its own deque.
+ */
+typedef struct tctaskdeque_ TCTaskDeque;
+struct tctaskdeque_ {
+    TCMutex     lock;
+    void        **tasks;
+    int         size;   /* always a power of 2 */
+    int         head;   /* thieves take from here */
+    int         tail;   /* owner pushes and pops here */
+};
+
+typedef struct tctaskworker_ TCTaskWorker;
+struct tctaskworker_ {
+    TCThread    thread;
+    TCTaskPool  *pool;
+    int         index;
+    unsigned    seed;   /* for victim selection */
+    long        steals;
+    TCTaskDeque deque;
+    char        pad[TC_TASK_CACHELINE];
+};
+
+struct tctaskpool_ {
+    TCTaskWorker    *workers;
+    int             count;
+
+    TCTaskFn        run;
+    void            *userdata;
+
+    TCParker        parker;
+
+    TCMutex         lock;
+    TCCondition     idle;
+    volatile int    pending;    /* queued or running tasks */
+    int             next;       /* next deque for submit() */
+    volatile int    stopping;
+};
+
+/*************************************************************************/
+
+static int deque_init(TCTaskDeque *D)
+{
+    D->tasks = tc_malloc(TC_TASK_DEQUE_SIZE * sizeof(void*));
+    if (!D->tasks) {
+        return TC_ERROR;
+    }
+    D->size = TC_TASK_DEQUE_SIZE;
+    D->head = 0;
+    D->tail = 0;
+    tc_mutex_init(&D->lock);
+    return TC_OK;
+}
+
+/* must be called with the deque lock held */
+static int deque_grow(TCTaskDeque *D)
+{
+    void **tasks = tc_malloc(D->size * 2 * sizeof(void*));
+    int i = 0, n = D->tail - D->head;
+
+    if (!tasks) {
+        return TC_ERROR;
+    }
+    for (i = 0; i < n; i++) {
+        tasks[i] = D->tasks[(D->head + i) & (D->size - 1)];
+    }
+    tc_free(D->tasks);
+    D->tasks = tasks;
+    D->size *= 2;
+    D->head  = 0;
+    D->tail  = n;
+    return TC_OK;
+}
+
+static int deque_push(TCTaskDeque *D, void *task)
+{
+    int ret = TC_OK;
+
+    tc_mutex_lock(&D->lock);
+    if (D->tail - D->head >= D->size) {
+        ret = deque_grow(D);
+    }
+    if (ret == TC_OK) {
+        D->tasks[D->tail & (D->size - 1)] = task;
+        D->tail++;
+    }
+    tc_mutex_unlock(&D->lock);
+    return ret;
+}
+
+static void *deque_pop(TCTaskDeque *D)
+{
+    void *task = NULL;
+
+    tc_mutex_lock(&D->lock);
+    if (D->tail > D->head) {
+        D->tail--;
+        task = D->tasks[D->tail & (D->size - 1)];
+    }
+    tc_mutex_unlock(&D->lock);
+    return task;
+}
+
+static void *deque_steal(TCTaskDeque *D)
+{
+    void *task = NULL;
+
+    tc_mutex_lock(&D->lock);
+    if (D->tail > D->head) {
+        task = D->tasks[D->head & (D->size - 1)];
+        D->head++;
+    }
+    tc_mutex_unlock(&D->lock);
+    return task;
+}
+
+/*************************************************************************/
+
+/*
+ * The pending counter is touched twice per task, by every worker:
+ * keep it off the pool lock when we can. The lock is still taken
+ * when the counter drops to zero, so tc_task_pool_wait can't miss
+ * the wakeup.
+ */
+#ifdef TC_HAVE_ATOMICS
+
+static int pending_add(TCTaskPool *pool, int n)
+{
+    return tc_atomic_add(&pool->pending, n);
+}
+
+static int pending_get(TCTaskPool *pool)
+{
+    return tc_atomic_load(&pool->pending);
+}
+
+#else /* !TC_HAVE_ATOMICS */
+
+static int pending_add(TCTaskPool *pool, int n)
+{
+    int ret;
+    tc_mutex_lock(&pool->lock);
+    pool->pending += n;
+    ret = pool->pending;
+    tc_mutex_unlock(&pool->lock);
+    return ret;
+}
+
+/* caller holds the lock */
+static int pending_get(TCTaskPool *pool)
+{
+    return pool->pending;
+}
+
+#endif /* TC_HAVE_ATOMICS */
+
+static void pool_task_done(TCTaskPool *pool)
+{
+    if (pending_add(pool, -1) == 0) {
+        tc_mutex_lock(&pool->lock);
+        tc_condition_broadcast(&pool->idle);
+        tc_mutex_unlock(&pool->lock);
+    }
+}
+
+/* push a task on a given deque and wake up someone to run it */
+static int pool_push(TCTaskPool *pool, int index, void *task)
+{
+    int ret;
+
+    pending_add(pool, 1);
+    ret = deque_push(&pool->workers[index].deque, task);
+    if (ret == TC_OK) {
+        tc_parker_unpark(&pool->parker, TC_FALSE);
+    } else {
+        pool_task_done(pool);
+    }
+    return ret;
+}
+
+/* own deque first, then try to steal from a random victim onwards */
+static void *worker_take(TCTaskWorker *W)
+{
+    TCTaskPool *pool = W->pool;
+    void *task = deque_pop(&W->deque);
+    int i = 0, victim = 0;
+
+    if (task || pool->count == 1) {
+        return task;
+    }
+
+    W->seed = W->seed * 1103515245 + 12345;
+    victim = (W->seed >> 16) % pool->count;
+
+    for (i = 0; i < pool->count && !task; i++) {
+        int j = (victim + i) % pool->count;
+        if (j != W->index) {
+            task = deque_steal(&pool->workers[j].deque);
+        }
+    }
+    if (task) {
+        W->steals++;
+    }
+    return task;
+}
+
+static int task_worker(TCThreadData *td, void *arg)
+{
+    TCTaskWorker *W = arg;
+    TCTaskPool *pool = W->pool;
+    void *task = NULL;
+    int ticket = 0;
+
+    for (;;) {
+        task = worker_take(W);
+        if (!task) {
+            ticket = tc_parker_prepare(&pool->parker);
+            task = worker_take(W);
+            if (task) {
+                tc_parker_cancel(&pool->parker);
+            } else if (pool->stopping) {
+                tc_parker_cancel(&pool->parker);
+                break;
+            } else {
+                tc_parker_park(&pool->parker, ticket);
+                continue;
+            }
+        }
+        pool->run(task, W->index, pool->userdata);
+        pool_task_done(pool);
+    }
+    return 0;
+}
+
+/*************************************************************************/
+
+TCTaskPool *tc_task_pool_new(int workers, TCTaskFn run, void *userdata,
+                             const char *name)
+{
+    TCTaskPool *pool = NULL;
+    int i = 0;
+
+    if (workers <= 0 || !run) {
+        return NULL;
+    }
+
+    pool = tc_zalloc(sizeof(TCTaskPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->workers = tc_zalloc(workers * sizeof(TCTaskWorker));
+    if (!pool->workers) {
+        tc_free(pool);
+        return NULL;
+    }
+    pool->count    = workers;
+    pool->run      = run;
+    pool->userdata = userdata;
+
+    tc_parker_init(&pool->parker);
+    tc_mutex_init(&pool->lock);
+    tc_condition_init(&pool->idle);
+
+    for (i = 0; i < workers; i++) {
+        TCTaskWorker *W = &pool->workers[i];
+        if (deque_init(&W->deque) != TC_OK) {
+            break;
+        }
+        W->pool  = pool;
+        W->index = i;
+        W->seed  = i + 1;
+    }
+    if (i < workers) {
+        while (i-- > 0) {
+            tc_free(pool->workers[i].deque.tasks);
+        }
+        tc_free(pool->workers);
+        tc_free(pool);
+        return NULL;
+    }
+
+    for (i = 0; i < workers; i++) {
+        char thname[TC_THREAD_NAME_LEN];
+        tc_snprintf(thname, sizeof(thname), "%s%i",
+                    (name) ?name :"task", i);
+        tc_thread_init(&pool->workers[i].thread, thname);
+        tc_thread_start(&pool->workers[i].thread,
+                        task_worker, &pool->workers[i]);
+    }
+    return pool;
+}
+
+int tc_task_pool_del(TCTaskPool *pool)
+{
+    int i = 0;
+
+    if (!pool) {
+        return TC_ERROR;
+    }
+
+    tc_mutex_lock(&pool->lock);
+    pool->stopping = TC_TRUE;
+    tc_mutex_unlock(&pool->lock);
+    tc_parker_unpark(&pool->parker, TC_TRUE);
+
+    for (i = 0; i < pool->count; i++) {
+        tc_thread_wait(&pool->workers[i].thread, NULL);
+    }
+    for (i = 0; i < pool->count; i++) {
+        tc_free(pool->workers[i].deque.tasks);
+    }
+    tc_free(pool->workers);
+    tc_free(pool);
+    return TC_OK;
+}
+
+int tc_task_pool_submit(TCTaskPool *pool, void *task)
+{
+    int index = 0;
+
+    if (!pool || !task) {
+        return TC_ERROR;
+    }
+    tc_mutex_lock(&pool->lock);
+    index = pool->next;
+    pool->next = (pool->next + 1) % pool->count;
+    tc_mutex_unlock(&pool->lock);
+
+    return pool_push(pool, index, task);
+}
+
+int tc_task_pool_spawn(TCTaskPool *pool, int worker, void *task)
+{
+    if (!pool || !task || worker < 0 || worker >= pool->count) {
+        return TC_ERROR;
+    }
+    return pool_push(pool, worker, task);
+}
+
+void tc_task_pool_wait(TCTaskPool *pool)
+{
+    if (pool) {
+        tc_mutex_lock(&pool->lock);
+        while (pending_get(pool) > 0) {
+            tc_condition_wait(&pool->idle, &pool->lock);
+        }
+        tc_mutex_unlock(&pool->lock);
+    }
+}
+
+int tc_task_pool_workers(const TCTaskPool *pool)
+{
+    return (pool) ?pool->count :0;
+}
+
+long tc_task_pool_steals(TCTaskPool *pool)
+{
+    long steals = 0;
+    int i = 0;
+
+    if (pool) {
+        for (i = 0; i < pool->count; i++) {
+            steals += pool->workers[i].steals;
+        }
+    }
+    return steals;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,154 @@
+/*
+ * tctaskpool.h -- work-stealing task pool for transcode.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TCTASKPOOL_H
+#define TCTASKPOOL_H
+
+/*
+ * Quick Summary:
+ * a fixed set of worker threads, each one owning a double ended task
+ * queue (deque). A worker pops tasks from the bottom of its own deque
+ * (most recently pushed first, so a chain of dependent tasks stays
+ * on the same core), and when it runs dry it steals from the top of
+ * the deques of the other workers (oldest first). Workers with nothing
+ * to do sleep on a TCParker.
+ *
+ * Tasks are opaque pointers; the pool calls a single, pool-wide
+ * function to run each one of them. The pool never allocates or
+ * releases tasks by itself.
+ */
+
+typedef struct tctaskpool_ TCTaskPool;
+
+/*
+ * TCTaskFn:
+ *     typedef for the task execution function.
+ *
+ * Parameters:
+ *         task: the task to run, as given to submit/spawn.
+ *       worker: index of the worker running the task, in [0, workers).
+ *               Can be used with tc_task_pool_spawn.
+ *     userdata: the opaque pointer given to tc_task_pool_new.
+ * Return Value:
+ *     None.
+ */
+typedef void (*TCTaskFn)(void *task, int worker, void *userdata);
+
+/*
+ * tc_task_pool_new:
+ *     create a new task pool and start its worker threads.
+ *
+ * Parameters:
+ *      workers: number of worker threads. Must be > 0.
+ *          run: task execution function.
+ *     userdata: opaque pointer passed to `run' on each invocation.
+ *         name: prefix for worker thread names.
+ * Return Value:
+ *     pointer to the new pool on success, NULL on error.
+ */
+TCTaskPool *tc_task_pool_new(int workers, TCTaskFn run, void *userdata,
+                             const char *name);
+
+/*
+ * tc_task_pool_del:
+ *     stop a task pool and release all its resources.
+ *     Tasks already queued are run before the workers exit.
+ *     This is a blocking function.
+ *
+ * Parameters:
+ *     pool: task pool to destroy.
+ * Return Value:
+ *     TC_OK on success, TC_ERROR on error.
+ */
+int tc_task_pool_del(TCTaskPool *pool);
+
+/*
+ * tc_task_pool_submit (Thread safe):
+ *     queue a task from outside the pool. Successive submissions are
+ *     striped across the worker deques.
+ *
+ * Parameters:
+ *     pool: task pool to use.
+ *     task: opaque task pointer.
+ * Return Value:
+ *     TC_OK on success, TC_ERROR on error.
+ */
+int tc_task_pool_submit(TCTaskPool *pool, void *task);
+
+/*
+ * tc_task_pool_spawn (Thread safe):
+ *     queue a task on the deque owned by the given worker.
+ *     Meant to be used from inside a task to queue a follow-up task:
+ *     it will very likely run on the same worker.
+ *
+ * Parameters:
+ *       pool: task pool to use.
+ *     worker: deque to use, usually the one given to the running task.
+ *       task: opaque task pointer.
+ * Return Value:
+ *     TC_OK on success, TC_ERROR on error.
+ */
+int tc_task_pool_spawn(TCTaskPool *pool, int worker, void *task);
+
+/*
+ * tc_task_pool_wait (Thread safe):
+ *     wait until every task queued so far, including the ones spawned
+ *     while waiting, has been run. Must not be called from a task.
+ *
+ * Parameters:
+ *     pool: task pool to wait for.
+ * Return Value:
+ *     None.
+ */
+void tc_task_pool_wait(TCTaskPool *pool);
+
+/*
+ * tc_task_pool_workers:
+ *     query the number of worker threads of a pool.
+ *
+ * Parameters:
+ *     pool: task pool to query.
+ * Return Value:
+ *     number of workers.
+ */
+int tc_task_pool_workers(const TCTaskPool *pool);
+
+/*
+ * tc_task_pool_steals (Thread safe):
+ *     query how many tasks were stolen so far; for statistics only.
+ *
+ * Parameters:
+ *     pool: task pool to query.
+ * Return Value:
+ *     number of succesfull steals.
+ */
+long tc_task_pool_steals(TCTaskPool *pool);
+
+#endif /* TCTASKPOOL_H */
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -23,6 +23,14 @@
 #include "logging.h"
 #include "tcthread.h"
 
+#include <limits.h>
+
+#ifdef TC_PARKER_FUTEX
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
 
 
 /*************************************************************************/
@@ -135,6 +143,115 @@ int tc_condition_broadcast(TCCondition *c)
 
 /*************************************************************************/
 
+/*
+ * The parker protocol relies on the `seq' and `waiters' fields being
+ * accessed with sequentially consistent operations: either the waker
+ * sees the waiter announced, or the waiter sees the bumped sequence.
+ * Without atomics we just do everything under the lock.
+ */
+
+#ifdef TC_PARKER_FUTEX
+
+static void tc_futex_wait(volatile int *addr, int val)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static void tc_futex_wake(volatile int *addr, int num)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, num, NULL, NULL, 0);
+}
+
+int tc_parker_init(TCParker *P)
+{
+    P->seq     = 0;
+    P->waiters = 0;
+    return TC_OK;
+}
+
+int tc_parker_prepare(TCParker *P)
+{
+    tc_atomic_inc(&P->waiters);
+    return tc_atomic_add(&P->seq, 0);
+}
+
+void tc_parker_cancel(TCParker *P)
+{
+    tc_atomic_dec(&P->waiters);
+}
+
+void tc_parker_park(TCParker *P, int ticket)
+{
+    if (tc_atomic_load(&P->seq) == ticket) {
+        tc_futex_wait(&P->seq, ticket);
+    }
+    tc_atomic_dec(&P->waiters);
+}
+
+void tc_parker_unpark(TCParker *P, int broadcast)
+{
+    tc_atomic_inc(&P->seq);
+    if (tc_atomic_add(&P->waiters, 0) > 0) {
+        tc_futex_wake(&P->seq, (broadcast) ?INT_MAX :1);
+    }
+}
+
+#else /* !TC_PARKER_FUTEX */
+
+int tc_parker_init(TCParker *P)
+{
+    P->seq     = 0;
+    P->waiters = 0;
+    pthread_mutex_init(&P->lock, NULL);
+    pthread_cond_init(&P->cond, NULL);
+    return TC_OK;
+}
+
+int tc_parker_prepare(TCParker *P)
+{
+    int ticket;
+    pthread_mutex_lock(&P->lock);
+    P->waiters++;
+    ticket = P->seq;
+    pthread_mutex_unlock(&P->lock);
+    return ticket;
+}
+
+void tc_parker_cancel(TCParker *P)
+{
+    pthread_mutex_lock(&P->lock);
+    P->waiters--;
+    pthread_mutex_unlock(&P->lock);
+}
+
+void tc_parker_park(TCParker *P, int ticket)
+{
+    pthread_mutex_lock(&P->lock);
+    while (P->seq == ticket) {
+        pthread_cond_wait(&P->cond, &P->lock);
+    }
+    P->waiters--;
+    pthread_mutex_unlock(&P->lock);
+}
+
+void tc_parker_unpark(TCParker *P, int broadcast)
+{
+    pthread_mutex_lock(&P->lock);
+    P->seq++;
+    if (P->waiters > 0) {
+        if (broadcast) {
+            pthread_cond_broadcast(&P->cond);
+        } else {
+            pthread_cond_signal(&P->cond);
+        }
+    }
+    pthread_mutex_unlock(&P->lock);
+}
+
+#endif /* TC_PARKER_FUTEX */
+
+/*************************************************************************/
+
 /*
  * Local variables:
  *   c-file-style: "stroustrup"
@@ -27,6 +27,13 @@
 #include <pthread.h>
 #include <stdint.h>
 
+#include "tcatomic.h"
+
+#if defined(TC_HAVE_ATOMICS) \
+ && defined(HAVE_LINUX_FUTEX_H) && defined(HAVE_SYS_SYSCALL_H)
+# define TC_PARKER_FUTEX 1
+#endif
+
 
 /*
  * Quick Summary:
@@ -56,6 +63,22 @@ struct tccondition_ {
     pthread_cond_t c;
 };
 
+/*
+ * TCParker: lightweight primitive to put a thread to sleep until some
+ * other thread signals progress. It is meant to be paired with lock-free
+ * data structures: the fast path never touches any lock, threads only
+ * sleep (on a futex, where available) when there is nothing to do.
+ */
+typedef struct tcparker_ TCParker;
+struct tcparker_ {
+    volatile int    seq;     /* bumped on every unpark */
+    volatile int    waiters; /* how many threads are (going to) park */
+#ifndef TC_PARKER_FUTEX
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+#endif
+};
+
 typedef struct tcthread_ TCThread;
 struct tcthread_ {
     pthread_t       tid;
@@ -87,6 +110,27 @@ int tc_condition_wait(TCCondition *c, TCMutex *m);
 int tc_condition_signal(TCCondition *c);
 int tc_condition_broadcast(TCCondition *c);
 
+/*
+ * TCParker usage:
+ *
+ *     ticket = tc_parker_prepare(P);
+ *     if (<condition already satisfied>) {
+ *         tc_parker_cancel(P);
+ *     } else {
+ *         tc_parker_park(P, ticket);
+ *     }
+ *
+ * tc_parker_park returns as soon as any tc_parker_unpark happened
+ * after tc_parker_prepare, so no wakeup can be lost between the check
+ * and the sleep. Spurious wakeups are possible: always recheck.
+ * All functions are thread safe.
+ */
+int tc_parker_init(TCParker *P);
+int tc_parker_prepare(TCParker *P);
+void tc_parker_cancel(TCParker *P);
+void tc_parker_park(TCParker *P, int ticket);
+void tc_parker_unpark(TCParker *P, int broadcast);
+
 
 
 #endif /* TCTHREAD_H */
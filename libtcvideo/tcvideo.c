@@ -18,6 +18,8 @@
 #include "tccore/frame.h"
 #include "tccore/job.h"
 #include "libtc/libtc.h"
+#include "libtcutil/tcthread.h"
+#include "libtcutil/tctaskpool.h"
 #include "aclib/ac.h"
 #undef zoom
 #include <math.h>
@@ -45,15 +47,28 @@ struct resize_table_elem {
 /* Maximum number of ZoomInfo structures to cache. */
 #define ZOOMINFO_CACHE_SIZE 10
 
+/* Minimum number of rows in a band for threaded zooming. */
+#define ZOOM_BAND_MIN_ROWS 16
+
+/* A band of rows for threaded zooming. */
+struct zoom_band {
+    const ZoomInfo *zi;
+    const uint8_t *src;
+    uint8_t *dest;
+    int first, last;
+    int ok;
+};
+
 
 /* Internal data structure to hold various state information.  The
  * TCVHandle returned by tcv_init() and passed by the caller to other
  * functions is a pointer to this structure. */
 
 struct tcvhandle_ {
-    /* Various lookup tables */
-    struct resize_table_elem resize_table_x[TC_MAX_V_FRAME_WIDTH/8];
-    struct resize_table_elem resize_table_y[TC_MAX_V_FRAME_HEIGHT/8];
+    /* Various lookup tables; the resize ones grow with the frame size */
+    struct resize_table_elem *resize_table_x;
+    struct resize_table_elem *resize_table_y;
+    int resize_table_x_size, resize_table_y_size;
     uint8_t gamma_table[256];
     uint32_t aa_table_c[256];
     uint32_t aa_table_x[256];
@@ -70,7 +85,10 @@ struct tcvhandle_ {
         TCVZoomFilter filter;
         ZoomInfo *zi;
     } zoominfo_cache[ZOOMINFO_CACHE_SIZE];
-    /* Buffer and buffer size for tcv_convert() */
+    TCMutex zoominfo_lock;  /* the cache may be shared by many threads */
+    /* Worker threads for tcv_zoom() (NULL: zoom in the calling thread) */
+    TCTaskPool *zoom_pool;
+    /* Buffer and buffer size for tcv_convert() and tcv_flip_v() */
     uint8_t *convert_buffer;
     uint32_t convert_buffer_size;
 };
@@ -79,10 +97,16 @@ struct tcvhandle_ {
 
 /* Internal-use functions (defined at the bottom of the file). */
 
-static void init_resize_tables(TCVHandle handle,
-                               int oldw, int neww, int oldh, int newh);
+static int init_resize_tables(TCVHandle handle,
+                              int oldw, int neww, int oldh, int newh);
 static void init_one_resize_table(struct resize_table_elem *table,
                                   int oldsize, int newsize);
+static uint8_t *get_convert_buffer(TCVHandle handle, uint32_t size);
+static int zoom_filter_ok(TCVZoomFilter filter);
+static int zoom_plane(TCVHandle handle, uint8_t *src, uint8_t *dest,
+                      int width, int height, int Bpp, int new_w, int new_h,
+                      int interlace_mode, TCVZoomFilter filter);
+static void zoom_band_run(void *task, int worker, void *userdata);
 static void init_gamma_table(TCVHandle handle, double gamma);
 static void init_aa_table(TCVHandle handle, double aa_weight, double aa_bias);
 
@@ -116,12 +140,51 @@ TCVHandle tcv_init(void)
     handle = tc_zalloc(sizeof(*handle));
     if (handle) {
         handle->saved_weight = handle->saved_bias = -1.0;
+        tc_mutex_init(&handle->zoominfo_lock);
     }
     return handle;
 }
 
 /*************************************************************************/
 
+/**
+ * tcv_set_threads:  Set the number of threads used by tcv_zoom() and
+ * tcv_zoom_yuv() with the given handle.  With more than one thread, each
+ * image is split into bands of rows which are resized in parallel by a
+ * pool of worker threads owned by the handle, while the caller waits.
+ * The handle may then be used by several threads at the same time for
+ * zooming.
+ *
+ * Parameters:  handle: tcvideo handle.
+ *             threads: Number of threads; 0 or 1 means zooming in the
+ *                      calling thread (the default).
+ * Return value: Nonzero on success, zero on error (the handle then zooms
+ *               in the calling thread).
+ * Preconditions: handle != 0: handle was returned by tcv_init()
+ *                no other thread is using the handle
+ * Postconditions: None.
+ */
+
+int tcv_set_threads(TCVHandle handle, int threads)
+{
+    if (handle->zoom_pool) {
+        tc_task_pool_del(handle->zoom_pool);
+        handle->zoom_pool = NULL;
+    }
+    if (threads > 1) {
+        handle->zoom_pool = tc_task_pool_new(threads, zoom_band_run, NULL,
+                                             "tcvzoom");
+        if (!handle->zoom_pool) {
+            tc_log_error("libtcvideo", "tcv_set_threads: can't start"
+                         " %d threads!", threads);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*************************************************************************/
+
 /**
  * tcv_free:  Free resources allocated for the given handle.  Does nothing
  * if handle is zero.
@@ -136,11 +199,15 @@ void tcv_free(TCVHandle handle)
 {
     if (handle) {
         int i;
+        if (handle->zoom_pool)
+            tc_task_pool_del(handle->zoom_pool);
         for (i = 0; i < ZOOMINFO_CACHE_SIZE; i++) {
             if (handle->zoominfo_cache[i].zi)
                 zoom_free(handle->zoominfo_cache[i].zi);
         }
         free(handle->convert_buffer);
+        free(handle->resize_table_x);
+        free(handle->resize_table_y);
         free(handle);
     }
 }
@@ -461,7 +528,9 @@ int tcv_resize(TCVHandle handle,
         int Bpl = width * Bpp;  /* bytes per line */
         int i, y;
 
-        init_resize_tables(handle, 0, 0, height*8/scale_h, new_h*8/scale_h);
+        if (!init_resize_tables(handle, 0, 0,
+                                height*8/scale_h, new_h*8/scale_h))
+            return 0;
         for (i = 0; i < scale_h; i++) {
             uint8_t *sptr = src  + (i * (height/scale_h)) * Bpl;
             uint8_t *dptr = dest + (i * (new_h /scale_h)) * Bpl;
@@ -481,7 +550,9 @@ int tcv_resize(TCVHandle handle,
     if (resize_w) {
         int i, x;
 
-        init_resize_tables(handle, width*8/scale_w, new_w*8/scale_w, 0, 0);
+        if (!init_resize_tables(handle, width*8/scale_w, new_w*8/scale_w,
+                                0, 0))
+            return 0;
         /* Treat the image as an array of blocks */
         for (i = 0; i < new_h * scale_w; i++) {
             /* This `if' is an optimization hint to the compiler, to
@@ -559,10 +630,7 @@ int tcv_zoom(TCVHandle handle,
              uint8_t *src, uint8_t *dest, int width, int height, int Bpp,
              int new_w, int new_h, TCVZoomFilter filter)
 {
-    ZoomInfo *zi;
-    int free_zi = 0;  // Should the ZoomInfo be freed after use?
     int interlace_mode = 0;
-    int i;
 
     if (!src || !dest || width <= 0 || height <= 0 || (Bpp != 1 && Bpp != 3)) {
         tc_log_error("libtcvideo", "tcv_zoom: invalid frame parameters!");
@@ -583,72 +651,99 @@ int tcv_zoom(TCVHandle handle,
                      new_w, new_h);
         return 0;
     }
-    switch (filter) {
-      case TCV_ZOOM_BOX:
-      case TCV_ZOOM_TRIANGLE:
-      case TCV_ZOOM_HERMITE:
-      case TCV_ZOOM_BELL:
-      case TCV_ZOOM_B_SPLINE:
-      case TCV_ZOOM_MITCHELL:
-      case TCV_ZOOM_LANCZOS3:
-        break;
-      default:
+    if (!zoom_filter_ok(filter)) {
         tc_log_error("libtcvideo", "tcv_zoom: invalid filter %d!", filter);
         return 0;
     }
 
-    for (i = 0, zi = NULL; i < ZOOMINFO_CACHE_SIZE && zi == NULL; i++) {
-        if (handle->zoominfo_cache[i].zi     != NULL
-         && handle->zoominfo_cache[i].old_w  == width
-         && handle->zoominfo_cache[i].old_h  == height
-         && handle->zoominfo_cache[i].new_w  == new_w
-         && handle->zoominfo_cache[i].new_h  == new_h
-         && handle->zoominfo_cache[i].Bpp    == Bpp
-         && handle->zoominfo_cache[i].ilace  == interlace_mode
-         && handle->zoominfo_cache[i].filter == filter
-        ) {
-            zi = handle->zoominfo_cache[i].zi;
-        }
+    return zoom_plane(handle, src, dest, width, height, Bpp, new_w, new_h,
+                      interlace_mode, filter);
+}
+
+/*************************************************************************/
+
+/**
+ * tcv_zoom_yuv:  Resize the given planar YUV image to an arbitrary size,
+ * with filtering.  This is equivalent to calling tcv_zoom() on each
+ * plane, but with a single call per frame.
+ *
+ * Parameters: handle: tcvideo handle.
+ *                src: Source image (planes stored consecutively).
+ *               dest: Destination image (planes stored consecutively).
+ *              width: Width of frame.
+ *             height: Height of frame.
+ *                fmt: Image format (IMG_YUV420P, IMG_YV12, IMG_YUV411P,
+ *                     IMG_YUV422P, or IMG_YUV444P).
+ *              new_w: New frame width.
+ *              new_h: New frame height.  If negative, the Y plane is
+ *                     processed in an interlaced mode as for tcv_zoom(),
+ *                     while the U and V planes, which are shared between
+ *                     both fields, are zoomed normally.
+ *             filter: Filter type (TCV_ZOOM_*).
+ * Return value: Nonzero on success, zero on error (invalid parameters).
+ * Preconditions: handle != 0: handle was returned by tcv_init()
+ *                src != NULL: the whole source image is readable
+ *                dest != NULL: the whole destination image is writable
+ *                src != dest: src and dest do not overlap
+ * Postconditions: (on success) the destination image is set
+ */
+
+int tcv_zoom_yuv(TCVHandle handle,
+                 uint8_t *src, uint8_t *dest, int width, int height,
+                 ImageFormat fmt, int new_w, int new_h, TCVZoomFilter filter)
+{
+    int xdiv, ydiv, interlace_mode = 0;
+    int cw, ch, new_cw, new_ch;
+
+    switch (fmt) {
+      case IMG_YUV420P:
+      case IMG_YV12:    xdiv = 2; ydiv = 2; break;
+      case IMG_YUV411P: xdiv = 4; ydiv = 1; break;
+      case IMG_YUV422P: xdiv = 2; ydiv = 1; break;
+      case IMG_YUV444P: xdiv = 1; ydiv = 1; break;
+      default:
+        tc_log_error("libtcvideo", "tcv_zoom_yuv: invalid format %d!", fmt);
+        return 0;
     }
-    if (!zi) {
-        int ilace_height = height;
-        int ilace_new_h = new_h;
-        int old_stride = width * Bpp;
-        int new_stride = new_w * Bpp;
-        if (interlace_mode) {
-            ilace_height /= 2;
-            ilace_new_h /= 2;
-            old_stride *= 2;
-            new_stride *= 2;
-        }
-        zi = zoom_init(width, ilace_height, new_w, ilace_new_h, Bpp,
-                       old_stride, new_stride, filter);
-        if (!zi) {
-            tc_log_error("libtcvideo", "tcv_zoom: zoom_init() failed!");
+    if (new_h < 0) {
+        new_h = -new_h;
+        interlace_mode = 1;
+        if (height % 2 != 0 || new_h % 2 != 0) {
+            tc_log_error("libtcvideo", "tcv_zoom_yuv: heights must be even"
+                         " in interlace mode (old height %d, new height %d)",
+                         height, new_h);
             return 0;
         }
-        free_zi = 1;
-        for (i = 0; i < ZOOMINFO_CACHE_SIZE; i++) {
-            if (!handle->zoominfo_cache[i].zi) {
-                handle->zoominfo_cache[i].zi     = zi;
-                handle->zoominfo_cache[i].old_w  = width;
-                handle->zoominfo_cache[i].old_h  = height;
-                handle->zoominfo_cache[i].new_w  = new_w;
-                handle->zoominfo_cache[i].new_h  = new_h;
-                handle->zoominfo_cache[i].Bpp    = Bpp;
-                handle->zoominfo_cache[i].ilace  = interlace_mode;
-                handle->zoominfo_cache[i].filter = filter;
-                free_zi = 0;
-                break;
-            }
-        }
     }
-    zoom_process(zi, src, dest);
-    if (interlace_mode)
-        zoom_process(zi, src + width*Bpp, dest + new_w*Bpp);
-    if (free_zi)
-        zoom_free(zi);
-    return 1;
+    cw = width / xdiv;
+    ch = height / ydiv;
+    new_cw = new_w / xdiv;
+    new_ch = new_h / ydiv;
+    if (!src || !dest || cw <= 0 || ch <= 0) {
+        tc_log_error("libtcvideo", "tcv_zoom_yuv: invalid frame parameters!");
+        return 0;
+    }
+    if (new_cw <= 0 || new_ch <= 0) {
+        tc_log_error("libtcvideo", "tcv_zoom_yuv: invalid target size %dx%d!",
+                     new_w, new_h);
+        return 0;
+    }
+    if (!zoom_filter_ok(filter)) {
+        tc_log_error("libtcvideo", "tcv_zoom_yuv: invalid filter %d!",
+                     filter);
+        return 0;
+    }
+
+    if (!zoom_plane(handle, src, dest, width, height, 1, new_w, new_h,
+                    interlace_mode, filter))
+        return 0;
+    src += width * height;
+    dest += new_w * new_h;
+    if (!zoom_plane(handle, src, dest, cw, ch, 1, new_cw, new_ch, 0, filter))
+        return 0;
+    src += cw * ch;
+    dest += new_cw * new_ch;
+    return zoom_plane(handle, src, dest, cw, ch, 1, new_cw, new_ch, 0, filter);
 }
 
 /*************************************************************************/
@@ -741,7 +836,7 @@ int tcv_flip_v(TCVHandle handle,
 {
     int Bpl = width * Bpp;  /* bytes per line */
     int y;
-    uint8_t buf[TC_MAX_V_FRAME_WIDTH * TC_MAX_V_BYTESPP];
+    uint8_t *buf;
 
     if (!src || !dest || width <= 0 || height <= 0 || (Bpp != 1 && Bpp != 3)) {
         tc_log_error("libtcvideo", "tcv_flip_v: invalid frame parameters!");
@@ -755,6 +850,9 @@ int tcv_flip_v(TCVHandle handle,
             ac_memcpy(dest + ((height-1)-y)*Bpl, src + y*Bpl, Bpl);
         }
     } else {
+        buf = get_convert_buffer(handle, Bpl);
+        if (!buf)
+            return 0;
         for (y = 0; y < (height+1)/2; y++) {
             ac_memcpy(buf, src + y*Bpl, Bpl);
             ac_memcpy(dest + y*Bpl, src + ((height-1)-y)*Bpl, Bpl);
@@ -1042,15 +1140,10 @@ int tcv_convert(TCVHandle handle, uint8_t *src, uint8_t *dest, int width,
     }
 
     if (src == dest) {
-        /* In-place conversion, so allocate a properly-sized buffer */
-        if (!handle->convert_buffer || handle->convert_buffer_size < size) {
-            free(handle->convert_buffer);
-            handle->convert_buffer = tc_malloc(size);
-            if (!handle->convert_buffer)
-                return 0;
-            handle->convert_buffer_size = size;
-        }
-        realdest = handle->convert_buffer;
+        /* In-place conversion, so use a properly-sized buffer */
+        realdest = get_convert_buffer(handle, size);
+        if (!realdest)
+            return 0;
     } else {
         realdest = dest;
     }
@@ -1087,7 +1180,7 @@ int tcv_convert(TCVHandle handle, uint8_t *src, uint8_t *dest, int width,
  *               neww: New image width.
  *               oldh: Original image height.
  *               newh: New image height.
- * Return value: None.
+ * Return value: Nonzero on success, zero on error (out of memory).
  * Preconditions: handle != 0
  *                oldw % 8 == 0
  *                neww % 8 == 0
@@ -1099,12 +1192,21 @@ int tcv_convert(TCVHandle handle, uint8_t *src, uint8_t *dest, int width,
  *                     resize_table_y[0..newh/8-1] are initialized
  */
 
-static void init_resize_tables(TCVHandle handle,
-                               int oldw, int neww, int oldh, int newh)
+static int init_resize_tables(TCVHandle handle,
+                              int oldw, int neww, int oldh, int newh)
 {
     if (oldw > 0 && neww > 0
      && (oldw != handle->saved_oldw || neww != handle->saved_neww)
     ) {
+        if (handle->resize_table_x_size < neww/8) {
+            free(handle->resize_table_x);
+            handle->resize_table_x_size = 0;
+            handle->resize_table_x =
+                tc_malloc((neww/8) * sizeof(*handle->resize_table_x));
+            if (!handle->resize_table_x)
+                return 0;
+            handle->resize_table_x_size = neww/8;
+        }
         init_one_resize_table(handle->resize_table_x, oldw, neww);
         handle->saved_oldw = oldw;
         handle->saved_neww = neww;
@@ -1112,10 +1214,20 @@ static void init_resize_tables(TCVHandle handle,
     if (oldh > 0 && newh > 0
      && (oldh != handle->saved_oldh || newh != handle->saved_newh)
     ) {
+        if (handle->resize_table_y_size < newh/8) {
+            free(handle->resize_table_y);
+            handle->resize_table_y_size = 0;
+            handle->resize_table_y =
+                tc_malloc((newh/8) * sizeof(*handle->resize_table_y));
+            if (!handle->resize_table_y)
+                return 0;
+            handle->resize_table_y_size = newh/8;
+        }
         init_one_resize_table(handle->resize_table_y, oldh, newh);
         handle->saved_oldh = oldh;
         handle->saved_newh = newh;
     }
+    return 1;
 }
 
 
@@ -1166,6 +1278,207 @@ static void init_one_resize_table(struct resize_table_elem *table,
 
 /*************************************************************************/
 
+/**
+ * zoom_filter_ok:  Return whether the given filter can be used with
+ * tcv_zoom().
+ *
+ * Parameters: filter: Filter type (TCV_ZOOM_*).
+ * Return value: Nonzero if the filter is valid, else zero.
+ * Preconditions: None.
+ * Postconditions: None.
+ */
+
+static int zoom_filter_ok(TCVZoomFilter filter)
+{
+    switch (filter) {
+      case TCV_ZOOM_BOX:
+      case TCV_ZOOM_TRIANGLE:
+      case TCV_ZOOM_HERMITE:
+      case TCV_ZOOM_BELL:
+      case TCV_ZOOM_B_SPLINE:
+      case TCV_ZOOM_MITCHELL:
+      case TCV_ZOOM_LANCZOS3:
+      case TCV_ZOOM_CUBIC_KEYS4:
+      case TCV_ZOOM_SINC8:
+        return 1;
+      default:
+        return 0;
+    }
+}
+
+/*************************************************************************/
+
+/**
+ * zoom_plane:  Resize one data plane for tcv_zoom() or tcv_zoom_yuv(),
+ * using (and filling) the handle's ZoomInfo cache.  If the handle has
+ * worker threads, the plane is split into bands which are resized in
+ * parallel.
+ *
+ * Parameters: handle: tcvideo handle.
+ *                src: Source data plane.
+ *               dest: Destination data plane.
+ *              width: Width of plane.
+ *             height: Height of plane.
+ *                Bpp: Bytes per pixel.
+ *              new_w: New plane width.
+ *              new_h: New plane height.
+ *     interlace_mode: Nonzero to zoom each field separately.
+ *             filter: Filter type (TCV_ZOOM_*).
+ * Return value: Nonzero on success, zero on error (out of memory).
+ * Preconditions: the parameters were checked by the caller
+ * Postconditions: (on success) the destination plane is set
+ */
+
+static int zoom_plane(TCVHandle handle, uint8_t *src, uint8_t *dest,
+                      int width, int height, int Bpp, int new_w, int new_h,
+                      int interlace_mode, TCVZoomFilter filter)
+{
+    ZoomInfo *zi;
+    int free_zi = 0;  // Should the ZoomInfo be freed after use?
+    int fields = interlace_mode ? 2 : 1;
+    int field_h = new_h / fields;
+    int nbands = 1, ok = 1;
+    int i;
+
+    tc_mutex_lock(&handle->zoominfo_lock);
+    for (i = 0, zi = NULL; i < ZOOMINFO_CACHE_SIZE && zi == NULL; i++) {
+        if (handle->zoominfo_cache[i].zi     != NULL
+         && handle->zoominfo_cache[i].old_w  == width
+         && handle->zoominfo_cache[i].old_h  == height
+         && handle->zoominfo_cache[i].new_w  == new_w
+         && handle->zoominfo_cache[i].new_h  == new_h
+         && handle->zoominfo_cache[i].Bpp    == Bpp
+         && handle->zoominfo_cache[i].ilace  == interlace_mode
+         && handle->zoominfo_cache[i].filter == filter
+        ) {
+            zi = handle->zoominfo_cache[i].zi;
+        }
+    }
+    tc_mutex_unlock(&handle->zoominfo_lock);
+    if (!zi) {
+        int ilace_height = height;
+        int ilace_new_h = new_h;
+        int old_stride = width * Bpp;
+        int new_stride = new_w * Bpp;
+        if (interlace_mode) {
+            ilace_height /= 2;
+            ilace_new_h /= 2;
+            old_stride *= 2;
+            new_stride *= 2;
+        }
+        zi = zoom_init(width, ilace_height, new_w, ilace_new_h, Bpp,
+                       old_stride, new_stride, filter);
+        if (!zi) {
+            tc_log_error("libtcvideo", "tcv_zoom: zoom_init() failed!");
+            return 0;
+        }
+        free_zi = 1;
+        tc_mutex_lock(&handle->zoominfo_lock);
+        for (i = 0; i < ZOOMINFO_CACHE_SIZE; i++) {
+            if (!handle->zoominfo_cache[i].zi) {
+                handle->zoominfo_cache[i].zi     = zi;
+                handle->zoominfo_cache[i].old_w  = width;
+                handle->zoominfo_cache[i].old_h  = height;
+                handle->zoominfo_cache[i].new_w  = new_w;
+                handle->zoominfo_cache[i].new_h  = new_h;
+                handle->zoominfo_cache[i].Bpp    = Bpp;
+                handle->zoominfo_cache[i].ilace  = interlace_mode;
+                handle->zoominfo_cache[i].filter = filter;
+                free_zi = 0;
+                break;
+            }
+        }
+        tc_mutex_unlock(&handle->zoominfo_lock);
+    }
+
+    if (handle->zoom_pool) {
+        nbands = tc_task_pool_workers(handle->zoom_pool);
+        if (nbands > field_h / ZOOM_BAND_MIN_ROWS)
+            nbands = field_h / ZOOM_BAND_MIN_ROWS;
+    }
+    if (nbands > 1) {
+        /* Bands are as few as possible, since each one repeats the
+         * horizontal pass on the rows it shares with its neighbours */
+        struct zoom_band bands[fields * nbands];
+        int f, b;
+        for (f = 0; f < fields; f++) {
+            for (b = 0; b < nbands; b++) {
+                struct zoom_band *band = &bands[f*nbands + b];
+                band->zi = zi;
+                band->src = src + f*width*Bpp;
+                band->dest = dest + f*new_w*Bpp;
+                band->first = (long)field_h * b / nbands;
+                band->last = (long)field_h * (b+1) / nbands;
+                band->ok = 0;
+                if (tc_task_pool_submit(handle->zoom_pool, band) != TC_OK)
+                    zoom_band_run(band, 0, NULL);
+            }
+        }
+        tc_task_pool_wait(handle->zoom_pool);
+        for (i = 0; i < fields * nbands; i++)
+            ok = ok && bands[i].ok;
+    } else {
+        ok = zoom_process(zi, src, dest);
+        if (interlace_mode)
+            ok = ok && zoom_process(zi, src + width*Bpp, dest + new_w*Bpp);
+    }
+    if (!ok)
+        tc_log_error("libtcvideo", "tcv_zoom: out of memory!");
+    if (free_zi)
+        zoom_free(zi);
+    return ok;
+}
+
+/*************************************************************************/
+
+/**
+ * zoom_band_run:  Task function for the tcv_zoom() worker threads:
+ * resize one band of rows.
+ *
+ * Parameters:     task: Band to process (struct zoom_band *).
+ *               worker: Index of the worker thread (unused).
+ *             userdata: Unused.
+ * Return value: None.
+ * Preconditions: None.
+ * Postconditions: band->ok is set
+ */
+
+static void zoom_band_run(void *task, int worker, void *userdata)
+{
+    struct zoom_band *band = task;
+
+    band->ok = zoom_process_rows(band->zi, band->src, band->dest,
+                                 band->first, band->last);
+}
+
+/*************************************************************************/
+
+/**
+ * get_convert_buffer:  Return the handle's scratch buffer, enlarging it
+ * if needed to hold at least the given number of bytes.
+ *
+ * Parameters: handle: tcvideo handle.
+ *               size: Minimum size of the buffer, in bytes.
+ * Return value: Pointer to the buffer, or NULL on error (out of memory).
+ * Preconditions: handle != 0
+ * Postconditions: (on success) handle->convert_buffer_size >= size
+ */
+
+static uint8_t *get_convert_buffer(TCVHandle handle, uint32_t size)
+{
+    if (!handle->convert_buffer || handle->convert_buffer_size < size) {
+        free(handle->convert_buffer);
+        handle->convert_buffer_size = 0;
+        handle->convert_buffer = tc_malloc(size);
+        if (!handle->convert_buffer)
+            return NULL;
+        handle->convert_buffer_size = size;
+    }
+    return handle->convert_buffer;
+}
+
+/*************************************************************************/
+
 /**
  * init_gamma_table:  Initialize the gamma correction lookup table.
  * Initialization will not be performed for repeated calls with the same
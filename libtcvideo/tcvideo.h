@@ -55,6 +55,8 @@ TCVHandle tcv_init(void);
 
 void tcv_free(TCVHandle handle);
 
+int tcv_set_threads(TCVHandle handle, int threads);
+
 int tcv_clip(TCVHandle handle,
              uint8_t *src, uint8_t *dest, int width, int height, int Bpp,
              int clip_left, int clip_right, int clip_top, int clip_bottom,
@@ -72,6 +74,10 @@ int tcv_zoom(TCVHandle handle,
              uint8_t *src, uint8_t *dest, int width, int height, int Bpp,
              int new_w, int new_h, TCVZoomFilter filter);
 
+int tcv_zoom_yuv(TCVHandle handle,
+                 uint8_t *src, uint8_t *dest, int width, int height,
+                 ImageFormat fmt, int new_w, int new_h, TCVZoomFilter filter);
+
 int tcv_reduce(TCVHandle handle,
                uint8_t *src, uint8_t *dest, int width, int height, int Bpp,
                int reduce_w, int reduce_h);
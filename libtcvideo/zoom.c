@@ -16,25 +16,29 @@
 #include "tccore/job.h"
 #include "libtc/libtc.h"
 #include "aclib/ac.h"
+#include <limits.h>
 #include <math.h>
+#include <stdlib.h>
 
 /*************************************************************************/
 
-/* Data structures for holding resizing data (used internally). */
-
-/* A contributor to a single pixel */
-struct contrib {
-    int pixel;
-    double weight;
-};
-
-/* List of all contributors to a single pixel */
-struct clist {
-    int n;                      /* Number of contributors */
-    struct contrib *list;       /* Pointer to list of contributors */
-};
+/* Data for a resize operation (used internally).  Each direction is
+ * resized with a fixed number of taps for every output pixel, unused taps
+ * having a zero weight; the first source pixel for each output pixel may
+ * be outside the source image, which is mirrored at the edges.
+ *
+ * For the horizontal direction, each source row is first copied to a
+ * buffer with the mirrored pixels on either side, so the taps are always
+ * consecutive pixels.  When both directions are resized, the horizontally
+ * resized rows go into a ring of `y_taps' rows, which is just what is
+ * needed for one output row; since the source rows needed only move
+ * forward, each row is resized horizontally once, and the intermediate
+ * data stays in the cache.
+ *
+ * The structure is not modified after zoom_init(): the row buffers belong
+ * to each zoom_process_rows() call, so different ranges of rows (or
+ * different images) can be processed at the same time. */
 
-/* Data for a resize operation */
 struct zoominfo {
     int old_w, old_h;           /* Original width and height */
     int new_w, new_h;           /* New width and height */
@@ -43,16 +47,27 @@ struct zoominfo {
     int new_stride;             /* Bytes per line (new image) */
     double (*filter)(double);   /* Filter function */
     double fwidth;              /* Filter width */
-    int32_t *x_contrib;         /* Contributors in the horizontal direction */
-    int32_t *y_contrib;         /* Contributors in the vertical direction */
-    uint8_t *tmpimage;          /* Temporary buffer */
+
+    int x_taps;                 /* Taps per pixel horizontally (0: none) */
+    int32_t *x_start;           /* First pixel in the padded row */
+    int16_t *x_weights;         /* Weights for each pixel */
+    int x_pad;                  /* Mirrored pixels on the left */
+    int rowbuf_w;               /* Width of the padded row in pixels */
+
+    int y_taps;                 /* Taps per row vertically (0: none) */
+    int32_t *y_start;           /* First source row (may be out of range) */
+    int16_t *y_weights;         /* Weights for each row */
 };
 
-/* Convert a double to a 16.16 fixed-point value */
-#define DOUBLE_TO_FIXED(v) ((int32_t)((v)*65536))
+/* Row buffers for one zoom_process_rows() call */
+struct zoombufs {
+    uint8_t *rowbuf;            /* Padded source row */
+    uint8_t *ring;              /* Horizontally resized rows */
+    int *ring_row;              /* Source row in each slot of `ring' */
+};
 
-/* Convert a 16.16 fixed-point value to an integer */
-#define FIXED_TO_INT(v) ((v)>>16)
+/* Fixed-point 1.0 for weights */
+#define WEIGHT_ONE      (1 << AC_RESAMPLE_BITS)
 
 /*************************************************************************/
 
@@ -325,38 +340,63 @@ static double sinc8_filter(double t)
 /*************************************************************************/
 
 /**
- * gen_contrib:  Helper function to generate the list of contributors to
- * each resized pixel in one direction (horizontal or vertical).
+ * mirror:  Helper function to map a pixel index outside an image back
+ * into it, mirroring the image at its edges.
+ *
+ * Parameters:
+ *     i: Pixel index.
+ *  size: Size of image in the direction of the index.
+ * Return value:
+ *     Pixel index in [0,size).
+ */
+
+static inline int mirror(int i, int size)
+{
+    if (i < 0)
+        i = -i;
+    if (i >= size)
+        i = (size - i) + size - 1;
+    return i < 0 ? 0 : i >= size ? size-1 : i;
+}
+
+/*************************************************************************/
+
+/**
+ * gen_weights:  Helper function to generate the filter taps for each
+ * resized pixel in one direction (horizontal or vertical).  The weights
+ * for each pixel are normalized, so that a flat area stays flat.
  *
  * Parameters:
  *     oldsize: Size of original image in the direction for which
- *              contributors are being generated.
+ *              weights are being generated.
  *     newsize: Size of resized image in the direction for which
- *              contributors are being generated.
- *      stride: Number of bytes between adjacent pixels in the direction
- *              for which contributors are being generated.
+ *              weights are being generated.
  *      filter: As for zoom_process().
  *      fwidth: As for zoom_process().
+ *       align: Number of taps is rounded up to a multiple of this.
+ *   start_ret: Receives a `newsize'-element array with the first source
+ *              pixel for each resized pixel.
+ * weights_ret: Receives a `newsize'*taps-element array with the weights
+ *              for each resized pixel.
  * Return value:
- *     A pointer to a `newsize'-element array of `struct clist' elements,
- *     or NULL on error (out of memory).
+ *     Number of taps for each pixel, or 0 on error (out of memory).
  * Preconditions:
  *     oldsize > 0
  *     newsize > 0
- *     stride > 0
  *     filter != NULL
  *     fwidth > 0
+ *     align > 0
  */
 
-static struct clist *gen_contrib(int oldsize, int newsize, int stride,
-                                 double (*filter)(double), double fwidth)
+static int gen_weights(int oldsize, int newsize,
+                       double (*filter)(double), double fwidth, int align,
+                       int32_t **start_ret, int16_t **weights_ret)
 {
-    struct clist *contrib;
     double scale = (double)newsize / (double)oldsize;
-    double new_fwidth, fscale;
-    int i, j;
-
-    contrib = tc_zalloc(newsize * sizeof(struct clist));
+    double new_fwidth, fscale, *w;
+    int32_t *start;
+    int16_t *weights;
+    int taps, i, j;
 
     if (scale < 1.0) {
         fscale = 1.0 / scale;
@@ -364,30 +404,57 @@ static struct clist *gen_contrib(int oldsize, int newsize, int stride,
         fscale = 1.0;
     }
     new_fwidth = fwidth * fscale;
-    for (i = 0; i < newsize; ++i) {
+
+    for (taps = 0, i = 0; i < newsize; i++) {
         double center = (double) i / scale;
         int left = ceil(center - new_fwidth);
         int right = floor(center + new_fwidth);
-        contrib[i].n = 0;
-        contrib[i].list = tc_zalloc((right-left+1) * sizeof(struct contrib));
-        for (j = left; j <= right; ++j) {
-            int k, n;
-            double weight = center - (double) j;
-            weight = (*filter)(weight / fscale) / fscale;
-            if (j < 0) {
-                n = -j;
-            } else if (j >= oldsize) {
-                n = (oldsize - j) + oldsize - 1;
-            } else {
-                n = j;
-            }
-            k = contrib[i].n++;
-            contrib[i].list[k].pixel = n*stride;
-            contrib[i].list[k].weight = weight;
+        if (right-left+1 > taps)
+            taps = right-left+1;
+    }
+    taps = (taps + align-1) / align * align;
+
+    start = tc_malloc(newsize * sizeof(*start));
+    weights = tc_zalloc(newsize * taps * sizeof(*weights));
+    w = tc_malloc(taps * sizeof(*w));
+    if (!start || !weights || !w) {
+        free(start);
+        free(weights);
+        free(w);
+        return 0;
+    }
+
+    for (i = 0; i < newsize; i++) {
+        double center = (double) i / scale;
+        int left = ceil(center - new_fwidth);
+        int right = floor(center + new_fwidth);
+        int16_t *iw = weights + i*taps;
+        double sum = 0;
+        int total = 0, big = 0;
+
+        for (j = left; j <= right; j++) {
+            w[j-left] = (*filter)((center - (double) j) / fscale) / fscale;
+            sum += w[j-left];
+        }
+        if (sum == 0)
+            sum = 1;
+        for (j = 0; j <= right-left; j++) {
+            double v = floor(w[j] / sum * WEIGHT_ONE + 0.5);
+            iw[j] = v < -32768 ? -32768 : v > 32767 ? 32767 : v;
+            total += iw[j];
+            if (abs(iw[j]) > abs(iw[big]))
+                big = j;
         }
+        /* Rounding leftovers go to the largest weight */
+        if (abs(iw[big] + WEIGHT_ONE - total) <= 32767)
+            iw[big] += WEIGHT_ONE - total;
+        start[i] = left;
     }
 
-    return contrib;
+    free(w);
+    *start_ret = start;
+    *weights_ret = weights;
+    return taps;
 }
 
 /*************************************************************************/
@@ -420,7 +487,6 @@ ZoomInfo *zoom_init(int old_w, int old_h, int new_w, int new_h, int Bpp,
                     int old_stride, int new_stride, TCVZoomFilter filter)
 {
     ZoomInfo *zi;
-    struct clist *x_contrib = NULL, *y_contrib = NULL;
 
     /* Sanity check */
     if (old_w <= 0 || old_h <= 0 || new_w <= 0 || new_h <= 0 || Bpp <= 0
@@ -482,189 +548,231 @@ ZoomInfo *zoom_init(int old_w, int old_h, int new_w, int new_h, int Bpp,
         return NULL;
     }
 
-    /* Generate contributor lists and allocate temporary image buffer */
-    zi->x_contrib = NULL;
-    zi->y_contrib = NULL;
-    zi->tmpimage = tc_malloc(new_w * old_h * Bpp);
-    if (!zi->tmpimage)
-        goto error_out;
+    /* Generate the filter taps */
+    zi->x_taps = 0;
+    zi->x_start = NULL;
+    zi->x_weights = NULL;
+    zi->x_pad = 0;
+    zi->rowbuf_w = 0;
+    zi->y_taps = 0;
+    zi->y_start = NULL;
+    zi->y_weights = NULL;
+
     if (old_w != new_w) {
-        x_contrib = gen_contrib(old_w, new_w, Bpp, zi->filter, zi->fwidth);
-        if (!x_contrib)
+        int i;
+        /* The SIMD horizontal resamplers work on 8 taps at a time */
+        zi->x_taps = gen_weights(old_w, new_w, zi->filter, zi->fwidth, 8,
+                                 &zi->x_start, &zi->x_weights);
+        if (!zi->x_taps)
             goto error_out;
+        for (i = 0; i < new_w; i++) {
+            if (-zi->x_start[i] > zi->x_pad)
+                zi->x_pad = -zi->x_start[i];
+        }
+        zi->rowbuf_w = old_w + zi->x_pad;
+        for (i = 0; i < new_w; i++) {
+            zi->x_start[i] += zi->x_pad;
+            if (zi->x_start[i] + zi->x_taps > zi->rowbuf_w)
+                zi->rowbuf_w = zi->x_start[i] + zi->x_taps;
+        }
     }
+
     if (old_h != new_h) {
-        /* Calculate the correct stride--if the width isn't changing,
-         * this will just be old_stride */
-        int stride = (old_w==new_w) ? old_stride : Bpp*new_w;
-        y_contrib = gen_contrib(old_h, new_h, stride, zi->filter,
-                                zi->fwidth);
-        if (!y_contrib)
+        zi->y_taps = gen_weights(old_h, new_h, zi->filter, zi->fwidth, 1,
+                                 &zi->y_start, &zi->y_weights);
+        if (!zi->y_taps)
             goto error_out;
     }
 
-    /* Convert contributor lists into flat arrays and fixed-point values.
-     * The flat array consists of a contributor count plus two values per
-     * contributor (index and fixed-point weight) for each output pixel.
-     * Note that for the horizontal direction, we make `Bpp' copies of the
-     * contributors, adjusting the offset for each byte of the pixel. */
+    /* Done */
+    return zi;
 
-    if (x_contrib) {
-        int count = 0, i;
-        int32_t *ptr;
+  error_out:
+    zoom_free(zi);
+    return NULL;
+}
 
-        for (i = 0; i < new_w; i++)
-            count += 1 + 2 * x_contrib[i].n;
-        zi->x_contrib = tc_malloc(sizeof(int32_t) * count * Bpp);
-        if (!zi->x_contrib)
-            goto error_out;
-        for (ptr = zi->x_contrib, i = 0; i < new_w * Bpp; i++) {
-            int j;
-            *ptr++ = x_contrib[i/Bpp].n;
-            for (j = 0; j < x_contrib[i/Bpp].n; j++) {
-                *ptr++ = x_contrib[i/Bpp].list[j].pixel + i%Bpp;
-                *ptr++ = DOUBLE_TO_FIXED(x_contrib[i/Bpp].list[j].weight);
-            }
-        }
-        /* Free original contributor list */
-        for (i = 0; i < new_w; i++)
-            free(x_contrib[i].list);
-        free(x_contrib);
-        x_contrib = NULL;
-    }
+/*************************************************************************/
+
+/**
+ * zoom_row:  Helper function to resize one row horizontally.
+ *
+ * Parameters:
+ *       zi: ZoomInfo structure allocated by zoom_init().
+ *     bufs: Row buffers for this call.
+ *      src: Source row.
+ *     dest: Destination row.
+ * Return value: None.
+ * Preconditions:
+ *     zi->x_taps != 0
+ */
 
-    if (y_contrib) {
-        int count = 0, i;
-        int32_t *ptr;
+static void zoom_row(const ZoomInfo *zi, const struct zoombufs *bufs,
+                     const uint8_t *src, uint8_t *dest)
+{
+    uint8_t *buf = bufs->rowbuf;
+    int Bpp = zi->Bpp, pad = zi->x_pad, i, j;
 
-        for (i = 0; i < new_h; i++)
-            count += 1 + 2 * y_contrib[i].n;
-        zi->y_contrib = tc_malloc(sizeof(int32_t) * count);
-        if (!zi->y_contrib)
-            goto error_out;
-        for (ptr = zi->y_contrib, i = 0; i < new_h; i++) {
-            int j;
-            *ptr++ = y_contrib[i].n;
-            for (j = 0; j < y_contrib[i].n; j++) {
-                *ptr++ = y_contrib[i].list[j].pixel;
-                *ptr++ = DOUBLE_TO_FIXED(y_contrib[i].list[j].weight);
-            }
-        }
-        for (i = 0; i < new_h; i++)
-            free(y_contrib[i].list);
-        free(y_contrib);
-        y_contrib = NULL;
+    for (i = 0; i < pad; i++) {
+        const uint8_t *from = src + mirror(i - pad, zi->old_w) * Bpp;
+        for (j = 0; j < Bpp; j++)
+            buf[i*Bpp+j] = from[j];
+    }
+    ac_memcpy(buf + pad*Bpp, src, zi->old_w * Bpp);
+    for (i = pad + zi->old_w; i < zi->rowbuf_w; i++) {
+        const uint8_t *from = src + mirror(i - pad, zi->old_w) * Bpp;
+        for (j = 0; j < Bpp; j++)
+            buf[i*Bpp+j] = from[j];
     }
+    ac_resample_h(buf, dest, zi->new_w, Bpp, zi->x_start, zi->x_weights,
+                  zi->x_taps);
+}
 
-    /* Done */
-    return zi;
+/*************************************************************************/
 
-  error_out:
-    {
-        if (x_contrib) {
-            int i;
-            for (i = 0; i < new_w; i++)
-                free(x_contrib[i].list);
-            free(x_contrib);
-        }
-        if (y_contrib) {
-            int i;
-            for (i = 0; i < new_w; i++)
-                free(x_contrib[i].list);
-            free(x_contrib);
-        }
-        zoom_free(zi);
-        return NULL;
+/**
+ * zoom_get_row:  Helper function to return a source row for the vertical
+ * pass, resized horizontally if needed.  Rows outside the source image
+ * are mirrored at the edges.
+ *
+ * Parameters:
+ *       zi: ZoomInfo structure allocated by zoom_init().
+ *     bufs: Row buffers for this call.
+ *      src: Source data plane.
+ *      row: Index of the row (may be out of range).
+ * Return value:
+ *     Pointer to the row data.
+ * Preconditions:
+ *     zi->y_taps != 0
+ */
+
+static const uint8_t *zoom_get_row(const ZoomInfo *zi,
+                                   const struct zoombufs *bufs,
+                                   const uint8_t *src, int row)
+{
+    const uint8_t *from = src + mirror(row, zi->old_h) * zi->old_stride;
+    uint8_t *to;
+    int slot;
+
+    if (!zi->x_taps)
+        return from;
+    slot = row % zi->y_taps;
+    if (slot < 0)
+        slot += zi->y_taps;
+    to = bufs->ring + slot * zi->new_w * zi->Bpp;
+    if (bufs->ring_row[slot] != row) {
+        zoom_row(zi, bufs, from, to);
+        bufs->ring_row[slot] = row;
     }
+    return to;
 }
 
 /*************************************************************************/
 
 /**
- * zoom_process:  Image resizing core.
+ * zoom_process_rows:  Image resizing core.  Only the given range of rows
+ * of the resized image is stored; different ranges can be processed in
+ * parallel with the same ZoomInfo structure.
  *
  * Parameters:
  *       zi: ZoomInfo structure allocated by zoom_init().
  *      src: Source data plane.
  *     dest: Destination data plane.
- * Return value: None.
+ *    first: First row of the resized image to process.
+ *     last: One past the last row of the resized image to process.
+ * Return value:
+ *     Nonzero on success, zero on error (out of memory).
  * Preconditions:
  *     zi was allocated by zoom_init()
  *     src != NULL
  *     dest != NULL
  *     src and dest do not overlap
+ *     0 <= first <= last <= new height
  */
 
-/* clamp the input to the specified range */
-#define CLAMP(v,l,h)    ((v)<(l) ? (l) : (v) > (h) ? (h) : (v))
-
-void zoom_process(const ZoomInfo *zi, const uint8_t *src, uint8_t *dest)
+int zoom_process_rows(const ZoomInfo *zi, const uint8_t *src, uint8_t *dest,
+                      int first, int last)
 {
-    int from_stride, to_stride;
-    const uint8_t *from;
-    uint8_t *to;
-
-    from = src;
-    from_stride = zi->old_stride;
-
-    /* Apply filter to zoom horizontally from src to tmp (if necessary) */
-    if (zi->x_contrib) {
-        int y;
-        to = zi->tmpimage;
-        to_stride = zi->new_w * zi->Bpp;
-        for (y = 0; y < zi->old_h; y++, from += from_stride, to += to_stride) {
-            int32_t *contrib = zi->x_contrib;
-            int x;
-            for (x = 0; x < zi->new_w * zi->Bpp; x++) {
-                int32_t weight = DOUBLE_TO_FIXED(0.5);
-                int n = *contrib++, i;
-                for (i = 0; i < n; i++) {
-                    int pixel = *contrib++;
-                    weight += from[pixel] * (*contrib++);
-                }
-                to[x] = CLAMP(FIXED_TO_INT(weight), 0, 255);
-            }
-        }
-        from = zi->tmpimage;
-        from_stride = to_stride;
+    int row_bytes = zi->new_w * zi->Bpp;
+    struct zoombufs bufs = { NULL, NULL, NULL };
+    int y;
+
+    if (zi->x_taps) {
+        /* One allocation for all the row buffers; ring_row goes first,
+         * to keep its alignment */
+        int ringsize = zi->y_taps * sizeof(*bufs.ring_row);
+        uint8_t *mem;
+        if (zi->y_taps)
+            ringsize += zi->y_taps * row_bytes;
+        mem = tc_malloc(ringsize + zi->rowbuf_w * zi->Bpp);
+        if (!mem)
+            return 0;
+        bufs.ring_row = (int *)mem;
+        bufs.ring = mem + zi->y_taps * sizeof(*bufs.ring_row);
+        bufs.rowbuf = mem + ringsize;
+    } else if (zi->y_taps) {
+        bufs.ring_row = tc_malloc(zi->y_taps * sizeof(*bufs.ring_row));
+        if (!bufs.ring_row)
+            return 0;
     }
 
-    /* Apply filter to zoom vertically from tmp (or src) to dest */
-    /* Use Y as the outside loop to avoid cache thrashing on output buffer */
-    to = dest;
-    to_stride = zi->new_stride;
-    if (zi->y_contrib) {
-        int32_t *contrib = zi->y_contrib;
-        int y;
-        for (y = 0; y < zi->new_h; y++, to += to_stride) {
-            int n = *contrib++, x;
-            for (x = 0; x < zi->new_w * zi->Bpp; x++) {
-                int32_t weight = DOUBLE_TO_FIXED(0.5);
-                int i;
-                for (i = 0; i < n; i++) {
-                    int pixel = contrib[i*2];
-                    weight += from[x+pixel] * contrib[i*2+1];
-                }
-                to[x] = CLAMP(FIXED_TO_INT(weight), 0, 255);
-            }
-            contrib += 2*n;
+    dest += first * zi->new_stride;
+    if (zi->y_taps) {
+        const uint8_t *rows[zi->y_taps];
+        int i;
+
+        for (i = 0; i < zi->y_taps; i++)
+            bufs.ring_row[i] = INT_MIN;
+        for (y = first; y < last; y++, dest += zi->new_stride) {
+            for (i = 0; i < zi->y_taps; i++)
+                rows[i] = zoom_get_row(zi, &bufs, src, zi->y_start[y] + i);
+            ac_resample_v(rows, zi->y_weights + y * zi->y_taps, zi->y_taps,
+                          dest, row_bytes);
+        }
+    } else if (zi->x_taps) {
+        src += first * zi->old_stride;
+        for (y = first; y < last; y++) {
+            zoom_row(zi, &bufs, src, dest);
+            src += zi->old_stride;
+            dest += zi->new_stride;
         }
     } else {
         /* No zooming necessary, just copy */
-        if (from_stride == zi->new_w*zi->Bpp
-         && to_stride == zi->new_w*zi->Bpp
-        ) {
-            /* We can copy the whole frame at once */
-            ac_memcpy(to, from, to_stride * zi->new_h);
+        src += first * zi->old_stride;
+        if (zi->old_stride == row_bytes && zi->new_stride == row_bytes) {
+            /* We can copy the whole range at once */
+            ac_memcpy(dest, src, row_bytes * (last - first));
         } else {
             /* Copy one row at a time */
-            int y;
-            for (y = 0; y < zi->new_h; y++) {
-                ac_memcpy(to + y*to_stride, from + y*from_stride,
-                          zi->new_w * zi->Bpp);
+            for (y = first; y < last; y++) {
+                ac_memcpy(dest, src, row_bytes);
+                src += zi->old_stride;
+                dest += zi->new_stride;
             }
         }
     }
+
+    /* The single allocation starts at ring_row in both cases */
+    free(bufs.ring_row);
+    return 1;
+}
+
+/*************************************************************************/
+
+/**
+ * zoom_process:  Resize a whole image; see zoom_process_rows().
+ *
+ * Parameters:
+ *       zi: ZoomInfo structure allocated by zoom_init().
+ *      src: Source data plane.
+ *     dest: Destination data plane.
+ * Return value:
+ *     Nonzero on success, zero on error (out of memory).
+ */
+
+int zoom_process(const ZoomInfo *zi, const uint8_t *src, uint8_t *dest)
+{
+    return zoom_process_rows(zi, src, dest, 0, zi->new_h);
 }
 
 /*************************************************************************/
@@ -683,9 +791,10 @@ void zoom_process(const ZoomInfo *zi, const uint8_t *src, uint8_t *dest)
  */
 void zoom_free(ZoomInfo *zi)
 {
-    free(zi->x_contrib);
-    free(zi->y_contrib);
-    free(zi->tmpimage);
+    free(zi->x_start);
+    free(zi->x_weights);
+    free(zi->y_start);
+    free(zi->y_weights);
     free(zi);
 }
 
@@ -19,8 +19,13 @@ typedef struct zoominfo ZoomInfo;
 ZoomInfo *zoom_init(int old_w, int old_h, int new_w, int new_h, int Bpp,
                     int old_stride, int new_stride, TCVZoomFilter filter);
 
-/* The resizing function itself. */
-void zoom_process(const ZoomInfo *zi, const uint8_t *src, uint8_t *dest);
+/* The resizing function itself; returns nonzero on success. */
+int zoom_process(const ZoomInfo *zi, const uint8_t *src, uint8_t *dest);
+
+/* Resize only rows [first,last) of the resized image.  Can be called for
+ * different ranges at the same time. */
+int zoom_process_rows(const ZoomInfo *zi, const uint8_t *src, uint8_t *dest,
+                      int first, int last);
 
 /* Free a ZoomInfo structure. */
 void zoom_free(ZoomInfo *zi);
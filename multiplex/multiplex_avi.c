@@ -26,7 +26,7 @@
 #include "avilib/avilib.h"
 
 #define MOD_NAME    "multiplex_avi.so"
-#define MOD_VERSION "v0.1.0 (2009-02-07)"
+#define MOD_VERSION "v0.2.0 (2026-10-18)"
 #define MOD_CAP     "create an AVI stream using avilib"
 
 #define MOD_FEATURES \
@@ -46,6 +46,8 @@ static const char avi_help[] = ""
     "    maximum of one audio and video track.\n"
     "    You can add more tracks with further processing.\n"
     "Options:\n"
+    "    buffer  output buffer size in KB (0 = write each chunk)\n"
+    "    direct  write with O_DIRECT, bypassing the page cache\n"
     "    help    produce module overview and options explanations\n";
 
 typedef struct {
@@ -55,6 +57,8 @@ typedef struct {
     int arate;
     int abitrate;
     const char *fcc;
+    int wbuf_kb; /* -1: avilib default */
+    int direct; /* boolean flag */
 } AVIPrivateData;
 
 static int avi_inspect(TCModuleInstance *self,
@@ -93,6 +97,15 @@ static int avi_configure(TCModuleInstance *self,
         tc_log_info(MOD_NAME, "AVI FourCC: '%s'", pd->fcc);
     }
 
+    pd->wbuf_kb = -1;
+    pd->direct  = TC_FALSE;
+    if (options != NULL) {
+        optstr_get(options, "buffer", "%i", &pd->wbuf_kb);
+        if (optstr_lookup(options, "direct")) {
+            pd->direct = TC_TRUE;
+        }
+    }
+
     if (vob->ex_v_codec == TC_CODEC_RGB24
      || vob->ex_v_codec == TC_CODEC_YUV420P
      || vob->ex_v_codec == TC_CODEC_YUV422P) {
@@ -121,6 +134,16 @@ static int avi_open(TCModuleInstance *self,
         return TC_ERROR;
     }
 
+    if (pd->wbuf_kb >= 0 || pd->direct) {
+        long size = (pd->wbuf_kb >= 0)
+                    ?pd->wbuf_kb * 1024L :AVI_WRITE_BUFFER;
+
+        if (AVI_set_write_buffer(pd->avifile, size, pd->direct) < 0) {
+            tc_log_warn(MOD_NAME, "can't set the output buffer: %s",
+                        AVI_strerror());
+        }
+    }
+
 	AVI_set_video(pd->avifile, vob->ex_v_width, vob->ex_v_height,
 	              vob->ex_fps, pd->fcc);
 
@@ -734,7 +734,9 @@ static int tc_ogg_open(TCModuleInstance *self,
 
     pd = self->userdata;
 
-    srand(time(NULL));
+    /* chunked mode chains the files of workers started at once, their
+     * serial numbers must differ too */
+    srand(time(NULL) ^ getpid());
     /* need some inequal serial numbers */
     pd->hserial = rand();
     pd->vserial = rand();
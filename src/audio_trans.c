@@ -160,6 +160,7 @@ int process_aud_frame(vob_t *vob, aframe_list_t *ptr)
     }
 
     /* Actually perform processing */
+    aframe_unshare(ptr);
     return do_process_audio(vob, ptr) ? 0 : -1;
 }
 
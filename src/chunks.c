@@ -0,0 +1,402 @@
+/*
+ *  chunks.c -- chunked encoding of a single input: where to cut it and
+ *              how to join the encoded pieces.
+ *
+ *  This file is part of transcode, a video stream processing tool
+ *
+ *  transcode is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  transcode is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include "transcode.h"
+#include "chunks.h"
+#include "probe.h"
+
+#include "avilib/avilib.h"
+#include "libtcutil/ioutils.h"
+
+/* side files of the raw multiplexor, see multiplex_raw.c */
+static const char *join_suffixes[] = { "", ".vid", ".aud", NULL };
+#define JOIN_AUDIO_SUFFIX   ".aud"
+
+/*************************************************************************/
+
+/* even cuts, for inputs we know nothing about but the length */
+static int plan_even(int first, int last, int count, TCChunk *chunks)
+{
+    int i = 0, n = 0;
+
+    if (count > last - first) {
+        count = last - first;
+    }
+    for (i = 0; i < count; i++) {
+        chunks[n].first = first + (int)((int64_t)(last - first) * i / count);
+        chunks[n].last = first
+                         + (int)((int64_t)(last - first) * (i + 1) / count);
+        chunks[n].offset = -1;
+        if (chunks[n].last > chunks[n].first) {
+            n++;
+        }
+    }
+    return n;
+}
+
+/* cuts on the first key frame at or after each even cut */
+static int plan_avi(avi_t *avi, int first, int last, int count,
+                    TCChunk *chunks)
+{
+    const uint8_t *data = NULL;
+    int i = 0, n = 0, key = 0, frame = 0, prev_key = 0, target = 0;
+
+    if (last == TC_FRAME_LAST || last > AVI_video_frames(avi)) {
+        last = AVI_video_frames(avi);
+    }
+    if (first >= last) {
+        return 0;
+    }
+
+    AVI_seek_start(avi);
+    /* the first chunk seeks to the key frame before it */
+    for (frame = 0; frame <= first; frame++) {
+        if (AVI_read_frame_ref(avi, &data, &key) < 0) {
+            return -1;
+        }
+        if (key || frame == 0) {
+            prev_key = frame;
+        }
+    }
+    chunks[0].first = first;
+    chunks[0].offset = prev_key;
+    n = 1;
+
+    for (i = 1; i < count; i++) {
+        target = first + (int)((int64_t)(last - first) * i / count);
+        for (; frame < last; frame++) {
+            if (AVI_read_frame_ref(avi, &data, &key) < 0) {
+                return -1;
+            }
+            if (key && frame >= target) {
+                break;
+            }
+        }
+        if (frame >= last) {
+            break;
+        }
+        chunks[n - 1].last = frame;
+        chunks[n].first = frame;
+        chunks[n].offset = frame;
+        n++;
+        frame++;
+    }
+    chunks[n - 1].last = last;
+    return n;
+}
+
+int tc_chunk_plan(const char *file, int first, int last, int count,
+                  TCChunk *chunks)
+{
+    avi_t *avi = AVI_open_input_file(file, 1);
+    ProbeInfo info;
+    int n = 0;
+
+    if (count < 1) {
+        return 0;
+    }
+    if (avi != NULL) {
+        n = plan_avi(avi, first, last, count, chunks);
+        AVI_close(avi);
+        return n;
+    }
+
+    if (last == TC_FRAME_LAST) {
+        memset(&info, 0, sizeof(info));
+        if (!probe_stream_data(file, 1, &info) || info.frames <= 0) {
+            return -1;
+        }
+        last = (int)info.frames;
+    }
+    return plan_even(first, last, count, chunks);
+}
+
+/*************************************************************************/
+
+int tc_chunk_can_join(const char *mplex)
+{
+    return (mplex != NULL
+            && (strcmp(mplex, "avi") == 0 || strcmp(mplex, "raw") == 0
+             || strcmp(mplex, "ogg") == 0 || strcmp(mplex, "null") == 0));
+}
+
+/* the audio of the joined file, from the part encoded in one go */
+typedef struct joinaudio_ JoinAudio;
+struct joinaudio_ {
+    avi_t *in;                      /* NULL for none */
+    int tracks;
+    long chunks[AVI_MAX_TRACKS];    /* in each track */
+    long done[AVI_MAX_TRACKS];      /* copied so far */
+};
+
+/* copies the audio chunks due once `frame' of `frames' is written, so
+ * each track is spread evenly over the video as the original was; AVI
+ * timing is in the frame and byte counts, so the interleaving doesn't
+ * change it.  The last frame takes whatever is left. */
+static int join_avi_audio(avi_t *out, JoinAudio *A, long frame, long frames)
+{
+    const uint8_t *data = NULL;
+    long bytes = 0;
+    int t = 0;
+
+    for (t = 0; t < A->tracks; t++) {
+        AVI_set_audio_track(A->in, t);
+        AVI_set_audio_track(out, t);
+        while (A->done[t] < A->chunks[t]
+               && (frame == frames - 1
+                   || A->done[t] * frames < (frame + 1) * A->chunks[t])) {
+            bytes = AVI_read_audio_chunk_ref(A->in, &data);
+            if (bytes < 0 || AVI_write_audio(out, data, bytes) < 0) {
+                return TC_ERROR;
+            }
+            A->done[t]++;
+        }
+    }
+    return TC_OK;
+}
+
+/* copies the video of one chunk; `frame' counts the frames written */
+static int join_avi_part(avi_t *out, const char *part, JoinAudio *A,
+                         long *frame, long frames)
+{
+    avi_t *in = AVI_open_input_file(part, 1);
+    const uint8_t *data = NULL;
+    long f = 0, n = 0, bytes = 0;
+    int key = 0;
+
+    if (in == NULL) {
+        tc_log_error(__FILE__, "cannot open chunk %s: %s",
+                     part, AVI_strerror());
+        return TC_ERROR;
+    }
+    n = AVI_video_frames(in);
+    for (f = 0; f < n; f++, (*frame)++) {
+        bytes = AVI_read_frame_ref(in, &data, &key);
+        if (bytes < 0 || AVI_write_frame(out, data, bytes, key) < 0
+         || join_avi_audio(out, A, *frame, frames) != TC_OK) {
+            goto failed;
+        }
+    }
+    AVI_close(in);
+    return TC_OK;
+
+  failed:
+    tc_log_error(__FILE__, "joining chunk %s: %s", part, AVI_strerror());
+    AVI_close(in);
+    return TC_ERROR;
+}
+
+/* how many frames the chunks have together, -1 on error */
+static long join_avi_frames(char * const *parts, int count)
+{
+    avi_t *in = NULL;
+    long frames = 0;
+    int i = 0;
+
+    for (i = 0; i < count; i++) {
+        in = AVI_open_input_file(parts[i], 1);
+        if (in == NULL) {
+            tc_log_error(__FILE__, "cannot open chunk %s: %s",
+                         parts[i], AVI_strerror());
+            return -1;
+        }
+        frames += AVI_video_frames(in);
+        AVI_close(in);
+    }
+    return frames;
+}
+
+static int join_avi(const char *name, char * const *parts, int count,
+                    const char *audio)
+{
+    avi_t *in = NULL, *out = NULL;
+    JoinAudio A;
+    long frames = 0, frame = 0;
+    int i = 0, t = 0, ret = TC_OK;
+
+    memset(&A, 0, sizeof(A));
+    frames = join_avi_frames(parts, count);
+    if (frames < 0) {
+        return TC_ERROR;
+    }
+    in = AVI_open_input_file(parts[0], 1);
+    if (audio != NULL) {
+        A.in = AVI_open_input_file(audio, 1);
+    }
+    if (in == NULL || (audio != NULL && A.in == NULL)) {
+        tc_log_error(__FILE__, "cannot open chunk %s: %s",
+                     (in == NULL) ?parts[0] :audio, AVI_strerror());
+        goto failed;
+    }
+    out = AVI_open_output_file(name);
+    if (out == NULL) {
+        tc_log_error(__FILE__, "cannot open %s: %s", name, AVI_strerror());
+        goto failed;
+    }
+
+    /* all the chunks were written with the same settings */
+    AVI_set_video(out, AVI_video_width(in), AVI_video_height(in),
+                  AVI_frame_rate(in), AVI_video_compressor(in));
+    AVI_close(in);
+    A.tracks = (A.in != NULL) ?AVI_audio_tracks(A.in) :0;
+    for (t = 0; t < A.tracks; t++) {
+        AVI_set_audio_track(A.in, t);
+        AVI_set_audio_track(out, t);
+        AVI_set_audio(out, AVI_audio_channels(A.in), AVI_audio_rate(A.in),
+                      AVI_audio_bits(A.in), AVI_audio_format(A.in),
+                      AVI_audio_mp3rate(A.in));
+        AVI_set_audio_vbr(out, AVI_get_audio_vbr(A.in));
+        A.chunks[t] = AVI_audio_chunks(A.in);
+    }
+
+    for (i = 0; i < count && ret == TC_OK; i++) {
+        ret = join_avi_part(out, parts[i], &A, &frame, frames);
+    }
+    if (A.in != NULL) {
+        AVI_close(A.in);
+    }
+    /* the index is written here */
+    if (AVI_close(out) != 0 && ret == TC_OK) {
+        tc_log_error(__FILE__, "closing %s: %s", name, AVI_strerror());
+        ret = TC_ERROR;
+    }
+    return ret;
+
+  failed:
+    if (in != NULL) {
+        AVI_close(in);
+    }
+    if (A.in != NULL) {
+        AVI_close(A.in);
+    }
+    return TC_ERROR;
+}
+
+/* plain concatenation, checked against the sizes of the parts since
+ * tc_preadwrite() doesn't tell about write errors */
+static int join_concat(const char *name, char * const *parts, int count)
+{
+    struct stat st;
+    off_t total = 0;
+    int i = 0, fd = -1, in = -1, ret = TC_OK;
+
+    fd = open(name, O_WRONLY|O_CREAT|O_TRUNC,
+              S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+    if (fd < 0) {
+        tc_log_error(__FILE__, "cannot open %s: %s", name, strerror(errno));
+        return TC_ERROR;
+    }
+    for (i = 0; i < count && ret == TC_OK; i++) {
+        in = open(parts[i], O_RDONLY);
+        if (in < 0 || fstat(in, &st) != 0 || tc_preadwrite(in, fd) != 0) {
+            tc_log_error(__FILE__, "cannot copy chunk %s: %s",
+                         parts[i], strerror(errno));
+            ret = TC_ERROR;
+        } else {
+            total += st.st_size;
+        }
+        if (in >= 0) {
+            close(in);
+        }
+    }
+    if (ret == TC_OK && (fstat(fd, &st) != 0 || st.st_size != total)) {
+        tc_log_error(__FILE__, "short write on %s", name);
+        ret = TC_ERROR;
+    }
+    if (close(fd) != 0 && ret == TC_OK) {
+        tc_log_error(__FILE__, "closing %s: %s", name, strerror(errno));
+        ret = TC_ERROR;
+    }
+    return ret;
+}
+
+int tc_chunk_join(const char *mplex, const char *out,
+                  char * const *parts, int count, const char *audio)
+{
+    char name[PATH_MAX], **names = NULL, *aparts[1] = { (char *)audio };
+    char * const *from = NULL;
+    int i = 0, s = 0, n = 0, ret = TC_OK;
+
+    if (!tc_chunk_can_join(mplex) || count < 1) {
+        tc_log_error(__FILE__, "cannot join the outputs of the %s"
+                               " multiplexor", (mplex) ?mplex :"unknown");
+        return TC_ERROR;
+    }
+    if (strcmp(mplex, "null") == 0) {
+        return TC_OK;
+    }
+    if (strcmp(mplex, "avi") == 0) {
+        return join_avi(out, parts, count, audio);
+    }
+
+    names = tc_malloc(count * sizeof(*names));
+    for (s = 0; join_suffixes[s] != NULL && ret == TC_OK; s++) {
+        /* the audio stream is all in its own part */
+        if (audio != NULL
+         && strcmp(join_suffixes[s], JOIN_AUDIO_SUFFIX) == 0) {
+            from = aparts;
+            n = 1;
+        } else {
+            from = parts;
+            n = count;
+        }
+        tc_snprintf(name, sizeof(name), "%s%s", from[0], join_suffixes[s]);
+        if (access(name, F_OK) != 0) {
+            continue;   /* this multiplexor didn't write one */
+        }
+        for (i = 0; i < n; i++) {
+            names[i] = tc_malloc(PATH_MAX);
+            tc_snprintf(names[i], PATH_MAX, "%s%s",
+                        from[i], join_suffixes[s]);
+        }
+        tc_snprintf(name, sizeof(name), "%s%s", out, join_suffixes[s]);
+        ret = join_concat(name, names, n);
+        for (i = 0; i < n; i++) {
+            tc_free(names[i]);
+        }
+    }
+    tc_free(names);
+    return ret;
+}
+
+void tc_chunk_remove(const char *part)
+{
+    char name[PATH_MAX];
+    int s = 0;
+
+    for (s = 0; join_suffixes[s] != NULL; s++) {
+        tc_snprintf(name, sizeof(name), "%s%s", part, join_suffixes[s]);
+        unlink(name);
+    }
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,116 @@
+/*
+ *  chunks.h -- chunked encoding of a single input: where to cut it and
+ *              how to join the encoded pieces.
+ *
+ *  This file is part of transcode, a video stream processing tool
+ *
+ *  transcode is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  transcode is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef CHUNKS_H
+#define CHUNKS_H
+
+/*
+ * SUMMARY:
+ *
+ * The frame range to encode is cut into chunks, each one encoded on its
+ * own by a separate transcode worker; the outputs are joined back in
+ * order afterwards.  For AVI inputs the cuts are put on key frames, so a
+ * worker can seek straight to its chunk; for anything else the cuts are
+ * even and each worker decodes from the start, skipping the frames before
+ * its chunk.  Each chunk's output begins with a key frame anyway, since
+ * each one comes from a new encoder.
+ *
+ * The audio is not cut: an audio encoder adds priming at the start and
+ * padding at the end of what it encodes, and the frames of audio don't
+ * divide evenly, so the audio of the chunks put end to end would drift
+ * a little more at each join.  One more worker encodes the audio of the
+ * whole range in one go instead, and the join takes the audio from its
+ * output and the video from the chunks.
+ */
+
+typedef struct tcchunk_ TCChunk;
+struct tcchunk_ {
+    int first;  /* first frame of the chunk */
+    int last;   /* one past its last frame */
+    int offset; /* key frame to seek to before decoding, -1 if none */
+};
+
+/*
+ * tc_chunk_plan: cut the frames first..last-1 of `file' into at most
+ * `count' chunks of about the same length.
+ *
+ * Parameters:
+ *      file: input file name.
+ *     first: first frame to encode.
+ *      last: one past the last frame to encode, or TC_FRAME_LAST for
+ *            the end of the file.
+ *     count: how many chunks are wanted.
+ *    chunks: array of at least `count' chunks to fill.
+ * Return Value:
+ *     the number of chunks made (fewer than `count' if there are too few
+ *     frames or key frames), or -1 if the number of frames in the file
+ *     can't be found.
+ */
+int tc_chunk_plan(const char *file, int first, int last, int count,
+                  TCChunk *chunks);
+
+/*
+ * tc_chunk_can_join: tell if the outputs of a multiplexor can be joined.
+ *
+ * Parameters:
+ *     mplex: name of the multiplex module.
+ * Return Value:
+ *     TC_TRUE for avi, raw, ogg and null, TC_FALSE otherwise.
+ */
+int tc_chunk_can_join(const char *mplex);
+
+/*
+ * tc_chunk_join: join the outputs of the chunks into one file.
+ *     AVI files are multiplexed again, so the result has one index and
+ *     the headers count all the frames; raw streams are concatenated,
+ *     as are Ogg files, which become a chain of Ogg streams (each with
+ *     its own timestamps starting from zero, as chained streams do).
+ *     The raw multiplexor's .vid and .aud side files are joined too.
+ *     The audio, if any, comes from `audio' alone: the audio tracks of
+ *     an AVI file, or the .aud side file of raw streams.  Ogg streams
+ *     can't take their audio from elsewhere.
+ *
+ * Parameters:
+ *     mplex: name of the multiplex module which wrote the chunks.
+ *       out: name of the joined file.
+ *     parts: names of the chunk outputs, in order.
+ *     count: number of chunks.
+ *     audio: name of the output holding the audio of all the chunks,
+ *            NULL to join the chunks as they are (and drop the audio
+ *            tracks of AVI chunks).
+ * Return Value:
+ *     TC_OK on success, TC_ERROR on error (with a message logged).
+ */
+int tc_chunk_join(const char *mplex, const char *out,
+                  char * const *parts, int count, const char *audio);
+
+/*
+ * tc_chunk_remove: remove the output of a chunk, and its side files.
+ *
+ * Parameters:
+ *     part: name of the chunk output.
+ * Return Value:
+ *     None.
+ */
+void tc_chunk_remove(const char *part);
+
+#endif  /* CHUNKS_H */
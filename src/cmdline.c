@@ -11,6 +11,7 @@
 #include "transcode.h"
 #include "decoder.h"
 #include "probe.h"
+#include "frame_threads.h"
 #include "libtc/libtc.h"
 #include "libtc/ratiocodes.h"
 #include "libtc/tccodecs.h"
@@ -227,6 +227,25 @@ TC_OPTION(multi_input,     0,   0,
                 "enable EXPERIMENTAL multiple input mode (see manpage)",
                 session->core_mode = TC_MODE_DIRECTORY;
 )
+TC_OPTION(multi_jobs,         0,   "N",
+                "with --multi_input, transcode each input file to its own\n"
+                "output, N files at a time [off]",
+                session->multi_jobs = strtol(optarg, &optarg, 10);
+                if (*optarg || session->multi_jobs < 1) {
+                    tc_error("Invalid argument for --multi_jobs");
+                    goto short_usage;
+                }
+                session->core_mode = TC_MODE_DIRECTORY;
+)
+TC_OPTION(chunk_jobs,         0,   "N",
+                "encode the input in N chunks at once, cut on key frames,\n"
+                "and join them [off]",
+                session->chunk_jobs = strtol(optarg, &optarg, 10);
+                if (*optarg || session->chunk_jobs < 1) {
+                    tc_error("Invalid argument for --chunk_jobs");
+                    goto short_usage;
+                }
+)
 TC_OPTION(output,             'o', "file",
                 "output file name",
                 vob->video_out_file = optarg;
@@ -1082,6 +1101,17 @@ TC_OPTION(zoom_filter,        0,   "filter",
                     goto short_usage;
                 }
 )
+TC_OPTION(zoom_threads,       0,   "N",
+                "use N threads for -Z resizing [1]",
+                vob->zoom_threads = strtol(optarg, &optarg, 10);
+                if (*optarg
+                 || vob->zoom_threads < 1
+                 || vob->zoom_threads > TC_FRAME_THREADS_MAX
+                ) {
+                    tc_error("Invalid argument for --zoom_threads");
+                    goto short_usage;
+                }
+)
 TC_OPTION(ex_clip,            'Y', "t[,l[,b[,r]]]",
                 "clip or add frame border after filters [off]",
                 int n = sscanf(optarg, "%d,%d,%d,%d",
@@ -1443,6 +1473,52 @@ TC_OPTION(threads,            0,   "N",
                     goto short_usage;
                 }
 )
+TC_OPTION(frame_queue,        0,   "mode",
+                "select framebuffer queue backend [locked]\n"
+                "one of: locked, lockfree",
+                if (strcmp(optarg, "locked") == 0) {
+                    session->frame_queue_mode = TC_FRAME_QUEUE_LOCKED;
+                } else if (strcmp(optarg, "lockfree") == 0) {
+                    session->frame_queue_mode = TC_FRAME_QUEUE_LOCKFREE;
+                } else {
+                    tc_error("bad argument for --frame_queue, should"
+                             " be one of: locked (default), lockfree");
+                    goto short_usage;
+                }
+)
+TC_OPTION(frame_sched,        0,   "mode",
+                "select video frame scheduler [workers]\n"
+                "one of: workers, tasks",
+                if (strcmp(optarg, "workers") == 0) {
+                    session->frame_threads_mode = TC_FRAME_THREADS_WORKERS;
+                } else if (strcmp(optarg, "tasks") == 0) {
+                    session->frame_threads_mode = TC_FRAME_THREADS_TASKS;
+                } else {
+                    tc_error("bad argument for --frame_sched, should"
+                             " be one of: workers (default), tasks");
+                    goto short_usage;
+                }
+)
+TC_OPTION(slice_threads,      0,   "N",
+                "use N threads for slice-parallel filters [autodetect]",
+                session->slice_threads = strtol(optarg, &optarg, 10);
+                if (*optarg
+                 || session->slice_threads < 0
+                 || session->slice_threads > TC_FRAME_THREADS_MAX
+                ) {
+                    tc_error("Invalid argument for --slice_threads");
+                    goto short_usage;
+                }
+)
+TC_OPTION(export_pipeline,    0,   "N",
+                "encode audio, video and multiplex on separate threads,"
+                " with up to N frames in flight [0: off]",
+                session->export_pipeline = strtol(optarg, &optarg, 10);
+                if (*optarg || session->export_pipeline < 0) {
+                    tc_error("Invalid argument for --export_pipeline");
+                    goto short_usage;
+                }
+)
 TC_OPTION(progress_meter,     0,   "N",
                 "select type of progress meter [1]",
                 session->progress_meter = strtol(optarg, &optarg, 0);
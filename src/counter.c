@@ -29,7 +29,7 @@ static int printed = 0;           /* Have we printed a line? */
 static void print_counter_line(int encoding, int frame, int first, int last,
                                double fps, double done, double timestamp,
                                int secleft, int decodebuf, int filterbuf,
-                               int encodebuf);
+                               int encodebuf, unsigned long copied);
 
 /*************************************************************************/
 /*************************************************************************/
@@ -124,6 +124,32 @@ void counter_reset_ranges(void)
 
 /*************************************************************************/
 
+/**
+ * copied_per_frame:  Helper function to compute how much frame payload
+ * was copied around, per frame, since the last call.
+ *
+ * Parameters:
+ *     frame: Current frame being encoded or skipped.
+ * Return value:
+ *     Average number of bytes copied per frame.
+ */
+
+static unsigned long copied_per_frame(int frame)
+{
+    /* Values during last call (-1 = not called yet) */
+    static unsigned long old_copied = 0;
+    static int old_frame = -1;
+    unsigned long copied = tc_framebuffer_get_copied(), ret = 0;
+
+    if (old_frame >= 0 && frame > old_frame)
+        ret = (copied - old_copied) / (frame - old_frame);
+    old_copied = copied;
+    old_frame = frame;
+    return ret;
+}
+
+/*************************************************************************/
+
 /**
  * counter_print:  Display the progress counter, if active.
  *
@@ -145,6 +171,7 @@ void counter_print(int encoding, int frame, int first, int last)
     struct timezone dummy_tz = {0,0};
     double now, timediff, fps, time;
     int buf_im, buf_fl, buf_ex;
+    unsigned long copied;
     /* Values of 'first' and `last' during last call (-1 = not called yet) */
     static int old_first = -1, old_last = -1;
     /* Time of first call for this range */
@@ -213,20 +240,21 @@ void counter_print(int encoding, int frame, int first, int last)
     }
 
     tc_framebuffer_get_counters(&buf_im, &buf_fl, &buf_ex);
+    copied = copied_per_frame(frame);
 
     time = (double)frame / ((vob->ex_fps<1.0) ? 1.0 : vob->ex_fps);
 
     if (last == -1) {
         /* Can't calculate ETA, just display current timestamp */
         print_counter_line(encoding, frame, first, -1, fps, -1, time, -1,
-                           buf_im, buf_fl, buf_ex);
+                           buf_im, buf_fl, buf_ex, copied);
 
     } else if (frames_to_encode == 0) {
         /* Total number of frames unknown, just display for current range */
         double done = (double)(frame - first + 1) / (double)(last+1 - first);
         int secleft = fps>0 ? ((last+1)-frame) / fps : -1;
         print_counter_line(encoding, frame, first, last, fps, done, time,
-                           secleft, buf_im, buf_fl, buf_ex);
+                           secleft, buf_im, buf_fl, buf_ex, copied);
 
     } else {
         /* Estimate time remaining for entire run */
@@ -277,7 +305,7 @@ void counter_print(int encoding, int frame, int first, int last)
         done = (double)(encoded_frames + skipped_frames)
              / (double)(frames_to_encode + frames_to_skip);
         print_counter_line(encoding, frame, 0, highest_frame, fps, done,
-                           time, secleft, buf_im, buf_fl, buf_ex);
+                           time, secleft, buf_im, buf_fl, buf_ex, copied);
     }
 
     fflush(stdout);
@@ -303,6 +331,7 @@ void counter_print(int encoding, int frame, int first, int last)
  *     decodebuf: Number of buffered frames awaiting decoding.
  *     filterbuf: Number of buffered frames awaiting filtering.
  *     encodebuf: Number of buffered frames awaiting encoding.
+ *        copied: Frame payload bytes copied per frame, lately.
  * Return value:
  *     None.
  */
@@ -310,25 +339,27 @@ void counter_print(int encoding, int frame, int first, int last)
 static void print_counter_line(int encoding, int frame, int first, int last,
                                double fps, double done, double timestamp,
                                int secleft, int decodebuf, int filterbuf,
-                               int encodebuf)
+                               int encodebuf, unsigned long copied)
 {
     TCSession *session = tc_get_session();
     if (session->progress_meter == 2) {
         /* Raw data format */
         printf("encoding=%d frame=%d first=%d last=%d fps=%.3f done=%.6f"
                " timestamp=%.3f timeleft=%d decodebuf=%d filterbuf=%d"
-               " encodebuf=%d\n",
+               " encodebuf=%d copied=%lu\n",
                encoding, frame, first, last, fps, done,
-               timestamp, secleft, decodebuf, filterbuf, encodebuf);
+               timestamp, secleft, decodebuf, filterbuf, encodebuf,
+               copied);
     } else if (last < 0 || done < 0 || secleft < 0) {
         int timeint = floor(timestamp);
         fprintf(stderr, "%s frames [%d-%d], %6.2f fps, CFT: %d:%02d:%02d,"
-                        "  (%2d|%2d|%2d) \r",
+                        "  (%2d|%2d|%2d), copy %lu kB/f \r",
                 encoding ? "encoding" : "skipping",
                 first, frame,
                 fps,
                 timeint/3600, (timeint/60) % 60, timeint % 60,
-                decodebuf, filterbuf, encodebuf
+                decodebuf, filterbuf, encodebuf,
+                copied / 1024
         );
     } else {
         char eta_buf[100];
@@ -339,13 +370,14 @@ static void print_counter_line(int encoding, int frame, int first, int last,
                      secleft/3600, (secleft/60) % 60, secleft % 60);
         }
         fprintf(stderr, "%s frame [%d/%d], %6.2f fps, %5.1f%%, ETA: %s,"
-                        " (%2d|%2d|%2d)  \r",
+                        " (%2d|%2d|%2d), copy %lu kB/f  \r",
                 encoding ? "encoding" : "skipping",
                 frame, last+1,
                 fps,
                 floor(1000*done)/10,  // Round down to tenths of a percent
                 eta_buf,
-                decodebuf, filterbuf, encodebuf
+                decodebuf, filterbuf, encodebuf,
+                copied / 1024
         );
     }
     printed = 1;
@@ -56,6 +56,7 @@ typedef struct tcimportdata_ TCImportData;
 struct tcimportdata_ {
     int             bytes;       /* XXX                              */
     FILE            *fd;         /* for stream import                */
+    int             pipe_size;   /* pipe already grown for this size */
     vob_t           *vob;        /* XXX                              */
     void            *im_handle;  /* import module handle             */
     long int        framecount;
@@ -78,6 +79,7 @@ static void init_imdata(TCImportData *data,
     data->vob         = vob;
     data->bytes       = bytes;
     data->fd          = NULL;
+    data->pipe_size   = 0;
     data->im_handle   = NULL;
     data->framecount  = 0;
     data->active_flag = TC_FALSE;
@@ -86,6 +88,15 @@ static void init_imdata(TCImportData *data,
     tc_thread_init(&(data->th_handle), name);
 }
 
+/* what a video frame of the ring can hold, for the import modules */
+static int video_buffer_size(void)
+{
+    const TCFrameSpecs *specs = tc_framebuffer_get_specs();
+
+    return (int)tc_video_frame_size(specs->width, specs->height,
+                                    specs->format);
+}
+
 /*************************************************************************/
 /*  Old-style compatibility support functions                            */
 /*************************************************************************/
@@ -149,30 +160,25 @@ static int check_module_caps(const transfer_t *param, int codec,
 }
 
 /*************************************************************************/
-/*                  optimized block-wise fread                           */
+/*                  whole frame reads from import pipes                  */
 /*************************************************************************/
 
-#ifdef PIPE_BUF
-#define BLOCKSIZE PIPE_BUF /* 4096 on linux-x86 */
-#else
-#define BLOCKSIZE 4096
-#endif
-
-static int mfread(uint8_t *buf, int size, int nelem, FILE *f)
+/*
+ * import_read: read a whole frame from the stream of an old-style
+ * import module. The pipe is enlarged to hold a frame first, so the
+ * frame usually crosses it with one read(2) instead of one for each
+ * PIPE_BUF bytes; each read asks for all the data still missing.
+ */
+static int import_read(TCImportData *data, uint8_t *buf, int size)
 {
-    int fd = fileno(f);
-    int n = 0, r1 = 0, r2 = 0;
-    while (n < size*nelem-BLOCKSIZE) {
-        if ( !(r1 = read(fd, &buf[n], BLOCKSIZE)))
-            return 0;
-        n += r1;
-    }
-    while (size*nelem-n) {
-        if ( !(r2 = read(fd, &buf[n], size*nelem-n)))
-            return 0;
-        n += r2;
+    int fd = fileno(data->fd);
+
+    if (size > data->pipe_size) {
+        /* just once per size, whatever the outcome */
+        tc_pipe_grow(fd, size);
+        data->pipe_size = size;
     }
-    return nelem;
+    return (tc_pread(fd, buf, size) == size) ?TC_OK :TC_ERROR;
 }
 
 /*************************************************************************/
@@ -300,6 +306,7 @@ static int tc_import_video_open(TCImportData *imdata)
     memset(&import_para, 0, sizeof(transfer_t));
 
     import_para.flag = TC_VIDEO;
+    import_para.buffer_size = video_buffer_size();
 
     ret = tcv_import(TC_IMPORT_OPEN, &import_para, imdata->vob);
     if (ret < 0) {
@@ -308,6 +315,7 @@ static int tc_import_video_open(TCImportData *imdata)
     }
 
     imdata->fd = import_para.fd;
+    imdata->pipe_size = 0;
 
     return TC_OK;
 }
@@ -329,6 +337,7 @@ static int tc_import_audio_open(TCImportData *imdata)
     }
 
     imdata->fd = import_para.fd;
+    imdata->pipe_size = 0;
 
     return TC_OK;
 }
@@ -426,8 +435,8 @@ static int video_get_frame(void *ctx, TCFrameVideo *ptr)
     int ret = TC_OK;
 
     if (data->fd != NULL) {
-        if (data->bytes && (ret = mfread(ptr->video_buf, data->bytes, 1, data->fd)) != 1)
-            ret = TC_ERROR;
+        if (data->bytes)
+            ret = import_read(data, ptr->video_buf, data->bytes);
         ptr->video_len  = data->bytes;
         ptr->video_size = data->bytes;
     } else {
@@ -437,6 +446,7 @@ static int video_get_frame(void *ctx, TCFrameVideo *ptr)
         import_para.size       = data->bytes;
         import_para.flag       = TC_VIDEO;
         import_para.attributes = ptr->attributes;
+        import_para.buffer_size = video_buffer_size();
 
         ret = tcv_import(TC_IMPORT_DECODE, &import_para, data->vob);
 
@@ -553,8 +563,8 @@ static int audio_get_frame(void *ctx, TCFrameAudio *ptr)
     int ret = TC_OK;
 
     if (data->fd != NULL) {
-        if (data->bytes && (ret = mfread(ptr->audio_buf, data->bytes, 1, data->fd)) != 1)
-            ret = TC_ERROR;
+        if (data->bytes)
+            ret = import_read(data, ptr->audio_buf, data->bytes);
         ptr->audio_len  = data->bytes;
         ptr->audio_size = data->bytes;
     } else {
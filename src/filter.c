@@ -11,6 +11,12 @@
 #include "transcode.h"
 #include "filter.h"
 
+#include "libtcmodule/tcmodule-data.h"
+#include "libtcutil/tcatomic.h"
+#include "libtcutil/tccounter.h"
+#include "libtcutil/tcthread.h"
+#include "libtcutil/tctimer.h"
+
 // temp defines during module system switchover
 //#define SUPPORT_NMS     // support NMS modules?
 #define SUPPORT_CLASSIC // support classic modules?
@@ -35,6 +41,9 @@ typedef struct FilterInstance_ {
     char name[MAX_FILTER_NAME_LEN+1]; // Filter name
     int id;                     // Unique ID value for this filter instance
     int enabled;                // Nonzero if filter is inabled
+    uint32_t flags;             // TC_MODULE_FLAG_* (parallelism, access)
+    int linked;                 // Nonzero once a snapshot may call it
+    unsigned long time_base[2]; // Time counters when the filter was added
 #ifdef SUPPORT_CLASSIC
     void *handle;               // DLL handle for old-style modules
     TCFilterOldEntryFunc entry; // Module entry point for old-style modules
@@ -45,12 +54,69 @@ typedef struct FilterInstance_ {
 } FilterInstance;
 
 
+/* One filter in a chain snapshot (see below). */
+
+typedef struct FilterLink_ {
+    int id;                     // Filter ID
+    int index;                  // filters[] index, for the time counters
+    int enabled;                // Nonzero if the filter is to be applied
+    uint32_t flags;             // TC_MODULE_FLAG_*
+#ifdef SUPPORT_CLASSIC
+    TCFilterOldEntryFunc entry; // Module entry point
+#endif
+} FilterLink;
+
+/* Snapshot of the filter chain: all the loaded filters, in the order they
+ * are applied.  Snapshots are never modified; a new one replaces the
+ * current one whenever a filter is added, removed, enabled, disabled or
+ * reconfigured.  Other threads may still be walking the old snapshot, so
+ * each one counts its users, and a replaced snapshot is kept (in the
+ * `older' list of the current one) until its last user is done with it.
+ * A filter is only closed and unloaded once no snapshot older than the
+ * current one is left, so nobody can be running it anymore. */
+
+typedef struct FilterChain_ FilterChain;
+struct FilterChain_ {
+    FilterChain *older;         // Replaced snapshots still in use
+    int users;                  // Threads walking this snapshot
+    int generation;             // See tc_filter_chain_generation()
+    int count;                  // Number of entries in links[]
+    FilterLink links[MAX_FILTERS];
+};
+
+
 /* Flag: are we initialized? */
 static int initialized = 0;
 
 /* Filter instance table. */
 static FilterInstance filters[MAX_FILTERS];
 
+/* Current filter chain snapshot, lock for replacing it and for freeing
+ * the replaced ones, and condition signaled when one of those goes away.
+ * Walking the chain takes no lock where atomics are available: a thread
+ * bumps chain_entering while it picks the current snapshot and counts
+ * itself as a user, and replaced snapshots are not freed meanwhile. */
+static FilterChain *chain = NULL;
+static TCMutex chain_lock;
+static TCCondition chain_released;
+static int chain_entering = 0;  // Threads between loading and counting
+static int chain_retired = 0;   // Replaced snapshots not freed yet
+static int chain_generation = 0;
+
+#ifdef TC_HAVE_ATOMICS
+# define CHAIN_LOAD(P)      tc_atomic_load(P)
+# define CHAIN_STORE(P, V)  tc_atomic_store((P), (V))
+#else
+/* every access is made under chain_lock then */
+# define CHAIN_LOAD(P)      (*(P))
+# define CHAIN_STORE(P, V)  (*(P) = (V))
+#endif
+
+/* Number of calls (2*index) and microseconds spent (2*index+1) by each
+ * filters[] entry; time_base[] holds the values when the filter was
+ * added. */
+static TCCounterSet *filter_times = NULL;
+
 
 /* Macro to check that tc_filter_init() has been called, and abort the
  * function otherwise.  Pass the appropriate return value (nothing for a
@@ -95,6 +161,208 @@ static int id_to_index(int id, const char *func)
     return i;
 }
 
+/*************************************************************************/
+
+/**
+ * chain_reclaim:  Local helper function to free the replaced snapshots
+ * nobody is walking anymore.  Must be called with chain_lock held.
+ *
+ * Parameters:
+ *     None.
+ * Return value:
+ *     None.
+ */
+
+static void chain_reclaim(void)
+{
+    FilterChain **prev = &chain->older;
+    int freed = 0;
+
+#ifdef TC_HAVE_ATOMICS
+    /* Somebody may have loaded a replaced snapshot without counting
+     * itself yet; it will call us again from chain_put(). */
+    tc_atomic_fence();
+    if (tc_atomic_load(&chain_entering) != 0)
+        return;
+#endif
+    while (*prev) {
+        FilterChain *old = *prev;
+        if (CHAIN_LOAD(&old->users) == 0) {
+            *prev = old->older;
+            free(old);
+            freed++;
+        } else {
+            prev = &old->older;
+        }
+    }
+    if (freed) {
+        CHAIN_STORE(&chain_retired, chain_retired - freed);
+        tc_condition_broadcast(&chain_released);
+    }
+}
+
+/*************************************************************************/
+
+/**
+ * chain_get:  Local helper function to return the current filter chain
+ * snapshot, which stays valid (and the filters it calls loaded) until
+ * chain_put() is called on it.
+ *
+ * Parameters:
+ *     None.
+ * Return value:
+ *     The current filter chain snapshot.
+ */
+
+static const FilterChain *chain_get(void)
+{
+    FilterChain *current;
+
+#ifdef TC_HAVE_ATOMICS
+    tc_atomic_inc(&chain_entering);
+    current = tc_atomic_load(&chain);
+    tc_atomic_inc(&current->users);
+    tc_atomic_dec(&chain_entering);
+#else
+    tc_mutex_lock(&chain_lock);
+    current = chain;
+    current->users++;
+    tc_mutex_unlock(&chain_lock);
+#endif
+    return current;
+}
+
+/*************************************************************************/
+
+/**
+ * chain_put:  Local helper function to release a snapshot returned by
+ * chain_get().
+ *
+ * Parameters:
+ *     current: The snapshot to release.
+ * Return value:
+ *     None.
+ */
+
+static void chain_put(const FilterChain *current)
+{
+#ifdef TC_HAVE_ATOMICS
+    tc_atomic_dec(&((FilterChain *)current)->users);
+    /* Only while the chain is changing */
+    if (tc_atomic_load(&chain_retired) > 0) {
+        tc_mutex_lock(&chain_lock);
+        chain_reclaim();
+        tc_mutex_unlock(&chain_lock);
+    }
+#else
+    tc_mutex_lock(&chain_lock);
+    ((FilterChain *)current)->users--;
+    if (current != chain && current->users == 0)
+        chain_reclaim();
+    tc_mutex_unlock(&chain_lock);
+#endif
+}
+
+/*************************************************************************/
+
+/**
+ * chain_wait_older:  Local helper function to wait until every snapshot
+ * older than the current one is gone.  Must not be called while walking
+ * a snapshot, or it would wait forever.
+ *
+ * Parameters:
+ *     None.
+ * Return value:
+ *     None.
+ */
+
+static void chain_wait_older(void)
+{
+    tc_mutex_lock(&chain_lock);
+    chain_reclaim();
+    while (chain->older)
+        tc_condition_wait(&chain_released, &chain_lock);
+    tc_mutex_unlock(&chain_lock);
+}
+
+/*************************************************************************/
+
+/**
+ * chain_rebuild:  Local helper function to build a new filter chain
+ * snapshot from the filters[] table and make it the current one.  Must
+ * be called after every change to the table.
+ *
+ * Parameters:
+ *     None.
+ * Return value:
+ *     Nonzero on success, zero on failure (out of memory: the current
+ *     snapshot is left in place).
+ */
+
+static int chain_rebuild(void)
+{
+    FilterChain *new_chain;
+    int last_id;
+
+    new_chain = tc_zalloc(sizeof(*new_chain));
+    if (!new_chain) {
+        tc_log_error(__FILE__, "Out of memory rebuilding the filter chain");
+        return 0;
+    }
+
+    /* The order of the filters is given by their ID values--however, this
+     * does not necessarily match the order in the filters[] array.  We
+     * keep track of the last ID stored (starting at 0, lower than any
+     * valid ID), then each time through the loop, search for the lowest ID
+     * greater than that value, which will be the next filter to store.
+     * The loop ends when no filter has an ID greater than the last ID
+     * stored. */
+    last_id = 0;
+    for (;;) {
+        FilterLink *link;
+        int next_filter = -1, i;
+
+        for (i = 0; i < MAX_FILTERS; i++) {
+            if (filters[i].id <= last_id)
+                continue;
+            if (next_filter < 0 || filters[i].id < filters[next_filter].id)
+                next_filter = i;
+        }
+        if (next_filter < 0)
+            break;
+        last_id = filters[next_filter].id;
+
+        link = &new_chain->links[new_chain->count++];
+        link->id      = last_id;
+        link->index   = next_filter;
+        link->enabled = filters[next_filter].enabled;
+        link->flags   = filters[next_filter].flags;
+        if (link->enabled)
+            filters[next_filter].linked = 1;
+#ifdef SUPPORT_CLASSIC
+        link->entry   = filters[next_filter].entry;
+        if (link->enabled && !link->entry) {
+            tc_log_warn(__FILE__, "Filter %s (%d) missing entry function"
+                        " (bug?), disabling", filters[next_filter].name,
+                        last_id);
+            filters[next_filter].enabled = 0;
+            link->enabled = 0;
+        }
+#endif
+    }
+
+    tc_mutex_lock(&chain_lock);
+    new_chain->older = chain;
+    new_chain->generation = chain ? chain->generation + 1 : 0;
+    if (chain)
+        CHAIN_STORE(&chain_retired, chain_retired + 1);
+    CHAIN_STORE(&chain_generation, new_chain->generation);
+    CHAIN_STORE(&chain, new_chain);
+    chain_reclaim();
+    tc_mutex_unlock(&chain_lock);
+    return 1;
+}
+
 /*************************************************************************/
 /*************************************************************************/
 
@@ -117,6 +385,12 @@ int tc_filter_init(void)
     }
     for (i = 0; i < MAX_FILTERS; i++)
         filters[i].id = 0;
+    tc_mutex_init(&chain_lock);
+    tc_condition_init(&chain_released);
+    if (!chain_rebuild())
+        return 0;
+    /* Without it, filters just aren't timed */
+    filter_times = tc_counter_set_new(MAX_FILTERS * 2);
     initialized = 1;
     return 1;
 }
@@ -145,11 +419,77 @@ void tc_filter_fini(void)
             tc_filter_remove(filters[i].id);
     }
 
+    /* Nobody is using the filters anymore, so the snapshot can go */
+    while (chain) {
+        FilterChain *older = chain->older;
+        free(chain);
+        chain = older;
+    }
+    chain_retired = 0;
+    tc_counter_set_del(filter_times);
+    filter_times = NULL;
+
     initialized = 0;
 }
 
 /*************************************************************************/
 
+/**
+ * unshare_frame:  Make sure a filter can safely write on the given frame,
+ * which may share its payload with a clone of it (see vframe_dup()).
+ * Filters flagged TC_MODULE_FLAG_READONLY get the frame as is.
+ *
+ * Parameters:
+ *     frame: Frame about to be given to the filter.
+ *     flags: The filter's TC_MODULE_FLAG_* flags.
+ * Return value:
+ *     None.
+ */
+
+static void unshare_frame(frame_list_t *frame, uint32_t flags)
+{
+    if (flags & TC_MODULE_FLAG_READONLY)
+        return;
+    if (frame->tag & TC_VIDEO)
+        vframe_unshare((TCFrameVideo *)frame);
+    else if (frame->tag & TC_AUDIO)
+        aframe_unshare((TCFrameAudio *)frame);
+}
+
+/*************************************************************************/
+
+/**
+ * run_filter:  Sends the given frame to a single filter of a chain
+ * snapshot, and accounts for the time the filter took.
+ *
+ * Parameters:
+ *      link: Chain entry of the filter.
+ *     frame: Frame to process.
+ * Return value:
+ *     None.
+ */
+
+static void run_filter(const FilterLink *link, frame_list_t *frame)
+{
+    uint64_t start = tc_gettime(), end;
+
+#ifdef SUPPORT_NMS
+# error please write NMS support code
+#endif
+
+#ifdef SUPPORT_CLASSIC
+    unshare_frame(frame, link->flags);
+    frame->filter_id = link->id;
+    link->entry(frame, NULL);
+#endif
+
+    end = tc_gettime();
+    tc_counter_add2(filter_times, link->index * 2, 1, link->index * 2 + 1,
+                    (end > start) ? (unsigned long)(end - start) : 0);
+}
+
+/*************************************************************************/
+
 /**
  * tc_filter_process:  Sends the given frame to all enabled filters for
  * processing.
@@ -164,7 +504,8 @@ void tc_filter_fini(void)
 
 void tc_filter_process(frame_list_t *frame)
 {
-    int last_id;
+    const FilterChain *current;
+    int i;
 
     CHECK_INITIALIZED();
     if (!frame) {
@@ -172,43 +513,115 @@ void tc_filter_process(frame_list_t *frame)
         return;
     }
 
-    /* The order of the filters is given by their ID values--however, this
-     * does not necessarily match the order in the filters[] array.  We
-     * keep track of the last ID processed (starting at 0, lower than any
-     * valid ID), then each time through the loop, search for the lowest ID
-     * greater than that value, which will be the next filter to process.
-     * The loop ends when no enabled filter has an ID greater than the last
-     * ID processed. */
+    /* The snapshot stays valid even if the chain changes meanwhile */
+    current = chain_get();
+    for (i = 0; i < current->count; i++) {
+        if (current->links[i].enabled)
+            run_filter(&current->links[i], frame);
+    }
+    chain_put(current);
+}
 
-    last_id = 0;
-    for (;;) {
-        int next_filter = -1, i;
+/*************************************************************************/
 
-        for (i = 0; i < MAX_FILTERS; i++) {
-            if (filters[i].id <= last_id || !filters[i].enabled)
-                continue;
-            if (next_filter < 0 || filters[i].id < filters[next_filter].id)
-                next_filter = i;
-        }
-        if (next_filter < 0)
-            break;
-        last_id = filters[next_filter].id;
+/**
+ * tc_filter_process_one:  Sends the given frame to a single filter, if
+ * that filter is still loaded and enabled.  Used by the task scheduler,
+ * which walks the filter chain itself (see tc_filter_get_chain()).
+ *
+ * Parameters:
+ *     frame: Frame to process.
+ *        id: ID of filter to use.
+ * Return value:
+ *     None.
+ * Prerequisites:
+ *     frame->tag is set to an appropriate value
+ */
 
-#ifdef SUPPORT_NMS
-# error please write NMS support code
-#endif
+void tc_filter_process_one(frame_list_t *frame, int id)
+{
+    const FilterChain *current;
+    int i;
 
-#ifdef SUPPORT_CLASSIC
-        if (!filters[next_filter].entry) {
-            tc_log_warn(__FILE__, "Filter %s (%d) missing entry function"
-                        " (bug?), disabling", filters[i].name, last_id);
-            filters[next_filter].enabled = 0;
-            continue;
+    CHECK_INITIALIZED();
+    if (!frame) {
+        tc_log_warn(__FILE__, "tc_filter_process_one: frame is NULL!");
+        return;
+    }
+
+    /* A filter which went away in the meantime is not an error here:
+     * the caller's chain may be slightly out of date. */
+    current = chain_get();
+    for (i = 0; i < current->count; i++) {
+        if (current->links[i].id == id) {
+            if (current->links[i].enabled)
+                run_filter(&current->links[i], frame);
+            break;
         }
-        frame->filter_id = last_id;
-        filters[next_filter].entry(frame, NULL);
+    }
+    chain_put(current);
+}
+
+/*************************************************************************/
+
+/**
+ * tc_filter_get_chain:  Return the IDs and the TC_MODULE_FLAG_* flags of
+ * all loaded filters (enabled or not), in the order they are applied.
+ * Filters not declaring TC_MODULE_FLAG_FRAME_PARALLEL are always
+ * reported with TC_MODULE_FLAG_SEQUENTIAL set.
+ *
+ * Parameters:
+ *         stages: Array to fill.
+ *            max: Number of entries in `stages'.
+ *     generation: If not NULL, receives the current chain generation;
+ *                 see tc_filter_chain_generation().
+ * Return value:
+ *     Number of entries stored in `stages'.
+ */
+
+int tc_filter_get_chain(TCFilterStage *stages, int max, int *generation)
+{
+    const FilterChain *current;
+    int n;
+
+    CHECK_INITIALIZED(0);
+    current = chain_get();
+    if (generation)
+        *generation = current->generation;
+    for (n = 0; n < current->count && n < max; n++) {
+        stages[n].id    = current->links[n].id;
+        stages[n].flags = current->links[n].flags;
+    }
+    chain_put(current);
+    return n;
+}
+
+/*************************************************************************/
+
+/**
+ * tc_filter_chain_generation:  Return a counter which changes each time
+ * the filter chain changes (a filter is added, removed, enabled, disabled
+ * or reconfigured).
+ *
+ * Parameters:
+ *     None.
+ * Return value:
+ *     The current chain generation.
+ */
+
+int tc_filter_chain_generation(void)
+{
+    int generation;
+
+    CHECK_INITIALIZED(0);
+#ifdef TC_HAVE_ATOMICS
+    generation = tc_atomic_load(&chain_generation);
+#else
+    tc_mutex_lock(&chain_lock);
+    generation = chain_generation;
+    tc_mutex_unlock(&chain_lock);
 #endif
-    }  // for (;;)
+    return generation;
 }
 
 /*************************************************************************/
@@ -302,6 +715,29 @@ int tc_filter_add(const char *name, const char *options)
             return 0;
         }
         filters[i].id = id;  /* loaded, at least */
+
+        /* Modules built for the new module system also carry their
+         * parallelism hints; classic ones may declare them with
+         * TC_FILTER_DECLARE_FLAGS, and are assumed sequential anyway. */
+        filters[i].flags = TC_MODULE_FLAG_NONE;
+        {
+            const TCModuleClass *(*setup)(void);
+            const uint32_t *oldflags;
+            setup = dlsym(filters[i].handle, "tc_plugin_setup");
+            if (setup) {
+                const TCModuleClass *klass = setup();
+                if (klass && klass->info)
+                    filters[i].flags = klass->info->flags;
+            } else {
+                oldflags = dlsym(filters[i].handle, "tc_filter_flags");
+                if (oldflags)
+                    filters[i].flags = *oldflags;
+            }
+        }
+        if (!(filters[i].flags & TC_MODULE_FLAG_FRAME_PARALLEL))
+            filters[i].flags |= TC_MODULE_FLAG_SEQUENTIAL;
+        filters[i].time_base[0] = tc_counter_get(filter_times, i * 2);
+        filters[i].time_base[1] = tc_counter_get(filter_times, i * 2 + 1);
         if (verbose >= TC_DEBUG)
             tc_log_msg(__FILE__, "tc_filter_add: module %s loaded", path);
 
@@ -314,6 +750,7 @@ int tc_filter_add(const char *name, const char *options)
         if (filters[i].entry(&dummy_frame, (char *)options) < 0) {
             tc_warn("Initialization of filter %s failed, skipping.", name);
             tc_filter_remove(id);
+            return 0;
         }
         if (verbose >= TC_DEBUG)
             tc_log_msg(__FILE__, "tc_filter_add: filter %s successfully"
@@ -323,7 +760,8 @@ int tc_filter_add(const char *name, const char *options)
 
     /* Module was successfully loaded and initialized, so enable it */
     filters[i].enabled = 1;
-    return 1;
+    chain_rebuild();
+    return id;
 }
 
 /*************************************************************************/
@@ -353,7 +791,9 @@ int tc_filter_find(const char *name)
 /*************************************************************************/
 
 /**
- * tc_filter_remove:  Remove the given filter.
+ * tc_filter_remove:  Remove the given filter.  Waits for the threads
+ * still running it to be done; so it must not be called by a filter
+ * while processing a frame.
  *
  * Parameters:
  *     id: ID of filter to remove.
@@ -369,6 +809,21 @@ void tc_filter_remove(int id)
     if ((i = id_to_index(id, __FUNCTION__)) < 0)
         return;
 
+    /* Take the filter out of the chain, and wait for the threads still
+     * walking an older snapshot to be done with it, before closing it */
+    if (filters[i].enabled) {
+        filters[i].enabled = 0;
+        if (!chain_rebuild()) {
+            tc_log_warn(__FILE__, "Filter %s (%d) still in use, not"
+                        " removed", filters[i].name, id);
+            return;
+        }
+    }
+    if (filters[i].linked) {
+        chain_wait_older();
+        filters[i].linked = 0;
+    }
+
 #ifdef SUPPORT_NMS
 # error please write NMS support code
 #endif
@@ -393,6 +848,8 @@ void tc_filter_remove(int id)
     memset(filters[i].name, 0, sizeof(filters[i].name));
     filters[i].id = 0;
     filters[i].enabled = 0;
+    filters[i].flags = 0;
+    chain_rebuild();
 }
 
 /*************************************************************************/
@@ -415,7 +872,7 @@ int tc_filter_enable(int id)
     if (i < 0)
         return 0;
     filters[i].enabled = 1;
-    return 1;
+    return chain_rebuild();
 }
 
 /*************************************************************************/
@@ -438,7 +895,7 @@ int tc_filter_disable(int id)
     if (i < 0)
         return 0;
     filters[i].enabled = 0;
-    return 1;
+    return chain_rebuild();
 }
 
 /*************************************************************************/
@@ -474,6 +931,7 @@ int tc_filter_configure(int id, const char *options)
             tc_log_warn(__FILE__, "Filter %s (%d) missing entry function"
                         " (bug?), disabling", filters[i].name, id);
             filters[i].enabled = 0;
+            chain_rebuild();
             return 0;
         }
         /* Old filter API does a close before reconfiguring */
@@ -488,9 +946,10 @@ int tc_filter_configure(int id, const char *options)
             tc_log_warn(PACKAGE, "Reconfiguration of filter %s failed,"
                         " disabling.", filters[i].name);
             filters[i].enabled = 0;
+            chain_rebuild();
             return 0;
         }
-        return 1;
+        return chain_rebuild();
     }
 #endif
 }
@@ -538,6 +997,7 @@ const char *tc_filter_get_conf(int id, const char *option)
             tc_log_warn(__FILE__, "Filter %s (%d) missing entry function"
                         " (bug?), disabling", filters[i].name, id);
             filters[i].enabled = 0;
+            chain_rebuild();
         }
         return NULL;
     }
@@ -550,6 +1010,8 @@ const char *tc_filter_get_conf(int id, const char *option)
  * tc_filter_list:  Return a list of filters according to the given
  * parameter.  The list is comma-space separated, with each name enclosed
  * in double quotes; filters are listed in the same order they are applied.
+ * For TC_FILTER_LIST_TIMES, all loaded filters are listed one per line,
+ * with the number of calls and the time spent in each one.
  *
  * Parameters:
  *     what: Selects what kind of modules to list (TC_FILTER_LIST_*).
@@ -559,34 +1021,39 @@ const char *tc_filter_get_conf(int id, const char *option)
 
 const char *tc_filter_list(enum tc_filter_list_enum what)
 {
-    static char buf[MAX_FILTERS * (MAX_FILTER_NAME_LEN+4)];
-    int last_id;
+    static char buf[MAX_FILTERS * (MAX_FILTER_NAME_LEN+80)];
+    const FilterChain *current;
+    int i, n = 0;
 
     *buf = 0;
     CHECK_INITIALIZED(buf);
 
-    /* Use the same logic as in tc_filter_process() to retrieve the filters
-     * in ID order. */
-    last_id = 0;
-    for (;;) {
-        int next_filter = -1, i;
+    current = chain_get();
+    for (i = 0; i < current->count; i++) {
+        const FilterLink *link = &current->links[i];
+        const FilterInstance *filter = &filters[link->index];
 
-        for (i = 0; i < MAX_FILTERS; i++) {
-            if (filters[i].id <= last_id)
-                continue;
-            if (what == TC_FILTER_LIST_ENABLED && !filters[i].enabled)
-                continue;
-            if (what == TC_FILTER_LIST_DISABLED && filters[i].enabled)
-                continue;
-            if (next_filter < 0 || filters[i].id < filters[next_filter].id)
-                next_filter = i;
+        if (what == TC_FILTER_LIST_ENABLED && !link->enabled)
+            continue;
+        if (what == TC_FILTER_LIST_DISABLED && link->enabled)
+            continue;
+        if (what == TC_FILTER_LIST_TIMES) {
+            unsigned long calls, usecs;
+            calls = tc_counter_get(filter_times, link->index * 2)
+                    - filter->time_base[0];
+            usecs = tc_counter_get(filter_times, link->index * 2 + 1)
+                    - filter->time_base[1];
+            tc_snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf),
+                        "\"%s\" (%d): %lu calls, %.1f ms, %.1f us/call\n",
+                        filter->name, link->id, calls, usecs / 1000.0,
+                        calls ? (double)usecs / calls : 0.0);
+        } else {
+            tc_snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf),
+                        "%s\"%s\"", n == 0 ? "" : ", ", filter->name);
         }
-        if (next_filter < 0)
-            break;
-        last_id = filters[next_filter].id;
-        tc_snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), "%s\"%s\"",
-                    last_id==0 ? "" : ", ", filters[next_filter].name);
+        n++;
     }
+    chain_put(current);
     return buf;
 }
 
@@ -26,13 +26,25 @@ enum tc_filter_list_enum {
     TC_FILTER_LIST_LOADED,
     TC_FILTER_LIST_ENABLED,
     TC_FILTER_LIST_DISABLED,
+    TC_FILTER_LIST_TIMES,       // loaded filters, with the time spent
 };
 
 
+/* One entry of the filter chain, as returned by tc_filter_get_chain(). */
+typedef struct tcfilterstage_ {
+    int id;             // Filter ID
+    uint32_t flags;     // TC_MODULE_FLAG_* parallelism/access hints
+} TCFilterStage;
+
+
 /* Filter interface functions. */
 extern int tc_filter_init(void);
 extern void tc_filter_fini(void);
 extern void tc_filter_process(frame_list_t *frame);
+extern void tc_filter_process_one(frame_list_t *frame, int id);
+extern int tc_filter_get_chain(TCFilterStage *stages, int max,
+                               int *generation);
+extern int tc_filter_chain_generation(void);
 extern int tc_filter_add(const char *name, const char *options);
 extern int tc_filter_find(const char *name);
 extern void tc_filter_remove(int id);
@@ -47,6 +59,13 @@ extern const char *tc_filter_list(enum tc_filter_list_enum what);
 typedef int (*TCFilterOldEntryFunc)(void *ptr, char *options);
 extern int tc_filter(frame_list_t *ptr, char *options);
 
+/* Old-style modules can still declare TC_MODULE_FLAG_* hints
+ * by placing this macro at file scope, e.g.
+ *     TC_FILTER_DECLARE_FLAGS(TC_MODULE_FLAG_SLICE_PARALLEL);
+ */
+#define TC_FILTER_DECLARE_FLAGS(FLAGS) \
+    const uint32_t tc_filter_flags = (FLAGS)
+
 /*************************************************************************/
 
 #endif  /* FILTER_H */
@@ -26,6 +26,8 @@
 
 
 #include "libtcutil/tcthread.h"
+#include "libtcutil/tctaskpool.h"
+#include "libtcmodule/tcmodule-info.h"
 #include "tccore/runcontrol.h"
 
 #include "transcode.h"
@@ -43,6 +45,7 @@ typedef struct tcframethreaddata_ TCFrameThreadData;
 struct tcframethreaddata_ {
     TCThread     threads[TC_FRAME_THREADS_MAX]; /* thread pool        */
     int          count;                         /* how many workers?  */
+    int          mode;                          /* TC_FRAME_THREADS_* */
 
     TCMutex      lock;
     volatile int running;                       /* POOL running flag  */
@@ -283,6 +286,340 @@ static int process_audio_frame(TCThreadData *td, void *_vob)
     return res;
 }
 
+/*************************************************************************/
+/*         work-stealing video frame scheduler                           */
+/*************************************************************************/
+
+/*
+ * In TC_FRAME_THREADS_TASKS mode a single feeder thread reserves the
+ * video frames and turns each one into a task which walks the filter
+ * chain one stage at a time; after each stage the task queues itself
+ * again, so an idle worker can pick it up while the current one moves
+ * to another frame. Frame-parallel filters run on any number of frames
+ * at once. Every other filter is guarded by a gate which lets frames
+ * through one at a time, in the order the feeder reserved them: frames
+ * arriving early are parked into the gate and requeued by the frame
+ * leaving it.
+ *
+ * Frames dropped halfway still walk the remaining gates (without
+ * calling the filters) so the gates never wait for a frame which
+ * is not coming.
+ */
+
+/* the filter phases come first: they index the gates */
+enum {
+    TC_TASK_PHASE_PRE = 0,  /* pre-processing filters   */
+    TC_TASK_PHASE_POST,     /* post-processing filters  */
+    TC_TASK_PHASE_CORE,     /* internal processing      */
+    TC_TASK_PHASE_DONE,
+};
+
+#define TC_TASK_GATE_PHASES     2
+
+typedef struct tcframetask_ TCFrameTask;
+struct tcframetask_ {
+    TCFrameVideo    *ptr;
+    int             seq;    /* reservation order, for the gates */
+    int             phase;
+    int             stage;  /* next position in the filter chain */
+    int             skip;   /* frame dropped, just walk the gates */
+    TCFrameTask     *next;  /* link for the gate waiting list */
+};
+
+typedef struct tcfiltergate_ TCFilterGate;
+struct tcfiltergate_ {
+    TCMutex         lock;
+    int             next_seq;
+    TCFrameTask     *waiting;
+};
+
+typedef struct tcframesched_ TCFrameSched;
+struct tcframesched_ {
+    TCTaskPool      *pool;
+    TCThread        feeder;
+    vob_t           *vob;
+
+    /* filter chain snapshot, changed only when no frame is in flight */
+    TCFilterStage   chain[MAX_FILTERS];
+    int             chain_len;
+    int             chain_gen;
+    TCFilterGate    gates[TC_TASK_GATE_PHASES][MAX_FILTERS];
+
+    int             seq;        /* next frame sequence number */
+
+    TCMutex         lock;
+    TCCondition     drained;
+    int             inflight;   /* frames handed to the pool */
+};
+
+static TCFrameSched video_sched;
+
+
+static void sched_reset_chain(TCFrameSched *sched)
+{
+    int i = 0, j = 0;
+
+    sched->chain_len = tc_filter_get_chain(sched->chain, MAX_FILTERS,
+                                           &sched->chain_gen);
+    for (i = 0; i < TC_TASK_GATE_PHASES; i++) {
+        for (j = 0; j < MAX_FILTERS; j++) {
+            sched->gates[i][j].next_seq = sched->seq;
+            sched->gates[i][j].waiting  = NULL;
+        }
+    }
+}
+
+/* wait until all the frames dispatched so far have left the pool */
+static void sched_drain(TCFrameSched *sched)
+{
+    tc_mutex_lock(&sched->lock);
+    while (sched->inflight > 0) {
+        tc_condition_wait(&sched->drained, &sched->lock);
+    }
+    tc_mutex_unlock(&sched->lock);
+}
+
+static void sched_frame_done(TCFrameSched *sched, TCFrameTask *task)
+{
+    tc_free(task);
+
+    tc_mutex_lock(&sched->lock);
+    sched->inflight--;
+    if (sched->inflight == 0) {
+        tc_condition_broadcast(&sched->drained);
+    }
+    tc_mutex_unlock(&sched->lock);
+}
+
+/*
+ * gate_enter: let a frame in if it is its turn, park it otherwise.
+ * Return Value:
+ *     TC_TRUE if the frame can go through the gate.
+ *     TC_FALSE if the frame was parked; the task must end now.
+ */
+static int gate_enter(TCFilterGate *gate, TCFrameTask *task)
+{
+    int ret = TC_TRUE;
+
+    tc_mutex_lock(&gate->lock);
+    if (task->seq != gate->next_seq) {
+        task->next    = gate->waiting;
+        gate->waiting = task;
+        ret = TC_FALSE;
+    }
+    tc_mutex_unlock(&gate->lock);
+    return ret;
+}
+
+static void run_video_task(void *_task, int worker, void *_sched);
+
+/*
+ * task_requeue: hand a task back to the pool for its next step. If the
+ * pool can't take it (no memory to grow the deque) the step is run right
+ * here instead: dropping it would lose the frame and hang sched_drain.
+ */
+static void task_requeue(TCFrameSched *sched, TCFrameTask *task, int worker)
+{
+    if (tc_task_pool_spawn(sched->pool, worker, task) != TC_OK) {
+        run_video_task(task, worker, sched);
+    }
+}
+
+/* gate_leave: open the gate to the next frame, requeueing it if parked */
+static void gate_leave(TCFrameSched *sched, TCFilterGate *gate, int worker)
+{
+    TCFrameTask **link = NULL, *task = NULL;
+
+    tc_mutex_lock(&gate->lock);
+    gate->next_seq++;
+    for (link = &gate->waiting; *link; link = &(*link)->next) {
+        if ((*link)->seq == gate->next_seq) {
+            task  = *link;
+            *link = task->next;
+            break;
+        }
+    }
+    tc_mutex_unlock(&gate->lock);
+
+    if (task) {
+        task_requeue(sched, task, worker);
+    }
+}
+
+/* the end of a filter phase: same checks of process_video_frame */
+static void video_task_phase_end(TCFrameTask *task)
+{
+    TCFrameVideo *ptr = task->ptr;
+
+    if (task->phase == TC_TASK_PHASE_PRE) {
+        if (ptr->attributes & TC_FRAME_IS_SKIPPED) {
+            task->skip = TC_TRUE;
+        } else {
+            DUP_vptr_if_cloned(ptr);
+        }
+        task->phase = (task->skip) ?TC_TASK_PHASE_POST :TC_TASK_PHASE_CORE;
+    } else {
+        if (ptr->attributes & TC_FRAME_IS_SKIPPED) {
+            task->skip = TC_TRUE;
+        }
+        task->phase = TC_TASK_PHASE_DONE;
+    }
+    task->stage = 0;
+}
+
+static void run_video_task(void *_task, int worker, void *_sched)
+{
+    TCFrameTask *task = _task;
+    TCFrameSched *sched = _sched;
+    TCFrameVideo *ptr = task->ptr;
+    const TCFilterStage *stage = NULL;
+    TCFilterGate *gate = NULL;
+
+    switch (task->phase) {
+      case TC_TASK_PHASE_PRE:
+      case TC_TASK_PHASE_POST:
+        if (task->stage >= sched->chain_len) {
+            video_task_phase_end(task);
+            break;
+        }
+        stage = &sched->chain[task->stage];
+        if (!(stage->flags & TC_MODULE_FLAG_FRAME_PARALLEL)) {
+            gate = &sched->gates[task->phase][task->stage];
+            if (!gate_enter(gate, task)) {
+                return; /* will be requeued by gate_leave */
+            }
+        }
+        if (!task->skip) {
+            ptr->tag = TC_VIDEO | ((task->phase == TC_TASK_PHASE_PRE)
+                                   ?TC_PRE_M_PROCESS :TC_POST_M_PROCESS);
+            tc_filter_process_one((frame_list_t *)ptr, stage->id);
+        }
+        task->stage++;
+        if (gate) {
+            gate_leave(sched, gate, worker);
+        }
+        break;
+
+      case TC_TASK_PHASE_CORE:
+        ptr->tag = TC_VIDEO;
+        process_vid_frame(sched->vob, ptr);
+        task->phase = TC_TASK_PHASE_POST;
+        break;
+
+      case TC_TASK_PHASE_DONE:
+      default:
+        if (task->skip) {
+            vframe_remove(ptr);  /* release frame buffer memory */
+        } else {
+            vframe_push_next(ptr, TC_FRAME_READY);
+        }
+        sched_frame_done(sched, task);
+        return;
+    }
+
+    task_requeue(sched, task, worker);
+}
+
+static int feed_video_tasks(TCThreadData *td, void *_sched)
+{
+    TCFrameSched *sched = _sched;
+    TCFrameTask *task = NULL;
+    TCFrameVideo *ptr = NULL;
+    int res = 0;
+
+    while (!stop_requested(&video_threads)) {
+        ptr = vframe_reserve();
+        if (ptr == NULL) {
+            SET_STOP_FLAG(&video_threads, "video interrupted: exiting!");
+            res = 1;
+            break;
+        }
+        if (ptr->attributes & TC_FRAME_IS_END_OF_STREAM) {
+            SET_STOP_FLAG(&video_threads, "video stream end: marking!");
+            /* the encoder quits on the first frame marked as the end
+             * of the stream, so every older frame must be out by then */
+            sched_drain(sched);
+        }
+
+        if (ptr->attributes & TC_FRAME_IS_SKIPPED) {
+            vframe_remove(ptr);  /* release frame buffer memory */
+            continue;
+        }
+        if (!TC_FRAME_NEED_PROCESSING(ptr)) {
+            vframe_push_next(ptr, TC_FRAME_READY);
+            continue;
+        }
+
+        if (tc_filter_chain_generation() != sched->chain_gen) {
+            /* filters were (un)loaded: the gates must restart clean */
+            sched_drain(sched);
+            sched_reset_chain(sched);
+        }
+
+        task = tc_zalloc(sizeof(TCFrameTask));
+        if (task == NULL) {
+            tc_log_error(__FILE__, "can't allocate video frame task");
+            vframe_remove(ptr);
+            continue;
+        }
+        task->ptr   = ptr;
+        task->seq   = sched->seq++;
+        task->phase = TC_TASK_PHASE_PRE;
+
+        tc_mutex_lock(&sched->lock);
+        sched->inflight++;
+        tc_mutex_unlock(&sched->lock);
+
+        if (tc_task_pool_submit(sched->pool, task) != TC_OK) {
+            /* no gate has seen this frame yet, just forget it */
+            tc_log_error(__FILE__, "can't queue video frame task");
+            sched->seq--;
+            vframe_remove(ptr);
+            sched_frame_done(sched, task);
+        }
+    }
+    tc_debug(TC_DEBUG_CLEANUP, "video stream end: got, so exiting!");
+
+    return res;
+}
+
+static int video_sched_start(TCFrameSched *sched, vob_t *vob, int workers)
+{
+    int i = 0, j = 0;
+
+    sched->vob      = vob;
+    sched->seq      = 0;
+    sched->inflight = 0;
+    tc_mutex_init(&sched->lock);
+    tc_condition_init(&sched->drained);
+    for (i = 0; i < TC_TASK_GATE_PHASES; i++) {
+        for (j = 0; j < MAX_FILTERS; j++) {
+            tc_mutex_init(&sched->gates[i][j].lock);
+        }
+    }
+    sched_reset_chain(sched);
+
+    sched->pool = tc_task_pool_new(workers, run_video_task, sched, "vtask");
+    if (!sched->pool) {
+        return TC_ERROR;
+    }
+    tc_thread_init(&sched->feeder, "vfeeder");
+    return tc_thread_start(&sched->feeder, feed_video_tasks, sched);
+}
+
+static void video_sched_stop(TCFrameSched *sched)
+{
+    int ret = 0;
+
+    tc_thread_wait(&sched->feeder, &ret);
+    sched_drain(sched);
+
+    tc_debug(TC_DEBUG_CLEANUP, "video task pool: %li steals",
+             tc_task_pool_steals(sched->pool));
+    tc_task_pool_del(sched->pool);
+    sched->pool = NULL;
+}
+
 /*************************************************************************/
 
 
@@ -297,7 +634,8 @@ int tc_frame_threads_have_audio_workers(void)
 }
 
 
-void tc_frame_threads_init(vob_t *vob, int vworkers, int aworkers)
+void tc_frame_threads_init(vob_t *vob, int vworkers, int aworkers,
+                           int mode)
 {
     int n = 0;
 
@@ -305,17 +643,28 @@ void tc_frame_threads_init(vob_t *vob, int vworkers, int aworkers)
 
     if (vworkers > 0 && !video_threads.running) {
         video_threads.count   = vworkers;
+        video_threads.mode    = mode;
         video_threads.running = TC_TRUE; /* enforce, needed when restarting */
 
-        if (verbose >= TC_DEBUG)
-            tc_log_info(__FILE__, "starting %i video frame"
-                                 " processing thread(s)", vworkers);
-
-        // start the thread pool
-        for (n = 0; n < vworkers; n++) {
-            if (tc_thread_start(&(video_threads.threads[n]),
-                                process_video_frame, vob) != 0)
-                tc_error("failed to start video frame processing thread");
+        if (mode == TC_FRAME_THREADS_TASKS) {
+            if (verbose >= TC_DEBUG)
+                tc_log_info(__FILE__, "starting %i video frame"
+                                     " processing task worker(s)", vworkers);
+
+            if (video_sched_start(&video_sched, vob, vworkers) != TC_OK)
+                tc_error("failed to start video frame task scheduler");
+        } else {
+            if (verbose >= TC_DEBUG)
+                tc_log_info(__FILE__, "starting %i video frame"
+                                     " processing thread(s)", vworkers);
+
+            // start the thread pool
+            for (n = 0; n < vworkers; n++) {
+                if (tc_thread_start(&(video_threads.threads[n]),
+                                    process_video_frame, vob) != 0)
+                    tc_error("failed to start video frame"
+                             " processing thread");
+            }
         }
     }
 
@@ -362,8 +711,12 @@ void tc_frame_threads_close(void)
                      "wait for %i video frame processing threads",
                      video_threads.count);
 
-        for (n = 0; n < video_threads.count; n++)
-            tc_thread_wait(&video_threads.threads[n], &ret);
+        if (video_threads.mode == TC_FRAME_THREADS_TASKS) {
+            video_sched_stop(&video_sched);
+        } else {
+            for (n = 0; n < video_threads.count; n++)
+                tc_thread_wait(&video_threads.threads[n], &ret);
+        }
 
         tc_debug(TC_DEBUG_CLEANUP,
                      "video frame processing threads canceled");
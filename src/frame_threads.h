@@ -36,8 +36,20 @@
  * It is important to note that each thread is equivalent to each
  * other, and each one will take care of one frame and applies to
  * it the whole filter chain.
+ *
+ * Alternatively, video frames can be split into per-filter tasks,
+ * run by a work-stealing task pool (TC_FRAME_THREADS_TASKS).
+ * Filters flagged TC_MODULE_FLAG_FRAME_PARALLEL can then run on many
+ * frames at once, while all the others see one frame at a time, in
+ * order. Audio frames are always processed in the first way.
  */
 
+/* video frame processing modes */
+enum {
+    TC_FRAME_THREADS_WORKERS = 0, /* one frame, whole chain, per thread */
+    TC_FRAME_THREADS_TASKS   = 1, /* per-filter tasks, work stealing */
+};
+
 /*
  * tc_frame_threads_init: start the frame threads pool and implicitely
  * and automatically starts the frame filter layer.
@@ -46,10 +58,12 @@
  *           vob: vob structure.
  *      vworkers: number of threads in the video filter pool.
  *      aworkers: number of threads in the audio filter pool.
+ *          mode: video frame processing mode (TC_FRAME_THREADS_*).
  * Return Value:
  *      None.
  */
-void tc_frame_threads_init(vob_t *vob, int vworkers, int aworkers);
+void tc_frame_threads_init(vob_t *vob, int vworkers, int aworkers,
+                           int mode);
 
 /*
  * tc_frame_threads_close: destroy both audio and video filter pool threads,
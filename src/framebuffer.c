@@ -21,6 +21,7 @@
  */
 
 #include "libtcutil/tcthread.h"
+#include "libtcutil/tccounter.h"
 
 #include "tccore/tc_defaults.h"
 #include "tccore/runcontrol.h"
@@ -30,6 +31,8 @@
 #include "libtc/tcframes.h"
 #include "libtc/ratiocodes.h"
 
+#include <sched.h>
+
 /* unit testing needs this */
 #ifndef FBUF_TEST
 #define STATIC  static
@@ -95,6 +98,8 @@ STATIC const char *frame_status_name(TCFrameStatus S)
  * Specs used internally. I don't export this structure directly
  * because I want to be free to change it if needed
  */
+#define TC_FRAME_GEOMETRY_PAD(N)    (((N) + 15) & ~15)
+
 static TCFrameSpecs tc_specs = {
     /* Largest supported values, to ensure the buffer is always big enough
      * (see FIXME in tc_framebuffer_set_specs()) */
@@ -125,14 +130,16 @@ void tc_framebuffer_set_specs(const TCFrameSpecs *specs)
         /* raw copy first */
         ac_memcpy(&tc_specs, specs, sizeof(TCFrameSpecs));
 
-        /* restore width/height/bpp
-         * (FIXME: temp until we have a way to know the max size that will
-         *         be used through the decode/process/encode chain; without
-         *         this, -V yuv420p -y raw -F rgb (e.g.) crashes with a
-         *         buffer overrun)
+        /* 
+         * The caller gives us the largest geometry seen through the
+         * decode/process/encode chain, but not the largest format:
+         * -V yuv420p -y raw -F rgb (e.g.) converts to RGB24 in place,
+         * so we always size for the fattest format. The geometry is
+         * padded to whole macroblocks for the sake of the codecs which
+         * write a few rows/columns past the visible frame.
          */
-        tc_specs.width  = TC_MAX_V_FRAME_WIDTH;
-        tc_specs.height = TC_MAX_V_FRAME_HEIGHT;
+        tc_specs.width  = TC_FRAME_GEOMETRY_PAD(specs->width);
+        tc_specs.height = TC_FRAME_GEOMETRY_PAD(specs->height);
         tc_specs.format = TC_CODEC_RGB24;
 
         /* then deduct missing parameters */
@@ -159,21 +166,24 @@ void tc_framebuffer_set_specs(const TCFrameSpecs *specs)
 
 #define TCFRAMEPTR_IS_NULL(tcf)    (tcf.generic == NULL)
 
-static TCFramePtr tc_video_alloc(const TCFrameSpecs *specs)
+static TCFramePtr tc_video_alloc(const TCFrameSpecs *specs,
+                                 TCArena *arena)
 {
     TCFramePtr frame;
     /* NOTE: The temporary frame buffer is _required_ (hence TC_FALSE)
      *       if any video transformations (-j, -Z, etc.) are used! */
-    frame.video = tc_new_video_frame(specs->width, specs->height,
-                                      specs->format, TC_FALSE);
+    frame.video = tc_new_video_frame_arena(arena,
+                                           specs->width, specs->height,
+                                           specs->format, TC_FALSE);
     return frame;
 }
 
-static TCFramePtr tc_audio_alloc(const TCFrameSpecs *specs)
+static TCFramePtr tc_audio_alloc(const TCFrameSpecs *specs,
+                                 TCArena *arena)
 {
     TCFramePtr frame;
-    frame.audio = tc_new_audio_frame(specs->samples, specs->channels,
-                                     specs->bits);
+    frame.audio = tc_new_audio_frame_arena(arena, specs->samples,
+                                           specs->channels, specs->bits);
     return frame;
 }
 
@@ -203,6 +213,28 @@ aframe_list_t *aframe_alloc_single(void)
 
 /*************************************************************************/
 
+/*
+ * A frame queue can be either a plain FIFO or a priority queue (heap)
+ * ordered by frame id; both must be protected by an external lock.
+ *
+ * Lock-free queues are instead built on a bounded ring of cells, each
+ * one carrying its own sequence number (Vyukov-style), so any number of
+ * threads can put and get concurrently without locks.
+ * The priority flavour keeps a private heap owned by the (single!)
+ * consumer: get() first drains the ring into the heap, then pops the
+ * lowest id, so the ordering semantics are the same of a locked heap.
+ */
+
+enum {
+    TC_CACHE_LINE = 64
+};
+
+typedef struct tcframecell_ TCFrameCell;
+struct tcframecell_ {
+    unsigned long   seq;
+    TCFramePtr      ptr;
+};
+
 #ifndef FBUF_TEST
 typedef struct tcframequeue_ TCFrameQueue;
 #endif
@@ -216,11 +248,31 @@ struct tcframequeue_ {
     int         priority;
     TCFramePtr  (*get)(TCFrameQueue *Q);
     int         (*put)(TCFrameQueue *Q, TCFramePtr ptr);
+
+    /* lock-free ring only */
+    int             lockfree;
+    TCFrameCell     *cells;
+    unsigned long   mask;
+    TCFrameQueue    *heap;   /* consumer-side reordering, if priority */
+    uint8_t         pad0[TC_CACHE_LINE];
+    unsigned long   head;    /* next cell to get, consumers side */
+    uint8_t         pad1[TC_CACHE_LINE];
+    unsigned long   tail;    /* next cell to put, producers side */
+    uint8_t         pad2[TC_CACHE_LINE];
 };
 
 STATIC void tc_frame_queue_dump_status(TCFrameQueue *Q, const char *tag)
 {
     int i = 0;
+    if (Q->lockfree) {
+        tc_log_msg(FPOOL_NAME, "(%s|queue|%s) size=%i num=%i (lock-free)",
+                   tag, (Q->priority) ?"HEAP" :"FIFO", Q->size, Q->num);
+        if (Q->heap) {
+            tc_frame_queue_dump_status(Q->heap, tag);
+        }
+        return;
+    }
+
     tc_log_msg(FPOOL_NAME, "(%s|queue|%s) size=%i num=%i first=%i last=%i",
                tag, (Q->priority) ?"HEAP" :"FIFO",
                Q->size, Q->num, Q->first, Q->last);
@@ -240,17 +292,26 @@ STATIC void tc_frame_queue_dump_status(TCFrameQueue *Q, const char *tag)
 
 STATIC void tc_frame_queue_del(TCFrameQueue *Q)
 {
+    if (Q->heap) {
+        tc_frame_queue_del(Q->heap);
+    }
     tc_free(Q);
 }
 
+#ifdef TC_HAVE_ATOMICS
+# define QUEUE_NUM(Q)   (((Q)->lockfree) ?tc_atomic_load(&(Q)->num) :(Q)->num)
+#else
+# define QUEUE_NUM(Q)   ((Q)->num)
+#endif
+
 STATIC int tc_frame_queue_empty(TCFrameQueue *Q)
 {
-    return (Q->num == 0) ?TC_TRUE :TC_FALSE;
+    return (QUEUE_NUM(Q) == 0) ?TC_TRUE :TC_FALSE;
 }
 
 STATIC int tc_frame_queue_size(TCFrameQueue *Q)
 {
-    return Q->num;
+    return QUEUE_NUM(Q);
 }
 
 STATIC TCFramePtr tc_frame_queue_get(TCFrameQueue *Q)
@@ -432,6 +493,152 @@ STATIC TCFrameQueue *tc_frame_queue_new(int size, int priority)
     return Q;
 }
 
+#ifdef TC_HAVE_ATOMICS
+
+static int lfring_enqueue(TCFrameQueue *Q, TCFramePtr ptr)
+{
+    unsigned long pos = tc_atomic_load_relaxed(&Q->tail);
+    TCFrameCell *cell = NULL;
+
+    for (;;) {
+        long diff;
+        cell = &(Q->cells[pos & Q->mask]);
+        diff = (long)tc_atomic_load(&cell->seq) - (long)pos;
+
+        if (diff == 0) {
+            if (tc_atomic_cas(&Q->tail, &pos, pos + 1)) {
+                break;
+            }
+            /* lost the race: pos was reloaded by the CAS */
+        } else if (diff < 0) {
+            return 0; /* full */
+        } else {
+            pos = tc_atomic_load_relaxed(&Q->tail);
+        }
+    }
+    cell->ptr = ptr;
+    tc_atomic_store(&cell->seq, pos + 1);
+    return 1;
+}
+
+static TCFramePtr lfring_dequeue(TCFrameQueue *Q)
+{
+    TCFramePtr ptr = { .generic = NULL };
+    unsigned long pos = tc_atomic_load_relaxed(&Q->head);
+    TCFrameCell *cell = NULL;
+
+    for (;;) {
+        long diff;
+        cell = &(Q->cells[pos & Q->mask]);
+        diff = (long)tc_atomic_load(&cell->seq) - (long)(pos + 1);
+
+        if (diff == 0) {
+            if (tc_atomic_cas(&Q->head, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return ptr; /* empty */
+        } else {
+            pos = tc_atomic_load_relaxed(&Q->head);
+        }
+    }
+    ptr = cell->ptr;
+    tc_atomic_store(&cell->seq, pos + Q->mask + 1);
+    return ptr;
+}
+
+static int lfring_put(TCFrameQueue *Q, TCFramePtr ptr)
+{
+    while (!lfring_enqueue(Q, ptr)) {
+        /*
+         * the ring may look full for a short while if a consumer
+         * is still in the middle of a dequeue on the very cell we
+         * want; since a ring never holds more frames than it was
+         * sized for, just wait for it to finish.
+         */
+        if (tc_atomic_load(&Q->num) >= Q->size) {
+            /* can't happen: more frames than the ring has buffers */
+            tc_log_error(FRING_NAME, "lock-free queue overflow"
+                                     " (%i frames), frame lost", Q->size);
+            return 0;
+        }
+        sched_yield();
+    }
+    tc_atomic_inc(&Q->num);
+    return 1;
+}
+
+static TCFramePtr lfring_get(TCFrameQueue *Q)
+{
+    TCFramePtr ptr = lfring_dequeue(Q);
+    if (!TCFRAMEPTR_IS_NULL(ptr)) {
+        tc_atomic_dec(&Q->num);
+    }
+    return ptr;
+}
+
+/* MUST be called by one consumer thread at time */
+static TCFramePtr lfheap_get(TCFrameQueue *Q)
+{
+    TCFramePtr ptr = lfring_dequeue(Q);
+
+    while (!TCFRAMEPTR_IS_NULL(ptr)) {
+        heap_put(Q->heap, ptr);
+        ptr = lfring_dequeue(Q);
+    }
+    ptr = heap_get(Q->heap);
+    if (!TCFRAMEPTR_IS_NULL(ptr)) {
+        tc_atomic_dec(&Q->num);
+    }
+    return ptr;
+}
+
+STATIC TCFrameQueue *tc_frame_queue_new_lockfree(int size, int priority)
+{
+    TCFrameQueue *Q = NULL;
+    uint8_t *mem = NULL;
+    unsigned long i = 0, cap = 1;
+
+    while (cap < (unsigned long)size) {
+        cap <<= 1;
+    }
+
+    mem = tc_zalloc(sizeof(TCFrameQueue) + (sizeof(TCFrameCell) * cap));
+    if (mem) {
+        Q           = (TCFrameQueue *)mem;
+        Q->cells    = (TCFrameCell *)(mem + sizeof(TCFrameQueue));
+        Q->mask     = cap - 1;
+        Q->size     = size;
+        Q->priority = priority;
+        Q->lockfree = TC_TRUE;
+        for (i = 0; i < cap; i++) {
+            Q->cells[i].seq = i;
+        }
+        if (priority) {
+            Q->heap = tc_frame_queue_new(size, TC_TRUE);
+            if (!Q->heap) {
+                tc_free(Q);
+                return NULL;
+            }
+            Q->get  = lfheap_get;
+            Q->put  = lfring_put;
+        } else {
+            Q->get  = lfring_get;
+            Q->put  = lfring_put;
+        }
+    }
+    return Q;
+}
+
+#else /* !TC_HAVE_ATOMICS */
+
+STATIC TCFrameQueue *tc_frame_queue_new_lockfree(int size, int priority)
+{
+    return NULL;
+}
+
+#endif /* TC_HAVE_ATOMICS */
+
 /*************************************************************************/
 
 #ifndef FBUF_TEST
@@ -446,20 +653,30 @@ struct tcframepool_ {
     int          waiting;    /* how many thread blocked here? */
 
     TCFrameQueue *queue;
+
+    int          lockfree;   /* if so, lock and condition are unused */
+    TCParker     parker;
 };
 
 STATIC int tc_frame_pool_init(TCFramePool *P, int size, int priority,
+                              int lockfree,
                               const char *tag, const char *ptag)
 {
     int ret = TC_ERROR;
     if (P) {
         tc_mutex_init(&P->lock);
         tc_condition_init(&P->empty);
+        tc_parker_init(&P->parker);
 
         P->ptag     = (ptag) ?ptag :"unknown";
         P->tag      = (tag)  ?tag  :"unknown";
         P->waiting  = 0;
-        P->queue     = tc_frame_queue_new(size, priority);
+        P->lockfree = lockfree;
+        if (lockfree) {
+            P->queue = tc_frame_queue_new_lockfree(size, priority);
+        } else {
+            P->queue = tc_frame_queue_new(size, priority);
+        }
         if (P->queue) {
             ret = TC_OK;
         }
@@ -476,16 +693,101 @@ STATIC int tc_frame_pool_fini(TCFramePool *P)
     return TC_OK;
 }
 
+#ifdef FBUF_TEST
+TCFramePool *tc_frame_pool_new(int size, int priority, int lockfree,
+                               const char *tag, const char *ptag)
+{
+    TCFramePool *P = tc_zalloc(sizeof(TCFramePool));
+    if (P && tc_frame_pool_init(P, size, priority, lockfree,
+                                tag, ptag) != TC_OK) {
+        tc_free(P);
+        P = NULL;
+    }
+    return P;
+}
+
+void tc_frame_pool_del(TCFramePool *P)
+{
+    tc_frame_pool_fini(P);
+    tc_free(P);
+}
+#endif
+
 STATIC void tc_frame_pool_dump_status(TCFramePool *P)
 {
     tc_log_msg(FPOOL_NAME, "(%s|%s) waiting=%i fifo status:",
-               P->ptag, P->tag, P->waiting);
+               P->ptag, P->tag,
+               (P->lockfree) ?P->parker.waiters :P->waiting);
     tc_frame_queue_dump_status(P->queue, P->tag);
 }
 
+/*
+ * lock-free pools never block producers, and block consumers only
+ * when the queue is found empty: the parker takes care of not losing
+ * wakeups between the emptiness check and the sleep.
+ */
+
+static void tc_frame_pool_put_frame_lockfree(TCFramePool *P,
+                                             TCFramePtr ptr)
+{
+    int wakeup = tc_frame_queue_put(P->queue, ptr);
+
+    tc_debug(TC_DEBUG_FLIST,
+             "(%s|put_frame|%s|%s|0x%X) wakeup=%i (lock-free)",
+             FPOOL_NAME,
+             P->tag, P->ptag, PTHREAD_ID, wakeup);
+
+    if (wakeup) {
+        tc_parker_unpark(&P->parker, TC_FALSE);
+    }
+}
+
+static TCFramePtr tc_frame_pool_get_frame_lockfree(TCFramePool *P)
+{
+    int interrupted = TC_FALSE;
+    TCFramePtr ptr = tc_frame_queue_get(P->queue);
+
+    while (!interrupted && TCFRAMEPTR_IS_NULL(ptr)) {
+        int ticket = tc_parker_prepare(&P->parker);
+
+        ptr = tc_frame_queue_get(P->queue);
+        if (!TCFRAMEPTR_IS_NULL(ptr)) {
+            tc_parker_cancel(&P->parker);
+            break;
+        }
+
+        tc_debug(TC_DEBUG_THREADS,
+                 "(%s|get_frame|%s|%s|0x%X) parking (no frames in pool)",
+                 FPOOL_NAME,
+                 P->tag, P->ptag, PTHREAD_ID);
+
+        tc_parker_park(&P->parker, ticket);
+
+        interrupted = !tc_running();
+        if (!interrupted) {
+            ptr = tc_frame_queue_get(P->queue);
+        }
+    }
+
+    tc_debug(TC_DEBUG_FLIST,
+             "(%s|got_frame|%s|%s|0x%X) frame=%p #%i (lock-free)",
+             FPOOL_NAME,
+             P->tag, P->ptag, PTHREAD_ID,
+             ptr.generic,
+             (ptr.generic) ?ptr.generic->bufid :(-1));
+
+    return ptr;
+}
+
 STATIC void tc_frame_pool_put_frame(TCFramePool *P, TCFramePtr ptr)
 {
     int wakeup = 0;
+
+    if (P->lockfree) {
+        tc_frame_pool_put_frame_lockfree(P, ptr);
+        return;
+    }
+
     tc_mutex_lock(&P->lock);
     wakeup = tc_frame_queue_put(P->queue, ptr);
 
@@ -506,6 +808,11 @@ STATIC TCFramePtr tc_frame_pool_get_frame(TCFramePool *P)
     int interrupted = TC_FALSE;
 
     TCFramePtr ptr = { .generic = NULL };
+
+    if (P->lockfree) {
+        return tc_frame_pool_get_frame_lockfree(P);
+    }
+
     tc_mutex_lock(&P->lock);
 
     tc_debug(TC_DEBUG_FLIST,
@@ -560,6 +867,11 @@ STATIC void tc_frame_pool_push_frame(TCFramePool *P, TCFramePtr ptr)
 
 STATIC void tc_frame_pool_wakeup(TCFramePool *P, int broadcast)
 {
+    if (P->lockfree) {
+        tc_parker_unpark(&P->parker, broadcast);
+        return;
+    }
+
     tc_mutex_lock(&P->lock);
     if (broadcast) {
         tc_condition_broadcast(&P->empty);
@@ -576,7 +888,7 @@ STATIC void tc_frame_pool_wakeup(TCFramePool *P, int broadcast)
  * (avoid if()s and so on).
  *************************************************************************/
 
-typedef TCFramePtr (*TCFrameAllocFn)(const TCFrameSpecs *);
+typedef TCFramePtr (*TCFrameAllocFn)(const TCFrameSpecs *, TCArena *);
 typedef void       (*TCFrameFreeFn)(TCFramePtr);
 
 /*************************************************************************/
@@ -591,6 +903,10 @@ struct tcframering_ {
     TCFramePool         pools[TC_FRAME_STAGE_NUM];
 
     const TCFrameSpecs  *specs;  /* what we need here? */
+    TCArena             *arena;  /* where the frame buffers live */
+    size_t              frame_size; /* buffer bytes per frame */
+    TCMutex             share_lock; /* guards the payload sharing */
+    TCCondition         share_done; /* a payload copy is finished */
     /* (de)allocation helpers */
     TCFrameAllocFn      alloc;
     TCFrameFreeFn       free;
@@ -614,6 +930,9 @@ static int tc_frame_ring_get_pool_size(TCFrameRing *rfb,
 {
     int size;
     TCFramePool *P = tc_frame_ring_get_pool(rfb, S);
+    if (P->lockfree) {
+        locked = TC_FALSE; /* nothing to lock */
+    }
     if (locked) {
         tc_mutex_lock(&P->lock);
     }
@@ -670,6 +989,8 @@ static void tc_frame_ring_dump_status(TCFrameRing *rfb,
  *     specs: frame specifications to use for allocation.
  *     alloc: frame allocation function to use.
  *      free: frame disposal function to use.
+ *     bsize: size of a single frame buffer.
+ *   buffers: buffers needed by each frame.
  *      size: size of ringbuffer (number of frame to allocate)
  * Return Value:
  *      > 0: wrong (NULL) parameters
@@ -681,18 +1002,37 @@ static int tc_frame_ring_init(TCFrameRing *rfb,
                               const TCFrameSpecs *specs,
                               TCFrameAllocFn alloc,
                               TCFrameFreeFn free,
-                              int size)
+                              size_t bsize, int buffers,
+                              int size, int mode)
 {
-    int i = 0;
+    int i = 0, lockfree = (mode == TC_FRAME_QUEUE_LOCKFREE);
 
     if (rfb == NULL   || specs == NULL || size < 0
-     || alloc == NULL || free == NULL) {
+     || alloc == NULL || free == NULL || bsize == 0 || buffers <= 0) {
         return 1;
     }
     size = (size > 0) ?size :1; /* allocate at least one frame */
 
+#ifndef TC_HAVE_ATOMICS
+    if (lockfree) {
+        tc_log_warn(FRING_NAME,
+                    "(init|%s) lock-free queues not available,"
+                    " falling back to locked ones", tag);
+        lockfree = TC_FALSE;
+    }
+#endif
+
+    /* all the buffers of the ring belong to the same size class */
+    rfb->arena = tc_arena_new(bsize, size * buffers, TC_ARENA_HUGEPAGES);
+    if (rfb->arena == NULL) {
+        return -1;
+    }
+    rfb->frame_size = bsize * buffers;
+
     rfb->frames = tc_malloc(size * sizeof(TCFramePtr));
     if (rfb->frames == NULL) {
+        tc_arena_del(rfb->arena);
+        rfb->arena = NULL;
         return -1;
     }
 
@@ -701,6 +1041,8 @@ static int tc_frame_ring_init(TCFrameRing *rfb,
     rfb->specs = specs;
     rfb->alloc = alloc;
     rfb->free  = free;
+    tc_mutex_init(&rfb->share_lock);
+    tc_condition_init(&rfb->share_done);
 
     /* first, warm up the pools */
     for (i = 0; i < TC_FRAME_STAGE_NUM; i++) {
@@ -708,7 +1050,7 @@ static int tc_frame_ring_init(TCFrameRing *rfb,
         const char *name = frame_status_name(S);
 
         int err = tc_frame_pool_init(&(rfb->pools[i]), size,
-                                     (S == TC_FRAME_READY),
+                                     (S == TC_FRAME_READY), lockfree,
                                      name, tag);
         
         if (err) {
@@ -720,7 +1062,7 @@ static int tc_frame_ring_init(TCFrameRing *rfb,
 
     /* then, fillup the `NULL' pool */
     for (i = 0; i < size; i++) {
-        rfb->frames[i] = rfb->alloc(rfb->specs);
+        rfb->frames[i] = rfb->alloc(rfb->specs, rfb->arena);
         if (TCFRAMEPTR_IS_NULL(rfb->frames[i])) {
             tc_debug(TC_DEBUG_FLIST,
                      "(%s|init|%s) failed frame allocation",
@@ -776,6 +1118,8 @@ static void tc_frame_ring_fini(TCFrameRing *rfb)
             rfb->free(rfb->frames[i]);
         }
         tc_free(rfb->frames);
+        tc_arena_del(rfb->arena);
+        rfb->arena = NULL;
     }
 }
 
@@ -880,9 +1224,15 @@ static void tc_frame_ring_reinject_frame(TCFrameRing *rfb,
  */
 static int tc_frame_ring_flush(TCFrameRing *rfb)
 {
-    int i = 0, n = 0;
+    int claimed[TC_FRAME_STAGE_NUM] = { 0 };
+    int i = 0, j = 0, n = 0;
     TCFramePool *NP = tc_frame_ring_get_pool(rfb, TC_FRAME_NULL);
 
+    /*
+     * count first: the frame pulled from a pool is not necessarily
+     * the one we are looking at, so a frame seen later could already
+     * be flushed, and look free.
+     */
     for (i = 0; i < rfb->size; i++) {
         TCFrameStatus S = rfb->frames[i].generic->status;
 
@@ -892,24 +1242,29 @@ static int tc_frame_ring_flush(TCFrameRing *rfb)
                      "(%s|flush|%s) frame #%i already free (not flushed)",
                      FRING_NAME, rfb->tag, i);
         } else {
-            TCFramePool *P = tc_frame_ring_get_pool(rfb, S);
-            TCFramePtr frame;
-
             tc_debug(TC_DEBUG_CLEANUP,
                      "(%s|flush|%s) flushing frame #%i in [%s] status",
                      FRING_NAME, rfb->tag, i, frame_status_name(S));
+            claimed[TC_FRAME_STAGE_ID(S)]++;
+        }
+    }
+
+    for (i = 0; i < TC_FRAME_STAGE_NUM; i++) {
+        TCFramePool *P = &(rfb->pools[i]);
+
+        for (j = 0; j < claimed[i]; j++) {
+            TCFramePtr frame = tc_frame_pool_pull_frame(P);
 
-            frame = tc_frame_pool_pull_frame(P);
             if (TCFRAMEPTR_IS_NULL(frame)) {
                 tc_debug(TC_DEBUG_CLEANUP,
-                         "(%s|flush|%s) got NULL while flushing frame #%i",
-                         FRING_NAME, rfb->tag, i);
+                         "(%s|flush|%s) got NULL while flushing [%s]",
+                         FRING_NAME, rfb->tag, frame_stages[i].name);
                 tc_frame_pool_dump_status(P);
-            } else {
-                frame.generic->status = TC_FRAME_NULL;
-                tc_frame_pool_push_frame(NP, frame);
-                n++;
+                break;
             }
+            frame.generic->status = TC_FRAME_NULL;
+            tc_frame_pool_push_frame(NP, frame);
+            n++;
         }
     }
 
@@ -960,18 +1315,31 @@ static void tc_frame_ring_get_counters(TCFrameRing *rfb,
 /* Backward-compatible API                                               */
 /*************************************************************************/
 
-int aframe_alloc(int num)
+static void frame_copied_init(void); /* below, with the frame cloning */
+
+int aframe_alloc(int num, int mode)
 {
+    size_t bsize = tc_audio_frame_buffer_size(tc_specs.samples,
+                                              tc_specs.channels,
+                                              tc_specs.bits);
+    frame_copied_init();
     return tc_frame_ring_init(&tc_audio_ringbuffer,
                               "audio", &tc_specs,
-                              tc_audio_alloc, tc_audio_free, num);
+                              tc_audio_alloc, tc_audio_free,
+                              bsize, 1, num, mode);
 }
 
-int vframe_alloc(int num)
+int vframe_alloc(int num, int mode)
 {
+    size_t bsize = tc_video_frame_buffer_size(tc_specs.width,
+                                              tc_specs.height,
+                                              tc_specs.format);
+    frame_copied_init();
+    /* every video frame has a backup buffer too */
     return tc_frame_ring_init(&tc_video_ringbuffer,
                               "video", &tc_specs,
-                              tc_video_alloc, tc_video_free, num);
+                              tc_video_alloc, tc_video_free,
+                              bsize, 2, num, mode);
 }
 
 void aframe_free(void)
@@ -984,6 +1352,313 @@ void vframe_free(void)
     tc_frame_ring_fini(&tc_video_ringbuffer);
 }
 
+static void tc_frame_ring_get_budget(const TCFrameRing *rfb,
+                                     size_t *frame, size_t *total,
+                                     int *hugepages)
+{
+    *frame = (rfb->arena != NULL) ?rfb->frame_size :0;
+    *total = tc_arena_size(rfb->arena);
+    if (tc_arena_hugepages(rfb->arena)) {
+        *hugepages = TC_TRUE;
+    }
+}
+
+void tc_framebuffer_get_budget(TCFrameBudget *budget)
+{
+    if (budget != NULL) {
+        budget->hugepages = TC_FALSE;
+        tc_frame_ring_get_budget(&tc_video_ringbuffer,
+                                 &budget->video_frame, &budget->video_total,
+                                 &budget->hugepages);
+        tc_frame_ring_get_budget(&tc_audio_ringbuffer,
+                                 &budget->audio_frame, &budget->audio_total,
+                                 &budget->hugepages);
+    }
+}
+
+
+/*************************************************************************/
+/* Shared (copy-on-write) payloads                                       */
+/*************************************************************************/
+
+/*
+ * A clone made by vframe_dup/aframe_dup doesn't get a copy of the
+ * payload: it points to the one of the original frame. All the frames
+ * sharing a payload are linked in a circular list through their
+ * `shared' field; the length of the list is the reference count of the
+ * payload. The payload is always one of the internal buffers of exactly
+ * one frame of the list, its owner.
+ *
+ * A frame leaves the list when it is released, or before anything
+ * writes on its payload (see vframe_unshare); in the latter case it
+ * takes a private copy of the data. If the owner leaves first, it trades
+ * the payload buffer for the matching one of another frame of the list,
+ * so each buffer keeps belonging to a single frame, and goes back to the
+ * right place when the frames are freed.
+ *
+ * The private copy is taken before leaving the list, so once a frame
+ * finds itself alone nobody reads its payload anymore and it can be
+ * written freely. That check is a lock-free read: without atomics,
+ * clones just get a deep copy like they always did.
+ *
+ * The copy itself runs outside of the share lock: the frame stays in
+ * the list meanwhile, flagged with `share_copy', which keeps the payload
+ * alive. A frame being copied is never picked to inherit the payload
+ * buffer, since that would take its copy destination away; an owner
+ * which is left only with such frames waits for them to be done.
+ */
+
+/* bumped by every thread cloning frames: sharded, see tccounter.h */
+static TCCounterSet *frame_copied_bytes = NULL;
+
+static void frame_copied_init(void)
+{
+    if (frame_copied_bytes == NULL) {
+        frame_copied_bytes = tc_counter_set_new(1);
+    }
+}
+
+static void frame_copied_add(size_t bytes)
+{
+    tc_counter_add(frame_copied_bytes, 0, bytes); /* just statistics */
+}
+
+unsigned long tc_framebuffer_get_copied(void)
+{
+    return tc_counter_get(frame_copied_bytes, 0);
+}
+
+#define SWAP_BUF(A, B) do { \
+    uint8_t *tmp_ = (A);    \
+    (A) = (B);              \
+    (B) = tmp_;             \
+} while (0)
+
+/* which internal buffer of `f' holds `buf', if any */
+static int vframe_slot(const TCFrameVideo *f, const uint8_t *buf)
+{
+    if (buf == f->internal_video_buf_0) {
+        return 0;
+    }
+    if (buf == f->internal_video_buf_1) {
+        return 1;
+    }
+    return -1;
+}
+
+/* trade the `k'th buffer (and its plane pointers) between two frames */
+static void vframe_swap_slot(TCFrameVideo *a, TCFrameVideo *b, int k)
+{
+    uint8_t *a_buf = a->video_buf_Y[k], *b_buf = b->video_buf_Y[k];
+
+    if (k == 0) {
+        SWAP_BUF(a->internal_video_buf_0, b->internal_video_buf_0);
+    } else {
+        SWAP_BUF(a->internal_video_buf_1, b->internal_video_buf_1);
+    }
+    SWAP_BUF(a->video_buf_RGB[k], b->video_buf_RGB[k]);
+    SWAP_BUF(a->video_buf_Y[k], b->video_buf_Y[k]);
+    SWAP_BUF(a->video_buf_U[k], b->video_buf_U[k]);
+    SWAP_BUF(a->video_buf_V[k], b->video_buf_V[k]);
+    if (a->video_buf2 == a_buf) {
+        a->video_buf2 = b_buf;
+    }
+    if (b->video_buf2 == b_buf) {
+        b->video_buf2 = a_buf;
+    }
+}
+
+static void vframe_share(TCFrameVideo *dst, TCFrameVideo *src)
+{
+#ifdef TC_HAVE_ATOMICS
+    TCFrameRing *rfb = &tc_video_ringbuffer;
+
+    vframe_copy(dst, src, 0);
+
+    tc_mutex_lock(&rfb->share_lock);
+    tc_atomic_store(&dst->shared, (src->shared) ?src->shared :src);
+    tc_atomic_store(&src->shared, dst);
+    tc_mutex_unlock(&rfb->share_lock);
+#else
+    vframe_copy(dst, src, 1);
+#endif
+}
+
+#ifdef TC_HAVE_ATOMICS
+
+/* first frame sharing with `f' which may take the payload over */
+static TCFrameVideo *vframe_share_heir(TCFrameVideo *f)
+{
+    TCFrameVideo *g;
+
+    for (g = f->shared; g != f; g = g->shared) {
+        if (!g->share_copy) {
+            return g;
+        }
+    }
+    return NULL;
+}
+
+/* must be called with the share lock held */
+static void vframe_share_unlink(TCFrameVideo *f)
+{
+    TCFrameVideo *prev = f, *next = f->shared;
+
+    while (prev->shared != f) {
+        prev = prev->shared;
+    }
+    tc_atomic_store(&prev->shared, (prev == next) ?NULL :next);
+    tc_atomic_store(&f->shared, NULL);
+}
+
+#endif /* TC_HAVE_ATOMICS */
+
+static void vframe_leave_share(TCFrameVideo *f, int keep_data)
+{
+#ifdef TC_HAVE_ATOMICS
+    TCFrameRing *rfb = &tc_video_ringbuffer;
+    TCFrameVideo *heir = NULL;
+    uint8_t *payload = NULL;
+    int cur = 0;
+
+    if (tc_atomic_load(&f->shared) == NULL) {
+        return;
+    }
+
+    tc_mutex_lock(&rfb->share_lock);
+    payload = f->video_buf;
+    cur = vframe_slot(f, payload);
+    if (cur >= 0) {
+        /* we own the payload, and somebody else may still need it */
+        while (f->shared != NULL && (heir = vframe_share_heir(f)) == NULL) {
+            tc_condition_wait(&rfb->share_done, &rfb->share_lock);
+        }
+        if (heir == NULL) {
+            /* everybody else left meanwhile, the payload is ours */
+            tc_mutex_unlock(&rfb->share_lock);
+            return;
+        }
+        vframe_swap_slot(f, heir, cur);
+    } else {
+        cur = (f->free == 0) ?1 :0;
+    }
+    if (keep_data) {
+        f->share_copy = TC_TRUE;
+        tc_mutex_unlock(&rfb->share_lock);
+
+        ac_memcpy(f->video_buf_Y[cur], payload, f->video_size);
+        frame_copied_add(f->video_size);
+
+        tc_mutex_lock(&rfb->share_lock);
+        f->share_copy = TC_FALSE;
+        tc_condition_broadcast(&rfb->share_done);
+    }
+    f->video_buf = f->video_buf_Y[cur];
+    vframe_share_unlink(f);
+    tc_mutex_unlock(&rfb->share_lock);
+#endif
+}
+
+void vframe_unshare(TCFrameVideo *ptr)
+{
+    if (ptr != NULL) {
+        vframe_leave_share(ptr, TC_TRUE);
+    }
+}
+
+static void aframe_share(TCFrameAudio *dst, TCFrameAudio *src)
+{
+#ifdef TC_HAVE_ATOMICS
+    TCFrameRing *rfb = &tc_audio_ringbuffer;
+
+    aframe_copy(dst, src, 0);
+
+    tc_mutex_lock(&rfb->share_lock);
+    tc_atomic_store(&dst->shared, (src->shared) ?src->shared :src);
+    tc_atomic_store(&src->shared, dst);
+    tc_mutex_unlock(&rfb->share_lock);
+#else
+    aframe_copy(dst, src, 1);
+#endif
+}
+
+#ifdef TC_HAVE_ATOMICS
+
+/* first frame sharing with `f' which may take the payload over */
+static TCFrameAudio *aframe_share_heir(TCFrameAudio *f)
+{
+    TCFrameAudio *g;
+
+    for (g = f->shared; g != f; g = g->shared) {
+        if (!g->share_copy) {
+            return g;
+        }
+    }
+    return NULL;
+}
+
+/* must be called with the share lock held */
+static void aframe_share_unlink(TCFrameAudio *f)
+{
+    TCFrameAudio *prev = f, *next = f->shared;
+
+    while (prev->shared != f) {
+        prev = prev->shared;
+    }
+    tc_atomic_store(&prev->shared, (prev == next) ?NULL :next);
+    tc_atomic_store(&f->shared, NULL);
+}
+
+#endif /* TC_HAVE_ATOMICS */
+
+static void aframe_leave_share(TCFrameAudio *f, int keep_data)
+{
+#ifdef TC_HAVE_ATOMICS
+    TCFrameRing *rfb = &tc_audio_ringbuffer;
+    TCFrameAudio *heir = NULL;
+    uint8_t *payload = NULL;
+
+    if (tc_atomic_load(&f->shared) == NULL) {
+        return;
+    }
+
+    tc_mutex_lock(&rfb->share_lock);
+    payload = f->audio_buf;
+    if (payload == f->internal_audio_buf) {
+        /* we own the payload, and somebody else may still need it */
+        while (f->shared != NULL && (heir = aframe_share_heir(f)) == NULL) {
+            tc_condition_wait(&rfb->share_done, &rfb->share_lock);
+        }
+        if (heir == NULL) {
+            /* everybody else left meanwhile, the payload is ours */
+            tc_mutex_unlock(&rfb->share_lock);
+            return;
+        }
+        SWAP_BUF(f->internal_audio_buf, heir->internal_audio_buf);
+    }
+    if (keep_data) {
+        f->share_copy = TC_TRUE;
+        tc_mutex_unlock(&rfb->share_lock);
+
+        ac_memcpy(f->internal_audio_buf, payload, f->audio_size);
+        frame_copied_add(f->audio_size);
+
+        tc_mutex_lock(&rfb->share_lock);
+        f->share_copy = TC_FALSE;
+        tc_condition_broadcast(&rfb->share_done);
+    }
+    f->audio_buf = f->internal_audio_buf;
+    aframe_share_unlink(f);
+    tc_mutex_unlock(&rfb->share_lock);
+#endif
+}
+
+void aframe_unshare(TCFrameAudio *ptr)
+{
+    if (ptr != NULL) {
+        aframe_leave_share(ptr, TC_TRUE);
+    }
+}
 
 aframe_list_t *aframe_dup(aframe_list_t *f)
 {
@@ -997,9 +1672,8 @@ aframe_list_t *aframe_dup(aframe_list_t *f)
     frame = tc_frame_ring_register_frame(&tc_audio_ringbuffer,
                                          0, TC_FRAME_WAIT);
     if (!TCFRAMEPTR_IS_NULL(frame)) {
-        aframe_copy(frame.audio, f, 1);
-        tc_frame_ring_put_frame(&tc_audio_ringbuffer,
-                                TC_FRAME_WAIT, frame);
+        /* the caller will push it where it belongs */
+        aframe_share(frame.audio, f);
     }
     return frame.audio;
 }
@@ -1016,9 +1690,8 @@ vframe_list_t *vframe_dup(vframe_list_t *f)
     frame = tc_frame_ring_register_frame(&tc_video_ringbuffer,
                                          0, TC_FRAME_WAIT);
     if (!TCFRAMEPTR_IS_NULL(frame)) {
-        vframe_copy(frame.video, f, 1);
-        tc_frame_ring_put_frame(&tc_video_ringbuffer,
-                                TC_FRAME_WAIT, frame);
+        /* the caller will push it where it belongs */
+        vframe_share(frame.video, f);
     }
     return frame.video;
 }
@@ -1045,6 +1718,7 @@ void aframe_remove(aframe_list_t *ptr)
         tc_log_warn(FRBUF_NAME, "aframe_remove: given NULL frame pointer");
     } else {
         TCFramePtr frame = { .audio = ptr };
+        aframe_leave_share(ptr, TC_FALSE);
         tc_frame_ring_remove_frame(&tc_audio_ringbuffer, frame);
     }
 }
@@ -1055,6 +1729,7 @@ void vframe_remove(vframe_list_t *ptr)
         tc_log_warn(FRBUF_NAME, "vframe_remove: given NULL frame pointer");
     } else {
         TCFramePtr frame = { .video = ptr };
+        vframe_leave_share(ptr, TC_FALSE);
         tc_frame_ring_remove_frame(&tc_video_ringbuffer, frame);
     }
 }
@@ -1131,18 +1806,28 @@ void vframe_push_next(vframe_list_t *ptr, int status)
 
 void aframe_flush(void)
 {
+    int i = 0;
+
+    for (i = 0; i < tc_audio_ringbuffer.size; i++) {
+        aframe_leave_share(tc_audio_ringbuffer.frames[i].audio, TC_FALSE);
+    }
     tc_frame_ring_flush(&tc_audio_ringbuffer);
 }
 
 void vframe_flush(void)
 {
+    int i = 0;
+
+    for (i = 0; i < tc_video_ringbuffer.size; i++) {
+        vframe_leave_share(tc_video_ringbuffer.frames[i].video, TC_FALSE);
+    }
     tc_frame_ring_flush(&tc_video_ringbuffer);
 }
 
 void tc_framebuffer_flush(void)
 {
-    tc_frame_ring_flush(&tc_audio_ringbuffer);
-    tc_frame_ring_flush(&tc_video_ringbuffer);
+    aframe_flush();
+    vframe_flush();
 }
 
 /*************************************************************************/
@@ -1210,6 +1895,7 @@ void aframe_copy(aframe_list_t *dst, const aframe_list_t *src,
     if (copy_data) {
         /* really copy video data */
         ac_memcpy(dst->audio_buf, src->audio_buf, dst->audio_size);
+        frame_copied_add(dst->audio_size);
     } else {
         /* soft copy, new frame points to old audio data */
         dst->audio_buf = src->audio_buf;
@@ -1237,6 +1923,7 @@ void vframe_copy(vframe_list_t *dst, const vframe_list_t *src,
     if (copy_data == 1) {
         /* really copy video data */
         ac_memcpy(dst->video_buf,  src->video_buf,  dst->video_size);
+        frame_copied_add(dst->video_size);
     } else {
         /* soft copy, new frame points to old video data */
         dst->video_buf  = src->video_buf;
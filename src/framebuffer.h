@@ -158,6 +158,18 @@ void tc_framebuffer_interrupt(void);
  */
 void tc_framebuffer_interrupt_stage(TCFrameStatus S);
 
+/*
+ * Frame queue backends. They differ only in how concurrent access to
+ * the per-stage frame pools is synchronized; frame ordering semantics
+ * are the same (the `ready' stage always hands out the lowest frame id
+ * available).
+ */
+enum {
+    TC_FRAME_QUEUE_LOCKED   = 0, /* mutex + condition variable (default) */
+    TC_FRAME_QUEUE_LOCKFREE = 1, /* lock-free rings, threads park only
+                                    when a pool is empty */
+};
+
 /*
  * vframe_alloc, aframe_alloc: (NOT thread safe)
  *     Allocate respectively a video or audio frame ringbuffer capable to hold
@@ -166,15 +178,18 @@ void tc_framebuffer_interrupt_stage(TCFrameStatus S);
  *     Use vframe_free/aframe_free to release acquired ringbuffers.
  *
  * Parameters:
- *     num: size of ringbuffer to allocate (number of framebuffers holded
- *          in ringbuffer).
+ *      num: size of ringbuffer to allocate (number of framebuffers holded
+ *           in ringbuffer).
+ *     mode: frame queue backend to use (TC_FRAME_QUEUE_*).
+ *           If the lock-free backend is not available on this platform,
+ *           the locked one is silently (modulo a warning) used instead.
  * Return Value:
  *      0: succesfull
  *     !0: error, tipically this means that one (or more) frame
  *         can't be allocated.
  */
-int vframe_alloc(int num);
-int aframe_alloc(int num);
+int vframe_alloc(int num, int mode);
+int aframe_alloc(int num, int mode);
 
 /*
  * vframe_alloc_single, aframe_alloc_single: (NOT thread safe)
@@ -212,6 +227,30 @@ TCFrameAudio *aframe_alloc_single(void);
 void vframe_free(void);
 void aframe_free(void);
 
+/* memory reserved for the frame ringbuffers */
+typedef struct tcframebudget_ TCFrameBudget;
+struct tcframebudget_ {
+    size_t video_frame; /* buffer bytes for each video frame */
+    size_t video_total; /* bytes reserved for the video ringbuffer */
+    size_t audio_frame; /* buffer bytes for each audio frame */
+    size_t audio_total; /* bytes reserved for the audio ringbuffer */
+    int    hugepages;   /* any of the above backed by huge pages? */
+};
+
+/*
+ * tc_framebuffer_get_budget: (NOT thread safe)
+ *     report the memory reserved for the frame ringbuffers
+ *     by vframe_alloc and aframe_alloc. The ringbuffers are carved
+ *     from a single arena each, so this is all the memory the frames
+ *     will ever use, no matter how long the job is.
+ *
+ * Parameters:
+ *     budget: structure to fill with the memory figures.
+ * Return Value:
+ *     None.
+ */
+void tc_framebuffer_get_budget(TCFrameBudget *budget);
+
 /*
  * vframe_flush, aframe_flush: (NOT thread safe)
  *     flush all framebuffers still in ringbuffer, by marking those as unused.
@@ -398,9 +437,11 @@ void aframe_push_next(TCFrameAudio *ptr, TCFrameStatus status);
  * vframe_dup, aframe_dup: (thread safe)
  *     Frame claiming functions.
  *     Duplicate given respectively video or audio framebuffer.
- *     New framebuffer will be a full (deep) copy of old one
- *     (see aframe_copy/vframe_copy documentation to learn about
- *     deep copy).
+ *     New framebuffer will share the payload of the old one, which is
+ *     copied only when either of them is about to be modified
+ *     (see vframe_unshare/aframe_unshare).
+ *     The new framebuffer is claimed by the caller, which must hand it
+ *     over to the next stage (see vframe_push_next/aframe_push_next).
  *
  * Parameters:
  *     f: framebuffer to be copied.
@@ -415,14 +456,31 @@ void aframe_push_next(TCFrameAudio *ptr, TCFrameStatus status);
 TCFrameVideo *vframe_dup(TCFrameVideo *f);
 TCFrameAudio *aframe_dup(TCFrameAudio *f);
 
+/*
+ * vframe_unshare, aframe_unshare: (thread safe)
+ *     make sure the payload of respectively a video or audio frame
+ *     is not shared with any other frame, by giving the frame a private
+ *     copy of it if needed. Must be called before anything writes on
+ *     a frame payload; the core does it before running a filter (unless
+ *     it is flagged TC_MODULE_FLAG_READONLY) and before the internal
+ *     processing, when any applies. Encoders are given frames as they
+ *     are, so they must never write on them (convert into a buffer of
+ *     their own instead). Cheap if the frame was never cloned.
+ *
+ * Parameters:
+ *     ptr: frame about to be modified.
+ * Return Value:
+ *     None.
+ */
+void vframe_unshare(TCFrameVideo *ptr);
+void aframe_unshare(TCFrameAudio *ptr);
+
 /*
  * vframe_copy, aframe_copy (thread safe)
  *     perform a soft or optionally deep copy respectively of a 
  *     video or audio framebuffer. A soft copy just copies metadata;
- * #ifdef STATBUFFER
  *     soft copy also let the buffer pointers point to original frame
  *     buffers, so data isn't really copied around.
- * #endif
  *     A deep copy just ac_memcpy()s buffer data from a frame to other
  *     one, so new frame will be an independent copy of old one.
  *
@@ -506,6 +564,18 @@ void aframe_get_counters(int *im, int *fl, int *ex);
  */
 void tc_framebuffer_get_counters(int *im, int *fl, int *ex);
 
+/*
+ * tc_framebuffer_get_copied (thread safe):
+ *     get the amount of frame payload copied around so far, by deep
+ *     frame copies and by unsharing frames.
+ *
+ * Parameters:
+ *     None.
+ * Return Value:
+ *     bytes copied since the start (modulo ULONG_MAX).
+ */
+unsigned long tc_framebuffer_get_copied(void);
+
 /*************************************************************************/
 
 /* Internal functions used in unit tests: */
@@ -523,9 +593,14 @@ extern int tc_frame_queue_size(TCFrameQueue *Q);
 extern TCFramePtr tc_frame_queue_get(TCFrameQueue *Q);
 extern int tc_frame_queue_put(TCFrameQueue *Q, TCFramePtr ptr);
 extern TCFrameQueue *tc_frame_queue_new(int size, int sorted);
+extern TCFrameQueue *tc_frame_queue_new_lockfree(int size, int sorted);
 extern int tc_frame_pool_init(TCFramePool *P, int size, int sorted,
+                              int lockfree,
                               const char *tag, const char *ptag);
 extern int tc_frame_pool_fini(TCFramePool *P);
+extern TCFramePool *tc_frame_pool_new(int size, int sorted, int lockfree,
+                                      const char *tag, const char *ptag);
+extern void tc_frame_pool_del(TCFramePool *P);
 extern void tc_frame_pool_dump_status(TCFramePool *P);
 extern void tc_frame_pool_put_frame(TCFramePool *P, TCFramePtr ptr);
 extern TCFramePtr tc_frame_pool_get_frame(TCFramePool *P);
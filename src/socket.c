@@ -101,18 +101,18 @@ static int sendstr(int sock, const char *str)
 
 static void dump_processing(int sock)
 {
-    uint32_t dropped = 0, encoded = 0;
+    TCFrameCounters frames;
     int im = 0, fl = 0, ex = 0;
     char buf[TC_BUF_LINE];
     int n;
 
-    dropped = tc_get_frames_dropped();
-    encoded = tc_get_frames_encoded();
+    tc_get_frames_counters(&frames);
     tc_framebuffer_get_counters(&im, &fl, &ex);
 
     n = tc_snprintf(buf, sizeof(buf),
                     "E=%lu|D=%lu|im=%i|fl=%i|ex=%i",
-                    encoded, dropped, im, fl, ex);
+                    (unsigned long)frames.encoded,
+                    (unsigned long)frames.dropped, im, fl, ex);
     if (n > 0)
         sendall(sock, buf, n);
 }
@@ -402,7 +402,7 @@ static int handle_help(char *params)
             "disable <filter>\n"
             "config <filter> <string>\n"
             "parameters <filter>\n"
-            "list [ load | enable | disable ]\n"
+            "list [ load | enable | disable | time ]\n"
             "dump\n"
             "progress\n"
             "pause\n"
@@ -441,6 +441,8 @@ static int handle_list(char *params)
         list = tc_filter_list(TC_FILTER_LIST_ENABLED);
     else if (strncasecmp(params, "disable", 2) == 0)
         list = tc_filter_list(TC_FILTER_LIST_DISABLED);
+    else if (strncasecmp(params, "time", 2) == 0)
+        list = tc_filter_list(TC_FILTER_LIST_TIMES);
 
     if (list) {
         sendstr(client_sock, list);
@@ -38,6 +38,7 @@
 #include "probe.h"
 #include "socket.h"
 #include "split.h"
+#include "chunks.h"
 
 #include "cmdline.h"
 
@@ -47,11 +48,14 @@
 #include "libtcext/tc_ext.h"
 #include "libtcutil/xio.h"
 #include "libtcutil/cfgfile.h"
+#include "libtcutil/tctimer.h"
 #include "libtcexport/export.h"
 #include "libtcexport/export_profile.h"
+#include "libtcmodule/tcmodule-slice.h"
 
 #include <ctype.h>
 #include <math.h>
+#include <sys/wait.h>
 
 
 /* ------------------------------------------------------------
@@ -437,6 +441,12 @@ static int transcode_init(TCSession *session, const TCFrameSpecs *specs)
     ret = tc_import_init(vob, session->im_aud_mod, session->im_vid_mod);
     RETURN_IF(ret < 0, "failed to init the import modules", TC_ERROR);
 
+    /* the slice pool must be up before any filter is configured;
+     * filters run in the frame threads, the import and the export ones */
+    ret = tc_module_slice_init(session->slice_threads,
+                               session->max_frame_threads + 3);
+    RETURN_IF(ret != TC_OK, "failed to start the slice threads", TC_ERROR);
+
     /* load and initialize filters */
     tc_filter_init();
     load_all_filters(session->plugins_string);
@@ -457,6 +467,16 @@ static int transcode_init(TCSession *session, const TCFrameSpecs *specs)
 
     tc_export_config(verbose, 1, session->cluster_mode);
 
+    /* frames in flight hold buffers the importer needs too */
+    if (session->export_pipeline > session->max_frame_buffers / 2) {
+        tc_log_warn(PACKAGE, "export pipeline too deep for %i frame"
+                             " buffers, using %i frames",
+                    session->max_frame_buffers,
+                    session->max_frame_buffers / 2);
+        session->export_pipeline = session->max_frame_buffers / 2;
+    }
+    tc_export_pipeline(session->export_pipeline);
+
     ret = transcode_find_modules(session);
     RETURN_IF(ret != TC_OK, "can't setup export modules", TC_ERROR);
 
@@ -486,6 +506,7 @@ static int transcode_fini(TCSession *session)
     tc_import_shutdown();
     /* unload filters */
     tc_filter_fini();
+    tc_module_slice_fini();
     /* unload export modules */
     tc_export_shutdown();
     tc_export_del();
@@ -723,7 +744,8 @@ static int transcode_mode_psu(TCSession *session, const char *psubase)
             tc_import_threads_create(vob);
 
             // frame threads may need a reboot too.
-            tc_frame_threads_init(vob, th_num, th_num);
+            tc_frame_threads_init(vob, th_num, th_num,
+                                  session->frame_threads_mode);
 
             // open new output file
             if (!no_split) {
@@ -940,11 +962,11 @@ static vob_t *new_vob(void)
     vob->im_a_size           = SIZE_PCM_FRAME;
     vob->im_v_width          = PAL_W;
     vob->im_v_height         = PAL_H;
-    vob->im_v_size           = SIZE_RGB_FRAME;
+    vob->im_v_size           = PAL_W * PAL_H * BPP/8;
     vob->ex_a_size           = SIZE_PCM_FRAME;
     vob->ex_v_width          = PAL_W;
     vob->ex_v_height         = PAL_H;
-    vob->ex_v_size           = SIZE_RGB_FRAME;
+    vob->ex_v_size           = PAL_W * PAL_H * BPP/8;
     vob->a_track             = 0;
     vob->v_track             = 0;
     vob->volume              = 0;
@@ -1057,6 +1079,7 @@ static vob_t *new_vob(void)
     vob->zoom_width          = 0;
     vob->zoom_height         = 0;
     vob->zoom_filter         = TCV_ZOOM_LANCZOS3;
+    vob->zoom_threads        = 1;
     vob->zoom_interlaced     = 0;
 
     vob->frame_interval      = 1; // write every frame
@@ -1177,6 +1200,12 @@ static TCSession *new_session(TCJob *job)
     session->hw_threads          = 1;  /* sane fallback */
     tc_sys_get_hw_threads(&(session->hw_threads));
     session->max_frame_threads   = session->hw_threads;
+    session->frame_queue_mode    = TC_FRAME_QUEUE_LOCKED;
+    session->frame_threads_mode  = TC_FRAME_THREADS_WORKERS;
+    session->slice_threads       = session->hw_threads;
+    session->export_pipeline     = 0;
+    session->multi_jobs          = 0; /* disabled */
+    session->chunk_jobs          = 0; /* disabled */
 
     session->progress_meter      = -1;
     session->progress_rate       = 1;
@@ -1450,6 +1479,565 @@ static void teardown_input_sources(vob_t *vob)
     }
 }
 
+/* -------------------------------------------------------------
+ * worker processes: batch mode (directory mode with --multi_jobs) and
+ * chunked mode (--chunk_jobs) run each of their tasks, a file or a
+ * chunk of one, in a worker process doing the default mode; the parent
+ * only hands out the tasks, splits the thread budget among the workers
+ * and sums up what they did.  Workers are processes since the
+ * framebuffer, the module factory and the counters are all per process.
+ * ------------------------------------------------------------*/
+
+typedef struct tcbatchjob_ TCBatchJob;
+struct tcbatchjob_ {
+    pid_t pid;      /* 0 if the slot is free */
+    int fd;         /* read end of the worker's report pipe */
+    int task;       /* what it works on */
+};
+
+/* in a worker, where to report the frame count when done */
+static int batch_fd = -1;
+/* in the parent, set once batch_run() took a SIGINT or SIGTERM */
+static int batch_signalled = TC_FALSE;
+
+static int batch_interrupted(void)
+{
+    sigset_t pending;
+
+    if (batch_signalled) {
+        return TC_TRUE;
+    }
+    sigemptyset(&pending);
+    sigpending(&pending);
+    return sigismember(&pending, SIGINT) || sigismember(&pending, SIGTERM);
+}
+
+static void batch_stop(const TCBatchJob *jobs, int slots)
+{
+    int i = 0;
+
+    for (i = 0; i < slots; i++) {
+        if (jobs[i].pid != 0) {
+            kill(jobs[i].pid, SIGTERM);
+        }
+    }
+}
+
+static void batch_report(void)
+{
+    TCFrameCounters frames;
+    long encoded = 0;
+
+    if (batch_fd >= 0) {
+        tc_get_frames_counters(&frames);
+        encoded = (long)frames.encoded;
+        if (write(batch_fd, &encoded, sizeof(encoded)) != sizeof(encoded)) {
+            tc_warn("cannot report to the parent process");
+        }
+        close(batch_fd);
+        batch_fd = -1;
+    }
+}
+
+/*
+ * batch_run: runs `tasks' tasks in worker processes, at most `slots' at
+ * a time, the first slots getting what of the thread budget doesn't
+ * divide.  Returns the task number in a worker; in the parent, returns
+ * -1 once all the workers have ended, with frames[] holding the frames
+ * each task encoded (-1 if it failed or never ran).  `names' are for
+ * the log only.  A SIGINT or SIGTERM to the parent stops handing out
+ * tasks and passes SIGTERM on to the running workers at once: the parent
+ * keeps them blocked, and waits for them together with SIGCHLD.
+ */
+static int batch_run(TCSession *session, const char *tag, int tasks,
+                     int slots, char * const *names, long *frames)
+{
+    TCBatchJob *jobs = NULL;
+    sigset_t events, oldmask;
+    struct timespec tick = { 1, 0 };
+    int frame_threads = session->max_frame_threads;
+    int slice_threads = session->slice_threads;
+    int running = 0, next = 0, failed = 0, interrupted = TC_FALSE;
+    int i = 0, j = 0;
+    long total = 0;
+    uint64_t start = 0;
+    double secs = 0.0;
+
+    slots = TC_MIN(slots, tasks);
+    jobs = tc_zalloc(slots * sizeof(*jobs));
+    for (i = 0; i < tasks; i++) {
+        frames[i] = -1;
+    }
+
+    if (verbose >= TC_INFO)
+        tc_log_info(PACKAGE, "%s: %i tasks, %i at a time, %i+%i threads"
+                             " shared", tag, tasks, slots,
+                    frame_threads, slice_threads);
+
+    /* SIGINT and SIGTERM are blocked already, see main() */
+    sigemptyset(&events);
+    sigaddset(&events, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &events, &oldmask);
+    sigaddset(&events, SIGINT);
+    sigaddset(&events, SIGTERM);
+
+    start = tc_gettime();
+    while (running > 0 || (next < tasks && !interrupted)) {
+        int status = 0, ok = 0, sig = 0;
+        long done = 0;
+        pid_t pid = 0;
+
+        if (!interrupted && batch_interrupted()) {
+            interrupted = TC_TRUE;
+            batch_stop(jobs, slots);
+        }
+
+        for (i = 0; i < slots && next < tasks && !interrupted; i++) {
+            int pfd[2];
+
+            if (jobs[i].pid != 0) {
+                continue;
+            }
+            if (pipe(pfd) != 0)
+                tc_error("%s: cannot create a pipe: %s",
+                         tag, strerror(errno));
+            if (verbose >= TC_INFO)
+                tc_log_info(PACKAGE, "%s: [%i/%i] %s",
+                            tag, next + 1, tasks, names[next]);
+            /* or the workers print what is still buffered again */
+            fflush(stdout);
+            fflush(stderr);
+
+            pid = fork();
+            if (pid == 0) {
+                sigprocmask(SIG_SETMASK, &oldmask, NULL);
+                close(pfd[0]);
+                for (j = 0; j < slots; j++) {
+                    if (jobs[j].pid != 0) {
+                        close(jobs[j].fd);
+                    }
+                }
+                tc_free(jobs);
+                batch_fd = pfd[1];
+
+                session->max_frame_threads = frame_threads / slots
+                                             + (i < frame_threads % slots);
+                session->slice_threads = slice_threads / slots
+                                         + (i < slice_threads % slots);
+                session->core_mode = TC_MODE_DEFAULT;
+                session->tc_pid = getpid();
+                if (slots > 1) {
+                    /* the meters of several workers would just overwrite
+                     * each other */
+                    session->progress_meter = 0;
+                }
+                return next;
+            }
+            close(pfd[1]);
+            if (pid < 0) {
+                close(pfd[0]);
+                tc_error("%s: cannot start a worker: %s",
+                         tag, strerror(errno));
+            }
+            jobs[i].pid = pid;
+            jobs[i].fd = pfd[0];
+            jobs[i].task = next++;
+            running++;
+        }
+
+        pid = waitpid(-1, &status, WNOHANG);
+        if (pid == 0) {
+            /* the tick is just in case a SIGCHLD goes astray */
+            sig = sigtimedwait(&events, NULL, &tick);
+            if ((sig == SIGINT || sig == SIGTERM) && !interrupted) {
+                batch_signalled = TC_TRUE;
+                interrupted = TC_TRUE;
+                batch_stop(jobs, slots);
+            }
+            continue;
+        }
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            tc_error("%s: lost the workers: %s", tag, strerror(errno));
+        }
+        for (i = 0; i < slots && jobs[i].pid != pid; i++)
+            ;
+        if (i == slots) {
+            continue;   /* not ours */
+        }
+
+        ok = (read(jobs[i].fd, &done, sizeof(done)) == sizeof(done)
+              && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        close(jobs[i].fd);
+        jobs[i].pid = 0;
+        running--;
+
+        if (ok) {
+            frames[jobs[i].task] = done;
+            total += done;
+            if (verbose >= TC_INFO)
+                tc_log_info(PACKAGE, "%s: [%i/%i] %ld frames",
+                            tag, jobs[i].task + 1, tasks, done);
+        } else {
+            failed++;
+            tc_warn("%s: [%i/%i] %s: FAILED",
+                    tag, jobs[i].task + 1, tasks, names[jobs[i].task]);
+        }
+    }
+    sigprocmask(SIG_SETMASK, &oldmask, NULL);
+    secs = (tc_gettime() - start) / 1000000.0;
+
+    if (verbose >= TC_INFO)
+        tc_log_info(PACKAGE, "%s: %i tasks (%i failed, %i not done),"
+                             " %ld frames in %.2f s, %.2f frames/s",
+                    tag, tasks, failed, tasks - next, total, secs,
+                    (secs > 0) ?total / secs :0.0);
+
+    tc_free(jobs);
+    return -1;
+}
+
+static int batch_failures(const long *frames, int tasks)
+{
+    int i = 0, failed = 0;
+
+    for (i = 0; i < tasks; i++) {
+        if (frames[i] < 0) {
+            failed++;
+        }
+    }
+    return failed;
+}
+
+/* output name template: `-o' itself if it has a %s, else the input name
+ * goes before the suffix, as for PSU mode.  Only the first %s is
+ * replaced, by hand: `-o' is no format string */
+static char *batch_output_template(const char *out)
+{
+    char *templ = tc_malloc(PATH_MAX);
+    const char *suffix = strrchr(out, '.');
+
+    if (strstr(out, "%s") != NULL) {
+        strlcpy(templ, out, PATH_MAX);
+    } else {
+        if (suffix == NULL || strchr(suffix, '/') != NULL) {
+            suffix = out + strlen(out);
+        }
+        tc_snprintf(templ, PATH_MAX, "%.*s-%%s%s",
+                    (int)(suffix - out), out, suffix);
+    }
+    return templ;
+}
+
+static char *batch_output_name(const char *templ, const char *in)
+{
+    char base[PATH_MAX], *name = tc_malloc(PATH_MAX);
+    const char *pc = strrchr(in, '/');
+    const char *mark = strstr(templ, "%s");
+    char *suffix = NULL;
+
+    strlcpy(base, (pc != NULL) ?pc + 1 :in, sizeof(base));
+    suffix = strrchr(base, '.');
+    if (suffix != NULL && suffix != base) {
+        *suffix = '\0';
+    }
+    tc_snprintf(name, PATH_MAX, "%.*s%s%s",
+                (int)(mark - templ), templ, base, mark + 2);
+    return name;
+}
+
+/*
+ * transcode_batch: directory mode with --multi_jobs, each input file is
+ * transcoded to its own output.  Returns TC_OK only in a worker, with
+ * the job set up for its file; the parent exits when all the files are
+ * done.
+ */
+static int transcode_batch(TCSession *session)
+{
+    TCJob *vob = session->job;
+    char **files = NULL, **outs = NULL, **labels = NULL, *templ = NULL;
+    const char *file = NULL;
+    long *frames = NULL;
+    int nfiles = 0, failed = 0, task = 0, i = 0;
+
+    if (strcmp(vob->audio_in_file, vob->video_in_file) != 0)
+        tc_error("batch mode DOES NOT support separate audio files (A=%s|V=%s)",
+                 vob->audio_in_file, vob->video_in_file);
+    if (vob->video_out_file == NULL)
+        tc_error("please specify output file name for batch mode");
+
+    for (file = vob->video_in_file; file != NULL;
+         file = (vob->video_in_files != NULL)
+                ?tc_glob_next(vob->video_in_files) :NULL) {
+        files = tc_realloc(files, (nfiles + 1) * sizeof(*files));
+        files[nfiles++] = tc_strdup(file);
+    }
+    templ = batch_output_template(vob->video_out_file);
+    outs = tc_malloc(nfiles * sizeof(*outs));
+    labels = tc_malloc(nfiles * sizeof(*labels));
+    frames = tc_malloc(nfiles * sizeof(*frames));
+    for (i = 0; i < nfiles; i++) {
+        outs[i] = batch_output_name(templ, files[i]);
+        labels[i] = tc_malloc(strlen(files[i]) + strlen(outs[i]) + 5);
+        sprintf(labels[i], "%s -> %s", files[i], outs[i]);
+    }
+
+    task = batch_run(session, "batch", nfiles, session->multi_jobs,
+                     labels, frames);
+    if (task >= 0) {
+        teardown_input_sources(vob);
+        vob->video_in_file = files[task];
+        vob->audio_in_file = files[task];
+        vob->video_out_file = outs[task];
+        return TC_OK;
+    }
+    failed = batch_failures(frames, nfiles);
+
+    for (i = 0; i < nfiles; i++) {
+        tc_free(files[i]);
+        tc_free(outs[i]);
+        tc_free(labels[i]);
+    }
+    tc_free(files);
+    tc_free(outs);
+    tc_free(labels);
+    tc_free(frames);
+    tc_free(templ);
+    teardown_input_sources(vob);
+    tc_free(vob);
+
+    if (batch_interrupted())
+        exit(127);
+    exit((failed > 0) ?EXIT_FAILURE :EXIT_SUCCESS);
+}
+
+/* looks up the export modules in the parent, which must know the
+ * multiplexor before it starts; the workers load them */
+static int chunk_find_modules(TCSession *session)
+{
+    TCJob *vob = session->job;
+    int ret = TC_ERROR;
+
+    session->factory = tc_new_module_factory(vob->mod_path, verbose);
+    if (session->factory != NULL) {
+        session->registry = tc_new_module_registry(session->factory,
+                                                   vob->reg_path, verbose);
+        if (session->registry != NULL) {
+            ret = transcode_find_modules(session);
+            tc_del_module_registry(session->registry);
+        }
+        tc_del_module_factory(session->factory);
+    }
+    session->registry = NULL;
+    session->factory = NULL;
+    return ret;
+}
+
+/* import_avi seeks the video by frames, and the audio by frames' worth
+ * of PCM; any other import module decodes from the start */
+static int chunk_can_seek(TCSession *session)
+{
+    TCJob *vob = session->job;
+    const char *vmod = (session->im_vid_mod != NULL)
+                       ?session->im_vid_mod :vob->vmod_probed;
+    const char *amod = (session->im_aud_mod != NULL)
+                       ?session->im_aud_mod :vob->amod_probed;
+
+    return (vmod != NULL && strcmp(vmod, "avi") == 0 && amod != NULL
+            && (strcmp(amod, "null") == 0
+             || (strcmp(amod, "avi") == 0
+                 && vob->im_a_codec == TC_CODEC_PCM)));
+}
+
+static char **chunk_names(const char *out, int count)
+{
+    char **names = tc_malloc(count * sizeof(*names));
+    int i = 0;
+
+    for (i = 0; i < count; i++) {
+        names[i] = tc_malloc(PATH_MAX);
+        tc_snprintf(names[i], PATH_MAX, "%s.chunk%02i", out, i);
+    }
+    return names;
+}
+
+static void chunk_free_names(char **names, int count, int remove)
+{
+    int i = 0;
+
+    for (i = 0; names != NULL && i < count; i++) {
+        if (remove) {
+            tc_chunk_remove(names[i]);
+        }
+        tc_free(names[i]);
+    }
+    tc_free(names);
+}
+
+/* a chunk whose worker encoded another number of frames than it holds
+ * would shift everything after it at the join: count it as failed */
+static int chunk_failures(const TCChunk *chunks, int count,
+                          const long *frames, int tasks)
+{
+    int i = 0, failed = 0;
+    long want = 0;
+
+    for (i = 0; i < tasks; i++) {
+        /* the task after the chunks encodes the audio of them all */
+        want = (i < count) ?chunks[i].last - chunks[i].first
+                           :chunks[count - 1].last - chunks[0].first;
+        if (frames[i] < 0) {
+            failed++;
+        } else if (frames[i] != want) {
+            tc_warn("chunks: [%i/%i] encoded %li frames instead of %li",
+                    i + 1, tasks, frames[i], want);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+/*
+ * transcode_chunked: --chunk_jobs, the frame range is cut into chunks
+ * (on key frames for AVI inputs), each encoded by a worker on its own,
+ * and the outputs are joined through the multiplexor's format.  Unless
+ * the audio encoder is null, one more worker encodes the audio of the
+ * whole range, with the video left out, and the join takes the audio
+ * from it alone (see chunks.h).  Returns TC_OK only in a worker, with
+ * the job set up for its task; the parent exits when the output is
+ * joined.
+ */
+static int transcode_chunked(TCSession *session)
+{
+    TCJob *vob = session->job;
+    TCChunk *chunks = NULL, *chunk = NULL, whole;
+    char **parts = NULL, **aparts = NULL, **labels = NULL;
+    const char *audio_part = NULL;
+    long *frames = NULL;
+    int count = 0, task = 0, failed = 0, seek = 0, base = 0, i = 0;
+    int audio = TC_FALSE, tasks = 0, ret = TC_ERROR;
+
+    if (session->core_mode != TC_MODE_DEFAULT)
+        tc_error("chunked mode works on a single input only");
+    if (vob->ttime->next != NULL)
+        tc_error("chunked mode supports a single -c range only");
+    if (vob->vob_offset != 0 || vob->vob_chunk_max != 0)
+        tc_error("chunked mode can't be used with -L or -W");
+    if (session->split_time != 0 || session->split_size != 0)
+        tc_error("chunked mode can't be used with output splitting");
+    if (vob->video_out_file == NULL
+     || strcmp(vob->video_out_file, TC_DEFAULT_OUT_FILE) == 0)
+        tc_error("please specify output file name for chunked mode");
+
+    if (chunk_find_modules(session) != TC_OK)
+        tc_error("can't setup export modules");
+    if (!tc_chunk_can_join(session->ex_mplex_mod)
+     || (vob->audio_out_file != NULL
+         && !tc_chunk_can_join(session->ex_mplex_mod_aux)))
+        tc_error("chunked mode can join avi, raw and ogg outputs only");
+    audio = (strcmp(session->ex_aud_mod, "null") != 0
+             && (vob->audio_out_file != NULL
+                 || strcmp(session->ex_mplex_mod, "null") != 0));
+    if (audio && vob->audio_out_file == NULL
+     && strcmp(session->ex_mplex_mod, "ogg") == 0)
+        tc_error("chunked mode can't join the audio of ogg outputs,"
+                 " please write it to its own file with -m");
+
+    chunks = tc_malloc(session->chunk_jobs * sizeof(*chunks));
+    count = tc_chunk_plan(vob->video_in_file, vob->ttime->stf,
+                          vob->ttime->etf, session->chunk_jobs, chunks);
+    if (count < 0)
+        tc_error("can't tell how many frames %s has, please give them"
+                 " with -c", vob->video_in_file);
+    if (count == 0)
+        tc_error("no frames to encode");
+    seek = chunk_can_seek(session);
+    tasks = count + (audio ?1 :0);
+
+    whole.first  = chunks[0].first;
+    whole.last   = chunks[count - 1].last;
+    whole.offset = chunks[0].offset;
+
+    parts = chunk_names(vob->video_out_file, tasks);
+    if (vob->audio_out_file != NULL) {
+        aparts = chunk_names(vob->audio_out_file, tasks);
+    }
+    labels = tc_malloc(tasks * sizeof(*labels));
+    frames = tc_malloc(tasks * sizeof(*frames));
+    for (i = 0; i < tasks; i++) {
+        chunk = (i < count) ?&chunks[i] :&whole;
+        labels[i] = tc_malloc(TC_BUF_MIN);
+        tc_snprintf(labels[i], TC_BUF_MIN, "%sframes %i-%i%s",
+                    (i < count) ?"" :"audio, ",
+                    chunk->first, chunk->last - 1,
+                    (seek && chunk->offset > 0) ?" (seeking)" :"");
+    }
+
+    /* the audio worker has little to do, it doesn't take a chunk's slot */
+    task = batch_run(session, "chunks", tasks,
+                     session->chunk_jobs + (audio ?1 :0), labels, frames);
+    if (task >= 0) {
+        chunk = &chunks[task];
+        if (task == count) {
+            chunk = &whole;
+            session->im_vid_mod = "null";
+            session->ex_vid_mod = "null";
+        }
+        if (seek && chunk->offset > 0) {
+            /* -c counts from the seek point */
+            vob->vob_offset = chunk->offset;
+            base = chunk->offset;
+        }
+        vob->ttime->stf = chunk->first - base;
+        vob->ttime->etf = chunk->last - base;
+        vob->video_out_file = parts[task];
+        if (aparts != NULL) {
+            vob->audio_out_file = aparts[task];
+        }
+        return TC_OK;
+    }
+
+    failed = chunk_failures(chunks, count, frames, tasks);
+    if (failed == 0 && !batch_interrupted()) {
+        /* some multiplexors keep writing the audio here even with -m */
+        if (audio && strcmp(session->ex_mplex_mod, "ogg") != 0) {
+            audio_part = parts[count];
+        }
+        ret = tc_chunk_join(session->ex_mplex_mod, vob->video_out_file,
+                            parts, count, audio_part);
+        if (ret == TC_OK && aparts != NULL && audio) {
+            /* the audio worker's output is all there is to join */
+            ret = tc_chunk_join(session->ex_mplex_mod_aux,
+                                vob->audio_out_file, &aparts[count], 1,
+                                aparts[count]);
+        } else if (ret == TC_OK && aparts != NULL) {
+            ret = tc_chunk_join(session->ex_mplex_mod_aux,
+                                vob->audio_out_file, aparts, count, NULL);
+        }
+        if (ret == TC_OK && verbose >= TC_INFO)
+            tc_log_info(PACKAGE, "chunks: joined %i chunks into %s",
+                        count, vob->video_out_file);
+    }
+    if (ret != TC_OK) {
+        tc_warn("chunks: not joined, the chunks are left in %s.chunk*",
+                vob->video_out_file);
+    }
+
+    chunk_free_names(parts, tasks, ret == TC_OK);
+    chunk_free_names(aparts, tasks, ret == TC_OK);
+    chunk_free_names(labels, tasks, TC_FALSE);
+    tc_free(frames);
+    tc_free(chunks);
+    teardown_input_sources(vob);
+    tc_free(vob);
+
+    if (batch_interrupted())
+        exit(127);
+    exit((ret == TC_OK) ?EXIT_SUCCESS :EXIT_FAILURE);
+}
+
 /*************************************************************************/
 
 /* support macros */
@@ -1489,6 +2077,12 @@ static void teardown_input_sources(vob_t *vob)
 
 
 
+/* the frame buffers must fit the largest frame in the whole chain */
+#define FRAME_GEOMETRY_UPDATE() do { \
+    frame_width  = TC_MAX(frame_width,  vob->ex_v_width); \
+    frame_height = TC_MAX(frame_height, vob->ex_v_height); \
+} while (0)
+
 #define SHUTDOWN_MARK(STAGE) do { \
     tc_debug(TC_DEBUG_CLEANUP, "shutdown: %s", (STAGE)); \
 } while (0)
@@ -1553,6 +2147,8 @@ int main(int argc, char *argv[])
     struct fc_time *tstart = NULL;
     const TCExportInfo *info = NULL;
     TCFrameSpecs specs;
+    TCFrameBudget budget;
+    int frame_width = 0, frame_height = 0;
 
     /* ------------------------------------------------------------
      *
@@ -1636,6 +2232,11 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (session->core_mode == TC_MODE_DIRECTORY && session->multi_jobs > 0) {
+        // from here on, each worker transcodes one of the files
+        transcode_batch(session);
+    }
+
     // user doesn't want to start at all;-(
     if (tc_interrupted())
         goto summary;
@@ -1826,6 +2427,8 @@ int main(int argc, char *argv[])
     // export bytes per frame (RGB 24bits)
     vob->ex_v_size   = vob->im_v_size;
 
+    FRAME_GEOMETRY_UPDATE();
+
     // --PRE_CLIP
     if (pre_im_clip) {
         CLIP_CHECK(pre_im_clip, "pre_clip", "--pre_clip");
@@ -1838,6 +2441,8 @@ int main(int argc, char *argv[])
         }
     }
 
+    FRAME_GEOMETRY_UPDATE();
+
     // -j
     if (im_clip) {
         CLIP_CHECK(im_clip, "clip", "-j");
@@ -1848,6 +2453,8 @@ int main(int argc, char *argv[])
         }
     }
 
+    FRAME_GEOMETRY_UPDATE();
+
     // -I
     /* can this really happen? */
     if (vob->deinterlace < 0 || vob->deinterlace > 5) {
@@ -1987,6 +2594,8 @@ int main(int argc, char *argv[])
                         vob->ex_v_width, vob->ex_v_height, asr);
     }
 
+    FRAME_GEOMETRY_UPDATE();
+
     // -B
     if (resize1) {
         if (vob->resize1_mult % 8 != 0)
@@ -2022,6 +2631,8 @@ int main(int argc, char *argv[])
                         vob->ex_v_width, vob->ex_v_height, asr);
     }
 
+    FRAME_GEOMETRY_UPDATE();
+
     // -Z
     if (vob->zoom_flag) {
         // new aspect ratio:
@@ -2032,12 +2643,16 @@ int main(int argc, char *argv[])
 
         if (verbose >= TC_INFO && vob->ex_v_height > 0)
             tc_log_info(PACKAGE,
-                        "V: %-16s | %03dx%03d  %4.2f:1 (%s)",
+                        "V: %-16s | %03dx%03d  %4.2f:1 (%s, %i thread%s)",
                         "zoom",
                         vob->ex_v_width, vob->ex_v_height, asr,
-                        tcv_zoom_filter_to_string(vob->zoom_filter));
+                        tcv_zoom_filter_to_string(vob->zoom_filter),
+                        vob->zoom_threads,
+                        (vob->zoom_threads > 1) ?"s" :"");
     }
 
+    FRAME_GEOMETRY_UPDATE();
+
     // -Y
     if (ex_clip) {
         CLIP_CHECK(ex_clip, "clip", "-Y");
@@ -2048,6 +2663,8 @@ int main(int argc, char *argv[])
                         vob->ex_v_width, vob->ex_v_height);
     }
 
+    FRAME_GEOMETRY_UPDATE();
+
     // -r
     if (rescale) {
         vob->ex_v_height /= vob->reduce_h;
@@ -2483,6 +3100,20 @@ int main(int argc, char *argv[])
     if (verbose >= TC_INFO)
         tc_log_info(PACKAGE, "H: worker threads   | %i (%i hardware)",
                     session->max_frame_threads, session->hw_threads);
+    if (verbose >= TC_INFO)
+        tc_log_info(PACKAGE, "H: frame queues     | %s",
+                    (session->frame_queue_mode == TC_FRAME_QUEUE_LOCKFREE)
+                        ?"lock-free" :"locked");
+    if (verbose >= TC_INFO)
+        tc_log_info(PACKAGE, "H: frame scheduler  | %s",
+                    (session->frame_threads_mode == TC_FRAME_THREADS_TASKS)
+                        ?"work-stealing tasks" :"one frame per thread");
+    if (verbose >= TC_INFO)
+        tc_log_info(PACKAGE, "H: slice threads    | %i",
+                    session->slice_threads);
+    if (verbose >= TC_INFO && session->export_pipeline > 0)
+        tc_log_info(PACKAGE, "H: export pipeline  | %i frames",
+                    session->export_pipeline);
 
     // --accel
     session->acceleration &= ac_cpuinfo();
@@ -2528,6 +3159,11 @@ int main(int argc, char *argv[])
         tc_log_msg(PACKAGE, "encoder delay = decode=%d encode=%d usec",
                    session->buffer_delay_dec, session->buffer_delay_enc);
 
+    if (session->chunk_jobs > 0) {
+        // from here on, each worker encodes one chunk of the input
+        transcode_chunked(session);
+    }
+
     /* -------------------------------------------------------------
      *
      * OK, so far, now start the support threads, setup buffers, ...
@@ -2544,8 +3180,9 @@ int main(int argc, char *argv[])
     } else {
         specs.frc = vob->ex_frc;
     }
-    specs.width  = TC_MAX(vob->im_v_width, vob->ex_v_width);
-    specs.height = TC_MAX(vob->im_v_height, vob->ex_v_height);
+    FRAME_GEOMETRY_UPDATE();
+    specs.width  = frame_width;
+    specs.height = frame_height;
     specs.format = vob->im_v_codec;
 
     /* XXX: explain me up */
@@ -2562,22 +3199,29 @@ int main(int argc, char *argv[])
                     session->max_frame_buffers, specs.rate, specs.channels, specs.bits);
     }
 
-#ifdef STATBUFFER
     // allocate buffer
     if (verbose >= TC_DEBUG)
-        tc_log_msg(PACKAGE, "allocating %d framebuffers (static)",
+        tc_log_msg(PACKAGE, "allocating %d framebuffers",
                    session->max_frame_buffers);
 
-    if (vframe_alloc(session->max_frame_buffers) < 0)
-        tc_error("static framebuffer allocation failed");
-    if (aframe_alloc(session->max_frame_buffers) < 0)
-        tc_error("static framebuffer allocation failed");
+    if (vframe_alloc(session->max_frame_buffers,
+                     session->frame_queue_mode) != 0)
+        tc_error("framebuffer allocation failed");
+    if (aframe_alloc(session->max_frame_buffers,
+                     session->frame_queue_mode) != 0)
+        tc_error("framebuffer allocation failed");
 
-#else
-    if(verbose >= TC_DEBUG)
-        tc_log_msg(PACKAGE, "%d framebuffers (dynamic) requested",
-                   session->max_frame_buffers);
-#endif
+    tc_framebuffer_get_budget(&budget);
+    if (verbose >= TC_INFO) {
+        tc_log_info(PACKAGE, "M: frame memory     | %lu kB/video frame,"
+                             " %lu kB/audio frame",
+                    (unsigned long)(budget.video_frame >> 10),
+                    (unsigned long)(budget.audio_frame >> 10));
+        tc_log_info(PACKAGE, "M: memory budget    | %lu MB%s",
+                    (unsigned long)((budget.video_total
+                                     + budget.audio_total) >> 20),
+                    (budget.hugepages) ?" (huge pages)" :"");
+    }
 
     // load import/export modules and filters plugins
     if (transcode_init(session, tc_framebuffer_get_specs()) != TC_OK)
@@ -2596,7 +3240,8 @@ int main(int argc, char *argv[])
     // start frame processing threads
     tc_frame_threads_init(vob,
                           session->max_frame_threads,
-                          session->max_frame_threads);
+                          session->max_frame_threads,
+                          session->frame_threads_mode);
 
 
     /* ------------------------------------------------------------
@@ -2672,22 +3317,21 @@ int main(int argc, char *argv[])
                     vob->clip_count/2);
 
     if (verbose >= TC_INFO) {
-        long drop = - tc_get_frames_dropped();
+        TCFrameCounters frames;
 
+        tc_get_frames_counters(&frames);
         tc_log_info(PACKAGE, "encoded %ld frames (%ld dropped, %ld cloned),"
                             " clip length %6.2f s",
-                    (long)tc_get_frames_encoded(), drop,
-                    (long)tc_get_frames_cloned(),
-                    tc_get_frames_encoded()/vob->ex_fps);
+                    (long)frames.encoded, - (long)frames.dropped,
+                    (long)frames.cloned, frames.encoded/vob->ex_fps);
     }
+    batch_report();
 
-#ifdef STATBUFFER
     // free buffers
     vframe_free();
     aframe_free();
     if(verbose >= TC_DEBUG)
         tc_log_msg(PACKAGE, "buffer released");
-#endif
 
     teardown_input_sources(vob);
 
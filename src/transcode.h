@@ -112,8 +112,16 @@ struct tcsession_ {
 
     int max_frame_buffers;
     int max_frame_threads;
+    int frame_queue_mode;
+    int frame_threads_mode;
+    int slice_threads;
+    int export_pipeline;
     int hw_threads;
     /* how many threads the HW can do in parallel? */
+    int multi_jobs;
+    /* directory mode: input files transcoded at once, each on its own */
+    int chunk_jobs;
+    /* chunks of the input encoded at once, then joined */
 
     int psu_frame_threshold;
     
@@ -178,6 +178,30 @@ static void swap_buffers(video_trans_data_t *vtd)
 /*************************************************************************/
 /*************************************************************************/
 
+/**
+ * frame_is_processed:  Tell whether do_process_frame() will touch the
+ * given frame at all, so that a frame sharing its payload with a clone
+ * is only unshared when something is actually going to write on it.
+ *
+ * Parameters:
+ *     vob: Global data pointer.
+ *     ptr: Pointer to video frame buffer.
+ * Return value:
+ *     Nonzero if any transformation applies to the frame, else zero.
+ */
+
+static int frame_is_processed(vob_t *vob, vframe_list_t *ptr)
+{
+    return im_clip || ex_clip || rescale || resize1 || resize2
+        || vob->deinterlace > 0
+        || ((ptr->attributes & TC_FRAME_IS_INTERLACED)
+            && ptr->deinter_flag > 0)
+        || vob->zoom_flag || vob->flip || vob->mirror || vob->rgbswap
+        || vob->decolor || vob->dgamma || vob->antialias;
+}
+
+/*************************************************************************/
+
 /**
  * do_process_frame:  Perform video frame transformations based on global
  * transcoding settings (derived from command-line arguments).
@@ -300,25 +324,23 @@ static int do_process_frame(vob_t *vob, vframe_list_t *ptr)
 
     if (vob->zoom_flag) {
         preadjust_frame_size(&vtd, vob->zoom_width, vob->zoom_height);
-        if (vob->zoom_interlaced) {
-            /* In YUV mode, only handle the first place as interlaced;
-             * the U and V planes are shared between both fields */
-            int i;
-            tcv_zoom(handle, vtd.planes[0], vtd.tmpplanes[0],
-                     ptr->v_width, ptr->v_height, vtd.Bpp,
-                     vob->zoom_width, -vob->zoom_height, vob->zoom_filter);
-            for (i = 1; i < vtd.nplanes; i++) {
-                tcv_zoom(handle, vtd.planes[i], vtd.tmpplanes[i],
-                         ptr->v_width / vtd.width_div[i],
-                         ptr->v_height / vtd.height_div[i], vtd.Bpp,
-                         vob->zoom_width / vtd.width_div[i],
-                         vob->zoom_height / vtd.height_div[i],
+        if (vtd.nplanes == 3) {
+            /* In interlaced mode, only the Y plane is handled as
+             * interlaced; the U and V planes are shared between both
+             * fields */
+            tcv_zoom_yuv(handle, vtd.planes[0], vtd.tmpplanes[0],
+                         ptr->v_width, ptr->v_height,
+                         ptr->v_codec == TC_CODEC_YUV422P
+                             ? IMG_YUV422P : IMG_YUV420P,
+                         vob->zoom_width,
+                         vob->zoom_interlaced ? -vob->zoom_height
+                                              : vob->zoom_height,
                          vob->zoom_filter);
-            }
             swap_buffers(&vtd);
         } else {
-            PROCESS_FRAME(tcv_zoom, &vtd, vob->zoom_width / vtd.width_div[i],
-                          vob->zoom_height / vtd.height_div[i],
+            PROCESS_FRAME(tcv_zoom, &vtd, vob->zoom_width,
+                          vob->zoom_interlaced ? -vob->zoom_height
+                                               : vob->zoom_height,
                           vob->zoom_filter);
         }
     }
@@ -459,6 +481,9 @@ int process_vid_frame(vob_t *vob, vframe_list_t *ptr)
      || vob->im_v_codec == TC_CODEC_YUV422P
     ) {
         ptr->v_codec = vob->im_v_codec;
+        if (!frame_is_processed(vob, ptr))
+            return 0;
+        vframe_unshare(ptr);
         return do_process_frame(vob, ptr);
     }
 
@@ -493,6 +518,10 @@ int preprocess_vid_frame(vob_t *vob, vframe_list_t *ptr)
             tc_log_error(PACKAGE, "video_trans.c: tcv_init() failed!");
             return -1;
         }
+        if (vob->zoom_threads > 1
+         && !tcv_set_threads(handle, vob->zoom_threads)) {
+            tc_log_warn(PACKAGE, "video_trans.c: resizing in one thread");
+        }
     }
 
     /* Check for pass-through mode */
@@ -569,6 +598,7 @@ int postprocess_vid_frame(vob_t *vob, vframe_list_t *ptr)
     /* Perform final clipping, if this isn't a cloned frame */
     if (post_ex_clip && !(ptr->attributes & TC_FRAME_WAS_CLONED)) {
         video_trans_data_t vtd;
+        vframe_unshare(ptr);
         ptr->v_codec = vob->im_v_codec;
         set_vtd(&vtd, ptr);
         preadjust_frame_size(&vtd,
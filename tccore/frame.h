@@ -47,9 +47,11 @@
 #define NTSC_W                  720
 #define NTSC_H                  480
 
-//new max frame size:
-#define TC_MAX_V_FRAME_WIDTH     2500
-#define TC_MAX_V_FRAME_HEIGHT    2000
+// max frame size (8K and then some). This is just a sanity limit:
+// the frame buffers are sized after the actual job (see TCFrameSpecs),
+// and so must be any other buffer holding a frame (TC_JOB_FRAME_SIZE)
+#define TC_MAX_V_FRAME_WIDTH     8192
+#define TC_MAX_V_FRAME_HEIGHT    8192
 
 // max bytes per pixel
 #define TC_MAX_V_BYTESPP        4
@@ -233,13 +235,8 @@ struct tcframevideo_ {
 
     int free; /* flag */
 
-#ifdef STATBUFFER
     uint8_t *internal_video_buf_0;
     uint8_t *internal_video_buf_1;
-#else
-    uint8_t internal_video_buf_0[SIZE_RGB_FRAME];
-    uint8_t internal_video_buf_1[SIZE_RGB_FRAME];
-#endif
 
     int deinter_flag;
     /* set to N for internal de-interlacing with "-I N" */
@@ -249,6 +246,11 @@ struct tcframevideo_ {
     uint8_t *video_buf_Y[2];
     uint8_t *video_buf_U[2];
     uint8_t *video_buf_V[2];
+
+    void *arena; /* where the buffers come from; NULL means the heap */
+    /* next frame sharing the payload (see vframe_dup); NULL if none */
+    struct tcframevideo_ *shared;
+    int share_copy; /* copying the payload away before leaving the share */
 };
 typedef struct tcframevideo_ vframe_list_t;
 
@@ -274,13 +276,13 @@ struct tcframeaudio_ {
 
     int free; /* flag */
 
-#ifdef STATBUFFER
     uint8_t *internal_audio_buf;
     uint8_t *internal_audio_buf_1;
-#else
-    uint8_t internal_audio_buf[SIZE_PCM_FRAME * 2];
-    uint8_t internal_audio_buf_1[SIZE_PCM_FRAME * 2];
-#endif
+
+    void *arena; /* where the buffers come from; NULL means the heap */
+    /* next frame sharing the payload (see aframe_dup); NULL if none */
+    struct tcframeaudio_ *shared;
+    int share_copy; /* copying the payload away before leaving the share */
 };
 typedef struct tcframeaudio_ aframe_list_t;
 
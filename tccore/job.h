@@ -60,6 +60,7 @@ typedef struct _transfer_t {
     uint8_t *buffer;
     uint8_t *buffer2;
     int attributes;
+    int buffer_size;    /* bytes allocated at buffer, 0 if unknown */
 } transfer_t;
 
 typedef struct _vob_t vob_t;
@@ -217,6 +218,7 @@ struct _vob_t {
     int zoom_interlaced;        // Zoom in interlaced mode?
 
     TCVZoomFilter zoom_filter;
+    int zoom_threads;           // Threads for resizing each frame
 
     int antialias;
     int deinterlace;
@@ -325,6 +327,17 @@ struct _vob_t {
 };
 typedef struct _vob_t TCJob;
 
+/*
+ * TC_JOB_FRAME_SIZE: the size in bytes of the largest video frame a
+ * module can be handed during this job: the larger of the import and
+ * export geometries, in RGB24, the fattest format the frame buffers
+ * hold. Size frame-sized scratch buffers with this rather than with
+ * SIZE_RGB_FRAME, which is the (huge) limit on any job.
+ */
+#define TC_JOB_FRAME_SIZE(job) \
+    ((size_t)TC_MAX((job)->im_v_width, (job)->ex_v_width) \
+     * (size_t)TC_MAX((job)->im_v_height, (job)->ex_v_height) * 3)
+
 enum {
     TC_MODE_DEFAULT     =  0,
     TC_MODE_AVI_SPLIT   =  1,
@@ -0,0 +1,266 @@
+/*
+ * test-avi-index-cache.c -- check that avilib keeps the index of files
+ *                           without one in a sidecar cache.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Writes an AVI file, cuts off its idx1 and opens it repeatedly:
+ *
+ *   the first open scans and leaves a cache behind;
+ *   the next one must take the index from the cache, and find the
+ *   same index as the scan;
+ *   a damaged cache, or an AVI file with another mtime, must be
+ *   ignored and the index scanned for again.
+ *
+ * Usage: test-avi-index-cache [-n frames] [-d dir]
+ */
+
+#include <glob.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#include "avilib/avilib.h"
+
+
+/*************************************************************************/
+
+enum {
+    DEF_FRAMES   = 500,
+    FRAME_SIZE   = 4000,
+    AUDIO_CHUNKS = 2,
+    AUDIO_SIZE   = 417,
+};
+
+/*************************************************************************/
+
+/* an AVI file as a capture cut short leaves it: no idx1 */
+/* the cache is written under a temporary name, then renamed */
+static int leftovers(const char *cache)
+{
+    char pattern[PATH_MAX];
+    glob_t g;
+    int found = 0;
+
+    if (snprintf(pattern, sizeof(pattern), "%s.*", cache)
+        >= (int)sizeof(pattern)) {
+        return 1;   /* can't tell */
+    }
+    found = (glob(pattern, 0, NULL, &g) == 0 && g.gl_pathc > 0);
+    globfree(&g);
+    return found;
+}
+
+static int write_file(const char *name, int frames)
+{
+    uint8_t buf[FRAME_SIZE];
+    avi_t *avi = AVI_open_output_file(name);
+    off_t size = 0;
+    int i = 0, j = 0, ok = 1;
+
+    if (avi == NULL) {
+        AVI_print_error(name);
+        return 0;
+    }
+    for (i = 0; i < FRAME_SIZE; i++) {
+        buf[i] = i * 13;
+    }
+    AVI_set_video(avi, 320, 240, 25.0, "DIVX");
+    AVI_set_audio(avi, 2, 44100, 16, 0x55, 128);
+    for (i = 0; i < frames && ok; i++) {
+        ok = (AVI_write_frame(avi, buf, FRAME_SIZE - (i % 37), i % 12 == 0)
+              == 0);
+        for (j = 0; j < AUDIO_CHUNKS && ok; j++) {
+            ok = (AVI_write_audio(avi, buf + j, AUDIO_SIZE + (i & 1)) == 0);
+        }
+    }
+    /* the index goes after the last chunk */
+    size = avi->pos;
+    if (AVI_close(avi) != 0) {
+        ok = 0;
+    }
+    return ok && truncate(name, size) == 0;
+}
+
+/* opens `name' and tells whether the index came from the cache */
+static avi_t *open_file(const char *name, int *cached)
+{
+    avi_t *avi = AVI_open_input_file(name, 1);
+
+    if (avi == NULL) {
+        AVI_print_error(name);
+        return NULL;
+    }
+    *cached = (avi->scan_pos == 0);
+    return avi;
+}
+
+static int same_index(avi_t *a, avi_t *b)
+{
+    long i = 0;
+
+    if (AVI_video_frames(a) != AVI_video_frames(b)
+     || AVI_audio_chunks(a) != AVI_audio_chunks(b)
+     || AVI_audio_bytes(a) != AVI_audio_bytes(b)
+     || AVI_max_video_chunk(a) != AVI_max_video_chunk(b)) {
+        return 0;
+    }
+    for (i = 0; i < AVI_video_frames(a); i++) {
+        if (a->video_index[i].pos != b->video_index[i].pos
+         || a->video_index[i].len != b->video_index[i].len
+         || a->video_index[i].key != b->video_index[i].key) {
+            return 0;
+        }
+    }
+    for (i = 0; i < AVI_audio_chunks(a); i++) {
+        if (a->track[0].audio_index[i].pos != b->track[0].audio_index[i].pos
+         || a->track[0].audio_index[i].len != b->track[0].audio_index[i].len
+         || a->track[0].audio_index[i].tot != b->track[0].audio_index[i].tot) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int damage_file(const char *name, long offset)
+{
+    FILE *f = fopen(name, "r+b");
+    int c = 0, ok = 0;
+
+    if (f != NULL) {
+        if (fseek(f, offset, SEEK_SET) == 0 && (c = getc(f)) != EOF) {
+            ok = (fseek(f, offset, SEEK_SET) == 0 && putc(c ^ 1, f) != EOF);
+        }
+        ok = (fclose(f) == 0) && ok;
+    }
+    return ok;
+}
+
+static int check(const char *what, int ok)
+{
+    printf("%-40s %s\n", what, ok ?"ok" :"FAILED");
+    return ok ?0 :1;
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    char name[PATH_MAX], cache[PATH_MAX];
+    int frames = DEF_FRAMES, errors = 0, cached = 0, ch;
+    const char *dir = ".";
+    avi_t *ref = NULL, *avi = NULL;
+    struct stat st;
+    struct utimbuf ut;
+
+    while ((ch = getopt(argc, argv, "n:d:h")) != -1) {
+        switch (ch) {
+          case 'n':
+            frames = atoi(optarg);
+            if (frames <= 0) {
+                fprintf(stderr, "bad frame count: %s\n", optarg);
+                return 1;
+            }
+            break;
+          case 'd':
+            dir = optarg;
+            break;
+          default:
+            fprintf(stderr, "Usage: %s [-n frames] [-d dir]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (snprintf(name, sizeof(name), "%s/avi-index-cache.avi", dir)
+        >= (int)sizeof(name)
+     || snprintf(cache, sizeof(cache), "%s%s", name, AVI_INDEX_CACHE_SUFFIX)
+        >= (int)sizeof(cache)) {
+        fprintf(stderr, "directory name too long: %s\n", dir);
+        return 1;
+    }
+    unlink(cache);
+
+    if (!write_file(name, frames)) {
+        return check("write the test file", 0);
+    }
+
+    ref = open_file(name, &cached);
+    if (ref == NULL) {
+        return 1;
+    }
+    errors += check("first open scans", !cached);
+    errors += check("frames found", AVI_video_frames(ref) == frames);
+    errors += check("cache written", stat(cache, &st) == 0);
+    errors += check("cache readable by all", (st.st_mode & 0444) == 0444);
+    errors += check("no temporary file left", !leftovers(cache));
+
+    avi = open_file(name, &cached);
+    errors += check("second open uses the cache", avi != NULL && cached);
+    errors += check("cached index is the same",
+                    avi != NULL && same_index(ref, avi));
+    if (avi != NULL) {
+        AVI_close(avi);
+    }
+
+    errors += check("damage the cache", damage_file(cache, st.st_size / 2));
+    avi = open_file(name, &cached);
+    errors += check("damaged cache is ignored", avi != NULL && !cached);
+    errors += check("scanned index is the same",
+                    avi != NULL && same_index(ref, avi));
+    if (avi != NULL) {
+        AVI_close(avi);
+    }
+    avi = open_file(name, &cached);
+    errors += check("cache written again", avi != NULL && cached);
+    if (avi != NULL) {
+        AVI_close(avi);
+    }
+
+    if (stat(name, &st) == 0) {
+        ut.actime  = st.st_atime;
+        ut.modtime = st.st_mtime + 10;
+        utime(name, &ut);
+    }
+    avi = open_file(name, &cached);
+    errors += check("changed file is scanned again", avi != NULL && !cached);
+    if (avi != NULL) {
+        AVI_close(avi);
+    }
+
+    AVI_close(ref);
+    unlink(name);
+    unlink(cache);
+    return (errors > 0) ?1 :0;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,254 @@
+/*
+ * test-avi-write-speed.c -- time avilib output with and without the
+ *                           write buffer.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Writes the same AVI file, video frames of the given size each followed
+ * by a few small audio chunks as an MP3 track would give, with each
+ * output mode and reports the write calls per chunk and the throughput:
+ *
+ *   plain:  no buffer, one writev(2) per chunk;
+ *   buffer: the default AVI_WRITE_BUFFER;
+ *   direct: as `buffer', with O_DIRECT where available.
+ *
+ * The files must come out identical and readable.
+ *
+ * Usage: test-avi-write-speed [-n frames] [-d dir] [frame_size ...]
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "config.h"
+#include "avilib/avilib.h"
+
+
+/*************************************************************************/
+
+enum {
+    DEF_FRAMES   = 250,
+    FRAME_SIZES  = 16,
+    AUDIO_CHUNKS = 3,     /* per video frame */
+    AUDIO_SIZE   = 417,   /* 128 kbps MP3 at 44.1 kHz */
+};
+
+enum {
+    MODE_PLAIN = 0,
+    MODE_BUFFER,
+    MODE_DIRECT,
+    MODE_NUM,
+};
+
+static const char *mode_names[MODE_NUM] = { "plain", "buffer", "direct" };
+
+/* MPEG-4 at low and high rate, PAL YUV420, 1080p YUV420 */
+static const int def_sizes[] = { 8000, 60000, 622080, 3110400, 0 };
+
+/*************************************************************************/
+
+static double elapsed(const struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec)
+           + (now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* frame sizes vary a bit, and are odd half the time to need padding */
+static long frame_size(int size, int i)
+{
+    return size - (i * 7919) % (size / 8 + 1);
+}
+
+static int files_equal(const char *name1, const char *name2)
+{
+    FILE *f1 = fopen(name1, "rb"), *f2 = fopen(name2, "rb");
+    int c1 = 0, c2 = 0;
+
+    if (f1 != NULL && f2 != NULL) {
+        do {
+            c1 = getc(f1);
+            c2 = getc(f2);
+        } while (c1 == c2 && c1 != EOF);
+    }
+    if (f1 != NULL) {
+        fclose(f1);
+    }
+    if (f2 != NULL) {
+        fclose(f2);
+    }
+    return (f1 != NULL && f2 != NULL && c1 == c2);
+}
+
+static int check_file(const char *name, int frames)
+{
+    avi_t *avi = AVI_open_input_file(name, 1);
+    int ok = 0;
+
+    if (avi != NULL) {
+        ok = (AVI_video_frames(avi) == frames
+              && AVI_audio_chunks(avi) == frames * AUDIO_CHUNKS);
+        AVI_close(avi);
+    }
+    return ok;
+}
+
+/* returns 0 if the file didn't come out right */
+static int run(int mode, int size, int frames, const char *dir)
+{
+    char name[PATH_MAX], ref[PATH_MAX];
+    struct timeval start;
+    uint8_t *buf = malloc(size);
+    avi_t *avi = NULL;
+    long calls = 0, chunks = 0;
+    double secs = 0.0, bytes = 0.0;
+    int i = 0, j = 0, ok = 1;
+
+    snprintf(name, sizeof(name), "%s/avi-write-%s.avi",
+             dir, mode_names[mode]);
+    snprintf(ref, sizeof(ref), "%s/avi-write-%s.avi",
+             dir, mode_names[MODE_PLAIN]);
+
+    if (buf == NULL) {
+        return 0;
+    }
+    for (i = 0; i < size; i++) {
+        buf[i] = i * 31 + (i >> 8);
+    }
+
+    gettimeofday(&start, NULL);
+    avi = AVI_open_output_file(name);
+    if (avi == NULL) {
+        AVI_print_error(name);
+        free(buf);
+        return 0;
+    }
+    if (mode != MODE_BUFFER) {
+        ok = (AVI_set_write_buffer(avi, (mode == MODE_DIRECT)
+                                        ?AVI_WRITE_BUFFER :0,
+                                   (mode == MODE_DIRECT)) == 0);
+    }
+    AVI_set_video(avi, 720, 576, 25.0, "DIVX");
+    AVI_set_audio(avi, 2, 44100, 16, 0x55, 128);
+
+    for (i = 0; i < frames && ok; i++) {
+        ok = (AVI_write_frame(avi, buf, frame_size(size, i), i % 12 == 0)
+              == 0);
+        bytes += frame_size(size, i);
+        for (j = 0; j < AUDIO_CHUNKS && ok; j++) {
+            ok = (AVI_write_audio(avi, buf + j, AUDIO_SIZE + (i & 1)) == 0);
+            bytes += AUDIO_SIZE + (i & 1);
+        }
+    }
+    /* the last few writes in AVI_close aren't counted */
+    chunks = avi->video_frames + avi->track[0].audio_chunks;
+    calls = avi->wbuf_calls;
+    if (AVI_close(avi) != 0) {
+        ok = 0;
+    }
+    secs = elapsed(&start);
+    free(buf);
+
+    if (ok) {
+        ok = check_file(name, frames);
+    }
+    if (ok && mode != MODE_PLAIN) {
+        ok = files_equal(name, ref);
+    }
+
+    printf("%9i  %6s  %9.3f  %9.1f%s\n", size, mode_names[mode],
+           (double)calls / chunks,
+           (secs > 0) ?bytes / secs / 1048576.0 :0.0,
+           ok ?"" :"  FAILED");
+    return ok;
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    int sizes[FRAME_SIZES + 1];
+    int frames = DEF_FRAMES, errors = 0, i = 0, m = 0, n = 0, ch;
+    const char *dir = ".";
+    char name[PATH_MAX];
+
+    while ((ch = getopt(argc, argv, "n:d:h")) != -1) {
+        switch (ch) {
+          case 'n':
+            frames = atoi(optarg);
+            if (frames <= 0) {
+                fprintf(stderr, "bad frame count: %s\n", optarg);
+                return 1;
+            }
+            break;
+          case 'd':
+            dir = optarg;
+            break;
+          default:
+            fprintf(stderr, "Usage: %s [-n frames] [-d dir]"
+                            " [frame_size ...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    for (i = optind; i < argc && n < FRAME_SIZES; i++) {
+        sizes[n] = atoi(argv[i]);
+        if (sizes[n] >= AUDIO_SIZE + AUDIO_CHUNKS) {
+            n++;
+        }
+    }
+    if (n == 0) {
+        for (n = 0; def_sizes[n] > 0; n++) {
+            sizes[n] = def_sizes[n];
+        }
+    }
+
+    printf("%9s  %6s  %9s  %9s\n", "bytes", "mode", "calls/chk", "MB/s");
+    for (i = 0; i < n; i++) {
+        for (m = 0; m < MODE_NUM; m++) {
+            if (!run(m, sizes[i], frames, dir)) {
+                errors++;
+            }
+        }
+    }
+
+    for (m = 0; m < MODE_NUM; m++) {
+        snprintf(name, sizeof(name), "%s/avi-write-%s.avi",
+                 dir, mode_names[m]);
+        unlink(name);
+    }
+    return (errors > 0) ?1 :0;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,620 @@
+/*
+ * test-filters.c -- behaviour tests for the filters ported to the
+ *                   module API: fixed frames in, known checksums out.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "src/transcode.h"
+#include "aclib/ac.h"
+#include "libtc/libtc.h"
+#include "libtcutil/tcutil.h"
+#include "libtcutil/ioutils.h"
+#include "libtc/ratiocodes.h"
+#include "libtcmodule/tcmodule-slice.h"
+#include "libtcvideo/tcvideo.h"
+
+#ifdef HAVE_DLFCN_H
+# include <dlfcn.h>
+#else
+# ifdef OS_DARWIN
+#  include "libdldarwin/dlfcn.h"
+# endif
+#endif
+
+/*
+ * Every filter goes through the classic tc_filter() entry point, which
+ * both the ported filters and the ones they were ported from provide,
+ * so the checksums below were taken by running the very same frames
+ * through the classic filters (run with -g to print them). Except for:
+ * - ascii and whitebalance: the classic ones converted YUV to RGB in
+ *   place and ran off the end of a YUV frame;
+ * - slowmo: the classic one checked the clone flag in the wrong field
+ *   and never cloned anything.
+ * Those checksums are the ones of the ported filters. fieldanalysis only
+ * reports, so all its checksum tells is that the frames went through
+ * untouched.
+ *
+ * Frames go through the stages the way the core sends them: PRE_S,
+ * then PRE_M, POST_M and POST_S. A skipped frame stops where it was
+ * skipped; a cloned one is sent again from PRE_M, flagged as a clone,
+ * once it is through.
+ */
+
+int verbose = TC_QUIET;
+
+static vob_t *vob = NULL;
+
+// dependencies
+vob_t *tc_get_vob(void) { return vob; }
+
+/* the filters take these from the program: make sure they are linked in */
+void *test_filters_deps[] = {
+    ac_endian, ac_memcpy,
+    fc_time_contains, free_fc_time, new_fc_time_from_string,
+    optstr_filter_desc, optstr_get, optstr_lookup, optstr_param,
+    tc_frc_code_to_value, tc_module_slice_run, tc_module_slice_slots,
+    tc_test_program, tcv_convert, tcv_free, tcv_init,
+};
+
+/*************************************************************************/
+
+enum {
+    WIDTH       = 96,
+    HEIGHT      = 72,
+    FRAMES      = 30,
+    SAMPLES     = 1920,     /* 48kHz at 25 fps */
+    CLONES_MAX  = 4,        /* per frame, in case a filter runs wild */
+};
+
+#define VIDEO_SIZE      (WIDTH * HEIGHT * 3 / 2)
+#define AUDIO_SIZE      (SAMPLES * 2 * 2)
+
+#define ATTR_MASK   (TC_FRAME_IS_SKIPPED | TC_FRAME_IS_CLONED \
+                     | TC_FRAME_WAS_CLONED | TC_FRAME_IS_INTERLACED)
+
+typedef struct filtercase_ FilterCase;
+struct filtercase_ {
+    const char  *name;      /* filter module */
+    const char  *options;   /* NULL for none */
+    int         media;      /* TC_VIDEO or TC_AUDIO */
+    double      ex_fps;     /* export frame rate, 0 for the import one */
+    const char  *logfile;   /* file written by the filter, checked too */
+    uint32_t    checksum;
+};
+
+static const FilterCase cases[] = {
+    { "29to23",         NULL,                   TC_VIDEO, 0,  NULL,
+      0xb2d13eaf },
+    { "32detect",       "force_mode=3",         TC_VIDEO, 0,  NULL,
+      0xbdd70502 },
+    { "32drop",         NULL,                   TC_VIDEO, 0,  NULL,
+      0xf7a6a085 },
+    { "aclip",          "level=10:range=2",     TC_AUDIO, 0,  NULL,
+      0xa581af0c },
+    { "ascii",          NULL,                   TC_VIDEO, 0,  NULL,
+      0xb4bc2eb9 },
+    { "cpaudio",        "source=r",             TC_AUDIO, 0,  NULL,
+      0x5b919280 },
+    { "decimate",       NULL,                   TC_VIDEO, 0,  NULL,
+      0x149c094f },
+    { "denoise3d",      "luma=6:chroma=4",      TC_VIDEO, 0,  NULL,
+      0x74f185c1 },
+    { "detectclipping", "limit=24:log=clip.log", TC_VIDEO, 0, "clip.log",
+      0xa489cb9d },
+    { "fieldanalysis",  NULL,                   TC_VIDEO, 0,  NULL,
+      0xcc691f92 },
+    { "fps",            "25:15",                TC_VIDEO, 0,  NULL,
+      0x0ceaa956 },
+    { "fps",            "25:40:post",           TC_VIDEO, 0,  NULL,
+      0xa102d7a1 },
+    { "hqdn3d",         "luma=6:chroma=4",      TC_VIDEO, 0,  NULL,
+      0x399783a4 },
+    { "ivtc",           NULL,                   TC_VIDEO, 0,  NULL,
+      0x581cfe0f },
+    { "mask",           "lefttop=8x8:rightbot=80x60", TC_VIDEO, 0, NULL,
+      0x055b44ad },
+    { "modfps",         "mode=1",               TC_VIDEO, 20, NULL,
+      0x96aace44 },
+    { "modfps",         "mode=1:clonetype=3",   TC_VIDEO, 30, NULL,
+      0x988b60dd },
+    { "normalize",      "algo=2",               TC_AUDIO, 0,  NULL,
+      0x3e46996d },
+    { "skip",           "3-6 20-24/2",          TC_VIDEO, 0,  NULL,
+      0xd9a50dd7 },
+    { "skip",           "3-6 20-24/2",          TC_AUDIO, 0,  NULL,
+      0xa94da134 },
+    { "slowmo",         NULL,                   TC_VIDEO, 0,  NULL,
+      0xe1a9c6e4 },
+    { "smartbob",       NULL,                   TC_VIDEO, 0,  NULL,
+      0x360cf58f },
+    { "smartdeinter",   NULL,                   TC_VIDEO, 0,  NULL,
+      0x617322df },
+    { "smartdeinter",   "diffmode=2:highq=1:cubic=1", TC_VIDEO, 0, NULL,
+      0xa01a939b },
+    { "smartyuv",       NULL,                   TC_VIDEO, 0,  NULL,
+      0x69b5ccb0 },
+    { "smooth",         NULL,                   TC_VIDEO, 0,  NULL,
+      0xad05f808 },
+    { "testframe",      "mode=2",               TC_VIDEO, 0,  NULL,
+      0x41c0e074 },
+    { "testframe",      "mode=5",               TC_VIDEO, 0,  NULL,
+      0x7ad7abf4 },
+    { "unsharp",        "luma=1.5:chroma=0.8",  TC_VIDEO, 0,  NULL,
+      0x16aab506 },
+    { "whitebalance",   "level=40",             TC_VIDEO, 0,  NULL,
+      0xaf593d79 },
+    { "yait",           "log=yait.log",         TC_VIDEO, 0,  "yait.log",
+      0x66def9e3 },
+    { NULL,             NULL,                   0,        0,  NULL,
+      0x00000000 }
+};
+
+/*************************************************************************/
+
+/* FNV-1a */
+static uint32_t hash_bytes(uint32_t hash, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    for (i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static uint32_t hash_int(uint32_t hash, int value)
+{
+    uint8_t buf[4] = {
+        value & 0xff, (value >> 8) & 0xff,
+        (value >> 16) & 0xff, (value >> 24) & 0xff
+    };
+    return hash_bytes(hash, buf, sizeof(buf));
+}
+
+static uint32_t hash_file(uint32_t hash, const char *name)
+{
+    uint8_t buf[1024];
+    size_t n = 0;
+    FILE *f = fopen(name, "rb");
+
+    if (!f) {
+        return hash_int(hash, -1);
+    }
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        hash = hash_bytes(hash, buf, n);
+    }
+    fclose(f);
+    return hash;
+}
+
+/*************************************************************************/
+
+/*
+ * A pattern sliding right by two pixels a frame, with black bars on top
+ * and bottom, some noise and a scene change halfway. On two frames out
+ * of five the odd lines lag one frame behind, like telecined film.
+ */
+static void fill_video(vframe_list_t *frame, int n)
+{
+    uint8_t *Y = NULL, *U = NULL, *V = NULL;
+    uint32_t seed = 12345 + n * 7919;
+    int x = 0, y = 0, t = 0;
+
+    /* filters may have swapped the buffers */
+    tc_init_video_frame(frame, WIDTH, HEIGHT, TC_CODEC_YUV420P);
+    Y = frame->video_buf;
+    U = Y + WIDTH * HEIGHT;
+    V = U + WIDTH * HEIGHT / 4;
+
+    for (y = 0; y < HEIGHT; y++) {
+        t = ((y & 1) && (n % 5 == 2 || n % 5 == 3)) ?n - 1 :n;
+        for (x = 0; x < WIDTH; x++) {
+            seed = seed * 1103515245 + 12345;
+            if (y < 6 || y >= HEIGHT - 6) {
+                Y[y * WIDTH + x] = 16;
+            } else if (n < FRAMES / 2) {
+                Y[y * WIDTH + x] = (((x + 2 * t) * 3 + y * 2) & 0xff)
+                                   ^ (seed >> 28);
+            } else {
+                Y[y * WIDTH + x] = ((x * 5 - y * 3 + 4 * t) & 0xff)
+                                   ^ (seed >> 28);
+            }
+        }
+    }
+    for (y = 0; y < HEIGHT / 2; y++) {
+        for (x = 0; x < WIDTH / 2; x++) {
+            U[y * WIDTH / 2 + x] = (x * 4 + y + n) & 0xff;
+            V[y * WIDTH / 2 + x] = (128 + x - y * 2 + n * 3) & 0xff;
+        }
+    }
+
+    frame->id         = n;
+    frame->v_codec    = TC_CODEC_YUV420P;
+    frame->v_width    = WIDTH;
+    frame->v_height   = HEIGHT;
+    frame->v_bpp      = 24;
+    frame->video_len  = VIDEO_SIZE;
+    frame->deinter_flag = 0;
+}
+
+/* 16 bit stereo triangle waves; every fourth frame is almost silent */
+static void fill_audio(aframe_list_t *frame, int n)
+{
+    uint8_t *buf = NULL;
+    int amp = (n % 4 == 0) ?5 :(3000 + n * 200);
+    int i = 0, phase = 0, l = 0, r = 0;
+
+    tc_init_audio_frame(frame, SAMPLES, 2, 16);
+    buf = frame->audio_buf;
+
+    for (i = 0; i < SAMPLES; i++) {
+        phase = (i * (n + 3)) % 400;
+        l = amp * ((phase < 200) ?(phase - 100) :(300 - phase)) / 100;
+        r = -l / 2 + (i % 7) - 3;
+        buf[i * 4 + 0] = l & 0xff;
+        buf[i * 4 + 1] = (l >> 8) & 0xff;
+        buf[i * 4 + 2] = r & 0xff;
+        buf[i * 4 + 3] = (r >> 8) & 0xff;
+    }
+
+    frame->id         = n;
+    frame->a_codec    = TC_CODEC_PCM;
+    frame->a_rate     = 48000;
+    frame->a_bits     = 16;
+    frame->a_chan     = 2;
+    frame->audio_len  = AUDIO_SIZE;
+}
+
+static void setup_vob(const FilterCase *fc)
+{
+    memset(vob, 0, sizeof(vob_t));
+    vob->im_v_codec  = TC_CODEC_YUV420P;
+    vob->im_v_width  = WIDTH;
+    vob->im_v_height = HEIGHT;
+    vob->ex_v_width  = WIDTH;
+    vob->ex_v_height = HEIGHT;
+    vob->im_v_size   = VIDEO_SIZE;
+    vob->ex_v_size   = VIDEO_SIZE;
+    vob->fps         = PAL_FPS;
+    vob->im_frc      = 3;
+    vob->ex_fps      = (fc->ex_fps > 0) ?fc->ex_fps :PAL_FPS;
+    vob->ex_frc      = 0;
+    vob->a_rate      = 48000;
+    vob->a_bits      = 16;
+    vob->a_chan      = 2;
+    vob->dm_bits     = 16;
+    vob->dm_chan     = 2;
+    vob->im_a_size   = AUDIO_SIZE;
+    vob->ex_a_size   = AUDIO_SIZE;
+    vob->im_a_codec  = TC_CODEC_PCM;
+}
+
+/*************************************************************************/
+
+typedef int (*FilterEntry)(frame_list_t *frame, char *options);
+
+/* one filter instance with the frame it is working on */
+typedef struct instance_ Instance;
+struct instance_ {
+    int             id;
+    vframe_list_t   *vframe;
+    aframe_list_t   *aframe;
+    frame_list_t    *frame;
+    uint32_t        hash;
+};
+
+static const int stages[] = {
+    TC_PRE_S_PROCESS, TC_PRE_M_PROCESS, TC_POST_M_PROCESS, TC_POST_S_PROCESS
+};
+
+static int run_stages(FilterEntry entry, Instance *I, int media, int first)
+{
+    int s = 0;
+
+    for (s = first; s < 4; s++) {
+        I->frame->tag = media | stages[s];
+        I->frame->filter_id = I->id;
+        if (entry(I->frame, NULL) < 0) {
+            return TC_ERROR;
+        }
+        if (I->frame->attributes & TC_FRAME_IS_SKIPPED) {
+            break;
+        }
+    }
+    return TC_OK;
+}
+
+static void hash_frame(Instance *I, int media)
+{
+    I->hash = hash_int(I->hash, I->frame->id);
+    I->hash = hash_int(I->hash, I->frame->attributes & ATTR_MASK);
+    if (I->frame->attributes & TC_FRAME_IS_SKIPPED) {
+        return;
+    }
+    if (media == TC_VIDEO) {
+        I->hash = hash_int(I->hash, I->vframe->deinter_flag);
+        I->hash = hash_bytes(I->hash, I->vframe->video_buf, VIDEO_SIZE);
+    } else {
+        I->hash = hash_int(I->hash, I->aframe->audio_len);
+        I->hash = hash_bytes(I->hash, I->aframe->audio_buf,
+                             TC_MIN(I->aframe->audio_len, AUDIO_SIZE));
+    }
+}
+
+static int process_frame(FilterEntry entry, Instance *I, int media, int n)
+{
+    int clones = 0, first = 0;
+
+    if (media == TC_VIDEO) {
+        fill_video(I->vframe, n);
+    } else {
+        fill_audio(I->aframe, n);
+    }
+
+    do {
+        if (run_stages(entry, I, media, first) != TC_OK) {
+            return TC_ERROR;
+        }
+        hash_frame(I, media);
+        if (!(I->frame->attributes & TC_FRAME_IS_CLONED)) {
+            break;
+        }
+        I->frame->attributes &= ~(TC_FRAME_IS_CLONED|TC_FRAME_IS_SKIPPED);
+        I->frame->attributes |= TC_FRAME_WAS_CLONED;
+        first = 1; /* from PRE_M on */
+    } while (++clones < CLONES_MAX);
+    return TC_OK;
+}
+
+/*
+ * run_case: run the frames through `instances' instances of the filter
+ * at once, each of them getting the same frames in turn.
+ *
+ * Return value: TC_OK if every instance worked and all of them ended up
+ * with the same checksum, stored in *hash; TC_ERROR otherwise.
+ */
+static int run_case(const char *modpath, const FilterCase *fc,
+                    int instances, uint32_t *hash)
+{
+    Instance inst[2];
+    char path[PATH_MAX];
+    frame_list_t init;
+    FilterEntry entry = NULL;
+    void *handle = NULL;
+    int i = 0, n = 0, ret = TC_OK;
+
+    tc_snprintf(path, sizeof(path), "%s/filter_%s.so", modpath, fc->name);
+    handle = dlopen(path, RTLD_NOW);
+    if (!handle) {
+        tc_log_warn(__FILE__, "FAILED: can't load %s: %s", path, dlerror());
+        return TC_ERROR;
+    }
+    entry = (FilterEntry)dlsym(handle, "tc_filter");
+    if (!entry) {
+        tc_log_warn(__FILE__, "FAILED: no tc_filter in %s", path);
+        dlclose(handle);
+        return TC_ERROR;
+    }
+
+    setup_vob(fc);
+    if (fc->logfile) {
+        unlink(fc->logfile);
+    }
+
+    memset(inst, 0, sizeof(inst));
+    for (i = 0; i < instances; i++) {
+        inst[i].id = i + 1;
+        inst[i].hash = 2166136261U;
+        inst[i].vframe = tc_new_video_frame(WIDTH, HEIGHT,
+                                            TC_CODEC_YUV420P, 0);
+        inst[i].aframe = tc_new_audio_frame(SAMPLES, 2, 16);
+        inst[i].frame = (fc->media == TC_VIDEO)
+                        ?(frame_list_t *)inst[i].vframe
+                        :(frame_list_t *)inst[i].aframe;
+
+        memset(&init, 0, sizeof(init));
+        init.tag = TC_FILTER_INIT;
+        init.filter_id = inst[i].id;
+        if (entry(&init, (char *)fc->options) < 0) {
+            tc_log_warn(__FILE__, "FAILED: %s init", fc->name);
+            ret = TC_ERROR;
+            instances = i;
+            break;
+        }
+    }
+
+    for (n = 0; n < FRAMES && ret == TC_OK; n++) {
+        for (i = 0; i < instances && ret == TC_OK; i++) {
+            ret = process_frame(entry, &inst[i], fc->media, n);
+        }
+    }
+    if (ret != TC_OK) {
+        tc_log_warn(__FILE__, "FAILED: %s on frame %i", fc->name, n - 1);
+    }
+
+    for (i = 0; i < instances; i++) {
+        memset(&init, 0, sizeof(init));
+        init.tag = TC_FILTER_CLOSE;
+        init.filter_id = inst[i].id;
+        entry(&init, NULL);
+    }
+    for (i = 0; i < 2; i++) {
+        if (inst[i].vframe) {
+            tc_del_video_frame(inst[i].vframe);
+        }
+        if (inst[i].aframe) {
+            tc_del_audio_frame(inst[i].aframe);
+        }
+    }
+    dlclose(handle);
+
+    if (ret == TC_OK && instances > 1 && inst[0].hash != inst[1].hash) {
+        tc_log_warn(__FILE__, "FAILED: %s instances disagree", fc->name);
+        ret = TC_ERROR;
+    }
+    if (ret == TC_OK && fc->logfile && instances == 1) {
+        /* not with more: they all write the same file */
+        inst[0].hash = hash_file(inst[0].hash, fc->logfile);
+    }
+    if (fc->logfile) {
+        unlink(fc->logfile);
+    }
+    *hash = inst[0].hash;
+    return ret;
+}
+
+/*************************************************************************/
+
+/* a stand-in for aart, which filter_ascii runs: give the picture back */
+static int make_fake_aart(const char *dir)
+{
+    char path[PATH_MAX], *env = NULL;
+    const char *oldpath = getenv("PATH");
+    FILE *f = NULL;
+
+    tc_snprintf(path, sizeof(path), "%s/aart", dir);
+    f = fopen(path, "w");
+    if (!f) {
+        return TC_ERROR;
+    }
+    fputs("#!/bin/sh\ncat \"$1\"\n", f);
+    fclose(f);
+    chmod(path, 0755);
+
+    env = tc_malloc(strlen(dir) + strlen((oldpath) ?oldpath :"") + 2);
+    if (!env) {
+        return TC_ERROR;
+    }
+    sprintf(env, "%s:%s", dir, (oldpath) ?oldpath :"");
+    setenv("PATH", env, 1);
+    tc_free(env);
+    return TC_OK;
+}
+
+static int test_filter(const char *modpath, const FilterCase *fc,
+                       int generate)
+{
+    const char *media = (fc->media == TC_VIDEO) ?"video" :"audio";
+    uint32_t hash = 0, hash2 = 0;
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [%s(%s) %s]", fc->name,
+                (fc->options) ?fc->options :"", media);
+
+    if (run_case(modpath, fc, 1, &hash) != TC_OK) {
+        return 1;
+    }
+    if (generate) {
+        printf("%s(%s) %s: 0x%08x\n", fc->name,
+               (fc->options) ?fc->options :"", media, hash);
+        return 0;
+    }
+    if (hash != fc->checksum) {
+        tc_log_warn(__FILE__, "FAILED: checksum 0x%08x, expected 0x%08x",
+                    hash, fc->checksum);
+        ret = 1;
+    }
+    /* instances must not share state (the log file is left out) */
+    if (run_case(modpath, fc, 2, &hash2) != TC_OK
+      || (!fc->logfile && hash2 != hash)) {
+        tc_log_warn(__FILE__, "FAILED: two instances at once");
+        ret = 1;
+    }
+    return ret;
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    char dir[] = "/tmp/test-filters.XXXXXX";
+    char modpath[PATH_MAX];
+    const char *filter = NULL;
+    int errors = 0, generate = 0, i = 0, ch = 0;
+
+    libtc_init(&argc, &argv);
+    /* plain C everywhere, so the checksums don't depend on the CPU */
+    ac_init(AC_NONE);
+
+    while ((ch = getopt(argc, argv, "f:g")) != -1) {
+        switch (ch) {
+          case 'f':
+            filter = optarg;
+            break;
+          case 'g':
+            generate = 1;
+            break;
+          default:
+            fprintf(stderr, "usage: %s [-g] [-f filter] [/module/path]\n",
+                    argv[0]);
+            exit(1);
+        }
+    }
+    if (!realpath((optind < argc) ?argv[optind] :"../filter/.libs",
+                  modpath)) {
+        tc_log_error(__FILE__, "bad module path");
+        exit(1);
+    }
+
+    if (!mkdtemp(dir) || chdir(dir) != 0 || make_fake_aart(dir) != TC_OK) {
+        tc_log_error(__FILE__, "can't set up %s", dir);
+        exit(1);
+    }
+
+    vob = tc_zalloc(sizeof(vob_t));
+
+    for (i = 0; cases[i].name != NULL; i++) {
+        if (!filter || !strcmp(filter, cases[i].name)) {
+            errors += test_filter(modpath, &cases[i], generate);
+        }
+    }
+
+    tc_free(vob);
+
+    unlink("aart");
+    if (chdir("/") == 0) {
+        rmdir(dir);
+    }
+
+    if (!generate) {
+        putchar('\n');
+        tc_log_info(__FILE__, "test summary: %i error%s (%s)",
+                    errors,
+                    (errors > 1) ?"s" :"",
+                    (errors > 0) ?"FAILED" :"PASSED");
+    }
+    return (errors > 0) ?1 :0;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -28,7 +28,9 @@
 #include "libtc/libtc.h"
 #include "libtc/tccodecs.h"
 #include "libtc/tcframes.h"
+#include "libtcutil/tcthread.h"
 #include "tccore/tc_defaults.h"
+#include "libtcvideo/tcvideo.h"
 #include "src/framebuffer.h"
 
 #ifndef PACKAGE
@@ -132,9 +134,342 @@ static int test_alloc_memset_aud(double rate, double fps, int chans, int bits)
     return ret;
 }
 
+#define ARENA_FRAMES    4
+
+/* fill up an arena, overflow it, drain it and fill it again */
+static int test_alloc_arena_vid(int w, int h, int fmtid)
+{
+    int ret = 1, i = 0, round = 0;
+    int fmt = format[fmtid];
+    size_t size = tc_video_frame_buffer_size(w, h, fmt);
+    TCArena *arena = tc_arena_new(size, ARENA_FRAMES * 2, 0);
+    vframe_list_t *vptrs[ARENA_FRAMES];
+
+    if (arena == NULL) {
+        ret = 0;
+    }
+    for (round = 0; ret && round < 2; round++) {
+        for (i = 0; i < ARENA_FRAMES; i++) {
+            vptrs[i] = tc_new_video_frame_arena(arena, w, h, fmt, 0);
+            if (vptrs[i] == NULL || vptrs[i]->video_size < (w * h * 3 / 2)) {
+                ret = 0;
+            } else {
+                memset(vptrs[i]->video_buf, 'A', vptrs[i]->video_size);
+                memset(vptrs[i]->video_buf2, 'B', vptrs[i]->video_size);
+            }
+        }
+        if (ret && tc_new_video_frame_arena(arena, w, h, fmt, 1) != NULL) {
+            ret = 0; /* arena should be exhausted by now */
+        }
+        for (i = 0; i < ARENA_FRAMES; i++) {
+            tc_del_video_frame(vptrs[i]);
+        }
+    }
+    tc_arena_del(arena);
+
+    if (ret) {
+        tc_info("testing frame (arena): width=%i height=%i format=%s -> OK",
+                w, h, strfmt[fmtid]);
+    } else {
+        tc_warn("testing frame (arena): width=%i height=%i format=%s -> FAILED",
+                w, h, strfmt[fmtid]);
+    }
+    return ret;
+}
+
+/* frame geometry is dynamic: UHD and 8K must work end to end */
+static int test_alloc_huge_vid(int w, int h, int fmtid)
+{
+    int ret = 0;
+    int fmt = format[fmtid];
+    size_t psizes[3] = { 0, 0, 0 };
+    vframe_list_t *vptr = tc_new_video_frame(w, h, fmt, 0);
+
+    tc_video_planes_size(psizes, w, h, fmt);
+    if (vptr != NULL
+     && vptr->video_size >= psizes[0] + psizes[1] + psizes[2]) {
+        /* touch both ends of both buffers */
+        vptr->video_buf[0] = vptr->video_buf2[0] = 'A';
+        vptr->video_buf[vptr->video_size - 1] = 'B';
+        vptr->video_buf2[vptr->video_size - 1] = 'B';
+        ret = 1;
+    }
+    tc_del_video_frame(vptr);
+
+    if (ret) {
+        tc_info("testing frame (huge): width=%i height=%i format=%s -> OK",
+                w, h, strfmt[fmtid]);
+    } else {
+        tc_warn("testing frame (huge): width=%i height=%i format=%s -> FAILED",
+                w, h, strfmt[fmtid]);
+    }
+    return ret;
+}
+
+/* the frame ringbuffers must follow the job size, both ways */
+static int test_ring_geometry(int w, int h)
+{
+    int ret = 0;
+    TCFrameSpecs specs = {
+        .frc = 3, .width = w, .height = h, .format = TC_CODEC_YUV420P,
+        .rate = 48000, .channels = 2, .bits = 16,
+    };
+    const TCFrameSpecs *got = NULL;
+    TCFrameBudget budget;
+    size_t need = (size_t)w * h * 3 * 2; /* RGB24, two buffers */
+
+    tc_framebuffer_set_specs(&specs);
+    got = tc_framebuffer_get_specs();
+    if (got->width >= w && got->width < w + 16
+     && got->height >= h && got->height < h + 16
+     && vframe_alloc(2, TC_FRAME_QUEUE_LOCKED) == 0) {
+        tc_framebuffer_get_budget(&budget);
+        /* big enough, and not (much) bigger than needed */
+        if (budget.video_frame >= need
+         && budget.video_frame < need + need / 8 + 65536) {
+            ret = 1;
+        }
+        vframe_free();
+    }
+
+    if (ret) {
+        tc_info("testing ringbuffer geometry: width=%i height=%i -> OK",
+                w, h);
+    } else {
+        tc_warn("testing ringbuffer geometry: width=%i height=%i -> FAILED",
+                w, h);
+    }
+    return ret;
+}
+
+enum {
+    SHARE_FRAMES = 4,
+};
+
+static void share_fill(uint8_t *buf, int size, int seed)
+{
+    int i = 0;
+    for (i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(i * 7 + seed);
+    }
+}
+
+static int share_check(const uint8_t *buf, int size, int seed)
+{
+    int i = 0;
+    for (i = 0; i < size; i++) {
+        if (buf[i] != (uint8_t)(i * 7 + seed)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* all the frames are back, unshared, each one with its own buffers */
+static int share_check_ring(void)
+{
+    TCFrameVideo *frames[SHARE_FRAMES];
+    uint8_t *bufs[SHARE_FRAMES * 2];
+    int i = 0, j = 0, ret = 1;
+
+    for (i = 0; i < SHARE_FRAMES; i++) {
+        frames[i] = vframe_register(i);
+        bufs[i * 2    ] = frames[i]->internal_video_buf_0;
+        bufs[i * 2 + 1] = frames[i]->internal_video_buf_1;
+        if (frames[i]->shared != NULL
+         || (frames[i]->video_buf != bufs[i * 2]
+          && frames[i]->video_buf != bufs[i * 2 + 1])) {
+            ret = 0;
+        }
+    }
+    for (i = 0; i < SHARE_FRAMES * 2; i++) {
+        for (j = i + 1; j < SHARE_FRAMES * 2; j++) {
+            if (bufs[i] == bufs[j]) {
+                ret = 0;
+            }
+        }
+    }
+    for (i = 0; i < SHARE_FRAMES; i++) {
+        vframe_remove(frames[i]);
+    }
+    return ret;
+}
+
+/* clones share the payload until somebody writes on it */
+static int test_ring_share(void)
+{
+    int ret = 0, size = 0;
+    TCFrameSpecs specs = {
+        .frc = 3, .width = 320, .height = 240, .format = TC_CODEC_YUV420P,
+        .rate = 48000, .channels = 2, .bits = 16,
+    };
+    TCFrameVideo *orig = NULL, *clone = NULL, *clone2 = NULL;
+    unsigned long copied = 0;
+
+    tc_framebuffer_set_specs(&specs);
+    if (vframe_alloc(SHARE_FRAMES, TC_FRAME_QUEUE_LOCKED) == 0) {
+        orig = vframe_register(1);
+        size = orig->video_size;
+        share_fill(orig->video_buf, size, 1);
+        copied = tc_framebuffer_get_copied();
+
+        clone  = vframe_dup(orig);
+        clone2 = vframe_dup(clone);
+        ret = (clone->video_buf == orig->video_buf
+            && clone2->video_buf == orig->video_buf
+            && tc_framebuffer_get_copied() == copied);
+
+        /* a private copy for the writer, nobody else sees the change */
+        vframe_unshare(clone);
+        ret = ret && clone->video_buf != orig->video_buf
+                  && share_check(clone->video_buf, size, 1)
+                  && tc_framebuffer_get_copied() == copied + size;
+        share_fill(clone->video_buf, size, 2);
+        ret = ret && share_check(orig->video_buf, size, 1)
+                  && share_check(clone2->video_buf, size, 1);
+
+        /* the owner goes away first: the payload must survive it */
+        vframe_remove(orig);
+        ret = ret && share_check(clone2->video_buf, size, 1);
+        vframe_unshare(clone2); /* alone now: nothing to copy */
+        ret = ret && share_check(clone2->video_buf, size, 1)
+                  && tc_framebuffer_get_copied() == copied + size;
+
+        vframe_remove(clone);
+        vframe_remove(clone2);
+        ret = ret && share_check_ring();
+
+        /* flushing frames which are still sharing */
+        orig  = vframe_register(1);
+        clone = vframe_dup(orig);
+        vframe_push_next(orig, TC_FRAME_WAIT);
+        vframe_push_next(clone, TC_FRAME_WAIT);
+        vframe_flush();
+        ret = ret && share_check_ring();
+
+        vframe_free();
+    }
+
+    if (ret) {
+        tc_info("testing ringbuffer payload sharing -> OK");
+    } else {
+        tc_warn("testing ringbuffer payload sharing -> FAILED");
+    }
+    return ret;
+}
+
+typedef struct sharewriter_ ShareWriter;
+struct sharewriter_ {
+    TCFrameVideo    *frame;
+    int             seed;
+    int             ok;
+};
+
+static int share_writer(TCThreadData *td, void *datum)
+{
+    ShareWriter *W = datum;
+    int size = W->frame->video_size;
+
+    vframe_unshare(W->frame);
+    W->ok = share_check(W->frame->video_buf, size, 1);
+    share_fill(W->frame->video_buf, size, W->seed);
+    return 0;
+}
+
+/* the clones copy the payload away while the owner goes away */
+static int test_ring_share_threads(void)
+{
+    int ret = 0, size = 0, i = 0, j = 0, round = 0;
+    TCFrameSpecs specs = {
+        .frc = 3, .width = 320, .height = 240, .format = TC_CODEC_YUV420P,
+        .rate = 48000, .channels = 2, .bits = 16,
+    };
+    ShareWriter writers[SHARE_FRAMES - 1];
+    TCThread threads[SHARE_FRAMES - 1];
+    TCFrameVideo *orig = NULL;
+
+    tc_framebuffer_set_specs(&specs);
+    if (vframe_alloc(SHARE_FRAMES, TC_FRAME_QUEUE_LOCKED) == 0) {
+        ret = 1;
+        for (round = 0; round < 50 && ret; round++) {
+            orig = vframe_register(1);
+            size = orig->video_size;
+            share_fill(orig->video_buf, size, 1);
+            for (i = 0; i < SHARE_FRAMES - 1; i++) {
+                writers[i].frame = vframe_dup(orig);
+                writers[i].seed  = i + 2;
+                writers[i].ok    = 0;
+            }
+            for (i = 0; i < SHARE_FRAMES - 1; i++) {
+                tc_thread_init(&threads[i], "writer");
+                tc_thread_start(&threads[i], share_writer, &writers[i]);
+            }
+            vframe_remove(orig);
+            for (i = 0; i < SHARE_FRAMES - 1; i++) {
+                tc_thread_wait(&threads[i], NULL);
+            }
+
+            for (i = 0; i < SHARE_FRAMES - 1; i++) {
+                TCFrameVideo *f = writers[i].frame;
+                ret = ret && writers[i].ok && f->shared == NULL
+                          && share_check(f->video_buf, size, writers[i].seed);
+                for (j = i + 1; j < SHARE_FRAMES - 1; j++) {
+                    ret = ret && f->video_buf != writers[j].frame->video_buf;
+                }
+            }
+            for (i = 0; i < SHARE_FRAMES - 1; i++) {
+                vframe_remove(writers[i].frame);
+            }
+            ret = ret && share_check_ring();
+        }
+        vframe_free();
+    }
+
+    if (ret) {
+        tc_info("testing concurrent payload unsharing -> OK");
+    } else {
+        tc_warn("testing concurrent payload unsharing -> FAILED");
+    }
+    return ret;
+}
+
+/* no fixed size tables or scratch buffers in the video transformations */
+static int test_tcvideo_huge(int w, int h)
+{
+    int ret = 0;
+    TCVHandle handle = tcv_init();
+    uint8_t *src = tc_zalloc((size_t)w * h * 3);
+    uint8_t *dst = tc_zalloc((size_t)w * h * 3 * 9 / 4);
+
+    if (handle != NULL && src != NULL && dst != NULL) {
+        ret = tcv_zoom(handle, src, dst, w, h, 1, w / 2, h / 2,
+                       TCV_ZOOM_TRIANGLE)
+           && tcv_resize(handle, src, dst, w, h, 1, w / 16, 0, 8, 8)
+           && tcv_resize(handle, src, dst, w, h, 1, 0, h / 16, 8, 8)
+           && tcv_flip_v(handle, src, src, w, h, 3);
+    }
+    tc_free(dst);
+    tc_free(src);
+    tcv_free(handle);
+
+    if (ret) {
+        tc_info("testing tcvideo (huge): width=%i height=%i -> OK", w, h);
+    } else {
+        tc_warn("testing tcvideo (huge): width=%i height=%i -> FAILED",
+                w, h);
+    }
+    return ret;
+}
 
 #define LEN(a)  (sizeof(a)/sizeof((a)[0]))
 
+/* stubs */
+int tc_running(void);
+int tc_running(void)
+{
+    return TC_TRUE;
+}
+
 int main(int argc, char *argv[])
 {
     int width[] = { 128, 320, 576, 640, 960, 1024, 1280, 2048 };
@@ -194,9 +529,36 @@ int main(int argc, char *argv[])
         }
     }
 
+    for (f = 0; f < LEN(format); f++) {
+        for (w = 0; w < LEN(width); w++) {
+            succesfull += test_alloc_arena_vid(width[w], height[w], f);
+            runned++;
+        }
+    }
+
+    for (f = 0; f < LEN(format); f++) {
+        succesfull += test_alloc_huge_vid(3840, 2160, f);
+        succesfull += test_alloc_huge_vid(7680, 4320, f);
+        runned += 2;
+    }
+
+    succesfull += test_ring_geometry(7680, 4320);
+    succesfull += test_ring_geometry(3840, 2160);
+    succesfull += test_ring_geometry(720, 576);
+    succesfull += test_ring_geometry(350, 238);
+    runned += 4;
+
+    succesfull += test_ring_share();
+    succesfull += test_ring_share_threads();
+    runned += 2;
+
+    succesfull += test_tcvideo_huge(3840, 2160);
+    succesfull += test_tcvideo_huge(7680, 4320);
+    runned += 2;
+
     tc_info("test summary: %i tests runned, %i succesfully",
             runned, succesfull);
-    return 0;
+    return (succesfull == runned) ?0 :1;
 }
 
 /*************************************************************************/
@@ -80,7 +80,7 @@ static void clear_signals(void)
     signal(SIGILL , old_SIGILL );
 }
 
-/* Return value: >=0 is time/iteration in usec, <0 is error
+/* Return value: >0 is time/iteration in nsec, <0 is error
  *   -1: unknown error
  *   -2: ac_init(0) failed
  *   -3: ac_init(accel) failed
@@ -170,7 +170,8 @@ static int testit(uint8_t *srcimage, ImageFormat srcfmt, ImageFormat destfmt,
     } while (stop-start < MINTIME*1000);
 
     clear_signals();
-    return (stop-start + icnt/2) / icnt;
+    tdiff = ((stop-start)*1000 + icnt/2) / icnt;
+    return tdiff > 0 ? tdiff : 1;
 }
 
 /*************************************************************************/
@@ -225,10 +226,115 @@ static int checkall(uint8_t *srcimage, int accel, const char *name)
 
 /*************************************************************************/
 
+/* Check ac_imgconvert_image() on a sub-rectangle of a larger source image
+ * and a destination with padded rows, against ac_imgconvert() on
+ * contiguous copies; return 1 (no failures) or 0 (some failures) */
+
+#define SUB_X           16
+#define SUB_Y           6
+#define SUB_WIDTH       364
+#define SUB_HEIGHT      130
+#define SUB_ALIGN       64
+
+/* Number of rows in plane `p' of an image set up by ac_image_init() */
+static int plane_rows(const ACImage *img, int p)
+{
+    if (p == 0)
+        return img->height;
+    return UV_PLANE_SIZE(img->format, img->width, img->height)
+         / img->stride[p];
+}
+
+static int checkimage_one(uint8_t *srcimage, ImageFormat srcfmt,
+                          ImageFormat destfmt, int verbose)
+{
+    static __attribute__((aligned(64))) uint8_t srcbuf[WIDTH*HEIGHT*4],
+        tightbuf[WIDTH*HEIGHT*4], destbuf[WIDTH*HEIGHT*4],
+        cmpbuf[WIDTH*HEIGHT*4];
+    ACImage big, sub, tight, dest, cmp;
+    int p, y, x;
+
+    ac_memcpy(srcbuf, srcimage, sizeof(srcbuf));
+    memset(destbuf, 0, sizeof(destbuf));
+    memset(cmpbuf, 0, sizeof(cmpbuf));
+    if (!ac_image_init(&big, srcfmt, srcbuf, WIDTH, HEIGHT, 0)
+     || !ac_image_crop(&sub, &big, SUB_X, SUB_Y, SUB_WIDTH, SUB_HEIGHT)
+     || !ac_image_init(&tight, srcfmt, tightbuf, SUB_WIDTH, SUB_HEIGHT, 0)
+     || !ac_image_init(&dest, destfmt, destbuf, SUB_WIDTH, SUB_HEIGHT,
+                       SUB_ALIGN)
+     || !ac_image_init(&cmp, destfmt, cmpbuf, SUB_WIDTH, SUB_HEIGHT, 0)
+    ) {
+        if (verbose)
+            fprintf(stderr, "*** image setup failed\n");
+        return 0;
+    }
+    for (p = 0; p < 3 && tight.planes[p]; p++) {
+        for (y = 0; y < plane_rows(&tight, p); y++) {
+            memcpy(tight.planes[p] + y*tight.stride[p],
+                   sub.planes[p] + y*sub.stride[p], tight.stride[p]);
+        }
+    }
+
+    if (!ac_imgconvert(tight.planes, srcfmt, cmp.planes, destfmt,
+                       SUB_WIDTH, SUB_HEIGHT)
+     || !ac_imgconvert_image(&sub, &dest)
+    ) {
+        if (verbose)
+            fprintf(stderr, "*** conversion failed\n");
+        return 0;
+    }
+
+    for (p = 0; p < 3 && cmp.planes[p]; p++) {
+        for (y = 0; y < plane_rows(&cmp, p); y++) {
+            for (x = 0; x < cmp.stride[p]; x++) {
+                int want = cmp.planes[p][y*cmp.stride[p] + x];
+                int have = dest.planes[p][y*dest.stride[p] + x];
+                if (want - have < -1 || want - have > 1) {
+                    if (verbose) {
+                        fprintf(stderr, "*** compare error: plane %d at"
+                                " %d,%d (want=%d have=%d)\n",
+                                p, x, y, want, have);
+                    }
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+static int checkimage(uint8_t *srcimage, int accel, const char *name)
+{
+    int i, j;
+    int failures = 0;
+
+    if (!ac_init(accel))
+        return 0;
+    for (i = 0; fmtlist[i].fmt != IMG_NONE; i++) {
+        for (j = 0; fmtlist[j].fmt != IMG_NONE; j++) {
+            if (!checkimage_one(srcimage, fmtlist[i].fmt, fmtlist[j].fmt,
+                                name != NULL)) {
+                printf("FAILED: %s -> %s (image)\n",
+                       fmtlist[i].name, fmtlist[j].name);
+                failures++;
+            }
+        }
+    }
+    if (name) {
+        if (failures)
+            printf("%s: %d image conversions failed.\n", name, failures);
+        else
+            printf("%s: All image conversions succeeded.\n", name);
+    }
+    return failures == 0;
+}
+
+/*************************************************************************/
+
 static const char *accel_flags(int accel)
 {
     static char buf[1000];
-    snprintf(buf, sizeof(buf), "%s%s%s%s%s%s%s%s%s%s",
+    snprintf(buf, sizeof(buf), "%s%s%s%s%s%s%s%s%s%s%s%s",
            !accel                ? " none"     : "",
            (accel & AC_IA32ASM ) ? " ia32asm"  : "",
            (accel & AC_AMD64ASM) ? " amd64asm" : "",
@@ -238,26 +344,86 @@ static const char *accel_flags(int accel)
            (accel & AC_3DNOW   ) ? " 3dnow"    : "",
            (accel & AC_SSE     ) ? " sse"      : "",
            (accel & AC_SSE2    ) ? " sse2"     : "",
-           (accel & AC_SSE3    ) ? " sse3"     : "");
+           (accel & AC_SSE3    ) ? " sse3"     : "",
+           (accel & AC_AVX     ) ? " avx"      : "",
+           (accel & AC_AVX2    ) ? " avx2"     : "");
     return buf;
 }
 
+/*************************************************************************/
+
+/* Report the throughput of each conversion, counting both the source and
+ * destination data, along with the formats it goes through */
+
+static const char *fmt_name(ImageFormat fmt)
+{
+    int i;
+    for (i = 0; fmtlist[i].fmt != IMG_NONE; i++) {
+        if (fmtlist[i].fmt == fmt)
+            return fmtlist[i].name;
+    }
+    return "????";
+}
+
+static int report_mbps(uint8_t *srcimage, int width, int height, int accel,
+                       int verbose)
+{
+    int i, j, k;
+
+    printf("Units: MB/s of source + destination data"
+           " (frame size: %dx%d)\n\n", width, height);
+    for (i = 0; fmtlist[i].fmt != IMG_NONE; i++) {
+        if (fmtlist[i].disabled)
+            continue;
+        for (j = 0; fmtlist[j].fmt != IMG_NONE; j++) {
+            ImageFormat via[2];
+            int res, hops, bytes;
+            if (fmtlist[j].disabled)
+                continue;
+            printf("%s -> %s ", fmtlist[i].name, fmtlist[j].name);
+            fflush(stdout);
+            res = testit(srcimage, fmtlist[i].fmt, fmtlist[j].fmt,
+                         width, height, accel, verbose, 0);
+            switch (res) {
+                case -1:
+                case -2:
+                case -3:
+                case -4:
+                case -5: printf("    ----\n"); continue;
+                case -6: printf("     BAD\n"); continue;
+                case -7: printf("    SEGV\n"); continue;
+                case -8: printf("     ILL\n"); continue;
+            }
+            bytes = ac_image_size(fmtlist[i].fmt, width, height, 0)
+                  + ac_image_size(fmtlist[j].fmt, width, height, 0);
+            printf("%8.1f", bytes * 1e9 / res / 1048576.0);
+            hops = ac_imgconvert_route(fmtlist[i].fmt, fmtlist[j].fmt, via);
+            for (k = 0; k < hops-1; k++)
+                printf("%s%s", k ? " -> " : "  (via ", fmt_name(via[k]));
+            printf("%s\n", hops > 1 ? ")" : "");
+        }
+    }
+    return 0;
+}
+
+/*************************************************************************/
 
 int main(int argc, char **argv)
 {
     static uint8_t srcbuf[WIDTH*HEIGHT*4];
-    int check = 0, accel = 0, compare = 0, verbose = 0, width = WIDTH,
-        height = HEIGHT;
+    int check = 0, accel = 0, compare = 0, mbps = 0, verbose = 0,
+        width = WIDTH, height = HEIGHT;
     int i, j;
 
     while (argc > 1) {
         if (strcmp(argv[--argc],"-h") == 0) {
             fprintf(stderr,
-"Usage: %s [-C] [-c] [-v] [=fmt-name[,fmt-name...]] [@WIDTHxHEIGHT] [accel-name...]\n",
+"Usage: %s [-C] [-c] [-m] [-v] [=fmt-name[,fmt-name...]] [@WIDTHxHEIGHT] [accel-name...]\n",
                     argv[0]);
             fprintf(stderr,
 "-C: check all testable accelerated routines and exit with success/failure\n"
 "-c: compare with non-accelerated versions and report percentage speedup\n"
+"-m: report MB/s (source + destination data) and route for each format pair\n"
 "-v: verbose (report details of comparison failures; with -C, print test names)\n"
 "=: select formats to test\n"
 "   fmt-name can be:");
@@ -279,6 +445,8 @@ int main(int argc, char **argv)
             check = 1;
         else if (strcmp(argv[argc],"-c") == 0)
             compare = 1;
+        else if (strcmp(argv[argc],"-m") == 0)
+            mbps = 1;
         else if (strcmp(argv[argc],"-v") == 0)
             verbose = 1;
         else if (strcmp(argv[argc],"ia32asm") == 0)
@@ -301,6 +469,10 @@ int main(int argc, char **argv)
             accel |= AC_SSE2;
         else if (strcmp(argv[argc],"sse3") == 0)
             accel |= AC_SSE3;
+        else if (strcmp(argv[argc],"avx") == 0)
+            accel |= AC_AVX;
+        else if (strcmp(argv[argc],"avx2") == 0)
+            accel |= AC_AVX2;
         else if (argv[argc][0] == '=') {
             char *s = argv[argc]+1;
             for (i = 0; fmtlist[i].fmt != IMG_NONE; i++) {
@@ -379,10 +551,22 @@ int main(int argc, char **argv)
                           verbose ? "sse2" : NULL))
                 return 1;
         }
+        if (ac_cpuinfo() & AC_AVX2) {
+            if (!checkall(srcbuf, AC_IA32ASM | AC_AMD64ASM | AC_CMOVE
+                                | AC_MMX | AC_SSE | AC_SSE2 | AC_AVX | AC_AVX2,
+                          verbose ? "avx2" : NULL))
+                return 1;
+        }
+        if (!checkimage(srcbuf, 0, verbose ? "image" : NULL)
+         || !checkimage(srcbuf, ac_cpuinfo(),
+                        verbose ? "image/accel" : NULL))
+            return 1;
         return 0;
     }
 
     printf("Acceleration flags:%s\n", accel_flags(accel));
+    if (mbps)
+        return report_mbps(srcbuf, width, height, accel, verbose);
     if (compare)
         printf("Units: conversions/time (unaccelerated = 100)\n\n");
     else
@@ -428,7 +612,7 @@ int main(int argc, char **argv)
                         else
                             printf("%4d|", (100*res0 + res/2) / res);
                     } else {
-                        printf("%4d|", (1000000+res/2)/res);
+                        printf("%4d|", (int)((1000000000LL+res/2)/res));
                     }
                     break;
             }
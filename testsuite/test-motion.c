@@ -0,0 +1,456 @@
+/*
+ * test-motion.c - test all aclib block matching implementations
+ *
+ * This file is part of transcode, a video stream processing tool.
+ * transcode is free software, distributable under the terms of the GNU
+ * General Public License (version 2 or later).  See the file COPYING
+ * for details.
+ */
+
+#define _GNU_SOURCE  /* for strsignal */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "config.h"
+
+#define ac_sad local_ac_sad  /* to avoid clash with libac.a */
+#define ac_sad_avg local_ac_sad_avg
+#define ac_ssd local_ac_ssd
+#define ac_motion_search local_ac_motion_search
+#define ac_motion_search_hier local_ac_motion_search_hier
+#define ac_motion_halfpel local_ac_motion_halfpel
+#define ac_downsample2 local_ac_downsample2
+#define ac_motion_init local_ac_motion_init
+#include "aclib/ac.h"
+
+/* Include motion.c directly for access to the particular implementations */
+#include "../aclib/motion.c"
+/* Make sure all names are available, to simplify function table */
+#if !defined(HAVE_ASM_SSE2)
+# define sad_sse2 sad
+# define sad_avg_sse2 sad_avg
+# define ssd_sse2 ssd
+#endif
+#if !defined(HAVE_ASM_AVX2)
+# define sad_avx2 sad_sse2
+# define sad_avg_avx2 sad_avg_sse2
+#endif
+
+/* Size of the test planes */
+#define PLANE   256
+
+typedef uint32_t (*SADFunc)(const uint8_t *, int, const uint8_t *, int,
+                            int, int);
+typedef uint32_t (*SADAvgFunc)(const uint8_t *, int, const uint8_t *,
+                               const uint8_t *, int, int, int);
+typedef uint64_t (*SSDFunc)(const uint8_t *, int, const uint8_t *, int,
+                            int, int);
+
+/*************************************************************************/
+
+static void *old_SIGSEGV = NULL, *old_SIGILL = NULL;
+static sigjmp_buf env;
+
+
+static void sighandler(int sig)
+{
+    printf("*** %s\n", strsignal(sig));
+    siglongjmp(env, 1);
+}
+
+static void set_signals(void)
+{
+    old_SIGSEGV = signal(SIGSEGV, sighandler);
+    old_SIGILL  = signal(SIGILL , sighandler);
+}
+
+static void clear_signals(void)
+{
+    signal(SIGSEGV, old_SIGSEGV);
+    signal(SIGILL , old_SIGILL );
+}
+
+/*************************************************************************/
+
+/* Test data: random planes, and a smooth one (blurred noise) for the
+ * stepped and pyramid searches, which need nearby positions to match
+ * nearly as well. */
+
+static uint8_t plane1[PLANE*PLANE], plane2[PLANE*PLANE];
+static uint8_t plane3[PLANE*PLANE], smooth[PLANE*PLANE];
+
+static void gen_data(void)
+{
+    static uint8_t tmp[PLANE*PLANE];
+    int i, x, y, pass;
+
+    for (i = 0; i < PLANE*PLANE; i++) {
+        plane1[i] = rand();
+        plane2[i] = rand();
+        plane3[i] = rand();
+        smooth[i] = rand();
+    }
+    for (pass = 0; pass < 3; pass++) {
+        for (y = 0; y < PLANE; y++) {
+            for (x = 0; x < PLANE; x++) {
+                int sum = 0, dx, dy;
+                for (dy = -3; dy <= 3; dy++) {
+                    for (dx = -3; dx <= 3; dx++) {
+                        int sx = (x+dx+PLANE) % PLANE;
+                        int sy = (y+dy+PLANE) % PLANE;
+                        sum += smooth[sy*PLANE + sx];
+                    }
+                }
+                tmp[y*PLANE + x] = sum / 49;
+            }
+        }
+        memcpy(smooth, tmp, sizeof(smooth));
+    }
+    /* Stretch the contrast back out */
+    for (i = 0; i < PLANE*PLANE; i++) {
+        int v = (smooth[i] - 128) * 8 + 128;
+        smooth[i] = v < 0 ? 0 : v > 255 ? 255 : v;
+    }
+}
+
+/* Fill `dest' with `src' moved by mx,my (so that the block at x,y of `src'
+ * is at x+mx,y+my of `dest'), wrapping around at the edges. */
+
+static void shift_plane(const uint8_t *src, uint8_t *dest, int mx, int my)
+{
+    int x, y;
+
+    for (y = 0; y < PLANE; y++) {
+        for (x = 0; x < PLANE; x++) {
+            int sx = (x - mx + PLANE) % PLANE, sy = (y - my + PLANE) % PLANE;
+            dest[y*PLANE + x] = src[sy*PLANE + sx];
+        }
+    }
+}
+
+/*************************************************************************/
+
+/* Test the block functions at the given size against the C versions,
+ * with blocks at random places in the test planes.  Returns nonzero on
+ * success, zero on failure. */
+
+static int test_block(SADFunc sadfunc, SADAvgFunc avgfunc, SSDFunc ssdfunc,
+                      int width, int height, int verbose)
+{
+    int stride1 = width + rand() % 40, stride2 = width + rand() % 40;
+    int max1 = PLANE*PLANE - ((height-1)*stride1 + width);
+    int max2 = PLANE*PLANE - ((height-1)*stride2 + width) - stride2;
+    const uint8_t *s1 = plane1 + rand() % (max1+1);
+    const uint8_t *s2 = plane2 + rand() % (max2+1);
+    const uint8_t *s3 = s2 + stride2;
+    uint32_t sad_expect, avg_expect, sad_result = 0, avg_result = 0;
+    uint64_t ssd_expect, ssd_result = 0;
+    int ok;
+
+    sad_expect = sad(s1, stride1, s2, stride2, width, height);
+    avg_expect = sad_avg(s1, stride1, s2, s3, stride2, width, height);
+    ssd_expect = ssd(s1, stride1, s2, stride2, width, height);
+    set_signals();
+    if (sigsetjmp(env, 1)) {
+        ok = 0;
+    } else {
+        sad_result = (*sadfunc)(s1, stride1, s2, stride2, width, height);
+        avg_result = (*avgfunc)(s1, stride1, s2, s3, stride2,
+                                width, height);
+        ssd_result = (*ssdfunc)(s1, stride1, s2, stride2, width, height);
+        ok = (sad_result == sad_expect && avg_result == avg_expect
+              && ssd_result == ssd_expect);
+    }
+    clear_signals();
+    if (!ok && verbose) {
+        fprintf(stderr, "SAD %u (expected %u), average SAD %u (expected"
+                " %u), SSD %llu (expected %llu)\n", sad_result, sad_expect,
+                avg_result, avg_expect, (unsigned long long)ssd_result,
+                (unsigned long long)ssd_expect);
+    }
+    return ok;
+}
+
+/* Test the block functions on the largest differences possible, for
+ * overflow. */
+
+static int test_extreme(SADFunc sadfunc, SADAvgFunc avgfunc,
+                        SSDFunc ssdfunc, int verbose)
+{
+    static uint8_t zero[PLANE*PLANE], full[PLANE*PLANE];
+    const uint32_t sad_expect = 255u * PLANE*PLANE;
+    const uint64_t ssd_expect = 255ull*255 * PLANE*PLANE;
+    uint32_t sad_result = 0, avg_result = 0;
+    uint64_t ssd_result = 0;
+    int ok;
+
+    memset(full, 255, sizeof(full));
+    set_signals();
+    if (sigsetjmp(env, 1)) {
+        ok = 0;
+    } else {
+        sad_result = (*sadfunc)(zero, PLANE, full, PLANE, PLANE, PLANE);
+        avg_result = (*avgfunc)(full, PLANE, zero, zero, PLANE,
+                                PLANE, PLANE);
+        ssd_result = (*ssdfunc)(full, PLANE, zero, PLANE, PLANE, PLANE);
+        ok = (sad_result == sad_expect && avg_result == sad_expect
+              && ssd_result == ssd_expect);
+    }
+    clear_signals();
+    if (!ok && verbose) {
+        fprintf(stderr, "Extremes: SAD %u, average SAD %u, SSD %llu\n",
+                sad_result, avg_result, (unsigned long long)ssd_result);
+    }
+    return ok;
+}
+
+/* Test the searches, using the given block functions, on a plane moved by
+ * a known amount. */
+
+static int test_search(SADFunc sadfunc, SADAvgFunc avgfunc, int verbose)
+{
+    static uint8_t moved[PLANE*PLANE], cur[PLANE*PLANE];
+    static uint8_t pyr_cur[2][PLANE*PLANE/4], pyr_ref[2][PLANE*PLANE/4];
+    const uint8_t *curs[3], *refs[3];
+    int strides[3] = {PLANE, PLANE/2, PLANE/4};
+    int mx = rand() % 21 - 10, my = rand() % 21 - 10;
+    const int bx = 96, by = 112, offset = by*PLANE + bx;
+    ACMotionVector mv;
+    int ok = 1, x, y;
+
+    sad_ptr = sadfunc;
+    sad_avg_ptr = avgfunc;
+
+    /* Full-pixel searches */
+    shift_plane(plane3, moved, mx, my);
+    mv.x = mv.y = 0;
+    ac_motion_search(plane3 + offset, PLANE, moved + offset, PLANE,
+                     16, 16, 10, 1, &mv);
+    if (mv.x != mx || mv.y != my || mv.cost != 0) {
+        if (verbose)
+            fprintf(stderr, "Search found %d,%d (%u), expected %d,%d\n",
+                    mv.x, mv.y, mv.cost, mx, my);
+        ok = 0;
+    }
+    /* A stepped search needs an image that changes slowly enough for the
+     * grid to land near the match */
+    shift_plane(smooth, moved, mx, my);
+    mv.x = mv.y = 0;
+    ac_motion_search(smooth + offset, PLANE, moved + offset, PLANE,
+                     16, 16, 10, 4, &mv);
+    if (mv.x != mx || mv.y != my || mv.cost != 0) {
+        if (verbose)
+            fprintf(stderr, "Step search found %d,%d (%u), expected %d,%d\n",
+                    mv.x, mv.y, mv.cost, mx, my);
+        ok = 0;
+    }
+
+    /* Half-pixel refinement, on a block halfway between two pixels */
+    shift_plane(plane3, moved, mx, my);
+    for (y = 0; y < PLANE-1; y++) {
+        for (x = 0; x < PLANE-1; x++) {
+            int i = y*PLANE + x;
+            cur[i] = (moved[i + mx + my*PLANE]
+                      + moved[i + mx+1 + (my+1)*PLANE] + 1) >> 1;
+        }
+    }
+    mv.x = mx;
+    mv.y = my;
+    ac_motion_halfpel(cur + offset, PLANE, moved + offset, PLANE,
+                      16, 16, &mv);
+    if (mv.x != mx*2+1 || mv.y != my*2+1 || mv.cost != 0) {
+        if (verbose)
+            fprintf(stderr, "Half-pixel search found %d,%d (%u), expected"
+                    " %d,%d\n", mv.x, mv.y, mv.cost, mx*2+1, my*2+1);
+        ok = 0;
+    }
+
+    /* Three-level pyramid, on the smooth plane */
+    shift_plane(smooth, moved, mx*2, my*2);
+    ac_downsample2(smooth, PLANE, pyr_cur[0], PLANE/2, PLANE/2, PLANE/2);
+    ac_downsample2(pyr_cur[0], PLANE/2, pyr_cur[1], PLANE/4,
+                   PLANE/4, PLANE/4);
+    ac_downsample2(moved, PLANE, pyr_ref[0], PLANE/2, PLANE/2, PLANE/2);
+    ac_downsample2(pyr_ref[0], PLANE/2, pyr_ref[1], PLANE/4,
+                   PLANE/4, PLANE/4);
+    curs[0] = smooth;
+    curs[1] = pyr_cur[0];
+    curs[2] = pyr_cur[1];
+    refs[0] = moved;
+    refs[1] = pyr_ref[0];
+    refs[2] = pyr_ref[1];
+    ac_motion_search_hier(curs, refs, strides, 3, bx, by, 32, 32, 24, &mv);
+    if (mv.x != mx*2 || mv.y != my*2 || mv.cost != 0) {
+        if (verbose)
+            fprintf(stderr, "Pyramid search found %d,%d (%u), expected"
+                    " %d,%d\n", mv.x, mv.y, mv.cost, mx*2, my*2);
+        ok = 0;
+    }
+
+    sad_ptr = sad;
+    sad_avg_ptr = sad_avg;
+    return ok;
+}
+
+/*************************************************************************/
+
+/* Return the time taken for `count' SADs (or SSDs) of the given size, in
+ * microseconds. */
+
+static long time_sad(SADFunc func, int size, int count)
+{
+    struct timeval tv0, tv1;
+    volatile uint32_t sink = 0;
+    int i;
+
+    gettimeofday(&tv0, NULL);
+    for (i = 0; i < count; i++)
+        sink += (*func)(plane1, PLANE, plane2 + (i & 63), PLANE, size, size);
+    gettimeofday(&tv1, NULL);
+    return (tv1.tv_sec - tv0.tv_sec) * 1000000L + (tv1.tv_usec - tv0.tv_usec);
+}
+
+static long time_ssd(SSDFunc func, int size, int count)
+{
+    struct timeval tv0, tv1;
+    volatile uint64_t sink = 0;
+    int i;
+
+    gettimeofday(&tv0, NULL);
+    for (i = 0; i < count; i++)
+        sink += (*func)(plane1, PLANE, plane2 + (i & 63), PLANE, size, size);
+    gettimeofday(&tv1, NULL);
+    return (tv1.tv_sec - tv0.tv_sec) * 1000000L + (tv1.tv_usec - tv0.tv_usec);
+}
+
+/*************************************************************************/
+
+/* Turn presence/absence of #define into a number */
+#if defined(HAVE_ASM_SSE2)
+# define defined_HAVE_ASM_SSE2 1
+#else
+# define defined_HAVE_ASM_SSE2 0
+#endif
+#if defined(HAVE_ASM_AVX2)
+# define defined_HAVE_ASM_AVX2 1
+#else
+# define defined_HAVE_ASM_AVX2 0
+#endif
+
+/* List of routines to test, NULL-terminated */
+static struct {
+    const char *name;
+    int arch_ok;  /* defined(ARCH_xxx), etc. */
+    int acflags;  /* required ac_cpuinfo() flags */
+    SADFunc sad;
+    SADAvgFunc sad_avg;
+    SSDFunc ssd;
+} testfuncs[] = {
+    { "c",    1,                                0,
+              sad,      sad_avg,      ssd },
+    { "sse2", defined_HAVE_ASM_SSE2,            AC_SSE2,
+              sad_sse2, sad_avg_sse2, ssd_sse2 },
+    { "avx2", defined_HAVE_ASM_AVX2,            AC_AVX2,
+              sad_avx2, sad_avg_avx2, ssd_sse2 },
+    { NULL }
+};
+
+/* Parameters to test */
+static const int widths[] = {1, 3, 4, 7, 8, 9, 15, 16, 17, 24, 31, 32, 33,
+                             48, 63, 64, 65, 200};
+static const int heights[] = {1, 2, 4, 8, 16, 17, 64};
+
+#define lenof(a)  (sizeof(a) / sizeof(*(a)))
+
+/*************************************************************************/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [-v] [-t]\n", argv0);
+    fprintf(stderr, "-v: verbose (print error details)\n");
+    fprintf(stderr, "-t: print timings\n");
+}
+
+int main(int argc, char **argv)
+{
+    int verbose = 0, timing = 0;
+    int failed = 0;
+    int ch, i;
+
+    while ((ch = getopt(argc, argv, "htv")) != EOF) {
+        if (ch == 't') {
+            timing = 1;
+        } else if (ch == 'v') {
+            verbose = 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    srand(42);
+    gen_data();
+    for (i = 0; testfuncs[i].name; i++) {
+        int w, h, n;
+        if (!testfuncs[i].arch_ok
+         || (ac_cpuinfo() & testfuncs[i].acflags) != testfuncs[i].acflags)
+            continue;
+        for (w = 0; i > 0 && w < lenof(widths); w++) {
+            for (h = 0; h < lenof(heights); h++) {
+                if (!test_block(testfuncs[i].sad, testfuncs[i].sad_avg,
+                                testfuncs[i].ssd, widths[w], heights[h],
+                                verbose)) {
+                    printf("FAILED: %s block, %dx%d\n",
+                           testfuncs[i].name, widths[w], heights[h]);
+                    failed = 1;
+                }
+            }
+        }
+        if (i > 0 && !test_extreme(testfuncs[i].sad, testfuncs[i].sad_avg,
+                                   testfuncs[i].ssd, verbose)) {
+            printf("FAILED: %s extremes\n", testfuncs[i].name);
+            failed = 1;
+        }
+        for (n = 0; n < 8; n++) {
+            if (!test_search(testfuncs[i].sad, testfuncs[i].sad_avg,
+                             verbose)) {
+                printf("FAILED: %s search\n", testfuncs[i].name);
+                failed = 1;
+            }
+        }
+    }
+
+    if (timing) {
+        for (i = 0; testfuncs[i].name; i++) {
+            if (!testfuncs[i].arch_ok
+             || (ac_cpuinfo() & testfuncs[i].acflags)
+                != testfuncs[i].acflags)
+                continue;
+            printf("%-4s: SAD 8x8/16x16/64x64 %6ld/%6ld/%6ld us,"
+                   " SSD 16x16 %6ld us\n", testfuncs[i].name,
+                   time_sad(testfuncs[i].sad, 8, 100000),
+                   time_sad(testfuncs[i].sad, 16, 100000),
+                   time_sad(testfuncs[i].sad, 64, 10000),
+                   time_ssd(testfuncs[i].ssd, 16, 100000));
+        }
+    }
+
+    return failed;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,263 @@
+/*
+ * test-pread-speed.c -- time frame reads from a pipe, as done by the
+ *                       import layer for old-style import modules.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A child process writes frames on a pipe, one write(2) per frame, as
+ * the import tools do; the parent reads them back with each strategy
+ * and reports the read(2) calls per frame and the throughput:
+ *
+ *   block: the old mfread(), PIPE_BUF bytes at time;
+ *   frame: ask for the whole missing data at each read (tc_pread);
+ *   grown: as `frame', after tc_pipe_grow() to the frame size.
+ *
+ * Usage: test-pread-speed [-n frames] [frame_size ...]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "config.h"
+#include "libtc/libtc.h"
+
+
+/*************************************************************************/
+
+#ifdef PIPE_BUF
+# define BLOCKSIZE PIPE_BUF
+#else
+# define BLOCKSIZE 4096
+#endif
+
+enum {
+    DEF_FRAMES   = 100,
+    FRAME_SIZES  = 16,
+};
+
+enum {
+    MODE_BLOCK = 0,
+    MODE_FRAME,
+    MODE_GROWN,
+    MODE_NUM,
+};
+
+static const char *mode_names[MODE_NUM] = { "block", "frame", "grown" };
+
+/* QCIF RGB, PAL YUV420, 720p YUV420, 1080p YUV420, 1080p RGB, 2160p YUV */
+static const int def_sizes[] = {
+    76032, 622080, 1382400, 3110400, 6220800, 12441600, 0
+};
+
+/*************************************************************************/
+
+/* the old mfread() of src/decoder.c, counting the syscalls */
+static int read_block(int fd, uint8_t *buf, int size, long *calls)
+{
+    int n = 0, r = 0;
+
+    while (n < size - BLOCKSIZE) {
+        r = read(fd, buf + n, BLOCKSIZE);
+        (*calls)++;
+        if (r <= 0) {
+            return TC_ERROR;
+        }
+        n += r;
+    }
+    while (size - n) {
+        r = read(fd, buf + n, size - n);
+        (*calls)++;
+        if (r <= 0) {
+            return TC_ERROR;
+        }
+        n += r;
+    }
+    return TC_OK;
+}
+
+/* same loop as tc_pread(), counting the syscalls */
+static int read_frame(int fd, uint8_t *buf, int size, long *calls)
+{
+    int n = 0, r = 0;
+
+    while (n < size) {
+        r = read(fd, buf + n, size - n);
+        (*calls)++;
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            return TC_ERROR;
+        }
+        n += r;
+    }
+    return TC_OK;
+}
+
+static void writer(int fd, int size, int frames)
+{
+    uint8_t *buf = tc_malloc(size);
+    int i = 0;
+
+    if (buf == NULL) {
+        _exit(1);
+    }
+    memset(buf, 0x42, size);
+    for (i = 0; i < frames; i++) {
+        if (tc_pwrite(fd, buf, size) != size) {
+            _exit(1);
+        }
+    }
+    _exit(0);
+}
+
+static double elapsed(const struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec)
+           + (now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* returns TC_ERROR if the data didn't get through */
+static int run(int mode, int size, int frames)
+{
+    struct timeval start;
+    uint8_t *buf = NULL;
+    int fds[2], status = 0, i = 0, ret = TC_OK, cap = 0;
+    long calls = 0;
+    double secs = 0.0;
+    pid_t pid;
+
+    buf = tc_malloc(size);
+    if (buf == NULL || pipe(fds) < 0) {
+        tc_log_perror(__FILE__, "setup");
+        return TC_ERROR;
+    }
+    if (mode == MODE_GROWN) {
+        cap = tc_pipe_grow(fds[0], size);
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        tc_log_perror(__FILE__, "fork");
+        return TC_ERROR;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        writer(fds[1], size, frames);
+    }
+    close(fds[1]);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < frames && ret == TC_OK; i++) {
+        if (mode == MODE_BLOCK) {
+            ret = read_block(fds[0], buf, size, &calls);
+        } else {
+            ret = read_frame(fds[0], buf, size, &calls);
+        }
+    }
+    secs = elapsed(&start);
+
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+    if (ret == TC_OK && (buf[0] != 0x42 || buf[size - 1] != 0x42)) {
+        ret = TC_ERROR;
+    }
+
+    printf("%9i  %s  %9.1f  %9.1f", size, mode_names[mode],
+           (double)calls / frames,
+           (secs > 0) ?(double)size * frames / secs / 1048576.0 :0.0);
+    if (mode == MODE_GROWN) {
+        printf("  (pipe: %i)", cap);
+    }
+    printf("%s\n", (ret == TC_OK) ?"" :"  FAILED");
+
+    tc_free(buf);
+    return ret;
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    int sizes[FRAME_SIZES + 1];
+    int frames = DEF_FRAMES, errors = 0, i = 0, m = 0, n = 0, ch;
+
+    libtc_init(&argc, &argv);
+
+    while ((ch = getopt(argc, argv, "n:h")) != -1) {
+        switch (ch) {
+          case 'n':
+            frames = atoi(optarg);
+            if (frames <= 0) {
+                fprintf(stderr, "bad frame count: %s\n", optarg);
+                return 1;
+            }
+            break;
+          default:
+            fprintf(stderr, "Usage: %s [-n frames] [frame_size ...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    for (i = optind; i < argc && n < FRAME_SIZES; i++) {
+        sizes[n] = atoi(argv[i]);
+        if (sizes[n] > 0) {
+            n++;
+        }
+    }
+    if (n == 0) {
+        for (n = 0; def_sizes[n] > 0; n++) {
+            sizes[n] = def_sizes[n];
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("%9s  %5s  %9s  %9s\n", "bytes", "mode", "reads/frm", "MB/s");
+    for (i = 0; i < n; i++) {
+        for (m = 0; m < MODE_NUM; m++) {
+            if (run(m, sizes[i], frames) != TC_OK) {
+                errors++;
+            }
+        }
+    }
+    return (errors > 0) ?1 :0;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,348 @@
+/*
+ * test-resample.c - test all aclib resampler implementations
+ *
+ * This file is part of transcode, a video stream processing tool.
+ * transcode is free software, distributable under the terms of the GNU
+ * General Public License (version 2 or later).  See the file COPYING
+ * for details.
+ */
+
+#define _GNU_SOURCE  /* for strsignal */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "config.h"
+
+#define ac_resample_h local_ac_resample_h  /* to avoid clash with libac.a */
+#define ac_resample_v local_ac_resample_v
+#define ac_resample_init local_ac_resample_init
+#include "aclib/ac.h"
+
+/* Include resample.c directly for access to the particular implementations */
+#include "../aclib/resample.c"
+/* Make sure all names are available, to simplify function table */
+#if !defined(HAVE_ASM_SSE2)
+# define resample_h_sse2 resample_h
+# define resample_v_sse2 resample_v
+#endif
+#if !defined(HAVE_ASM_AVX2)
+# define resample_h_avx2 resample_h
+# define resample_v_avx2 resample_v
+#endif
+
+/* Bytes checked on either side of the destination */
+#define SPILL   16
+
+/* Largest width (in pixels) and number of taps tested */
+#define MAXWIDTH 1000
+#define MAXTAPS  24
+
+typedef void (*HFunc)(const uint8_t *, uint8_t *, int, int,
+                      const int32_t *, const int16_t *, int);
+typedef void (*VFunc)(const uint8_t * const *, const int16_t *, int,
+                      uint8_t *, int);
+
+/*************************************************************************/
+
+static void *old_SIGSEGV = NULL, *old_SIGILL = NULL;
+static sigjmp_buf env;
+
+
+static void sighandler(int sig)
+{
+    printf("*** %s\n", strsignal(sig));
+    siglongjmp(env, 1);
+}
+
+static void set_signals(void)
+{
+    old_SIGSEGV = signal(SIGSEGV, sighandler);
+    old_SIGILL  = signal(SIGILL , sighandler);
+}
+
+static void clear_signals(void)
+{
+    signal(SIGSEGV, old_SIGSEGV);
+    signal(SIGILL , old_SIGILL );
+}
+
+/*************************************************************************/
+
+/* Test data: the source row(s), plus start offsets and weights for each
+ * destination pixel.  The weights are mostly a plausible filter, with
+ * some large and negative values thrown in to check the clamping. */
+
+static uint8_t srcdata[MAXTAPS][MAXWIDTH*3 + MAXTAPS*3];
+static int32_t starts[MAXWIDTH];
+static int16_t weights[MAXWIDTH * MAXTAPS];
+
+static void gen_data(int width, int taps, int srcwidth)
+{
+    int i, k;
+
+    for (k = 0; k < MAXTAPS; k++) {
+        for (i = 0; i < sizeof(srcdata[k]); i++)
+            srcdata[k][i] = rand();
+    }
+    for (i = 0; i < width; i++) {
+        int left = 1 << AC_RESAMPLE_BITS;
+        starts[i] = rand() % (srcwidth - taps + 1);
+        for (k = 0; k < taps; k++) {
+            int16_t w;
+            if (rand() % 8 == 0)
+                w = rand() % 65536 - 32768;
+            else if (k == taps-1)
+                w = left;
+            else
+                w = rand() % (2 << AC_RESAMPLE_BITS) / taps - 4096/taps;
+            weights[i*taps+k] = w;
+            left -= w;
+        }
+    }
+}
+
+/*************************************************************************/
+
+/* Check a result against the C version, and that `SPILL' bytes on either
+ * side of the result are not affected. */
+
+static int check(const uint8_t *result, const uint8_t *expect, int size,
+                 int verbose)
+{
+    int i;
+
+    for (i = 0; i < size; i++) {
+        if (result[i] != expect[i]) {
+            if (verbose) {
+                fprintf(stderr, "Bad result at byte %d (expected 0x%02X,"
+                        " got 0x%02X)\n", i, expect[i], result[i]);
+            }
+            return 0;
+        }
+    }
+    for (i = 0; i < SPILL; i++) {
+        if (result[-SPILL+i] != 0x11 || result[size+i] != 0x11) {
+            if (verbose)
+                fprintf(stderr, "Overrun at offset %d\n", i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Test a horizontal resampler for the given parameters.  Returns nonzero
+ * on success, zero on failure. */
+
+static int test_h(HFunc func, int width, int Bpp, int taps, int verbose)
+{
+    static uint8_t expect[MAXWIDTH*3], result_base[MAXWIDTH*3 + SPILL*2];
+    uint8_t *result = result_base + SPILL;
+    int size = width * Bpp, ok;
+
+    gen_data(width, taps, width + taps);
+    resample_h(srcdata[0], expect, width, Bpp, starts, weights, taps);
+    memset(result_base, 0x11, sizeof(result_base));
+    set_signals();
+    if (sigsetjmp(env, 1)) {
+        ok = 0;
+    } else {
+        (*func)(srcdata[0], result, width, Bpp, starts, weights, taps);
+        ok = check(result, expect, size, verbose);
+    }
+    clear_signals();
+    return ok;
+}
+
+/* Test a vertical resampler for the given parameters.  Returns nonzero on
+ * success, zero on failure. */
+
+static int test_v(VFunc func, int bytes, int taps, int verbose)
+{
+    static uint8_t expect[MAXWIDTH*3], result_base[MAXWIDTH*3 + SPILL*2];
+    uint8_t *result = result_base + SPILL;
+    const uint8_t *rows[MAXTAPS];
+    int k, ok;
+
+    gen_data(1, taps, taps);
+    for (k = 0; k < taps; k++)  /* Rows may repeat, as at image edges */
+        rows[k] = srcdata[rand() % 4 == 0 ? 0 : k] + rand() % 3;
+    resample_v(rows, weights, taps, expect, bytes);
+    memset(result_base, 0x11, sizeof(result_base));
+    set_signals();
+    if (sigsetjmp(env, 1)) {
+        ok = 0;
+    } else {
+        (*func)(rows, weights, taps, result, bytes);
+        ok = check(result, expect, bytes, verbose);
+    }
+    clear_signals();
+    return ok;
+}
+
+/*************************************************************************/
+
+/* Return the time taken for `count' calls to the given horizontal and
+ * vertical resamplers on a 1920-pixel row, in microseconds. */
+
+static long time_h(HFunc func, int taps, int count)
+{
+    static uint8_t dest[MAXWIDTH*2];
+    struct timeval tv0, tv1;
+    int i;
+
+    gen_data(MAXWIDTH, taps, MAXWIDTH + taps);
+    gettimeofday(&tv0, NULL);
+    for (i = 0; i < count; i++) {
+        (*func)(srcdata[0], dest, MAXWIDTH, 1, starts, weights, taps);
+        (*func)(srcdata[1], dest + MAXWIDTH, 920, 1, starts, weights, taps);
+    }
+    gettimeofday(&tv1, NULL);
+    return (tv1.tv_sec - tv0.tv_sec) * 1000000L + (tv1.tv_usec - tv0.tv_usec);
+}
+
+static long time_v(VFunc func, int taps, int count)
+{
+    static uint8_t dest[MAXWIDTH*3];
+    const uint8_t *rows[MAXTAPS];
+    struct timeval tv0, tv1;
+    int i;
+
+    gen_data(1, taps, taps);
+    for (i = 0; i < taps; i++)
+        rows[i] = srcdata[i];
+    gettimeofday(&tv0, NULL);
+    for (i = 0; i < count; i++)
+        (*func)(rows, weights, taps, dest, 1920);
+    gettimeofday(&tv1, NULL);
+    return (tv1.tv_sec - tv0.tv_sec) * 1000000L + (tv1.tv_usec - tv0.tv_usec);
+}
+
+/*************************************************************************/
+
+/* Turn presence/absence of #define into a number */
+#if defined(HAVE_ASM_SSE2)
+# define defined_HAVE_ASM_SSE2 1
+#else
+# define defined_HAVE_ASM_SSE2 0
+#endif
+#if defined(HAVE_ASM_AVX2)
+# define defined_HAVE_ASM_AVX2 1
+#else
+# define defined_HAVE_ASM_AVX2 0
+#endif
+
+/* List of routines to test, NULL-terminated */
+static struct {
+    const char *name;
+    int arch_ok;  /* defined(ARCH_xxx), etc. */
+    int acflags;  /* required ac_cpuinfo() flags */
+    HFunc hfunc;
+    VFunc vfunc;
+} testfuncs[] = {
+    { "c",    1,                                0,
+              resample_h,      resample_v },
+    { "sse2", defined_HAVE_ASM_SSE2,            AC_SSE2,
+              resample_h_sse2, resample_v_sse2 },
+    { "avx2", defined_HAVE_ASM_AVX2,            AC_AVX2,
+              resample_h_avx2, resample_v_avx2 },
+    { NULL }
+};
+
+/* Parameters to test */
+static const int widths[] = {1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33,
+                             63, 64, 65, 352, 720, 1000};
+static const int tapcounts[] = {1, 2, 3, 4, 5, 8, 12, 16, 17, 24};
+
+#define lenof(a)  (sizeof(a) / sizeof(*(a)))
+
+/*************************************************************************/
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [-v] [-t]\n", argv0);
+    fprintf(stderr, "-v: verbose (print error details)\n");
+    fprintf(stderr, "-t: print timings\n");
+}
+
+int main(int argc, char **argv)
+{
+    int verbose = 0, timing = 0;
+    int failed = 0;
+    int ch, i;
+
+    while ((ch = getopt(argc, argv, "htv")) != EOF) {
+        if (ch == 't') {
+            timing = 1;
+        } else if (ch == 'v') {
+            verbose = 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    srand(42);
+    for (i = 1; testfuncs[i].name; i++) {
+        int Bpp, w, t;
+        if (!testfuncs[i].arch_ok
+         || (ac_cpuinfo() & testfuncs[i].acflags) != testfuncs[i].acflags)
+            continue;
+        for (Bpp = 1; Bpp <= 3; Bpp += 2) {
+            for (w = 0; w < lenof(widths); w++) {
+                for (t = 0; t < lenof(tapcounts); t++) {
+                    if (!test_h(testfuncs[i].hfunc, widths[w], Bpp,
+                                tapcounts[t], verbose)) {
+                        printf("FAILED: %s horizontal, Bpp %d, width %d,"
+                               " %d taps\n", testfuncs[i].name, Bpp,
+                               widths[w], tapcounts[t]);
+                        failed = 1;
+                    }
+                }
+            }
+        }
+        for (w = 0; w < lenof(widths); w++) {
+            for (t = 0; t < lenof(tapcounts); t++) {
+                if (!test_v(testfuncs[i].vfunc, widths[w], tapcounts[t],
+                            verbose)) {
+                    printf("FAILED: %s vertical, %d bytes, %d taps\n",
+                           testfuncs[i].name, widths[w], tapcounts[t]);
+                    failed = 1;
+                }
+            }
+        }
+    }
+
+    if (timing) {
+        for (i = 0; testfuncs[i].name; i++) {
+            if (!testfuncs[i].arch_ok
+             || (ac_cpuinfo() & testfuncs[i].acflags)
+                != testfuncs[i].acflags)
+                continue;
+            printf("%-4s: horizontal 8/16 taps %6ld/%6ld us,"
+                   " vertical 4/8 taps %6ld/%6ld us\n", testfuncs[i].name,
+                   time_h(testfuncs[i].hfunc, 8, 1000),
+                   time_h(testfuncs[i].hfunc, 16, 1000),
+                   time_v(testfuncs[i].vfunc, 4, 1000),
+                   time_v(testfuncs[i].vfunc, 8, 1000));
+        }
+    }
+
+    return failed;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
@@ -0,0 +1,317 @@
+/*
+ * test-tccounter.c -- testsuite for the TCCounterSet sharded counters.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "config.h"
+#include "libtc/libtc.h"
+#include "libtcutil/tcthread.h"
+#include "libtcutil/tccounter.h"
+
+
+/*************************************************************************/
+
+enum {
+    ADDS_NUM    = 200000,
+    THREADS_MAX = 8,
+    ROUNDS      = 5,    /* of thread start/stop, for the shard recycling */
+};
+
+enum {
+    CNT_A = 0,
+    CNT_B,
+    CNT_C,
+    CNT_NUM,
+};
+
+typedef struct testdata_ TestData;
+struct testdata_ {
+    TCCounterSet    *set;
+    TCMutex         lock;   /* for the locked reference */
+    unsigned long   locked; /* the old way, for timing */
+    int             use_lock;
+    int             resets;     /* the reader resets the set as well */
+    volatile int    done;
+    int             torn;   /* snapshots seeing half an update */
+    long            snapshots;
+};
+
+static int test_writer(TCThreadData *td, void *datum)
+{
+    TestData *data = datum;
+    int i = 0;
+
+    for (i = 0; i < ADDS_NUM; i++) {
+        if (data->use_lock) {
+            tc_mutex_lock(&data->lock);
+            data->locked++;
+            tc_mutex_unlock(&data->lock);
+        } else {
+            /* A and B always move together */
+            tc_counter_add2(data->set, CNT_A, 1, CNT_B, 2);
+            tc_counter_add(data->set, CNT_C, 1);
+        }
+    }
+    return 0;
+}
+
+static int test_reader(TCThreadData *td, void *datum)
+{
+    TestData *data = datum;
+    unsigned long vals[CNT_NUM];
+
+    while (!data->done) {
+        if (data->resets && data->snapshots % 16 == 0) {
+            tc_counter_reset(data->set);
+        }
+        tc_counter_snapshot(data->set, vals);
+        if (vals[CNT_B] != 2 * vals[CNT_A]) {
+            data->torn++;
+        }
+        data->snapshots++;
+    }
+    return 0;
+}
+
+static double elapsed(const struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec)
+           + (now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* run `writers' threads, `rounds' times; returns the seconds taken */
+static double run_writers(TestData *data, int writers, int rounds)
+{
+    TCThread threads[THREADS_MAX];
+    struct timeval start;
+    int i = 0, r = 0;
+
+    gettimeofday(&start, NULL);
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < writers; i++) {
+            tc_thread_init(&threads[i], "writer");
+            tc_thread_start(&threads[i], test_writer, data);
+        }
+        for (i = 0; i < writers; i++) {
+            tc_thread_wait(&threads[i], NULL);
+        }
+    }
+    return elapsed(&start);
+}
+
+/*************************************************************************/
+
+static int test_counter_bad_args(void)
+{
+    unsigned long val = 42;
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [bad_args]");
+
+    if (tc_counter_set_new(0) != NULL) {
+        tc_log_warn(__FILE__, "FAILED: set created with no counters");
+        ret = 1;
+    }
+    /* a NULL set is a valid, disabled, one */
+    tc_counter_add(NULL, 0, 1);
+    tc_counter_snapshot(NULL, &val);
+    if (tc_counter_get(NULL, 0) != 0 || val != 42) {
+        tc_log_warn(__FILE__, "FAILED: NULL set has values");
+        ret = 1;
+    }
+    tc_counter_set_del(NULL);
+    return ret;
+}
+
+static int test_counter_single(void)
+{
+    TCCounterSet *set = tc_counter_set_new(CNT_NUM);
+    unsigned long vals[CNT_NUM];
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [single]");
+
+    if (set == NULL) {
+        tc_log_warn(__FILE__, "FAILED: setup");
+        return 1;
+    }
+    tc_counter_add(set, CNT_A, 3);
+    tc_counter_add(set, CNT_C, 5);
+    tc_counter_add2(set, CNT_A, 1, CNT_B, 7);
+    tc_counter_snapshot(set, vals);
+    if (vals[CNT_A] != 4 || vals[CNT_B] != 7 || vals[CNT_C] != 5
+     || tc_counter_get(set, CNT_A) != 4) {
+        tc_log_warn(__FILE__, "FAILED: got %lu/%lu/%lu, expected 4/7/5",
+                    vals[CNT_A], vals[CNT_B], vals[CNT_C]);
+        ret = 1;
+    }
+    tc_counter_reset(set);
+    tc_counter_add(set, CNT_B, 1);
+    tc_counter_snapshot(set, vals);
+    if (vals[CNT_A] != 0 || vals[CNT_B] != 1 || vals[CNT_C] != 0) {
+        tc_log_warn(__FILE__, "FAILED: reset left %lu/%lu/%lu",
+                    vals[CNT_A], vals[CNT_B], vals[CNT_C]);
+        ret = 1;
+    }
+    tc_counter_set_del(set);
+    return ret;
+}
+
+/* many writers, coming and going, and a reader checking each snapshot */
+static int test_counter_threads(int writers)
+{
+    TestData data;
+    TCThread reader;
+    unsigned long expected = (unsigned long)ADDS_NUM * writers * ROUNDS;
+    unsigned long vals[CNT_NUM];
+    double secs = 0.0, locked_secs = 0.0;
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [threads(%i)]", writers);
+
+    memset(&data, 0, sizeof(data));
+    tc_mutex_init(&data.lock);
+    data.set = tc_counter_set_new(CNT_NUM);
+    if (data.set == NULL) {
+        tc_log_warn(__FILE__, "FAILED: setup");
+        return 1;
+    }
+
+    tc_thread_init(&reader, "reader");
+    tc_thread_start(&reader, test_reader, &data);
+    secs = run_writers(&data, writers, ROUNDS);
+    data.done = 1;
+    tc_thread_wait(&reader, NULL);
+
+    tc_counter_snapshot(data.set, vals);
+    if (vals[CNT_A] != expected || vals[CNT_B] != 2 * expected
+     || vals[CNT_C] != expected) {
+        tc_log_warn(__FILE__, "FAILED: got %lu/%lu/%lu, expected %lu",
+                    vals[CNT_A], vals[CNT_B], vals[CNT_C], expected);
+        ret = 1;
+    }
+    if (data.torn > 0) {
+        tc_log_warn(__FILE__, "FAILED: %i torn snapshots out of %li",
+                    data.torn, data.snapshots);
+        ret = 1;
+    }
+
+    data.use_lock = 1;
+    locked_secs = run_writers(&data, writers, ROUNDS);
+    tc_log_info(__FILE__, "  %li snapshots; %.1f Madd/s (%.1f with a lock)",
+                data.snapshots,
+                (secs > 0) ?2.0 * expected / secs / 1e6 :0.0,
+                (locked_secs > 0) ?expected / locked_secs / 1e6 :0.0);
+
+    tc_counter_set_del(data.set);
+    return ret;
+}
+
+/* resets racing with the writers must not split their updates */
+static int test_counter_reset_threads(int writers)
+{
+    TestData data;
+    TCThread reader;
+    unsigned long vals[CNT_NUM];
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [reset_threads(%i)]", writers);
+
+    memset(&data, 0, sizeof(data));
+    data.resets = 1;
+    data.set = tc_counter_set_new(CNT_NUM);
+    if (data.set == NULL) {
+        tc_log_warn(__FILE__, "FAILED: setup");
+        return 1;
+    }
+
+    tc_thread_init(&reader, "reader");
+    tc_thread_start(&reader, test_reader, &data);
+    run_writers(&data, writers, 1);
+    data.done = 1;
+    tc_thread_wait(&reader, NULL);
+
+    if (data.torn > 0) {
+        tc_log_warn(__FILE__, "FAILED: %i torn snapshots out of %li",
+                    data.torn, data.snapshots);
+        ret = 1;
+    }
+    /* the shards of the writers gone are reset too */
+    tc_counter_reset(data.set);
+    tc_counter_snapshot(data.set, vals);
+    if (vals[CNT_A] != 0 || vals[CNT_B] != 0 || vals[CNT_C] != 0
+     || tc_counter_get(data.set, CNT_C) != 0) {
+        tc_log_warn(__FILE__, "FAILED: reset left %lu/%lu/%lu",
+                    vals[CNT_A], vals[CNT_B], vals[CNT_C]);
+        ret = 1;
+    }
+    run_writers(&data, writers, 1);
+    tc_counter_snapshot(data.set, vals);
+    if (vals[CNT_A] != (unsigned long)ADDS_NUM * writers
+     || vals[CNT_B] != 2 * vals[CNT_A]) {
+        tc_log_warn(__FILE__, "FAILED: got %lu/%lu after the reset,"
+                              " expected %lu", vals[CNT_A], vals[CNT_B],
+                    (unsigned long)ADDS_NUM * writers);
+        ret = 1;
+    }
+
+    tc_counter_set_del(data.set);
+    return ret;
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    int errors = 0;
+
+    libtc_init(&argc, &argv);
+
+    errors += test_counter_bad_args();
+    errors += test_counter_single();
+    errors += test_counter_threads(1);
+    errors += test_counter_threads(4);
+    errors += test_counter_threads(THREADS_MAX);
+    errors += test_counter_reset_threads(4);
+
+    putchar('\n');
+    tc_log_info(__FILE__, "test summary: %i error%s (%s)",
+                errors,
+                (errors > 1) ?"s" :"",
+                (errors > 0) ?"FAILED" :"PASSED");
+    return (errors > 0) ?1 :0;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
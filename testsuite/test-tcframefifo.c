@@ -23,6 +23,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "config.h"
 #include "libtc/libtc.h"
@@ -31,6 +32,9 @@
 /*************************************************************************/
 
 #define TC_TEST_BEGIN(NAME, SIZE, PRIORITY) \
+    TC_TEST_BEGIN_WITH(NAME, tc_frame_queue_new, SIZE, PRIORITY)
+
+#define TC_TEST_BEGIN_WITH(NAME, NEW, SIZE, PRIORITY) \
 static int tcframequeue_ ## NAME ## _test(void) \
 { \
     const char *TC_TEST_name = # NAME ; \
@@ -41,7 +45,7 @@ static int tcframequeue_ ## NAME ## _test(void) \
     TCFrameQueue *Q = NULL; \
     \
     tc_log_info(__FILE__, "running test: [%s]", # NAME); \
-    Q = tc_frame_queue_new((SIZE), (PRIORITY)); \
+    Q = NEW((SIZE), (PRIORITY)); \
     if (Q) {
 
 
@@ -447,10 +451,190 @@ TC_TEST_END
 
 
 
+/*************************************************************************/
+/* lock-free queues                                                      */
+
+#define TC_TEST_BEGIN_LF(NAME, SIZE, PRIORITY) \
+    TC_TEST_BEGIN_WITH(NAME, tc_frame_queue_new_lockfree, SIZE, PRIORITY)
+
+TC_TEST_BEGIN_LF(LU_init_empty, QUEUESIZE, UNPRIORITY)
+    TCFramePtr fp = { .generic = NULL };
+
+    TC_TEST_IS_TRUE(tc_frame_queue_empty(Q));
+    TC_TEST_IS_TRUE(tc_frame_queue_size(Q) == 0);
+
+    fp = tc_frame_queue_get(Q);
+    TC_TEST_IS_TRUE(TCFRAMEPTR_IS_NULL(fp));
+TC_TEST_END
+
+TC_TEST_BEGIN_LF(LU_putMax_getMax, QUEUESIZE, UNPRIORITY)
+    frame_list_t frame[QUEUESIZE];
+    TCFramePtr ptr[QUEUESIZE];
+    TCFramePtr fp = { .generic = NULL };
+    int i = 0, j = 0;
+
+    init_frames(QUEUESIZE, frame, ptr);
+
+    /* go around the ring a few times */
+    for (j = 0; j < 3; j++) {
+        for (i = 0; i < QUEUESIZE; i++) {
+            TC_TEST_IS_TRUE(tc_frame_queue_put(Q, ptr[QUEUESIZE - i - 1]));
+            TC_TEST_IS_TRUE(tc_frame_queue_size(Q) == (i+1));
+        }
+
+        for (i = 0; i < QUEUESIZE; i++) {
+            fp = tc_frame_queue_get(Q);
+            TC_TEST_IS_TRUE(!TCFRAMEPTR_IS_NULL(fp));
+            /* FIFO: insertion order */
+            TC_TEST_IS_TRUE(fp.generic->id == (QUEUESIZE - i - 1));
+            TC_TEST_IS_TRUE(tc_frame_queue_size(Q) == (QUEUESIZE-i-1));
+        }
+        TC_TEST_IS_TRUE(tc_frame_queue_empty(Q));
+    }
+TC_TEST_END
+
+TC_TEST_BEGIN_LF(LS_putMax_getMax_rev, QUEUESIZE, PRIORITY)
+    frame_list_t frame[QUEUESIZE];
+    TCFramePtr ptr[QUEUESIZE];
+    TCFramePtr fp = { .generic = NULL };
+    int i = 0;
+
+    init_frames(QUEUESIZE, frame, ptr);
+
+    for (i = 0; i < QUEUESIZE; i++) {
+        TC_TEST_IS_TRUE(tc_frame_queue_put(Q, ptr[QUEUESIZE - i - 1]));
+        TC_TEST_IS_TRUE(tc_frame_queue_size(Q) == (i+1));
+    }
+
+    for (i = 0; i < QUEUESIZE; i++) {
+        fp = tc_frame_queue_get(Q);
+        TC_TEST_IS_TRUE(!TCFRAMEPTR_IS_NULL(fp));
+        /* heap: id order */
+        TC_TEST_IS_TRUE(fp.generic->id == i);
+        TC_TEST_IS_TRUE(tc_frame_queue_size(Q) == (QUEUESIZE-i-1));
+    }
+TC_TEST_END
+
+TC_TEST_BEGIN_LF(LS_interleaved, QUEUESIZE, PRIORITY)
+    frame_list_t frame[QUEUESIZE];
+    TCFramePtr ptr[QUEUESIZE];
+    TCFramePtr fp = { .generic = NULL };
+
+    init_frames(QUEUESIZE, frame, ptr);
+
+    TC_TEST_IS_TRUE(tc_frame_queue_put(Q, ptr[3]));
+    TC_TEST_IS_TRUE(tc_frame_queue_put(Q, ptr[1]));
+    fp = tc_frame_queue_get(Q);
+    TC_TEST_IS_TRUE(fp.generic->id == 1);
+    TC_TEST_IS_TRUE(tc_frame_queue_put(Q, ptr[2]));
+    TC_TEST_IS_TRUE(tc_frame_queue_put(Q, ptr[0]));
+    fp = tc_frame_queue_get(Q);
+    TC_TEST_IS_TRUE(fp.generic->id == 0);
+    fp = tc_frame_queue_get(Q);
+    TC_TEST_IS_TRUE(fp.generic->id == 2);
+    fp = tc_frame_queue_get(Q);
+    TC_TEST_IS_TRUE(fp.generic->id == 3);
+    TC_TEST_IS_TRUE(tc_frame_queue_empty(Q));
+TC_TEST_END
+
+/*************************************************************************/
+/* lock-free pool, concurrent access                                     */
+
+enum {
+    STRESS_THREADS = 4,
+    STRESS_FRAMES  = 16,
+    STRESS_ROUNDS  = 20000,
+};
+
+typedef struct stressdata_ StressData;
+struct stressdata_ {
+    TCFramePool *src;
+    TCFramePool *dst;
+    int         rounds;
+};
+
+/* bounce frames from a pool to another, as filter workers do */
+static void *stress_worker(void *arg)
+{
+    StressData *sd = arg;
+    int i;
+
+    for (i = 0; i < sd->rounds; i++) {
+        TCFramePtr fp = tc_frame_pool_get_frame(sd->src);
+        fp.generic->tag++;
+        tc_frame_pool_put_frame(sd->dst, fp);
+    }
+    return NULL;
+}
+
+static int test_frame_pool_lockfree_stress(void)
+{
+    frame_list_t frame[STRESS_FRAMES];
+    TCFramePtr ptr[STRESS_FRAMES];
+    pthread_t tids[STRESS_THREADS * 2];
+    StressData fwd, bwd;
+    TCFramePool *A = NULL, *B = NULL;
+    int i, total = 0, num = 0, errors = 0;
+
+    tc_log_info(__FILE__, "running test: [%s]", "lockfree_pool_stress");
+
+    init_frames(STRESS_FRAMES, frame, ptr);
+    A = tc_frame_pool_new(STRESS_FRAMES, UNPRIORITY, TC_TRUE, "A", "stress");
+    B = tc_frame_pool_new(STRESS_FRAMES, UNPRIORITY, TC_TRUE, "B", "stress");
+    if (A == NULL || B == NULL) {
+        tc_log_warn(__FILE__, "FAILED test [%s]: pool init",
+                    "lockfree_pool_stress");
+        return 1;
+    }
+    for (i = 0; i < STRESS_FRAMES; i++) {
+        tc_frame_pool_put_frame(A, ptr[i]);
+    }
+
+    fwd.src = A;
+    fwd.dst = B;
+    fwd.rounds = STRESS_ROUNDS;
+    bwd.src = B;
+    bwd.dst = A;
+    bwd.rounds = STRESS_ROUNDS;
+    for (i = 0; i < STRESS_THREADS; i++) {
+        pthread_create(&tids[i], NULL, stress_worker, &fwd);
+        pthread_create(&tids[STRESS_THREADS + i], NULL, stress_worker, &bwd);
+    }
+    for (i = 0; i < STRESS_THREADS * 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    while (!TCFRAMEPTR_IS_NULL(tc_frame_pool_pull_frame(A))) {
+        num++;
+    }
+    while (!TCFRAMEPTR_IS_NULL(tc_frame_pool_pull_frame(B))) {
+        num++;
+    }
+    for (i = 0; i < STRESS_FRAMES; i++) {
+        total += frame[i].tag;
+    }
+    if (num != STRESS_FRAMES) {
+        tc_log_warn(__FILE__, "FAILED test [%s]: lost frames (%i/%i)",
+                    "lockfree_pool_stress", num, STRESS_FRAMES);
+        errors++;
+    }
+    if (total != STRESS_THREADS * 2 * STRESS_ROUNDS) {
+        tc_log_warn(__FILE__, "FAILED test [%s]: lost moves (%i/%i)",
+                    "lockfree_pool_stress",
+                    total, STRESS_THREADS * 2 * STRESS_ROUNDS);
+        errors++;
+    }
+
+    tc_frame_pool_del(A);
+    tc_frame_pool_del(B);
+    return errors;
+}
+
 /*************************************************************************/
 
 static int test_frame_queue_all(void)
 {
+    TCFrameQueue *Q = NULL;
     int errors = 0;
 
     TC_RUN_TEST(U_init_empty);
@@ -472,6 +656,20 @@ static int test_frame_queue_all(void)
     TC_RUN_TEST(S_putMax_getMax);
     TC_RUN_TEST(S_putMax_getMax_rev);
 
+    Q = tc_frame_queue_new_lockfree(1, UNPRIORITY);
+    if (Q == NULL) {
+        tc_log_warn(__FILE__, "lock-free queues not available, skipped");
+        return errors;
+    }
+    tc_frame_queue_del(Q);
+
+    TC_RUN_TEST(LU_init_empty);
+    TC_RUN_TEST(LU_putMax_getMax);
+    TC_RUN_TEST(LS_putMax_getMax_rev);
+    TC_RUN_TEST(LS_interleaved);
+
+    errors += test_frame_pool_lockfree_stress();
+
     return errors;
 }
 
@@ -112,6 +112,17 @@ TC_TEST_BEGIN(U_prepend_get, UNCACHED)
     TC_TEST_IS_TRUE(&num == res);
 TC_TEST_END
 
+TC_TEST_BEGIN(U_append_dup_get, UNCACHED)
+    long num = 42, *res;
+    TC_TEST_IS_TRUE(tc_list_append_dup(&L, &num, sizeof(num)) == TC_OK);
+    TC_TEST_IS_TRUE(tc_list_size(&L) == 1);
+    num = 23;
+    res = tc_list_pop(&L, 0);
+    TC_TEST_IS_TRUE(&num != res);
+    TC_TEST_IS_TRUE(*res == 42);
+    tc_free(res);
+TC_TEST_END
+
 TC_TEST_BEGIN(U_appendN_get, UNCACHED)
     long *res, nums[] = { 23, 42, 18, 75, 73, 99, 14, 29 };
     int i = 0, len = sizeof(nums)/sizeof(nums[0]);
@@ -259,6 +270,7 @@ static int test_list_all(void)
     TC_RUN_TEST(U_append);
     TC_RUN_TEST(U_append_get);
     TC_RUN_TEST(U_prepend_get);
+    TC_RUN_TEST(U_append_dup_get);
     TC_RUN_TEST(U_appendN_get);
     TC_RUN_TEST(U_prependN_get);
     TC_RUN_TEST(U_appendN_getN);
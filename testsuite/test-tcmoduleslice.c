@@ -0,0 +1,272 @@
+/*
+ * test-tcmoduleslice.c -- testsuite for the slice-parallel module helpers.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "libtc/libtc.h"
+#include "libtcutil/tcthread.h"
+#include "libtcmodule/tcmodule-slice.h"
+
+
+/*************************************************************************/
+
+enum {
+    ROWS_NUM    = 1080,
+    SLOTS_MAX   = 32,
+};
+
+typedef struct testdata_ TestData;
+struct testdata_ {
+    TCMutex     lock;
+    int         rows[ROWS_NUM];
+    int         busy[SLOTS_MAX];    /* bands running on each slot */
+    int         calls;
+    int         bad_range;
+    int         bad_slot;
+};
+
+static void test_slice_fn(void *_data, int first, int last, int slot)
+{
+    TestData *data = _data;
+    volatile int i = 0;
+    int y = 0;
+
+    tc_mutex_lock(&data->lock);
+    data->calls++;
+    if (first < 0 || last > ROWS_NUM || first >= last) {
+        data->bad_range = 1;
+    }
+    if (slot < 0 || slot >= tc_module_slice_slots() || slot >= SLOTS_MAX
+     || data->busy[slot]++ > 0) {
+        data->bad_slot = 1;
+    }
+    tc_mutex_unlock(&data->lock);
+
+    for (y = first; y < last && y < ROWS_NUM; y++) {
+        /* several callers may work on the same rows */
+        tc_mutex_lock(&data->lock);
+        data->rows[y]++;
+        tc_mutex_unlock(&data->lock);
+        for (i = 0; i < 100; i++)
+            ; /* just burn some cycles */
+    }
+
+    tc_mutex_lock(&data->lock);
+    if (slot >= 0 && slot < SLOTS_MAX) {
+        data->busy[slot]--;
+    }
+    tc_mutex_unlock(&data->lock);
+}
+
+static void test_data_init(TestData *data)
+{
+    memset(data, 0, sizeof(TestData));
+    tc_mutex_init(&data->lock);
+}
+
+/* every row done `times' times, no band out of range, no slot clash */
+static int test_data_check(const TestData *data, int count, int times)
+{
+    int y = 0;
+
+    if (data->bad_range) {
+        tc_log_warn(__FILE__, "FAILED: bogus band range");
+        return 1;
+    }
+    if (data->bad_slot) {
+        tc_log_warn(__FILE__, "FAILED: bogus or shared slot");
+        return 1;
+    }
+    for (y = 0; y < ROWS_NUM; y++) {
+        if (data->rows[y] != ((y < count) ?times :0)) {
+            tc_log_warn(__FILE__, "FAILED: row %i done %i times",
+                        y, data->rows[y]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*************************************************************************/
+
+static int test_slice_bad_args(void)
+{
+    TestData data;
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [bad_args]");
+
+    test_data_init(&data);
+    if (tc_module_slice_run(NULL, &data, ROWS_NUM, 1) == TC_OK) {
+        tc_log_warn(__FILE__, "FAILED: run with no function");
+        ret = 1;
+    }
+    if (tc_module_slice_run(test_slice_fn, &data, ROWS_NUM, 0) == TC_OK) {
+        tc_log_warn(__FILE__, "FAILED: run with grain 0");
+        ret = 1;
+    }
+    if (tc_module_slice_run(test_slice_fn, &data, -1, 1) == TC_OK) {
+        tc_log_warn(__FILE__, "FAILED: run with negative count");
+        ret = 1;
+    }
+    if (data.calls != 0) {
+        tc_log_warn(__FILE__, "FAILED: function called on bad args");
+        ret = 1;
+    }
+    return ret;
+}
+
+/* no pool: one band, in the caller */
+static int test_slice_inline(void)
+{
+    TestData data;
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [inline]");
+
+    test_data_init(&data);
+    if (tc_module_slice_slots() != 1) {
+        tc_log_warn(__FILE__, "FAILED: %i slots without a pool",
+                    tc_module_slice_slots());
+        ret = 1;
+    }
+    tc_module_slice_run(test_slice_fn, &data, ROWS_NUM, 1);
+    if (data.calls != 1) {
+        tc_log_warn(__FILE__, "FAILED: %i calls without a pool",
+                    data.calls);
+        ret = 1;
+    }
+    return ret + test_data_check(&data, ROWS_NUM, 1);
+}
+
+static int test_slice_run(int threads, int count, int grain)
+{
+    TestData data;
+    int ret = 0, i = 0;
+
+    tc_log_info(__FILE__, "running test: [run(%i threads, %i/%i)]",
+                threads, count, grain);
+
+    if (tc_module_slice_init(threads, 1) != TC_OK) {
+        tc_log_warn(__FILE__, "FAILED: can't start the slice pool");
+        return 1;
+    }
+    if (tc_module_slice_slots() != TC_MAX(threads, 1)) {
+        tc_log_warn(__FILE__, "FAILED: %i slots for %i threads",
+                    tc_module_slice_slots(), threads);
+        ret = 1;
+    }
+    for (i = 0; i < 20 && !ret; i++) {
+        test_data_init(&data);
+        tc_module_slice_run(test_slice_fn, &data, count, grain);
+        ret = test_data_check(&data, count, 1);
+        if (!ret && count > 0 && data.calls > (count + grain - 1) / grain) {
+            tc_log_warn(__FILE__, "FAILED: bands smaller than grain");
+            ret = 1;
+        }
+    }
+    tc_module_slice_fini();
+    return ret;
+}
+
+static int test_caller(TCThreadData *td, void *_data)
+{
+    TestData *data = _data;
+    int i = 0;
+
+    for (i = 0; i < 20; i++) {
+        tc_module_slice_run(test_slice_fn, data, ROWS_NUM, 8);
+    }
+    return 0;
+}
+
+/* many frame threads using the same instance: no slot can be shared */
+static int test_slice_callers(int threads, int callers, int running)
+{
+    TCThread th[SLOTS_MAX];
+    TestData data;
+    int ret = 0, i = 0;
+
+    tc_log_info(__FILE__, "running test: [callers(%i threads, %i/%i)]",
+                threads, running, callers);
+
+    if (tc_module_slice_init(threads, callers) != TC_OK) {
+        tc_log_warn(__FILE__, "FAILED: can't start the slice pool");
+        return 1;
+    }
+    if (tc_module_slice_slots() != TC_MAX(threads, 1) - 1 + callers) {
+        tc_log_warn(__FILE__, "FAILED: %i slots for %i+%i threads",
+                    tc_module_slice_slots(), threads, callers);
+        ret = 1;
+    }
+    test_data_init(&data);
+    for (i = 0; i < running; i++) {
+        tc_thread_init(&th[i], "caller");
+        tc_thread_start(&th[i], test_caller, &data);
+    }
+    for (i = 0; i < running; i++) {
+        tc_thread_wait(&th[i], NULL);
+    }
+    tc_module_slice_fini();
+    return ret + test_data_check(&data, ROWS_NUM, running * 20);
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    int errors = 0;
+
+    libtc_init(&argc, &argv);
+
+    errors += test_slice_bad_args();
+    errors += test_slice_inline();
+    errors += test_slice_run(1, ROWS_NUM, 1);
+    errors += test_slice_run(4, ROWS_NUM, 1);
+    errors += test_slice_run(4, ROWS_NUM, 16);
+    errors += test_slice_run(4, 0, 16);
+    errors += test_slice_run(4, 3, 16);
+    errors += test_slice_run(8, 17, 1);
+    errors += test_slice_run(SLOTS_MAX, ROWS_NUM, 8);
+    errors += test_slice_callers(1, 4, 4);
+    errors += test_slice_callers(4, 4, 4);
+    errors += test_slice_callers(4, 2, 6);
+
+    putchar('\n');
+    tc_log_info(__FILE__, "test summary: %i error%s (%s)",
+                errors,
+                (errors > 1) ?"s" :"",
+                (errors > 0) ?"FAILED" :"PASSED");
+    return (errors > 0) ?1 :0;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
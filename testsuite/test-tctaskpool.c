@@ -0,0 +1,253 @@
+/*
+ * test-tctaskpool.c -- testsuite for the TCTaskPool work-stealing pool.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "libtc/libtc.h"
+#include "libtcutil/tcthread.h"
+#include "libtcutil/tctaskpool.h"
+
+
+/*************************************************************************/
+
+enum {
+    TASKS_NUM   = 1000,
+    CHAIN_LEN   = 50,
+    WORKERS_MAX = 8,
+};
+
+typedef struct testtask_ TestTask;
+struct testtask_ {
+    int     left;       /* how many times to requeue itself */
+    int     runs;       /* how many times we were run */
+    int     last;       /* last worker which ran the task */
+};
+
+typedef struct testdata_ TestData;
+struct testdata_ {
+    TCTaskPool  *pool;
+    TCMutex     lock;
+    long        runs;
+    int         per_worker[WORKERS_MAX];
+    int         bad_worker;
+};
+
+static void test_task_run(void *_task, int worker, void *_data)
+{
+    TestTask *task = _task;
+    TestData *data = _data;
+    volatile int i = 0;
+
+    for (i = 0; i < 1000; i++)
+        ; /* just burn some cycles */
+
+    task->runs++;
+    task->last = worker;
+
+    tc_mutex_lock(&data->lock);
+    data->runs++;
+    if (worker < 0 || worker >= WORKERS_MAX) {
+        data->bad_worker = 1;
+    } else {
+        data->per_worker[worker]++;
+    }
+    tc_mutex_unlock(&data->lock);
+
+    if (task->left > 0) {
+        task->left--;
+        tc_task_pool_spawn(data->pool, worker, task);
+    }
+}
+
+/*************************************************************************/
+
+static int test_task_pool_create(int workers)
+{
+    TestData data;
+    TCTaskPool *pool = NULL;
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [create(%i)]", workers);
+
+    memset(&data, 0, sizeof(data));
+    pool = tc_task_pool_new(workers, test_task_run, &data, "test");
+    if (!pool) {
+        tc_log_warn(__FILE__, "FAILED: can't create pool");
+        return 1;
+    }
+    if (tc_task_pool_workers(pool) != workers) {
+        tc_log_warn(__FILE__, "FAILED: wrong worker count (%i/%i)",
+                    tc_task_pool_workers(pool), workers);
+        ret = 1;
+    }
+    tc_task_pool_wait(pool); /* nothing queued, must not block */
+    tc_task_pool_del(pool);
+    return ret;
+}
+
+static int test_task_pool_bad_args(void)
+{
+    TestData data;
+    int ret = 0;
+
+    tc_log_info(__FILE__, "running test: [bad_args]");
+
+    if (tc_task_pool_new(0, test_task_run, &data, "test") != NULL) {
+        tc_log_warn(__FILE__, "FAILED: pool created with no workers");
+        ret = 1;
+    }
+    if (tc_task_pool_new(2, NULL, &data, "test") != NULL) {
+        tc_log_warn(__FILE__, "FAILED: pool created with no function");
+        ret = 1;
+    }
+    if (tc_task_pool_submit(NULL, &data) == TC_OK) {
+        tc_log_warn(__FILE__, "FAILED: submit to NULL pool");
+        ret = 1;
+    }
+    return ret;
+}
+
+/* submit/spawn a bunch of tasks, verify each one ran as many times
+ * as requested, no more, no less */
+static int test_task_pool_run(int workers, int chain)
+{
+    TestTask *tasks = NULL;
+    TestData data;
+    long expected = (long)TASKS_NUM * (chain + 1);
+    int i = 0, ret = 0;
+
+    tc_log_info(__FILE__, "running test: [run(%i workers, chain=%i)]",
+                workers, chain);
+
+    tasks = tc_zalloc(TASKS_NUM * sizeof(TestTask));
+    memset(&data, 0, sizeof(data));
+    tc_mutex_init(&data.lock);
+
+    data.pool = tc_task_pool_new(workers, test_task_run, &data, "test");
+    if (!tasks || !data.pool) {
+        tc_log_warn(__FILE__, "FAILED: setup");
+        return 1;
+    }
+
+    for (i = 0; i < TASKS_NUM; i++) {
+        tasks[i].left = chain;
+        if (tc_task_pool_submit(data.pool, &tasks[i]) != TC_OK) {
+            tc_log_warn(__FILE__, "FAILED: submit #%i", i);
+            ret = 1;
+        }
+    }
+    tc_task_pool_wait(data.pool);
+
+    if (data.runs != expected) {
+        tc_log_warn(__FILE__, "FAILED: ran %li tasks, expected %li",
+                    data.runs, expected);
+        ret = 1;
+    }
+    for (i = 0; i < TASKS_NUM; i++) {
+        if (tasks[i].runs != chain + 1 || tasks[i].left != 0) {
+            tc_log_warn(__FILE__, "FAILED: task #%i ran %i times",
+                        i, tasks[i].runs);
+            ret = 1;
+            break;
+        }
+    }
+    if (data.bad_worker) {
+        tc_log_warn(__FILE__, "FAILED: bogus worker index");
+        ret = 1;
+    }
+    tc_log_info(__FILE__, "  steals: %li", tc_task_pool_steals(data.pool));
+
+    tc_task_pool_del(data.pool);
+    tc_free(tasks);
+    return ret;
+}
+
+/* tasks queued right before del() must still be run */
+static int test_task_pool_del_drains(int workers)
+{
+    TestTask *tasks = NULL;
+    TestData data;
+    int i = 0, ret = 0;
+
+    tc_log_info(__FILE__, "running test: [del_drains(%i)]", workers);
+
+    tasks = tc_zalloc(TASKS_NUM * sizeof(TestTask));
+    memset(&data, 0, sizeof(data));
+    tc_mutex_init(&data.lock);
+
+    data.pool = tc_task_pool_new(workers, test_task_run, &data, "test");
+    if (!tasks || !data.pool) {
+        tc_log_warn(__FILE__, "FAILED: setup");
+        return 1;
+    }
+    for (i = 0; i < TASKS_NUM; i++) {
+        tasks[i].left = 1;
+        tc_task_pool_submit(data.pool, &tasks[i]);
+    }
+    tc_task_pool_del(data.pool);
+
+    if (data.runs != TASKS_NUM * 2) {
+        tc_log_warn(__FILE__, "FAILED: ran %li tasks, expected %i",
+                    data.runs, TASKS_NUM * 2);
+        ret = 1;
+    }
+    tc_free(tasks);
+    return ret;
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    int errors = 0;
+
+    libtc_init(&argc, &argv);
+
+    errors += test_task_pool_bad_args();
+    errors += test_task_pool_create(1);
+    errors += test_task_pool_create(WORKERS_MAX);
+    errors += test_task_pool_run(1, 0);
+    errors += test_task_pool_run(1, CHAIN_LEN);
+    errors += test_task_pool_run(4, 0);
+    errors += test_task_pool_run(4, CHAIN_LEN);
+    errors += test_task_pool_run(WORKERS_MAX, CHAIN_LEN);
+    errors += test_task_pool_del_drains(4);
+
+    putchar('\n');
+    tc_log_info(__FILE__, "test summary: %i error%s (%s)",
+                errors,
+                (errors > 1) ?"s" :"",
+                (errors > 0) ?"FAILED" :"PASSED");
+    return (errors > 0) ?1 :0;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
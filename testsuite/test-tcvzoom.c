@@ -0,0 +1,366 @@
+/*
+ * test-tcvzoom.c -- testsuite for the tcv_zoom() filtered resizing.
+ *
+ * This file is part of transcode, a video stream processing tool.
+ *
+ * transcode is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * transcode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "config.h"
+#include "libtc/libtc.h"
+#include "aclib/ac.h"
+#include "libtcvideo/tcvideo.h"
+
+
+/*************************************************************************/
+
+/* frames are at most this size, for the fixed buffers below */
+enum {
+    MAX_W = 1920,
+    MAX_H = 1088,
+};
+
+static uint8_t src_buf[MAX_W * MAX_H * 3];
+static uint8_t dst_buf[MAX_W * MAX_H * 3];
+static uint8_t ref_buf[MAX_W * MAX_H * 3];
+static uint8_t tmp_buf[MAX_W * MAX_H * 3];
+
+static void fill_random(uint8_t *buf, int size)
+{
+    int i = 0;
+
+    for (i = 0; i < size; i++) {
+        buf[i] = rand();
+    }
+}
+
+static double elapsed(const struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec)
+           + (now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/*************************************************************************/
+
+/*
+ * Straightforward floating point version of the zoom, with the triangle
+ * filter: same geometry and edge handling as libtcvideo, rounding once
+ * per direction.
+ */
+
+static int mirror(int i, int size)
+{
+    if (i < 0) {
+        i = -i;
+    }
+    if (i >= size) {
+        i = 2 * size - 1 - i;
+    }
+    return (i < 0) ?0 :(i >= size) ?size - 1 :i;
+}
+
+static double triangle(double t)
+{
+    t = fabs(t);
+    return (t < 1.0) ?1.0 - t :0.0;
+}
+
+/* resize `n' samples `step' bytes apart from `oldsize' to `newsize' */
+static void ref_line(const uint8_t *src, uint8_t *dst, int step,
+                     int oldsize, int newsize)
+{
+    double scale = (double)newsize / oldsize;
+    double fscale = (scale < 1.0) ?1.0 / scale :1.0;
+    int i = 0, j = 0;
+
+    for (i = 0; i < newsize; i++) {
+        double center = i / scale, sum = 0.0, wsum = 0.0;
+        int left = ceil(center - fscale), right = floor(center + fscale);
+
+        for (j = left; j <= right; j++) {
+            double w = triangle((center - j) / fscale);
+            sum += w * src[mirror(j, oldsize) * step];
+            wsum += w;
+        }
+        sum = floor(sum / wsum + 0.5);
+        dst[i * step] = (sum < 0) ?0 :(sum > 255) ?255 :sum;
+    }
+}
+
+static void ref_zoom(const uint8_t *src, uint8_t *dst, int w, int h, int Bpp,
+                     int new_w, int new_h)
+{
+    int x = 0, y = 0, c = 0;
+
+    for (y = 0; y < h; y++) {
+        for (c = 0; c < Bpp; c++) {
+            ref_line(src + y * w * Bpp + c, tmp_buf + y * new_w * Bpp + c,
+                     Bpp, w, new_w);
+        }
+    }
+    for (x = 0; x < new_w * Bpp; x++) {
+        ref_line(tmp_buf + x, dst + x, new_w * Bpp, h, new_h);
+    }
+}
+
+/*************************************************************************/
+
+static int test_zoom_reference(TCVHandle handle, int w, int h, int Bpp,
+                               int new_w, int new_h)
+{
+    int size = new_w * new_h * Bpp, i = 0, bad = 0, maxdiff = 0;
+
+    fill_random(src_buf, w * h * Bpp);
+    ref_zoom(src_buf, ref_buf, w, h, Bpp, new_w, new_h);
+    if (!tcv_zoom(handle, src_buf, dst_buf, w, h, Bpp, new_w, new_h,
+                  TCV_ZOOM_TRIANGLE)) {
+        tc_log_warn(__FILE__, "FAILED: %ix%i -> %ix%i (Bpp %i): error",
+                    w, h, new_w, new_h, Bpp);
+        return 1;
+    }
+    for (i = 0; i < size; i++) {
+        int diff = abs(dst_buf[i] - ref_buf[i]);
+        if (diff > maxdiff) {
+            maxdiff = diff;
+        }
+        if (diff > 1) {
+            bad++;
+        }
+    }
+    if (bad > 0) {
+        tc_log_warn(__FILE__, "FAILED: %ix%i -> %ix%i (Bpp %i): %i bytes"
+                    " off by up to %i", w, h, new_w, new_h, Bpp, bad,
+                    maxdiff);
+        return 1;
+    }
+    return 0;
+}
+
+/* a flat image stays flat, whatever the filter */
+static int test_zoom_flat(TCVHandle handle, TCVZoomFilter filter)
+{
+    int i = 0;
+
+    memset(src_buf, 0xEB, 720 * 576);
+    if (!tcv_zoom(handle, src_buf, dst_buf, 720, 576, 1, 352, 720, filter)) {
+        tc_log_warn(__FILE__, "FAILED: flat (%s): error",
+                    tcv_zoom_filter_to_string(filter));
+        return 1;
+    }
+    for (i = 0; i < 352 * 720; i++) {
+        if (dst_buf[i] != 0xEB) {
+            tc_log_warn(__FILE__, "FAILED: flat (%s): 0x%02X at %i",
+                        tcv_zoom_filter_to_string(filter), dst_buf[i], i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* tcv_zoom_yuv gives the same result as zooming each plane */
+static int test_zoom_yuv(TCVHandle handle, ImageFormat fmt, int xdiv,
+                         int ydiv, int ilace)
+{
+    int w = 720, h = 576, new_w = 640, new_h = 480;
+    int ysize = new_w * new_h, csize = ysize / (xdiv * ydiv);
+    uint8_t *src = src_buf, *ref = ref_buf;
+    int ret = 0;
+
+    fill_random(src_buf, w * h * 3);
+    if (!tcv_zoom_yuv(handle, src_buf, dst_buf, w, h, fmt, new_w,
+                      ilace ?-new_h :new_h, TCV_ZOOM_LANCZOS3)) {
+        tc_log_warn(__FILE__, "FAILED: yuv (%i/%i): error", xdiv, ydiv);
+        return 1;
+    }
+    ret |= !tcv_zoom(handle, src, ref, w, h, 1, new_w, ilace ?-new_h :new_h,
+                     TCV_ZOOM_LANCZOS3);
+    src += w * h;
+    ref += ysize;
+    ret |= !tcv_zoom(handle, src, ref, w / xdiv, h / ydiv, 1, new_w / xdiv,
+                     new_h / ydiv, TCV_ZOOM_LANCZOS3);
+    src += (w / xdiv) * (h / ydiv);
+    ref += csize;
+    ret |= !tcv_zoom(handle, src, ref, w / xdiv, h / ydiv, 1, new_w / xdiv,
+                     new_h / ydiv, TCV_ZOOM_LANCZOS3);
+    if (ret || memcmp(dst_buf, ref_buf, ysize + 2 * csize) != 0) {
+        tc_log_warn(__FILE__, "FAILED: yuv (%i/%i%s) differs from planes",
+                    xdiv, ydiv, ilace ?", interlaced" :"");
+        return 1;
+    }
+    return 0;
+}
+
+/* the accelerated resamplers give the same result as the C ones */
+static int test_zoom_accel(TCVHandle handle, int Bpp, TCVZoomFilter filter)
+{
+    int w = 704, h = 576, new_w = 1280, new_h = 720;
+    int ret = 0;
+
+    fill_random(src_buf, w * h * Bpp);
+    ac_init(AC_NONE);
+    ret |= !tcv_zoom(handle, src_buf, ref_buf, w, h, Bpp, new_w, new_h,
+                     filter);
+    ret |= !tcv_zoom(handle, src_buf, ref_buf + new_w * new_h * Bpp,
+                     new_w, new_h, Bpp, w, h, filter);
+    ac_init(AC_ALL);
+    ret |= !tcv_zoom(handle, src_buf, dst_buf, w, h, Bpp, new_w, new_h,
+                     filter);
+    ret |= !tcv_zoom(handle, src_buf, dst_buf + new_w * new_h * Bpp,
+                     new_w, new_h, Bpp, w, h, filter);
+    if (ret || memcmp(dst_buf, ref_buf, (new_w * new_h + w * h) * Bpp)) {
+        tc_log_warn(__FILE__, "FAILED: accel (Bpp %i, %s) differs from C",
+                    Bpp, tcv_zoom_filter_to_string(filter));
+        return 1;
+    }
+    return 0;
+}
+
+/* zooming with worker threads gives the same result as without them */
+static int test_zoom_threads(TCVHandle handle, int threads, int Bpp,
+                             int w, int h, int new_w, int new_h)
+{
+    TCVHandle threaded = tcv_init();
+    int ret = 0;
+
+    if (!threaded || !tcv_set_threads(threaded, threads)) {
+        tc_log_warn(__FILE__, "FAILED: setup (%i threads)", threads);
+        tcv_free(threaded);
+        return 1;
+    }
+    fill_random(src_buf, w * h * Bpp);
+    ret |= !tcv_zoom(handle, src_buf, ref_buf, w, h, Bpp, new_w, new_h,
+                     TCV_ZOOM_LANCZOS3);
+    ret |= !tcv_zoom(threaded, src_buf, dst_buf, w, h, Bpp, new_w, new_h,
+                     TCV_ZOOM_LANCZOS3);
+    ret |= !tcv_zoom(handle, src_buf, ref_buf + new_w * new_h * Bpp,
+                     w, h, Bpp, new_w, -new_h, TCV_ZOOM_LANCZOS3);
+    ret |= !tcv_zoom(threaded, src_buf, dst_buf + new_w * new_h * Bpp,
+                     w, h, Bpp, new_w, -new_h, TCV_ZOOM_LANCZOS3);
+    if (ret || memcmp(dst_buf, ref_buf, new_w * new_h * Bpp * 2)) {
+        tc_log_warn(__FILE__, "FAILED: %i threads (%ix%i -> %ix%i, Bpp %i)"
+                    " differ from one", threads, w, h, new_w, new_h, Bpp);
+        ret = 1;
+    }
+    tcv_free(threaded);
+    return ret;
+}
+
+static void time_zoom(TCVHandle handle, int w, int h, int new_w, int new_h)
+{
+    struct timeval start;
+    double secs = 0.0;
+    int i = 0, frames = 20;
+
+    fill_random(src_buf, w * h * 3 / 2);
+    gettimeofday(&start, NULL);
+    for (i = 0; i < frames; i++) {
+        tcv_zoom_yuv(handle, src_buf, dst_buf, w, h, IMG_YUV420P,
+                     new_w, new_h, TCV_ZOOM_LANCZOS3);
+    }
+    secs = elapsed(&start);
+    tc_log_info(__FILE__, "  %ix%i -> %ix%i (lanczos3, yuv420p): %.1f fps",
+                w, h, new_w, new_h, (secs > 0) ?frames / secs :0.0);
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    static const struct { int w, h, new_w, new_h; } sizes[] = {
+        { 720, 576, 352, 288 },
+        { 720, 576, 1280, 720 },
+        { 352, 288, 720, 576 },
+        { 640, 480, 640, 360 },
+        { 640, 480, 320, 480 },
+        { 17, 9, 3, 31 },
+        { 1, 1, 8, 8 },
+    };
+    static const TCVZoomFilter filters[] = {
+        TCV_ZOOM_BOX, TCV_ZOOM_TRIANGLE, TCV_ZOOM_HERMITE, TCV_ZOOM_BELL,
+        TCV_ZOOM_B_SPLINE, TCV_ZOOM_MITCHELL, TCV_ZOOM_LANCZOS3,
+        TCV_ZOOM_CUBIC_KEYS4, TCV_ZOOM_SINC8,
+    };
+    TCVHandle handle;
+    int errors = 0, i = 0;
+
+    libtc_init(&argc, &argv);
+    ac_init(AC_ALL);
+    srand(1);
+    handle = tcv_init();
+
+    tc_log_info(__FILE__, "running test: [reference]");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        errors += test_zoom_reference(handle, sizes[i].w, sizes[i].h, 1,
+                                      sizes[i].new_w, sizes[i].new_h);
+        errors += test_zoom_reference(handle, sizes[i].w, sizes[i].h, 3,
+                                      sizes[i].new_w, sizes[i].new_h);
+    }
+    tc_log_info(__FILE__, "running test: [flat]");
+    for (i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+        errors += test_zoom_flat(handle, filters[i]);
+    }
+    tc_log_info(__FILE__, "running test: [yuv]");
+    errors += test_zoom_yuv(handle, IMG_YUV420P, 2, 2, 0);
+    errors += test_zoom_yuv(handle, IMG_YUV420P, 2, 2, 1);
+    errors += test_zoom_yuv(handle, IMG_YUV411P, 4, 1, 0);
+    errors += test_zoom_yuv(handle, IMG_YUV422P, 2, 1, 0);
+    errors += test_zoom_yuv(handle, IMG_YUV444P, 1, 1, 0);
+    tc_log_info(__FILE__, "running test: [accel]");
+    errors += test_zoom_accel(handle, 1, TCV_ZOOM_LANCZOS3);
+    errors += test_zoom_accel(handle, 1, TCV_ZOOM_SINC8);
+    errors += test_zoom_accel(handle, 3, TCV_ZOOM_MITCHELL);
+    tc_log_info(__FILE__, "running test: [threads]");
+    errors += test_zoom_threads(handle, 2, 1, 720, 576, 1280, 720);
+    errors += test_zoom_threads(handle, 4, 1, 1280, 720, 720, 576);
+    errors += test_zoom_threads(handle, 3, 3, 352, 288, 720, 480);
+    errors += test_zoom_threads(handle, 8, 1, 64, 40, 100, 36);
+    tc_log_info(__FILE__, "running test: [speed]");
+    time_zoom(handle, 720, 576, 1280, 720);
+    time_zoom(handle, 1920, 1080, 720, 576);
+    if (tcv_set_threads(handle, 4)) {
+        tc_log_info(__FILE__, "  (4 threads)");
+        time_zoom(handle, 720, 576, 1280, 720);
+        time_zoom(handle, 1920, 1080, 720, 576);
+    }
+
+    tcv_free(handle);
+
+    putchar('\n');
+    tc_log_info(__FILE__, "test summary: %i error%s (%s)",
+                errors,
+                (errors > 1) ?"s" :"",
+                (errors > 0) ?"FAILED" :"PASSED");
+    return (errors > 0) ?1 :0;
+}
+
+/*************************************************************************/
+
+/*
+ * Local variables:
+ *   c-file-style: "stroustrup"
+ *   c-file-offsets: ((case-label . *) (statement-case-intro . *))
+ *   indent-tabs-mode: nil
+ * End:
+ *
+ * vim: expandtab shiftwidth=4:
+ */
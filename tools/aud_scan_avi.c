@@ -50,8 +50,6 @@ struct avidata_ {
     int     chan;
     long    rate;
     int     bits;
-
-    uint8_t data[48000 * 16 * 4];
 };
 
 static void init_avi_data(AVIData *data, avi_t *AVI)
@@ -89,17 +87,18 @@ static int AV_synch_avi2avi(AVIData *data,
                             double vid_ms, double *aud_ms,
                             avi_t *in, avi_t *out)
 {
+    const uint8_t *chunk = NULL;
     long bytes = 0;
 
     while (*aud_ms < vid_ms) {
-        bytes = AVI_read_audio_chunk(in, data->data);
+        bytes = AVI_read_audio_chunk_ref(in, &chunk);
         if (bytes < 0) {
             AVI_print_error("AVI audio read frame");
             return -2;
         }
 
         if (out) {
-            if (AVI_write_audio(out, data->data, bytes) < 0) {
+            if (AVI_write_audio(out, chunk, bytes) < 0) {
                 AVI_print_error("AVI write audio frame");
                 return -1;
             }
@@ -112,7 +111,7 @@ static int AV_synch_avi2avi(AVIData *data,
         }
 
         if (data->vbr
-         && tc_get_audio_header(data->data, bytes, data->format,
+         && tc_get_audio_header((uint8_t *)chunk, bytes, data->format,
                                 NULL, NULL, &(data->mp3rate)) < 0) {
             // if this is the last frame of the file, slurp in audio chunks
             //if (n == frames-1) continue;
@@ -130,17 +129,18 @@ static int AV_synch_avi2avi(AVIData *data,
 static int AV_synch_avi2avi_raw(AVIData *data,
                                 avi_t *in, avi_t *out)
 {
+    const uint8_t *chunk = NULL;
     long bytes = 0;
 
     do {
-        bytes = AVI_read_audio_chunk(in, data->data);
+        bytes = AVI_read_audio_chunk_ref(in, &chunk);
         if (bytes < 0) {
             AVI_print_error("AVI audio read frame");
             return -2;
         }
 
         if (out) {
-            if (AVI_write_audio(out, data->data, bytes) < 0) {
+            if (AVI_write_audio(out, chunk, bytes) < 0) {
                 AVI_print_error("AVI write audio frame");
                 return -1;
             }
@@ -58,7 +58,8 @@ static void usage(int status)
     exit(status);
 }
 
-static char data[SIZE_RGB_FRAME];
+/* one MP3 or AC3 frame of the track to merge: under 4k, see aud_scan.c */
+static char data[8192];
 static char *comfile = NULL;
 static char *indexfile = NULL;
 long sum_frames = 0;
@@ -79,6 +80,7 @@ static int merger(avi_t *out, char *file)
     static double aud_ms[AVI_MAX_TRACKS];
     int have_printed=0;
     int do_drop_video=0;
+    const uint8_t *frame = NULL;
 
     if (!init) {
 	for (j=0; j<AVI_MAX_TRACKS; j++)
@@ -143,14 +145,14 @@ static int merger(avi_t *out, char *file)
       }
 
       // video
-      bytes = AVI_read_frame(in, data, &key);
+      bytes = AVI_read_frame_ref(in, &frame, &key);
 
       if(bytes < 0) {
 	AVI_print_error("AVI read video frame");
 	return(-1);
       }
 
-      if(AVI_write_frame(out, data, bytes, key)<0) {
+      if(AVI_write_frame(out, frame, bytes, key)<0) {
 	AVI_print_error("AVI write video frame");
 	return(-1);
       }
@@ -187,6 +189,7 @@ int main(int argc, char *argv[])
   long offset, frames, n, bytes, aud_offset=0;
 
   int key;
+  const uint8_t *frame = NULL;
 
   int aud_tracks;
 
@@ -470,14 +473,14 @@ int main(int argc, char *argv[])
   for (n=0; n<frames; ++n) {
 
     // video
-    bytes = AVI_read_frame(avifile1, data, &key);
+    bytes = AVI_read_frame_ref(avifile1, &frame, &key);
 
     if(bytes < 0) {
       AVI_print_error("AVI read video frame");
       return(-1);
     }
 
-    if(AVI_write_frame(avifile, data, bytes, key)<0) {
+    if(AVI_write_frame(avifile, frame, bytes, key)<0) {
       AVI_print_error("AVI write video frame");
       return(-1);
     }
@@ -537,14 +540,14 @@ int main(int argc, char *argv[])
     for (n=0; n<frames; ++n) {
 
       // video
-      bytes = AVI_read_frame(avifile1, data, &key);
+      bytes = AVI_read_frame_ref(avifile1, &frame, &key);
 
       if(bytes < 0) {
 	AVI_print_error("AVI read video frame");
 	return(-1);
       }
 
-      if(AVI_write_frame(avifile, data, bytes, key)<0) {
+      if(AVI_write_frame(avifile, frame, bytes, key)<0) {
 	AVI_print_error("AVI write video frame");
 	return(-1);
       }
@@ -629,14 +632,14 @@ merge_mp3:
   for (n=0; n<frames; ++n) {
 
     // video
-    bytes = AVI_read_frame(avifile1, data, &key);
+    bytes = AVI_read_frame_ref(avifile1, &frame, &key);
 
     if(bytes < 0) {
       AVI_print_error("AVI read video frame");
       return(-1);
     }
 
-    if(AVI_write_frame(avifile, data, bytes, key)<0) {
+    if(AVI_write_frame(avifile, frame, bytes, key)<0) {
       AVI_print_error("AVI write video frame");
       return(-1);
     }
@@ -722,14 +725,14 @@ merge_mp3:
     for (n=0; n<frames; ++n) {
 
       // video
-      bytes = AVI_read_frame(avifile1, data, &key);
+      bytes = AVI_read_frame_ref(avifile1, &frame, &key);
 
       if(bytes < 0) {
 	AVI_print_error("AVI read video frame");
 	return(-1);
       }
 
-      if(AVI_write_frame(avifile, data, bytes, key)<0) {
+      if(AVI_write_frame(avifile, frame, bytes, key)<0) {
 	AVI_print_error("AVI write video frame");
 	return(-1);
       }
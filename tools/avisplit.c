@@ -61,8 +61,6 @@ static void usage(int status)
     exit(status);
 }
 
-// buffer
-static char data[SIZE_RGB_FRAME];
 static char out_file[1024];
 static char *comfile = NULL;
 int is_vbr = 1;
@@ -90,6 +88,7 @@ int main(int argc, char *argv[])
   char *codec;
 
   int j, n, key, k;
+  const uint8_t *frame = NULL;
 
   int key_boundary=1;
 
@@ -271,7 +270,7 @@ int main(int argc, char *argv[])
     for (n=0; n<frames; ++n) {
 
       // read video frame
-      bytes = AVI_read_frame(in, data, &key);
+      bytes = AVI_read_frame_ref(in, &frame, &key);
 
       if(bytes < 0) {
         fprintf(stderr, "%d (%ld)\n", n, bytes);
@@ -361,7 +360,7 @@ int main(int argc, char *argv[])
 
       //write frame
 
-      if(AVI_write_frame(out, data, bytes, key)<0) {
+      if(AVI_write_frame(out, frame, bytes, key)<0) {
         AVI_print_error("AVI write video frame");
         return(-1);
       }
@@ -528,7 +527,7 @@ int main(int argc, char *argv[])
         /*
          * read video frame
          */
-        bytes = AVI_read_frame( in, data, &key );
+        bytes = AVI_read_frame_ref( in, &frame, &key );
         if( bytes < 0 ) {
           fprintf( stderr, "%d (%ld)\n", n, bytes );
           AVI_print_error( "AVI read video frame" );
@@ -599,7 +598,7 @@ int main(int argc, char *argv[])
             /*
              * re-read video and audio from rewound position
              */
-            bytes = AVI_read_frame( in, data, &key );
+            bytes = AVI_read_frame_ref( in, &frame, &key );
 
 	    // count the frame which will be written also this, too
 	    vid_ms = vid_ms_w+1000.0/fps;
@@ -611,7 +610,7 @@ int main(int argc, char *argv[])
           /*
            * do the write
            */
-          if( AVI_write_frame( out, data, bytes, key ) < 0 ) {
+          if( AVI_write_frame( out, frame, bytes, key ) < 0 ) {
             AVI_print_error( "AVI write video frame" );
             return( -1 );
           }
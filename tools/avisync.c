@@ -62,13 +62,40 @@ static void usage(int status)
   exit(status);
 }
 
-// buffer
-static  char data[SIZE_RGB_FRAME];
-static  char ptrdata[SIZE_RGB_FRAME];
+// buffer: audio chunks are read in data, which grows as needed;
+// ptrdata holds the chunk repeated as padding, see buffer.c
+static  char *data = NULL;
+static  long data_size = 0;
+static  char *ptrdata = NULL;
 static int   ptrlen=0;
 static char *comfile = NULL;
 int is_vbr = 1;
 
+static int data_reserve(long bytes)
+{
+  char *buf = NULL;
+
+  if (bytes > data_size) {
+    buf = tc_realloc(data, bytes);
+    if (buf == NULL) {
+      fprintf(stderr, "out of memory\n");
+      return(-1);
+    }
+    data = buf;
+    data_size = bytes;
+  }
+  return(0);
+}
+
+// AVI_read_audio_chunk() into data
+static long read_audio_chunk(avi_t *avi)
+{
+  if (data_reserve(AVI_read_audio_chunk(avi, NULL)) < 0) {
+    return(-1);
+  }
+  return(AVI_read_audio_chunk(avi, data));
+}
+
 int main(int argc, char *argv[])
 {
 
@@ -79,6 +106,7 @@ int main(int argc, char *argv[])
   char *in_file=NULL, *out_file=NULL;
 
   long frames, bytes;
+  const uint8_t *frame = NULL;
 
   double fps;
 
@@ -112,6 +140,12 @@ int main(int argc, char *argv[])
 
   ac_init(AC_ALL);
 
+  ptrdata = tc_malloc(MAX_PCM_BUFFER);
+  if (ptrdata == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+
   if(argc==1) usage(EXIT_FAILURE);
 
   while ((ch = getopt(argc, argv, "a:b:vi:o:n:Nq?h")) != -1)
@@ -333,14 +367,14 @@ int main(int argc, char *argv[])
   for (n=0; n<frames; ++n) {
 
     // video unchanged
-    bytes = AVI_read_frame(avifile1, data, &key);
+    bytes = AVI_read_frame_ref(avifile1, &frame, &key);
 
     if(bytes < 0) {
       AVI_print_error("AVI read video frame");
       return(-1);
     }
 
-    if(AVI_write_frame(avifile2, data, bytes, key)<0) {
+    if(AVI_write_frame(avifile2, frame, bytes, key)<0) {
       AVI_print_error("AVI write video frame");
       return(-1);
     }
@@ -388,7 +422,7 @@ int main(int argc, char *argv[])
 
 		aud_bitrate = (format==0x1||format==0x2000)?1:0;
 		aud_chunks++;
-		if( (bytes = AVI_read_audio_chunk(avifile1, data)) <= 0) {
+		if( (bytes = read_audio_chunk(avifile1)) <= 0) {
 		    aud_ms[track_num] = vid_ms + one_vid_ms*i;
 		    if (bytes == 0) continue;
 		    AVI_print_error("AVI 2 audio read frame");
@@ -409,7 +443,7 @@ int main(int argc, char *argv[])
 	    bytes=0;
 	    for(i=0;i<shift;++i) {
 		do {
-		    if( (bytes = AVI_read_audio_chunk(avifile1, data)) < 0) {
+		    if( (bytes = read_audio_chunk(avifile1)) < 0) {
 			AVI_print_error("AVI audio read frame");
 			return(-1);
 		    }
@@ -429,7 +463,7 @@ int main(int argc, char *argv[])
 		aud_chunks++;
 		aud_bitrate = (format==0x1||format==0x2000)?1:0;
 
-		if( (bytes = AVI_read_audio_chunk(avifile1, data)) < 0) {
+		if( (bytes = read_audio_chunk(avifile1)) < 0) {
 		    aud_ms[track_num] = vid_ms + shift_ms;
 		    AVI_print_error("AVI 3 audio read frame");
 		    break;
@@ -475,7 +509,7 @@ int main(int argc, char *argv[])
 	bytes = AVI_audio_size(avifile1, n+shift-1);
 
 	do {
-	    if( (bytes = AVI_read_audio_chunk(avifile1, data)) < 0) {
+	    if( (bytes = read_audio_chunk(avifile1)) < 0) {
 		AVI_print_error("AVI audio read frame");
 		return(-1);
 	    }
@@ -601,7 +635,7 @@ int main(int argc, char *argv[])
 
 	  aud_bitrate = (format==0x1||format==0x2000)?1:0;
 
-	  if( (bytes = AVI_read_audio_chunk(avifile1, data)) < 0) {
+	  if( (bytes = read_audio_chunk(avifile1)) < 0) {
 	    AVI_print_error("AVI 2 audio read frame");
 	    aud_ms[track_num] = vid_ms;
 	    break;
@@ -684,7 +718,7 @@ int main(int argc, char *argv[])
       bytes = AVI_audio_size(avifile1, n);
 
 
-      if(bytes > SIZE_RGB_FRAME) {
+      if(bytes < 0 || data_reserve(bytes) < 0) {
 	fprintf(stderr, "invalid frame size\n");
 	return(-1);
       }
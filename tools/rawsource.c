@@ -57,6 +57,7 @@ struct tcrawsource_ {
     int             aframe_id;
 
     TCFrameVideo    *vframe;
+    int             vframe_size;    /* bytes allocated at vframe */
     TCFrameAudio    *aframe;
     int             acount;
     int             num_sources;
@@ -78,7 +79,7 @@ static TCFrameVideo *rawsource_read_video(TCFrameSource *FS)
 
     rawsource = FS->privdata;
 
-    if (FS->job->im_v_size > rawsource->vframe->video_size) {
+    if (FS->job->im_v_size > rawsource->vframe_size) {
         /* paranoia */
         tc_log_error(__FILE__, "video buffer too small"
                                " (this should'nt happen)");
@@ -91,6 +92,7 @@ static TCFrameVideo *rawsource_read_video(TCFrameSource *FS)
     im_para.buffer2    = NULL;
     im_para.size       = FS->job->im_v_size;
     im_para.flag       = TC_VIDEO;
+    im_para.buffer_size = rawsource->vframe_size;
 
     ret = tcv_import(TC_IMPORT_DECODE, &im_para, FS->job);
     if (ret != TC_IMPORT_OK) {
@@ -174,6 +176,7 @@ static TCRawSource rawsource = {
     .sources    = 0,
 
     .vframe     = NULL,
+    .vframe_size = 0,
     .aframe     = NULL,
     .acount     = 0,
 };
@@ -210,6 +213,8 @@ static int tc_rawsource_do_open(TCFrameSource *FS, TCJob *job)
         tc_log_error(__FILE__, "can't allocate video frame buffer");
         goto vframe_failed;
     }
+    /* video_size follows what was read in last, this doesn't */
+    rawsource->vframe_size = rawsource->vframe->video_size;
     samples = TC_AUDIO_SAMPLES_IN_FRAME(job->a_rate, job->ex_fps);
     rawsource->aframe = tc_new_audio_frame(samples, job->a_chan, job->a_bits);
     if (!rawsource->aframe) {
@@ -245,6 +250,7 @@ static int tc_rawsource_do_open(TCFrameSource *FS, TCJob *job)
 
 	memset(&im_para, 0, sizeof(transfer_t));
     im_para.flag = TC_VIDEO;
+    im_para.buffer_size = rawsource->vframe_size;
     ret = tcv_import(TC_IMPORT_OPEN, &im_para, job);
     if (TC_IMPORT_OK != ret) {
         tc_log_warn(__FILE__, "video open failed (ret=%i)", ret);
@@ -544,6 +544,7 @@ int main(int argc, char *argv[])
     const TCExportInfo *info = NULL;
     TCFrameSource *framesource = NULL;
     TCEncConf config;
+    TCFrameSpecs specs;
     TCVHandle tcv_handle = tcv_init();
     TCJob *job = tc_get_vob();
 
@@ -607,6 +608,16 @@ int main(int argc, char *argv[])
     ret = tc_rawsource_num_sources();
     EXIT_IF(ret != 2, "can't open both input sources", STATUS_IO_ERROR);
 
+    /* size the export buffers after the source, not the largest frame */
+    specs.frc      = job->ex_frc;
+    specs.width    = TC_MAX(job->im_v_width,  job->ex_v_width);
+    specs.height   = TC_MAX(job->im_v_height, job->ex_v_height);
+    specs.format   = job->im_v_codec;
+    specs.rate     = job->a_rate;
+    specs.channels = job->a_chan;
+    specs.bits     = job->a_bits;
+    tc_framebuffer_set_specs(&specs);
+
     ret = tc_export_new(job, factory,
                         tc_runcontrol_get_instance(),
                         tc_framebuffer_get_specs());
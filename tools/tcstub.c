@@ -261,6 +261,15 @@ void dummy_tcformat(void)
     str = tc_format_to_string(TC_FORMAT_UNKNOWN);
 }
 
+#include "libtcutil/tctaskpool.h"
+#include "libtcmodule/tcmodule-slice.h"
+void dummy_tcslice(void);
+void dummy_tcslice(void)
+{
+    tc_module_slice_run(NULL, NULL, 0, 1);
+    tc_task_pool_del(NULL);
+}
+
 
 #include "libtcutil/static_tcutil.h"
 